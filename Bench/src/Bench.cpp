@@ -0,0 +1,44 @@
+#include "Bench.h"
+
+#include "core/utils/Log.h"
+
+#include <numeric>
+
+namespace Rapture::Bench {
+
+void Context::fail(std::string message)
+{
+    RP_ERROR("[{}] {}", m_suite, message);
+    m_failures.push_back(m_suite + ": " + std::move(message));
+}
+
+bool Context::selected(std::string_view name) const
+{
+    if (m_filter.empty()) {
+        return true;
+    }
+    std::string qualified = m_suite + "/" + std::string(name);
+    return qualified.find(m_filter) != std::string::npos;
+}
+
+CaseResult &Context::record(std::string_view name, std::vector<double> &samples)
+{
+    std::sort(samples.begin(), samples.end());
+
+    CaseResult result;
+    result.suite = m_suite;
+    result.name = name;
+    result.iterations = static_cast<uint32_t>(samples.size());
+    result.minMs = samples.front();
+    result.maxMs = samples.back();
+    result.medianMs = samples[samples.size() / 2];
+    result.meanMs = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+
+    RP_INFO("{}/{}: median {:.3f} ms, min {:.3f} ms over {} runs", m_suite, name, result.medianMs, result.minMs,
+            result.iterations);
+
+    m_results.push_back(std::move(result));
+    return m_results.back();
+}
+
+} // namespace Rapture::Bench
@@ -0,0 +1,123 @@
+#ifndef RAPTURE__BENCH_H
+#define RAPTURE__BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Rapture::Bench {
+
+/**
+ * @brief The timings of one benchmark case, plus whatever it chose to count
+ */
+struct CaseResult {
+    std::string suite;
+    std::string name;
+    uint32_t iterations = 0;
+    double minMs = 0.0;
+    double medianMs = 0.0;
+    double meanMs = 0.0;
+    double maxMs = 0.0;
+    std::vector<std::pair<std::string, double>> counters;
+
+    /**
+     * @brief Records a named value next to the timings, e.g. a byte count or a throughput
+     */
+    CaseResult &counter(std::string_view key, double value)
+    {
+        counters.emplace_back(key, value);
+        return *this;
+    }
+};
+
+/**
+ * @brief What a suite is handed to time its cases, record counters and report failed checks
+ *
+ * Results outlive the suite so the runner can write them out together once every suite ran.
+ */
+class Context {
+  public:
+    Context(bool quick, std::string_view filter) : m_quick(quick), m_filter(filter) {}
+
+    /**
+     * @brief Times a case over several iterations after one untimed warm-up run
+     * @param name The case name, unique within the suite
+     * @param iterations How many timed runs to take, cut to a few in quick mode
+     * @param fn The work to time, called once per run
+     * @return The recorded result, to attach counters to; a dummy when the filter skips the case
+     */
+    template <typename Fn>
+    CaseResult &run(std::string_view name, uint32_t iterations, Fn &&fn)
+    {
+        if (!selected(name)) {
+            m_skipped = CaseResult{};
+            return m_skipped;
+        }
+
+        iterations = std::max(1u, m_quick ? std::min(iterations, 3u) : iterations);
+        fn();
+
+        std::vector<double> samples;
+        samples.reserve(iterations);
+        for (uint32_t i = 0; i < iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto end = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        return record(name, samples);
+    }
+
+    /**
+     * @brief Records a check that failed, which fails the whole run
+     */
+    void fail(std::string message);
+
+    /**
+     * @brief Whether a case of the current suite passes the command line filter
+     */
+    bool selected(std::string_view name) const;
+
+    /**
+     * @brief Whether to run with smaller inputs and fewer iterations, for a smoke test
+     */
+    bool quick() const { return m_quick; }
+
+    void beginSuite(std::string_view suite) { m_suite = suite; }
+
+    const std::vector<CaseResult> &results() const { return m_results; }
+    const std::vector<std::string> &failures() const { return m_failures; }
+
+  private:
+    CaseResult &record(std::string_view name, std::vector<double> &samples);
+
+    bool m_quick = false;
+    std::string m_filter;
+    std::string m_suite;
+    std::vector<CaseResult> m_results;
+    std::vector<std::string> m_failures;
+    CaseResult m_skipped;
+};
+
+/**
+ * @brief Keeps a value alive so the optimizer cannot drop the work that produced it
+ */
+template <typename T>
+inline void doNotOptimize(const T &value)
+{
+#if defined(_MSC_VER)
+    static volatile const void *s_sink;
+    s_sink = &value;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+} // namespace Rapture::Bench
+
+#endif // RAPTURE__BENCH_H
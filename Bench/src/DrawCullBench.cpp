@@ -0,0 +1,257 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "renderer/DrawCulling.h"
+#include "renderer/Frustum.h"
+#include "renderer/FrustumCulling.h"
+#include "scene/systems/WorldBounds.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cfloat>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+constexpr uint32_t DEPTH_WIDTH = 1920;
+constexpr uint32_t DEPTH_HEIGHT = 1080;
+constexpr float WALL_DISTANCE = 60.0f;
+
+/**
+ * @brief A batch of draws scattered around a camera, one mesh slot per draw, a tenth of them already hidden
+ */
+struct DrawField {
+    std::vector<VkDrawIndexedIndirectCommand> commands;
+    std::vector<uint32_t> meshIndices;
+    std::vector<DrawBounds> bounds;
+    std::vector<glm::mat4> models;
+    uint32_t count;
+
+    explicit DrawField(uint32_t drawCount) : count(drawCount)
+    {
+        uint32_t state = 0x9E3779B9u;
+        auto next = [&state]() {
+            state = state * 1664525u + 1013904223u;
+            return static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+        };
+
+        commands.resize(count);
+        meshIndices.resize(count);
+        bounds.resize(count);
+        models.resize(count);
+
+        for (uint32_t i = 0; i < count; ++i) {
+            const glm::vec3 position(next() * 2000.0f - 1000.0f, next() * 200.0f - 100.0f, next() * 2000.0f - 1000.0f);
+            const glm::vec3 scale(0.5f + next() * 3.0f, 0.5f + next() * 3.0f, 0.5f + next() * 3.0f);
+            const glm::mat4 placed = glm::translate(glm::mat4(1.0f), position);
+            models[i] = glm::scale(glm::rotate(placed, next() * 6.28f, glm::vec3(0.0f, 1.0f, 0.0f)), scale);
+
+            bounds[i].min = glm::vec4(-1.0f, -1.0f, -1.0f, 0.0f);
+            bounds[i].max = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+            meshIndices[i] = i;
+
+            // firstInstance is the draw's own index, so the compacted output shows its order
+            commands[i].indexCount = 36;
+            commands[i].instanceCount = next() < 0.1f ? 0u : 1u;
+            commands[i].firstIndex = 0;
+            commands[i].vertexOffset = 0;
+            commands[i].firstInstance = i;
+        }
+    }
+
+    DrawCullInput input() const { return {commands, meshIndices, bounds, models}; }
+};
+
+/**
+ * @brief A depth buffer cleared to the far plane with a wall across the middle third of the view
+ */
+std::vector<float> s_wallDepth(const glm::mat4 &projection)
+{
+    const glm::vec4 clip = projection * glm::vec4(0.0f, 0.0f, -WALL_DISTANCE, 1.0f);
+    const float wallDepth = clip.z / clip.w;
+
+    std::vector<float> depth(static_cast<size_t>(DEPTH_WIDTH) * DEPTH_HEIGHT, 1.0f);
+    for (uint32_t y = DEPTH_HEIGHT / 3; y < DEPTH_HEIGHT * 2 / 3; ++y) {
+        for (uint32_t x = DEPTH_WIDTH / 3; x < DEPTH_WIDTH * 2 / 3; ++x) {
+            depth[static_cast<size_t>(y) * DEPTH_WIDTH + x] = wallDepth;
+        }
+    }
+    return depth;
+}
+
+void s_throughput(CaseResult &result, uint32_t count)
+{
+    result.counter("draws", count);
+    if (result.medianMs > 0.0) {
+        result.counter("draws_per_ms", count / result.medianMs);
+    }
+}
+
+// the kept commands must be the source commands in their original order, which firstInstance records
+bool s_preservesOrder(const DrawField &field, const std::vector<VkDrawIndexedIndirectCommand> &out)
+{
+    for (size_t i = 0; i < out.size(); ++i) {
+        if (out[i].firstInstance >= field.count || (i > 0 && out[i].firstInstance <= out[i - 1].firstInstance)) {
+            return false;
+        }
+        const VkDrawIndexedIndirectCommand &source = field.commands[out[i].firstInstance];
+        if (out[i].indexCount != source.indexCount || out[i].instanceCount != source.instanceCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool s_sameCommands(const std::vector<VkDrawIndexedIndirectCommand> &a, const std::vector<VkDrawIndexedIndirectCommand> &b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].firstInstance != b[i].firstInstance || a[i].instanceCount != b[i].instanceCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+void runDrawCullSuite(Context &ctx)
+{
+    const uint32_t count = ctx.quick() ? 100000 : 1000000;
+    const std::string suffix = "/" + std::to_string(count);
+    const DrawField field(count);
+
+    const glm::mat4 projection =
+        glm::perspective(glm::radians(70.0f), static_cast<float>(DEPTH_WIDTH) / static_cast<float>(DEPTH_HEIGHT), 0.1f, 800.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(1.0f, 9.9f, 0.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    Frustum frustum;
+    frustum.update(projection, view);
+
+    DrawCullParams params;
+    params.planes = frustum.getPlanes();
+    params.occlusionViewProj = projection * view;
+
+    std::vector<VkDrawIndexedIndirectCommand> frustumOut;
+    DrawCullStats frustumStats;
+    CaseResult &frustumOnly = ctx.run("frustum" + suffix, 10, [&] {
+        frustumStats = {};
+        culling::cullDraws(field.input(), params, frustumOut, &frustumStats);
+        doNotOptimize(frustumOut.data());
+    });
+    s_throughput(frustumOnly, count);
+    frustumOnly.counter("visible", frustumStats.visible)
+        .counter("hidden", frustumStats.hidden)
+        .counter("frustum_culled", frustumStats.frustumCulled);
+
+    // the same world boxes through the scene's SoA cull, which tests corners where the draw cull
+    // tests a center and extent, so a box grazing a plane may round the other way
+    BoundsView padded{};
+    padded.count = count;
+    std::vector<float> minX(padded.getPaddedCount(), FLT_MAX), minY(minX), minZ(minX);
+    std::vector<float> maxX(padded.getPaddedCount(), -FLT_MAX), maxY(maxX), maxZ(maxX);
+    for (uint32_t i = 0; i < count; ++i) {
+        const glm::mat4 &model = field.models[i];
+        const glm::vec3 center(model[3]);
+        const glm::vec3 extent = glm::abs(glm::vec3(model[0])) + glm::abs(glm::vec3(model[1])) + glm::abs(glm::vec3(model[2]));
+        minX[i] = center.x - extent.x;
+        minY[i] = center.y - extent.y;
+        minZ[i] = center.z - extent.z;
+        maxX[i] = center.x + extent.x;
+        maxY[i] = center.y + extent.y;
+        maxZ[i] = center.z + extent.z;
+    }
+    const BoundsView worldBounds{minX.data(), minY.data(), minZ.data(), maxX.data(), maxY.data(), maxZ.data(), count};
+
+    VisibilityMask mask;
+    culling::cull(params.planes, worldBounds, mask, UINT32_MAX);
+
+    uint32_t frustumMismatches = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const DrawCullResult result = culling::testDraw(params, field.models[i], field.bounds[i], field.commands[i]);
+        if (result != DrawCullResult::HIDDEN) {
+            frustumMismatches += mask.test(i) != (result == DrawCullResult::VISIBLE);
+        }
+    }
+    frustumOnly.counter("mismatches_vs_soa", frustumMismatches);
+
+    if (frustumMismatches > count / 100000) {
+        ctx.fail("frustum: " + std::to_string(frustumMismatches) + " draws disagree with culling::cull");
+    }
+    if (!s_preservesOrder(field, frustumOut)) {
+        ctx.fail("frustum: the kept commands are not the source commands in order");
+    }
+
+    const std::vector<float> depth = s_wallDepth(projection);
+    DepthPyramid pyramid;
+    CaseResult &build = ctx.run("pyramid_build/" + std::to_string(DEPTH_WIDTH) + "x" + std::to_string(DEPTH_HEIGHT), 10, [&] {
+        pyramid.build(depth.data(), DEPTH_WIDTH, DEPTH_HEIGHT);
+        doNotOptimize(&pyramid);
+    });
+    build.counter("levels", pyramid.getLevelCount());
+
+    if (pyramid.getLevelCount() != DepthPyramid::levelCount(DEPTH_WIDTH, DEPTH_HEIGHT) ||
+        pyramid.getWidth(pyramid.getLevelCount() - 1) != 1 || pyramid.getHeight(pyramid.getLevelCount() - 1) != 1) {
+        ctx.fail("pyramid_build: the pyramid does not reduce to a single texel");
+    }
+
+    // the last level holds the farthest depth of the whole buffer, which is the cleared far plane
+    if (pyramid.fetch(pyramid.getLevelCount() - 1, 0, 0) != 1.0f) {
+        ctx.fail("pyramid_build: the last level lost the farthest depth");
+    }
+
+    params.pyramid = &pyramid;
+    std::vector<VkDrawIndexedIndirectCommand> occlusionOut;
+    DrawCullStats occlusionStats;
+    CaseResult &occlusion = ctx.run("frustum_hiz" + suffix, 10, [&] {
+        occlusionStats = {};
+        culling::cullDraws(field.input(), params, occlusionOut, &occlusionStats);
+        doNotOptimize(occlusionOut.data());
+    });
+    s_throughput(occlusion, count);
+    occlusion.counter("visible", occlusionStats.visible).counter("occluded", occlusionStats.occluded);
+
+    // the pyramid only ever removes draws the frustum kept, the wall must hide some of them
+    if (occlusionStats.frustumCulled != frustumStats.frustumCulled ||
+        occlusionStats.visible + occlusionStats.occluded != frustumStats.visible) {
+        ctx.fail("frustum_hiz: the occlusion test changed what the frustum test decides");
+    }
+    if (occlusionStats.occluded == 0) {
+        ctx.fail("frustum_hiz: nothing behind the wall was occluded");
+    }
+    if (!s_preservesOrder(field, occlusionOut)) {
+        ctx.fail("frustum_hiz: the kept commands are not the source commands in order");
+    }
+
+    // a draw in front of the wall must survive, whatever the pyramid's levels round to
+    uint32_t wrongOccluded = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (culling::testDraw(params, field.models[i], field.bounds[i], field.commands[i]) != DrawCullResult::OCCLUDED) {
+            continue;
+        }
+        const glm::vec4 viewCenter = view * field.models[i][3];
+        wrongOccluded += -viewCenter.z < WALL_DISTANCE - 6.0f;
+    }
+    occlusion.counter("occluded_in_front", wrongOccluded);
+    if (wrongOccluded != 0) {
+        ctx.fail("frustum_hiz: " + std::to_string(wrongOccluded) + " draws in front of the wall were occluded");
+    }
+
+    // the GPU output is compared word for word against this one, so it must not depend on the run
+    std::vector<VkDrawIndexedIndirectCommand> repeatOut;
+    for (uint32_t run = 0; run < 3; ++run) {
+        culling::cullDraws(field.input(), params, repeatOut);
+        if (!s_sameCommands(repeatOut, occlusionOut)) {
+            ctx.fail("frustum_hiz: run " + std::to_string(run) + " kept different commands");
+            break;
+        }
+    }
+}
+
+} // namespace Rapture::Bench
@@ -0,0 +1,198 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "renderer/Frustum.h"
+#include "renderer/FrustumCulling.h"
+#include "scene/systems/BoundingBox.h"
+#include "scene/systems/WorldBounds.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+/**
+ * @brief Boxes scattered through a volume around a camera, kept both as SoA arrays and as BoundingBoxes
+ */
+struct BoxField {
+    std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+    std::vector<BoundingBox> boxes;
+    uint32_t count;
+
+    explicit BoxField(uint32_t boxCount) : count(boxCount)
+    {
+        uint32_t state = 0x2545F491u;
+        auto next = [&state]() {
+            state = state * 1664525u + 1013904223u;
+            return static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+        };
+
+        BoundsView padded{};
+        padded.count = count;
+        const size_t size = padded.getPaddedCount();
+        minX.resize(size, FLT_MAX);
+        minY.resize(size, FLT_MAX);
+        minZ.resize(size, FLT_MAX);
+        maxX.resize(size, -FLT_MAX);
+        maxY.resize(size, -FLT_MAX);
+        maxZ.resize(size, -FLT_MAX);
+        boxes.reserve(count);
+
+        for (uint32_t i = 0; i < count; ++i) {
+            const glm::vec3 min(next() * 2000.0f - 1000.0f, next() * 200.0f - 100.0f, next() * 2000.0f - 1000.0f);
+            const glm::vec3 max = min + glm::vec3(0.5f + next() * 5.0f, 0.5f + next() * 5.0f, 0.5f + next() * 5.0f);
+            minX[i] = min.x;
+            minY[i] = min.y;
+            minZ[i] = min.z;
+            maxX[i] = max.x;
+            maxY[i] = max.y;
+            maxZ[i] = max.z;
+            boxes.emplace_back(min, max);
+        }
+    }
+
+    BoundsView view() const
+    {
+        return {minX.data(), minY.data(), minZ.data(), maxX.data(), maxY.data(), maxZ.data(), count};
+    }
+};
+
+void s_throughput(CaseResult &result, uint32_t count)
+{
+    result.counter("boxes", count);
+    if (result.medianMs > 0.0) {
+        result.counter("boxes_per_ms", count / result.medianMs);
+    }
+}
+
+/**
+ * @brief The views a frame with a camera, four cascades and eight spot lights culls for
+ */
+std::vector<std::array<glm::vec4, 6>> s_frameViews()
+{
+    std::vector<std::array<glm::vec4, 6>> views;
+    const glm::vec3 up(0.0f, 1.0f, 0.0f);
+
+    Frustum camera;
+    camera.update(glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 800.0f),
+                  glm::lookAt(glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(1.0f, 9.9f, 0.5f), up));
+    views.push_back(camera.getPlanes());
+
+    // cascades grow along the camera's view, lit from a sun high above it
+    float extent = 25.0f;
+    for (uint32_t cascade = 0; cascade < 4; ++cascade) {
+        const glm::vec3 center = glm::vec3(0.0f, 10.0f, 0.0f) + glm::vec3(0.89f, 0.0f, 0.45f) * extent;
+        Frustum ortho;
+        ortho.update(glm::ortho(-extent, extent, -extent, extent, 0.1f, 600.0f),
+                     glm::lookAt(center + glm::vec3(-100.0f, 300.0f, -50.0f), center, up));
+        views.push_back(ortho.getPlanes());
+        extent *= 3.0f;
+    }
+
+    for (uint32_t spot = 0; spot < 8; ++spot) {
+        const float angle = glm::radians(45.0f * static_cast<float>(spot));
+        const glm::vec3 position(std::cos(angle) * 150.0f, 40.0f, std::sin(angle) * 150.0f);
+        Frustum light;
+        light.update(glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 120.0f),
+                     glm::lookAt(position, position + glm::vec3(0.0f, -1.0f, 0.3f), up));
+        views.push_back(light.getPlanes());
+    }
+    return views;
+}
+
+} // namespace
+
+void runFrustumCullSuite(Context &ctx)
+{
+    const uint32_t count = ctx.quick() ? 100000 : 1000000;
+    const std::string suffix = "/" + std::to_string(count);
+    const BoxField field(count);
+
+    // a camera in the middle of the field, so roughly a quarter of the boxes survive
+    Frustum frustum;
+    frustum.update(glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 800.0f),
+                   glm::lookAt(glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(1.0f, 9.9f, 0.5f), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+    std::vector<uint8_t> reference(count);
+    CaseResult &perBox = ctx.run("per_box" + suffix, 10, [&] {
+        for (uint32_t i = 0; i < count; ++i) {
+            reference[i] = frustum.testBoundingBox(field.boxes[i]) != FrustumResult::Outside;
+        }
+        doNotOptimize(reference.data());
+    });
+    s_throughput(perBox, count);
+
+    VisibilityMask mask;
+    CaseResult &serial = ctx.run("soa_serial" + suffix, 20, [&] {
+        culling::cull(frustum.getPlanes(), field.view(), mask, UINT32_MAX);
+        doNotOptimize(mask.data());
+    });
+    s_throughput(serial, count);
+
+    // the corner test and the center and extent test round differently, a box grazing a plane may disagree
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        mismatches += mask.test(i) != (reference[i] != 0);
+    }
+    serial.counter("visible", mask.countVisible()).counter("mismatches_vs_per_box", mismatches);
+
+    VisibilityMask parallelMask;
+    CaseResult &parallel = ctx.run("soa_parallel" + suffix, 20, [&] {
+        culling::cull(frustum.getPlanes(), field.view(), parallelMask);
+        doNotOptimize(parallelMask.data());
+    });
+    s_throughput(parallel, count);
+
+    uint32_t parallelMismatches = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        parallelMismatches += parallelMask.test(i) != mask.test(i);
+    }
+
+    if (mismatches > count / 100000) {
+        ctx.fail("soa_serial: " + std::to_string(mismatches) + " boxes disagree with Frustum::testBoundingBox");
+    }
+    if (parallelMismatches != 0) {
+        ctx.fail("soa_parallel: " + std::to_string(parallelMismatches) + " boxes disagree with the serial cull");
+    }
+
+    // a frame's worth of views at 100k boxes, each culled on its own and then all of them in one pass
+    const uint32_t frameCount = 100000;
+    const BoxField frameField(frameCount);
+    const std::vector<std::array<glm::vec4, 6>> views = s_frameViews();
+    const std::string frameSuffix = "/" + std::to_string(views.size()) + "_views/" + std::to_string(frameCount);
+
+    std::vector<VisibilityMask> separateMasks(views.size());
+    // read straight away, the next run() may move the result
+    const double separateMs = ctx.run("per_view" + frameSuffix, 20, [&] {
+        for (size_t view = 0; view < views.size(); ++view) {
+            culling::cull(views[view], frameField.view(), separateMasks[view]);
+            doNotOptimize(separateMasks[view].data());
+        }
+    }).medianMs;
+
+    std::vector<VisibilityMask> sharedMasks(views.size());
+    CaseResult &shared = ctx.run("multi_view" + frameSuffix, 20, [&] {
+        culling::cullViews(views, frameField.view(), sharedMasks);
+        doNotOptimize(sharedMasks.data());
+    });
+    shared.counter("views", static_cast<double>(views.size())).counter("saved_ms", separateMs - shared.medianMs);
+
+    uint32_t viewMismatches = 0;
+    for (size_t view = 0; view < views.size(); ++view) {
+        for (uint32_t i = 0; i < frameCount; ++i) {
+            viewMismatches += sharedMasks[view].test(i) != separateMasks[view].test(i);
+        }
+    }
+    if (viewMismatches != 0) {
+        ctx.fail("multi_view: " + std::to_string(viewMismatches) + " boxes disagree with culling each view on its own");
+    }
+}
+
+} // namespace Rapture::Bench
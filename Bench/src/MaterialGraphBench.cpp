@@ -0,0 +1,497 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "assets/materials/graph/GraphDomain.h"
+#include "assets/materials/graph/MaterialGraph.h"
+#include "assets/materials/graph/MaterialGraphCompiler.h"
+#include "assets/materials/graph/NodeRegistry.h"
+#include "assets/materials/graph/SurfaceGraphManager.h"
+#include "gpu/shaders/ShaderCompilation.h"
+
+#include <array>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+constexpr uint32_t PROJECT_MATERIALS = 300;
+
+using GN = GraphNodeType;
+
+struct GraphBuilder {
+    MaterialGraph graph;
+    uint32_t nextId = 1;
+
+    uint32_t add(GraphNodeType type, std::vector<std::optional<PinValue>> values = {})
+    {
+        graph.nodes.push_back({.id = nextId, .type = type, .inputValues = std::move(values)});
+        return nextId++;
+    }
+
+    void connect(uint32_t src, uint32_t srcPin, uint32_t dst, uint32_t dstPin)
+    {
+        graph.connections.push_back({.srcNode = src, .srcPin = srcPin, .dstNode = dst, .dstPin = dstPin});
+    }
+};
+
+/**
+ * @brief One material of a synthetic project, built the way artists build them: a few base looks with optional layers
+ *
+ * Materials of one look differ only in their authored values, which live in the instance slice, so they compile to the
+ * same body. The layers add subtrees that recur across looks, like the facing term, which is what helpers can share.
+ */
+MaterialGraph s_projectMaterial(uint32_t index)
+{
+    GraphBuilder b;
+    b.graph.name = "material_" + std::to_string(index);
+    b.graph.domain = GD_SURFACE;
+
+    const float t = static_cast<float>(index % 17) / 17.0f;
+    const uint32_t look = index % 3;
+    const bool proceduralRoughness = (index / 3) % 2 == 1;
+    const bool pulsingEmission = (index / 6) % 2 == 1;
+    const bool facingOcclusion = (index / 12) % 2 == 1;
+
+    const uint32_t output = b.add(GN::SURFACE_OUTPUT);
+    b.graph.outputNodeId = output;
+
+    const uint32_t uv = b.add(GN::TEXCOORD);
+    const uint32_t uvSplit = b.add(GN::SPLIT_VEC2);
+    b.connect(uv, 0, uvSplit, 0);
+
+    // saturate(dot(N, normalize(P))), the rim term several layers reuse
+    auto facing = [&] {
+        const uint32_t normal = b.add(GN::NORMAL);
+        const uint32_t position = b.add(GN::POSITION);
+        const uint32_t direction = b.add(GN::NORMALIZE_VEC3);
+        const uint32_t dot = b.add(GN::DOT_VEC3);
+        const uint32_t saturate = b.add(GN::SATURATE_FLOAT);
+        b.connect(position, 0, direction, 0);
+        b.connect(normal, 0, dot, 0);
+        b.connect(direction, 0, dot, 1);
+        b.connect(dot, 0, saturate, 0);
+        return saturate;
+    };
+
+    const uint32_t colorA = b.add(GN::CONSTANT_VEC3, {PinValue(glm::vec3(t, 0.5f, 1.0f - t))});
+    const uint32_t colorB = b.add(GN::CONSTANT_VEC3, {PinValue(glm::vec3(1.0f - t, t, 0.25f))});
+    uint32_t albedo = 0;
+    if (look == 0) {
+        albedo = b.add(GN::MULTIPLY_VEC3);
+        b.connect(colorA, 0, albedo, 0);
+        b.connect(colorB, 0, albedo, 1);
+    } else {
+        albedo = b.add(GN::MIX_VEC3);
+        b.connect(colorA, 0, albedo, 0);
+        b.connect(colorB, 0, albedo, 1);
+        b.connect(look == 1 ? uvSplit : facing(), look == 1 ? 1 : 0, albedo, 2);
+    }
+    b.connect(albedo, 0, output, 0);
+
+    const uint32_t roughness = b.add(GN::CONSTANT_FLOAT, {PinValue(0.2f + 0.6f * t)});
+    if (proceduralRoughness) {
+        const uint32_t ramp = b.add(GN::SMOOTHSTEP_FLOAT, {PinValue(0.1f), PinValue(0.9f), std::nullopt});
+        const uint32_t scaled = b.add(GN::MULTIPLY_FLOAT);
+        b.connect(uvSplit, 0, ramp, 2);
+        b.connect(ramp, 0, scaled, 0);
+        b.connect(roughness, 0, scaled, 1);
+        b.connect(scaled, 0, output, 2);
+    } else {
+        b.connect(roughness, 0, output, 2);
+    }
+
+    const uint32_t metallic = b.add(GN::CONSTANT_FLOAT, {PinValue(look == 0 ? 1.0f : 0.0f)});
+    b.connect(metallic, 0, output, 3);
+
+    if (pulsingEmission) {
+        // the unauthored multiply by one is left in on purpose, as editors leave it, for the folding to remove
+        const uint32_t position = b.add(GN::POSITION);
+        const uint32_t positionSplit = b.add(GN::SPLIT_VEC3);
+        const uint32_t frequency = b.add(GN::MULTIPLY_FLOAT, {std::nullopt, PinValue(4.0f + t)});
+        const uint32_t wave = b.add(GN::SIN_FLOAT);
+        const uint32_t unit = b.add(GN::MULTIPLY_FLOAT);
+        const uint32_t strength = b.add(GN::SATURATE_FLOAT);
+        b.connect(position, 0, positionSplit, 0);
+        b.connect(positionSplit, 0, frequency, 0);
+        b.connect(frequency, 0, wave, 0);
+        b.connect(wave, 0, unit, 0);
+        b.connect(unit, 0, strength, 0);
+        b.connect(strength, 0, output, 6);
+    }
+
+    if (facingOcclusion) {
+        const uint32_t occlusion = b.add(GN::POWER_FLOAT, {std::nullopt, PinValue(2.0f)});
+        b.connect(facing(), 0, occlusion, 0);
+        b.connect(occlusion, 0, output, 4);
+    }
+
+    return std::move(b.graph);
+}
+
+// Pure nodes a random graph draws from, every pin a float or vector so any two can be wired by type
+constexpr std::array RANDOM_NODE_TYPES = {
+    GN::TEXCOORD,       GN::POSITION,      GN::NORMAL,        GN::CONSTANT_FLOAT,   GN::CONSTANT_VEC3,   GN::ADD_FLOAT,
+    GN::ADD_VEC3,       GN::SUBTRACT_FLOAT, GN::SUBTRACT_VEC3, GN::MULTIPLY_FLOAT,   GN::MULTIPLY_VEC3,   GN::DIVIDE_FLOAT,
+    GN::ABS_FLOAT,      GN::MIN_FLOAT,     GN::MAX_VEC3,      GN::CLAMP_FLOAT,      GN::SATURATE_FLOAT,  GN::SATURATE_VEC3,
+    GN::MIX_FLOAT,      GN::MIX_VEC3,      GN::STEP_FLOAT,    GN::SMOOTHSTEP_FLOAT, GN::FRACT_FLOAT,     GN::POWER_FLOAT,
+    GN::SQRT_FLOAT,     GN::SIN_FLOAT,     GN::COS_VEC3,      GN::DOT_VEC3,         GN::CROSS_VEC3,      GN::NORMALIZE_VEC3,
+    GN::LENGTH_VEC3,    GN::COMBINE_VEC3,  GN::SPLIT_VEC2,    GN::SPLIT_VEC3,       GN::LUMINANCE,       GN::REMAP_FLOAT,
+};
+
+struct PinRef {
+    uint32_t node = 0;
+    uint32_t pin = 0;
+};
+
+/**
+ * @brief A graph of random nodes wired to earlier outputs of the same type
+ *
+ * Sources are drawn from a window of recent nodes, which gives chains deep enough to be realistic, and only
+ * some outputs end up read by the sink, so a share of every graph is dead. Draws use the raw engine output
+ * rather than a distribution, whose results differ between standard libraries, so a seed means the same
+ * graph everywhere.
+ */
+MaterialGraph s_randomGraph(uint32_t nodeCount, uint32_t seed)
+{
+    constexpr uint32_t SOURCE_WINDOW = 32;
+
+    std::mt19937 rng(seed);
+    auto chance = [&](uint32_t percent) { return rng() % 100 < percent; };
+    auto unit = [&] { return static_cast<float>(rng() % 1000) / 1000.0f; };
+
+    GraphBuilder b;
+    b.graph.name = "random_" + std::to_string(nodeCount);
+    b.graph.domain = GD_SURFACE;
+    const uint32_t output = b.add(GN::SURFACE_OUTPUT);
+    b.graph.outputNodeId = output;
+
+    std::unordered_map<PinType, std::vector<PinRef>> outputs;
+    for (uint32_t i = 1; i < nodeCount; ++i) {
+        const GraphNodeType type = RANDOM_NODE_TYPES[rng() % RANDOM_NODE_TYPES.size()];
+        const NodeDefinition *def = NodeRegistry::get(type);
+
+        std::vector<std::optional<PinValue>> values(def->inputs.size());
+        std::vector<PinRef> sources(def->inputs.size(), PinRef{});
+        for (uint32_t pin = 0; pin < def->inputs.size(); ++pin) {
+            const std::vector<PinRef> &candidates = outputs[def->inputs[pin].type];
+            if (!candidates.empty() && chance(75)) {
+                size_t window = std::min<size_t>(candidates.size(), SOURCE_WINDOW);
+                sources[pin] = candidates[candidates.size() - 1 - rng() % window];
+            } else if (chance(50)) {
+                values[pin] = def->inputs[pin].type == PinType::FLOAT ? PinValue(unit()) : PinValue(glm::vec4(unit()));
+            }
+        }
+
+        const uint32_t node = b.add(type, std::move(values));
+        for (uint32_t pin = 0; pin < sources.size(); ++pin) {
+            if (sources[pin].node != 0) {
+                b.connect(sources[pin].node, sources[pin].pin, node, pin);
+            }
+        }
+        for (uint32_t pin = 0; pin < def->outputs.size(); ++pin) {
+            outputs[def->outputs[pin].type].push_back({node, pin});
+        }
+    }
+
+    const NodeDefinition *sinkDef = NodeRegistry::get(GN::SURFACE_OUTPUT);
+    for (uint32_t pin = 0; pin < sinkDef->inputs.size(); ++pin) {
+        const std::vector<PinRef> &candidates = outputs[sinkDef->inputs[pin].type];
+        if (!candidates.empty()) {
+            size_t window = std::min<size_t>(candidates.size(), SOURCE_WINDOW);
+            const PinRef &source = candidates[candidates.size() - 1 - rng() % window];
+            b.connect(source.node, source.pin, output, pin);
+        }
+    }
+    return std::move(b.graph);
+}
+
+/**
+ * @brief A graph stacked from blend layers the way large artist graphs are, each one masking a new color over the last
+ *
+ * Almost every node is live and most pins are authored, so this one leans on the slice layout and the emit where the
+ * random graphs lean on elimination.
+ */
+MaterialGraph s_layeredGraph(uint32_t nodeCount)
+{
+    GraphBuilder b;
+    b.graph.name = "layered_" + std::to_string(nodeCount);
+    b.graph.domain = GD_SURFACE;
+    const uint32_t output = b.add(GN::SURFACE_OUTPUT);
+    b.graph.outputNodeId = output;
+
+    const uint32_t uv = b.add(GN::TEXCOORD);
+    const uint32_t uvSplit = b.add(GN::SPLIT_VEC2);
+    b.connect(uv, 0, uvSplit, 0);
+
+    uint32_t albedo = b.add(GN::CONSTANT_VEC3, {PinValue(glm::vec3(0.5f))});
+    uint32_t roughness = b.add(GN::CONSTANT_FLOAT, {PinValue(0.5f)});
+
+    constexpr uint32_t LAYER_NODES = 7;
+    for (uint32_t layer = 0; b.graph.nodes.size() + LAYER_NODES <= nodeCount; ++layer) {
+        const float t = static_cast<float>(layer % 13) / 13.0f;
+        const uint32_t scaled = b.add(GN::MULTIPLY_FLOAT, {std::nullopt, PinValue(1.0f + layer)});
+        const uint32_t wave = b.add(GN::SIN_FLOAT);
+        const uint32_t mask = b.add(GN::SMOOTHSTEP_FLOAT, {PinValue(t * 0.5f), PinValue(0.5f + t * 0.5f), std::nullopt});
+        const uint32_t color = b.add(GN::CONSTANT_VEC3, {PinValue(glm::vec3(t, 1.0f - t, 0.5f))});
+        const uint32_t mixedAlbedo = b.add(GN::MIX_VEC3);
+        const uint32_t layerRoughness = b.add(GN::CONSTANT_FLOAT, {PinValue(t)});
+        const uint32_t mixedRoughness = b.add(GN::MIX_FLOAT);
+
+        b.connect(uvSplit, layer % 2, scaled, 0);
+        b.connect(scaled, 0, wave, 0);
+        b.connect(wave, 0, mask, 2);
+        b.connect(albedo, 0, mixedAlbedo, 0);
+        b.connect(color, 0, mixedAlbedo, 1);
+        b.connect(mask, 0, mixedAlbedo, 2);
+        b.connect(roughness, 0, mixedRoughness, 0);
+        b.connect(layerRoughness, 0, mixedRoughness, 1);
+        b.connect(mask, 0, mixedRoughness, 2);
+
+        albedo = mixedAlbedo;
+        roughness = mixedRoughness;
+    }
+
+    b.connect(albedo, 0, output, 0);
+    b.connect(roughness, 0, output, 2);
+    return std::move(b.graph);
+}
+
+/**
+ * @brief Whether two compiles of a graph produced the same code, slice layout and defaults
+ */
+bool s_sameOutput(const CompileResult &a, const CompileResult &b)
+{
+    if (a.success != b.success || a.defaults != b.defaults || a.functions.size() != b.functions.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.functions.size(); ++i) {
+        if (a.functions[i].functionName != b.functions[i].functionName || a.functions[i].body != b.functions[i].body) {
+            return false;
+        }
+    }
+    if (a.mapping.slots.size() != b.mapping.slots.size()) {
+        return false;
+    }
+    for (const auto &[key, slot] : a.mapping.slots) {
+        auto it = b.mapping.slots.find(key);
+        if (it == b.mapping.slots.end() || it->second.offset != slot.offset || it->second.type != slot.type) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Times cold compiles of one graph and reports its size and where the time went
+ *
+ * Each run compiles with a fresh compiler so the content-hash cache never answers. A second compile
+ * with another fresh compiler, and a cached one, must match the first byte for byte.
+ */
+void s_compileScaling(Context &ctx, const std::string &name, const MaterialGraph &graph, uint32_t iterations)
+{
+    CompileResult reference = MaterialGraphCompiler().compile(graph, 0);
+    if (!reference.success) {
+        ctx.fail(name + " did not compile");
+        return;
+    }
+
+    MaterialCompileStats total;
+    uint32_t runs = 0;
+    CaseResult &result = ctx.run(name, iterations, [&] {
+        CompileResult compiled = MaterialGraphCompiler().compile(graph, 0);
+        total.validateMs += compiled.stats.validateMs;
+        total.eliminateMs += compiled.stats.eliminateMs;
+        total.layoutMs += compiled.stats.layoutMs;
+        total.emitMs += compiled.stats.emitMs;
+        ++runs;
+        doNotOptimize(compiled);
+    });
+
+    size_t glslBytes = 0;
+    for (const auto &function : reference.functions) {
+        glslBytes += function.body.size();
+    }
+
+    runs = std::max(runs, 1u);
+    result.counter("nodes", static_cast<double>(graph.nodes.size()))
+        .counter("live_nodes", reference.stats.liveNodes)
+        .counter("dead_nodes", reference.stats.deadNodes)
+        .counter("slots", reference.stats.slotCount)
+        .counter("folded_values", reference.foldedValues)
+        .counter("glsl_bytes", static_cast<double>(glslBytes))
+        .counter("validate_ms", total.validateMs / runs)
+        .counter("eliminate_ms", total.eliminateMs / runs)
+        .counter("layout_ms", total.layoutMs / runs)
+        .counter("emit_ms", total.emitMs / runs);
+
+    MaterialGraphCompiler cached;
+    cached.compile(graph, 0);
+    if (!s_sameOutput(reference, MaterialGraphCompiler().compile(graph, 0)) || !s_sameOutput(reference, cached.compile(graph, 0))) {
+        ctx.fail(name + " compiled to different output on the same input");
+    }
+}
+
+/**
+ * @brief Copies the engine's GLSL tree aside so generated files can be written without touching the source tree
+ */
+std::filesystem::path s_scratchShaderTree(const std::filesystem::path &glslRoot)
+{
+    std::filesystem::path scratch = std::filesystem::temp_directory_path() / "rapture_bench_material_graph";
+    std::error_code ec;
+    std::filesystem::remove_all(scratch, ec);
+    std::filesystem::create_directories(scratch, ec);
+    std::filesystem::copy(glslRoot, scratch / "glsl", std::filesystem::copy_options::recursive, ec);
+    return ec ? std::filesystem::path() : scratch / "glsl";
+}
+
+size_t s_fileSize(const std::filesystem::path &path)
+{
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    return ec ? 0 : static_cast<size_t>(size);
+}
+
+} // namespace
+
+void runMaterialGraphSuite(Context &ctx)
+{
+    GraphDomainRegistry::registerBuiltins();
+    const GraphDomain *surface = GraphDomainRegistry::forId(GD_SURFACE);
+    if (surface == nullptr) {
+        ctx.fail("the surface domain is not registered");
+        return;
+    }
+
+    std::vector<MaterialGraph> project;
+    for (uint32_t i = 0; i < PROJECT_MATERIALS; ++i) {
+        project.push_back(s_projectMaterial(i));
+    }
+
+    MaterialGraphCompiler compiler;
+    std::vector<CompileResult> compiled(project.size());
+    uint32_t folded = 0;
+    for (uint32_t i = 0; i < project.size(); ++i) {
+        compiled[i] = compiler.compile(project[i], i);
+        if (!compiled[i].success) {
+            ctx.fail("project material " + std::to_string(i) + " did not compile");
+            return;
+        }
+        folded += compiled[i].foldedValues;
+    }
+
+    const uint32_t iterations = 10;
+
+    ctx.run("compile_project_cold", iterations, [&] {
+        MaterialGraphCompiler cold;
+        for (uint32_t i = 0; i < project.size(); ++i) {
+            doNotOptimize(cold.compile(project[i], i));
+        }
+    })
+        .counter("graphs", static_cast<double>(project.size()))
+        .counter("folded_values", static_cast<double>(folded));
+
+    ctx.run("compile_project_cached", iterations, [&] {
+        for (uint32_t i = 0; i < project.size(); ++i) {
+            doNotOptimize(compiler.compile(project[i], i));
+        }
+    });
+
+    // An editor tweak: one graph gets a value it never had, every other one has to come out of the cache
+    MaterialGraph edited = project[0];
+    float editValue = 0.0f;
+    ctx.run("recompile_after_one_edit", iterations, [&] {
+        edited.nodes.back().inputValues = {PinValue(editValue -= 1.0f)};
+        uint32_t missesBefore = compiler.getCacheMisses();
+        doNotOptimize(compiler.compile(edited, 0));
+        for (uint32_t i = 1; i < project.size(); ++i) {
+            doNotOptimize(compiler.compile(project[i], i));
+        }
+        if (compiler.getCacheMisses() - missesBefore != 1) {
+            ctx.fail("editing one graph recompiled more than that graph");
+        }
+    });
+
+    std::vector<const CompileResult *> linkable;
+    for (const auto &result : compiled) {
+        linkable.push_back(&result);
+    }
+
+    for (size_t passIndex = 0; passIndex < surface->passes.size(); ++passIndex) {
+        const std::string pass(surface->passes[passIndex].fileName);
+        LinkedPass standalone = MaterialGraphCompiler::link(linkable, *surface, passIndex, false);
+        LinkedPass shared = MaterialGraphCompiler::link(linkable, *surface, passIndex);
+
+        ctx.run("link_standalone/" + pass, iterations, [&] {
+            doNotOptimize(MaterialGraphCompiler::link(linkable, *surface, passIndex, false));
+        })
+            .counter("glsl_bytes", static_cast<double>(standalone.stats.linkedBytes))
+            .counter("functions", static_cast<double>(standalone.stats.functionCount));
+
+        ctx.run("link_shared/" + pass, iterations, [&] {
+            doNotOptimize(MaterialGraphCompiler::link(linkable, *surface, passIndex));
+        })
+            .counter("glsl_bytes", static_cast<double>(shared.stats.linkedBytes))
+            .counter("functions", static_cast<double>(shared.stats.functionCount))
+            .counter("shared_helpers", static_cast<double>(shared.stats.sharedHelperCount));
+
+        if (shared.stats.linkedBytes >= standalone.stats.linkedBytes) {
+            ctx.fail("linking " + pass + " did not shrink it");
+        }
+        if (shared.dispatch.size() != standalone.dispatch.size()) {
+            ctx.fail("linking " + pass + " lost dispatcher cases");
+        }
+    }
+
+    // Single graphs from tiny to far beyond what anyone authors by hand, to catch anything superlinear
+    const std::vector<uint32_t> sizes = ctx.quick() ? std::vector<uint32_t>{10, 100} : std::vector<uint32_t>{10, 100, 500, 2000};
+    for (uint32_t size : sizes) {
+        const uint32_t scaledIterations = size >= 500 ? 5 : 20;
+        s_compileScaling(ctx, "compile_random/" + std::to_string(size), s_randomGraph(size, 0x9E3779B9u ^ size), scaledIterations);
+        s_compileScaling(ctx, "compile_layered/" + std::to_string(size), s_layeredGraph(size), scaledIterations);
+    }
+
+    // What the driver-side cost looks like: GBuffer.fs.glsl through glslang against either generated file
+    const std::filesystem::path glslRoot = std::filesystem::path(RAPTURE_BENCH_ENGINE_ASSETS) / "shaders" / "glsl";
+    const std::filesystem::path scratch = s_scratchShaderTree(glslRoot);
+    if (scratch.empty()) {
+        ctx.fail("could not copy the shader tree from " + glslRoot.string());
+        return;
+    }
+
+    ShaderCompiler shaderCompiler;
+    ShaderCompileInfo compileInfo;
+    compileInfo.includePath = scratch;
+
+    for (bool shareCode : {false, true}) {
+        SurfaceGraphManager manager;
+        manager.setCodeSharing(shareCode);
+        for (const auto &graph : project) {
+            manager.registerGraph(graph);
+        }
+        if (!manager.writeGeneratedFiles(scratch / "generated")) {
+            ctx.fail("could not write the generated surface graph files");
+            return;
+        }
+
+        size_t spirvBytes = 0;
+        ctx.run(shareCode ? "glslang_gbuffer_shared" : "glslang_gbuffer_standalone", 5, [&] {
+            std::vector<char> spirv = shaderCompiler.Compile(scratch / "GBuffer.fs.glsl", compileInfo);
+            if (spirv.empty()) {
+                ctx.fail("GBuffer.fs.glsl did not compile against the generated surface graphs");
+            }
+            spirvBytes = spirv.size();
+        })
+            .counter("generated_bytes", static_cast<double>(s_fileSize(scratch / "generated" / "SurfaceGraphs.glsl")))
+            .counter("spirv_bytes", static_cast<double>(spirvBytes));
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(scratch.parent_path(), ec);
+}
+
+} // namespace Rapture::Bench
@@ -0,0 +1,178 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "physics/CharacterBody.h"
+#include "physics/PhysicsSystem.h"
+#include "physics/RigidBody.h"
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+constexpr uint32_t STEPS_PER_RUN = 30;
+constexpr float CHARACTER_SPACING = 1.0f;
+constexpr float WALK_SPEED = 1.5f;
+
+/**
+ * @brief A floor with a square crowd of capsules on it, all walking in towards the middle
+ *
+ * The capsules start close enough that the crowd bunches up within a run, so with
+ * characterVsCharacter they find one another and are joined into islands.
+ */
+struct CrowdScene {
+    std::unique_ptr<PhysicsSystem> system;
+    std::unique_ptr<physics::RigidBody> floor;
+    std::vector<std::unique_ptr<physics::CharacterBody>> characters;
+    uint32_t steps = 0;
+
+    CrowdScene(uint32_t count, uint32_t characterJobs, bool characterVsCharacter)
+    {
+        physics::SystemConfig config;
+        config.characterJobs = characterJobs;
+        config.characterVsCharacter = characterVsCharacter;
+        system = std::make_unique<PhysicsSystem>(config);
+
+        const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(count))));
+        const float extent = static_cast<float>(side) * CHARACTER_SPACING + 10.0f;
+
+        physics::RigidBodyConfig floorConfig;
+        floorConfig.shape = physics::BoxShape{glm::vec3(extent, 1.0f, extent)};
+        floorConfig.position = glm::vec3(0.0f, -1.0f, 0.0f);
+        floorConfig.motionType = physics::MOTION_STATIC;
+        floor = system->createRigidBody(floorConfig, nullptr);
+
+        characters.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            const float x = (static_cast<float>(i % side) - static_cast<float>(side) * 0.5f) * CHARACTER_SPACING;
+            const float z = (static_cast<float>(i / side) - static_cast<float>(side) * 0.5f) * CHARACTER_SPACING;
+
+            physics::CharacterBodyConfig characterConfig;
+            characterConfig.shape = physics::CapsuleShape{0.5f, 0.3f};
+            characterConfig.shapeOffset = glm::vec3(0.0f, 0.8f, 0.0f);
+            characterConfig.position = glm::vec3(x, 0.0f, z);
+            characters.push_back(system->createCharacterBody(characterConfig, nullptr));
+
+            const glm::vec3 inward(-x, 0.0f, -z);
+            physics::CharacterBodyMovement movement;
+            movement.velocity = glm::length(inward) > 0.0f ? glm::normalize(inward) * WALK_SPEED : glm::vec3(0.0f);
+            characters.back()->setMovement(movement);
+        }
+    }
+
+    void step(float fixedTimeStep)
+    {
+        for (uint32_t i = 0; i < STEPS_PER_RUN; ++i) {
+            system->onUpdate(fixedTimeStep);
+        }
+        steps += STEPS_PER_RUN;
+    }
+
+    std::vector<glm::vec3> positions() const
+    {
+        std::vector<glm::vec3> out;
+        out.reserve(characters.size());
+        for (const auto &character : characters) {
+            glm::vec3 position;
+            glm::quat rotation;
+            character->getTransform(position, rotation);
+            out.push_back(position);
+        }
+        return out;
+    }
+};
+
+bool s_samePositions(const CrowdScene &a, const CrowdScene &b)
+{
+    const std::vector<glm::vec3> left = a.positions();
+    const std::vector<glm::vec3> right = b.positions();
+    return std::memcmp(left.data(), right.data(), left.size() * sizeof(glm::vec3)) == 0;
+}
+
+bool s_sameContacts(const CrowdScene &a, const CrowdScene &b)
+{
+    const std::vector<physics::CharacterContact> &left = a.system->getCharacterContacts();
+    const std::vector<physics::CharacterContact> &right = b.system->getCharacterContacts();
+    if (left.size() != right.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < left.size(); ++i) {
+        if (left[i].a.value != right[i].a.value || left[i].b.value != right[i].b.value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void s_perStep(CaseResult &result, const CrowdScene &scene)
+{
+    const physics::CharacterStepStats &stats = scene.system->getLastCharacterStats();
+    result.counter("characters", stats.characters);
+    result.counter("ms_per_step", result.medianMs / STEPS_PER_RUN);
+    result.counter("batches", stats.batches);
+    result.counter("jobs", stats.jobs);
+}
+
+/**
+ * @brief The crowd stepped on one job and split over every job, with and without character vs character
+ *
+ * However the batches were scheduled, each pair of runs must end bit for bit in the same place, and
+ * with character vs character must report the same contacts.
+ */
+void s_benchCrowd(Context &ctx, uint32_t count)
+{
+    const std::string suffix = "/" + std::to_string(count);
+    const float fixedTimeStep = physics::SystemConfig{}.fixedTimeStep;
+
+    CrowdScene serial(count, 1, false);
+    const double serialMs = ctx.run("crowd/one_job" + suffix, 10, [&] { serial.step(fixedTimeStep); }).medianMs;
+
+    CrowdScene split(count, 0, false);
+    CaseResult &splitResult = ctx.run("crowd/jobs" + suffix, 10, [&] { split.step(fixedTimeStep); });
+    s_perStep(splitResult, split);
+    if (splitResult.medianMs > 0.0) {
+        splitResult.counter("speedup_vs_one_job", serialMs / splitResult.medianMs);
+    }
+
+    CrowdScene serialIslands(count, 1, true);
+    const double serialIslandsMs =
+        ctx.run("crowd/one_job_character_vs_character" + suffix, 10, [&] { serialIslands.step(fixedTimeStep); }).medianMs;
+
+    CrowdScene islands(count, 0, true);
+    CaseResult &islandsResult = ctx.run("crowd/jobs_character_vs_character" + suffix, 10, [&] { islands.step(fixedTimeStep); });
+    s_perStep(islandsResult, islands);
+    islandsResult.counter("islands", islands.system->getLastCharacterStats().islands);
+    islandsResult.counter("contacts", islands.system->getLastCharacterStats().contacts);
+    if (islandsResult.medianMs > 0.0) {
+        islandsResult.counter("speedup_vs_one_job", serialIslandsMs / islandsResult.medianMs);
+    }
+
+    // a case was filtered out, there is nothing to compare against
+    if (serial.steps != 0 && split.steps == serial.steps && !s_samePositions(serial, split)) {
+        ctx.fail("crowd" + suffix + ": characters split over jobs ended up elsewhere than on one job");
+    }
+    if (serialIslands.steps != 0 && islands.steps == serialIslands.steps) {
+        if (!s_samePositions(serialIslands, islands)) {
+            ctx.fail("crowd" + suffix + ": colliding characters split over jobs ended up elsewhere than on one job");
+        }
+        if (!s_sameContacts(serialIslands, islands)) {
+            ctx.fail("crowd" + suffix + ": colliding characters split over jobs reported other contacts than on one job");
+        }
+    }
+}
+
+} // namespace
+
+void runPhysicsCharactersSuite(Context &ctx)
+{
+    s_benchCrowd(ctx, 1);
+    s_benchCrowd(ctx, 100);
+    s_benchCrowd(ctx, ctx.quick() ? 500 : 2000);
+}
+
+} // namespace Rapture::Bench
@@ -0,0 +1,251 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "core/ecs/registry.h"
+#include "physics/PhysicsSystem.h"
+#include "physics/RigidBody.h"
+#include "scene/components/ChangeChannels.h"
+#include "scene/components/Components.h"
+#include "scene/systems/BodyInterpolation.h"
+#include "scene/systems/TransformHierarchy.h"
+#include "scene/systems/Transforms.h"
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+constexpr uint32_t REPLAY_SEED = 0x5eed;
+constexpr uint32_t REPLAY_FRAMES = 120;
+constexpr float FRAME_RATE = 144.0f;
+constexpr uint32_t JUDDER_FRAMES = 288;
+constexpr float MAX_INTERPOLATED_JUDDER = 0.05f;
+constexpr uint32_t GRID_SIDE = 32;
+
+/**
+ * @brief Frame times as a game sees them, mostly near 60Hz with the odd hitch, the same every run
+ */
+std::vector<float> s_jitteryFrames(uint32_t count)
+{
+    std::mt19937 random(REPLAY_SEED);
+    std::uniform_real_distribution<float> jitter(1.0f / 90.0f, 1.0f / 40.0f);
+    std::vector<float> frames(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        frames[i] = (i % 29 == 28) ? 0.1f : jitter(random);
+    }
+    return frames;
+}
+
+/**
+ * @brief A floor and boxes dropped onto it, with the SimulatedTarget each box hands its states to
+ *
+ * Bodies are owned by their targets here the way they are owned by a PhysicsBody3D in a scene, so
+ * BodyInterpolation resolves them through the same owner pointer.
+ */
+struct BodyScene {
+    ecs::Registry registry{CHANNEL_COUNT};
+    TransformHierarchy hierarchy{registry};
+    std::unique_ptr<PhysicsSystem> system;
+    std::unique_ptr<physics::RigidBody> floor;
+    std::vector<std::unique_ptr<physics::RigidBody>> bodies;
+    std::vector<SimulatedTarget> targets;
+    physics::StepCapture capture;
+    BodyInterpolation interpolation;
+
+    BodyScene(uint32_t count, const glm::vec3 &gravity, const glm::vec3 &velocity)
+    {
+        physics::SystemConfig config;
+        config.maxContactConstraints = 65536;
+        config.gravity = gravity;
+        system = std::make_unique<PhysicsSystem>(config);
+
+        const float extent = GRID_SIDE * 2.0f;
+        physics::RigidBodyConfig floorConfig;
+        floorConfig.shape = physics::BoxShape{glm::vec3(extent, 1.0f, extent)};
+        floorConfig.position = glm::vec3(0.0f, -1.0f, 0.0f);
+        floorConfig.motionType = physics::MOTION_STATIC;
+        floor = system->createRigidBody(floorConfig, nullptr);
+
+        // reserved up front, the bodies carry pointers into it
+        targets.resize(count);
+        bodies.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            const uint32_t cell = i % (GRID_SIDE * GRID_SIDE);
+            const float x = static_cast<float>(cell % GRID_SIDE) - GRID_SIDE * 0.5f;
+            const float z = static_cast<float>(cell / GRID_SIDE) - GRID_SIDE * 0.5f;
+
+            targets[i].entity = registry.create();
+            registry.add<TransformComponent>(targets[i].entity);
+
+            physics::RigidBodyConfig bodyConfig;
+            bodyConfig.shape = physics::BoxShape{glm::vec3(0.4f)};
+            bodyConfig.position = glm::vec3(x * 2.0f, 4.0f + static_cast<float>(i / (GRID_SIDE * GRID_SIDE)) * 1.5f, z * 2.0f);
+            bodies.push_back(system->createRigidBody(bodyConfig, &targets[i]));
+            bodies.back()->setLinearVelocity(velocity);
+        }
+    }
+
+    void take()
+    {
+        interpolation.capture(capture, [](void *owner) { return static_cast<const SimulatedTarget *>(owner); });
+    }
+
+    std::vector<glm::vec3> positions() const
+    {
+        std::vector<glm::vec3> out;
+        out.reserve(bodies.size());
+        for (const auto &body : bodies) {
+            glm::vec3 position;
+            glm::quat rotation;
+            body->getTransform(position, rotation);
+            out.push_back(position);
+        }
+        return out;
+    }
+};
+
+/**
+ * @brief The same frames fed to a scene stepping on the calling thread and to one stepping on a worker
+ *
+ * Both clocks see the same frame times and so run the same steps, and the simulation does not care
+ * which thread steps it, so both must end bit for bit in the same place.
+ */
+void s_benchReplay(Context &ctx, uint32_t count)
+{
+    const std::vector<float> frames = s_jitteryFrames(REPLAY_FRAMES);
+    const std::string suffix = "/" + std::to_string(count);
+    const glm::vec3 gravity = physics::SystemConfig{}.gravity;
+
+    BodyScene sync(count, gravity, glm::vec3(0.0f));
+    uint32_t syncRuns = 0;
+    const double syncMs = ctx.run("replay/calling_thread" + suffix, 5, [&] {
+        for (float dt : frames) {
+            const uint32_t steps = sync.system->advance(dt);
+            if (steps > 0) {
+                sync.system->runSteps(steps, sync.capture);
+                sync.take();
+            }
+        }
+        syncRuns++;
+    }).medianMs;
+
+    BodyScene worker(count, gravity, glm::vec3(0.0f));
+    uint32_t workerRuns = 0;
+    CaseResult &workerResult = ctx.run("replay/worker" + suffix, 5, [&] {
+        for (float dt : frames) {
+            const uint32_t steps = worker.system->advance(dt);
+            if (steps > 0) {
+                worker.system->launchSteps(steps, worker.capture);
+                worker.system->waitForSteps();
+                worker.take();
+            }
+        }
+        workerRuns++;
+    });
+    workerResult.counter("bodies", count);
+    if (workerResult.medianMs > 0.0) {
+        workerResult.counter("ratio_vs_calling_thread", syncMs / workerResult.medianMs);
+    }
+
+    // one of the cases was filtered out, there is nothing to compare
+    if (syncRuns == 0 || workerRuns != syncRuns) {
+        return;
+    }
+
+    const std::vector<glm::vec3> syncOut = sync.positions();
+    const std::vector<glm::vec3> workerOut = worker.positions();
+    if (std::memcmp(syncOut.data(), workerOut.data(), syncOut.size() * sizeof(glm::vec3)) != 0) {
+        ctx.fail("replay: stepping on a worker did not end where stepping on the calling thread did");
+    }
+}
+
+/**
+ * @brief How unevenly a body moving at a constant speed is drawn, frames at 144Hz over 60Hz steps
+ *
+ * The spread of the distance drawn per frame over its mean, 0 for perfectly even motion. Drawn
+ * straight from the last step, frames alternate between standing still and jumping a whole step.
+ */
+float s_judder(BodyScene &scene, bool interpolate)
+{
+    const float frameTime = 1.0f / FRAME_RATE;
+    const ecs::Entity tracked = scene.targets[0].entity;
+
+    std::vector<float> distances;
+    distances.reserve(JUDDER_FRAMES);
+    glm::vec3 last = transform::translation(transform::toMat4(scene.hierarchy.world(tracked)));
+    for (uint32_t frame = 0; frame < JUDDER_FRAMES; ++frame) {
+        const uint32_t steps = scene.system->advance(frameTime);
+        if (steps > 0) {
+            scene.system->runSteps(steps, scene.capture);
+            scene.take();
+        }
+        scene.interpolation.place(interpolate ? scene.system->getInterpolationAlpha() : 1.0f, scene.registry,
+                                  scene.hierarchy);
+        scene.hierarchy.flush();
+
+        const glm::vec3 now = transform::translation(transform::toMat4(scene.hierarchy.world(tracked)));
+        // the first frames fill the capture, what they draw says nothing about evenness
+        if (frame >= 4) {
+            distances.push_back(glm::length(now - last));
+        }
+        last = now;
+    }
+
+    double mean = 0.0;
+    for (float distance : distances) {
+        mean += distance;
+    }
+    mean /= static_cast<double>(distances.size());
+
+    double variance = 0.0;
+    for (float distance : distances) {
+        variance += (distance - mean) * (distance - mean);
+    }
+    variance /= static_cast<double>(distances.size());
+
+    return mean > 0.0 ? static_cast<float>(std::sqrt(variance) / mean) : 0.0f;
+}
+
+void s_benchJudder(Context &ctx, uint32_t count)
+{
+    const std::string suffix = "/" + std::to_string(count);
+    const glm::vec3 velocity(3.0f, 0.0f, 0.0f);
+
+    float rawJudder = 0.0f;
+    float interpolatedJudder = 0.0f;
+    bool measured = false;
+
+    ctx.run("judder/last_step" + suffix, 3, [&] {
+        BodyScene scene(count, glm::vec3(0.0f), velocity);
+        rawJudder = s_judder(scene, false);
+    }).counter("relative_stddev", rawJudder);
+
+    CaseResult &interpolated = ctx.run("judder/interpolated" + suffix, 3, [&] {
+        BodyScene scene(count, glm::vec3(0.0f), velocity);
+        interpolatedJudder = s_judder(scene, true);
+        measured = true;
+    });
+    interpolated.counter("relative_stddev", interpolatedJudder);
+    interpolated.counter("relative_stddev_last_step", rawJudder);
+
+    if (measured && !(interpolatedJudder <= MAX_INTERPOLATED_JUDDER)) {
+        ctx.fail("judder: interpolated bodies move unevenly, relative stddev " + std::to_string(interpolatedJudder));
+    }
+}
+
+} // namespace
+
+void runPhysicsInterpolationSuite(Context &ctx)
+{
+    const uint32_t count = ctx.quick() ? 500 : 4000;
+    s_benchReplay(ctx, count);
+    s_benchJudder(ctx, count);
+}
+
+} // namespace Rapture::Bench
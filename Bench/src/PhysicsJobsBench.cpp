@@ -0,0 +1,133 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "physics/PhysicsSystem.h"
+#include "physics/RigidBody.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+constexpr uint32_t STEPS_PER_RUN = 30;
+constexpr float DROP_HEIGHT = 4.0f;
+constexpr float BODY_SPACING = 1.5f;
+constexpr uint32_t GRID_SIDE = 50;
+
+float s_startHeight(uint32_t body)
+{
+    return DROP_HEIGHT + static_cast<float>(body / (GRID_SIDE * GRID_SIDE)) * BODY_SPACING;
+}
+
+/**
+ * @brief A floor and a grid of boxes dropped onto it, stepped by one of the two job backends
+ *
+ * The boxes start a little apart and stacked a few high, so the first steps are free fall and
+ * the later ones resolve the contacts of everything landing at once.
+ */
+struct DropScene {
+    std::unique_ptr<PhysicsSystem> system;
+    std::unique_ptr<physics::RigidBody> floor;
+    std::vector<std::unique_ptr<physics::RigidBody>> bodies;
+    uint32_t steps = 0;
+
+    DropScene(uint32_t count, bool privateJobPool)
+    {
+        physics::SystemConfig config;
+        config.maxContactConstraints = 65536;
+        config.privateJobPool = privateJobPool;
+        system = std::make_unique<PhysicsSystem>(config);
+
+        const float extent = GRID_SIDE * BODY_SPACING;
+
+        physics::RigidBodyConfig floorConfig;
+        floorConfig.shape = physics::BoxShape{glm::vec3(extent, 1.0f, extent)};
+        floorConfig.position = glm::vec3(0.0f, -1.0f, 0.0f);
+        floorConfig.motionType = physics::MOTION_STATIC;
+        floor = system->createRigidBody(floorConfig, nullptr);
+
+        bodies.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            const uint32_t cell = i % (GRID_SIDE * GRID_SIDE);
+            const float x = static_cast<float>(cell % GRID_SIDE) - GRID_SIDE * 0.5f;
+            const float z = static_cast<float>(cell / GRID_SIDE) - GRID_SIDE * 0.5f;
+
+            physics::RigidBodyConfig bodyConfig;
+            bodyConfig.shape = physics::BoxShape{glm::vec3(0.4f)};
+            bodyConfig.position = glm::vec3(x * BODY_SPACING, s_startHeight(i), z * BODY_SPACING);
+            bodies.push_back(system->createRigidBody(bodyConfig, nullptr));
+        }
+    }
+
+    void step(float fixedTimeStep)
+    {
+        for (uint32_t i = 0; i < STEPS_PER_RUN; ++i) {
+            system->onUpdate(fixedTimeStep);
+        }
+        steps += STEPS_PER_RUN;
+    }
+
+    std::vector<glm::vec3> positions() const
+    {
+        std::vector<glm::vec3> out;
+        out.reserve(bodies.size());
+        for (const auto &body : bodies) {
+            glm::vec3 position;
+            glm::quat rotation;
+            body->getTransform(position, rotation);
+            out.push_back(position);
+        }
+        return out;
+    }
+};
+
+void s_perStep(CaseResult &result, uint32_t bodies)
+{
+    result.counter("bodies", bodies);
+    result.counter("ms_per_step", result.medianMs / STEPS_PER_RUN);
+}
+
+} // namespace
+
+void runPhysicsJobsSuite(Context &ctx)
+{
+    const uint32_t count = ctx.quick() ? 2000 : 10000;
+    const std::string suffix = "/" + std::to_string(count);
+    const float fixedTimeStep = physics::SystemConfig{}.fixedTimeStep;
+
+    DropScene pooled(count, true);
+    const double pooledMs = ctx.run("drop/private_pool" + suffix, 10, [&] { pooled.step(fixedTimeStep); }).medianMs;
+
+    DropScene engine(count, false);
+    CaseResult &engineResult = ctx.run("drop/engine_jobs" + suffix, 10, [&] { engine.step(fixedTimeStep); });
+    s_perStep(engineResult, count);
+    if (engineResult.medianMs > 0.0) {
+        engineResult.counter("speedup_vs_private_pool", pooledMs / engineResult.medianMs);
+    }
+
+    // one of the cases was filtered out, there is nothing to compare
+    if (pooled.steps == 0 || engine.steps != pooled.steps) {
+        return;
+    }
+
+    // Jolt steps the same way however its jobs are spread over threads, so the two worlds agree
+    const std::vector<glm::vec3> pooledOut = pooled.positions();
+    const std::vector<glm::vec3> engineOut = engine.positions();
+    uint32_t diverged = 0;
+    uint32_t stillAirborne = 0;
+    for (size_t i = 0; i < engineOut.size(); ++i) {
+        diverged += glm::length(engineOut[i] - pooledOut[i]) > 1e-3f;
+        stillAirborne += engineOut[i].y >= s_startHeight(static_cast<uint32_t>(i));
+    }
+    if (diverged != 0) {
+        ctx.fail("drop: " + std::to_string(diverged) + " bodies ended up elsewhere on the engine's jobs");
+    }
+    if (stillAirborne != 0) {
+        ctx.fail("drop: " + std::to_string(stillAirborne) + " bodies never fell");
+    }
+}
+
+} // namespace Rapture::Bench
@@ -0,0 +1,250 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "physics/PhysicsSystem.h"
+#include "physics/RigidBody.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+constexpr uint32_t QUERY_SEED = 0x9e11;
+constexpr uint32_t GRID_SIDE = 48;
+constexpr float GRID_SPACING = 3.0f;
+constexpr uint32_t OVERLAP_CAPACITY = 16;
+
+/**
+ * @brief A field of static pillars with boxes resting among them, each body owning a tag saying which it is
+ */
+struct QueryScene {
+    std::unique_ptr<PhysicsSystem> system;
+    std::vector<std::unique_ptr<physics::RigidBody>> bodies;
+    std::vector<physics::MotionType> owners; // a body's owner points at its entry
+
+    QueryScene()
+    {
+        physics::SystemConfig config;
+        config.maxContactConstraints = 65536;
+        system = std::make_unique<PhysicsSystem>(config);
+
+        // reserved up front, the bodies carry pointers into it
+        owners.reserve(GRID_SIDE * GRID_SIDE * 2 + 1);
+        const float half = static_cast<float>(GRID_SIDE) * GRID_SPACING * 0.5f;
+
+        owners.push_back(physics::MOTION_STATIC);
+        physics::RigidBodyConfig floorConfig;
+        floorConfig.shape = physics::BoxShape{glm::vec3(half + 10.0f, 1.0f, half + 10.0f)};
+        floorConfig.position = glm::vec3(0.0f, -1.0f, 0.0f);
+        floorConfig.motionType = physics::MOTION_STATIC;
+        bodies.push_back(system->createRigidBody(floorConfig, &owners.back()));
+
+        for (uint32_t i = 0; i < GRID_SIDE * GRID_SIDE; ++i) {
+            const float x = static_cast<float>(i % GRID_SIDE) * GRID_SPACING - half;
+            const float z = static_cast<float>(i / GRID_SIDE) * GRID_SPACING - half;
+
+            owners.push_back(physics::MOTION_STATIC);
+            physics::RigidBodyConfig pillar;
+            pillar.shape = physics::BoxShape{glm::vec3(0.5f, 2.0f, 0.5f)};
+            pillar.position = glm::vec3(x, 2.0f, z);
+            pillar.motionType = physics::MOTION_STATIC;
+            bodies.push_back(system->createRigidBody(pillar, &owners.back()));
+
+            owners.push_back(physics::MOTION_DYNAMIC);
+            physics::RigidBodyConfig box;
+            box.shape = physics::BoxShape{glm::vec3(0.4f)};
+            box.position = glm::vec3(x + GRID_SPACING * 0.5f, 0.4f, z + GRID_SPACING * 0.5f);
+            box.startActive = false;
+            bodies.push_back(system->createRigidBody(box, &owners.back()));
+        }
+    }
+};
+
+/**
+ * @brief Rays from head height in every direction, the kind line of sight and occlusion checks cast
+ */
+std::vector<physics::RayQuery> s_rays(uint32_t count, uint32_t layers)
+{
+    std::mt19937 random(QUERY_SEED);
+    const float half = static_cast<float>(GRID_SIDE) * GRID_SPACING * 0.5f;
+    std::uniform_real_distribution<float> position(-half, half);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> pitch(-0.4f, 0.1f);
+
+    std::vector<physics::RayQuery> rays(count);
+    for (physics::RayQuery &ray : rays) {
+        const float yaw = angle(random);
+        const float dip = pitch(random);
+        ray.origin = glm::vec3(position(random), 1.7f, position(random));
+        ray.direction = glm::normalize(glm::vec3(std::cos(yaw), dip, std::sin(yaw)));
+        ray.maxDistance = 30.0f;
+        ray.layers = layers;
+    }
+    return rays;
+}
+
+bool s_sameHit(const physics::RaycastResult &a, const physics::RaycastResult &b)
+{
+    return a.hit == b.hit && a.owner == b.owner && a.position == b.position && a.normal == b.normal;
+}
+
+/**
+ * @brief The same rays cast one call at a time, as one batch on the calling thread and as one batch over jobs
+ *
+ * Every way must find the same hits, and the one call at a time way is what the batches are checked
+ * against.
+ */
+void s_benchRays(Context &ctx, QueryScene &scene, uint32_t count)
+{
+    const std::string suffix = "/" + std::to_string(count);
+    const std::vector<physics::RayQuery> rays = s_rays(count, physics::QUERY_LAYER_ALL);
+
+    uint32_t runs[3] = {};
+
+    std::vector<physics::RaycastResult> single(count);
+    const double singleMs = ctx.run("rays/one_call_each" + suffix, 5, [&] {
+        for (uint32_t i = 0; i < count; ++i) {
+            single[i] = scene.system->raycast(rays[i].origin, rays[i].direction, rays[i].maxDistance);
+        }
+        runs[0]++;
+    }).medianMs;
+
+    std::vector<physics::RaycastResult> serialHits(count);
+    physics::SceneQueryBatch serialBatch;
+    serialBatch.rays = rays;
+    serialBatch.rayHits = serialHits;
+    CaseResult &serialResult =
+        ctx.run("rays/batch_calling_thread" + suffix, 5, [&] { runs[1] += scene.system->queryBatch(serialBatch, UINT32_MAX); });
+    if (serialResult.medianMs > 0.0) {
+        serialResult.counter("speedup_vs_one_call_each", singleMs / serialResult.medianMs);
+    }
+
+    std::vector<physics::RaycastResult> jobHits(count);
+    physics::SceneQueryBatch jobBatch;
+    jobBatch.rays = rays;
+    jobBatch.rayHits = jobHits;
+    CaseResult &jobResult = ctx.run("rays/batch_jobs" + suffix, 5, [&] { runs[2] += scene.system->queryBatch(jobBatch); });
+    jobResult.counter("rays", count);
+    jobResult.counter("jobs", scene.system->getLastQueryStats().jobs);
+    if (jobResult.medianMs > 0.0) {
+        jobResult.counter("speedup_vs_one_call_each", singleMs / jobResult.medianMs);
+        jobResult.counter("mrays_per_s", count / (jobResult.medianMs * 1000.0));
+    }
+
+    // a case was filtered out, there is nothing to compare against
+    if (runs[0] == 0 || runs[1] == 0 || runs[2] == 0) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!s_sameHit(single[i], serialHits[i]) || !s_sameHit(single[i], jobHits[i])) {
+            ctx.fail("rays" + suffix + ": ray " + std::to_string(i) + " found another hit in a batch than on its own");
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Rays that only see static bodies must never report a moving one, and still strike the pillars
+ */
+void s_checkLayers(Context &ctx, QueryScene &scene)
+{
+    const uint32_t count = 4096;
+    const std::vector<physics::RayQuery> rays = s_rays(count, physics::QUERY_LAYER_STATIC);
+    std::vector<physics::RaycastResult> hits(count);
+
+    physics::SceneQueryBatch batch;
+    batch.rays = rays;
+    batch.rayHits = hits;
+    if (!scene.system->queryBatch(batch)) {
+        ctx.fail("layers: the batch was refused");
+        return;
+    }
+
+    uint32_t struck = 0;
+    for (const physics::RaycastResult &hit : hits) {
+        if (!hit.hit) {
+            continue;
+        }
+        struck++;
+        if (hit.owner == nullptr || *static_cast<const physics::MotionType *>(hit.owner) != physics::MOTION_STATIC) {
+            ctx.fail("layers: a ray filtered to static bodies struck a moving one");
+            return;
+        }
+    }
+    if (struck == 0) {
+        ctx.fail("layers: no ray filtered to static bodies struck anything");
+    }
+}
+
+/**
+ * @brief Spheres swept and boxes placed among the pillars, built once for the whole batch
+ */
+void s_benchShapes(Context &ctx, QueryScene &scene, uint32_t count)
+{
+    const std::string suffix = "/" + std::to_string(count);
+    const std::vector<physics::RayQuery> rays = s_rays(count, physics::QUERY_LAYER_ALL);
+    const physics::CollisionShape shapes[] = {physics::SphereShape{0.3f}, physics::BoxShape{glm::vec3(1.5f)}};
+
+    std::vector<physics::ShapeCastQuery> casts(count);
+    std::vector<physics::OverlapQuery> overlaps(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        casts[i].shape = 0;
+        casts[i].origin = rays[i].origin;
+        casts[i].direction = rays[i].direction;
+        casts[i].maxDistance = rays[i].maxDistance;
+        overlaps[i].shape = 1;
+        overlaps[i].position = rays[i].origin;
+    }
+
+    std::vector<physics::RaycastResult> castHits(count);
+    std::vector<physics::OverlapResult> overlapResults(count);
+    std::vector<void *> overlapOwners(static_cast<size_t>(count) * OVERLAP_CAPACITY);
+
+    physics::SceneQueryBatch batch;
+    batch.shapes = shapes;
+    batch.shapeCasts = casts;
+    batch.shapeCastHits = castHits;
+    batch.overlaps = overlaps;
+    batch.overlapResults = overlapResults;
+    batch.overlapOwners = overlapOwners;
+
+    bool ran = false;
+    CaseResult &result = ctx.run("shapes/batch_jobs" + suffix, 5, [&] { ran = scene.system->queryBatch(batch); });
+    result.counter("shape_casts", count);
+    result.counter("overlaps", count);
+    result.counter("jobs", scene.system->getLastQueryStats().jobs);
+    if (!ran) {
+        return;
+    }
+
+    uint32_t castsHit = 0;
+    uint32_t overlapping = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        castsHit += castHits[i].hit ? 1 : 0;
+        overlapping += overlapResults[i].count;
+    }
+    result.counter("casts_hit", castsHit);
+    result.counter("bodies_overlapped", overlapping);
+    if (castsHit == 0 || overlapping == 0) {
+        ctx.fail("shapes" + suffix + ": no shape cast or overlap found a body among the pillars");
+    }
+}
+
+} // namespace
+
+void runPhysicsQueriesSuite(Context &ctx)
+{
+    QueryScene scene;
+    s_benchRays(ctx, scene, ctx.quick() ? 10000 : 100000);
+    s_checkLayers(ctx, scene);
+    s_benchShapes(ctx, scene, ctx.quick() ? 2000 : 10000);
+}
+
+} // namespace Rapture::Bench
@@ -0,0 +1,239 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "assets/meshes/StaticMesh.h"
+#include "physics/PhysicsSystem.h"
+#include "physics/RigidBody.h"
+#include "physics/ShapeCooking.h"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+constexpr float GRID_SPACING = 0.5f;
+constexpr float MAX_HEIGHT_ERROR = 1e-3f;
+
+/**
+ * @brief Rolling terrain as a mesh still in memory, one vertex per sample, the way an import hands it over
+ */
+struct GridMesh {
+    uint32_t side = 0;
+    std::vector<glm::vec3> positions;
+    std::vector<float> heights;
+    std::vector<uint32_t> indices;
+    MeshAllocatorParams params;
+
+    explicit GridMesh(uint32_t sampleSide) : side(sampleSide)
+    {
+        const float half = static_cast<float>(side - 1) * GRID_SPACING * 0.5f;
+        positions.reserve(side * side);
+        heights.reserve(side * side);
+        for (uint32_t z = 0; z < side; ++z) {
+            for (uint32_t x = 0; x < side; ++x) {
+                const float px = static_cast<float>(x) * GRID_SPACING - half;
+                const float pz = static_cast<float>(z) * GRID_SPACING - half;
+                const float height = 2.0f * std::sin(px * 0.3f) * std::cos(pz * 0.2f) + 3.0f;
+                positions.emplace_back(px, height, pz);
+                heights.push_back(height);
+            }
+        }
+
+        indices.reserve((side - 1) * (side - 1) * 6);
+        for (uint32_t z = 0; z + 1 < side; ++z) {
+            for (uint32_t x = 0; x + 1 < side; ++x) {
+                const uint32_t i = z * side + x;
+                indices.insert(indices.end(), {i, i + side, i + 1, i + 1, i + side, i + side + 1});
+            }
+        }
+
+        BufferAttribute position;
+        position.name = BufferAttributeID::POSITION;
+        position.componentType = FLOAT_TYPE;
+        position.type = "VEC3";
+        position.offset = 0;
+        params.bufferLayout.buffer_attribs.push_back(position);
+        params.bufferLayout.isInterleaved = true;
+        params.bufferLayout.calculateVertexSize();
+
+        params.vertexData = positions.data();
+        params.vertexDataSize = static_cast<uint32_t>(positions.size() * sizeof(glm::vec3));
+        params.indexData = indices.data();
+        params.indexDataSize = static_cast<uint32_t>(indices.size() * sizeof(uint32_t));
+        params.indexCount = static_cast<uint32_t>(indices.size());
+        params.indexType = VK_INDEX_TYPE_UINT32;
+        params.boundsMin = glm::vec3(-half, 1.0f, -half);
+        params.boundsMax = glm::vec3(half, 5.0f, half);
+    }
+
+    /**
+     * @brief Cooks one kind of shape straight from the geometry, the work a body built from raw data pays
+     */
+    std::shared_ptr<const physics::CookedShape> cook(physics::CollisionShapeType kind) const
+    {
+        switch (kind) {
+        case physics::COLLISION_SHAPE_MESH:
+            return physics::cookMeshShape(positions, indices);
+        case physics::COLLISION_SHAPE_CONVEX_HULL:
+            return physics::cookConvexHullShape(positions);
+        case physics::COLLISION_SHAPE_HEIGHT_FIELD: {
+            const float half = static_cast<float>(side - 1) * GRID_SPACING * 0.5f;
+            return physics::cookHeightFieldShape(heights, side, glm::vec3(-half, 0.0f, -half),
+                                                 glm::vec3(GRID_SPACING, 1.0f, GRID_SPACING));
+        }
+        default:
+            return nullptr;
+        }
+    }
+};
+
+std::unique_ptr<physics::RigidBody> s_createBody(PhysicsSystem &system, physics::CollisionShapeType kind,
+                                                 std::shared_ptr<const physics::CookedShape> cooked, uint32_t index)
+{
+    physics::CollisionShape shape = physics::CollisionShape_ofType(kind);
+    physics::CollisionShape_cookedSource(shape)->cooked = std::move(cooked);
+
+    physics::RigidBodyConfig config;
+    config.shape = shape;
+    config.position = glm::vec3(static_cast<float>(index % 16) * 40.0f, 0.0f, static_cast<float>(index / 16) * 40.0f);
+    config.motionType = physics::MOTION_STATIC;
+    return system.createRigidBody(config, nullptr);
+}
+
+/**
+ * @brief Bodies built by cooking at runtime, by reading cooked bytes back, and from bytes read back once
+ *
+ * A level streaming in pays the middle cost per mesh instance unless the instances share their
+ * mesh's cooked data, in which case only the first one reads it back.
+ */
+void s_benchCreate(Context &ctx, const GridMesh &grid, const physics::CookedCollision &collision, physics::CollisionShapeType kind,
+                   uint32_t bodyCount)
+{
+    const std::string suffix = "/" + std::string(physics::CollisionShape_toString(kind));
+    const std::shared_ptr<const physics::CookedShape> cooked =
+        physics::CollisionShape_pickCooked(physics::CollisionShape_ofType(kind), collision);
+    if (cooked == nullptr) {
+        return;
+    }
+
+    PhysicsSystem system;
+    std::vector<std::unique_ptr<physics::RigidBody>> bodies;
+    bodies.reserve(bodyCount);
+    uint32_t failed = 0;
+
+    const double rawMs = ctx.run("create/cook_at_runtime" + suffix, 5, [&] {
+        for (uint32_t i = 0; i < bodyCount; ++i) {
+            bodies.push_back(s_createBody(system, kind, grid.cook(kind), i));
+            failed += bodies.back() == nullptr ? 1 : 0;
+        }
+        bodies.clear();
+    }).medianMs;
+
+    CaseResult &cookedResult = ctx.run("create/from_cooked" + suffix, 5, [&] {
+        for (uint32_t i = 0; i < bodyCount; ++i) {
+            // a copy per body, so each one reads its bytes back rather than finding them already read
+            bodies.push_back(s_createBody(system, kind, std::make_shared<physics::CookedShape>(*cooked), i));
+            failed += bodies.back() == nullptr ? 1 : 0;
+        }
+        bodies.clear();
+    });
+    cookedResult.counter("bodies", bodyCount);
+    cookedResult.counter("cooked_bytes", static_cast<double>(cooked->bytes.size()));
+    if (cookedResult.medianMs > 0.0) {
+        cookedResult.counter("speedup_vs_cook_at_runtime", rawMs / cookedResult.medianMs);
+    }
+
+    CaseResult &sharedResult = ctx.run("create/shared_cooked" + suffix, 5, [&] {
+        for (uint32_t i = 0; i < bodyCount; ++i) {
+            bodies.push_back(s_createBody(system, kind, cooked, i));
+            failed += bodies.back() == nullptr ? 1 : 0;
+        }
+        bodies.clear();
+    });
+    if (sharedResult.medianMs > 0.0) {
+        sharedResult.counter("speedup_vs_cook_at_runtime", rawMs / sharedResult.medianMs);
+    }
+
+    if (failed != 0) {
+        ctx.fail("create" + suffix + ": " + std::to_string(failed) + " bodies could not be created");
+    }
+}
+
+/**
+ * @brief A body read back from cooked bytes must stand where one cooked on the spot does
+ *
+ * Rays straight down onto grid samples inside the border must land on the sample's height, for the
+ * triangle mesh and the height field alike, and the convex hull must be struck at or above the terrain.
+ */
+void s_checkCooked(Context &ctx, const GridMesh &grid, const physics::CookedCollision &collision)
+{
+    if (collision.mesh == nullptr || collision.convexHull == nullptr || collision.heightField == nullptr) {
+        ctx.fail("cook: a grid mesh was not cooked into a triangle mesh, a convex hull and a height field");
+        return;
+    }
+
+    const physics::CollisionShapeType kinds[] = {physics::COLLISION_SHAPE_MESH, physics::COLLISION_SHAPE_CONVEX_HULL,
+                                                 physics::COLLISION_SHAPE_HEIGHT_FIELD};
+    for (physics::CollisionShapeType kind : kinds) {
+        const std::string name(physics::CollisionShape_toString(kind));
+
+        PhysicsSystem fromCooked;
+        PhysicsSystem fromRaw;
+        const auto cooked = physics::CollisionShape_pickCooked(physics::CollisionShape_ofType(kind), collision);
+        auto cookedBody = s_createBody(fromCooked, kind, cooked, 0);
+        auto rawBody = s_createBody(fromRaw, kind, grid.cook(kind), 0);
+        if (cookedBody == nullptr || rawBody == nullptr) {
+            ctx.fail("cook/" + name + ": a body could not be created");
+            continue;
+        }
+
+        for (uint32_t z = 1; z + 1 < grid.side; z += 7) {
+            const uint32_t x = 1 + (z * 5) % (grid.side - 2);
+            const glm::vec3 &point = grid.positions[z * grid.side + x];
+            const glm::vec3 origin(point.x, 100.0f, point.z);
+            const physics::RaycastResult cookedHit = fromCooked.raycast(origin, glm::vec3(0.0f, -1.0f, 0.0f), 200.0f);
+            const physics::RaycastResult rawHit = fromRaw.raycast(origin, glm::vec3(0.0f, -1.0f, 0.0f), 200.0f);
+
+            if (!cookedHit.hit || !rawHit.hit || glm::length(cookedHit.position - rawHit.position) > MAX_HEIGHT_ERROR) {
+                ctx.fail("cook/" + name + ": a ray struck the cooked body elsewhere than one cooked on the spot");
+                break;
+            }
+            const bool onSurface = kind == physics::COLLISION_SHAPE_CONVEX_HULL
+                                       ? cookedHit.position.y >= point.y - MAX_HEIGHT_ERROR
+                                       : std::abs(cookedHit.position.y - point.y) <= MAX_HEIGHT_ERROR;
+            if (!onSurface) {
+                ctx.fail("cook/" + name + ": a ray struck at height " + std::to_string(cookedHit.position.y) +
+                         " over a sample at " + std::to_string(point.y));
+                break;
+            }
+        }
+    }
+}
+
+} // namespace
+
+void runPhysicsShapesSuite(Context &ctx)
+{
+    const GridMesh grid(ctx.quick() ? 33 : 129);
+    const uint32_t bodyCount = ctx.quick() ? 16 : 64;
+
+    physics::CookedCollision collision;
+    ctx.run("cook/import", 3, [&] { collision = StaticMesh::cookCollision(grid.params); })
+        .counter("vertices", static_cast<double>(grid.positions.size()));
+
+    // a filtered import leaves nothing to build from, cook once untimed instead
+    if (collision.mesh == nullptr) {
+        collision = StaticMesh::cookCollision(grid.params);
+    }
+
+    s_checkCooked(ctx, grid, collision);
+    s_benchCreate(ctx, grid, collision, physics::COLLISION_SHAPE_MESH, bodyCount);
+    s_benchCreate(ctx, grid, collision, physics::COLLISION_SHAPE_CONVEX_HULL, bodyCount);
+    s_benchCreate(ctx, grid, collision, physics::COLLISION_SHAPE_HEIGHT_FIELD, bodyCount);
+}
+
+} // namespace Rapture::Bench
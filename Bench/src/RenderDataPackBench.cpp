@@ -0,0 +1,232 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "core/ecs/registry.h"
+#include "renderer/GPUDataStructs.h"
+#include "renderer/RenderPartition.h"
+#include "scene/components/ChangeChannels.h"
+#include "scene/components/Components.h"
+#include "scene/render_data/RenderDataPacking.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+constexpr uint32_t FRAME_COUNT = 2;
+constexpr uint32_t CHANGED_PER_FRAME = 2048; // half the journal's ring, so a frame never has to rebuild
+
+/**
+ * @brief GPUDataStore's partitions and slot numbering without its SSBOs
+ *
+ * The static region has a fixed capacity where the real store grows it along with the partition,
+ * which only moves where the dynamic slots are numbered from.
+ */
+template <typename T>
+class HeadlessStore {
+  public:
+    explicit HeadlessStore(uint32_t staticCapacity) : m_staticCapacity(staticCapacity)
+    {
+        for (auto &partition : m_partitions) {
+            partition.init(FRAME_COUNT);
+        }
+    }
+
+    RenderPartition<T> &getPartition(Mobility mobility) { return m_partitions[mobility]; }
+
+    uint32_t getGlobalSlot(Mobility mobility, uint32_t localSlot) const
+    {
+        return mobility == MOBILITY_DYNAMIC ? m_staticCapacity + localSlot : localSlot;
+    }
+
+    uint32_t getLocalSlot(Mobility mobility, uint32_t globalSlot) const
+    {
+        return mobility == MOBILITY_DYNAMIC ? globalSlot - m_staticCapacity : globalSlot;
+    }
+
+    void clearDirty(uint32_t frameIndex)
+    {
+        for (auto &partition : m_partitions) {
+            partition.clearDirty(frameIndex);
+        }
+    }
+
+    // every slot's bytes, static partition first, to compare two packs of the same scene
+    std::vector<T> snapshot()
+    {
+        std::vector<T> out;
+        for (auto &partition : m_partitions) {
+            out.insert(out.end(), partition.getData(), partition.getData() + partition.getCount());
+        }
+        return out;
+    }
+
+    void wipe()
+    {
+        for (auto &partition : m_partitions) {
+            std::memset(static_cast<void *>(partition.getData()), 0, sizeof(T) * partition.getCount());
+        }
+    }
+
+  private:
+    std::array<RenderPartition<T>, MOBILITY_COUNT> m_partitions;
+    uint32_t m_staticCapacity;
+};
+
+/**
+ * @brief A scene of lights with their slots handed out the way SceneRenderData::onLightAdded does
+ *
+ * A third of the lights are spots and every other one is dynamic, so both partitions fill and the
+ * packer reads each concrete light type.
+ */
+struct LightScene {
+    ecs::Registry registry{CHANNEL_COUNT};
+    std::vector<ecs::Entity> lights;
+    HeadlessStore<LightGPUData> store;
+    RenderSlotMap slots;
+
+    explicit LightScene(uint32_t count) : store(count)
+    {
+        lights.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            ecs::Entity entity = registry.create();
+
+            TransformComponent &transform = registry.add<TransformComponent>(entity);
+            transform.world.rows[0].w = static_cast<float>(i % 1000);
+            transform.world.rows[2].w = static_cast<float>(i / 1000);
+
+            LightComponent *light = nullptr;
+            if (i % 3 == 0) {
+                SpotLightComponent &spot = registry.add<SpotLightComponent>(entity);
+                spot.innerConeAngle = 0.2f + static_cast<float>(i % 7) * 0.05f;
+                light = &spot;
+            } else {
+                PointLightComponent &point = registry.add<PointLightComponent>(entity);
+                point.range = 5.0f + static_cast<float>(i % 11);
+                light = &point;
+            }
+            light->mobility = (i % 2 == 0) ? MOBILITY_STATIC : MOBILITY_DYNAMIC;
+
+            uint32_t localSlot = store.getPartition(light->mobility).allocateSlot(entity);
+            slots.assign(entity, {store.getGlobalSlot(light->mobility, localSlot), light->mobility});
+            lights.push_back(entity);
+        }
+    }
+
+    /**
+     * @brief What SceneRenderData::onUpdate does for the light store, short of the upload
+     */
+    void pack(RenderDataPacker &packer, RenderStoreBookmarks &bookmarks, uint32_t frameIndex, uint32_t parallelThreshold)
+    {
+        markChangedSlots(registry.getJournal(), store, slots, bookmarks, CHANNEL_LIGHT_PARAMS, frameIndex);
+
+        const LightPacker lightPacker(registry);
+        for (uint32_t m = 0; m < MOBILITY_COUNT; m++) {
+            packer.add(store.getPartition(static_cast<Mobility>(m)), frameIndex, lightPacker);
+        }
+        packer.run(parallelThreshold);
+        store.clearDirty(frameIndex);
+    }
+};
+
+void s_throughput(CaseResult &result, uint32_t slots)
+{
+    result.counter("slots", slots);
+    if (result.medianMs > 0.0) {
+        result.counter("slots_per_ms", slots / result.medianMs);
+    }
+}
+
+uint32_t s_mismatches(const std::vector<LightGPUData> &a, const std::vector<LightGPUData> &b)
+{
+    if (a.size() != b.size()) {
+        return static_cast<uint32_t>(std::max(a.size(), b.size()));
+    }
+    uint32_t mismatches = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        mismatches += std::memcmp(&a[i], &b[i], sizeof(LightGPUData)) != 0;
+    }
+    return mismatches;
+}
+
+} // namespace
+
+void runRenderDataPackSuite(Context &ctx)
+{
+    const uint32_t count = ctx.quick() ? 100000 : 500000;
+    const std::string suffix = "/" + std::to_string(count);
+    LightScene scene(count);
+    RenderDataPacker packer;
+
+    // a bookmark that was never read rebuilds, which repacks every slot the way a new frame buffer does
+    RenderDataPacker::Stats serialStats;
+    const double serialMs = ctx.run("repack_all/serial" + suffix, 10, [&] {
+        RenderStoreBookmarks bookmarks;
+        scene.pack(packer, bookmarks, 0, UINT32_MAX);
+        serialStats = packer.getLastStats();
+    }).medianMs;
+    const std::vector<LightGPUData> serialOut = scene.store.snapshot();
+
+    scene.store.wipe();
+    RenderDataPacker::Stats parallelStats;
+    CaseResult &parallel = ctx.run("repack_all/parallel" + suffix, 10, [&] {
+        RenderStoreBookmarks bookmarks;
+        scene.pack(packer, bookmarks, 0, PACK_PARALLEL_THRESHOLD);
+        parallelStats = packer.getLastStats();
+    });
+    s_throughput(parallel, parallelStats.slots);
+    parallel.counter("jobs", parallelStats.jobs);
+    if (parallel.medianMs > 0.0) {
+        parallel.counter("speedup_vs_serial", serialMs / parallel.medianMs);
+    }
+
+    if (serialStats.slots != count || parallelStats.slots != count) {
+        ctx.fail("repack_all: " + std::to_string(parallelStats.slots) + " slots packed of " + std::to_string(count));
+    }
+    if (parallelStats.jobs == 0) {
+        ctx.fail("repack_all/parallel: the pack never left the calling thread");
+    }
+    const uint32_t mismatches = s_mismatches(serialOut, scene.store.snapshot());
+    if (mismatches != 0) {
+        ctx.fail("repack_all: " + std::to_string(mismatches) + " slots packed differently on jobs");
+    }
+
+    // the packed position is the light's world translation, so a slot packed for the wrong entity shows
+    uint32_t misplaced = 0;
+    for (ecs::Entity entity : scene.lights) {
+        const RenderSlot *slot = scene.slots.find(entity);
+        const uint32_t localSlot = scene.store.getLocalSlot(slot->mobility, slot->globalSlot);
+        const LightGPUData &data = scene.store.getPartition(slot->mobility).getSlotData(localSlot);
+        misplaced += data.positionAndType.x != scene.registry.tryRead<TransformComponent>(entity)->world.rows[0].w;
+    }
+    if (misplaced != 0) {
+        ctx.fail("repack_all: " + std::to_string(misplaced) + " slots hold another light's position");
+    }
+
+    // a frame of gameplay moving some lights, read back through the journal
+    RenderStoreBookmarks bookmarks;
+    scene.pack(packer, bookmarks, 1, PACK_PARALLEL_THRESHOLD);
+    uint32_t frame = 0;
+    RenderDataPacker::Stats changedStats;
+    CaseResult &changed = ctx.run("journal_changes/" + std::to_string(CHANGED_PER_FRAME) + suffix, 20, [&] {
+        const uint32_t first = (frame++ * CHANGED_PER_FRAME) % (count - CHANGED_PER_FRAME);
+        for (uint32_t i = first; i < first + CHANGED_PER_FRAME; ++i) {
+            scene.registry.write<TransformComponent>(scene.lights[i])->world.rows[1].w += 1.0f;
+        }
+        scene.pack(packer, bookmarks, 1, PACK_PARALLEL_THRESHOLD);
+        changedStats = packer.getLastStats();
+    });
+    s_throughput(changed, changedStats.slots);
+
+    if (changedStats.slots != CHANGED_PER_FRAME) {
+        ctx.fail("journal_changes: " + std::to_string(changedStats.slots) + " slots packed for " +
+                 std::to_string(CHANGED_PER_FRAME) + " moved lights");
+    }
+}
+
+} // namespace Rapture::Bench
@@ -0,0 +1,173 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "core/ecs/entity_map.h"
+#include "core/ecs/registry.h"
+#include "scene/components/ChangeChannels.h"
+#include "scene/components/Components.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+/**
+ * @brief A scene's meshes as SceneRenderData sees them, with some entity indices already reused
+ *
+ * Every fourth mesh is skeletal. The destroyed entities are kept to check that a stale handle finds
+ * nothing.
+ */
+struct MeshScene {
+    ecs::Registry registry{CHANNEL_COUNT};
+    std::vector<ecs::Entity> meshes;
+    std::vector<ecs::Entity> destroyed;
+
+    explicit MeshScene(uint32_t count)
+    {
+        meshes.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            ecs::Entity entity = registry.create();
+
+            // a seventh of the indices go round once more, so the live handles carry mixed generations
+            if (i % 7 == 0) {
+                registry.destroy(entity);
+                destroyed.push_back(entity);
+                entity = registry.create();
+            }
+
+            TransformComponent &transform = registry.add<TransformComponent>(entity);
+            transform.world.rows[0].w = static_cast<float>(i); // the world translation along x
+            if (i % 4 == 3) {
+                registry.add<SkeletalMeshComponent>(entity);
+            } else {
+                registry.add<StaticMeshComponent>(entity);
+            }
+            meshes.push_back(entity);
+        }
+    }
+};
+
+void s_lookups(CaseResult &result, uint32_t count)
+{
+    result.counter("lookups", count);
+    if (result.medianMs > 0.0) {
+        result.counter("lookups_per_ms", count / result.medianMs);
+    }
+}
+
+} // namespace
+
+void runRenderDataSlotsSuite(Context &ctx)
+{
+    const uint32_t count = ctx.quick() ? 100000 : 500000;
+    const std::string suffix = "/" + std::to_string(count);
+    MeshScene scene(count);
+
+    // slots handed out in creation order, the way onMeshAdded allocates them on load
+    std::unordered_map<ecs::Entity, uint32_t> hashedSlots;
+    ecs::EntityMap<uint32_t> pagedSlots;
+    for (uint32_t i = 0; i < count; ++i) {
+        hashedSlots[scene.meshes[i]] = i;
+        pagedSlots.assign(scene.meshes[i], i);
+    }
+
+    // SceneGeometryDraw::populate looks up the slot of every mesh it keeps, every frame
+    std::vector<uint32_t> hashedOut(count);
+    const double hashedMs = ctx.run("slot_lookup/unordered_map" + suffix, 20, [&] {
+        for (uint32_t i = 0; i < count; ++i) {
+            auto it = hashedSlots.find(scene.meshes[i]);
+            hashedOut[i] = it != hashedSlots.end() ? it->second : UINT32_MAX;
+        }
+        doNotOptimize(hashedOut.data());
+    }).medianMs;
+
+    std::vector<uint32_t> pagedOut(count);
+    CaseResult &paged = ctx.run("slot_lookup/entity_map" + suffix, 20, [&] {
+        for (uint32_t i = 0; i < count; ++i) {
+            const uint32_t *slot = pagedSlots.find(scene.meshes[i]);
+            pagedOut[i] = slot != nullptr ? *slot : UINT32_MAX;
+        }
+        doNotOptimize(pagedOut.data());
+    });
+    s_lookups(paged, count);
+    if (paged.medianMs > 0.0) {
+        paged.counter("speedup_vs_unordered_map", hashedMs / paged.medianMs);
+    }
+
+    uint32_t slotMismatches = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        slotMismatches += hashedOut[i] != pagedOut[i] || pagedOut[i] != i;
+    }
+    uint32_t staleFound = 0;
+    for (ecs::Entity entity : scene.destroyed) {
+        staleFound += pagedSlots.find(entity) != nullptr;
+    }
+    if (slotMismatches != 0) {
+        ctx.fail("slot_lookup: " + std::to_string(slotMismatches) + " slots disagree with the unordered_map");
+    }
+    if (staleFound != 0) {
+        ctx.fail("slot_lookup: " + std::to_string(staleFound) + " destroyed entities still found a slot");
+    }
+
+    // what packMesh reads per slot: the transform and whichever mesh component the entity holds
+    const ecs::Registry &registry = scene.registry;
+    double triedSum = 0.0;
+    const double triedMs = ctx.run("pack_lookups/try_read" + suffix, 20, [&] {
+        double sum = 0.0;
+        for (ecs::Entity entity : scene.meshes) {
+            const TransformComponent *transform = registry.tryRead<TransformComponent>(entity);
+            if (transform == nullptr) {
+                continue;
+            }
+            if (const StaticMeshComponent *mesh = registry.tryRead<StaticMeshComponent>(entity)) {
+                sum += transform->world.rows[0].w + static_cast<double>(mesh->mobility);
+            } else if (const SkeletalMeshComponent *skeletal = registry.tryRead<SkeletalMeshComponent>(entity)) {
+                sum += transform->world.rows[0].w + (skeletal->pose != nullptr ? 1.0 : 0.5);
+            }
+        }
+        triedSum = sum;
+        doNotOptimize(&triedSum);
+    }).medianMs;
+
+    double maskedSum = 0.0;
+    CaseResult &masked = ctx.run("pack_lookups/component_mask" + suffix, 20, [&] {
+        const ecs::ComponentPool<TransformComponent> *transforms = registry.getPool<TransformComponent>();
+        const ecs::ComponentPool<StaticMeshComponent> *staticMeshes = registry.getPool<StaticMeshComponent>();
+        const ecs::ComponentPool<SkeletalMeshComponent> *skeletalMeshes = registry.getPool<SkeletalMeshComponent>();
+        const ecs::ComponentMask transformBit = ecs::ComponentBit<TransformComponent>();
+        const ecs::ComponentMask staticMeshBit = ecs::ComponentBit<StaticMeshComponent>();
+        const ecs::ComponentMask skeletalMeshBit = ecs::ComponentBit<SkeletalMeshComponent>();
+
+        double sum = 0.0;
+        for (ecs::Entity entity : scene.meshes) {
+            if (!registry.isValid(entity)) {
+                continue;
+            }
+            const ecs::ComponentMask components = registry.getComponentMask(entity);
+            if ((components & transformBit) == 0) {
+                continue;
+            }
+            const TransformComponent &transform = transforms->get(entity);
+            if ((components & staticMeshBit) != 0) {
+                sum += transform.world.rows[0].w + static_cast<double>(staticMeshes->get(entity).mobility);
+            } else if ((components & skeletalMeshBit) != 0) {
+                sum += transform.world.rows[0].w + (skeletalMeshes->get(entity).pose != nullptr ? 1.0 : 0.5);
+            }
+        }
+        maskedSum = sum;
+        doNotOptimize(&maskedSum);
+    });
+    s_lookups(masked, count);
+    if (masked.medianMs > 0.0) {
+        masked.counter("speedup_vs_try_read", triedMs / masked.medianMs);
+    }
+
+    if (triedSum != maskedSum) {
+        ctx.fail("pack_lookups: the component mask path read different components than tryRead");
+    }
+}
+
+} // namespace Rapture::Bench
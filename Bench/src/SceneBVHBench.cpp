@@ -0,0 +1,294 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "renderer/Frustum.h"
+#include "renderer/FrustumCulling.h"
+#include "scene/systems/SceneBVH.h"
+#include "scene/systems/WorldBounds.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+constexpr uint32_t RAY_COUNT = 1000;
+constexpr uint32_t SPHERE_COUNT = 1000;
+
+/**
+ * @brief Boxes scattered over a level, the way a city or a forest spreads its meshes out
+ */
+struct Level {
+    std::vector<ecs::Entity> entities;
+    std::vector<glm::vec3> mins, maxs;
+    std::vector<float> minX, minY, minZ, maxX, maxY, maxZ; // padded for the scan
+    float extent;
+
+    explicit Level(uint32_t count) : extent(20.0f * std::sqrt(static_cast<float>(count)))
+    {
+        uint32_t state = 0x9E3779B9u;
+        auto next = [&state]() {
+            state = state * 1664525u + 1013904223u;
+            return static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+        };
+
+        BoundsView padded{};
+        padded.count = count;
+        const size_t size = padded.getPaddedCount();
+        minX.resize(size, FLT_MAX);
+        minY.resize(size, FLT_MAX);
+        minZ.resize(size, FLT_MAX);
+        maxX.resize(size, -FLT_MAX);
+        maxY.resize(size, -FLT_MAX);
+        maxZ.resize(size, -FLT_MAX);
+
+        for (uint32_t i = 0; i < count; ++i) {
+            const glm::vec3 min((next() - 0.5f) * extent, next() * 40.0f, (next() - 0.5f) * extent);
+            const glm::vec3 max = min + glm::vec3(0.5f + next() * 6.0f, 0.5f + next() * 12.0f, 0.5f + next() * 6.0f);
+            entities.push_back(ecs::MakeEntity(i, 0));
+            mins.push_back(min);
+            maxs.push_back(max);
+            minX[i] = min.x;
+            minY[i] = min.y;
+            minZ[i] = min.z;
+            maxX[i] = max.x;
+            maxY[i] = max.y;
+            maxZ[i] = max.z;
+        }
+    }
+
+    uint32_t count() const { return static_cast<uint32_t>(entities.size()); }
+
+    BoundsView view() const
+    {
+        return {minX.data(), minY.data(), minZ.data(), maxX.data(), maxY.data(), maxZ.data(), count()};
+    }
+
+    void fill(SceneBVH &bvh) const
+    {
+        bvh.clear();
+        for (uint32_t i = 0; i < count(); ++i) {
+            bvh.set(entities[i], mins[i], maxs[i]);
+        }
+    }
+};
+
+SceneBVH::Planes s_cameraPlanes(const glm::vec3 &eye, const glm::vec3 &target, float fovDegrees, float farPlane)
+{
+    Frustum frustum;
+    frustum.update(glm::perspective(glm::radians(fovDegrees), 16.0f / 9.0f, 0.1f, farPlane),
+                   glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)));
+    return frustum.getPlanes();
+}
+
+bool s_rayHits(const glm::vec3 &origin, const glm::vec3 &direction, const glm::vec3 &min, const glm::vec3 &max, float limit,
+               float &entry)
+{
+    const glm::vec3 inverse = 1.0f / direction;
+    const glm::vec3 t0 = (min - origin) * inverse;
+    const glm::vec3 t1 = (max - origin) * inverse;
+    const glm::vec3 near = glm::min(t0, t1);
+    const glm::vec3 far = glm::max(t0, t1);
+    entry = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+    const float exit = std::min(std::min(far.x, far.y), std::min(far.z, limit));
+    return entry <= exit;
+}
+
+void s_perSecond(CaseResult &result, const char *key, uint32_t count)
+{
+    if (result.medianMs > 0.0) {
+        result.counter(key, count / result.medianMs);
+    }
+}
+
+void s_runLevel(Context &ctx, uint32_t count)
+{
+    const std::string suffix = "/" + std::to_string(count);
+    const Level level(count);
+    const uint32_t heavyIterations = count >= 1000000 ? 3 : 10;
+
+    SceneBVH inserted;
+    CaseResult &insert = ctx.run("insert" + suffix, heavyIterations, [&] { level.fill(inserted); });
+    s_perSecond(insert, "leaves_per_ms", count);
+
+    // every later case works on one tree built the way update() builds it for a new scene
+    SceneBVH bvh;
+    level.fill(bvh);
+    CaseResult &rebuild = ctx.run("rebuild" + suffix, heavyIterations, [&] { bvh.rebuild(); });
+    s_perSecond(rebuild, "leaves_per_ms", count);
+    rebuild.counter("height", bvh.getHeight()).counter("area_ratio", bvh.getAreaRatio());
+
+    // every leaf nudged inside its enlarged box, as a slowly drifting scene does each frame
+    float drift = 0.0f;
+    CaseResult &jitter = ctx.run("jitter_all" + suffix, heavyIterations, [&] {
+        drift = drift > 0.0f ? -0.01f : 0.01f;
+        for (uint32_t i = 0; i < count; ++i) {
+            bvh.set(level.entities[i], level.mins[i] + drift, level.maxs[i] + drift);
+        }
+    });
+    s_perSecond(jitter, "leaves_per_ms", count);
+
+    CaseResult &refit = ctx.run("refit" + suffix, heavyIterations, [&] { bvh.refit(); });
+    s_perSecond(refit, "leaves_per_ms", count);
+
+    // one in a hundred leaves teleported across the level and back, each taken out and put in again
+    const uint32_t movers = std::max(1u, count / 100);
+    bool away = false;
+    CaseResult &moveSome = ctx.run("move_1pct" + suffix, 10, [&] {
+        away = !away;
+        const glm::vec3 offset = away ? glm::vec3(level.extent * 0.25f, 0.0f, 0.0f) : glm::vec3(0.0f);
+        for (uint32_t i = 0; i < movers; ++i) {
+            const uint32_t leaf = (i * 7919u) % count;
+            bvh.set(level.entities[leaf], level.mins[leaf] + offset, level.maxs[leaf] + offset);
+        }
+    });
+    s_perSecond(moveSome, "moves_per_ms", movers);
+
+    // back to where the scan's arrays say every box is
+    for (uint32_t i = 0; i < count; ++i) {
+        bvh.set(level.entities[i], level.mins[i], level.maxs[i]);
+    }
+    bvh.rebuild();
+
+    // a camera standing in the level and looking along it
+    const glm::vec3 eye(0.0f, 20.0f, 0.0f);
+    const glm::vec3 target = eye + glm::vec3(1.0f, -0.1f, 0.3f);
+    const SceneBVH::Planes camera = s_cameraPlanes(eye, target, 70.0f, level.extent * 0.25f);
+
+    std::vector<ecs::Entity> hits;
+    CaseResult &frustum = ctx.run("query_frustum" + suffix, 20, [&] {
+        hits.clear();
+        bvh.queryFrustum(camera, hits);
+        doNotOptimize(hits.data());
+    });
+    frustum.counter("visible", static_cast<double>(hits.size()));
+
+    VisibilityMask mask;
+    CaseResult &scan = ctx.run("scan_frustum" + suffix, 20, [&] {
+        culling::cull(camera, level.view(), mask, UINT32_MAX);
+        doNotOptimize(mask.data());
+    });
+    scan.counter("visible", mask.countVisible());
+
+    const uint32_t scanVisible = mask.countVisible();
+    const uint32_t difference = scanVisible > hits.size() ? scanVisible - static_cast<uint32_t>(hits.size())
+                                                          : static_cast<uint32_t>(hits.size()) - scanVisible;
+    if (difference > count / 100000) {
+        ctx.fail("query_frustum" + suffix + ": " + std::to_string(hits.size()) + " visible, the scan found " +
+                 std::to_string(scanVisible));
+    }
+
+    // a narrow frustum, as the picking region under the cursor is
+    const SceneBVH::Planes picking = s_cameraPlanes(eye, target, 3.0f, level.extent * 0.5f);
+    CaseResult &pick = ctx.run("query_picking" + suffix, 50, [&] {
+        hits.clear();
+        bvh.queryFrustum(picking, hits);
+        doNotOptimize(hits.data());
+    });
+    pick.counter("visible", static_cast<double>(hits.size()));
+
+    // a camera and four shadow cascades reaching further each time, all looking the same way
+    std::array<SceneBVH::Planes, 5> views;
+    views[0] = camera;
+    for (uint32_t cascade = 1; cascade < views.size(); ++cascade) {
+        views[cascade] = s_cameraPlanes(eye, target, 80.0f, level.extent * 0.06f * cascade);
+    }
+    std::array<std::vector<ecs::Entity>, 5> viewHits;
+    CaseResult &frusta = ctx.run("query_frusta_5" + suffix, 20, [&] {
+        for (auto &list : viewHits) {
+            list.clear();
+        }
+        bvh.queryFrusta(views, viewHits);
+        doNotOptimize(viewHits.data());
+    });
+    frusta.counter("visible_camera", static_cast<double>(viewHits[0].size()));
+
+    const uint32_t batchedCamera = static_cast<uint32_t>(viewHits[0].size());
+    hits.clear();
+    bvh.queryFrustum(camera, hits);
+    if (batchedCamera != hits.size()) {
+        ctx.fail("query_frusta_5" + suffix + ": the camera sees " + std::to_string(batchedCamera) +
+                 " batched and " + std::to_string(hits.size()) + " alone");
+    }
+
+    uint32_t state = 12345u;
+    auto next = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+    };
+
+    std::vector<glm::vec3> centers(SPHERE_COUNT);
+    for (glm::vec3 &center : centers) {
+        center = glm::vec3((next() - 0.5f) * level.extent, next() * 40.0f, (next() - 0.5f) * level.extent);
+    }
+    size_t sphereHits = 0;
+    CaseResult &spheres = ctx.run("query_sphere_x1000" + suffix, 10, [&] {
+        sphereHits = 0;
+        for (const glm::vec3 &center : centers) {
+            hits.clear();
+            bvh.querySphere(center, 25.0f, hits);
+            sphereHits += hits.size();
+        }
+        doNotOptimize(sphereHits);
+    });
+    s_perSecond(spheres, "queries_per_ms", SPHERE_COUNT);
+    spheres.counter("hits", static_cast<double>(sphereHits));
+
+    std::vector<glm::vec3> origins(RAY_COUNT);
+    std::vector<glm::vec3> directions(RAY_COUNT);
+    for (uint32_t i = 0; i < RAY_COUNT; ++i) {
+        origins[i] = glm::vec3((next() - 0.5f) * level.extent, 20.0f + next() * 20.0f, (next() - 0.5f) * level.extent);
+        directions[i] = glm::normalize(glm::vec3(next() - 0.5f, next() - 0.7f, next() - 0.5f));
+    }
+    const float rayLength = level.extent * 0.5f;
+
+    std::vector<float> closest(RAY_COUNT);
+    CaseResult &rays = ctx.run("raycast_closest_x1000" + suffix, 10, [&] {
+        for (uint32_t i = 0; i < RAY_COUNT; ++i) {
+            float best = FLT_MAX;
+            bvh.raycast(origins[i], directions[i], rayLength, [&best](ecs::Entity, float distance) {
+                best = std::min(best, distance);
+                return distance;
+            });
+            closest[i] = best;
+        }
+        doNotOptimize(closest.data());
+    });
+    s_perSecond(rays, "rays_per_ms", RAY_COUNT);
+
+    // the first few rays against every box
+    uint32_t rayMismatches = 0;
+    for (uint32_t i = 0; i < 16; ++i) {
+        float best = FLT_MAX;
+        for (uint32_t box = 0; box < count; ++box) {
+            float entry;
+            if (s_rayHits(origins[i], directions[i], level.mins[box], level.maxs[box], rayLength, entry)) {
+                best = std::min(best, entry);
+            }
+        }
+        rayMismatches += best != closest[i];
+    }
+    if (rayMismatches != 0) {
+        ctx.fail("raycast_closest" + suffix + ": " + std::to_string(rayMismatches) + " of 16 rays disagree with a scan");
+    }
+}
+
+} // namespace
+
+void runSceneBVHSuite(Context &ctx)
+{
+    const std::vector<uint32_t> counts =
+        ctx.quick() ? std::vector<uint32_t>{10000, 100000} : std::vector<uint32_t>{10000, 100000, 1000000};
+    for (uint32_t count : counts) {
+        s_runLevel(ctx, count);
+    }
+}
+
+} // namespace Rapture::Bench
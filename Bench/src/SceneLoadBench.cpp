@@ -0,0 +1,288 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "core/ecs/entity_map.h"
+#include "core/ecs/registry.h"
+#include "core/serialization/SerialDocument.h"
+#include "scene/SceneLoadPlan.h"
+#include "scene/components/ChangeChannels.h"
+#include "scene/components/Components.h"
+#include "scene/instances/InstanceRegistry.h"
+#include "scene/systems/TransformHierarchy.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+constexpr uint32_t CHILDREN_PER_GROUP = 64;
+
+// every this many objects carries a scene component, so preparing resolves those classes too
+constexpr uint32_t OBJECTS_PER_COMPONENT = 8;
+
+constexpr std::string_view KEY_INSTANCES = "instances";
+constexpr std::string_view KEY_CLASS = "class";
+constexpr std::string_view KEY_ID = "id";
+constexpr std::string_view KEY_NAME = "name";
+constexpr std::string_view KEY_COMPONENTS = "components";
+constexpr std::string_view KEY_CHILDREN = "children";
+constexpr std::string_view KEY_TRANSFORM = "transform";
+constexpr std::string_view KEY_TRANSLATION = "translation";
+constexpr std::string_view KEY_ROTATION = "rotation";
+constexpr std::string_view KEY_SCALE = "scale";
+
+constexpr std::string_view MESH_CLASS = "StaticMesh3D";
+
+/**
+ * @brief A world document the shape Scene::serialize gives one: groups of Node3Ds with StaticMesh3Ds under them
+ */
+void s_writeObject(WriteNode node, uint32_t index, std::string_view className)
+{
+    const float t = static_cast<float>(index % 977) * 0.37f;
+    node.set(KEY_CLASS, className);
+    node.set(KEY_ID, static_cast<uint64_t>(index + 1));
+    node.set(KEY_NAME, std::string_view("Node"));
+
+    WriteNode transform = node.addObject(KEY_TRANSFORM);
+    WriteNode translation = transform.addArray(KEY_TRANSLATION);
+    translation.append(t);
+    translation.append(static_cast<float>(index % 13) * 0.5f);
+    translation.append(-t * 0.25f);
+    WriteNode rotation = transform.addArray(KEY_ROTATION);
+    rotation.append(0.0f);
+    rotation.append(0.0f);
+    rotation.append(0.0f);
+    rotation.append(1.0f);
+    WriteNode scale = transform.addArray(KEY_SCALE);
+    scale.append(1.0f + static_cast<float>(index % 7) * 0.125f);
+    scale.append(1.0f);
+    scale.append(1.0f);
+
+    if (index % OBJECTS_PER_COMPONENT == 0) {
+        WriteNode component = node.addArray(KEY_COMPONENTS).appendObject();
+        component.set(KEY_CLASS, std::string_view("VisibilityComponent"));
+        component.set(KEY_ID, static_cast<uint64_t>(index + 1) << 32);
+    }
+}
+
+std::string s_writeWorld(uint32_t count)
+{
+    SerialDocument document;
+    WriteNode instances = document.root().addArray(KEY_INSTANCES);
+    for (uint32_t group = 0; group < count; group += CHILDREN_PER_GROUP) {
+        WriteNode groupNode = instances.appendObject();
+        s_writeObject(groupNode, group, "Node3D");
+
+        const uint32_t end = std::min(group + CHILDREN_PER_GROUP, count);
+        if (group + 1 < end) {
+            WriteNode children = groupNode.addArray(KEY_CHILDREN);
+            for (uint32_t i = group + 1; i < end; ++i) {
+                s_writeObject(children.appendObject(), i, MESH_CLASS);
+            }
+        }
+    }
+    return document.toText();
+}
+
+glm::vec3 s_readVec3(ReadNode array)
+{
+    return glm::vec3(static_cast<float>(array.at(0).asF64()), static_cast<float>(array.at(1).asF64()),
+                     static_cast<float>(array.at(2).asF64()));
+}
+
+/**
+ * @brief What a scene keeps of loaded objects without a GPU: a registry, its transform hierarchy and mesh slots
+ *
+ * The hierarchy gains its rows as each transform is attached, as it does in a scene. The mesh slots are handed
+ * out the way SceneRenderData::onMeshAdded hands them out, from the construct signal, and are connected as
+ * immediate or as deferrable depending on the load being measured.
+ */
+struct LoadWorld {
+    ecs::Registry registry{CHANNEL_COUNT};
+    TransformHierarchy hierarchy{registry};
+    ecs::EntityMap<uint32_t> meshSlots;
+    std::vector<ecs::Entity> partitions[MOBILITY_COUNT];
+    ecs::SignalConnection meshConnection;
+
+    explicit LoadWorld(ecs::SignalDispatch dispatch)
+    {
+        auto meshAdded = [this](ecs::Entity entity) {
+            const StaticMeshComponent *mesh = registry.tryRead<StaticMeshComponent>(entity);
+            if (mesh == nullptr) {
+                return;
+            }
+            std::vector<ecs::Entity> &partition = partitions[mesh->mobility];
+            meshSlots.assign(entity, static_cast<uint32_t>(partition.size()));
+            partition.push_back(entity);
+        };
+        meshConnection = registry.onConstructScoped<StaticMeshComponent>(meshAdded, dispatch);
+    }
+
+    /**
+     * @brief The entity work SceneObject, Node3D and StaticMesh3D do for one object read from a document
+     */
+    ecs::Entity build(std::string_view className, std::string_view name, ReadNode fields, ecs::Entity parent)
+    {
+        ecs::Entity entity = registry.create();
+        registry.add<TagComponent>(entity, std::string(name));
+        registry.add<TransformComponent>(entity);
+        if (className == MESH_CLASS) {
+            registry.add<StaticMeshComponent>(entity);
+        }
+        hierarchy.setParent(entity, parent);
+
+        ReadNode transform = fields.child(KEY_TRANSFORM);
+        ReadNode rotation = transform.child(KEY_ROTATION);
+        hierarchy.setLocal(entity, s_readVec3(transform.child(KEY_TRANSLATION)),
+                           glm::quat(static_cast<float>(rotation.at(3).asF64()), static_cast<float>(rotation.at(0).asF64()),
+                                     static_cast<float>(rotation.at(1).asF64()), static_cast<float>(rotation.at(2).asF64())),
+                           s_readVec3(transform.child(KEY_SCALE)));
+        return entity;
+    }
+
+    /**
+     * @brief Walks the document as the load did before plans, header by header, resolving as it builds
+     * @return False if a class could not be resolved
+     */
+    bool loadSubtrees(ReadNode objects, ecs::Entity parent)
+    {
+        for (size_t i = 0; i < objects.size(); ++i) {
+            ReadNode node = objects.at(i);
+            SceneObject::DocumentHeader header = SceneObject::readHeader(node);
+            if (InstanceRegistry::findObjectFactory(header.className) == nullptr) {
+                return false;
+            }
+
+            const ecs::Entity entity = build(header.className, header.name, node, parent);
+            for (size_t c = 0; c < header.components.size(); ++c) {
+                ReadNode entry = header.components.at(c);
+                if (InstanceRegistry::findComponentFactory(Instance::readClassName(entry)) == nullptr) {
+                    return false;
+                }
+                (void)entry.child(KEY_ID).asU64();
+            }
+
+            if (!loadSubtrees(header.children, entity)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Builds a plan's records in pre-order, as SceneLoadPlan::instantiate does
+     */
+    void instantiate(const SceneLoadPlan &plan, uint32_t count, ecs::Entity parent, size_t &cursor)
+    {
+        for (uint32_t i = 0; i < count; ++i) {
+            const SceneLoadPlan::ObjectRecord &record = plan.objects()[cursor++];
+            const ecs::Entity entity = build(record.className, record.name, record.fields, parent);
+            instantiate(plan, record.childCount, entity, cursor);
+        }
+    }
+
+    bool loadPlan(const SceneLoadPlan &plan)
+    {
+        if (!plan.isValid()) {
+            return false;
+        }
+
+        registry.reserve(static_cast<uint32_t>(registry.getRecords().size() + plan.objects().size()));
+        registry.deferConstructSignals();
+        size_t cursor = 0;
+        instantiate(plan, plan.rootCount(), ecs::ENTITY_NULL, cursor);
+        registry.flushConstructSignals();
+        return true;
+    }
+
+    std::vector<TransformComponent> transforms() const
+    {
+        std::vector<TransformComponent> out;
+        for (auto [entity, transform] : registry.read<TransformComponent>()) {
+            out.push_back(transform);
+        }
+        return out;
+    }
+
+    size_t meshCount() const { return partitions[MOBILITY_STATIC].size() + partitions[MOBILITY_DYNAMIC].size(); }
+};
+
+bool s_sameTransforms(const std::vector<TransformComponent> &a, const std::vector<TransformComponent> &b)
+{
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(TransformComponent)) == 0;
+}
+
+/**
+ * @brief A world loaded object by object as it was, and prepared in jobs then instanced in one pass
+ *
+ * The document is parsed before either is timed, both build the same entities in the same order, and
+ * both have to end up with the same transforms and one mesh slot per mesh.
+ */
+void s_benchWorld(Context &ctx, uint32_t count)
+{
+    const std::string suffix = "/" + std::to_string(count);
+    const SerialDocument document = SerialDocument::parse(s_writeWorld(count));
+    ReadNode instances = document.rootView().child(KEY_INSTANCES);
+    const uint32_t meshes = count - (count + CHILDREN_PER_GROUP - 1) / CHILDREN_PER_GROUP;
+
+    bool loaded = true;
+    const double serialMs = ctx.run("object_by_object/load" + suffix, 5, [&] {
+        LoadWorld world(ecs::SIGNAL_DISPATCH_IMMEDIATE);
+        loaded = world.loadSubtrees(instances, ecs::ENTITY_NULL) && loaded;
+    }).medianMs;
+
+    uint32_t prepareJobs = 0;
+    const double prepareMs = ctx.run("two_phase/prepare" + suffix, 5, [&] {
+        SceneLoadPlan plan = SceneLoadPlan::prepare(instances);
+        loaded = plan.isValid() && loaded;
+        prepareJobs = plan.jobCount();
+    }).medianMs;
+
+    CaseResult &twoPhase = ctx.run("two_phase/load" + suffix, 5, [&] {
+        LoadWorld world(ecs::SIGNAL_DISPATCH_DEFERRABLE);
+        loaded = world.loadPlan(SceneLoadPlan::prepare(instances)) && loaded;
+    });
+    twoPhase.counter("objects", count);
+    twoPhase.counter("meshes", meshes);
+    twoPhase.counter("prepare_jobs", prepareJobs);
+    twoPhase.counter("prepare_ms", prepareMs);
+    if (serialMs > 0.0 && twoPhase.medianMs > 0.0) {
+        twoPhase.counter("speedup_vs_object_by_object", serialMs / twoPhase.medianMs);
+    }
+
+    if (!loaded) {
+        ctx.fail("scene_load" + suffix + ": a class the world names could not be resolved");
+        return;
+    }
+
+    LoadWorld serial(ecs::SIGNAL_DISPATCH_IMMEDIATE);
+    serial.loadSubtrees(instances, ecs::ENTITY_NULL);
+    LoadWorld planned(ecs::SIGNAL_DISPATCH_DEFERRABLE);
+    planned.loadPlan(SceneLoadPlan::prepare(instances));
+
+    if (!s_sameTransforms(serial.transforms(), planned.transforms())) {
+        ctx.fail("two_phase" + suffix + ": the transforms are not the ones the object by object load reads");
+    }
+    if (serial.meshCount() != meshes || planned.meshCount() != meshes) {
+        ctx.fail("two_phase" + suffix + ": not every mesh was handed exactly one slot");
+    }
+}
+
+} // namespace
+
+void runSceneLoadSuite(Context &ctx)
+{
+    // the class names are resolved through the registry the engine fills at startup
+    InstanceRegistry::init();
+
+    s_benchWorld(ctx, 20000);
+    s_benchWorld(ctx, 200000);
+
+    InstanceRegistry::shutdown();
+}
+
+} // namespace Rapture::Bench
@@ -0,0 +1,231 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "core/ecs/registry.h"
+#include "core/serialization/SerialDocument.h"
+#include "scene/SceneSnapshot.h"
+#include "scene/components/ChangeChannels.h"
+#include "scene/components/Components.h"
+#include "scene/instances/SceneObject.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+constexpr uint32_t CHILDREN_PER_GROUP = 64;
+
+constexpr std::string_view KEY_INSTANCES = "instances";
+constexpr std::string_view KEY_CLASS = "class";
+constexpr std::string_view KEY_ID = "id";
+constexpr std::string_view KEY_NAME = "name";
+constexpr std::string_view KEY_CHILDREN = "children";
+constexpr std::string_view KEY_TRANSFORM = "transform";
+constexpr std::string_view KEY_TRANSLATION = "translation";
+constexpr std::string_view KEY_ROTATION = "rotation";
+constexpr std::string_view KEY_SCALE = "scale";
+
+/**
+ * @brief A level of Node3Ds as a registry and the ids its instances go by, without a GPU to build a Scene on
+ *
+ * Every CHILDREN_PER_GROUP'th node is a group the nodes after it are parented to, and the document the
+ * level writes has the shape Scene::serialize gives one: the same keys, nested the same way. An instance
+ * id is the index of its entity plus one.
+ */
+struct SnapshotLevel {
+    ecs::Registry registry{CHANNEL_COUNT};
+    std::vector<ecs::Entity> entities;
+
+    explicit SnapshotLevel(uint32_t count)
+    {
+        entities.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            const float t = static_cast<float>(i % 977) * 0.37f;
+            TransformComponent transform;
+            transform.translation = glm::vec3(t, static_cast<float>(i % 13) * 0.5f, -t * 0.25f);
+            transform.rotation = glm::normalize(glm::quat(glm::vec3(0.01f * t, 0.3f, -0.02f * t)));
+            transform.scale = glm::vec3(1.0f + static_cast<float>(i % 7) * 0.125f);
+
+            entities.push_back(registry.create());
+            registry.add<TransformComponent>(entities.back(), transform);
+        }
+    }
+
+    void write(WriteNode root) const
+    {
+        WriteNode instances = root.addArray(KEY_INSTANCES);
+        for (uint32_t group = 0; group < entities.size(); group += CHILDREN_PER_GROUP) {
+            WriteNode groupNode = writeObject(instances.appendObject(), group);
+
+            const uint32_t end = std::min(group + CHILDREN_PER_GROUP, static_cast<uint32_t>(entities.size()));
+            if (group + 1 < end) {
+                WriteNode children = groupNode.addArray(KEY_CHILDREN);
+                for (uint32_t i = group + 1; i < end; ++i) {
+                    writeObject(children.appendObject(), i);
+                }
+            }
+        }
+    }
+
+    WriteNode writeObject(WriteNode node, uint32_t index) const
+    {
+        const TransformComponent &component = registry.read<TransformComponent>(entities[index]);
+        node.set(KEY_CLASS, std::string_view("Node3D"));
+        node.set(KEY_ID, static_cast<uint64_t>(index + 1));
+        node.set(KEY_NAME, std::string_view("Node"));
+
+        WriteNode transform = node.addObject(KEY_TRANSFORM);
+        WriteNode translation = transform.addArray(KEY_TRANSLATION);
+        WriteNode rotation = transform.addArray(KEY_ROTATION);
+        WriteNode scale = transform.addArray(KEY_SCALE);
+        for (int axis = 0; axis < 3; ++axis) {
+            translation.append(component.translation[axis]);
+            scale.append(component.scale[axis]);
+        }
+        for (int axis = 0; axis < 4; ++axis) {
+            rotation.append(component.rotation[axis]);
+        }
+        return node;
+    }
+
+    /**
+     * @brief Reads one object's transform back onto its entity, the work Node3D::deserialize does
+     */
+    void readObject(InstanceId id, ReadNode node)
+    {
+        ReadNode transform = node.child(KEY_TRANSFORM);
+        ReadNode translation = transform.child(KEY_TRANSLATION);
+        ReadNode rotation = transform.child(KEY_ROTATION);
+        ReadNode scale = transform.child(KEY_SCALE);
+
+        auto component = registry.write<TransformComponent>(entities[id - 1]);
+        for (int axis = 0; axis < 3; ++axis) {
+            component->translation[axis] = static_cast<float>(translation.at(axis).asF64());
+            component->scale[axis] = static_cast<float>(scale.at(axis).asF64());
+        }
+        for (int axis = 0; axis < 4; ++axis) {
+            component->rotation[axis] = static_cast<float>(rotation.at(axis).asF64());
+        }
+    }
+
+    /**
+     * @brief Walks a parsed document the way a restore from it did, header by header and index by index
+     */
+    void readSubtree(ReadNode objects)
+    {
+        for (size_t i = 0; i < objects.size(); ++i) {
+            ReadNode node = objects.at(i);
+            SceneObject::DocumentHeader header = SceneObject::readHeader(node);
+            readObject(header.id, node);
+            readSubtree(header.children);
+        }
+    }
+
+    /**
+     * @brief Moves every node away from where the snapshot has it, the way a run of play would
+     */
+    void disturb()
+    {
+        for (auto [entity, transform] : registry.mutableView<TransformComponent>()) {
+            transform.translation += glm::vec3(1.0f, 0.0f, 0.0f);
+        }
+    }
+
+    std::vector<TransformComponent> transforms() const
+    {
+        std::vector<TransformComponent> out;
+        out.reserve(entities.size());
+        for (ecs::Entity entity : entities) {
+            out.push_back(registry.read<TransformComponent>(entity));
+        }
+        return out;
+    }
+};
+
+bool s_sameTransforms(const std::vector<TransformComponent> &a, const std::vector<TransformComponent> &b)
+{
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(TransformComponent)) == 0;
+}
+
+/**
+ * @brief A level snapshot and restored through text, as play and stop did, and through a SceneSnapshot
+ *
+ * Either way the level must come back bit for bit as it was before it was disturbed.
+ */
+void s_benchLevel(Context &ctx, uint32_t count)
+{
+    const std::string suffix = "/" + std::to_string(count);
+    SnapshotLevel level(count);
+    const std::vector<TransformComponent> original = level.transforms();
+
+    SerialDocument textSnapshot;
+    size_t textBytes = 0;
+    const double textSnapshotMs = ctx.run("json/snapshot" + suffix, 5, [&] {
+        SerialDocument builder;
+        level.write(builder.root());
+        const std::string text = builder.toText();
+        textBytes = text.size();
+        textSnapshot = SerialDocument::parse(text);
+    }).medianMs;
+
+    SceneSnapshot binarySnapshot;
+    CaseResult &binarySnapshotResult = ctx.run("binary/snapshot" + suffix, 5, [&] {
+        SerialDocument builder(SERIAL_FLOAT_NATIVE);
+        level.write(builder.root());
+        binarySnapshot = SceneSnapshot::capture(std::move(builder), level.registry);
+    });
+    binarySnapshotResult.counter("objects", count);
+    binarySnapshotResult.counter("json_text_bytes", static_cast<double>(textBytes));
+    if (binarySnapshotResult.medianMs > 0.0) {
+        binarySnapshotResult.counter("speedup_vs_json", textSnapshotMs / binarySnapshotResult.medianMs);
+    }
+
+    // a case was filtered out, there is nothing to restore from
+    if (!textSnapshot.isReadable() || binarySnapshot.isEmpty()) {
+        return;
+    }
+
+    auto restoreText = [&] { level.readSubtree(textSnapshot.rootView().child(KEY_INSTANCES)); };
+    auto restoreBinary = [&] {
+        for (const SceneSnapshot::ObjectRecord &record : binarySnapshot.objects()) {
+            level.readObject(record.id, record.fields);
+        }
+        binarySnapshot.restorePools(level.registry);
+    };
+
+    const double textRestoreMs = ctx.run("json/restore" + suffix, 5, restoreText).medianMs;
+    CaseResult &binaryRestoreResult = ctx.run("binary/restore" + suffix, 5, restoreBinary);
+    binaryRestoreResult.counter("objects", count);
+    if (binaryRestoreResult.medianMs > 0.0) {
+        binaryRestoreResult.counter("speedup_vs_json", textRestoreMs / binaryRestoreResult.medianMs);
+    }
+
+    level.disturb();
+    restoreText();
+    if (!s_sameTransforms(level.transforms(), original)) {
+        ctx.fail("json" + suffix + ": the level did not come back from text as it was");
+    }
+
+    level.disturb();
+    restoreBinary();
+    if (!s_sameTransforms(level.transforms(), original)) {
+        ctx.fail("binary" + suffix + ": the level did not come back from its snapshot as it was");
+    }
+}
+
+} // namespace
+
+void runSceneSnapshotSuite(Context &ctx)
+{
+    s_benchLevel(ctx, 10000);
+    s_benchLevel(ctx, 100000);
+    if (!ctx.quick()) {
+        s_benchLevel(ctx, 500000);
+    }
+}
+
+} // namespace Rapture::Bench
@@ -0,0 +1,240 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "core/serialization/SerialBinary.h"
+#include "core/serialization/SerialDocument.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+constexpr uint32_t CHILDREN_PER_GROUP = 64;
+constexpr size_t CHUNK_BYTES = 256 * 1024; // what SceneStream closes a chunk at
+
+constexpr std::string_view KEY_INSTANCES = "instances";
+constexpr std::string_view KEY_CLASS = "class";
+constexpr std::string_view KEY_ID = "id";
+constexpr std::string_view KEY_NAME = "name";
+constexpr std::string_view KEY_CHILDREN = "children";
+constexpr std::string_view KEY_TRANSFORM = "transform";
+constexpr std::string_view KEY_TRANSLATION = "translation";
+constexpr std::string_view KEY_ROTATION = "rotation";
+constexpr std::string_view KEY_SCALE = "scale";
+constexpr std::string_view KEY_VISIBLE = "visible";
+
+constexpr uint32_t FLOATS_PER_OBJECT = 10;
+
+/**
+ * @brief The fields of a level of Node3Ds, written in the shape Scene::serialize gives a scene
+ *
+ * Every CHILDREN_PER_GROUP'th object is a group the objects after it are parented to, so a group is what
+ * a scene stream writes as one top level object.
+ */
+struct FormatLevel {
+    std::vector<float> floats; // FLOATS_PER_OBJECT per object: translation, rotation, scale
+    uint32_t count = 0;
+
+    explicit FormatLevel(uint32_t objectCount) : count(objectCount)
+    {
+        floats.reserve(static_cast<size_t>(count) * FLOATS_PER_OBJECT);
+        for (uint32_t i = 0; i < count; ++i) {
+            const float t = static_cast<float>(i % 977) * 0.37f;
+            const float values[FLOATS_PER_OBJECT] = {t,    static_cast<float>(i % 13) * 0.5f, -t * 0.25f, 0.1f * t, 0.7f, -0.3f,
+                                                     0.6f, 1.0f + static_cast<float>(i % 7) * 0.125f, 1.0f, 0.8f};
+            floats.insert(floats.end(), values, values + FLOATS_PER_OBJECT);
+        }
+    }
+
+    void writeObject(WriteNode node, uint32_t index) const
+    {
+        node.set(KEY_CLASS, std::string_view("Node3D"));
+        node.set(KEY_ID, static_cast<uint64_t>(index + 1));
+        node.set(KEY_NAME, std::string_view("Node"));
+        node.set(KEY_VISIBLE, true);
+
+        const float *values = floats.data() + static_cast<size_t>(index) * FLOATS_PER_OBJECT;
+        WriteNode transform = node.addObject(KEY_TRANSFORM);
+        WriteNode translation = transform.addArray(KEY_TRANSLATION);
+        WriteNode rotation = transform.addArray(KEY_ROTATION);
+        WriteNode scale = transform.addArray(KEY_SCALE);
+        for (int i = 0; i < 3; ++i) {
+            translation.append(values[i]);
+        }
+        for (int i = 3; i < 7; ++i) {
+            rotation.append(values[i]);
+        }
+        for (int i = 7; i < 10; ++i) {
+            scale.append(values[i]);
+        }
+    }
+
+    void writeGroup(WriteNode node, uint32_t group) const
+    {
+        writeObject(node, group);
+
+        const uint32_t end = std::min(group + CHILDREN_PER_GROUP, count);
+        if (group + 1 < end) {
+            WriteNode children = node.addArray(KEY_CHILDREN);
+            for (uint32_t i = group + 1; i < end; ++i) {
+                writeObject(children.appendObject(), i);
+            }
+        }
+    }
+
+    void writeScene(WriteNode root) const
+    {
+        WriteNode instances = root.addArray(KEY_INSTANCES);
+        for (uint32_t group = 0; group < count; group += CHILDREN_PER_GROUP) {
+            writeGroup(instances.appendObject(), group);
+        }
+    }
+};
+
+/**
+ * @brief A level encoded the way writeSceneStream encodes one, a run of chunks of top level objects
+ */
+struct EncodedLevel {
+    struct Chunk {
+        size_t offset = 0;
+        size_t size = 0;
+        uint32_t count = 0;
+    };
+
+    std::vector<uint8_t> bytes;
+    std::vector<Chunk> chunks;
+};
+
+void s_encodeLevel(const FormatLevel &level, EncodedLevel &out)
+{
+    out.bytes.clear();
+    out.chunks.clear();
+
+    SerialBinaryEncoder encoder;
+    EncodedLevel::Chunk chunk;
+    for (uint32_t group = 0; group < level.count; group += CHILDREN_PER_GROUP) {
+        SerialDocument object(SERIAL_FLOAT_NATIVE);
+        level.writeGroup(object.root(), group);
+        encoder.encode(object, out.bytes);
+        chunk.count++;
+
+        chunk.size = out.bytes.size() - chunk.offset;
+        if (chunk.size >= CHUNK_BYTES) {
+            out.chunks.push_back(chunk);
+            encoder.reset();
+            chunk = EncodedLevel::Chunk{out.bytes.size(), 0, 0};
+        }
+    }
+    if (chunk.count > 0) {
+        out.chunks.push_back(chunk);
+    }
+}
+
+/**
+ * @brief Gathers an object's floats, and those of every object under it, in the order they were written
+ */
+void s_collectFloats(ReadNode node, std::vector<float> &out)
+{
+    ReadNode transform = node.child(KEY_TRANSFORM);
+    for (std::string_view key : {KEY_TRANSLATION, KEY_ROTATION, KEY_SCALE}) {
+        for (ReadNode value : transform.child(key).elements()) {
+            out.push_back(static_cast<float>(value.asF64()));
+        }
+    }
+    for (ReadNode child : node.child(KEY_CHILDREN).elements()) {
+        s_collectFloats(child, out);
+    }
+}
+
+bool s_sameFloats(const std::vector<float> &a, const std::vector<float> &b)
+{
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+/**
+ * @brief A level saved and loaded as one JSON document, and as the chunks a scene stream holds
+ *
+ * Either way every float has to read back bit for bit as it was written.
+ */
+void s_benchLevel(Context &ctx, uint32_t count)
+{
+    const std::string suffix = "/" + std::to_string(count);
+    FormatLevel level(count);
+
+    std::string text;
+    const double textSaveMs = ctx.run("json/save" + suffix, 5, [&] {
+        SerialDocument document;
+        level.writeScene(document.root());
+        text = document.toText();
+    }).medianMs;
+
+    EncodedLevel encoded;
+    CaseResult &binarySave = ctx.run("binary/save" + suffix, 5, [&] { s_encodeLevel(level, encoded); });
+    binarySave.counter("objects", count);
+    binarySave.counter("json_bytes", static_cast<double>(text.size()));
+    binarySave.counter("binary_bytes", static_cast<double>(encoded.bytes.size()));
+    binarySave.counter("chunks", static_cast<double>(encoded.chunks.size()));
+    if (binarySave.medianMs > 0.0) {
+        binarySave.counter("speedup_vs_json", textSaveMs / binarySave.medianMs);
+    }
+
+    // a case was filtered out, there is nothing to load
+    if (text.empty() || encoded.bytes.empty()) {
+        return;
+    }
+
+    std::vector<float> textFloats;
+    auto loadText = [&] {
+        SerialDocument document = SerialDocument::parse(text);
+        textFloats.clear();
+        for (ReadNode group : document.rootView().child(KEY_INSTANCES).elements()) {
+            s_collectFloats(group, textFloats);
+        }
+    };
+
+    // one chunk decoded at a time and dropped once read, as SceneStreamReader does
+    std::vector<float> binaryFloats;
+    auto loadBinary = [&] {
+        binaryFloats.clear();
+        for (const EncodedLevel::Chunk &chunk : encoded.chunks) {
+            std::span<const uint8_t> bytes(encoded.bytes.data() + chunk.offset, chunk.size);
+            SerialDocument document = decodeSerialBinary(bytes, chunk.count);
+            for (ReadNode group : document.rootView().elements()) {
+                s_collectFloats(group, binaryFloats);
+            }
+        }
+    };
+
+    const double textLoadMs = ctx.run("json/load" + suffix, 5, loadText).medianMs;
+    CaseResult &binaryLoad = ctx.run("binary/load" + suffix, 5, loadBinary);
+    binaryLoad.counter("objects", count);
+    if (binaryLoad.medianMs > 0.0) {
+        binaryLoad.counter("speedup_vs_json", textLoadMs / binaryLoad.medianMs);
+    }
+
+    loadText();
+    if (!s_sameFloats(textFloats, level.floats)) {
+        ctx.fail("json" + suffix + ": the floats read back are not the ones written");
+    }
+
+    loadBinary();
+    if (!s_sameFloats(binaryFloats, level.floats)) {
+        ctx.fail("binary" + suffix + ": the floats read back are not the ones written");
+    }
+}
+
+} // namespace
+
+void runSerialFormatSuite(Context &ctx)
+{
+    s_benchLevel(ctx, 10000);
+    s_benchLevel(ctx, 100000);
+    if (!ctx.quick()) {
+        s_benchLevel(ctx, 500000);
+    }
+}
+
+} // namespace Rapture::Bench
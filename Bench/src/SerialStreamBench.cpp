@@ -0,0 +1,268 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "core/serialization/SerialDocument.h"
+#include "core/serialization/SerialStream.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+constexpr uint32_t CHILDREN_PER_GROUP = 64;
+
+constexpr std::string_view KEY_SCENE = "scene";
+constexpr std::string_view KEY_NAME = "name";
+constexpr std::string_view KEY_INSTANCES = "instances";
+constexpr std::string_view KEY_CLASS = "class";
+constexpr std::string_view KEY_ID = "id";
+constexpr std::string_view KEY_CHILDREN = "children";
+constexpr std::string_view KEY_TRANSFORM = "transform";
+constexpr std::string_view KEY_TRANSLATION = "translation";
+constexpr std::string_view KEY_ROTATION = "rotation";
+constexpr std::string_view KEY_SCALE = "scale";
+constexpr std::string_view KEY_VISIBLE = "visible";
+
+/**
+ * @brief A world of Node3Ds written the way World::serialize writes one, groups of children under the root
+ */
+struct StreamLevel {
+    uint32_t count = 0;
+
+    void writeObject(WriteNode node, uint32_t index) const
+    {
+        const float t = static_cast<float>(index % 977) * 0.37f;
+        node.set(KEY_CLASS, std::string_view("Node3D"));
+        node.set(KEY_ID, static_cast<uint64_t>(index + 1));
+        node.set(KEY_NAME, std::string_view("Node"));
+        node.set(KEY_VISIBLE, true);
+
+        WriteNode transform = node.addObject(KEY_TRANSFORM);
+        WriteNode translation = transform.addArray(KEY_TRANSLATION);
+        translation.append(t);
+        translation.append(static_cast<float>(index % 13) * 0.5f);
+        translation.append(-t * 0.25f);
+        WriteNode rotation = transform.addArray(KEY_ROTATION);
+        rotation.append(0.1f * t);
+        rotation.append(0.7f);
+        rotation.append(-0.3f);
+        rotation.append(0.6f);
+        WriteNode scale = transform.addArray(KEY_SCALE);
+        scale.append(1.0f + static_cast<float>(index % 7) * 0.125f);
+        scale.append(1.0f);
+        scale.append(0.8f);
+    }
+
+    void writeGroup(WriteNode node, uint32_t group) const
+    {
+        writeObject(node, group);
+
+        const uint32_t end = std::min(group + CHILDREN_PER_GROUP, count);
+        if (group + 1 < end) {
+            WriteNode children = node.addArray(KEY_CHILDREN);
+            for (uint32_t i = group + 1; i < end; ++i) {
+                writeObject(children.appendObject(), i);
+            }
+        }
+    }
+
+    void writeHeader(WriteNode node) const { node.set(KEY_NAME, std::string_view("Bench World")); }
+
+    /**
+     * @brief The whole world in one document, turned to text and written out, as World::serialize does
+     */
+    bool saveAsTree(std::FILE *file, SerialKeyStorage keys, size_t &bytes) const
+    {
+        SerialDocument document(SERIAL_FLOAT_TEXT, keys);
+        WriteNode root = document.root();
+        writeHeader(root);
+
+        WriteNode instances = root.addObject(KEY_SCENE).addArray(KEY_INSTANCES);
+        for (uint32_t group = 0; group < count; group += CHILDREN_PER_GROUP) {
+            writeGroup(instances.appendObject(), group);
+        }
+
+        const std::string text = document.toText();
+        bytes = text.size();
+        return std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(text.data(), 1, text.size(), file) == text.size() &&
+               std::fflush(file) == 0;
+    }
+
+    /**
+     * @brief The world streamed a group at a time, as World::serializeTo does
+     */
+    bool saveAsStream(std::FILE *file, size_t &bytes) const
+    {
+        if (std::fseek(file, 0, SEEK_SET) != 0) {
+            return false;
+        }
+
+#if defined(_WIN32)
+        SerialStreamWriter writer(_fileno(file));
+#else
+        SerialStreamWriter writer(fileno(file));
+#endif // _WIN32
+
+        writer.beginObject();
+        writer.writeMembers([this](WriteNode node) { writeHeader(node); });
+        writer.beginObject(KEY_SCENE);
+        writer.beginArray(KEY_INSTANCES);
+        for (uint32_t group = 0; group < count; group += CHILDREN_PER_GROUP) {
+            writer.appendObject([this, group](WriteNode node) { writeGroup(node, group); });
+        }
+        writer.end();
+        writer.end();
+
+        const bool ok = writer.finish();
+        bytes = static_cast<size_t>(writer.bytesWritten());
+        return ok;
+    }
+};
+
+/**
+ * @brief Starts a new peak for s_peakRssBytes to report, where the platform lets one be started
+ * @return The resident bytes the peak starts from, 0 if the platform does not report it
+ */
+size_t s_resetPeakRss()
+{
+#if defined(__linux__)
+    std::ofstream("/proc/self/clear_refs") << "5";
+
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) {
+            return std::stoull(line.substr(6)) * 1024;
+        }
+    }
+#endif // __linux__
+    return 0;
+}
+
+/**
+ * @brief The most resident memory since the last s_resetPeakRss, 0 if the platform does not report it
+ */
+size_t s_peakRssBytes()
+{
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stoull(line.substr(6)) * 1024;
+        }
+    }
+#endif // __linux__
+    return 0;
+}
+
+/**
+ * @brief Runs one save outside the timings and measures how far it raised resident memory
+ * @return The growth in bytes, 0 if the platform does not report it
+ */
+template <typename Fn>
+size_t s_measurePeak(Fn &&save)
+{
+    const size_t before = s_resetPeakRss();
+    save();
+    const size_t peak = s_peakRssBytes();
+    return before > 0 && peak >= before ? peak - before : 0;
+}
+
+std::string s_readFile(std::FILE *file, size_t size)
+{
+    std::string text(size, '\0');
+    if (std::fseek(file, 0, SEEK_SET) != 0 || std::fread(text.data(), 1, size, file) != size) {
+        return {};
+    }
+    return text;
+}
+
+/**
+ * @brief A world saved as one document, with keys copied and borrowed, and streamed a group at a time
+ *
+ * The stream has to write the very text the document does. Its peak is measured first, so what the document
+ * saves leave behind in the heap is not counted against it.
+ */
+void s_benchLevel(Context &ctx, uint32_t count)
+{
+    const std::string suffix = "/" + std::to_string(count);
+    const StreamLevel level{count};
+
+    std::FILE *treeFile = std::tmpfile();
+    std::FILE *streamFile = std::tmpfile();
+    if (treeFile == nullptr || streamFile == nullptr) {
+        ctx.fail("serial_stream" + suffix + ": no temporary file to save into");
+        if (treeFile != nullptr) {
+            std::fclose(treeFile);
+        }
+        if (streamFile != nullptr) {
+            std::fclose(streamFile);
+        }
+        return;
+    }
+
+    bool saved = true;
+    size_t streamBytes = 0;
+    size_t treeBytes = 0;
+    size_t borrowedBytes = 0;
+
+    auto saveStream = [&] { saved = level.saveAsStream(streamFile, streamBytes) && saved; };
+    auto saveTree = [&] { saved = level.saveAsTree(treeFile, SERIAL_KEYS_COPIED, treeBytes) && saved; };
+    auto saveBorrowed = [&] { saved = level.saveAsTree(treeFile, SERIAL_KEYS_BORROWED, borrowedBytes) && saved; };
+
+    // the peaks are taken before any of the timings, the stream's first
+    const size_t streamPeak = ctx.selected("stream/save" + suffix) ? s_measurePeak(saveStream) : 0;
+    const size_t treePeak = ctx.selected("tree/save" + suffix) ? s_measurePeak(saveTree) : 0;
+
+    CaseResult &tree = ctx.run("tree/save" + suffix, 5, saveTree);
+    const double treeMs = tree.medianMs;
+    tree.counter("objects", count);
+    tree.counter("bytes", static_cast<double>(treeBytes));
+    if (treePeak > 0) {
+        tree.counter("peak_rss_growth_bytes", static_cast<double>(treePeak));
+    }
+
+    CaseResult &borrowed = ctx.run("tree_borrowed_keys/save" + suffix, 5, saveBorrowed);
+    if (treeMs > 0.0 && borrowed.medianMs > 0.0) {
+        borrowed.counter("speedup_vs_tree", treeMs / borrowed.medianMs);
+    }
+
+    CaseResult &stream = ctx.run("stream/save" + suffix, 5, saveStream);
+    stream.counter("objects", count);
+    stream.counter("bytes", static_cast<double>(streamBytes));
+    stream.counter("thread_arena_bytes", static_cast<double>(SerialStreamWriter::threadArenaBytes()));
+    if (streamPeak > 0) {
+        stream.counter("peak_rss_growth_bytes", static_cast<double>(streamPeak));
+    }
+    if (treeMs > 0.0 && stream.medianMs > 0.0) {
+        stream.counter("speedup_vs_tree", treeMs / stream.medianMs);
+    }
+
+    if (!saved) {
+        ctx.fail("serial_stream" + suffix + ": a save could not be written");
+    } else if (streamBytes > 0 && treeBytes > 0 && s_readFile(streamFile, streamBytes) != s_readFile(treeFile, treeBytes)) {
+        ctx.fail("serial_stream" + suffix + ": the stream did not write the text the document does");
+    }
+
+    std::fclose(treeFile);
+    std::fclose(streamFile);
+}
+
+} // namespace
+
+void runSerialStreamSuite(Context &ctx)
+{
+    s_benchLevel(ctx, 10000);
+    s_benchLevel(ctx, 100000);
+    if (!ctx.quick()) {
+        s_benchLevel(ctx, 500000);
+    }
+}
+
+} // namespace Rapture::Bench
@@ -0,0 +1,171 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "core/utils/Log.h"
+#include "core/utils/io.h"
+#include "gpu/shaders/ShaderCache.h"
+#include "gpu/shaders/ShaderCompilation.h"
+#include "gpu/shaders/ShaderReflections.h"
+
+#include <filesystem>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+struct StageSpirv {
+    std::filesystem::path path;
+    VkShaderStageFlags stage;
+    std::vector<char> spirv;
+};
+
+VkShaderStageFlags s_stageFromName(const std::string &name)
+{
+    if (name.find(".vs.") != std::string::npos) return VK_SHADER_STAGE_VERTEX_BIT;
+    if (name.find(".fs.") != std::string::npos) return VK_SHADER_STAGE_FRAGMENT_BIT;
+    if (name.find(".cs.") != std::string::npos) return VK_SHADER_STAGE_COMPUTE_BIT;
+    if (name.find(".gs.") != std::string::npos) return VK_SHADER_STAGE_GEOMETRY_BIT;
+    if (name.find(".mesh.") != std::string::npos) return VK_SHADER_STAGE_MESH_BIT_EXT;
+    if (name.find(".task.") != std::string::npos) return VK_SHADER_STAGE_TASK_BIT_EXT;
+    return 0;
+}
+
+/**
+ * @brief Compiles every stage source of the engine shader set, plus the precompiled SPIR-V it ships
+ *
+ * Stages that fail outside the engine, e.g. ones that need a generated material include, are left out.
+ */
+std::vector<StageSpirv> s_compileEngineShaders(const std::filesystem::path &shaderRoot)
+{
+    std::vector<StageSpirv> stages;
+    ShaderCompiler compiler;
+    const std::filesystem::path glslRoot = shaderRoot / "glsl";
+
+    std::error_code ec;
+    for (const auto &file : std::filesystem::recursive_directory_iterator(shaderRoot, ec)) {
+        if (!file.is_regular_file()) {
+            continue;
+        }
+
+        const std::filesystem::path &path = file.path();
+        VkShaderStageFlags stage = s_stageFromName(path.filename().string());
+        if (stage == 0) {
+            continue;
+        }
+
+        std::vector<char> spirv;
+        if (path.extension() == ".spv") {
+            spirv = readFile(path);
+        } else if (path.extension() == ".glsl") {
+            // engine shaders include either relative to their own folder or to the glsl root
+            ShaderCompileInfo info;
+            info.includePath = path.parent_path();
+            spirv = compiler.Compile(path, info);
+            if (spirv.empty()) {
+                info.includePath = glslRoot;
+                spirv = compiler.Compile(path, info);
+            }
+        }
+
+        if (!spirv.empty()) {
+            stages.push_back({path, stage, std::move(spirv)});
+        }
+    }
+    return stages;
+}
+
+// What Shader did before the single pass: one reflection module per query
+void s_reflectPerQuery(const StageSpirv &stage)
+{
+    const uint32_t *code = reinterpret_cast<const uint32_t *>(stage.spirv.data());
+    SpvReflectShaderModule module;
+    if (spvReflectCreateShaderModule(stage.spirv.size(), code, &module) == SPV_REFLECT_RESULT_SUCCESS) {
+        uint32_t count = 0;
+        spvReflectEnumerateDescriptorBindings(&module, &count, nullptr);
+        std::vector<SpvReflectDescriptorBinding *> bindings(count);
+        spvReflectEnumerateDescriptorBindings(&module, &count, bindings.data());
+        doNotOptimize(bindings);
+        spvReflectDestroyShaderModule(&module);
+    }
+
+    doNotOptimize(getCombinedPushConstantRanges({{stage.spirv, stage.stage}}));
+    doNotOptimize(extractDetailedPushConstants(stage.spirv));
+    doNotOptimize(extractMaterialSets(stage.spirv));
+}
+
+} // namespace
+
+void runShaderReflectionSuite(Context &ctx)
+{
+    const std::filesystem::path shaderRoot = std::filesystem::path(RAPTURE_BENCH_ENGINE_ASSETS) / "shaders";
+    std::vector<StageSpirv> stages = s_compileEngineShaders(shaderRoot);
+    if (stages.empty()) {
+        ctx.fail("no engine shaders compiled from " + shaderRoot.string());
+        return;
+    }
+
+    size_t spirvBytes = 0;
+    for (const auto &stage : stages) {
+        spirvBytes += stage.spirv.size();
+    }
+
+    std::vector<ShaderStageReflection> reflections(stages.size());
+    std::vector<std::vector<uint8_t>> encoded(stages.size());
+    size_t encodedBytes = 0;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        if (!reflectStageSpirv(stages[i].spirv, stages[i].stage, reflections[i])) {
+            ctx.fail("could not reflect " + stages[i].path.string());
+        }
+        encoded[i] = ShaderCache::serializeReflection(reflections[i]);
+        encodedBytes += encoded[i].size();
+
+        // a decoded entry has to encode back to the same bytes, or a warm start sees different data
+        ShaderStageReflection decoded;
+        if (!ShaderCache::deserializeReflection(encoded[i], decoded) || ShaderCache::serializeReflection(decoded) != encoded[i]) {
+            ctx.fail("reflection of " + stages[i].path.string() + " does not round-trip");
+        }
+    }
+
+    const uint32_t iterations = 20;
+
+    ctx.run("reflect_per_query", iterations, [&] {
+        for (const auto &stage : stages) {
+            s_reflectPerQuery(stage);
+        }
+    })
+        .counter("stages", static_cast<double>(stages.size()))
+        .counter("spirv_bytes", static_cast<double>(spirvBytes));
+
+    ctx.run("reflect_single_pass", iterations, [&] {
+        for (const auto &stage : stages) {
+            ShaderStageReflection reflection;
+            reflectStageSpirv(stage.spirv, stage.stage, reflection);
+            doNotOptimize(reflection);
+        }
+    }).counter("stages", static_cast<double>(stages.size()));
+
+    ctx.run("decode_cached", iterations, [&] {
+        for (const auto &bytes : encoded) {
+            ShaderStageReflection reflection;
+            ShaderCache::deserializeReflection(bytes, reflection);
+            doNotOptimize(reflection);
+        }
+    }).counter("encoded_bytes", static_cast<double>(encodedBytes));
+
+    // the warm start as the engine sees it: the `.refl` read from disk, checked against the SPIR-V, then decoded
+    for (size_t i = 0; i < stages.size(); ++i) {
+        ShaderCache::storeReflection(stages[i].spirv, reflections[i]);
+    }
+    ctx.run("load_cached_from_disk", iterations, [&] {
+        for (const auto &stage : stages) {
+            ShaderStageReflection reflection;
+            if (!ShaderCache::loadReflection(stage.spirv, reflection)) {
+                ctx.fail("cached reflection of " + stage.path.string() + " did not load");
+            }
+            doNotOptimize(reflection);
+        }
+    });
+}
+
+} // namespace Rapture::Bench
@@ -0,0 +1,33 @@
+#ifndef RAPTURE__BENCH_SUITES_H
+#define RAPTURE__BENCH_SUITES_H
+
+#include "Bench.h"
+
+namespace Rapture::Bench {
+
+// One entry point per suite, listed in main.cpp. Each suite times its own cases and reports
+// failed determinism or correctness checks through the context.
+
+void runShaderReflectionSuite(Context &ctx);
+void runMaterialGraphSuite(Context &ctx);
+void runTextureDecodeSuite(Context &ctx);
+void runTransformHierarchySuite(Context &ctx);
+void runTransformMathSuite(Context &ctx);
+void runFrustumCullSuite(Context &ctx);
+void runSceneBVHSuite(Context &ctx);
+void runDrawCullSuite(Context &ctx);
+void runRenderDataSlotsSuite(Context &ctx);
+void runRenderDataPackSuite(Context &ctx);
+void runPhysicsJobsSuite(Context &ctx);
+void runPhysicsInterpolationSuite(Context &ctx);
+void runPhysicsCharactersSuite(Context &ctx);
+void runPhysicsShapesSuite(Context &ctx);
+void runPhysicsQueriesSuite(Context &ctx);
+void runSceneSnapshotSuite(Context &ctx);
+void runSerialFormatSuite(Context &ctx);
+void runSerialStreamSuite(Context &ctx);
+void runSceneLoadSuite(Context &ctx);
+
+} // namespace Rapture::Bench
+
+#endif // RAPTURE__BENCH_SUITES_H
@@ -0,0 +1,238 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "assets/loaders/images/ImageDecoder.h"
+
+#include <stb_image.h>
+
+// The engine only ever reads images, the encoder is compiled here to build the inputs in memory
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+constexpr uint32_t BATCH_IMAGES = 32;
+constexpr uint32_t BATCH_SIZE = 512;
+constexpr int JPEG_QUALITY = 90;
+
+// Baseline JPEG decoders may round their IDCT differently, so only PNG has to match to the byte
+constexpr double JPEG_MAX_MEAN_ERROR = 2.0;
+
+struct EncodedImage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> bytes;
+};
+
+/**
+ * @brief RGBA8 content that compresses like a real texture: smooth gradients, some detail and a little noise
+ */
+std::vector<uint8_t> s_proceduralPixels(uint32_t size, uint32_t seed)
+{
+    std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4);
+    uint32_t noise = seed * 2654435761u + 1;
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            noise = noise * 1664525u + 1013904223u;
+            const float u = static_cast<float>(x) / static_cast<float>(size);
+            const float v = static_cast<float>(y) / static_cast<float>(size);
+            const float detail = 0.5f + 0.5f * std::sin((u * 23.0f + v * 7.0f + static_cast<float>(seed)) * 3.14159f);
+
+            uint8_t *px = &pixels[(static_cast<size_t>(y) * size + x) * 4];
+            px[0] = static_cast<uint8_t>(u * 255.0f);
+            px[1] = static_cast<uint8_t>(v * 255.0f);
+            px[2] = static_cast<uint8_t>(detail * 223.0f + static_cast<float>(noise >> 27));
+            px[3] = static_cast<uint8_t>(255 - ((x ^ y) & 31));
+        }
+    }
+    return pixels;
+}
+
+void s_appendBytes(void *context, void *data, int size)
+{
+    auto *bytes = static_cast<std::vector<uint8_t> *>(context);
+    const auto *src = static_cast<const uint8_t *>(data);
+    bytes->insert(bytes->end(), src, src + size);
+}
+
+EncodedImage s_encodePng(uint32_t size, uint32_t seed)
+{
+    EncodedImage image{size, size, {}};
+    std::vector<uint8_t> pixels = s_proceduralPixels(size, seed);
+    stbi_write_png_to_func(s_appendBytes, &image.bytes, static_cast<int>(size), static_cast<int>(size), 4, pixels.data(),
+                           static_cast<int>(size * 4));
+    return image;
+}
+
+EncodedImage s_encodeJpeg(uint32_t size, uint32_t seed)
+{
+    EncodedImage image{size, size, {}};
+    std::vector<uint8_t> pixels = s_proceduralPixels(size, seed);
+    stbi_write_jpg_to_func(s_appendBytes, &image.bytes, static_cast<int>(size), static_cast<int>(size), 4, pixels.data(),
+                           JPEG_QUALITY);
+    return image;
+}
+
+/**
+ * @brief The path textures took before decoders wrote to staging: stb_image allocates, then the pixels are copied
+ */
+bool s_decodeViaHeap(const EncodedImage &image, std::span<uint8_t> staging)
+{
+    int width = 0, height = 0, channels = 0;
+    stbi_uc *pixels = stbi_load_from_memory(image.bytes.data(), static_cast<int>(image.bytes.size()), &width, &height,
+                                            &channels, STBI_rgb_alpha);
+    if (pixels == nullptr) {
+        return false;
+    }
+    std::memcpy(staging.data(), pixels, staging.size());
+    stbi_image_free(pixels);
+    return true;
+}
+
+bool s_decodeDirect(const ImageDecoder &decoder, const EncodedImage &image, std::span<uint8_t> staging)
+{
+    ImageInfo info;
+    return decoder.readInfo(image.bytes, info) && decoder.decodeInto(image.bytes, info, staging);
+}
+
+void s_throughput(CaseResult &result, const EncodedImage &image, uint32_t imageCount)
+{
+    if (result.medianMs <= 0.0) {
+        return;
+    }
+    const double seconds = result.medianMs / 1000.0;
+    const double pixels = static_cast<double>(image.width) * image.height * imageCount;
+    result.counter("megapixels_per_s", pixels / 1.0e6 / seconds)
+        .counter("encoded_mb_per_s", static_cast<double>(image.bytes.size()) * imageCount / 1.0e6 / seconds)
+        .counter("encoded_bytes", static_cast<double>(image.bytes.size()));
+}
+
+double s_meanError(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        total += static_cast<uint64_t>(std::abs(static_cast<int>(a[i]) - static_cast<int>(b[i])));
+    }
+    return a.empty() ? 0.0 : static_cast<double>(total) / static_cast<double>(a.size());
+}
+
+/**
+ * @brief Decodes one image both ways, checks the outputs agree and times them
+ */
+void s_compareDecoders(Context &ctx, const ImageDecoder &fast, const char *format, const EncodedImage &image,
+                       uint32_t iterations)
+{
+    const std::string suffix = std::string(format) + "/" + std::to_string(image.width);
+    const size_t size = static_cast<size_t>(image.width) * image.height * 4;
+
+    std::vector<uint8_t> reference(size);
+    std::vector<uint8_t> decoded(size);
+    if (!s_decodeViaHeap(image, reference) || !s_decodeDirect(fast, image, decoded)) {
+        ctx.fail("decode_" + suffix + ": a decoder rejected the image");
+        return;
+    }
+
+    const double meanError = s_meanError(reference, decoded);
+    const bool lossless = std::string_view(format) == "png";
+    if (lossless ? reference != decoded : meanError > JPEG_MAX_MEAN_ERROR) {
+        ctx.fail("decode_" + suffix + ": " + std::string(fast.getName()) + " differs from stb_image, mean error " +
+                 std::to_string(meanError));
+    }
+
+    // The staging buffer stands in for the mapped upload memory, allocated once like the real one
+    std::vector<uint8_t> staging(size);
+
+    CaseResult &heap = ctx.run("decode_stb_heap_copy_" + suffix, iterations, [&] {
+        s_decodeViaHeap(image, staging);
+        doNotOptimize(staging.data());
+    });
+    s_throughput(heap, image, 1);
+
+    CaseResult &direct = ctx.run("decode_" + std::string(fast.getName()) + "_direct_" + suffix, iterations, [&] {
+        s_decodeDirect(fast, image, staging);
+        doNotOptimize(staging.data());
+    });
+    s_throughput(direct, image, 1);
+    direct.counter("mean_error_vs_stb", meanError);
+}
+
+/**
+ * @brief A folder of textures loading at once, each on its own thread like each texture gets its own job
+ */
+void s_decodeBatch(Context &ctx, const std::vector<EncodedImage> &images, bool direct)
+{
+    const uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    const size_t size = static_cast<size_t>(images.front().width) * images.front().height * 4;
+    std::vector<std::vector<uint8_t>> staging(images.size(), std::vector<uint8_t>(size));
+
+    std::atomic<uint32_t> failures{0};
+    CaseResult &result = ctx.run(direct ? "decode_batch_direct" : "decode_batch_stb_heap_copy", 5, [&] {
+        std::atomic<uint32_t> next{0};
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&] {
+                for (uint32_t i = next++; i < images.size(); i = next++) {
+                    const EncodedImage &image = images[i];
+                    bool ok = direct ? s_decodeDirect(ImageDecoderRegistry::find(image.bytes), image, staging[i])
+                                     : s_decodeViaHeap(image, staging[i]);
+                    if (!ok) {
+                        ++failures;
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    });
+    s_throughput(result, images.front(), static_cast<uint32_t>(images.size()));
+    result.counter("images", static_cast<double>(images.size())).counter("threads", threadCount);
+
+    if (failures.load() != 0) {
+        ctx.fail(std::string(direct ? "decode_batch_direct" : "decode_batch_stb_heap_copy") + ": " +
+                 std::to_string(failures.load()) + " decode(s) failed");
+    }
+}
+
+} // namespace
+
+void runTextureDecodeSuite(Context &ctx)
+{
+    const ImageDecoder *wuffs = ImageDecoderRegistry::get("wuffs");
+    if (wuffs == nullptr) {
+        ctx.fail("texture_decode: no wuffs decoder registered");
+        return;
+    }
+
+    std::vector<uint32_t> sizes = {512};
+    if (!ctx.quick()) {
+        sizes.push_back(2048);
+    }
+
+    for (uint32_t size : sizes) {
+        const uint32_t iterations = size >= 2048 ? 5 : 20;
+        s_compareDecoders(ctx, *wuffs, "png", s_encodePng(size, size), iterations);
+        s_compareDecoders(ctx, *wuffs, "jpeg", s_encodeJpeg(size, size), iterations);
+    }
+
+    // half PNG, half JPEG, the mix an imported glTF folder usually has
+    const uint32_t batchImages = ctx.quick() ? BATCH_IMAGES / 4 : BATCH_IMAGES;
+    std::vector<EncodedImage> batch;
+    for (uint32_t i = 0; i < batchImages; ++i) {
+        batch.push_back(i % 2 == 0 ? s_encodePng(BATCH_SIZE, i) : s_encodeJpeg(BATCH_SIZE, i));
+    }
+    s_decodeBatch(ctx, batch, false);
+    s_decodeBatch(ctx, batch, true);
+}
+
+} // namespace Rapture::Bench
@@ -0,0 +1,386 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "core/ecs/registry.h"
+#include "core/jobs/JobSystem.h"
+#include "scene/components/ChangeChannels.h"
+#include "scene/components/Components.h"
+#include "scene/systems/TransformHierarchy.h"
+#include "scene/systems/Transforms.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+constexpr float MAX_WORLD_ERROR = 1e-4f;
+
+/**
+ * @brief A forest to build, as the parent of every node in creation order, parents first
+ */
+struct TreeShape {
+    std::string name;
+    std::vector<uint32_t> parents; // UINT32_MAX for a root
+};
+
+TreeShape s_wideShape(uint32_t children)
+{
+    TreeShape shape{"wide", {UINT32_MAX}};
+    shape.parents.resize(children + 1, 0);
+    return shape;
+}
+
+TreeShape s_deepShape(uint32_t chains, uint32_t depth)
+{
+    TreeShape shape{"deep", {}};
+    for (uint32_t chain = 0; chain < chains; ++chain) {
+        shape.parents.push_back(UINT32_MAX);
+        for (uint32_t level = 1; level < depth; ++level) {
+            shape.parents.push_back(static_cast<uint32_t>(shape.parents.size()) - 1);
+        }
+    }
+    return shape;
+}
+
+TreeShape s_balancedShape(uint32_t branching, uint32_t depth)
+{
+    TreeShape shape{"balanced", {UINT32_MAX}};
+    uint32_t levelBegin = 0;
+    uint32_t levelEnd = 1;
+    for (uint32_t level = 1; level < depth; ++level) {
+        for (uint32_t parent = levelBegin; parent < levelEnd; ++parent) {
+            shape.parents.insert(shape.parents.end(), branching, parent);
+        }
+        levelBegin = levelEnd;
+        levelEnd = static_cast<uint32_t>(shape.parents.size());
+    }
+    return shape;
+}
+
+struct LocalParts {
+    glm::vec3 translation;
+    glm::quat rotation;
+    glm::vec3 scale;
+};
+
+/**
+ * @brief Small offsets and turns so deep chains stay finite and the error check stays meaningful
+ */
+LocalParts s_local(uint32_t node, uint32_t variant)
+{
+    const float t = static_cast<float>((node * 7u + variant * 13u) % 31u) / 31.0f;
+    return {glm::vec3(t - 0.5f, 0.25f, 0.1f * t), glm::quat(glm::vec3(0.02f * t, 0.03f, -0.01f * t)), glm::vec3(1.0f)};
+}
+
+void s_assign(TransformComponent &component, const LocalParts &local)
+{
+    component.translation = local.translation;
+    component.rotation = local.rotation;
+    component.scale = local.scale;
+}
+
+/**
+ * @brief The same forest twice: once behind a TransformHierarchy, once walked recursively
+ *
+ * The recursive side is how Node3D propagated world transforms before the hierarchy table: every node
+ * visited through its children list, composed with glm 4x4 matrices and written through its own write
+ * scope.
+ */
+struct TreeFixture {
+    ecs::Registry registry{CHANNEL_COUNT};
+    TransformHierarchy hierarchy{registry};
+    std::vector<ecs::Entity> entities;
+
+    ecs::Registry referenceRegistry{CHANNEL_COUNT};
+    std::vector<ecs::Entity> referenceEntities;
+    std::vector<std::vector<uint32_t>> children;
+    std::vector<uint32_t> roots;
+    std::vector<uint32_t> parents;
+    std::vector<glm::mat4> referenceLocals; // the 4x4 local matrices TransformComponent used to hold
+
+    explicit TreeFixture(const TreeShape &shape) : parents(shape.parents)
+    {
+        const uint32_t count = static_cast<uint32_t>(parents.size());
+        children.resize(count);
+        for (uint32_t node = 0; node < count; ++node) {
+            const LocalParts local = s_local(node, 0);
+
+            ecs::Entity entity = registry.create();
+            s_assign(registry.add<TransformComponent>(entity), local);
+            entities.push_back(entity);
+
+            ecs::Entity reference = referenceRegistry.create();
+            s_assign(referenceRegistry.add<TransformComponent>(reference), local);
+            referenceEntities.push_back(reference);
+            referenceLocals.push_back(transform::compose(local.translation, local.rotation, local.scale));
+
+            if (parents[node] == UINT32_MAX) {
+                roots.push_back(node);
+            } else {
+                children[parents[node]].push_back(node);
+                hierarchy.setParent(entity, entities[parents[node]]);
+            }
+        }
+        hierarchy.flush();
+        for (uint32_t root : roots) {
+            propagateRecursive(root, glm::mat4(1.0f));
+        }
+    }
+
+    void setLocal(uint32_t node, const LocalParts &local)
+    {
+        hierarchy.setLocal(entities[node], local.translation, local.rotation, local.scale);
+        s_assign(referenceRegistry.getPool<TransformComponent>()->get(referenceEntities[node]), local);
+        referenceLocals[node] = transform::compose(local.translation, local.rotation, local.scale);
+    }
+
+    void propagateRecursive(uint32_t node, const glm::mat4 &parentWorld)
+    {
+        glm::mat4 world;
+        {
+            auto component = referenceRegistry.write<TransformComponent>(referenceEntities[node]);
+            world = parentWorld * referenceLocals[node];
+            component->world = transform::toAffine(world);
+        }
+        for (uint32_t child : children[node]) {
+            propagateRecursive(child, world);
+        }
+    }
+
+    glm::mat4 referenceParentWorld(uint32_t node) const
+    {
+        if (parents[node] == UINT32_MAX) {
+            return glm::mat4(1.0f);
+        }
+        return referenceRegistry.read<TransformComponent>(referenceEntities[parents[node]]).worldMatrix();
+    }
+
+    float maxError() const
+    {
+        float error = 0.0f;
+        for (size_t node = 0; node < entities.size(); ++node) {
+            const Affine3x4 &a = registry.read<TransformComponent>(entities[node]).world;
+            const Affine3x4 &b = referenceRegistry.read<TransformComponent>(referenceEntities[node]).world;
+            for (int row = 0; row < 3; ++row) {
+                for (int column = 0; column < 4; ++column) {
+                    error = std::max(error, std::abs(a.rows[row][column] - b.rows[row][column]));
+                }
+            }
+        }
+        return error;
+    }
+};
+
+void s_throughput(CaseResult &result, uint32_t rows)
+{
+    result.counter("rows_updated", rows);
+    if (result.medianMs > 0.0) {
+        result.counter("rows_per_s", rows / (result.medianMs / 1000.0));
+    }
+}
+
+/**
+ * @brief Moves every root each iteration, so the whole forest is recomputed
+ */
+void s_benchFullUpdate(Context &ctx, const TreeShape &shape)
+{
+    TreeFixture fixture(shape);
+    const uint32_t count = static_cast<uint32_t>(shape.parents.size());
+    uint32_t variant = 0;
+
+    auto moveRoots = [&] {
+        variant++;
+        for (uint32_t root : fixture.roots) {
+            fixture.setLocal(root, s_local(root, variant));
+        }
+    };
+
+    CaseResult &recursive = ctx.run("recursive_" + shape.name, 10, [&] {
+        moveRoots();
+        for (uint32_t root : fixture.roots) {
+            fixture.propagateRecursive(root, glm::mat4(1.0f));
+        }
+    });
+    s_throughput(recursive, count);
+
+    const uint32_t parallelThreshold = fixture.hierarchy.getParallelThreshold();
+    fixture.hierarchy.setParallelThreshold(UINT32_MAX);
+    CaseResult &serial = ctx.run("hierarchy_serial_" + shape.name, 10, [&] {
+        moveRoots();
+        fixture.hierarchy.flush();
+    });
+    s_throughput(serial, fixture.hierarchy.getLastFlushStats().rowsUpdated);
+    serial.counter("levels", fixture.hierarchy.getLastFlushStats().levels)
+        .counter("ranges", fixture.hierarchy.getLastFlushStats().ranges);
+
+    fixture.hierarchy.setParallelThreshold(parallelThreshold);
+    CaseResult &parallel = ctx.run("hierarchy_parallel_" + shape.name, 10, [&] {
+        moveRoots();
+        fixture.hierarchy.flush();
+    });
+    s_throughput(parallel, fixture.hierarchy.getLastFlushStats().rowsUpdated);
+    parallel.counter("jobs", fixture.hierarchy.getLastFlushStats().parallelJobs);
+
+    // both sides saw the same final locals, the reference only needs to catch up on the last ones
+    for (uint32_t root : fixture.roots) {
+        fixture.propagateRecursive(root, glm::mat4(1.0f));
+    }
+    const float error = fixture.maxError();
+    parallel.counter("max_error_vs_recursive", error);
+    if (!(error <= MAX_WORLD_ERROR)) {
+        ctx.fail("hierarchy_" + shape.name + ": world transforms differ from the recursive walk by " + std::to_string(error));
+    }
+}
+
+/**
+ * @brief Moves one node at the bottom of the forest, the common case of a single object being edited
+ */
+void s_benchLeafUpdate(Context &ctx, const TreeShape &shape)
+{
+    TreeFixture fixture(shape);
+    const uint32_t leaf = static_cast<uint32_t>(shape.parents.size()) - 1;
+    uint32_t variant = 0;
+
+    CaseResult &recursive = ctx.run("recursive_leaf_" + shape.name, 50, [&] {
+        fixture.setLocal(leaf, s_local(leaf, ++variant));
+        fixture.propagateRecursive(leaf, fixture.referenceParentWorld(leaf));
+    });
+    recursive.counter("rows_updated", 1);
+
+    CaseResult &hierarchy = ctx.run("hierarchy_leaf_" + shape.name, 50, [&] {
+        fixture.setLocal(leaf, s_local(leaf, ++variant));
+        fixture.hierarchy.flush();
+    });
+    hierarchy.counter("rows_updated", fixture.hierarchy.getLastFlushStats().rowsUpdated);
+
+    fixture.propagateRecursive(leaf, fixture.referenceParentWorld(leaf));
+    const float error = fixture.maxError();
+    if (!(error <= MAX_WORLD_ERROR)) {
+        ctx.fail("hierarchy_leaf_" + shape.name + ": world transforms differ from the recursive walk by " + std::to_string(error));
+    }
+}
+
+/**
+ * @brief Places every body of a physics step, each a root carrying one child, one call per body or as one batch
+ */
+void s_benchSimulatedPlacements(Context &ctx, uint32_t bodies)
+{
+    const TreeShape shape = s_deepShape(bodies, 2);
+    TreeFixture perBody(shape);
+    TreeFixture batched(shape);
+    std::vector<WorldPlacement> placements(bodies);
+    uint32_t variant = 0;
+
+    auto place = [&](TreeFixture &fixture) {
+        for (uint32_t body = 0; body < bodies; ++body) {
+            const LocalParts local = s_local(body, variant);
+            placements[body] = {fixture.entities[body * 2],
+                                transform::composeAffine(local.translation, local.rotation, local.scale)};
+        }
+    };
+
+    const std::string suffix = "/" + std::to_string(bodies);
+    const double perBodyMs = ctx.run("simulated_per_body" + suffix, 20, [&] {
+        place(perBody);
+        for (const WorldPlacement &placement : placements) {
+            perBody.hierarchy.setWorld(placement.entity, transform::toMat4(placement.world));
+        }
+        perBody.hierarchy.flush();
+    }).medianMs;
+
+    CaseResult &batch = ctx.run("simulated_batched" + suffix, 20, [&] {
+        place(batched);
+        batched.hierarchy.setWorlds(placements);
+        batched.hierarchy.flush();
+    });
+    s_throughput(batch, batched.hierarchy.getLastFlushStats().rowsUpdated + bodies);
+    if (batch.medianMs > 0.0) {
+        batch.counter("speedup_vs_per_body", perBodyMs / batch.medianMs);
+    }
+
+    float error = 0.0f;
+    for (size_t node = 0; node < perBody.entities.size(); ++node) {
+        const Affine3x4 &a = perBody.registry.read<TransformComponent>(perBody.entities[node]).world;
+        const Affine3x4 &b = batched.registry.read<TransformComponent>(batched.entities[node]).world;
+        for (int row = 0; row < 3; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                error = std::max(error, std::abs(a.rows[row][column] - b.rows[row][column]));
+            }
+        }
+    }
+    if (!(error <= MAX_WORLD_ERROR)) {
+        ctx.fail("simulated_batched: world transforms differ from placing one body at a time by " + std::to_string(error));
+    }
+}
+
+/**
+ * @brief Removes the transform of every root, the rows below have to stay where they were
+ *
+ * One set of chains is flushed straight after, the other is read through world() first, which meets
+ * the orphaned rows before the flush rebuilds the order.
+ */
+void s_checkOrphanedRows(Context &ctx, uint32_t chains)
+{
+    const TreeShape shape = s_deepShape(chains, 3);
+
+    for (const bool readFirst : {false, true}) {
+        TreeFixture fixture(shape);
+        std::vector<Affine3x4> before;
+        for (ecs::Entity entity : fixture.entities) {
+            before.push_back(fixture.registry.read<TransformComponent>(entity).world);
+        }
+
+        for (uint32_t root : fixture.roots) {
+            fixture.registry.remove<TransformComponent>(fixture.entities[root]);
+        }
+        if (readFirst) {
+            for (uint32_t node = 0; node < fixture.entities.size(); ++node) {
+                if (fixture.parents[node] != UINT32_MAX) {
+                    fixture.hierarchy.world(fixture.entities[node]);
+                }
+            }
+        }
+        fixture.hierarchy.flush();
+
+        float error = 0.0f;
+        for (uint32_t node = 0; node < fixture.entities.size(); ++node) {
+            if (fixture.parents[node] == UINT32_MAX) {
+                continue;
+            }
+            const Affine3x4 &after = fixture.registry.read<TransformComponent>(fixture.entities[node]).world;
+            for (int row = 0; row < 3; ++row) {
+                for (int column = 0; column < 4; ++column) {
+                    error = std::max(error, std::abs(after.rows[row][column] - before[node].rows[row][column]));
+                }
+            }
+        }
+        if (!(error <= MAX_WORLD_ERROR)) {
+            ctx.fail(std::string("orphaned_rows") + (readFirst ? "_read_first" : "") +
+                     ": rows moved when their parent lost its transform, by " + std::to_string(error));
+        }
+    }
+}
+
+} // namespace
+
+void runTransformHierarchySuite(Context &ctx)
+{
+    const bool quick = ctx.quick();
+    std::vector<TreeShape> shapes;
+    shapes.push_back(s_wideShape(quick ? 5000 : 50000));
+    shapes.push_back(s_deepShape(quick ? 8 : 64, quick ? 128 : 512));
+    shapes.push_back(s_balancedShape(8, quick ? 5 : 6));
+
+    for (const TreeShape &shape : shapes) {
+        s_benchFullUpdate(ctx, shape);
+        s_benchLeafUpdate(ctx, shape);
+    }
+
+    s_benchSimulatedPlacements(ctx, quick ? 2000 : 10000);
+    s_checkOrphanedRows(ctx, quick ? 100 : 1000);
+}
+
+} // namespace Rapture::Bench
@@ -0,0 +1,220 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "scene/systems/BoundingBox.h"
+#include "scene/systems/TransformKernels.h"
+#include "scene/systems/Transforms.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace Rapture::Bench {
+
+namespace {
+
+// Kernels reassociate and may fuse multiply-adds, so they are held to a tolerance rather than to glm's bits
+constexpr float MAX_ERROR = 1e-4f;
+
+/**
+ * @brief Transforms spread the way a scene's are: anywhere within a few hundred units, any rotation,
+ * scales around one
+ */
+struct TransformSet {
+    std::vector<glm::vec3> translations;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::vec3> boundsMin;
+    std::vector<glm::vec3> boundsMax;
+
+    explicit TransformSet(size_t count)
+    {
+        uint32_t state = 0x9E3779B9u;
+        auto next = [&state]() {
+            state = state * 1664525u + 1013904223u;
+            return static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+        };
+
+        for (size_t i = 0; i < count; ++i) {
+            translations.emplace_back(next() * 400.0f - 200.0f, next() * 50.0f, next() * 400.0f - 200.0f);
+            rotations.push_back(glm::normalize(glm::quat(next() * 2.0f - 1.0f, next() * 2.0f - 1.0f, next() * 2.0f - 1.0f,
+                                                         next() * 2.0f - 1.0f)));
+            scales.emplace_back(0.5f + next() * 1.5f, 0.5f + next() * 1.5f, 0.5f + next() * 1.5f);
+
+            const glm::vec3 min(next() * -2.0f, next() * -2.0f, next() * -2.0f);
+            boundsMin.push_back(min);
+            boundsMax.push_back(min + glm::vec3(0.1f + next() * 4.0f, 0.1f + next() * 4.0f, 0.1f + next() * 4.0f));
+        }
+    }
+};
+
+float s_maxError(const Affine3x4 &a, const Affine3x4 &b)
+{
+    float error = 0.0f;
+    for (int row = 0; row < 3; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            error = std::max(error, std::abs(a.rows[row][column] - b.rows[row][column]));
+        }
+    }
+    return error;
+}
+
+float s_maxError(const glm::vec3 &a, const glm::vec3 &b)
+{
+    return std::max({std::abs(a.x - b.x), std::abs(a.y - b.y), std::abs(a.z - b.z)});
+}
+
+void s_throughput(CaseResult &result, size_t count)
+{
+    result.counter("transforms", static_cast<double>(count));
+    if (result.medianMs > 0.0) {
+        result.counter("transforms_per_s", static_cast<double>(count) / (result.medianMs / 1000.0));
+    }
+}
+
+/**
+ * @brief Fails the run if a kernel drifted from the glm result, relative to the size of the values
+ */
+void s_check(Context &ctx, const std::string &name, float error, float magnitude)
+{
+    const float relative = error / std::max(1.0f, magnitude);
+    if (!(relative <= MAX_ERROR)) {
+        ctx.fail(name + ": batch kernel differs from glm by " + std::to_string(relative));
+    }
+}
+
+} // namespace
+
+void runTransformMathSuite(Context &ctx)
+{
+    const size_t count = ctx.quick() ? 10000 : 100000;
+    const uint32_t iterations = 20;
+    const std::string suffix = "/" + std::to_string(count);
+
+    const TransformSet set(count);
+
+    // the glm forms of the same transforms, which is what the engine held before the affine layout
+    std::vector<glm::mat4> matrices(count);
+    std::vector<Affine3x4> affines(count);
+    for (size_t i = 0; i < count; ++i) {
+        matrices[i] = transform::compose(set.translations[i], set.rotations[i], set.scales[i]);
+        affines[i] = transform::toAffine(matrices[i]);
+    }
+
+    // compose
+    std::vector<glm::mat4> glmOut(count);
+    std::vector<Affine3x4> batchOut(count);
+    s_throughput(ctx.run("compose_glm" + suffix, iterations,
+                         [&] {
+                             for (size_t i = 0; i < count; ++i) {
+                                 glmOut[i] = transform::compose(set.translations[i], set.rotations[i], set.scales[i]);
+                             }
+                             doNotOptimize(glmOut.data());
+                         }),
+                 count);
+    CaseResult &compose = ctx.run("compose_batch" + suffix, iterations, [&] {
+        transform::composeBatch(set.translations.data(), set.rotations.data(), set.scales.data(), batchOut.data(), count);
+        doNotOptimize(batchOut.data());
+    });
+    s_throughput(compose, count);
+    float error = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        error = std::max(error, s_maxError(batchOut[i], affines[i]));
+    }
+    compose.counter("max_error_vs_glm", error);
+    s_check(ctx, "compose_batch", error, 200.0f);
+
+    // parent * child, each transform parented to its neighbour
+    s_throughput(ctx.run("multiply_glm" + suffix, iterations,
+                         [&] {
+                             for (size_t i = 0; i < count; ++i) {
+                                 glmOut[i] = matrices[i] * matrices[(i + 1) % count];
+                             }
+                             doNotOptimize(glmOut.data());
+                         }),
+                 count);
+    std::vector<Affine3x4> children(affines.begin() + 1, affines.end());
+    children.push_back(affines.front());
+    CaseResult &multiply = ctx.run("multiply_batch" + suffix, iterations, [&] {
+        transform::multiplyBatch(affines.data(), children.data(), batchOut.data(), count);
+        doNotOptimize(batchOut.data());
+    });
+    s_throughput(multiply, count);
+    error = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        error = std::max(error, s_maxError(batchOut[i], transform::toAffine(matrices[i] * matrices[(i + 1) % count])));
+    }
+    multiply.counter("max_error_vs_glm", error);
+    s_check(ctx, "multiply_batch", error, 800.0f);
+
+    // inverse, glm only has the general 4x4 one
+    s_throughput(ctx.run("inverse_glm" + suffix, iterations,
+                         [&] {
+                             for (size_t i = 0; i < count; ++i) {
+                                 glmOut[i] = glm::inverse(matrices[i]);
+                             }
+                             doNotOptimize(glmOut.data());
+                         }),
+                 count);
+    CaseResult &inverse = ctx.run("inverse_batch" + suffix, iterations, [&] {
+        transform::inverseBatch(affines.data(), batchOut.data(), count);
+        doNotOptimize(batchOut.data());
+    });
+    s_throughput(inverse, count);
+    error = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        error = std::max(error, s_maxError(batchOut[i], transform::toAffine(glm::inverse(matrices[i]))));
+    }
+    inverse.counter("max_error_vs_glm", error);
+    s_check(ctx, "inverse_batch", error, 400.0f);
+
+    // world bounds, against the eight corner transform BoundingBox has always done
+    std::vector<BoundingBox> glmBounds(count);
+    s_throughput(ctx.run("bounds_glm" + suffix, iterations,
+                         [&] {
+                             for (size_t i = 0; i < count; ++i) {
+                                 glmBounds[i] = BoundingBox(set.boundsMin[i], set.boundsMax[i]).transform(matrices[i]);
+                             }
+                             doNotOptimize(glmBounds.data());
+                         }),
+                 count);
+    std::vector<glm::vec3> outMin(count), outMax(count);
+    CaseResult &bounds = ctx.run("bounds_batch" + suffix, iterations, [&] {
+        transform::transformBoundsBatch(affines.data(), set.boundsMin.data(), set.boundsMax.data(), outMin.data(),
+                                        outMax.data(), count);
+        doNotOptimize(outMin.data());
+        doNotOptimize(outMax.data());
+    });
+    s_throughput(bounds, count);
+    error = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        error = std::max({error, s_maxError(outMin[i], glmBounds[i].getMin()), s_maxError(outMax[i], glmBounds[i].getMax())});
+    }
+    bounds.counter("max_error_vs_glm", error);
+    s_check(ctx, "bounds_batch", error, 220.0f);
+
+    // decompose, compared by composing the parts again since q and -q are the same rotation
+    std::vector<glm::vec3> translations(count), scales(count);
+    std::vector<glm::quat> rotations(count);
+    s_throughput(ctx.run("decompose_glm" + suffix, iterations,
+                         [&] {
+                             for (size_t i = 0; i < count; ++i) {
+                                 transform::decompose(matrices[i], translations[i], rotations[i], scales[i]);
+                             }
+                             doNotOptimize(rotations.data());
+                         }),
+                 count);
+    CaseResult &decompose = ctx.run("decompose_batch" + suffix, iterations, [&] {
+        transform::decomposeBatch(affines.data(), translations.data(), rotations.data(), scales.data(), count);
+        doNotOptimize(rotations.data());
+    });
+    s_throughput(decompose, count);
+    error = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        error = std::max(error, s_maxError(transform::composeAffine(translations[i], rotations[i], scales[i]), affines[i]));
+    }
+    decompose.counter("max_error_vs_glm", error);
+    s_check(ctx, "decompose_batch", error, 200.0f);
+}
+
+} // namespace Rapture::Bench
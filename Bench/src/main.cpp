@@ -0,0 +1,150 @@
+#include "Bench.h"
+#include "Suites.h"
+
+#include "core/jobs/JobSystem.h"
+#include "core/serialization/SerialDocument.h"
+#include "core/utils/EnginePaths.h"
+#include "core/utils/Log.h"
+
+#include <fstream>
+#include <string>
+#include <string_view>
+
+using namespace Rapture;
+
+struct SuiteEntry {
+    const char *name;
+    void (*run)(Bench::Context &);
+};
+
+// Every suite the runner knows, in the order they run
+static const SuiteEntry s_suites[] = {
+    {"shader_reflection", Bench::runShaderReflectionSuite},
+    {"material_graph", Bench::runMaterialGraphSuite},
+    {"texture_decode", Bench::runTextureDecodeSuite},
+    {"transform_hierarchy", Bench::runTransformHierarchySuite},
+    {"transform_math", Bench::runTransformMathSuite},
+    {"frustum_cull", Bench::runFrustumCullSuite},
+    {"scene_bvh", Bench::runSceneBVHSuite},
+    {"draw_cull", Bench::runDrawCullSuite},
+    {"render_data_slots", Bench::runRenderDataSlotsSuite},
+    {"render_data_pack", Bench::runRenderDataPackSuite},
+    {"physics_jobs", Bench::runPhysicsJobsSuite},
+    {"physics_interpolation", Bench::runPhysicsInterpolationSuite},
+    {"physics_characters", Bench::runPhysicsCharactersSuite},
+    {"physics_shapes", Bench::runPhysicsShapesSuite},
+    {"physics_queries", Bench::runPhysicsQueriesSuite},
+    {"scene_snapshot", Bench::runSceneSnapshotSuite},
+    {"serial_format", Bench::runSerialFormatSuite},
+    {"serial_stream", Bench::runSerialStreamSuite},
+    {"scene_load", Bench::runSceneLoadSuite},
+};
+
+static void s_printUsage()
+{
+    RP_INFO("usage: RaptureBench [--out results.json] [--filter suite/case] [--quick]");
+}
+
+/**
+ * @brief Whether a suite can match the filter at all, so the others skip their setup
+ *
+ * The filter is matched against "suite/case"; without a slash any suite may hold a matching case.
+ */
+static bool s_suiteSelected(std::string_view suite, std::string_view filter)
+{
+    size_t slash = filter.find('/');
+    if (slash == std::string_view::npos) {
+        return true;
+    }
+    return suite.find(filter.substr(0, slash)) != std::string_view::npos;
+}
+
+/**
+ * @brief Writes every result as one JSON document, keyed so two runs can be diffed case by case
+ */
+static bool s_writeResults(const std::string &path, const Bench::Context &ctx)
+{
+    SerialDocument doc;
+    WriteNode root = doc.root();
+    root.set("quick", ctx.quick());
+
+    WriteNode cases = root.addArray("cases");
+    for (const auto &result : ctx.results()) {
+        WriteNode node = cases.appendObject();
+        node.set("suite", std::string_view(result.suite));
+        node.set("name", std::string_view(result.name));
+        node.set("iterations", static_cast<uint64_t>(result.iterations));
+        node.set("min_ms", result.minMs);
+        node.set("median_ms", result.medianMs);
+        node.set("mean_ms", result.meanMs);
+        node.set("max_ms", result.maxMs);
+
+        WriteNode counters = node.addObject("counters");
+        for (const auto &[key, value] : result.counters) {
+            counters.set(key, value);
+        }
+    }
+
+    WriteNode failures = root.addArray("failures");
+    for (const auto &failure : ctx.failures()) {
+        failures.append(std::string_view(failure));
+    }
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        RP_ERROR("Could not open '{}' for writing", path);
+        return false;
+    }
+    file << doc.toText(true);
+    return static_cast<bool>(file);
+}
+
+int main(int argc, char **argv)
+{
+    Log::Init();
+    EnginePaths::init();
+
+    std::string outPath = "bench_results.json";
+    std::string filter;
+    bool quick = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--quick") {
+            quick = true;
+        } else {
+            s_printUsage();
+            return 2;
+        }
+    }
+
+    // suites that split work into jobs wait on it from here, like the engine's main thread does
+    JobSystem::init();
+
+    Bench::Context ctx(quick, filter);
+    for (const auto &suite : s_suites) {
+        if (!s_suiteSelected(suite.name, filter)) {
+            continue;
+        }
+        ctx.beginSuite(suite.name);
+        RP_INFO("Running suite {}", suite.name);
+        suite.run(ctx);
+    }
+
+    JobSystem::shutdown();
+
+    if (!s_writeResults(outPath, ctx)) {
+        return 1;
+    }
+    RP_INFO("Wrote {} results to {}", ctx.results().size(), outPath);
+
+    if (!ctx.failures().empty()) {
+        RP_ERROR("{} check(s) failed", ctx.failures().size());
+        return 1;
+    }
+    return 0;
+}
@@ -296,6 +296,14 @@ void ViewportPanel::buildRenderMenu()
     occlusionToggle->as<ViewportContextMenuTID>().value = true;
     items.push_back(std::move(occlusionToggle));
 
+    auto cullingToggle = ViewportContextMenuTID::create("GPU Culling", [this](bool on) {
+        if (m_viewport != nullptr) {
+            m_viewport->renderSettings().setFlag(Rapture::RENDER_USE_GPU_CULLING, on);
+        }
+    });
+    cullingToggle->as<ViewportContextMenuTID>().value = false;
+    items.push_back(std::move(cullingToggle));
+
     m_renderMenu->setItems(std::move(items));
 }
 
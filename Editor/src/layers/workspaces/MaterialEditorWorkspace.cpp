@@ -8,7 +8,6 @@
 #include <assets/asset_manager/AssetManager.h>
 #include <scene/components/Components.h>
 #include <components/extensions/ui_list_layout.h>
-#include <scene/systems/Transforms.h>
 #include <components/ui_scope.h>
 #include <assets/materials/MaterialInstance.h>
 #include <gpu/render_targets/SceneRenderTarget.h>
@@ -91,14 +90,12 @@ void MaterialEditorWorkspace::setupPreviewScene()
 
     Rapture::ecs::EntityAccessor camera = m_previewScene->createEntity("Preview Camera");
     auto &cameraTransform = camera.add<Rapture::TransformComponent>();
-    cameraTransform.local = Rapture::transform::compose(glm::vec3(0.0f, 0.0f, 4.0f), glm::vec3(0.0f), glm::vec3(1.0f));
-    cameraTransform.world = cameraTransform.local;
+    cameraTransform.translation = glm::vec3(0.0f, 0.0f, 4.0f);
     camera.add<Rapture::CameraComponent>(60.0f, 16.0f / 9.0f, 0.1f, 100.0f);
 
     Rapture::ecs::EntityAccessor light = m_previewScene->createEntity("Preview Light");
     auto &lightTransform = light.add<Rapture::TransformComponent>();
-    lightTransform.local = Rapture::transform::compose(glm::vec3(0.0f), glm::vec3(-0.6f, 0.5f, 0.0f), glm::vec3(1.0f));
-    lightTransform.world = lightTransform.local;
+    lightTransform.rotation = glm::quat(glm::vec3(-0.6f, 0.5f, 0.0f));
     light.add<Rapture::DirectionalLightComponent>(glm::vec3(1.0f), 3.0f);
 
     Rapture::Environment *environment = m_previewScene->environment();
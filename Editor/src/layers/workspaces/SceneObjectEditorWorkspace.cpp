@@ -9,7 +9,6 @@
 #include <assets/asset_manager/AssetManager.h>
 #include <scene/components/Components.h>
 #include <components/extensions/ui_list_layout.h>
-#include <scene/systems/Transforms.h>
 #include <components/ui_scope.h>
 #include <core/ecs/entity_accessor.h>
 #include <core/utils/Log.h>
@@ -113,8 +112,7 @@ void SceneObjectEditorWorkspace::setupScene()
 
     Rapture::ecs::EntityAccessor camera = m_scene->createEntity("Editor Camera");
     auto &cameraTransform = camera.add<Rapture::TransformComponent>();
-    cameraTransform.local = Rapture::transform::compose(glm::vec3(0.0f, 1.5f, 5.0f), glm::vec3(0.0f), glm::vec3(1.0f));
-    cameraTransform.world = cameraTransform.local;
+    cameraTransform.translation = glm::vec3(0.0f, 1.5f, 5.0f);
     camera.add<Rapture::CameraComponent>(60.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
 
     auto extent = app.getMainWindow().getSwapChain()->getExtent();
@@ -4,7 +4,9 @@
 
 // Defined for the Hi-Z pyramid, where a level must bound the nearest surface of everything below it.
 // The colour chain leaves it undefined and averages, which is the ordinary box mip.
-#ifdef DOWNSAMPLE_REDUCTION_MIN
+// DOWNSAMPLE_REDUCTION_MAX bounds the farthest surface instead, which is what occlusion culling tests
+// a box against with the engine's forward depth.
+#if defined(DOWNSAMPLE_REDUCTION_MIN) || defined(DOWNSAMPLE_REDUCTION_MAX)
     #define IMAGE_FORMAT r32f
 #else
     #define IMAGE_FORMAT rgba16f
@@ -37,6 +39,8 @@ void main() {
 
 #ifdef DOWNSAMPLE_REDUCTION_MIN
     vec4 result = vec4(1.0 / 0.0);
+#elif defined(DOWNSAMPLE_REDUCTION_MAX)
+    vec4 result = vec4(-1.0 / 0.0);
 #else
     vec4 result = vec4(0.0);
     float weight = 0.0;
@@ -48,6 +52,8 @@ void main() {
             vec4 texel = texelFetch(gTextures[nonuniformEXT(pc.sourceTextureIndex)], coord, pc.sourceMip);
 #ifdef DOWNSAMPLE_REDUCTION_MIN
             result = min(result, texel);
+#elif defined(DOWNSAMPLE_REDUCTION_MAX)
+            result = max(result, texel);
 #else
             result += texel;
             weight += 1.0;
@@ -55,7 +61,7 @@ void main() {
         }
     }
 
-#ifndef DOWNSAMPLE_REDUCTION_MIN
+#if !defined(DOWNSAMPLE_REDUCTION_MIN) && !defined(DOWNSAMPLE_REDUCTION_MAX)
     result /= weight;
 #endif
 
@@ -0,0 +1,325 @@
+#version 460
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Culls the draws of one MDIBatch and compacts the ones it keeps into an indirect buffer and a count,
+// for vkCmdDrawIndexedIndirectCount. Imported three times, one stage per variant:
+//   DRAW_CULL_STAGE_CULL     one thread per draw, writes a flag per draw and a count per group
+//   DRAW_CULL_STAGE_SCAN     a single group, turns the group counts into offsets and writes the total
+//   DRAW_CULL_STAGE_COMPACT  one thread per draw, copies each kept command to its slot
+// The kept commands keep the order they had in the batch, so the output does not depend on how the
+// GPU scheduled the groups. culling::cullDraws() in renderer/DrawCulling.cpp is the CPU reference of
+// this file and has to change with it: the arithmetic below is written out term by term and marked
+// precise so that nothing is fused or reordered and both sides round identically.
+
+#include "common/CameraCommon.glsl"
+
+#define GROUP_SIZE 256
+
+layout(local_size_x = GROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+
+struct DrawIndexedIndirectCommand {
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+struct MeshGPUData {
+    mat4 model;
+    uint materialIndex;
+    uint flags;
+    uint entityId;
+    uint boneOffset;
+};
+
+struct ObjectInfo {
+    uint meshIndex;
+    uint materialIndex;
+};
+
+struct DrawBounds {
+    vec4 min;
+    vec4 max;
+};
+
+layout(set = 2, binding = 0) readonly buffer MeshDataSSBO {
+    MeshGPUData meshes[];
+} u_meshSSBO[];
+
+layout(set = 3, binding = 0) uniform sampler2D gTextures[];
+
+layout(set = 3, binding = 1) readonly buffer SourceCommandBuffer {
+    DrawIndexedIndirectCommand commands[];
+} u_sourceCommands[];
+
+layout(set = 3, binding = 1) buffer CulledCommandBuffer {
+    DrawIndexedIndirectCommand commands[];
+} u_culledCommands[];
+
+layout(set = 3, binding = 1) readonly buffer BatchInfoBuffer {
+    ObjectInfo objects[];
+} u_batchInfo[];
+
+layout(set = 3, binding = 1) readonly buffer DrawBoundsBuffer {
+    DrawBounds bounds[];
+} u_drawBounds[];
+
+layout(set = 3, binding = 1) readonly buffer FrustumPlanesBuffer {
+    vec4 planes[];
+} u_frustumPlanes[];
+
+layout(set = 3, binding = 1) buffer DrawFlagBuffer {
+    uint flags[];
+} u_drawFlags[];
+
+layout(set = 3, binding = 1) buffer GroupCountBuffer {
+    uint counts[]; // visible draws per group, replaced by the offset of each group's first kept draw
+} u_groupCounts[];
+
+layout(set = 3, binding = 1) buffer DrawCountBuffer {
+    uint drawCount;
+} u_drawCount[];
+
+layout(push_constant) uniform PushConstants {
+    uint drawCount;
+    uint sourceCommandBufferIndex;
+    uint culledCommandBufferIndex;
+    uint batchInfoBufferIndex;
+    uint boundsBufferIndex;
+    uint meshSSBOIndex;
+    uint cameraSSBOIndex;
+    uint cameraSlotIndex;
+    uint frustumBufferIndex;
+    uint pyramidTextureIndex; // 0xFFFFFFFF skips the occlusion test
+    uint pyramidLevels;
+    uint flagBufferIndex;
+    uint groupCountBufferIndex;
+    uint drawCountBufferIndex;
+    ivec2 depthSize; // the depth buffer the pyramid was reduced from
+} pc;
+
+#ifdef DRAW_CULL_STAGE_CULL
+
+// The pixel an NDC coordinate c / w falls in: the largest t in [0, size) with t * 2w <= (c + w) * size.
+// A division is not correctly rounded on the GPU, so the quotient only seeds the search.
+uint pixelOf(float c, float w, uint size) {
+    precise float scaled = (c + w) * float(size);
+    precise float twoW = w + w;
+
+    float guess = scaled / twoW;
+    uint t = guess > 0.0 ? uint(min(guess, float(size - 1u))) : 0u;
+
+    while (t > 0u) {
+        precise float edge = float(t) * twoW;
+        if (edge <= scaled) {
+            break;
+        }
+        t--;
+    }
+    while (t + 1u < size) {
+        precise float edge = float(t + 1u) * twoW;
+        if (edge > scaled) {
+            break;
+        }
+        t++;
+    }
+    return t;
+}
+
+bool isOccluded(vec3 center, vec3 extent) {
+    mat4 viewProj = u_cameraSSBO[pc.cameraSSBOIndex].cameras[pc.cameraSlotIndex].prevViewProj;
+
+    float clipZ[8];
+    float clipW[8];
+    uvec2 minPixel = uvec2(0xFFFFFFFFu);
+    uvec2 maxPixel = uvec2(0u);
+
+    for (uint corner = 0u; corner < 8u; ++corner) {
+        precise float px = (corner & 1u) != 0u ? center.x + extent.x : center.x - extent.x;
+        precise float py = (corner & 2u) != 0u ? center.y + extent.y : center.y - extent.y;
+        precise float pz = (corner & 4u) != 0u ? center.z + extent.z : center.z - extent.z;
+
+        precise vec4 clip;
+        for (int row = 0; row < 4; ++row) {
+            clip[row] = ((viewProj[0][row] * px + viewProj[1][row] * py) + viewProj[2][row] * pz) + viewProj[3][row];
+        }
+
+        // a corner level with or behind the eye has no place on screen, the box may cover all of it
+        if (!(clip.w > 0.0)) {
+            return false;
+        }
+
+        uvec2 pixel = uvec2(pixelOf(clip.x, clip.w, uint(pc.depthSize.x)), pixelOf(clip.y, clip.w, uint(pc.depthSize.y)));
+        minPixel = min(minPixel, pixel);
+        maxPixel = max(maxPixel, pixel);
+
+        clipZ[corner] = clip.z;
+        clipW[corner] = clip.w;
+    }
+
+    // from the depth buffer's pixels down to the first level where the box covers at most 2x2 texels,
+    // an odd level's last texel also covers the one past it so the index is clamped rather than lost
+    uint level = 0u;
+    uvec2 size = uvec2(textureSize(gTextures[nonuniformEXT(pc.pyramidTextureIndex)], 0));
+    minPixel = min(minPixel >> 1u, size - 1u);
+    maxPixel = min(maxPixel >> 1u, size - 1u);
+
+    while ((maxPixel.x - minPixel.x > 1u || maxPixel.y - minPixel.y > 1u) && level + 1u < pc.pyramidLevels) {
+        level++;
+        size = uvec2(textureSize(gTextures[nonuniformEXT(pc.pyramidTextureIndex)], int(level)));
+        minPixel = min(minPixel >> 1u, size - 1u);
+        maxPixel = min(maxPixel >> 1u, size - 1u);
+    }
+
+    float farthest = -1.0 / 0.0;
+    for (uint y = minPixel.y; y <= maxPixel.y; ++y) {
+        for (uint x = minPixel.x; x <= maxPixel.x; ++x) {
+            float texel = texelFetch(gTextures[nonuniformEXT(pc.pyramidTextureIndex)], ivec2(x, y), int(level)).r;
+            farthest = max(farthest, texel);
+        }
+    }
+
+    // z / w > farthest for every corner, with w known to be positive
+    for (uint corner = 0u; corner < 8u; ++corner) {
+        precise float limit = farthest * clipW[corner];
+        if (!(clipZ[corner] > limit)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isVisible(uint draw) {
+    if (u_sourceCommands[pc.sourceCommandBufferIndex].commands[draw].instanceCount == 0u) {
+        return false;
+    }
+
+    uint meshIndex = u_batchInfo[pc.batchInfoBufferIndex].objects[draw].meshIndex;
+    mat4 model = u_meshSSBO[pc.meshSSBOIndex].meshes[meshIndex].model;
+    DrawBounds bounds = u_drawBounds[pc.boundsBufferIndex].bounds[draw];
+
+    precise vec3 localCenter = vec3((bounds.min.x + bounds.max.x) * 0.5, (bounds.min.y + bounds.max.y) * 0.5,
+                                    (bounds.min.z + bounds.max.z) * 0.5);
+    precise vec3 localExtent = vec3((bounds.max.x - bounds.min.x) * 0.5, (bounds.max.y - bounds.min.y) * 0.5,
+                                    (bounds.max.z - bounds.min.z) * 0.5);
+
+    // the box around the transformed box, as a center and a half size
+    precise vec3 center;
+    precise vec3 extent;
+    for (int row = 0; row < 3; ++row) {
+        center[row] = ((model[0][row] * localCenter.x + model[1][row] * localCenter.y) + model[2][row] * localCenter.z) +
+                      model[3][row];
+        extent[row] = (abs(model[0][row]) * localExtent.x + abs(model[1][row]) * localExtent.y) +
+                      abs(model[2][row]) * localExtent.z;
+    }
+
+    for (uint i = 0u; i < 6u; ++i) {
+        vec4 plane = u_frustumPlanes[pc.frustumBufferIndex].planes[i];
+        precise float distance = ((plane.x * center.x + plane.y * center.y) + plane.z * center.z) + plane.w;
+        precise float radius = (abs(plane.x) * extent.x + abs(plane.y) * extent.y) + abs(plane.z) * extent.z;
+        precise float reach = distance + radius;
+        if (reach < 0.0) {
+            return false;
+        }
+    }
+
+    if (pc.pyramidTextureIndex != 0xFFFFFFFFu && pc.pyramidLevels != 0u && isOccluded(center, extent)) {
+        return false;
+    }
+    return true;
+}
+
+shared uint s_visibleInGroup;
+
+void main() {
+    uint draw = gl_GlobalInvocationID.x;
+
+    if (gl_LocalInvocationIndex == 0u) {
+        s_visibleInGroup = 0u;
+    }
+    barrier();
+
+    if (draw < pc.drawCount) {
+        uint visible = isVisible(draw) ? 1u : 0u;
+        u_drawFlags[pc.flagBufferIndex].flags[draw] = visible;
+        if (visible != 0u) {
+            atomicAdd(s_visibleInGroup, 1u);
+        }
+    }
+    barrier();
+
+    if (gl_LocalInvocationIndex == 0u) {
+        u_groupCounts[pc.groupCountBufferIndex].counts[gl_WorkGroupID.x] = s_visibleInGroup;
+    }
+}
+
+#endif // DRAW_CULL_STAGE_CULL
+
+#ifdef DRAW_CULL_STAGE_SCAN
+
+shared uint s_sums[GROUP_SIZE];
+
+void main() {
+    uint lane = gl_LocalInvocationIndex;
+    uint groups = (pc.drawCount + GROUP_SIZE - 1u) / GROUP_SIZE;
+    uint perLane = (groups + GROUP_SIZE - 1u) / GROUP_SIZE;
+    uint begin = min(lane * perLane, groups);
+    uint end = min(begin + perLane, groups);
+
+    uint sum = 0u;
+    for (uint group = begin; group < end; ++group) {
+        sum += u_groupCounts[pc.groupCountBufferIndex].counts[group];
+    }
+    s_sums[lane] = sum;
+    barrier();
+
+    if (lane == 0u) {
+        uint running = 0u;
+        for (uint i = 0u; i < GROUP_SIZE; ++i) {
+            uint value = s_sums[i];
+            s_sums[i] = running;
+            running += value;
+        }
+        u_drawCount[pc.drawCountBufferIndex].drawCount = running;
+    }
+    barrier();
+
+    uint offset = s_sums[lane];
+    for (uint group = begin; group < end; ++group) {
+        uint value = u_groupCounts[pc.groupCountBufferIndex].counts[group];
+        u_groupCounts[pc.groupCountBufferIndex].counts[group] = offset;
+        offset += value;
+    }
+}
+
+#endif // DRAW_CULL_STAGE_SCAN
+
+#ifdef DRAW_CULL_STAGE_COMPACT
+
+shared uint s_prefix[GROUP_SIZE];
+
+void main() {
+    uint draw = gl_GlobalInvocationID.x;
+    uint lane = gl_LocalInvocationIndex;
+
+    uint flag = draw < pc.drawCount ? u_drawFlags[pc.flagBufferIndex].flags[draw] : 0u;
+    s_prefix[lane] = flag;
+    barrier();
+
+    // inclusive scan of the group's flags, so a kept draw knows how many kept ones come before it
+    for (uint stride = 1u; stride < GROUP_SIZE; stride <<= 1u) {
+        uint add = lane >= stride ? s_prefix[lane - stride] : 0u;
+        barrier();
+        s_prefix[lane] += add;
+        barrier();
+    }
+
+    if (flag != 0u) {
+        uint slot = u_groupCounts[pc.groupCountBufferIndex].counts[gl_WorkGroupID.x] + s_prefix[lane] - 1u;
+        u_culledCommands[pc.culledCommandBufferIndex].commands[slot] = u_sourceCommands[pc.sourceCommandBufferIndex].commands[draw];
+    }
+}
+
+#endif // DRAW_CULL_STAGE_COMPACT
@@ -9,6 +9,7 @@
 #include "core/utils/Timestep.h"
 #include "core/utils/TracyProfiler.h"
 #include "core/utils/rp_assert.h"
+#include "gpu/shaders/ShaderHotReload.h"
 #include "scene/instances/InstanceRegistry.h"
 
 #if defined(__linux__)
@@ -78,6 +79,7 @@ Application::Application(int width, int height, const char *title) : m_running(t
 
     JobSystem::init();
     InstanceRegistry::init();
+    ShaderHotReload::init(EnginePaths::shaderDirectory());
 
     m_project = Project::empty();
 
@@ -95,6 +97,7 @@ Application::~Application()
 
     m_vulkanContext->waitIdle();
 
+    ShaderHotReload::shutdown();
     TracyProfiler::shutdown();
 
     m_layerStack.clear();
@@ -196,6 +199,8 @@ void Application::run()
             pollTelemetry();
         }
 
+        // rebuilt shaders swap in here, before anything of this frame is recorded
+        ShaderHotReload::onUpdate();
         AssetManager::onUpdate();
 
         for (auto it = m_layerStack.layerBegin(); it != m_layerStack.layerEnd(); ++it) {
@@ -4,6 +4,8 @@
 #include "core/utils/Log.h"
 #include "scene/instances/InstanceRegistry.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <string_view>
@@ -43,10 +45,15 @@ struct RaptureAssetHeader {
 
 static_assert(sizeof(RaptureAssetHeader) == 64, "rasset header is a fixed 64-byte block");
 
-// FNV-1a, enough to catch a truncated or corrupted section
-static uint32_t s_checksum(std::span<const uint8_t> bytes)
+static constexpr uint32_t CHECKSUM_SEED = 2166136261u;
+
+// The pieces a payload is read in, by a streamed load and by a streamed write summing what it wrote
+static constexpr size_t RASSET_READ_PIECE_BYTES = 64 * 1024;
+
+// FNV-1a, enough to catch a truncated or corrupted section. A section read in pieces carries the hash of the
+// pieces before into the next.
+static uint32_t s_checksum(std::span<const uint8_t> bytes, uint32_t hash = CHECKSUM_SEED)
 {
-    uint32_t hash = 2166136261u;
     for (uint8_t b : bytes) {
         hash ^= b;
         hash *= 16777619u;
@@ -193,6 +200,73 @@ bool AssetCodec::writeRaptureAsset(const std::filesystem::path &path, AssetHandl
     return true;
 }
 
+bool AssetCodec::writeRaptureAsset(const std::filesystem::path &path, AssetHandle uuid, const AssetMetadata &metadata,
+                                   const std::function<bool(int fd)> &writePayload)
+{
+    std::vector<uint8_t> metadataBytes = s_serializeMetadata(metadata);
+
+    RaptureAssetHeader header;
+    header.uuid = uuid;
+    header.assetTypeCode = AssetTypeToCode(metadata.assetType);
+    header.metadataSize = metadataBytes.size();
+    header.metadataChecksum = s_checksum(metadataBytes);
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    // written beside the target and moved over it once complete, so a failed write leaves the old asset
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+
+    std::FILE *file = std::fopen(tempPath.string().c_str(), "w+b");
+    if (file == nullptr) {
+        RP_CORE_ERROR("Failed to open '{0}' for writing", tempPath.string());
+        return false;
+    }
+
+    // the header goes in first as a placeholder, the payload's size and checksum are only known once it is written
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(metadataBytes.data(), 1, metadataBytes.size(), file) == metadataBytes.size() && std::fflush(file) == 0;
+
+#if defined(_WIN32)
+    ok = ok && writePayload(_fileno(file));
+#else
+    ok = ok && writePayload(fileno(file));
+#endif // _WIN32
+
+    // read back in pieces for the checksum, so the payload is never held whole
+    const long payloadStart = static_cast<long>(sizeof(header) + metadataBytes.size());
+    uint32_t checksum = CHECKSUM_SEED;
+    uint64_t payloadSize = 0;
+    if (ok && std::fseek(file, payloadStart, SEEK_SET) == 0) {
+        std::vector<uint8_t> piece(RASSET_READ_PIECE_BYTES);
+        size_t read = 0;
+        while ((read = std::fread(piece.data(), 1, piece.size(), file)) > 0) {
+            checksum = s_checksum(std::span<const uint8_t>(piece.data(), read), checksum);
+            payloadSize += read;
+        }
+        ok = std::ferror(file) == 0;
+    } else {
+        ok = false;
+    }
+
+    header.payloadSize = payloadSize;
+    header.payloadChecksum = checksum;
+    ok = ok && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = std::fclose(file) == 0 && ok;
+
+    if (ok) {
+        std::filesystem::rename(tempPath, path, ec);
+        ok = !ec;
+    }
+
+    if (!ok) {
+        RP_CORE_ERROR("Failed to write rasset '{0}'", path.string());
+        std::filesystem::remove(tempPath, ec);
+    }
+    return ok;
+}
+
 static bool s_readHeader(std::ifstream &file, const std::filesystem::path &path, RaptureAssetHeader &header)
 {
     file.read(reinterpret_cast<char *>(&header), sizeof(header));
@@ -272,4 +346,46 @@ std::vector<uint8_t> AssetCodec::readRaptureAssetPayload(const std::filesystem::
     return payload;
 }
 
+bool AssetCodec::readRaptureAssetPayload(const std::filesystem::path &path,
+                                         const std::function<bool(std::span<const uint8_t> piece)> &readPiece)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        RP_CORE_ERROR("Failed to open rasset '{0}'", path.string());
+        return false;
+    }
+
+    RaptureAssetHeader header;
+    if (!s_readHeader(file, path, header)) {
+        return false;
+    }
+
+    file.seekg(static_cast<std::streamoff>(sizeof(RaptureAssetHeader) + header.metadataSize));
+
+    std::vector<uint8_t> piece(RASSET_READ_PIECE_BYTES);
+    uint32_t checksum = CHECKSUM_SEED;
+    uint64_t remaining = header.payloadSize;
+    while (remaining > 0) {
+        const size_t size = static_cast<size_t>(std::min<uint64_t>(remaining, piece.size()));
+        file.read(reinterpret_cast<char *>(piece.data()), static_cast<std::streamsize>(size));
+        if (!file) {
+            RP_CORE_ERROR("Rasset '{0}' payload is truncated", path.string());
+            return false;
+        }
+
+        const std::span<const uint8_t> bytes(piece.data(), size);
+        checksum = s_checksum(bytes, checksum);
+        if (!readPiece(bytes)) {
+            return false;
+        }
+        remaining -= size;
+    }
+
+    if (checksum != header.payloadChecksum) {
+        RP_CORE_ERROR("Rasset '{0}' payload checksum mismatch", path.string());
+        return false;
+    }
+    return true;
+}
+
 } // namespace Rapture
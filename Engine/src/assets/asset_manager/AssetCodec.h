@@ -5,6 +5,7 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <span>
@@ -41,6 +42,20 @@ class AssetCodec {
     static bool writeRaptureAsset(const std::filesystem::path &path, AssetHandle uuid, const AssetMetadata &metadata,
                                   std::span<const uint8_t> payload);
 
+    /**
+     * @brief Writes a self-contained `.rasset` whose payload goes straight into the file instead of through memory
+     *
+     * The file is written to `path` with `.tmp` appended and only replaces `path` once complete, a failed
+     * write keeps whatever asset was there.
+     * @param path The destination file
+     * @param uuid The asset handle stored in the header, the asset's identity
+     * @param metadata The metadata record encoded into the file
+     * @param writePayload Writes the payload to the descriptor it is handed, returning false on failure
+     * @return True on success, false on an I/O failure
+     */
+    static bool writeRaptureAsset(const std::filesystem::path &path, AssetHandle uuid, const AssetMetadata &metadata,
+                                  const std::function<bool(int fd)> &writePayload);
+
     /**
      * @brief Reads the header and metadata of a `.rasset` without touching the payload, for the scan
      * @param path The file to read
@@ -54,6 +69,18 @@ class AssetCodec {
      * @return The payload bytes, or empty on failure
      */
     static std::vector<uint8_t> readRaptureAssetPayload(const std::filesystem::path &path);
+
+    /**
+     * @brief Reads the payload section of a `.rasset` in pieces, handing each on as it is read
+     *
+     * The checksum is only known once the last piece is in, so whatever was built from the pieces has to be
+     * dropped when this returns false.
+     * @param path The file to read
+     * @param readPiece Takes the next piece of the payload, returning false to stop the read
+     * @return True if the whole payload was read and matched its checksum
+     */
+    static bool readRaptureAssetPayload(const std::filesystem::path &path,
+                                        const std::function<bool(std::span<const uint8_t> piece)> &readPiece);
 };
 
 } // namespace Rapture
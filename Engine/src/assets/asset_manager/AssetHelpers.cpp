@@ -1,5 +1,8 @@
 #include "AssetHelpers.h"
 
+#include "assets/loaders/images/ImageDecoder.h"
+#include "core/utils/io.h"
+
 #include "stb_image.h"
 
 namespace Rapture {
@@ -16,42 +19,66 @@ bool getImageDimensions(const std::filesystem::path &path, uint32_t &width, uint
     return true;
 }
 
+bool getImageDimensions(std::span<const uint8_t> data, uint32_t &width, uint32_t &height)
+{
+    ImageInfo info;
+    if (!ImageDecoderRegistry::find(data).readInfo(data, info)) {
+        RP_CORE_ERROR("Failed to read image info from memory");
+        return false;
+    }
+    width = info.width;
+    height = info.height;
+    return true;
+}
+
 DecodedImageData decodeImageFile(const std::filesystem::path &path)
 {
-    DecodedImageData result;
-    int width, height, channels;
-    stbi_uc *pixels = stbi_load(path.string().c_str(), &width, &height, &channels, 4);
-    if (!pixels) {
+    std::vector<char> bytes = readFile(path);
+    if (bytes.empty()) {
         RP_CORE_ERROR("Failed to decode image: {}", path.string());
-        return result;
+        return {};
     }
 
-    result.width = static_cast<uint32_t>(width);
-    result.height = static_cast<uint32_t>(height);
-    result.pixels.assign(pixels, pixels + (static_cast<size_t>(width) * height * 4));
-    result.success = true;
-
-    stbi_image_free(pixels);
+    DecodedImageData result = decodeImageMemory({reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size()});
+    if (!result.success) {
+        RP_CORE_ERROR("Failed to decode image: {}", path.string());
+    }
     return result;
 }
 
 DecodedImageData decodeImageMemory(std::span<const uint8_t> data)
 {
     DecodedImageData result;
-    int width, height, channels;
-    stbi_uc *pixels = stbi_load_from_memory(data.data(), static_cast<int>(data.size()), &width, &height, &channels, 4);
-    if (!pixels) {
+    const ImageDecoder &decoder = ImageDecoderRegistry::find(data);
+
+    ImageInfo info;
+    if (!decoder.readInfo(data, info)) {
         RP_CORE_ERROR("Failed to decode image from memory");
         return result;
     }
 
-    result.width = static_cast<uint32_t>(width);
-    result.height = static_cast<uint32_t>(height);
-    result.pixels.assign(pixels, pixels + (static_cast<size_t>(width) * height * 4));
-    result.success = true;
+    result.pixels.resize(info.rgba8Size());
+    if (!decoder.decodeInto(data, info, result.pixels)) {
+        RP_CORE_ERROR("Failed to decode image from memory with {}", decoder.getName());
+        result.pixels.clear();
+        return result;
+    }
 
-    stbi_image_free(pixels);
+    result.width = info.width;
+    result.height = info.height;
+    result.success = true;
     return result;
 }
 
+bool decodeImageInto(std::span<const uint8_t> data, uint32_t width, uint32_t height, std::span<uint8_t> dst)
+{
+    const ImageDecoder &decoder = ImageDecoderRegistry::find(data);
+    ImageInfo info{width, height};
+    if (dst.size() < info.rgba8Size() || !decoder.decodeInto(data, info, dst)) {
+        RP_CORE_ERROR("Failed to decode a {}x{} image with {}", width, height, decoder.getName());
+        return false;
+    }
+    return true;
+}
+
 } // namespace Rapture
@@ -53,6 +53,25 @@ DecodedImageData decodeImageFile(const std::filesystem::path &path);
  */
 DecodedImageData decodeImageMemory(std::span<const uint8_t> data);
 
+/**
+ * @brief Read width/height from an image already loaded into memory without decoding pixel data
+ * @param data Encoded image bytes
+ * @param width Output image width
+ * @param height Output image height
+ * @return true if the header was read successfully
+ */
+bool getImageDimensions(std::span<const uint8_t> data, uint32_t &width, uint32_t &height);
+
+/**
+ * @brief Decode an image already loaded into memory straight into a caller buffer, e.g. a mapped staging region
+ * @param data Encoded image bytes
+ * @param width Expected image width, decoding fails if the image has another size
+ * @param height Expected image height
+ * @param dst At least width * height * 4 bytes, only written to and front to back
+ * @return true if the image decoded into dst
+ */
+bool decodeImageInto(std::span<const uint8_t> data, uint32_t width, uint32_t height, std::span<uint8_t> dst);
+
 // Helper function to find related shader file paths
 inline std::optional<std::filesystem::path> getRelatedShaderPath(const std::filesystem::path &basePath,
                                                                  const std::string &targetStage)
@@ -200,6 +200,27 @@ bool AssetImporter::loadTexture(Asset &asset, AssetMetadata &metadata)
                 return;
             }
 
+            const TextureSpecification &spec = texPtr->getSpecification();
+            if (!isCompressedFormat(spec.format)) {
+                // Decoded straight into the mapped staging buffer, the pixels are never held anywhere else on the CPU.
+                // The asset only counts as loaded once the pixels decoded, so a corrupt image goes from LOADING
+                // straight to FAILED and no listener ever binds it.
+                uint32_t width = spec.width;
+                uint32_t height = spec.height;
+                texPtr->uploadDataAsync(static_cast<size_t>(width) * height * 4,
+                                        [ioData, assetPtr, path, width, height](std::span<uint8_t> staging) {
+                                            if (!decodeImageInto(ioData->first, width, height, staging)) {
+                                                RP_CORE_ERROR("Failed to decode texture: {}", path.string());
+                                                assetPtr->status = AssetStatus::FAILED;
+                                                return false;
+                                            }
+                                            assetPtr->status = AssetStatus::LOADED;
+                                            AssetEvents::onAssetLoaded().publish(assetPtr->getHandle());
+                                            return true;
+                                        });
+                return;
+            }
+
             DecodedImageData decoded = decodeImageMemory(ioData->first);
             if (!decoded.success) {
                 RP_CORE_ERROR("Failed to decode texture: {}", path.string());
@@ -208,38 +229,34 @@ bool AssetImporter::loadTexture(Asset &asset, AssetMetadata &metadata)
                 return;
             }
 
-            TextureFormat targetFormat = texPtr->getSpecification().format;
-            if (isCompressedFormat(targetFormat)) {
-                TextureCompressor compressor(std::move(decoded.pixels), decoded.width, decoded.height);
-                bool compressed = false;
-                if (compressor.isValid()) {
-                    switch (targetFormat) {
-                    case TextureFormat::BC1_RGB:
-                    case TextureFormat::BC1_RGBA:
-                        compressed = compressor.compressToBC1(jctx, *texPtr);
-                        break;
-                    case TextureFormat::BC3:
-                        compressed = compressor.compressToBC3(jctx, *texPtr);
-                        break;
-                    case TextureFormat::BC4:
-                        compressed = compressor.compressToBC4(jctx, *texPtr);
-                        break;
-                    case TextureFormat::BC5:
-                        compressed = compressor.compressToBC5(jctx, *texPtr);
-                        break;
-                    default:
-                        break;
-                    }
+            TextureFormat targetFormat = spec.format;
+            TextureCompressor compressor(std::move(decoded.pixels), decoded.width, decoded.height);
+            bool compressed = false;
+            if (compressor.isValid()) {
+                switch (targetFormat) {
+                case TextureFormat::BC1_RGB:
+                case TextureFormat::BC1_RGBA:
+                    compressed = compressor.compressToBC1(jctx, *texPtr);
+                    break;
+                case TextureFormat::BC3:
+                    compressed = compressor.compressToBC3(jctx, *texPtr);
+                    break;
+                case TextureFormat::BC4:
+                    compressed = compressor.compressToBC4(jctx, *texPtr);
+                    break;
+                case TextureFormat::BC5:
+                    compressed = compressor.compressToBC5(jctx, *texPtr);
+                    break;
+                default:
+                    break;
                 }
+            }
 
-                if (!compressed) {
-                    RP_CORE_ERROR("Failed to compress texture: {}", path.string());
-                    texPtr->markFailed();
-                    assetPtr->status = AssetStatus::FAILED;
-                    return;
-                }
-            } else {
-                texPtr->uploadDataAsync(std::move(decoded.pixels));
+            if (!compressed) {
+                RP_CORE_ERROR("Failed to compress texture: {}", path.string());
+                texPtr->markFailed();
+                assetPtr->status = AssetStatus::FAILED;
+                return;
             }
 
             assetPtr->status = AssetStatus::LOADED;
@@ -259,23 +276,26 @@ bool AssetImporter::loadCubemap(Asset &asset, AssetMetadata &metadata)
         return false;
     }
 
-    std::vector<DecodedImageData> decodedFaces;
-    decodedFaces.reserve(cubemapPaths.size());
-
-    uint32_t width = 0, height = 0;
+    // The faces are independent images, so each decodes on its own job
+    std::vector<DecodedImageData> decodedFaces(cubemapPaths.size());
+    Counter facesDecoded{};
+    facesDecoded.increment(static_cast<int32_t>(cubemapPaths.size()));
     for (size_t i = 0; i < cubemapPaths.size(); ++i) {
-        DecodedImageData decoded = decodeImageFile(cubemapPaths[i]);
-        if (!decoded.success) {
+        jobs().run(JobDeclaration(
+            [face = &decodedFaces[i], path = &cubemapPaths[i]](JobContext &) { *face = decodeImageFile(*path); },
+            JobPriority::HIGH, QueueAffinity::ANY, &facesDecoded, "Cubemap face decode"));
+    }
+    jobs().waitFor(facesDecoded, 0);
+
+    for (size_t i = 0; i < decodedFaces.size(); ++i) {
+        if (!decodedFaces[i].success) {
             RP_CORE_ERROR("Failed to decode cubemap face: {}", cubemapPaths[i]);
             asset.status = AssetStatus::FAILED;
             return false;
         }
-        if (i == 0) {
-            width = decoded.width;
-            height = decoded.height;
-        }
-        decodedFaces.push_back(std::move(decoded));
     }
+    uint32_t width = decodedFaces[0].width;
+    uint32_t height = decodedFaces[0].height;
 
     TextureSpecification texSpec{};
     texSpec.type = TextureType::TEXTURECUBE;
@@ -89,6 +89,11 @@ class AssetManager {
         return s_activeAssetManager->saveAsset(handle, folder);
     }
 
+    static bool cookAsset(AssetHandle handle, const std::filesystem::path &folder)
+    {
+        return s_activeAssetManager->cookAsset(handle, folder);
+    }
+
     static AssetHandle registerRaptureAsset(std::filesystem::path path)
     {
         return s_activeAssetManager->registerRaptureAsset(std::move(path));
@@ -8,6 +8,7 @@
 #include "assets/materials/Material.h"
 #include "assets/materials/MaterialInstance.h"
 #include "assets/meshes/MeshPrimitives.h"
+#include "scene/SceneStream.h"
 #include "scene/instances/Instance.h"
 #include "scene/instances/InstanceRegistry.h"
 #include "gpu/textures/Texture.h"
@@ -107,6 +108,48 @@ static std::vector<uint8_t> s_serializeAsset(Asset &asset, const AssetMetadata &
     return {};
 }
 
+/**
+ * @brief The payload an asset ships with in a cooked build, what it saves unless its type has a form faster to load
+ */
+static std::vector<uint8_t> s_cookAsset(Asset &asset, const AssetMetadata &metadata)
+{
+    if (metadata.assetType == ASSET_WORLD) {
+        if (World *world = asset.getUnderlyingAsset<World>()) {
+            // chunks a load can instantiate as they arrive, instead of a document parsed once all of it is in
+            return world->serialize(SCENE_FILE_BINARY);
+        }
+    }
+    return s_serializeAsset(asset, metadata);
+}
+
+static std::filesystem::path s_rassetPath(const std::filesystem::path &folder, const AssetMetadata &metadata)
+{
+    // The display name keeps its spaces, the on-disk file name does not
+    std::string fileName = metadata.getName();
+    std::replace(fileName.begin(), fileName.end(), ' ', '_');
+    return folder / (fileName + ".rasset");
+}
+
+/**
+ * @brief Writes an asset's `.rasset`, streaming the payload of a world rather than building it in memory first
+ * @return False if the asset could not be serialized or the file written
+ */
+static bool s_writeAssetFile(const std::filesystem::path &path, AssetHandle handle, const AssetMetadata &metadata, Asset &asset)
+{
+    if (metadata.assetType == ASSET_WORLD) {
+        if (World *world = asset.getUnderlyingAsset<World>()) {
+            return AssetCodec::writeRaptureAsset(path, handle, metadata, [world](int fd) { return world->serializeTo(fd); });
+        }
+    }
+
+    std::vector<uint8_t> payload = s_serializeAsset(asset, metadata);
+    if (payload.empty()) {
+        RP_CORE_ERROR("Failed to serialize '{}'", metadata.getName());
+        return false;
+    }
+    return AssetCodec::writeRaptureAsset(path, handle, metadata, payload);
+}
+
 static bool s_deserializeAsset(Asset &asset, const AssetMetadata &metadata, std::span<const uint8_t> payload)
 {
     switch (metadata.assetType) {
@@ -167,13 +210,51 @@ static bool s_deserializeAsset(Asset &asset, const AssetMetadata &metadata, std:
     return false;
 }
 
+/**
+ * @brief Loads a world from its `.rasset`, a scene stream being instantiated chunk by chunk as the payload is read
+ * @return False if the payload could not be read or does not hold a world
+ */
+static bool s_loadWorld(Asset &asset, const std::filesystem::path &path)
+{
+    SceneStreamReader reader;
+    std::vector<uint8_t> text; // a text save can only be parsed once all of it is in
+    bool first = true;
+    bool stream = false;
+
+    bool read = AssetCodec::readRaptureAssetPayload(path, [&](std::span<const uint8_t> piece) {
+        if (first) {
+            stream = isSceneStream(piece);
+            first = false;
+        }
+        if (stream) {
+            return reader.append(piece);
+        }
+        text.insert(text.end(), piece.begin(), piece.end());
+        return true;
+    });
+    if (!read) {
+        return false;
+    }
+
+    std::unique_ptr<World> world = stream ? World::deserialize(reader) : World::deserialize(text);
+    if (world == nullptr) {
+        return false;
+    }
+    asset.setAssetVariant(std::move(world));
+    return true;
+}
+
 static AssetVariant s_buildImportData(AssetImportDataVariant &data, std::vector<uint8_t> &payload, AssetType &type)
 {
     if (auto *meshData = std::get_if<StaticMeshImportData>(&data)) {
         // the source bytes are already in hand here, so this skips the readback serialize does
-        payload = StaticMesh::serializeParams(meshData->params);
+        // collision is cooked here, once, and only ever read back from the payload afterwards
+        const physics::CookedCollision collision = StaticMesh::cookCollision(meshData->params);
+        payload = StaticMesh::serializeParams(meshData->params, collision);
         type = ASSET_STATIC_MESH;
-        return std::make_unique<StaticMesh>(meshData->params);
+        auto mesh = std::make_unique<StaticMesh>(meshData->params);
+        mesh->setCollision(collision);
+        return mesh;
     }
     if (auto *skeletalData = std::get_if<SkeletalMeshImportData>(&data)) {
         payload = SkeletalMesh::serializeParams(skeletalData->params, skeletalData->skeleton, skeletalData->inverseBindMatrices);
@@ -546,8 +627,15 @@ std::unique_ptr<Asset> AssetManagerEditor::loadFromMetadata(AssetHandle handle,
     auto asset = std::make_unique<Asset>(handle);
 
     if (!metadata.assetPath.empty() && std::filesystem::exists(metadata.assetPath)) {
-        std::vector<uint8_t> payload = AssetCodec::readRaptureAssetPayload(metadata.assetPath);
-        if (!payload.empty() && s_deserializeAsset(*asset, metadata, payload)) {
+        bool loaded = false;
+        if (metadata.assetType == ASSET_WORLD) {
+            loaded = s_loadWorld(*asset, metadata.assetPath);
+        } else {
+            std::vector<uint8_t> payload = AssetCodec::readRaptureAssetPayload(metadata.assetPath);
+            loaded = !payload.empty() && s_deserializeAsset(*asset, metadata, payload);
+        }
+
+        if (loaded) {
             asset->status = AssetStatus::LOADED;
             return asset;
         }
@@ -738,13 +826,7 @@ bool AssetManagerEditor::updateAsset(AssetHandle handle, AssetVariant asset)
     loadedAsset.setAssetVariant(std::move(asset));
     loadedAsset.status = AssetStatus::LOADED;
 
-    std::vector<uint8_t> payload = s_serializeAsset(loadedAsset, metadata);
-    if (payload.empty()) {
-        RP_CORE_ERROR("Failed to serialize '{}'", metadata.getName());
-        return false;
-    }
-
-    if (!AssetCodec::writeRaptureAsset(metadata.assetPath, handle, metadata, payload)) {
+    if (!s_writeAssetFile(metadata.assetPath, handle, metadata, loadedAsset)) {
         RP_CORE_ERROR("Failed to write .rasset for '{}'", metadata.getName());
         return false;
     }
@@ -761,25 +843,44 @@ bool AssetManagerEditor::saveAsset(AssetHandle handle, const std::filesystem::pa
     }
 
     AssetMetadata &metadata = *slot->metadata;
-    std::vector<uint8_t> payload = s_serializeAsset(*slot->asset, metadata);
-    if (payload.empty()) {
-        RP_CORE_ERROR("Failed to serialize '{}'", metadata.getName());
-        return false;
-    }
-
     if (metadata.assetPath.empty()) {
+        std::vector<uint8_t> payload = s_serializeAsset(*slot->asset, metadata);
+        if (payload.empty()) {
+            RP_CORE_ERROR("Failed to serialize '{}'", metadata.getName());
+            return false;
+        }
+
         metadata.storageType = AssetStorageType::DISK;
         writeRaptureAssetFile(handle, folder, metadata, payload);
         return !metadata.assetPath.empty();
     }
 
-    if (!AssetCodec::writeRaptureAsset(metadata.assetPath, handle, metadata, payload)) {
+    if (!s_writeAssetFile(metadata.assetPath, handle, metadata, *slot->asset)) {
         RP_CORE_ERROR("Failed to write .rasset for '{}'", metadata.getName());
         return false;
     }
     return true;
 }
 
+bool AssetManagerEditor::cookAsset(AssetHandle handle, const std::filesystem::path &folder)
+{
+    AssetSlot *slot = m_assets.find(handle);
+    if (slot == nullptr || slot->asset == nullptr) {
+        RP_CORE_ERROR("cannot cook asset {}, it holds nothing", handle);
+        return false;
+    }
+
+    const AssetMetadata &metadata = *slot->metadata;
+    std::vector<uint8_t> payload = s_cookAsset(*slot->asset, metadata);
+    if (payload.empty()) {
+        RP_CORE_ERROR("Failed to cook '{}'", metadata.getName());
+        return false;
+    }
+
+    // the asset keeps its own file, the cooked copy only lands in the folder
+    return AssetCodec::writeRaptureAsset(s_rassetPath(folder, metadata), handle, metadata, payload);
+}
+
 void AssetManagerEditor::writeRaptureAssetFile(AssetHandle handle, const std::filesystem::path &folder,
                                                AssetMetadata &metadata, std::span<const uint8_t> payload)
 {
@@ -788,10 +889,7 @@ void AssetManagerEditor::writeRaptureAssetFile(AssetHandle handle, const std::fi
         return;
     }
 
-    // The display name keeps its spaces, the on-disk file name does not
-    std::string fileName = metadata.getName();
-    std::replace(fileName.begin(), fileName.end(), ' ', '_');
-    std::filesystem::path output = folder / (fileName + ".rasset");
+    std::filesystem::path output = s_rassetPath(folder, metadata);
     if (AssetCodec::writeRaptureAsset(output, handle, metadata, payload)) {
         metadata.assetPath = output;
         m_pathIndex[s_hashPath(output)] = handle;
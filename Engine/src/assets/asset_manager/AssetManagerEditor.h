@@ -73,6 +73,14 @@ class AssetManagerEditor : public AssetManagerBase {
      */
     bool saveAsset(AssetHandle handle, const std::filesystem::path &folder);
 
+    /**
+     * @brief Writes a loaded asset in the form a cooked build loads it in, leaving the asset's own file as it is
+     * @param handle The asset to write
+     * @param folder Directory the cooked `.rasset` is written into
+     * @return True if the cooked file was written
+     */
+    bool cookAsset(AssetHandle handle, const std::filesystem::path &folder);
+
     Asset &importDefaultAsset(AssetType assetType);
 
     Asset &registerVirtualAsset(AssetVariant asset, const std::string &virtualName, AssetType assetType);
@@ -0,0 +1,93 @@
+#include "ImageDecoder.h"
+
+#include "WuffsImageDecoder.h"
+
+#include <cstring>
+#include <vector>
+
+#include "stb_image.h"
+
+namespace Rapture {
+
+/**
+ * @brief Everything stb_image reads, the fallback for formats no faster decoder claims
+ *
+ * stb_image only decodes into memory it allocates itself, so this one pays a copy into the destination.
+ */
+class StbImageDecoder final : public ImageDecoder {
+  public:
+    std::string_view getName() const override { return "stb_image"; }
+
+    bool accepts(std::span<const uint8_t>) const override { return true; }
+
+    bool readInfo(std::span<const uint8_t> data, ImageInfo &info) const override
+    {
+        int width = 0, height = 0, channels = 0;
+        if (!stbi_info_from_memory(data.data(), static_cast<int>(data.size()), &width, &height, &channels)) {
+            return false;
+        }
+        info.width = static_cast<uint32_t>(width);
+        info.height = static_cast<uint32_t>(height);
+        return true;
+    }
+
+    bool decodeInto(std::span<const uint8_t> data, const ImageInfo &info, std::span<uint8_t> dst) const override
+    {
+        int width = 0, height = 0, channels = 0;
+        stbi_uc *pixels = stbi_load_from_memory(data.data(), static_cast<int>(data.size()), &width, &height, &channels, 4);
+        if (pixels == nullptr) {
+            return false;
+        }
+
+        bool matches = static_cast<uint32_t>(width) == info.width && static_cast<uint32_t>(height) == info.height &&
+                       dst.size() >= info.rgba8Size();
+        if (matches) {
+            std::memcpy(dst.data(), pixels, info.rgba8Size());
+        }
+        stbi_image_free(pixels);
+        return matches;
+    }
+};
+
+// Highest priority first, the stb_image fallback always last
+static std::vector<std::unique_ptr<ImageDecoder>> &s_decoders()
+{
+    static std::vector<std::unique_ptr<ImageDecoder>> decoders = [] {
+        std::vector<std::unique_ptr<ImageDecoder>> builtins;
+        builtins.push_back(createWuffsImageDecoder());
+        builtins.push_back(std::make_unique<StbImageDecoder>());
+        return builtins;
+    }();
+    return decoders;
+}
+
+void ImageDecoderRegistry::registerDecoder(std::unique_ptr<ImageDecoder> decoder)
+{
+    if (decoder) {
+        auto &decoders = s_decoders();
+        decoders.insert(decoders.begin(), std::move(decoder));
+    }
+}
+
+const ImageDecoder &ImageDecoderRegistry::find(std::span<const uint8_t> data)
+{
+    const auto &decoders = s_decoders();
+    for (const auto &decoder : decoders) {
+        if (decoder->accepts(data)) {
+            return *decoder;
+        }
+    }
+    return *decoders.back();
+}
+
+const ImageDecoder *ImageDecoderRegistry::get(std::string_view name)
+{
+    for (const auto &decoder : s_decoders()) {
+        if (decoder->getName() == name) {
+            return decoder.get();
+        }
+    }
+    return nullptr;
+}
+
+} // namespace Rapture
@@ -0,0 +1,84 @@
+#ifndef RAPTURE__IMAGE_DECODER_H
+#define RAPTURE__IMAGE_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+
+namespace Rapture {
+
+/**
+ * @brief What an image header says, enough to size the RGBA8 destination before decoding
+ */
+struct ImageInfo {
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    size_t rgba8Size() const { return static_cast<size_t>(width) * height * 4; }
+};
+
+/**
+ * @brief Decodes one family of encoded images to tightly packed RGBA8
+ *
+ * Decoders are stateless and called from any job, concurrently. decodeInto() only ever writes the
+ * destination, front to back, so it may be a mapped staging buffer in write-combined memory.
+ */
+class ImageDecoder {
+  public:
+    virtual ~ImageDecoder() = default;
+
+    virtual std::string_view getName() const = 0;
+
+    /**
+     * @brief Whether the bytes start with a signature this decoder reads, nothing past it is checked
+     */
+    virtual bool accepts(std::span<const uint8_t> data) const = 0;
+
+    /**
+     * @brief Parse only the header
+     * @param data The encoded image
+     * @param info Receives the dimensions
+     * @return False if the header is malformed
+     */
+    virtual bool readInfo(std::span<const uint8_t> data, ImageInfo &info) const = 0;
+
+    /**
+     * @brief Decode straight into a caller buffer, 4 channels whatever the source has
+     * @param data The encoded image
+     * @param info The dimensions readInfo() returned for the same data
+     * @param dst At least info.rgba8Size() bytes, rows top to bottom with no padding
+     * @return False if the data is corrupt or does not match info, dst is then partly written
+     */
+    virtual bool decodeInto(std::span<const uint8_t> data, const ImageInfo &info, std::span<uint8_t> dst) const = 0;
+};
+
+/**
+ * @brief The decoders texture loading picks from, by the signature of the bytes it was handed
+ *
+ * Decoders registered later are asked first, so a project can put a faster or more complete decoder
+ * in front of the builtins. stb_image is always last and takes whatever nobody else claimed.
+ */
+class ImageDecoderRegistry {
+  public:
+    /**
+     * @brief Add a decoder in front of the ones already registered, before any texture loads
+     */
+    static void registerDecoder(std::unique_ptr<ImageDecoder> decoder);
+
+    /**
+     * @brief The decoder for these bytes, never null since the stb_image fallback accepts anything
+     */
+    static const ImageDecoder &find(std::span<const uint8_t> data);
+
+    /**
+     * @brief A decoder by name, for tools and benchmarks that compare them
+     * @return The decoder, or nullptr if none has that name
+     */
+    static const ImageDecoder *get(std::string_view name);
+};
+
+} // namespace Rapture
+
+#endif // RAPTURE__IMAGE_DECODER_H
@@ -0,0 +1,96 @@
+#include "WuffsImageDecoder.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Declarations only, the implementation and the module selection live in the vendored wuffs target
+#include "wuffs-v0.4.c"
+
+namespace Rapture {
+
+static constexpr uint8_t PNG_SIGNATURE[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+static constexpr uint8_t JPEG_SIGNATURE[] = {0xFF, 0xD8, 0xFF};
+
+static bool s_startsWith(std::span<const uint8_t> data, std::span<const uint8_t> signature)
+{
+    return data.size() >= signature.size() && std::memcmp(data.data(), signature.data(), signature.size()) == 0;
+}
+
+/**
+ * @brief Hands Wuffs the caller's buffer as its pixel buffer, or stops once the header is known
+ *
+ * Without an expected size the decode ends at allocation, which is how readInfo() parses only the header.
+ */
+class DestinationCallbacks final : public wuffs_aux::DecodeImageCallbacks {
+  public:
+    DestinationCallbacks(const ImageInfo *expected, std::span<uint8_t> dst) : m_expected(expected), m_dst(dst) {}
+
+    const ImageInfo &getHeader() const { return m_header; }
+
+  private:
+    wuffs_base__pixel_format SelectPixfmt(const wuffs_base__image_config &) override
+    {
+        return wuffs_base__make_pixel_format(WUFFS_BASE__PIXEL_FORMAT__RGBA_NONPREMUL);
+    }
+
+    AllocPixbufResult AllocPixbuf(const wuffs_base__image_config &config, bool) override
+    {
+        m_header.width = config.pixcfg.width();
+        m_header.height = config.pixcfg.height();
+        if (m_expected == nullptr) {
+            return AllocPixbufResult(std::string("header only"));
+        }
+        if (m_header.width != m_expected->width || m_header.height != m_expected->height ||
+            m_dst.size() < m_header.rgba8Size()) {
+            return AllocPixbufResult(std::string("image does not match its destination"));
+        }
+
+        wuffs_base__pixel_buffer pixbuf;
+        wuffs_base__status status = pixbuf.set_from_slice(&config.pixcfg, wuffs_base__make_slice_u8(m_dst.data(), m_dst.size()));
+        if (!status.is_ok()) {
+            return AllocPixbufResult(std::string(status.message()));
+        }
+        // the memory is the caller's, so the owner Wuffs keeps frees nothing
+        return AllocPixbufResult(wuffs_aux::MemOwner(nullptr, &free), pixbuf);
+    }
+
+    const ImageInfo *m_expected;
+    std::span<uint8_t> m_dst;
+    ImageInfo m_header;
+};
+
+class WuffsImageDecoder final : public ImageDecoder {
+  public:
+    std::string_view getName() const override { return "wuffs"; }
+
+    bool accepts(std::span<const uint8_t> data) const override
+    {
+        return s_startsWith(data, PNG_SIGNATURE) || s_startsWith(data, JPEG_SIGNATURE);
+    }
+
+    bool readInfo(std::span<const uint8_t> data, ImageInfo &info) const override
+    {
+        DestinationCallbacks callbacks(nullptr, {});
+        wuffs_aux::sync_io::MemoryInput input(data.data(), data.size());
+        wuffs_aux::DecodeImage(callbacks, input);
+
+        info = callbacks.getHeader();
+        return info.width != 0 && info.height != 0;
+    }
+
+    bool decodeInto(std::span<const uint8_t> data, const ImageInfo &info, std::span<uint8_t> dst) const override
+    {
+        DestinationCallbacks callbacks(&info, dst);
+        wuffs_aux::sync_io::MemoryInput input(data.data(), data.size());
+        wuffs_aux::DecodeImageResult result = wuffs_aux::DecodeImage(callbacks, input);
+        return result.error_message.empty();
+    }
+};
+
+std::unique_ptr<ImageDecoder> createWuffsImageDecoder()
+{
+    return std::make_unique<WuffsImageDecoder>();
+}
+
+} // namespace Rapture
@@ -0,0 +1,19 @@
+#ifndef RAPTURE__WUFFS_IMAGE_DECODER_H
+#define RAPTURE__WUFFS_IMAGE_DECODER_H
+
+#include "ImageDecoder.h"
+
+#include <memory>
+
+namespace Rapture {
+
+/**
+ * @brief PNG and JPEG through Wuffs, which picks its SSE4.2/AVX2 paths at run time
+ *
+ * Wuffs swizzles straight into the destination, so unlike stb_image there is no intermediate copy.
+ */
+std::unique_ptr<ImageDecoder> createWuffsImageDecoder();
+
+} // namespace Rapture
+
+#endif // RAPTURE__WUFFS_IMAGE_DECODER_H
@@ -1,8 +1,12 @@
 #include "MaterialGraphCompiler.h"
 
+#include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
+#include <optional>
 #include <string_view>
 #include <unordered_map>
 #include <unordered_set>
@@ -16,12 +20,28 @@ namespace Rapture {
 
 using DiagnosticList = std::vector<MaterialCompilerDiagnostic>;
 
-// One emitted GLSL local standing in for a node output pin, tracked so consumers can reference it
-struct EmittedVar {
-    std::string var;
-    PinType type;
+// Subtrees smaller than this many nodes are cheaper inline than behind a shared helper call
+static constexpr uint32_t MIN_SHARED_COST = 3;
+static constexpr uint32_t MAX_VALUE_COST = 1u << 20;
+static constexpr size_t MAX_CACHED_GRAPHS = 1024;
+static constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+
+// What a node output or input pin resolves to while a pass is emitted
+struct PassOperand {
+    PinType type = PinType::FLOAT;
+    std::string expr;                 // GLSL, values of the pass written as @index@
+    std::optional<PinValue> constant; // set when the value is a literal known at compile time
 };
-using EmittedMap = std::unordered_map<GraphPinKey, EmittedVar>;
+using EmittedMap = std::unordered_map<GraphPinKey, PassOperand>;
+
+// The values of one pass as they are emitted, hash-consed on their expression
+struct PassBuilder {
+    std::vector<CompiledValue> values;
+    std::unordered_map<std::string, uint32_t> byExpr = {}; // "type expr" -> value index
+    uint32_t folded = 0;
+};
+
+using SharedHelpers = std::unordered_map<uint32_t, std::string>; // subtree shape -> helper function name
 
 /**
  * @brief Indexed, resolved view of a graph, built once and shared by every compile phase
@@ -189,6 +209,191 @@ static void s_packValue(GraphInstanceData &slice, GraphBufferOffset offset, cons
     }
 }
 
+static uint64_t s_hashBytes(std::string_view bytes, uint64_t hash)
+{
+    for (char c : bytes) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static std::string s_valueRef(uint32_t index)
+{
+    return "@" + std::to_string(index) + "@";
+}
+
+/**
+ * @brief Walk an expression, handing plain text and @index@ value references to separate callbacks
+ *
+ * '@' never appears in GLSL, so it cannot collide with template or domain input text.
+ */
+template <typename TextFn, typename RefFn>
+static void s_scanRefs(std::string_view expr, TextFn &&onText, RefFn &&onRef)
+{
+    size_t pos = 0;
+    while (pos < expr.size()) {
+        size_t open = expr.find('@', pos);
+        size_t close = open == std::string_view::npos ? open : expr.find('@', open + 1);
+        if (close == std::string_view::npos) {
+            onText(expr.substr(pos));
+            return;
+        }
+        onText(expr.substr(pos, open - pos));
+        uint32_t index = 0;
+        std::from_chars(expr.data() + open + 1, expr.data() + close, index);
+        onRef(index);
+        pos = close + 1;
+    }
+}
+
+static std::vector<uint32_t> s_collectOperands(std::string_view expr)
+{
+    std::vector<uint32_t> operands;
+    s_scanRefs(expr, [](std::string_view) {}, [&](uint32_t index) {
+        if (std::find(operands.begin(), operands.end(), index) == operands.end()) operands.push_back(index);
+    });
+    return operands;
+}
+
+/**
+ * @brief Give every value of the functions a shape, equal for two values exactly when their subtrees are equal
+ *
+ * A value's key is its text with each reference replaced by the referenced value's shape, so equal subtrees
+ * in different graphs meet on the same key and different ones never do.
+ * @return The shape of each value, per function
+ */
+static std::vector<std::vector<uint32_t>> s_internShapes(const std::vector<const CompiledFunction *> &functions)
+{
+    std::unordered_map<std::string, uint32_t> shapes; // "type expr", references written as @shape@ -> shape
+    std::vector<std::vector<uint32_t>> shapeOf(functions.size());
+    for (size_t f = 0; f < functions.size(); ++f) {
+        const std::vector<CompiledValue> &values = functions[f]->values;
+        shapeOf[f].reserve(values.size());
+        for (const auto &value : values) {
+            std::string key = std::string(graph_pinTypeGlsl(value.type)) + " ";
+            s_scanRefs(value.expr, [&](std::string_view text) { key += text; },
+                       [&](uint32_t index) { key += s_valueRef(shapeOf[f][index]); });
+            shapeOf[f].push_back(shapes.emplace(std::move(key), static_cast<uint32_t>(shapes.size())).first->second);
+        }
+    }
+    return shapeOf;
+}
+
+/**
+ * @brief A literal converted the way s_coerce converts its expression, so folding can see through it
+ */
+static PinValue s_coerceConstant(const PinValue &value, PinType from, PinType to)
+{
+    uint32_t fromComponents = graph_pinTypeComponents(from);
+    uint32_t toComponents = graph_pinTypeComponents(to);
+
+    if (fromComponents == 1) {
+        if (to == PinType::INT) return PinValue(from == PinType::INT ? value.i : static_cast<int>(value.f));
+        return PinValue(from == PinType::INT ? static_cast<float>(value.i) : value.f);
+    }
+    if (toComponents == 1) {
+        return to == PinType::INT ? PinValue(static_cast<int>(value.v4.x)) : PinValue(value.v4.x);
+    }
+
+    PinValue result = value;
+    for (uint32_t component = fromComponents; component < 4; ++component) {
+        (&result.v4.x)[component] = 0.0f;
+    }
+    if (from == PinType::VEC3 && to == PinType::VEC4) {
+        result.v4.w = 1.0f;
+    }
+    return result;
+}
+
+static PassOperand s_coerceOperand(const PassOperand &operand, PinType to)
+{
+    if (operand.type == to) {
+        return operand;
+    }
+    std::optional<PinValue> constant;
+    if (operand.constant.has_value()) {
+        constant = s_coerceConstant(*operand.constant, operand.type, to);
+    }
+    return {to, s_coerce(operand.expr, operand.type, to), constant};
+}
+
+static std::string s_renderExpr(std::string_view expr, const std::vector<std::string> &names)
+{
+    std::string out;
+    s_scanRefs(expr, [&](std::string_view text) { out += text; }, [&](uint32_t index) { out += names[index]; });
+    return out;
+}
+
+/**
+ * @brief Emit one local per value the roots need, a shared subtree as a call to its helper
+ * @param values The pass values
+ * @param roots The values the caller reads
+ * @param helpers The shared helpers by subtree shape, null to emit everything inline
+ * @param shapes The shape of each value, from s_internShapes, null when helpers is
+ * @param self A value emitted inline even though it has a helper, the helper being written, or UINT32_MAX
+ * @param names Filled with the local name of each emitted value
+ */
+static std::string s_renderLocals(const std::vector<CompiledValue> &values, const std::vector<uint32_t> &roots,
+                                  const SharedHelpers *helpers, const std::vector<uint32_t> *shapes, uint32_t self,
+                                  std::vector<std::string> &names)
+{
+    auto helperOf = [&](uint32_t index) -> const std::string * {
+        if (helpers == nullptr || index == self) return nullptr;
+        auto it = helpers->find((*shapes)[index]);
+        return it != helpers->end() ? &it->second : nullptr;
+    };
+
+    std::vector<uint8_t> live(values.size(), 0);
+    std::vector<uint32_t> stack(roots.begin(), roots.end());
+    while (!stack.empty()) {
+        uint32_t index = stack.back();
+        stack.pop_back();
+        if (live[index] != 0) continue;
+        live[index] = 1;
+        if (helperOf(index) == nullptr) {
+            stack.insert(stack.end(), values[index].operands.begin(), values[index].operands.end());
+        }
+    }
+
+    names.assign(values.size(), std::string());
+    std::string out;
+    uint32_t counter = 0;
+    for (uint32_t index = 0; index < values.size(); ++index) {
+        if (live[index] == 0) continue;
+        names[index] = "_n" + std::to_string(counter++);
+        const std::string *helper = helperOf(index);
+        std::string rhs = helper != nullptr ? *helper + "(si, base)" : s_renderExpr(values[index].expr, names);
+        out += std::string(graph_pinTypeGlsl(values[index].type)) + " " + names[index] + "=" + rhs + ";\n";
+    }
+    return out;
+}
+
+static std::string s_renderBody(const CompiledFunction &function, const GraphPass &pass, const SharedHelpers *helpers,
+                                const std::vector<uint32_t> *shapes)
+{
+    std::vector<uint32_t> roots;
+    for (const auto &field : function.fields) {
+        roots.insert(roots.end(), field.operands.begin(), field.operands.end());
+    }
+
+    std::vector<std::string> names;
+    std::string body = std::string(pass.structName) + " surf;\n";
+    body += s_renderLocals(function.values, roots, helpers, shapes, UINT32_MAX, names);
+    for (size_t i = 0; i < function.fields.size(); ++i) {
+        body += "surf." + std::string(pass.fields[i].name) + "=" + s_renderExpr(function.fields[i].expr, names) + ";\n";
+    }
+    body += "return surf;\n";
+    return body;
+}
+
+static std::string s_renderFunction(std::string_view returnType, std::string_view name, const GraphDomain &domain,
+                                    std::string_view body)
+{
+    return std::string(returnType) + " " + std::string(name) + "(" + std::string(domain.inputStructName) +
+           " si, uint base){\n" + std::string(body) + "}\n";
+}
+
 /**
  * @brief Index the graph into a GraphContext, resolving definitions, wires, dependencies and uses
  */
@@ -408,75 +613,291 @@ static void s_assignResources(const GraphContext &ctx, const std::vector<uint32_
 }
 
 /**
- * @brief Resolve the expression feeding one input pin, coerced to the pin type
+ * @brief Resolve the operand feeding one input pin, coerced to the pin type
  *
- * A wired pin uses its upstream local; an unwired pin reads its authored slot from the instance
- * slice, or bakes its literal default when nothing was authored.
+ * A wired pin uses its upstream value; an unwired pin reads its authored slot from the instance
+ * slice, or bakes its literal default when nothing was authored, which is the only compile time
+ * constant a graph has since authored values stay editable per instance.
  */
-static std::string s_resolveInput(const GraphContext &ctx, const GraphSlotMapping &mapping, const EmittedMap &emitted,
+static PassOperand s_resolveInput(const GraphContext &ctx, const GraphSlotMapping &mapping, const EmittedMap &emitted,
                                   uint32_t nodeId, const PinDef &pin, uint32_t pinIndex)
 {
     if (const GraphConnection *wire = ctx.wireInto(nodeId, pinIndex)) {
         auto it = emitted.find(Graph_pinKey(wire->srcNode, wire->srcPin));
         if (it != emitted.end()) {
-            return s_coerce(it->second.var, it->second.type, pin.type);
+            return s_coerceOperand(it->second, pin.type);
         }
     }
 
     auto slot = mapping.slots.find(Graph_pinKey(nodeId, pinIndex));
     if (pin.type == PinType::TEXTURE) {
         RP_ASSERT(slot != mapping.slots.end(), "texture pin reached codegen without a slot, validation should have rejected it");
-        return s_poolElem(slot->second.offset);
+        return {PinType::TEXTURE, s_poolElem(slot->second.offset), std::nullopt};
     }
     if (slot != mapping.slots.end()) {
-        return s_poolRead(slot->second.offset, slot->second.type);
+        return {pin.type, s_poolRead(slot->second.offset, slot->second.type), std::nullopt};
     }
-    return s_literal(pin.defaultValue, pin.type);
+    return {pin.type, s_literal(pin.defaultValue, pin.type), pin.defaultValue};
 }
 
 /**
- * @brief Substitute a node definition template into its concrete GLSL expression
+ * @brief Evaluate a pure arithmetic node whose inputs are all literals
+ * @return False for a node type that is not folded, or an input the GPU would not agree on
  *
- * A {pin} placeholder resolves to an upstream local or a slice read, a {$name} placeholder to the
- * domain's expression for that input.
+ * Only exact operations are folded, so the literal matches what the shader computed before.
+ */
+static bool s_foldNode(GraphNodeType type, uint32_t outPin, const std::vector<PassOperand> &in, PinValue &out)
+{
+    auto f = [&](size_t i) { return in[i].constant->f; };
+    auto v = [&](size_t i) { return in[i].constant->v3; };
+    auto n = [&](size_t i) { return in[i].constant->i; };
+    // ints wrap on the GPU, so they are added in unsigned to not overflow here
+    auto wrap = [](uint32_t value) { return static_cast<int32_t>(value); };
+    auto u = [&](size_t i) { return static_cast<uint32_t>(n(i)); };
+
+    using GN = GraphNodeType;
+    switch (type) {
+    case GN::ADD_FLOAT:
+        out = PinValue(f(0) + f(1));
+        return true;
+    case GN::ADD_VEC3:
+        out = PinValue(v(0) + v(1));
+        return true;
+    case GN::ADD_INT:
+        out = PinValue(wrap(u(0) + u(1)));
+        return true;
+    case GN::SUBTRACT_FLOAT:
+        out = PinValue(f(0) - f(1));
+        return true;
+    case GN::SUBTRACT_VEC3:
+        out = PinValue(v(0) - v(1));
+        return true;
+    case GN::SUBTRACT_INT:
+        out = PinValue(wrap(u(0) - u(1)));
+        return true;
+    case GN::MULTIPLY_FLOAT:
+        out = PinValue(f(0) * f(1));
+        return true;
+    case GN::MULTIPLY_VEC3:
+        out = PinValue(v(0) * v(1));
+        return true;
+    case GN::MULTIPLY_INT:
+        out = PinValue(wrap(u(0) * u(1)));
+        return true;
+    case GN::DIVIDE_FLOAT:
+        if (f(1) == 0.0f) return false;
+        out = PinValue(f(0) / f(1));
+        return true;
+    case GN::DIVIDE_VEC3:
+        if (v(1).x == 0.0f || v(1).y == 0.0f || v(1).z == 0.0f) return false;
+        out = PinValue(v(0) / v(1));
+        return true;
+    case GN::DIVIDE_INT:
+        if (n(1) == 0 || (n(0) == INT32_MIN && n(1) == -1)) return false;
+        out = PinValue(n(0) / n(1));
+        return true;
+    case GN::ABS_FLOAT:
+        out = PinValue(glm::abs(f(0)));
+        return true;
+    case GN::ABS_VEC3:
+        out = PinValue(glm::abs(v(0)));
+        return true;
+    case GN::ABS_INT:
+        if (n(0) == INT32_MIN) return false;
+        out = PinValue(n(0) < 0 ? -n(0) : n(0));
+        return true;
+    case GN::MIN_FLOAT:
+        out = PinValue(glm::min(f(0), f(1)));
+        return true;
+    case GN::MIN_VEC3:
+        out = PinValue(glm::min(v(0), v(1)));
+        return true;
+    case GN::MIN_INT:
+        out = PinValue(std::min(n(0), n(1)));
+        return true;
+    case GN::MAX_FLOAT:
+        out = PinValue(glm::max(f(0), f(1)));
+        return true;
+    case GN::MAX_VEC3:
+        out = PinValue(glm::max(v(0), v(1)));
+        return true;
+    case GN::MAX_INT:
+        out = PinValue(std::max(n(0), n(1)));
+        return true;
+    case GN::CLAMP_FLOAT:
+        out = PinValue(glm::min(glm::max(f(0), f(1)), f(2)));
+        return true;
+    case GN::CLAMP_VEC3:
+        out = PinValue(glm::min(glm::max(v(0), v(1)), v(2)));
+        return true;
+    case GN::CLAMP_INT:
+        out = PinValue(std::min(std::max(n(0), n(1)), n(2)));
+        return true;
+    case GN::SATURATE_FLOAT:
+        out = PinValue(glm::min(glm::max(f(0), 0.0f), 1.0f));
+        return true;
+    case GN::SATURATE_VEC3:
+        out = PinValue(glm::min(glm::max(v(0), glm::vec3(0.0f)), glm::vec3(1.0f)));
+        return true;
+    case GN::MIX_FLOAT:
+        out = PinValue(f(0) * (1.0f - f(2)) + f(1) * f(2));
+        return true;
+    case GN::MIX_VEC3:
+        out = PinValue(v(0) * (1.0f - f(2)) + v(1) * f(2));
+        return true;
+    case GN::COMBINE_VEC2:
+        out = PinValue(glm::vec2(f(0), f(1)));
+        return true;
+    case GN::COMBINE_VEC3:
+        out = PinValue(glm::vec3(f(0), f(1), f(2)));
+        return true;
+    case GN::COMBINE_VEC4:
+        out = PinValue(glm::vec4(f(0), f(1), f(2), f(3)));
+        return true;
+    case GN::SPLIT_VEC2:
+    case GN::SPLIT_VEC3:
+    case GN::SPLIT_VEC4:
+        out = PinValue((&in[0].constant->v4.x)[outPin]);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Whether an operand is a literal with every component equal to scalar
+static bool s_isSplat(const PassOperand &operand, float scalar)
+{
+    if (!operand.constant.has_value()) {
+        return false;
+    }
+    if (operand.type == PinType::INT) {
+        return operand.constant->i == static_cast<int32_t>(scalar);
+    }
+    for (uint32_t component = 0; component < graph_pinTypeComponents(operand.type); ++component) {
+        if ((&operand.constant->v4.x)[component] != scalar) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief The input a node reduces to when its other input is the identity, e.g. x * 1 or x + 0
+ * @return The surviving input, or nullptr when the node does real work
+ */
+static const PassOperand *s_identityOperand(GraphNodeType type, const std::vector<PassOperand> &in)
+{
+    using GN = GraphNodeType;
+    switch (type) {
+    case GN::ADD_FLOAT:
+    case GN::ADD_VEC3:
+    case GN::ADD_INT:
+        if (s_isSplat(in[0], 0.0f)) return &in[1];
+        if (s_isSplat(in[1], 0.0f)) return &in[0];
+        return nullptr;
+    case GN::SUBTRACT_FLOAT:
+    case GN::SUBTRACT_VEC3:
+    case GN::SUBTRACT_INT:
+        return s_isSplat(in[1], 0.0f) ? &in[0] : nullptr;
+    case GN::MULTIPLY_FLOAT:
+    case GN::MULTIPLY_VEC3:
+    case GN::MULTIPLY_INT:
+        if (s_isSplat(in[0], 1.0f)) return &in[1];
+        if (s_isSplat(in[1], 1.0f)) return &in[0];
+        return nullptr;
+    case GN::DIVIDE_FLOAT:
+    case GN::DIVIDE_VEC3:
+    case GN::DIVIDE_INT:
+        return s_isSplat(in[1], 1.0f) ? &in[0] : nullptr;
+    default:
+        return nullptr;
+    }
+}
+
+/**
+ * @brief Add a value to the pass, or return the existing one when the graph already computes it
  */
-static std::string s_emitNodeExpr(const GraphContext &ctx, const NodeDefinition &def, const GraphNode &node,
-                                  const GraphSlotMapping &mapping, const EmittedMap &emitted, std::string_view templateStr)
+static PassOperand s_intern(PassBuilder &builder, PinType type, std::string expr)
 {
-    std::string expr(templateStr);
+    std::string key = std::string(graph_pinTypeGlsl(type)) + " " + expr;
+    auto it = builder.byExpr.find(key);
+    if (it != builder.byExpr.end()) {
+        return {type, s_valueRef(it->second), std::nullopt};
+    }
+
+    CompiledValue value;
+    value.type = type;
+    value.operands = s_collectOperands(expr);
+    for (uint32_t operand : value.operands) {
+        value.cost = std::min(value.cost + builder.values[operand].cost, MAX_VALUE_COST);
+    }
+    value.expr = std::move(expr);
+
+    uint32_t index = static_cast<uint32_t>(builder.values.size());
+    builder.values.push_back(std::move(value));
+    builder.byExpr.emplace(std::move(key), index);
+    return {type, s_valueRef(index), std::nullopt};
+}
+
+/**
+ * @brief One node output: folded to a literal, forwarded from an input, or a new value of the pass
+ */
+static PassOperand s_emitOutput(const GraphContext &ctx, const NodeDefinition &def, uint32_t pin,
+                                const std::vector<PassOperand> &inputs, bool allConstant, std::string_view exprTemplate,
+                                PassBuilder &builder)
+{
+    PinType type = def.outputs[pin].type;
+
+    PinValue folded;
+    if (allConstant && !inputs.empty() && s_foldNode(def.type, pin, inputs, folded)) {
+        ++builder.folded;
+        return {type, s_literal(folded, type), folded};
+    }
+    if (const PassOperand *same = s_identityOperand(def.type, inputs); same != nullptr && same->type == type) {
+        ++builder.folded;
+        return *same;
+    }
+    // A template that is just one input, like a constant node's, forwards it rather than copying it to a local
+    for (uint32_t i = 0; i < def.inputs.size(); ++i) {
+        if (inputs[i].type == type && exprTemplate == "{" + def.inputs[i].name + "}") {
+            return inputs[i];
+        }
+    }
+
+    std::string expr(exprTemplate);
     for (uint32_t i = 0; i < def.inputs.size(); ++i) {
-        s_replaceAll(expr, "{" + def.inputs[i].name + "}", s_resolveInput(ctx, mapping, emitted, node.id, def.inputs[i], i));
+        s_replaceAll(expr, "{" + def.inputs[i].name + "}", inputs[i].expr);
     }
     Graph_substituteDomainInputs(expr, ctx.domain);
-    return expr;
+    return s_intern(builder, type, std::move(expr));
 }
 
 /**
- * @brief Emit one local per live node output, in dependency order, into emitted
+ * @brief Emit every live node output, in dependency order, into the pass and emitted
  */
-static std::string s_emitLocals(const GraphContext &ctx, const std::vector<uint32_t> &order, const GraphSlotMapping &mapping,
-                                EmittedMap &emitted)
+static void s_emitValues(const GraphContext &ctx, const std::vector<uint32_t> &order, const GraphSlotMapping &mapping,
+                         PassBuilder &builder, EmittedMap &emitted)
 {
-    std::string body;
-    uint32_t counter = 0;
+    std::vector<PassOperand> inputs;
     for (uint32_t nodeId : order) {
         if (nodeId == ctx.sink.id) continue;
         const GraphNode *node = ctx.node(nodeId);
         const NodeDefinition *def = ctx.defById.at(nodeId);
         bool multiOutput = def->outputs.size() > 1;
 
+        inputs.clear();
+        bool allConstant = true;
+        for (uint32_t i = 0; i < def->inputs.size(); ++i) {
+            inputs.push_back(s_resolveInput(ctx, mapping, emitted, node->id, def->inputs[i], i));
+            allConstant = allConstant && inputs.back().constant.has_value();
+        }
+
         for (uint32_t pin = 0; pin < def->outputs.size(); ++pin) {
             if (ctx.usedOutputs.count(Graph_pinKey(nodeId, pin)) == 0) continue;
             const PinDef &outPin = def->outputs[pin];
-            std::string_view exprTemplate = multiOutput ? std::string_view(outPin.glslTemplate) : std::string_view(def->glslTemplate);
-            std::string var = "_n" + std::to_string(counter++);
-
-            std::string expr = s_emitNodeExpr(ctx, *def, *node, mapping, emitted, exprTemplate);
-            body += std::string(graph_pinTypeGlsl(outPin.type)) + " " + var + "=" + expr + ";\n";
-            emitted[Graph_pinKey(nodeId, pin)] = {std::move(var), outPin.type};
+            std::string_view exprTemplate =
+                multiOutput ? std::string_view(outPin.glslTemplate) : std::string_view(def->glslTemplate);
+            emitted[Graph_pinKey(nodeId, pin)] = s_emitOutput(ctx, *def, pin, inputs, allConstant, exprTemplate, builder);
         }
     }
-    return body;
 }
 
 /**
@@ -518,7 +939,7 @@ static std::string s_emitFieldValue(const GraphContext &ctx, const GraphOutputFi
     if (const GraphConnection *wire = ctx.wireInto(ctx.sink.id, pin)) {
         auto it = emitted.find(Graph_pinKey(wire->srcNode, wire->srcPin));
         if (it != emitted.end()) {
-            return s_coerce(it->second.var, it->second.type, field.type);
+            return s_coerce(it->second.expr, it->second.type, field.type);
         }
     }
 
@@ -548,30 +969,103 @@ static std::vector<uint32_t> s_passRoots(const GraphContext &ctx, const GraphPas
 }
 
 /**
- * @brief Compile one pass to its GLSL function: DCE from the pass roots, locals, then field writes
+ * @brief Drop the values no field reaches any more, e.g. ones a folded or forwarded node left behind
+ */
+static void s_pruneValues(CompiledFunction &function)
+{
+    std::vector<uint8_t> live(function.values.size(), 0);
+    std::vector<uint32_t> stack;
+    for (const auto &field : function.fields) {
+        stack.insert(stack.end(), field.operands.begin(), field.operands.end());
+    }
+    while (!stack.empty()) {
+        uint32_t index = stack.back();
+        stack.pop_back();
+        if (live[index] != 0) continue;
+        live[index] = 1;
+        stack.insert(stack.end(), function.values[index].operands.begin(), function.values[index].operands.end());
+    }
+
+    std::vector<uint32_t> remap(function.values.size(), UINT32_MAX);
+    auto renumber = [&](CompiledValue &value) {
+        std::string expr;
+        s_scanRefs(value.expr, [&](std::string_view text) { expr += text; },
+                   [&](uint32_t index) { expr += s_valueRef(remap[index]); });
+        value.expr = std::move(expr);
+        for (uint32_t &operand : value.operands) {
+            operand = remap[operand];
+        }
+    };
+
+    std::vector<CompiledValue> values;
+    for (uint32_t i = 0; i < function.values.size(); ++i) {
+        if (live[i] == 0) continue;
+        remap[i] = static_cast<uint32_t>(values.size());
+        renumber(function.values[i]);
+        values.push_back(std::move(function.values[i]));
+    }
+    for (auto &field : function.fields) {
+        renumber(field);
+    }
+    function.values = std::move(values);
+}
+
+/**
+ * @brief Compile one pass: DCE from the pass roots, folded and hash-consed values, then field writes
  */
 static CompiledFunction s_emitPass(const GraphContext &ctx, const GraphPass &pass, size_t passIndex,
-                                   const std::string &name, const GraphSlotMapping &mapping)
+                                   const std::string &name, const GraphSlotMapping &mapping, uint32_t &folded)
 {
     std::vector<uint32_t> order;
     s_topoSort(ctx, s_passRoots(ctx, pass), order);
 
+    PassBuilder builder;
     EmittedMap emitted;
-    std::string body = s_emitLocals(ctx, order, mapping, emitted);
-    for (const auto &field : pass.fields) {
-        body += "surf." + std::string(field.name) + "=" + s_emitFieldValue(ctx, field, mapping, emitted) + ";\n";
-    }
+    s_emitValues(ctx, order, mapping, builder, emitted);
 
     CompiledFunction function;
     function.passIndex = passIndex;
     function.functionName = std::string(pass.funcPrefix) + name;
-    function.glslFunction = std::string(pass.structName) + " " + function.functionName + "(" +
-                            std::string(ctx.domain.inputStructName) + " si, uint base){\n" + std::string(pass.structName) +
-                            " surf;\n" + body + "return surf;\n}\n";
+    for (const auto &field : pass.fields) {
+        CompiledValue write;
+        write.type = field.type;
+        write.expr = s_emitFieldValue(ctx, field, mapping, emitted);
+        write.operands = s_collectOperands(write.expr);
+        function.fields.push_back(std::move(write));
+    }
+    function.values = std::move(builder.values);
+    s_pruneValues(function);
+
+    function.body = s_renderBody(function, pass, nullptr, nullptr);
+    folded += builder.folded;
     return function;
 }
 
-CompileResult MaterialGraphCompiler::compile(const MaterialGraph &graph, uint32_t graphId)
+// graphId keeps the function name unique even when two graphs share a sanitized name
+static std::string s_functionBaseName(const MaterialGraph &graph, uint32_t graphId)
+{
+    return s_sanitizeName(graph.name) + "_" + std::to_string(graphId);
+}
+
+/**
+ * @brief Hash of everything that decides a graph's compile result, equal for a graph saved and loaded again
+ */
+static uint64_t s_contentHash(const MaterialGraph &graph)
+{
+    std::vector<uint8_t> blob = graph.serialize();
+    uint64_t hash = s_hashBytes(std::string_view(reinterpret_cast<const char *>(blob.data()), blob.size()), FNV_OFFSET);
+
+    // the blob names textures by handle, while the compiled slice holds their bindless index
+    for (const auto &node : graph.nodes) {
+        for (const auto &texture : node.inputTextures) {
+            uint32_t index = texture ? texture->getBindlessIndex() : UINT32_MAX;
+            hash = s_hashBytes(std::string_view(reinterpret_cast<const char *>(&index), sizeof(index)), hash);
+        }
+    }
+    return hash;
+}
+
+static CompileResult s_compileGraph(const MaterialGraph &graph, uint32_t graphId)
 {
     CompileResult result;
     result.graphId = graphId;
@@ -606,11 +1100,18 @@ CompileResult MaterialGraphCompiler::compile(const MaterialGraph &graph, uint32_
     }
     result.domainId = domain->id;
 
+    using Clock = std::chrono::steady_clock;
+    auto elapsedMs = [](Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    };
+
+    auto start = Clock::now();
     GraphContext ctx{graph, *domain, *sink, *sinkDef};
     s_buildContext(ctx);
 
     s_validate(ctx, result.diagnostics);
     if (result.hasErrors()) return result;
+    auto validated = Clock::now();
 
     // The full order from the sink drives dead-node reporting and the slice layout shared by passes
     std::vector<uint32_t> fullOrder;
@@ -619,17 +1120,150 @@ CompileResult MaterialGraphCompiler::compile(const MaterialGraph &graph, uint32_
         return result;
     }
     s_reportDeadNodes(ctx, fullOrder, result.diagnostics);
-    s_assignResources(ctx, fullOrder, result.defaults, result.mapping, result.textureRefs);
+    auto eliminated = Clock::now();
 
-    // graphId keeps the function name unique even when two graphs share a sanitized name
-    std::string name = s_sanitizeName(graph.name) + "_" + std::to_string(graphId);
+    s_assignResources(ctx, fullOrder, result.defaults, result.mapping, result.textureRefs);
+    auto laidOut = Clock::now();
 
+    std::string name = s_functionBaseName(graph, graphId);
     for (size_t passIndex = 0; passIndex < domain->passes.size(); ++passIndex) {
-        result.functions.push_back(s_emitPass(ctx, domain->passes[passIndex], passIndex, name, result.mapping));
+        result.functions.push_back(
+            s_emitPass(ctx, domain->passes[passIndex], passIndex, name, result.mapping, result.foldedValues));
     }
+    auto emitted = Clock::now();
+
+    result.stats.liveNodes = static_cast<uint32_t>(fullOrder.size());
+    result.stats.deadNodes = static_cast<uint32_t>(graph.nodes.size() - fullOrder.size());
+    result.stats.slotCount = static_cast<uint32_t>(result.mapping.slots.size());
+    result.stats.validateMs = elapsedMs(start, validated);
+    result.stats.eliminateMs = elapsedMs(validated, eliminated);
+    result.stats.layoutMs = elapsedMs(eliminated, laidOut);
+    result.stats.emitMs = elapsedMs(laidOut, emitted);
 
     result.success = true;
     return result;
 }
 
+CompileResult MaterialGraphCompiler::compile(const MaterialGraph &graph, uint32_t graphId)
+{
+    uint64_t contentHash = s_contentHash(graph);
+
+    auto cached = m_cache.find(contentHash);
+    if (cached != m_cache.end()) {
+        ++m_cacheHits;
+        CompileResult result = cached->second;
+        result.graphId = graphId;
+        // the timings belong to the compile that filled the cache, this one did no such work
+        result.stats.validateMs = result.stats.eliminateMs = result.stats.layoutMs = result.stats.emitMs = 0.0;
+
+        // only the names carry the id, the code and the slice layout do not depend on it
+        const GraphDomain *domain = GraphDomainRegistry::forId(result.domainId);
+        std::string name = s_functionBaseName(graph, graphId);
+        for (auto &function : result.functions) {
+            function.functionName = std::string(domain->passes[function.passIndex].funcPrefix) + name;
+        }
+        return result;
+    }
+
+    ++m_cacheMisses;
+    CompileResult result = s_compileGraph(graph, graphId);
+    if (result.success) {
+        // a cached result holds its textures, so the cache is bounded rather than kept for the session
+        if (m_cache.size() >= MAX_CACHED_GRAPHS) {
+            m_cache.clear();
+        }
+        m_cache.emplace(contentHash, result);
+    }
+    return result;
+}
+
+void MaterialGraphCompiler::clearCache()
+{
+    m_cache.clear();
+}
+
+LinkedPass MaterialGraphCompiler::link(std::span<const CompileResult *const> graphs, const GraphDomain &domain, size_t passIndex,
+                                       bool shareCode)
+{
+    LinkedPass linked;
+    if (passIndex >= domain.passes.size()) {
+        return linked;
+    }
+    const GraphPass &pass = domain.passes[passIndex];
+
+    // Graphs with equal bodies, e.g. instances of one template with different authored values, call one function
+    std::vector<const CompiledFunction *> distinct;
+    std::unordered_map<std::string_view, const CompiledFunction *> byBody;
+    for (const CompileResult *graph : graphs) {
+        if (graph == nullptr || graph->domainId != domain.id || passIndex >= graph->functions.size()) {
+            continue;
+        }
+        const CompiledFunction &function = graph->functions[passIndex];
+        ++linked.stats.graphCount;
+        std::string standalone = s_renderFunction(pass.structName, function.functionName, domain, function.body);
+        linked.stats.standaloneBytes += standalone.size();
+
+        if (!shareCode) {
+            linked.code += standalone + "\n";
+            linked.dispatch.emplace_back(graph->graphId, function.functionName);
+            continue;
+        }
+
+        auto [it, inserted] = byBody.emplace(function.body, &function);
+        if (inserted) {
+            distinct.push_back(&function);
+        }
+        linked.dispatch.emplace_back(graph->graphId, it->second->functionName);
+    }
+
+    if (!shareCode) {
+        linked.stats.functionCount = linked.stats.graphCount;
+        linked.stats.linkedBytes = linked.code.size();
+        return linked;
+    }
+
+    // A subtree becomes a helper once two distinct functions compute it and it is big enough to pay for a call
+    const std::vector<std::vector<uint32_t>> shapes = s_internShapes(distinct);
+    std::unordered_map<uint32_t, uint32_t> users;
+    for (size_t f = 0; f < distinct.size(); ++f) {
+        std::unordered_set<uint32_t> seen;
+        for (uint32_t i = 0; i < distinct[f]->values.size(); ++i) {
+            if (distinct[f]->values[i].cost >= MIN_SHARED_COST && seen.insert(shapes[f][i]).second) {
+                ++users[shapes[f][i]];
+            }
+        }
+    }
+
+    // Emitted in value order, so a helper's nested shared subtrees always precede it
+    SharedHelpers helpers;
+    std::vector<std::string> names;
+    for (size_t f = 0; f < distinct.size(); ++f) {
+        const CompiledFunction *function = distinct[f];
+        for (uint32_t i = 0; i < function->values.size(); ++i) {
+            const CompiledValue &value = function->values[i];
+            const uint32_t shape = shapes[f][i];
+            if (value.cost < MIN_SHARED_COST || users[shape] < 2 || helpers.count(shape) != 0) {
+                continue;
+            }
+
+            std::string helperName = "graphShared_" + std::to_string(helpers.size());
+            std::string body = s_renderLocals(function->values, {i}, &helpers, &shapes[f], i, names);
+            body += "return " + names[i] + ";\n";
+            linked.code += s_renderFunction(graph_pinTypeGlsl(value.type), helperName, domain, body) + "\n";
+            helpers.emplace(shape, std::move(helperName));
+        }
+    }
+
+    for (size_t f = 0; f < distinct.size(); ++f) {
+        const CompiledFunction *function = distinct[f];
+        std::string body = s_renderBody(*function, pass, &helpers, &shapes[f]);
+        linked.code += s_renderFunction(pass.structName, function->functionName, domain, body) + "\n";
+    }
+
+    linked.stats.functionCount = static_cast<uint32_t>(distinct.size());
+    linked.stats.sharedHelperCount = static_cast<uint32_t>(helpers.size());
+    linked.stats.linkedBytes = linked.code.size();
+    return linked;
+}
+
 } // namespace Rapture
@@ -3,8 +3,10 @@
 
 #include "assets/asset_manager/AssetHandle.h"
 #include <cstdint>
+#include <span>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "GraphDomain.h"
@@ -18,7 +20,7 @@ namespace Rapture {
  *
  * Stamped into the generated file so stale or incompatible output can be detected.
  */
-constexpr uint32_t MATERIAL_GRAPH_COMPILER_VERSION = 4;
+constexpr uint32_t MATERIAL_GRAPH_COMPILER_VERSION = 5;
 
 /**
  * @brief Severity of a compile diagnostic, ordered least to most severe
@@ -70,12 +72,60 @@ struct GraphSlotMapping {
 };
 
 /**
- * @brief One compiled pass of a graph: which pass it fills and its GLSL function
+ * @brief One local of a compiled pass, a node output after constant folding and hash-consing
+ *
+ * Values reference earlier values of the same pass as @index@ in their expression, which keeps the
+ * pass renderable both on its own and with subtrees shared between graphs pulled out into helpers.
+ */
+struct CompiledValue {
+    PinType type = PinType::FLOAT;
+    std::string expr;               // the GLSL right hand side, earlier values written as @index@
+    std::vector<uint32_t> operands; // the values expr references, all earlier in the pass
+    uint32_t cost = 1;              // nodes in the subtree, small ones are not worth a shared helper
+};
+
+/**
+ * @brief One compiled pass of a graph: which pass it fills, its locals and its field writes
  */
 struct CompiledFunction {
     size_t passIndex = 0; // index into the graph's domain passes
     std::string functionName;
-    std::string glslFunction;
+    std::vector<CompiledValue> values; // live locals in dependency order
+    std::vector<CompiledValue> fields; // one per pass field in field order, its value written into the struct
+    std::string body;                  // the function body on its own, graphs with equal bodies share one function
+};
+
+/**
+ * @brief What linking the graphs of one pass produced, to judge how much the sharing saved
+ */
+struct MaterialLinkStats {
+    uint32_t graphCount = 0;        // graphs of the domain linked into the pass
+    uint32_t functionCount = 0;     // distinct functions left once graphs with equal bodies merged
+    uint32_t sharedHelperCount = 0; // subtrees emitted once and called from several functions
+    size_t standaloneBytes = 0;     // GLSL of every graph's function on its own, without any sharing
+    size_t linkedBytes = 0;         // GLSL of the helpers and the distinct functions
+};
+
+/**
+ * @brief The graph functions of one pass file, ready to be written before its dispatcher
+ */
+struct LinkedPass {
+    std::string code;                                       // shared helpers, then every distinct function
+    std::vector<std::pair<uint32_t, std::string>> dispatch; // graphId -> the function its dispatcher case calls
+    MaterialLinkStats stats;
+};
+
+/**
+ * @brief How big a compiled graph was and where its compile time went, zero for a cached result's timings
+ */
+struct MaterialCompileStats {
+    uint32_t liveNodes = 0; // nodes reachable from the output
+    uint32_t deadNodes = 0; // nodes eliminated because nothing reads them
+    uint32_t slotCount = 0; // authored pins given a slot in the instance slice
+    double validateMs = 0.0;
+    double eliminateMs = 0.0; // ordering from the output and dropping what it does not reach
+    double layoutMs = 0.0;    // packing authored values into the slice layout
+    double emitMs = 0.0;      // every pass, folding and pruning included
 };
 
 /**
@@ -93,6 +143,9 @@ struct CompileResult {
     GraphSlotMapping mapping;
     std::vector<AssetPtr<Texture>> textureRefs; // holds every texture the slice references so it is not evicted
 
+    uint32_t foldedValues = 0; // node outputs folded to a literal or passed through instead of a local
+    MaterialCompileStats stats;
+
     /**
      * @brief Whether any diagnostic is an error
      * @return True if at least one ERROR diagnostic was recorded
@@ -108,6 +161,9 @@ struct CompileResult {
 
 /**
  * @brief Compiles a MaterialGraph into a straight-line GLSL surface function
+ *
+ * Successful results are cached by the graph's content hash, so recompiling an unchanged graph,
+ * under any id, costs a hash of its blob. link() then merges the graphs of a pass into one file.
  */
 class MaterialGraphCompiler {
   public:
@@ -118,6 +174,33 @@ class MaterialGraphCompiler {
      * @return The compile result; check success, and diagnostics for messages
      */
     CompileResult compile(const MaterialGraph &graph, uint32_t graphId);
+
+    /**
+     * @brief Emit the functions of one pass for a batch of compiled graphs
+     *
+     * Graphs whose functions have equal bodies share one function, and subtrees that several
+     * distinct functions compute are emitted once as helpers they all call.
+     * @param graphs The compiled graphs, ones of other domains are skipped
+     * @param domain The domain owning the pass
+     * @param passIndex The pass to emit
+     * @param shareCode False to emit every graph's function on its own, as before linking existed
+     * @return The helpers and functions, the dispatcher case of every graph, and the size saved
+     */
+    static LinkedPass link(std::span<const CompileResult *const> graphs, const GraphDomain &domain, size_t passIndex,
+                           bool shareCode = true);
+
+    /**
+     * @brief Drop every cached result, and the textures they hold on to
+     */
+    void clearCache();
+
+    uint32_t getCacheHits() const { return m_cacheHits; }
+    uint32_t getCacheMisses() const { return m_cacheMisses; }
+
+  private:
+    std::unordered_map<uint64_t, CompileResult> m_cache; // graph content hash -> its result
+    uint32_t m_cacheHits = 0;
+    uint32_t m_cacheMisses = 0;
 };
 
 } // namespace Rapture
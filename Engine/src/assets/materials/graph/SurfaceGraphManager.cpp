@@ -1,15 +1,16 @@
 #include "SurfaceGraphManager.h"
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <string_view>
 #include <unordered_set>
+#include <vector>
 
 #include "GraphDomain.h"
 #include "MaterialGraphTypes.h"
 #include "core/events/ShaderEvents.h"
 #include "core/utils/Log.h"
-#include "app/Application.h"
 
 namespace Rapture {
 
@@ -83,15 +84,16 @@ static std::string s_fieldFallback(const GraphOutputField &field, const GraphDom
 }
 
 /**
- * @brief Build the generated file for one pass: its struct, every graph's function, and the dispatcher
+ * @brief Build the generated file for one pass: its struct, the linked graph functions, and the dispatcher
  * @param graphs The registered graphs
  * @param domain The domain owning this pass
  * @param pass The pass to emit
  * @param passIndex The pass index, selecting each graph's function
+ * @param shareCode Whether graphs share functions and helpers, see MaterialGraphCompiler::link
  * @return The file contents
  */
 static std::string s_emitPassFile(const std::vector<CompileResult> &graphs, const GraphDomain &domain, const GraphPass &pass,
-                                  size_t passIndex)
+                                  size_t passIndex, bool shareCode)
 {
     std::string out;
     out += "/**\n";
@@ -110,21 +112,35 @@ static std::string s_emitPassFile(const std::vector<CompileResult> &graphs, cons
     }
     out += "};\n\n";
 
+    std::vector<const CompileResult *> linkable;
+    linkable.reserve(graphs.size());
     for (const auto &graph : graphs) {
-        if (graph.domainId == domain.id && passIndex < graph.functions.size()) {
-            out += graph.functions[passIndex].glslFunction;
-            out += "\n";
-        }
+        linkable.push_back(&graph);
+    }
+    LinkedPass linked = MaterialGraphCompiler::link(linkable, domain, passIndex, shareCode);
+    out += linked.code;
+
+    if (linked.stats.graphCount > 0) {
+        RP_CORE_INFO("Linked {} surface graph(s) into '{}': {} function(s), {} shared helper(s), {} -> {} bytes",
+                     linked.stats.graphCount, pass.fileName, linked.stats.functionCount, linked.stats.sharedHelperCount,
+                     linked.stats.standaloneBytes, linked.stats.linkedBytes);
     }
 
+    // Graphs sharing a function share its case, so the switch stays as small as the function list
+    std::stable_sort(linked.dispatch.begin(), linked.dispatch.end(),
+                     [](const auto &a, const auto &b) { return a.second < b.second; });
+
     out += std::string(pass.structName) + " " + std::string(pass.dispatcherName) + "(uint graphId, " +
            std::string(domain.inputStructName) + " si, uint base) {\n";
     out += "    switch (graphId) {\n";
-    for (const auto &graph : graphs) {
-        if (graph.domainId == domain.id && passIndex < graph.functions.size()) {
-            out += "        case " + std::to_string(graph.graphId) + "u: return " + graph.functions[passIndex].functionName +
-                   "(si, base);\n";
+    for (size_t i = 0; i < linked.dispatch.size(); ++i) {
+        const auto &[graphId, functionName] = linked.dispatch[i];
+        out += "        case " + std::to_string(graphId) + "u:";
+        if (i + 1 < linked.dispatch.size() && linked.dispatch[i + 1].second == functionName) {
+            out += "\n";
+            continue;
         }
+        out += " return " + functionName + "(si, base);\n";
     }
     out += "    }\n\n";
     out += "    " + std::string(pass.structName) + " surf;\n";
@@ -154,7 +170,7 @@ bool SurfaceGraphManager::writeGeneratedFiles(const std::filesystem::path &direc
     for (const auto &domain : GraphDomainRegistry::all()) {
         for (size_t passIndex = 0; passIndex < domain.passes.size(); ++passIndex) {
             const GraphPass &pass = domain.passes[passIndex];
-            std::string content = s_emitPassFile(m_graphs, domain, pass, passIndex);
+            std::string content = s_emitPassFile(m_graphs, domain, pass, passIndex, m_shareCode);
             ok = s_writeFile(directory / std::string(pass.fileName), content) && ok;
         }
     }
@@ -163,8 +179,6 @@ bool SurfaceGraphManager::writeGeneratedFiles(const std::filesystem::path &direc
 
 void SurfaceGraphManager::notifyShadersOfRegeneration() const
 {
-    Application::getInstance().getVulkanContext().waitIdle();
-
     std::unordered_set<std::string_view> fired;
     for (const auto &domain : GraphDomainRegistry::all()) {
         for (const GraphPass &pass : domain.passes) {
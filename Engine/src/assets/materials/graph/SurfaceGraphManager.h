@@ -42,8 +42,17 @@ class SurfaceGraphManager {
      */
     bool writeGeneratedFiles(const std::filesystem::path &directory);
 
+    /**
+     * @brief Whether generated files merge equal graph functions and share common subtrees, on by default
+     *
+     * Off, every graph keeps its own self-contained function, which is easier to read when debugging a graph.
+     */
+    void setCodeSharing(bool enabled) { m_shareCode = enabled; }
+
     /**
      * @brief Fire a source-changed event for every generated pass file so dependent shaders reload
+     *
+     * The rebuild runs in the background and is swapped in by ShaderHotReload at a frame boundary.
      */
     void notifyShadersOfRegeneration() const;
 
@@ -71,6 +80,7 @@ class SurfaceGraphManager {
   private:
     std::vector<CompileResult> m_graphs;
     MaterialGraphCompiler m_compiler;
+    bool m_shareCode = true;
 };
 
 } // namespace Rapture
@@ -39,6 +39,24 @@ SkeletalMesh::SkeletalMesh(MeshAllocatorParams &params, AssetHandle skeleton, st
     if (m_skeleton == INVALID_ASSET_HANDLE) {
         RP_CORE_ERROR("skeletal mesh is bound to no skeleton");
     }
+
+    // a joint's bind transform is the inverse of its inverse bind matrix, its position the translation
+    for (const glm::mat4 &inverseBind : m_inverseBindMatrices) {
+        const glm::vec3 joint = glm::vec3(glm::inverse(inverseBind)[3]);
+        m_jointsMin = glm::min(m_jointsMin, joint);
+        m_jointsMax = glm::max(m_jointsMax, joint);
+    }
+}
+
+void SkeletalMesh::getPoseBounds(glm::vec3 &min, glm::vec3 &max) const
+{
+    const glm::vec3 low = glm::min(getBoundsMin(), m_jointsMin);
+    const glm::vec3 high = glm::max(getBoundsMax(), m_jointsMax);
+    const glm::vec3 center = (low + high) * 0.5f;
+    const float radius = glm::length(high - center);
+
+    min = center - glm::vec3(radius);
+    max = center + glm::vec3(radius);
 }
 
 static std::vector<uint8_t> s_wrapGeometry(const std::vector<uint8_t> &geometry, AssetHandle skeleton,
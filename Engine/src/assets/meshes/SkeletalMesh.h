@@ -4,6 +4,8 @@
 #include "assets/asset_manager/AssetCommon.h"
 #include "assets/meshes/Mesh.h"
 
+#include <cfloat>
+
 namespace Rapture {
 
 /**
@@ -29,6 +31,17 @@ class SkeletalMesh : public Mesh {
 
     uint32_t getJointCount() const { return static_cast<uint32_t>(m_inverseBindMatrices.size()); }
 
+    /**
+     * @brief Mesh space bounds that hold the mesh posed, not just as it was bound
+     *
+     * The bind pose box and every joint's bind position, grown to the cube around the sphere that holds
+     * them, so limbs swung out of the rest pose about the mesh's centre stay inside. Culling reads these,
+     * a pose that carries the whole mesh further than that is not covered.
+     * @param min Filled with the corner with the smallest coordinates
+     * @param max Filled with the corner with the largest coordinates
+     */
+    void getPoseBounds(glm::vec3 &min, glm::vec3 &max) const;
+
     /**
      * @brief Serializes this mesh, reading its geometry back off the GPU
      * @return The serialized bytes, empty if this mesh holds no geometry
@@ -55,6 +68,10 @@ class SkeletalMesh : public Mesh {
   private:
     AssetHandle m_skeleton = INVALID_ASSET_HANDLE;
     std::vector<glm::mat4> m_inverseBindMatrices;
+
+    // the box around every joint's bind position, empty while there are no joints
+    glm::vec3 m_jointsMin = glm::vec3(FLT_MAX);
+    glm::vec3 m_jointsMax = glm::vec3(-FLT_MAX);
 };
 
 } // namespace Rapture
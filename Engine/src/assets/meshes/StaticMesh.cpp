@@ -1,8 +1,12 @@
 #include "StaticMesh.h"
 
 #include "assets/asset_manager/AssetCommon.h"
+#include "core/utils/GLTypes.h"
 #include "core/utils/Log.h"
+#include "physics/ShapeCooking.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 
 namespace Rapture {
@@ -12,7 +16,7 @@ static constexpr uint32_t STATIC_MESH_MAGIC = Asset_fourCC("STMH");
 // Major in the high 16 bits, minor in the low 16. A backward-compatible change bumps minor, a
 // breaking one bumps major. Readers reject a different major and warn on a different minor.
 static constexpr uint16_t STATIC_MESH_VERSION_MAJOR = 1;
-static constexpr uint16_t STATIC_MESH_VERSION_MINOR = 0;
+static constexpr uint16_t STATIC_MESH_VERSION_MINOR = 1; // 1: cooked collision after the geometry
 static constexpr uint32_t STATIC_MESH_VERSION =
     (static_cast<uint32_t>(STATIC_MESH_VERSION_MAJOR) << 16) | STATIC_MESH_VERSION_MINOR;
 
@@ -20,11 +24,24 @@ struct StaticMeshBlobHeader {
     uint32_t magic = STATIC_MESH_MAGIC;
     uint32_t version = STATIC_MESH_VERSION;
     uint32_t geometryOffset = 0;
-    uint32_t reserved[5] = {}; // pad to 32 bytes, consume for backward-compatible additions
+    uint32_t collisionOffset = 0; // 0 when no collision was cooked, as in every minor 0 blob
+    uint32_t collisionSize = 0;
+    uint32_t reserved[3] = {}; // pad to 32 bytes, consume for backward-compatible additions
 };
 
 static_assert(sizeof(StaticMeshBlobHeader) == 32, "static mesh blob header is a fixed 32-byte directory");
 
+// The cooked shapes follow this header in the order it lists them, each 0 bytes when not cooked.
+struct StaticMeshCollisionHeader {
+    uint32_t meshSize = 0;
+    uint32_t convexHullSize = 0;
+    uint32_t heightFieldSize = 0;
+    uint32_t reserved = 0;
+};
+
+// How far a vertex may sit off a grid line, relative to the spacing, and still be read as a height sample
+static constexpr float HEIGHT_FIELD_GRID_TOLERANCE = 1e-3f;
+
 StaticMesh::StaticMesh(MeshAllocatorParams &params) : Mesh(params)
 {
     for (const BufferAttribute &attrib : params.bufferLayout.buffer_attribs) {
@@ -36,30 +53,256 @@ StaticMesh::StaticMesh(MeshAllocatorParams &params) : Mesh(params)
     }
 }
 
-static std::vector<uint8_t> s_wrapGeometry(const std::vector<uint8_t> &geometry)
+static uint32_t s_cookedSize(const std::shared_ptr<const physics::CookedShape> &cooked)
+{
+    return cooked != nullptr ? static_cast<uint32_t>(cooked->bytes.size()) : 0;
+}
+
+static void s_appendCooked(std::vector<uint8_t> &blob, size_t &offset, const std::shared_ptr<const physics::CookedShape> &cooked)
+{
+    if (cooked == nullptr || cooked->bytes.empty()) {
+        return;
+    }
+    std::memcpy(blob.data() + offset, cooked->bytes.data(), cooked->bytes.size());
+    offset += cooked->bytes.size();
+}
+
+static std::vector<uint8_t> s_wrapGeometry(const std::vector<uint8_t> &geometry, const physics::CookedCollision &collision)
 {
     if (geometry.empty()) {
         return {};
     }
 
+    StaticMeshCollisionHeader collisionHeader;
+    collisionHeader.meshSize = s_cookedSize(collision.mesh);
+    collisionHeader.convexHullSize = s_cookedSize(collision.convexHull);
+    collisionHeader.heightFieldSize = s_cookedSize(collision.heightField);
+    const uint32_t cookedSize = collisionHeader.meshSize + collisionHeader.convexHullSize + collisionHeader.heightFieldSize;
+
     StaticMeshBlobHeader header;
     header.geometryOffset = sizeof(StaticMeshBlobHeader);
+    if (cookedSize != 0) {
+        header.collisionOffset = header.geometryOffset + static_cast<uint32_t>(geometry.size());
+        header.collisionSize = sizeof(StaticMeshCollisionHeader) + cookedSize;
+    }
 
-    std::vector<uint8_t> blob(header.geometryOffset + geometry.size());
+    std::vector<uint8_t> blob(header.geometryOffset + geometry.size() + header.collisionSize);
     std::memcpy(blob.data(), &header, sizeof(StaticMeshBlobHeader));
     std::memcpy(blob.data() + header.geometryOffset, geometry.data(), geometry.size());
 
+    if (cookedSize != 0) {
+        size_t offset = header.collisionOffset;
+        std::memcpy(blob.data() + offset, &collisionHeader, sizeof(StaticMeshCollisionHeader));
+        offset += sizeof(StaticMeshCollisionHeader);
+        s_appendCooked(blob, offset, collision.mesh);
+        s_appendCooked(blob, offset, collision.convexHull);
+        s_appendCooked(blob, offset, collision.heightField);
+    }
+
     return blob;
 }
 
+static std::shared_ptr<const physics::CookedShape> s_readCooked(std::span<const uint8_t> section, size_t &offset, uint32_t size)
+{
+    if (size == 0) {
+        return nullptr;
+    }
+    auto cooked = std::make_shared<physics::CookedShape>();
+    cooked->bytes.assign(section.begin() + offset, section.begin() + offset + size);
+    offset += size;
+    return cooked;
+}
+
+static bool s_readCollision(std::span<const uint8_t> section, physics::CookedCollision &outCollision)
+{
+    if (section.size() < sizeof(StaticMeshCollisionHeader)) {
+        RP_CORE_ERROR("static mesh blob collision is smaller than its header");
+        return false;
+    }
+
+    StaticMeshCollisionHeader header;
+    std::memcpy(&header, section.data(), sizeof(StaticMeshCollisionHeader));
+
+    const uint64_t cookedSize = static_cast<uint64_t>(header.meshSize) + header.convexHullSize + header.heightFieldSize;
+    if (sizeof(StaticMeshCollisionHeader) + cookedSize > section.size()) {
+        RP_CORE_ERROR("static mesh blob collision runs past its end");
+        return false;
+    }
+
+    size_t offset = sizeof(StaticMeshCollisionHeader);
+    outCollision.mesh = s_readCooked(section, offset, header.meshSize);
+    outCollision.convexHull = s_readCooked(section, offset, header.convexHullSize);
+    outCollision.heightField = s_readCooked(section, offset, header.heightFieldSize);
+    return true;
+}
+
 std::vector<uint8_t> StaticMesh::serialize() const
 {
-    return s_wrapGeometry(serializeGeometry());
+    return s_wrapGeometry(serializeGeometry(), m_collision);
+}
+
+std::vector<uint8_t> StaticMesh::serializeParams(const MeshAllocatorParams &params, const physics::CookedCollision &collision)
+{
+    return s_wrapGeometry(params.serialize(), collision);
+}
+
+/**
+ * @brief Copies the float positions out of mesh data, interleaved or not
+ * @return False if the mesh data carries no float vec3 positions
+ */
+static bool s_readPositions(const MeshAllocatorParams &params, std::vector<glm::vec3> &outPositions)
+{
+    const BufferLayout &layout = params.bufferLayout;
+    const BufferAttribute *position = nullptr;
+    uint32_t vertexSize = 0;
+    for (const BufferAttribute &attrib : layout.buffer_attribs) {
+        vertexSize += attrib.getSizeInBytes();
+        if (attrib.name == BufferAttributeID::POSITION) {
+            position = &attrib;
+        }
+    }
+
+    if (position == nullptr || position->componentType != FLOAT_TYPE || position->type != "VEC3" || vertexSize == 0 ||
+        params.vertexData == nullptr) {
+        return false;
+    }
+
+    const uint32_t vertexCount = params.vertexDataSize / vertexSize;
+    const uint32_t stride = layout.isInterleaved ? vertexSize : static_cast<uint32_t>(sizeof(glm::vec3));
+    if (vertexCount == 0 || position->offset + static_cast<uint64_t>(vertexCount - 1) * stride + sizeof(glm::vec3) >
+                                params.vertexDataSize) {
+        return false;
+    }
+
+    const uint8_t *base = static_cast<const uint8_t *>(params.vertexData) + position->offset;
+    outPositions.resize(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; ++i) {
+        std::memcpy(&outPositions[i], base + static_cast<size_t>(i) * stride, sizeof(glm::vec3));
+    }
+    return true;
+}
+
+static void s_readIndices(const MeshAllocatorParams &params, std::vector<uint32_t> &outIndices)
+{
+    const uint32_t indexSize = (params.indexType == VK_INDEX_TYPE_UINT32) ? 4 : 2;
+    const uint32_t count = std::min(params.indexCount, params.indexData != nullptr ? params.indexDataSize / indexSize : 0);
+
+    outIndices.resize(count);
+    if (indexSize == 4) {
+        std::memcpy(outIndices.data(), params.indexData, static_cast<size_t>(count) * 4);
+        return;
+    }
+    const uint16_t *indices = static_cast<const uint16_t *>(params.indexData);
+    for (uint32_t i = 0; i < count; ++i) {
+        outIndices[i] = indices[i];
+    }
+}
+
+/**
+ * @brief Distinct values in order, those closer than the tolerance counted once
+ */
+static std::vector<float> s_distinct(std::vector<float> values, float tolerance)
+{
+    std::sort(values.begin(), values.end());
+    std::vector<float> distinct;
+    for (float value : values) {
+        if (distinct.empty() || value - distinct.back() > tolerance) {
+            distinct.push_back(value);
+        }
+    }
+    return distinct;
+}
+
+/**
+ * @brief Cooks a height field if every vertex is a sample of one square, evenly spaced grid in x and z
+ *
+ * Terrain exported as a mesh is a grid with one vertex per sample, or the same vertex repeated per
+ * triangle, so both are read. Anything else, a vertex off the grid or two heights in one cell, is
+ * left to the triangle mesh.
+ */
+static std::shared_ptr<const physics::CookedShape> s_cookHeightField(const std::vector<glm::vec3> &positions,
+                                                                     const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+{
+    const glm::vec3 extent = boundsMax - boundsMin;
+    const float looseTolerance = std::max(extent.x, extent.z) * HEIGHT_FIELD_GRID_TOLERANCE;
+
+    std::vector<float> xs(positions.size());
+    std::vector<float> zs(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        xs[i] = positions[i].x;
+        zs[i] = positions[i].z;
+    }
+    const size_t sampleCount = s_distinct(std::move(xs), looseTolerance).size();
+    if (sampleCount < 2 || sampleCount != s_distinct(std::move(zs), looseTolerance).size() ||
+        sampleCount * sampleCount > positions.size()) {
+        return nullptr;
+    }
+
+    const float spacingX = extent.x / static_cast<float>(sampleCount - 1);
+    const float spacingZ = extent.z / static_cast<float>(sampleCount - 1);
+    if (spacingX <= 0.0f || spacingZ <= 0.0f) {
+        return nullptr;
+    }
+
+    std::vector<float> heights(sampleCount * sampleCount, 0.0f);
+    std::vector<uint8_t> filled(sampleCount * sampleCount, 0);
+    for (const glm::vec3 &position : positions) {
+        const float gridX = (position.x - boundsMin.x) / spacingX;
+        const float gridZ = (position.z - boundsMin.z) / spacingZ;
+        const float cellX = std::round(gridX);
+        const float cellZ = std::round(gridZ);
+        if (std::abs(gridX - cellX) > HEIGHT_FIELD_GRID_TOLERANCE || std::abs(gridZ - cellZ) > HEIGHT_FIELD_GRID_TOLERANCE ||
+            cellX < 0.0f || cellZ < 0.0f || cellX >= static_cast<float>(sampleCount) || cellZ >= static_cast<float>(sampleCount)) {
+            return nullptr;
+        }
+
+        const size_t cell = static_cast<size_t>(cellZ) * sampleCount + static_cast<size_t>(cellX);
+        if (filled[cell] != 0 && heights[cell] != position.y) {
+            return nullptr;
+        }
+        heights[cell] = position.y;
+        filled[cell] = 1;
+    }
+
+    if (std::find(filled.begin(), filled.end(), 0) != filled.end()) {
+        return nullptr;
+    }
+
+    return physics::cookHeightFieldShape(heights, static_cast<uint32_t>(sampleCount), glm::vec3(boundsMin.x, 0.0f, boundsMin.z),
+                                         glm::vec3(spacingX, 1.0f, spacingZ));
 }
 
-std::vector<uint8_t> StaticMesh::serializeParams(const MeshAllocatorParams &params)
+physics::CookedCollision StaticMesh::cookCollision(const MeshAllocatorParams &params)
 {
-    return s_wrapGeometry(params.serialize());
+    physics::CookedCollision collision;
+
+    std::vector<glm::vec3> positions;
+    if (!s_readPositions(params, positions)) {
+        RP_CORE_WARN("static mesh carries no float positions to cook collision from");
+        return collision;
+    }
+
+    std::vector<uint32_t> indices;
+    s_readIndices(params, indices);
+
+    glm::vec3 boundsMin = positions.front();
+    glm::vec3 boundsMax = positions.front();
+    for (const glm::vec3 &position : positions) {
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+    }
+
+    if (!indices.empty()) {
+        collision.mesh = physics::cookMeshShape(positions, indices);
+    }
+    // flat geometry encloses no volume to make a hull of
+    const glm::vec3 extent = boundsMax - boundsMin;
+    if (extent.x > 0.0f && extent.y > 0.0f && extent.z > 0.0f) {
+        collision.convexHull = physics::cookConvexHullShape(positions);
+    }
+    collision.heightField = s_cookHeightField(positions, boundsMin, boundsMax);
+
+    return collision;
 }
 
 std::unique_ptr<StaticMesh> StaticMesh::deserialize(std::span<const uint8_t> blob)
@@ -91,12 +334,29 @@ std::unique_ptr<StaticMesh> StaticMesh::deserialize(std::span<const uint8_t> blo
         return nullptr;
     }
 
+    // a minor 0 blob carried nothing after its geometry and left these fields zero
+    physics::CookedCollision collision;
+    size_t geometryEnd = blob.size();
+    if (header.collisionOffset != 0) {
+        if (header.collisionOffset < header.geometryOffset ||
+            static_cast<uint64_t>(header.collisionOffset) + header.collisionSize > blob.size()) {
+            RP_CORE_ERROR("static mesh blob collision lies outside it");
+            return nullptr;
+        }
+        if (!s_readCollision(blob.subspan(header.collisionOffset, header.collisionSize), collision)) {
+            return nullptr;
+        }
+        geometryEnd = header.collisionOffset;
+    }
+
     MeshAllocatorParams params;
-    if (!MeshAllocatorParams::deserialize(blob.subspan(header.geometryOffset), params)) {
+    if (!MeshAllocatorParams::deserialize(blob.subspan(header.geometryOffset, geometryEnd - header.geometryOffset), params)) {
         return nullptr;
     }
 
-    return std::make_unique<StaticMesh>(params);
+    auto mesh = std::make_unique<StaticMesh>(params);
+    mesh->setCollision(collision);
+    return mesh;
 }
 
 } // namespace Rapture
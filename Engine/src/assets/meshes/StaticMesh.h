@@ -2,6 +2,7 @@
 #define RAPTURE__STATIC_MESH_H
 
 #include "assets/meshes/Mesh.h"
+#include "physics/Common.h"
 
 namespace Rapture {
 
@@ -22,9 +23,28 @@ class StaticMesh : public Mesh {
     /**
      * @brief Serializes mesh data that has not been uploaded yet, skipping the read back off the GPU
      * @param params The mesh data to write
+     * @param collision What the mesh was cooked into, written after its geometry
      * @return The serialized bytes
      */
-    static std::vector<uint8_t> serializeParams(const MeshAllocatorParams &params);
+    static std::vector<uint8_t> serializeParams(const MeshAllocatorParams &params, const physics::CookedCollision &collision = {});
+
+    /**
+     * @brief Cooks mesh data into the collision shapes bodies are built from
+     *
+     * Run once at import, as cooking a triangle mesh is far slower than reading the result back. A
+     * triangle mesh and a convex hull are always cooked, a height field only when the vertices lie
+     * on a square grid in x and z.
+     * @param params Mesh data still in memory, with float positions
+     * @return The cooked shapes, any of which is null when the geometry did not make it
+     */
+    static physics::CookedCollision cookCollision(const MeshAllocatorParams &params);
+
+    void setCollision(const physics::CookedCollision &collision) { m_collision = collision; }
+
+    /**
+     * @brief The collision this mesh was cooked into at import, streamed in with it
+     */
+    const physics::CookedCollision &getCollision() const { return m_collision; }
 
     /**
      * @brief Builds a static mesh from a blob produced by serialize
@@ -32,6 +52,9 @@ class StaticMesh : public Mesh {
      * @return The mesh, or nullptr if the blob is not a readable static mesh
      */
     static std::unique_ptr<StaticMesh> deserialize(std::span<const uint8_t> blob);
+
+  private:
+    physics::CookedCollision m_collision;
 };
 
 } // namespace Rapture
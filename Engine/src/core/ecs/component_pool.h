@@ -193,6 +193,16 @@ class ComponentPool final : public ComponentPoolBase {
 
     ComponentSignal &getDestroySignal() override { return m_onDestroy; }
 
+    /**
+     * @brief The packed component array, in the same order as getEntities().
+     * @return Every component this pool holds.
+     */
+    const std::vector<T> &getData() const
+    requires(!IS_EMPTY)
+    {
+        return m_data;
+    }
+
   private:
     struct NoData {};
 
@@ -202,6 +212,21 @@ class ComponentPool final : public ComponentPoolBase {
     [[no_unique_address]] std::conditional_t<IS_EMPTY, NoData, std::vector<T>> m_data;
 };
 
+/**
+ * @brief A copy of a pool of plain data, taken so its components can be copied back later.
+ *
+ * Holds the packed arrays as they were, so taking one is two copies of contiguous memory.
+ */
+template <typename T>
+struct PoolImage {
+    static_assert(std::is_trivially_copyable_v<T> && !std::is_empty_v<T>, "only a pool of plain data is copied as it is");
+
+    using Component = T;
+
+    std::vector<Entity> entities;
+    std::vector<T> data;
+};
+
 } // namespace ecs
 } // namespace Rapture
 
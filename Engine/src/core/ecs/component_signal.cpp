@@ -1,5 +1,7 @@
 #include "component_signal.h"
 
+#include <cstddef>
+
 namespace Rapture {
 namespace ecs {
 
@@ -51,14 +53,17 @@ bool SignalConnection::isConnected() const
     return m_signal != nullptr && !m_alive.expired();
 }
 
-SignalConnection ComponentSignal::connect(Callback callback)
+SignalConnection ComponentSignal::connect(Callback callback, SignalDispatch dispatch)
 {
     if (m_fireDepth == 0 && m_needsCompact) {
         compact();
     }
 
     uint32_t slotId = m_nextSlotId++;
-    m_slots.push_back(Slot{slotId, std::move(callback)});
+    m_slots.push_back(Slot{slotId, std::move(callback), dispatch});
+    if (dispatch == SIGNAL_DISPATCH_DEFERRABLE) {
+        m_deferrableCount++;
+    }
 
     return SignalConnection(this, m_alive, slotId);
 }
@@ -67,6 +72,9 @@ void ComponentSignal::disconnect(uint32_t slotId)
 {
     for (auto &slot : m_slots) {
         if (slot.id == slotId) {
+            if (slot.dispatch == SIGNAL_DISPATCH_DEFERRABLE) {
+                m_deferrableCount--;
+            }
             slot.id = 0;
             slot.callback = nullptr;
             m_needsCompact = true;
@@ -83,11 +91,18 @@ void ComponentSignal::fire(Entity entity)
 {
     m_fireDepth++;
 
+    const bool holding = m_isDeferring && m_deferrableCount > 0;
+
     size_t count = m_slots.size();
     for (size_t i = 0; i < count; i++) {
-        if (m_slots[i].callback != nullptr) {
-            m_slots[i].callback(entity);
+        if (m_slots[i].callback == nullptr || (holding && m_slots[i].dispatch == SIGNAL_DISPATCH_DEFERRABLE)) {
+            continue;
         }
+        m_slots[i].callback(entity);
+    }
+
+    if (holding) {
+        m_deferred.push_back(entity);
     }
 
     m_fireDepth--;
@@ -97,6 +112,68 @@ void ComponentSignal::fire(Entity entity)
     }
 }
 
+void ComponentSignal::defer()
+{
+    m_isDeferring = true;
+}
+
+void ComponentSignal::flushDeferred()
+{
+    m_isDeferring = false;
+    if (m_deferred.empty()) {
+        return;
+    }
+
+    // taken out first, so an entity a handler fires for from in here is not run twice
+    m_flushing = std::move(m_deferred);
+    m_deferred.clear();
+
+    m_fireDepth++;
+
+    // handler by handler, so each one walks the whole batch with its own state still warm
+    size_t count = m_slots.size();
+    for (size_t i = 0; i < count; i++) {
+        if (m_slots[i].dispatch != SIGNAL_DISPATCH_DEFERRABLE) {
+            continue;
+        }
+        // by index, a handler may cancel an entity further along the batch
+        for (size_t held = 0; held < m_flushing.size(); held++) {
+            if (m_slots[i].callback == nullptr) {
+                break;
+            }
+            if (m_flushing[held] != ENTITY_NULL) {
+                m_slots[i].callback(m_flushing[held]);
+            }
+        }
+    }
+    m_flushing.clear();
+
+    m_fireDepth--;
+
+    if (m_fireDepth == 0 && m_needsCompact) {
+        compact();
+    }
+}
+
+void ComponentSignal::cancelDeferred(Entity entity)
+{
+    // searched from the back, the entity leaving is most likely one that just arrived
+    for (size_t i = m_deferred.size(); i > 0; i--) {
+        if (m_deferred[i - 1] == entity) {
+            m_deferred.erase(m_deferred.begin() + static_cast<ptrdiff_t>(i - 1));
+            return;
+        }
+    }
+
+    // or it is in the batch being flushed, where it is blanked so the handlers still to run skip it
+    for (Entity &held : m_flushing) {
+        if (held == entity) {
+            held = ENTITY_NULL;
+            return;
+        }
+    }
+}
+
 bool ComponentSignal::isEmpty() const
 {
     return m_slots.empty();
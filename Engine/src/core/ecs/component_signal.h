@@ -13,6 +13,14 @@ namespace ecs {
 class Registry;
 class ComponentSignal;
 
+/**
+ * @brief When a subscriber is told of what a signal reports.
+ */
+enum SignalDispatch : uint8_t {
+    SIGNAL_DISPATCH_IMMEDIATE,  // as the signal fires, always
+    SIGNAL_DISPATCH_DEFERRABLE, // may be held while the signal defers, then told of every held entity in one go
+};
+
 /**
  * @brief RAII handle to one subscription, disconnects when it goes out of scope.
  *
@@ -50,9 +58,10 @@ class ComponentSignal {
     /**
      * @brief Subscribes to this signal.
      * @param callback Handler to run, receiving the registry and the entity.
+     * @param dispatch Whether the handler may be held back while the signal defers.
      * @return Connection that unsubscribes when destroyed.
      */
-    SignalConnection connect(Callback callback);
+    SignalConnection connect(Callback callback, SignalDispatch dispatch = SIGNAL_DISPATCH_IMMEDIATE);
 
     /**
      * @brief Unsubscribes a slot, deferring the erase if a fire is in progress.
@@ -66,6 +75,24 @@ class ComponentSignal {
      */
     void fire(Entity entity);
 
+    /**
+     * @brief Holds back the deferrable handlers, recording the entities they are owed instead.
+     */
+    void defer();
+
+    /**
+     * @brief Stops deferring and runs each deferrable handler over every held entity, in the order they fired.
+     */
+    void flushDeferred();
+
+    /**
+     * @brief Drops an entity that is still held, because what it fired for is leaving before it was flushed.
+     * @param entity Entity to drop.
+     */
+    void cancelDeferred(Entity entity);
+
+    bool isDeferring() const { return m_isDeferring; }
+
     bool isEmpty() const;
 
     /**
@@ -81,13 +108,18 @@ class ComponentSignal {
     struct Slot {
         uint32_t id = 0;
         Callback callback;
+        SignalDispatch dispatch = SIGNAL_DISPATCH_IMMEDIATE;
     };
 
     std::vector<Slot> m_slots;
+    std::vector<Entity> m_deferred;
+    std::vector<Entity> m_flushing; // the batch flushDeferred is running, ENTITY_NULL where one was cancelled
     std::shared_ptr<uint8_t> m_alive = std::make_shared<uint8_t>();
     uint32_t m_nextSlotId = 1;
     uint32_t m_fireDepth = 0;
+    uint32_t m_deferrableCount = 0;
     bool m_needsCompact = false;
+    bool m_isDeferring = false;
 };
 
 } // namespace ecs
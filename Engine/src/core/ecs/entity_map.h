@@ -0,0 +1,116 @@
+#ifndef RAPTURE__ENTITY_MAP_H
+#define RAPTURE__ENTITY_MAP_H
+
+#include "common.h"
+#include "sparse_set.h"
+
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace Rapture {
+namespace ecs {
+
+/**
+ * @brief Maps entities to a value through pages indexed by the entity index.
+ *
+ * Paged like SparseSet, so it only pays for the ranges of entity index space it holds, but the
+ * value sits in the page next to the entity it belongs to. A lookup is a page load, an entry load
+ * and a compare against the stored entity, which turns away stale generations the way a map keyed
+ * by the whole entity would.
+ */
+template <typename T>
+class EntityMap {
+  public:
+    /**
+     * @brief Value of an entity.
+     * @param entity Entity to look up, may be stale.
+     * @return Pointer to its value, or nullptr if the entity has none.
+     */
+    const T *find(Entity entity) const
+    {
+        const Entry *entry = findEntry(EntityIndex(entity));
+        return (entry != nullptr && entry->entity == entity) ? &entry->value : nullptr;
+    }
+
+    T *find(Entity entity) { return const_cast<T *>(std::as_const(*this).find(entity)); }
+
+    /**
+     * @brief Sets the value of an entity, replacing the value of an older generation at its index.
+     * @param entity Entity to set.
+     * @param value Value to hold.
+     * @return Reference to the held value.
+     */
+    T &assign(Entity entity, T value)
+    {
+        Entry &entry = assureEntry(EntityIndex(entity));
+        if (entry.entity == ENTITY_NULL) {
+            m_size++;
+        }
+        entry.entity = entity;
+        entry.value = std::move(value);
+        return entry.value;
+    }
+
+    /**
+     * @brief Removes the value of an entity.
+     * @param entity Entity to remove, may be stale.
+     * @return True if the entity had a value.
+     */
+    bool erase(Entity entity)
+    {
+        Entry *entry = const_cast<Entry *>(findEntry(EntityIndex(entity)));
+        if (entry == nullptr || entry->entity != entity) {
+            return false;
+        }
+        *entry = Entry{};
+        m_size--;
+        return true;
+    }
+
+    void clear()
+    {
+        m_pages.clear();
+        m_size = 0;
+    }
+
+    uint32_t getSize() const { return m_size; }
+
+  private:
+    struct Entry {
+        Entity entity = ENTITY_NULL;
+        T value{};
+    };
+
+    using Page = std::array<Entry, SPARSE_PAGE_SIZE>;
+
+    const Entry *findEntry(uint32_t entityIndex) const
+    {
+        uint32_t page = entityIndex / SPARSE_PAGE_SIZE;
+        if (page >= m_pages.size() || m_pages[page] == nullptr) {
+            return nullptr;
+        }
+        return &(*m_pages[page])[entityIndex % SPARSE_PAGE_SIZE];
+    }
+
+    Entry &assureEntry(uint32_t entityIndex)
+    {
+        uint32_t page = entityIndex / SPARSE_PAGE_SIZE;
+        if (page >= m_pages.size()) {
+            m_pages.resize(page + 1);
+        }
+        if (m_pages[page] == nullptr) {
+            m_pages[page] = std::make_unique<Page>();
+        }
+        return (*m_pages[page])[entityIndex % SPARSE_PAGE_SIZE];
+    }
+
+    std::vector<std::unique_ptr<Page>> m_pages;
+    uint32_t m_size = 0;
+};
+
+} // namespace ecs
+} // namespace Rapture
+
+#endif // RAPTURE__ENTITY_MAP_H
@@ -42,6 +42,29 @@ void Journal::record(Entity entity, ChangeMask channels)
     }
 }
 
+void Journal::record(std::span<const Entity> entities, ChangeMask channels)
+{
+    while (channels != 0) {
+        uint32_t channelIndex = static_cast<uint32_t>(std::countr_zero(channels));
+        channels &= channels - 1;
+
+        RP_ASSERT(channelIndex < m_channels.size(), "recording on a channel the journal does not have");
+        Channel &channel = m_channels[channelIndex];
+        const size_t ringSize = channel.ring.size();
+
+        for (Entity entity : entities) {
+            uint32_t index = EntityIndex(entity);
+            if (index >= channel.stamps.size() || channel.stamps[index] == m_epoch) {
+                continue;
+            }
+
+            channel.stamps[index] = m_epoch;
+            channel.ring[channel.total % ringSize] = entity;
+            channel.total++;
+        }
+    }
+}
+
 Batch Journal::readSince(uint32_t channel, Bookmark &bookmark)
 {
     RP_ASSERT(channel < m_channels.size(), "reading a channel the journal does not have");
@@ -3,6 +3,7 @@
 
 #include "common.h"
 
+#include <span>
 #include <vector>
 
 namespace Rapture {
@@ -102,6 +103,13 @@ class Journal {
      */
     void record(Entity entity, ChangeMask channels);
 
+    /**
+     * @brief Records many entities on every channel in a mask, resolving each channel once.
+     * @param entities Entities that changed, in the order they are to be read back.
+     * @param channels Mask of channels to record on, may be zero.
+     */
+    void record(std::span<const Entity> entities, ChangeMask channels);
+
     /**
      * @brief Reads everything recorded on a channel since a bookmark, and advances it.
      * @param channel Channel index to read.
@@ -41,6 +41,9 @@ void Registry::destroy(Entity entity)
     while (remaining != 0) {
         uint32_t typeId = static_cast<uint32_t>(std::countr_zero(remaining));
         remaining &= remaining - 1;
+        if (m_deferDepth > 0) {
+            m_pools[typeId]->getConstructSignal().cancelDeferred(entity);
+        }
         m_pools[typeId]->getDestroySignal().fire(entity);
     }
 
@@ -86,6 +89,48 @@ void Registry::clear()
     m_aliveCount = 0;
 }
 
+void Registry::reserve(uint32_t entityCount)
+{
+    m_records.reserve(entityCount);
+    m_journal.growTo(entityCount);
+}
+
+void Registry::deferConstructSignals()
+{
+    if (m_deferDepth++ > 0) {
+        return;
+    }
+
+    for (auto &pool : m_pools) {
+        if (pool != nullptr) {
+            pool->getConstructSignal().defer();
+        }
+    }
+}
+
+void Registry::flushConstructSignals()
+{
+    RP_ASSERT(m_deferDepth > 0, "construct signals were not deferred");
+    if (m_deferDepth > 1) {
+        m_deferDepth--;
+        return;
+    }
+
+    // the depth stays raised until every pool is flushed, so a handler that removes a component or
+    // destroys an entity still cancels what the pools after its own hold for it
+    m_flushingConstructs = true;
+
+    // by index, a handler may attach a component whose pool did not exist yet
+    for (size_t i = 0; i < m_pools.size(); i++) {
+        if (m_pools[i] != nullptr) {
+            m_pools[i]->getConstructSignal().flushDeferred();
+        }
+    }
+
+    m_flushingConstructs = false;
+    m_deferDepth = 0;
+}
+
 uint32_t Registry::getAliveCount() const
 {
     return m_aliveCount;
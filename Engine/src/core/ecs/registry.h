@@ -5,7 +5,9 @@
 #include "view.h"
 #include "write_scope.h"
 
+#include <algorithm>
 #include <memory>
+#include <span>
 #include <vector>
 
 namespace Rapture {
@@ -50,6 +52,28 @@ class Registry {
 
     uint32_t getAliveCount() const;
 
+    /**
+     * @brief Makes room for entities about to be created, so a bulk load does not grow the records as it goes.
+     * @param entityCount Number of entity slots the registry should hold without growing.
+     */
+    void reserve(uint32_t entityCount);
+
+    /**
+     * @brief Holds back deferrable construct handlers until flushConstructSignals.
+     *
+     * Immediate handlers still run as each component is attached, so whatever the entities being built
+     * read back while they are built stays in step. A component that leaves before the flush is dropped
+     * from it, though its destroy handlers still run. Calls nest, the outermost flush is the one that runs.
+     */
+    void deferConstructSignals();
+
+    /**
+     * @brief Runs every construct handler deferConstructSignals held back, pool by pool.
+     *
+     * A handler that removes a component or destroys an entity meanwhile drops it from what is still held.
+     */
+    void flushConstructSignals();
+
     /**
      * @brief Component mask of an entity, one bit per component type it holds.
      * @param entity Entity to inspect, must be alive.
@@ -129,6 +153,9 @@ class Registry {
         RP_ASSERT(has<T>(entity), "entity does not have this component");
 
         ComponentPool<T> *pool = getPool<T>();
+        if (m_deferDepth > 0) {
+            pool->getConstructSignal().cancelDeferred(entity);
+        }
         pool->getDestroySignal().fire(entity);
 
         m_records[EntityIndex(entity)].components &= ~ComponentBit<T>();
@@ -158,12 +185,13 @@ class Registry {
     /**
      * @brief Subscribes to T being attached, for a subscriber that can outlive its own interest.
      * @param callback Handler receiving the registry and the entity.
+     * @param dispatch Whether the handler may be held back while construct signals are deferred.
      * @return Connection that unsubscribes when destroyed.
      */
     template <typename T>
-    SignalConnection onConstructScoped(ComponentSignal::Callback callback)
+    SignalConnection onConstructScoped(ComponentSignal::Callback callback, SignalDispatch dispatch = SIGNAL_DISPATCH_IMMEDIATE)
     {
-        return assurePool<T>().getConstructSignal().connect(std::move(callback));
+        return assurePool<T>().getConstructSignal().connect(std::move(callback), dispatch);
     }
 
     /**
@@ -275,6 +303,58 @@ class Registry {
 
     Journal &getJournal() { return m_journal; }
 
+    /**
+     * @brief Copies every T out of its pool, as one block.
+     * @return The image, empty if no entity holds T.
+     */
+    template <typename T>
+    PoolImage<T> captureImage() const
+    {
+        PoolImage<T> image;
+        if (const ComponentPool<T> *pool = getPool<T>()) {
+            image.entities = pool->getEntities();
+            image.data = pool->getData();
+        }
+        return image;
+    }
+
+    /**
+     * @brief Copies an image's components back onto the entities that still hold T.
+     *
+     * An entity that was destroyed since, or lost T, is skipped rather than given it back. When
+     * nothing joined or left the pool since the image was taken, the whole array is copied at once.
+     * Every entity written to is recorded on T's channels.
+     * @param image An image this registry took.
+     * @return Number of components written.
+     */
+    template <typename T>
+    uint32_t restoreImage(const PoolImage<T> &image)
+    {
+        ComponentPool<T> *pool = getPool<T>();
+        if (pool == nullptr || image.entities.empty()) {
+            return 0;
+        }
+
+        const std::vector<Entity> &entities = pool->getEntities();
+        if (entities == image.entities) {
+            std::copy(image.data.begin(), image.data.end(), &pool->atDense(0));
+            m_journal.record(std::span<const Entity>(entities), COMPONENT_CHANNELS<T>);
+            return static_cast<uint32_t>(entities.size());
+        }
+
+        uint32_t written = 0;
+        for (size_t i = 0; i < image.entities.size(); i++) {
+            T *component = pool->tryGet(image.entities[i]);
+            if (component == nullptr) {
+                continue;
+            }
+            *component = image.data[i];
+            m_journal.record(image.entities[i], COMPONENT_CHANNELS<T>);
+            written++;
+        }
+        return written;
+    }
+
     /**
      * @brief Pool holding every instance of a component type.
      * @return The pool, or nullptr if no entity has ever held T.
@@ -339,6 +419,10 @@ class Registry {
         }
         if (m_pools[typeId] == nullptr) {
             m_pools[typeId] = std::make_unique<ComponentPool<T>>();
+            // a pool made by a flush handler may sit before the one flushing and would never be flushed
+            if (m_deferDepth > 0 && !m_flushingConstructs) {
+                m_pools[typeId]->getConstructSignal().defer();
+            }
         }
         return *static_cast<ComponentPool<T> *>(m_pools[typeId].get());
     }
@@ -350,6 +434,8 @@ class Registry {
     Journal m_journal;
     uint32_t m_freeHead = ENTITY_FREE_LIST_END;
     uint32_t m_aliveCount = 0;
+    uint32_t m_deferDepth = 0;
+    bool m_flushingConstructs = false;
 };
 
 } // namespace ecs
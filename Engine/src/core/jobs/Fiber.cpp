@@ -104,7 +104,7 @@ void Fiber::switchToScheduler()
 
 void initializeFiber(Fiber *fiber)
 {
-    void *stackTop = static_cast<char *>(fiber->stackBase) + FiberPool::FIBER_STACK_SIZE;
+    void *stackTop = static_cast<char *>(fiber->stackBase) + fiber->stackSize;
 
     uintptr_t stackAddr = reinterpret_cast<uintptr_t>(stackTop);
     stackAddr &= ~0xFull;
@@ -129,41 +129,73 @@ Fiber *createSchedulerFiber()
     return &t_schedulerFiber;
 }
 
-FiberPool::~FiberPool()
+static void s_freeStack(Fiber &fiber)
 {
-    for (size_t i = 0; i < MAX_FIBERS; ++i) {
-        if (m_fibers[i].fiber.stackBase != nullptr) {
+    if (fiber.stackBase == nullptr) {
+        return;
+    }
 #ifdef RAPTURE_FIBER_GUARD_PAGE
-            size_t guardSize = s_fiberGuardSize();
-            munmap(static_cast<char *>(m_fibers[i].fiber.stackBase) - guardSize, FIBER_STACK_SIZE + guardSize);
+    size_t guardSize = s_fiberGuardSize();
+    munmap(static_cast<char *>(fiber.stackBase) - guardSize, fiber.stackSize + guardSize);
 #else
-            std::free(m_fibers[i].fiber.stackBase);
+    std::free(fiber.stackBase);
 #endif // RAPTURE_FIBER_GUARD_PAGE
-        }
+}
+
+static void s_allocateStack(Fiber &fiber, size_t stackSize)
+{
+#ifdef RAPTURE_FIBER_GUARD_PAGE
+    size_t guardSize = s_fiberGuardSize();
+    void *mapping = mmap(nullptr, stackSize + guardSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    RP_ASSERT(mapping != MAP_FAILED, "Failed to mmap fiber stack");
+    int guardResult = mprotect(mapping, guardSize, PROT_NONE);
+    RP_ASSERT(guardResult == 0, "Failed to protect fiber guard page");
+    fiber.stackBase = static_cast<char *>(mapping) + guardSize;
+#else
+    fiber.stackBase = std::aligned_alloc(16, stackSize);
+    if (!fiber.stackBase) {
+        std::abort();
+    }
+#endif // RAPTURE_FIBER_GUARD_PAGE
+    fiber.stackSize = stackSize;
+}
+
+FiberPool::~FiberPool()
+{
+    for (FiberSlot &slot : m_fibers) {
+        s_freeStack(slot.fiber);
+    }
+    for (FiberSlot &slot : m_largeFibers) {
+        s_freeStack(slot.fiber);
     }
 }
 
-Fiber *FiberPool::acquire()
+std::span<FiberPool::FiberSlot> FiberPool::slotsFor(JobStack stack)
+{
+    if (stack == JobStack::LARGE) {
+        return m_largeFibers;
+    }
+    return m_fibers;
+}
+
+Fiber *FiberPool::acquire(JobStack stack)
 {
     while (true) {
-        for (size_t i = 0; i < MAX_FIBERS; ++i) {
-            bool expected = false;
-            if (m_fibers[i].inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
-                m_availableCount.fetch_sub(1, std::memory_order_relaxed);
-                return &m_fibers[i].fiber;
-            }
+        Fiber *fiber = nullptr;
+        if (tryAcquire(&fiber, stack)) {
+            return fiber;
         }
         std::this_thread::yield();
     }
 }
 
-bool FiberPool::tryAcquire(Fiber **out)
+bool FiberPool::tryAcquire(Fiber **out, JobStack stack)
 {
-    for (size_t i = 0; i < MAX_FIBERS; ++i) {
+    for (FiberSlot &slot : slotsFor(stack)) {
         bool expected = false;
-        if (m_fibers[i].inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+        if (slot.inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
             m_availableCount.fetch_sub(1, std::memory_order_relaxed);
-            *out = &m_fibers[i].fiber;
+            *out = &slot.fiber;
             return true;
         }
     }
@@ -172,9 +204,10 @@ bool FiberPool::tryAcquire(Fiber **out)
 
 void FiberPool::release(Fiber *fiber)
 {
-    for (size_t i = 0; i < MAX_FIBERS; ++i) {
-        if (&m_fibers[i].fiber == fiber) {
-            m_fibers[i].inUse.store(false, std::memory_order_release);
+    const JobStack stack = fiber->stackSize == FIBER_STACK_SIZE_LARGE ? JobStack::LARGE : JobStack::DEFAULT;
+    for (FiberSlot &slot : slotsFor(stack)) {
+        if (&slot.fiber == fiber) {
+            slot.inUse.store(false, std::memory_order_release);
             m_availableCount.fetch_add(1, std::memory_order_relaxed);
             return;
         }
@@ -188,25 +221,15 @@ size_t FiberPool::availableCount() const
 
 void FiberPool::initializeFiberStacks()
 {
-    for (size_t i = 0; i < MAX_FIBERS; ++i) {
-        Fiber &fiber = m_fibers[i].fiber;
-
-#ifdef RAPTURE_FIBER_GUARD_PAGE
-        size_t guardSize = s_fiberGuardSize();
-        void *mapping = mmap(nullptr, FIBER_STACK_SIZE + guardSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-        RP_ASSERT(mapping != MAP_FAILED, "Failed to mmap fiber stack");
-        int guardResult = mprotect(mapping, guardSize, PROT_NONE);
-        RP_ASSERT(guardResult == 0, "Failed to protect fiber guard page");
-        fiber.stackBase = static_cast<char *>(mapping) + guardSize;
-#else
-        fiber.stackBase = std::aligned_alloc(16, FIBER_STACK_SIZE);
-        if (!fiber.stackBase) {
-            std::abort();
-        }
-#endif // RAPTURE_FIBER_GUARD_PAGE
-
-        initializeFiber(&fiber);
-        m_fibers[i].inUse.store(false, std::memory_order_relaxed);
+    for (FiberSlot &slot : m_fibers) {
+        s_allocateStack(slot.fiber, FIBER_STACK_SIZE);
+        initializeFiber(&slot.fiber);
+        slot.inUse.store(false, std::memory_order_relaxed);
+    }
+    for (FiberSlot &slot : m_largeFibers) {
+        s_allocateStack(slot.fiber, FIBER_STACK_SIZE_LARGE);
+        initializeFiber(&slot.fiber);
+        slot.inUse.store(false, std::memory_order_relaxed);
     }
 }
 
@@ -7,6 +7,7 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <span>
 
 namespace Rapture {
 
@@ -27,6 +28,7 @@ struct FiberContext {
 
 struct Fiber {
     void *stackBase;      // Allocated stack memory
+    size_t stackSize;     // Size of the stack memory, set once by the pool
     void *stackPointer;   // Current stack position
     FiberContext context; // Platform-specific context (registers, etc.)
 
@@ -63,11 +65,11 @@ class FiberPool {
     FiberPool(FiberPool &&) = delete;
     FiberPool &operator=(FiberPool &&) = delete;
 
-    Fiber *acquire();             // Get a free fiber (blocks if none available)
-    bool tryAcquire(Fiber **out); // Non-blocking acquire
-    void release(Fiber *fiber);   // Return fiber to pool
+    Fiber *acquire(JobStack stack = JobStack::DEFAULT);               // Get a free fiber (blocks if none available)
+    bool tryAcquire(Fiber **out, JobStack stack = JobStack::DEFAULT); // Non-blocking acquire
+    void release(Fiber *fiber);                                       // Return fiber to pool
 
-    size_t availableCount() const;
+    size_t availableCount() const; // Free fibers of both stack sizes
 
     void initializeFiberStacks();
 
@@ -77,8 +79,11 @@ class FiberPool {
         std::atomic<bool> inUse{false};
     };
 
+    std::span<FiberSlot> slotsFor(JobStack stack);
+
     std::array<FiberSlot, MAX_FIBERS> m_fibers;
-    std::atomic<uint32_t> m_availableCount{MAX_FIBERS};
+    std::array<FiberSlot, MAX_LARGE_FIBERS> m_largeFibers;
+    std::atomic<uint32_t> m_availableCount{MAX_FIBERS + MAX_LARGE_FIBERS};
 };
 
 } // namespace Rapture
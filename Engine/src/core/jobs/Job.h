@@ -26,10 +26,11 @@ struct JobDeclaration {
     QueueAffinity affinity = QueueAffinity::ANY;
     Counter *signalOnComplete = nullptr;
     const char *debugName = nullptr;
+    JobStack stack = JobStack::DEFAULT;
 
     JobDeclaration(const JobFunction &_func, JobPriority _prio, QueueAffinity _affinity, Counter *onComplete = nullptr,
-                   const char *name = nullptr)
-        : function(_func), priority(_prio), affinity(_affinity), signalOnComplete(onComplete), debugName(name)
+                   const char *name = nullptr, JobStack _stack = JobStack::DEFAULT)
+        : function(_func), priority(_prio), affinity(_affinity), signalOnComplete(onComplete), debugName(name), stack(_stack)
     {
     }
 
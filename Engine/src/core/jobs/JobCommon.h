@@ -9,6 +9,13 @@ enum class JobPriority {
     HIGH    // Latency-sensitive (frame-critical rendering)
 };
 
+// The fiber stack a job runs on. LARGE is for code that recurses deep or keeps big frames on the
+// stack, physics simulation mostly, and comes from a smaller pool.
+enum class JobStack {
+    DEFAULT, // FiberPool::FIBER_STACK_SIZE
+    LARGE    // FiberPool::FIBER_STACK_SIZE_LARGE
+};
+
 enum class QueueAffinity {
     ANY,
     GRAPHICS,
@@ -32,6 +32,11 @@ class JobSystem {
 
     bool shouldShutdown();
 
+    /**
+     * @brief Number of worker threads jobs run on, not counting the io and gpu poll threads
+     */
+    uint32_t getWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
     PriorityQueueSet &getQueue() { return m_queues; }
     WaitList &getWaitList() { return m_waitList; }
     FiberPool &getFiberPool() { return m_fiberPool; }
@@ -0,0 +1,334 @@
+#include "SerialBinary.h"
+
+#include <cstring>
+
+#include <yyjson.h>
+
+#include "core/utils/Log.h"
+
+namespace Rapture {
+
+namespace {
+
+/**
+ * @brief What the byte in front of every encoded value says it is
+ */
+enum SerialBinaryTag : uint8_t {
+    TAG_NULL,
+    TAG_FALSE,
+    TAG_TRUE,
+    TAG_UINT,   // varint
+    TAG_SINT,   // zigzag varint
+    TAG_FLOAT,  // four bytes, for a real that a float holds exactly
+    TAG_DOUBLE, // eight bytes
+    TAG_STRING, // varint length, then the bytes
+    TAG_RAW,    // varint length, then the text a raw value holds
+    TAG_ARRAY,  // varint count, then the elements
+    TAG_OBJECT, // varint count, then a key and a value per member
+};
+
+void s_writeVarint(std::vector<uint8_t> &out, uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+template <typename T>
+void s_writeBytes(std::vector<uint8_t> &out, const T &v)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&v);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+void s_writeString(std::vector<uint8_t> &out, const char *text, size_t length)
+{
+    s_writeVarint(out, length);
+    out.insert(out.end(), reinterpret_cast<const uint8_t *>(text), reinterpret_cast<const uint8_t *>(text) + length);
+}
+
+/**
+ * @brief A cursor over encoded bytes that refuses to read past their end
+ */
+struct ByteReader {
+    std::span<const uint8_t> bytes;
+    size_t cursor = 0;
+    bool failed = false;
+
+    uint8_t byte()
+    {
+        if (cursor >= bytes.size()) {
+            failed = true;
+            return 0;
+        }
+        return bytes[cursor++];
+    }
+
+    uint64_t varint()
+    {
+        uint64_t v = 0;
+        for (uint32_t shift = 0; shift < 64; shift += 7) {
+            const uint8_t b = byte();
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                return v;
+            }
+        }
+        failed = true;
+        return 0;
+    }
+
+    const char *take(uint64_t length)
+    {
+        if (failed || length > bytes.size() - cursor) {
+            failed = true;
+            return nullptr;
+        }
+        const char *text = reinterpret_cast<const char *>(bytes.data() + cursor);
+        cursor += static_cast<size_t>(length);
+        return text;
+    }
+
+    template <typename T>
+    T value()
+    {
+        T v{};
+        if (const char *source = take(sizeof(T))) {
+            std::memcpy(&v, source, sizeof(T));
+        }
+        return v;
+    }
+};
+
+} // namespace
+
+/**
+ * @brief Writes one value and everything under it
+ */
+static void s_encodeValue(yyjson_mut_val *val, std::vector<uint8_t> &out, std::unordered_map<std::string_view, uint32_t> &keyIndex,
+                          std::deque<std::string> &keys)
+{
+    switch (yyjson_mut_get_type(val)) {
+    case YYJSON_TYPE_BOOL:
+        out.push_back(yyjson_mut_get_bool(val) ? TAG_TRUE : TAG_FALSE);
+        return;
+    case YYJSON_TYPE_NUM:
+        if (yyjson_mut_is_uint(val)) {
+            out.push_back(TAG_UINT);
+            s_writeVarint(out, yyjson_mut_get_uint(val));
+        } else if (yyjson_mut_is_sint(val)) {
+            const int64_t v = yyjson_mut_get_sint(val);
+            out.push_back(TAG_SINT);
+            s_writeVarint(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+        } else {
+            const double v = yyjson_mut_get_real(val);
+            const float narrowed = static_cast<float>(v);
+            if (static_cast<double>(narrowed) == v) {
+                out.push_back(TAG_FLOAT);
+                s_writeBytes(out, narrowed);
+            } else {
+                out.push_back(TAG_DOUBLE);
+                s_writeBytes(out, v);
+            }
+        }
+        return;
+    case YYJSON_TYPE_STR:
+        out.push_back(TAG_STRING);
+        s_writeString(out, yyjson_mut_get_str(val), yyjson_mut_get_len(val));
+        return;
+    case YYJSON_TYPE_RAW:
+        out.push_back(TAG_RAW);
+        s_writeString(out, yyjson_mut_get_raw(val), yyjson_mut_get_len(val));
+        return;
+    case YYJSON_TYPE_ARR: {
+        out.push_back(TAG_ARRAY);
+        s_writeVarint(out, yyjson_mut_arr_size(val));
+
+        size_t index = 0;
+        size_t count = 0;
+        yyjson_mut_val *element = nullptr;
+        yyjson_mut_arr_foreach(val, index, count, element)
+        {
+            s_encodeValue(element, out, keyIndex, keys);
+        }
+        return;
+    }
+    case YYJSON_TYPE_OBJ: {
+        out.push_back(TAG_OBJECT);
+        s_writeVarint(out, yyjson_mut_obj_size(val));
+
+        size_t index = 0;
+        size_t count = 0;
+        yyjson_mut_val *key = nullptr;
+        yyjson_mut_val *member = nullptr;
+        yyjson_mut_obj_foreach(val, index, count, key, member)
+        {
+            // the low bit tells a key spelled out for the first time from an index to one that was
+            std::string_view name(yyjson_mut_get_str(key), yyjson_mut_get_len(key));
+            auto found = keyIndex.find(name);
+            if (found != keyIndex.end()) {
+                s_writeVarint(out, static_cast<uint64_t>(found->second) << 1);
+            } else {
+                s_writeVarint(out, (static_cast<uint64_t>(name.size()) << 1) | 1);
+                out.insert(out.end(), name.begin(), name.end());
+                keyIndex.emplace(keys.emplace_back(name), static_cast<uint32_t>(keyIndex.size()));
+            }
+
+            s_encodeValue(member, out, keyIndex, keys);
+        }
+        return;
+    }
+    default:
+        out.push_back(TAG_NULL);
+        return;
+    }
+}
+
+bool SerialBinaryEncoder::encode(const SerialDocument &document, std::vector<uint8_t> &out)
+{
+    yyjson_mut_doc *source = static_cast<yyjson_mut_doc *>(document.m_mutDoc);
+    yyjson_mut_doc *copy = nullptr;
+
+    // a read-mode document is copied into write mode, so there is one kind of tree to walk
+    if (source == nullptr && document.m_doc != nullptr) {
+        copy = yyjson_doc_mut_copy(static_cast<yyjson_doc *>(document.m_doc), nullptr);
+        source = copy;
+    }
+
+    yyjson_mut_val *root = source != nullptr ? yyjson_mut_doc_get_root(source) : nullptr;
+    if (root == nullptr) {
+        RP_CORE_ERROR("cannot encode a document that holds nothing");
+        yyjson_mut_doc_free(copy);
+        return false;
+    }
+
+    s_encodeValue(root, out, m_keyIndex, m_keys);
+    yyjson_mut_doc_free(copy);
+    return true;
+}
+
+void SerialBinaryEncoder::reset()
+{
+    m_keyIndex.clear();
+    m_keys.clear();
+}
+
+/**
+ * @brief Reads one value and everything under it into a document being built
+ *
+ * Strings point into the encoded bytes rather than being copied, the freeze that follows copies them
+ * once into the read-mode document.
+ */
+static yyjson_mut_val *s_decodeValue(yyjson_mut_doc *doc, ByteReader &reader, std::vector<std::string_view> &keys)
+{
+    switch (reader.byte()) {
+    case TAG_NULL:
+        return yyjson_mut_null(doc);
+    case TAG_FALSE:
+        return yyjson_mut_false(doc);
+    case TAG_TRUE:
+        return yyjson_mut_true(doc);
+    case TAG_UINT:
+        return yyjson_mut_uint(doc, reader.varint());
+    case TAG_SINT: {
+        const uint64_t zigzag = reader.varint();
+        return yyjson_mut_sint(doc, static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1));
+    }
+    case TAG_FLOAT:
+        return yyjson_mut_real(doc, static_cast<double>(reader.value<float>()));
+    case TAG_DOUBLE:
+        return yyjson_mut_real(doc, reader.value<double>());
+    case TAG_STRING:
+    case TAG_RAW: {
+        const bool raw = reader.bytes[reader.cursor - 1] == TAG_RAW;
+        const uint64_t length = reader.varint();
+        const char *text = reader.take(length);
+        if (text == nullptr) {
+            return nullptr;
+        }
+        const size_t size = static_cast<size_t>(length);
+        return raw ? yyjson_mut_rawn(doc, text, size) : yyjson_mut_strn(doc, text, size);
+    }
+    case TAG_ARRAY: {
+        const uint64_t count = reader.varint();
+        yyjson_mut_val *array = yyjson_mut_arr(doc);
+        for (uint64_t i = 0; i < count && !reader.failed; i++) {
+            yyjson_mut_val *element = s_decodeValue(doc, reader, keys);
+            if (element == nullptr) {
+                return nullptr;
+            }
+            yyjson_mut_arr_append(array, element);
+        }
+        return reader.failed ? nullptr : array;
+    }
+    case TAG_OBJECT: {
+        const uint64_t count = reader.varint();
+        yyjson_mut_val *object = yyjson_mut_obj(doc);
+        for (uint64_t i = 0; i < count && !reader.failed; i++) {
+            const uint64_t keyCode = reader.varint();
+            std::string_view name;
+            if ((keyCode & 1) != 0) {
+                const char *text = reader.take(keyCode >> 1);
+                if (text == nullptr) {
+                    return nullptr;
+                }
+                name = std::string_view(text, static_cast<size_t>(keyCode >> 1));
+                keys.push_back(name);
+            } else if ((keyCode >> 1) < keys.size()) {
+                name = keys[static_cast<size_t>(keyCode >> 1)];
+            } else {
+                reader.failed = true;
+                return nullptr;
+            }
+
+            yyjson_mut_val *member = s_decodeValue(doc, reader, keys);
+            if (member == nullptr) {
+                return nullptr;
+            }
+            yyjson_mut_obj_add(object, yyjson_mut_strn(doc, name.data(), name.size()), member);
+        }
+        return reader.failed ? nullptr : object;
+    }
+    default:
+        reader.failed = true;
+        return nullptr;
+    }
+}
+
+SerialDocument decodeSerialBinary(std::span<const uint8_t> bytes, uint32_t count)
+{
+    SerialDocument out;
+    yyjson_mut_doc *doc = static_cast<yyjson_mut_doc *>(out.m_mutDoc);
+    if (doc == nullptr) {
+        return out;
+    }
+
+    ByteReader reader{bytes};
+    std::vector<std::string_view> keys;
+    yyjson_mut_val *root = yyjson_mut_arr(doc);
+    for (uint32_t i = 0; i < count; i++) {
+        yyjson_mut_val *value = s_decodeValue(doc, reader, keys);
+        if (value == nullptr || reader.failed) {
+            RP_CORE_ERROR("encoded document {} of {} is malformed at byte {}", i, count, reader.cursor);
+            yyjson_mut_doc_free(doc);
+            out.m_mutDoc = nullptr;
+            return out;
+        }
+        yyjson_mut_arr_append(root, value);
+    }
+
+    if (reader.cursor != bytes.size()) {
+        RP_CORE_ERROR("{} bytes follow the {} encoded documents", bytes.size() - reader.cursor, count);
+        yyjson_mut_doc_free(doc);
+        out.m_mutDoc = nullptr;
+        return out;
+    }
+
+    yyjson_mut_doc_set_root(doc, root);
+    out.freeze();
+    return out;
+}
+
+} // namespace Rapture
@@ -0,0 +1,54 @@
+#ifndef RAPTURE__SERIAL_BINARY_H
+#define RAPTURE__SERIAL_BINARY_H
+
+#include "core/serialization/SerialDocument.h"
+
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Rapture {
+
+/**
+ * @brief Encodes documents into a compact binary form, one after another into the same bytes.
+ *
+ * Numbers are stored as they are rather than as text, a float that fits in four bytes takes four, and a
+ * key is spelled out the first time this encoder writes it and referred to by index after. Documents
+ * encoded between two resets therefore share their keys, and have to be decoded together by one
+ * decodeSerialBinary call.
+ */
+class SerialBinaryEncoder {
+  public:
+    /**
+     * @brief Appends a document's root, and everything under it, to a run of bytes
+     * @param document A write-mode document, or a read-mode one, which is copied to be walked
+     * @param out Bytes to append to
+     * @return False if the document holds nothing to encode
+     */
+    bool encode(const SerialDocument &document, std::vector<uint8_t> &out);
+
+    /**
+     * @brief Forgets every key written so far, so what is encoded next can be decoded on its own
+     */
+    void reset();
+
+  private:
+    std::unordered_map<std::string_view, uint32_t> m_keyIndex;
+    std::deque<std::string> m_keys; // what m_keyIndex views, a deque so the strings never move
+};
+
+/**
+ * @brief Reads back what a SerialBinaryEncoder wrote between two of its resets
+ * @param bytes Exactly the bytes the documents were encoded into
+ * @param count How many documents the bytes hold
+ * @return A document whose root is an array of the count documents, unreadable if the bytes are malformed
+ */
+SerialDocument decodeSerialBinary(std::span<const uint8_t> bytes, uint32_t count);
+
+} // namespace Rapture
+
+#endif // RAPTURE__SERIAL_BINARY_H
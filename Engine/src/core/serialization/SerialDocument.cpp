@@ -26,13 +26,18 @@ static yyjson_val *s_asVal(void *val)
 }
 
 // a raw value, because yyjson formats reals as doubles and 0.8f promotes to 0.800000011920929
-static yyjson_mut_val *s_floatVal(yyjson_mut_doc *doc, float v)
+static yyjson_mut_val *s_floatVal(yyjson_mut_doc *doc, float v, SerialFloatFormat format)
 {
     if (!std::isfinite(v)) {
         RP_CORE_ERROR("cannot write {} as a number, writing 0 instead", v);
         return yyjson_mut_raw(doc, "0");
     }
 
+    // a float promotes to a double exactly, so a document that is never text reads back the same float
+    if (format == SERIAL_FLOAT_NATIVE) {
+        return yyjson_mut_real(doc, static_cast<double>(v));
+    }
+
     char text[32];
     auto [end, error] = std::to_chars(text, text + sizeof(text), v);
     if (error != std::errc()) {
@@ -43,7 +48,19 @@ static yyjson_mut_val *s_floatVal(yyjson_mut_doc *doc, float v)
     return yyjson_mut_rawncpy(doc, text, static_cast<size_t>(end - text));
 }
 
-WriteNode::WriteNode(void *doc, void *node) : m_doc(doc), m_node(node) {}
+// borrowed keys are the KEY_ constants every serialize writes with, which outlive any document
+static yyjson_mut_val *s_keyVal(yyjson_mut_doc *doc, std::string_view key, SerialKeyStorage storage)
+{
+    if (storage == SERIAL_KEYS_BORROWED) {
+        return yyjson_mut_strn(doc, key.data(), key.size());
+    }
+    return yyjson_mut_strncpy(doc, key.data(), key.size());
+}
+
+WriteNode::WriteNode(void *doc, void *node, SerialFloatFormat floatFormat, SerialKeyStorage keyStorage)
+    : m_doc(doc), m_node(node), m_floatFormat(floatFormat), m_keyStorage(keyStorage)
+{
+}
 
 bool WriteNode::valid() const
 {
@@ -56,12 +73,12 @@ WriteNode WriteNode::addObject(std::string_view key)
         return WriteNode();
     }
     yyjson_mut_doc *doc = s_asMutDoc(m_doc);
-    yyjson_mut_val *keyVal = yyjson_mut_strncpy(doc, key.data(), key.size());
+    yyjson_mut_val *keyVal = s_keyVal(doc, key, m_keyStorage);
     yyjson_mut_val *child = yyjson_mut_obj(doc);
     if (!yyjson_mut_obj_add(s_asMutVal(m_node), keyVal, child)) {
         return WriteNode();
     }
-    return WriteNode(m_doc, child);
+    return WriteNode(m_doc, child, m_floatFormat, m_keyStorage);
 }
 
 WriteNode WriteNode::addArray(std::string_view key)
@@ -70,12 +87,12 @@ WriteNode WriteNode::addArray(std::string_view key)
         return WriteNode();
     }
     yyjson_mut_doc *doc = s_asMutDoc(m_doc);
-    yyjson_mut_val *keyVal = yyjson_mut_strncpy(doc, key.data(), key.size());
+    yyjson_mut_val *keyVal = s_keyVal(doc, key, m_keyStorage);
     yyjson_mut_val *child = yyjson_mut_arr(doc);
     if (!yyjson_mut_obj_add(s_asMutVal(m_node), keyVal, child)) {
         return WriteNode();
     }
-    return WriteNode(m_doc, child);
+    return WriteNode(m_doc, child, m_floatFormat, m_keyStorage);
 }
 
 WriteNode WriteNode::appendObject()
@@ -87,7 +104,7 @@ WriteNode WriteNode::appendObject()
     if (!yyjson_mut_arr_append(s_asMutVal(m_node), child)) {
         return WriteNode();
     }
-    return WriteNode(m_doc, child);
+    return WriteNode(m_doc, child, m_floatFormat, m_keyStorage);
 }
 
 WriteNode WriteNode::appendArray()
@@ -99,7 +116,7 @@ WriteNode WriteNode::appendArray()
     if (!yyjson_mut_arr_append(s_asMutVal(m_node), child)) {
         return WriteNode();
     }
-    return WriteNode(m_doc, child);
+    return WriteNode(m_doc, child, m_floatFormat, m_keyStorage);
 }
 
 WriteNode WriteNode::addCopy(std::string_view key, ReadNode source)
@@ -112,11 +129,11 @@ WriteNode WriteNode::addCopy(std::string_view key, ReadNode source)
     if (child == nullptr) {
         return WriteNode();
     }
-    yyjson_mut_val *keyVal = yyjson_mut_strncpy(doc, key.data(), key.size());
+    yyjson_mut_val *keyVal = s_keyVal(doc, key, m_keyStorage);
     if (!yyjson_mut_obj_add(s_asMutVal(m_node), keyVal, child)) {
         return WriteNode();
     }
-    return WriteNode(m_doc, child);
+    return WriteNode(m_doc, child, m_floatFormat, m_keyStorage);
 }
 
 void WriteNode::set(std::string_view key, uint64_t v)
@@ -125,7 +142,7 @@ void WriteNode::set(std::string_view key, uint64_t v)
         return;
     }
     yyjson_mut_doc *doc = s_asMutDoc(m_doc);
-    yyjson_mut_val *keyVal = yyjson_mut_strncpy(doc, key.data(), key.size());
+    yyjson_mut_val *keyVal = s_keyVal(doc, key, m_keyStorage);
     yyjson_mut_obj_add(s_asMutVal(m_node), keyVal, yyjson_mut_uint(doc, v));
 }
 
@@ -135,7 +152,7 @@ void WriteNode::set(std::string_view key, int64_t v)
         return;
     }
     yyjson_mut_doc *doc = s_asMutDoc(m_doc);
-    yyjson_mut_val *keyVal = yyjson_mut_strncpy(doc, key.data(), key.size());
+    yyjson_mut_val *keyVal = s_keyVal(doc, key, m_keyStorage);
     yyjson_mut_obj_add(s_asMutVal(m_node), keyVal, yyjson_mut_sint(doc, v));
 }
 
@@ -145,8 +162,8 @@ void WriteNode::set(std::string_view key, float v)
         return;
     }
     yyjson_mut_doc *doc = s_asMutDoc(m_doc);
-    yyjson_mut_val *keyVal = yyjson_mut_strncpy(doc, key.data(), key.size());
-    yyjson_mut_obj_add(s_asMutVal(m_node), keyVal, s_floatVal(doc, v));
+    yyjson_mut_val *keyVal = s_keyVal(doc, key, m_keyStorage);
+    yyjson_mut_obj_add(s_asMutVal(m_node), keyVal, s_floatVal(doc, v, m_floatFormat));
 }
 
 void WriteNode::set(std::string_view key, double v)
@@ -155,7 +172,7 @@ void WriteNode::set(std::string_view key, double v)
         return;
     }
     yyjson_mut_doc *doc = s_asMutDoc(m_doc);
-    yyjson_mut_val *keyVal = yyjson_mut_strncpy(doc, key.data(), key.size());
+    yyjson_mut_val *keyVal = s_keyVal(doc, key, m_keyStorage);
     yyjson_mut_obj_add(s_asMutVal(m_node), keyVal, yyjson_mut_real(doc, v));
 }
 
@@ -165,7 +182,7 @@ void WriteNode::set(std::string_view key, bool v)
         return;
     }
     yyjson_mut_doc *doc = s_asMutDoc(m_doc);
-    yyjson_mut_val *keyVal = yyjson_mut_strncpy(doc, key.data(), key.size());
+    yyjson_mut_val *keyVal = s_keyVal(doc, key, m_keyStorage);
     yyjson_mut_obj_add(s_asMutVal(m_node), keyVal, yyjson_mut_bool(doc, v));
 }
 
@@ -175,7 +192,7 @@ void WriteNode::set(std::string_view key, std::string_view v)
         return;
     }
     yyjson_mut_doc *doc = s_asMutDoc(m_doc);
-    yyjson_mut_val *keyVal = yyjson_mut_strncpy(doc, key.data(), key.size());
+    yyjson_mut_val *keyVal = s_keyVal(doc, key, m_keyStorage);
     yyjson_mut_val *strVal = yyjson_mut_strncpy(doc, v.data(), v.size());
     yyjson_mut_obj_add(s_asMutVal(m_node), keyVal, strVal);
 }
@@ -201,7 +218,7 @@ void WriteNode::append(float v)
     if (!valid()) {
         return;
     }
-    yyjson_mut_arr_append(s_asMutVal(m_node), s_floatVal(s_asMutDoc(m_doc), v));
+    yyjson_mut_arr_append(s_asMutVal(m_node), s_floatVal(s_asMutDoc(m_doc), v, m_floatFormat));
 }
 
 void WriteNode::append(double v)
@@ -320,9 +337,34 @@ ReadNode ReadNode::at(size_t i) const
     return ReadNode(yyjson_arr_get(s_asVal(m_val), i));
 }
 
-SerialDocument::SerialDocument()
+std::vector<ReadNode> ReadNode::elements() const
+{
+    std::vector<ReadNode> out;
+    yyjson_val *val = s_asVal(m_val);
+    if (!yyjson_is_arr(val)) {
+        return out;
+    }
+
+    out.reserve(yyjson_arr_size(val));
+    size_t index = 0;
+    size_t count = 0;
+    yyjson_val *element = nullptr;
+    yyjson_arr_foreach(val, index, count, element)
+    {
+        out.push_back(ReadNode(element));
+    }
+    return out;
+}
+
+SerialDocument::SerialDocument(SerialFloatFormat floatFormat, SerialKeyStorage keyStorage)
+    : SerialDocument(nullptr, floatFormat, keyStorage)
+{
+}
+
+SerialDocument::SerialDocument(const void *allocator, SerialFloatFormat floatFormat, SerialKeyStorage keyStorage)
+    : m_floatFormat(floatFormat), m_keyStorage(keyStorage)
 {
-    m_mutDoc = yyjson_mut_doc_new(nullptr);
+    m_mutDoc = yyjson_mut_doc_new(static_cast<const yyjson_alc *>(allocator));
     if (m_mutDoc == nullptr) {
         RP_CORE_ERROR("failed to allocate write document");
         return;
@@ -341,7 +383,8 @@ SerialDocument::~SerialDocument()
     }
 }
 
-SerialDocument::SerialDocument(SerialDocument &&other) noexcept : m_mutDoc(other.m_mutDoc), m_doc(other.m_doc)
+SerialDocument::SerialDocument(SerialDocument &&other) noexcept
+    : m_mutDoc(other.m_mutDoc), m_doc(other.m_doc), m_floatFormat(other.m_floatFormat), m_keyStorage(other.m_keyStorage)
 {
     other.m_mutDoc = nullptr;
     other.m_doc = nullptr;
@@ -358,6 +401,8 @@ SerialDocument &SerialDocument::operator=(SerialDocument &&other) noexcept
         }
         m_mutDoc = other.m_mutDoc;
         m_doc = other.m_doc;
+        m_floatFormat = other.m_floatFormat;
+        m_keyStorage = other.m_keyStorage;
         other.m_mutDoc = nullptr;
         other.m_doc = nullptr;
     }
@@ -444,7 +489,7 @@ WriteNode SerialDocument::root()
         return WriteNode();
     }
     yyjson_mut_doc *doc = s_asMutDoc(m_mutDoc);
-    return WriteNode(m_mutDoc, yyjson_mut_doc_get_root(doc));
+    return WriteNode(m_mutDoc, yyjson_mut_doc_get_root(doc), m_floatFormat, m_keyStorage);
 }
 
 ReadNode SerialDocument::rootView() const
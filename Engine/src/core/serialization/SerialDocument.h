@@ -3,11 +3,29 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace Rapture {
 
+/**
+ * @brief How a write-mode document holds the floats written into it
+ */
+enum SerialFloatFormat : uint8_t {
+    SERIAL_FLOAT_TEXT,   // shortest text that reads back as the same float, for documents that become text
+    SERIAL_FLOAT_NATIVE, // the value itself, for documents that are frozen and read without ever being text
+};
+
+/**
+ * @brief Whether a write-mode document keeps its own copy of the keys written into it
+ */
+enum SerialKeyStorage : uint8_t {
+    SERIAL_KEYS_COPIED,   // any key may be written, including one built on the spot
+    SERIAL_KEYS_BORROWED, // keys are referenced where they are, so they must outlive the document
+};
+
 /**
  * @brief Non-owning write cursor into a SerialDocument being built.
  *
@@ -78,7 +96,7 @@ class WriteNode {
      * @brief Set a single precision member on this object node.
      *
      * Written as the shortest text that reads back as the same float, so a value like 0.8f
-     * stays "0.8" instead of the double it promotes to.
+     * stays "0.8" instead of the double it promotes to, unless the document holds native floats.
      *
      * @param key Member key.
      * @param v Value, must be finite.
@@ -134,7 +152,7 @@ class WriteNode {
      * @brief Append a single precision element to this array node.
      *
      * Written as the shortest text that reads back as the same float, so a value like 0.8f
-     * stays "0.8" instead of the double it promotes to.
+     * stays "0.8" instead of the double it promotes to, unless the document holds native floats.
      *
      * @param v Value, must be finite.
      */
@@ -171,10 +189,12 @@ class WriteNode {
 
   private:
     friend class SerialDocument;
-    WriteNode(void *doc, void *node);
+    WriteNode(void *doc, void *node, SerialFloatFormat floatFormat, SerialKeyStorage keyStorage);
 
     void *m_doc = nullptr;
     void *m_node = nullptr;
+    SerialFloatFormat m_floatFormat = SERIAL_FLOAT_TEXT;
+    SerialKeyStorage m_keyStorage = SERIAL_KEYS_COPIED;
 };
 
 /**
@@ -248,6 +268,14 @@ class ReadNode {
      */
     ReadNode at(size_t i) const;
 
+    /**
+     * @brief Cursors to every element of this array node, in order.
+     *
+     * Walks the array once, where calling at() for each index walks it again per element.
+     * @return One cursor per element, empty if this is not an array.
+     */
+    std::vector<ReadNode> elements() const;
+
   private:
     friend class SerialDocument;
     friend class WriteNode;
@@ -265,7 +293,12 @@ class ReadNode {
  */
 class SerialDocument {
   public:
-    SerialDocument();
+    /**
+     * @brief Opens a write-mode document
+     * @param floatFormat How floats are held, native only for a document that is frozen rather than turned to text
+     * @param keyStorage Whether keys are copied, or borrowed because every key written is a constant
+     */
+    explicit SerialDocument(SerialFloatFormat floatFormat = SERIAL_FLOAT_TEXT, SerialKeyStorage keyStorage = SERIAL_KEYS_COPIED);
     ~SerialDocument();
 
     SerialDocument(SerialDocument &&other) noexcept;
@@ -318,8 +351,20 @@ class SerialDocument {
     ReadNode rootView() const;
 
   private:
+    friend class SerialBinaryEncoder;
+    friend class SerialStreamWriter;
+    friend SerialDocument decodeSerialBinary(std::span<const uint8_t> bytes, uint32_t count);
+
+    /**
+     * @brief Opens a write-mode document that takes its memory from an allocator rather than the heap
+     * @param allocator The backend's allocator, nullptr for the heap
+     */
+    SerialDocument(const void *allocator, SerialFloatFormat floatFormat, SerialKeyStorage keyStorage);
+
     void *m_mutDoc = nullptr;
     void *m_doc = nullptr;
+    SerialFloatFormat m_floatFormat = SERIAL_FLOAT_TEXT;
+    SerialKeyStorage m_keyStorage = SERIAL_KEYS_COPIED;
 };
 
 } // namespace Rapture
@@ -0,0 +1,349 @@
+#include "SerialStream.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include <yyjson.h>
+
+#include "core/utils/Log.h"
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace Rapture {
+
+static constexpr size_t SERIAL_OUTPUT_BYTES = 64 * 1024;
+static constexpr size_t SERIAL_ARENA_BLOCK_BYTES = 256 * 1024;
+
+// What a thread keeps between saves; a save with a larger piece than this grows past it and gives the rest back.
+static constexpr size_t SERIAL_ARENA_RETAINED_BYTES = 16 * 1024 * 1024;
+
+static constexpr size_t SERIAL_ARENA_ALIGNMENT = 16;
+
+namespace {
+
+/**
+ * @brief Bump allocator over blocks that are kept when it is reset, so a save reuses the memory of the last one
+ */
+struct SerialArena {
+    struct Block {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size = 0;
+    };
+
+    std::vector<Block> blocks;
+    size_t block = 0;  // the block being allocated from
+    size_t offset = 0; // bytes used of it
+    bool inUse = false;
+    yyjson_alc alc;
+
+    SerialArena()
+    {
+        alc.malloc = [](void *ctx, size_t size) { return static_cast<SerialArena *>(ctx)->allocate(size); };
+        alc.realloc = [](void *ctx, void *ptr, size_t oldSize, size_t size) {
+            return static_cast<SerialArena *>(ctx)->reallocate(ptr, oldSize, size);
+        };
+        alc.free = [](void *, void *) {};
+        alc.ctx = this;
+    }
+
+    SerialArena(const SerialArena &) = delete;
+    SerialArena &operator=(const SerialArena &) = delete;
+
+    static size_t aligned(size_t size) { return (size + SERIAL_ARENA_ALIGNMENT - 1) & ~(SERIAL_ARENA_ALIGNMENT - 1); }
+
+    void *allocate(size_t size)
+    {
+        size = aligned(size);
+        for (; block < blocks.size(); block++, offset = 0) {
+            if (blocks[block].size - offset >= size) {
+                void *ptr = blocks[block].data.get() + offset;
+                offset += size;
+                return ptr;
+            }
+        }
+
+        const size_t blockSize = std::max(size, SERIAL_ARENA_BLOCK_BYTES);
+        blocks.push_back(Block{std::make_unique<uint8_t[]>(blockSize), blockSize});
+        block = blocks.size() - 1;
+        offset = size;
+        return blocks[block].data.get();
+    }
+
+    void *reallocate(void *ptr, size_t oldSize, size_t size)
+    {
+        // the text writer grows its buffer at the end of the block, where it can usually grow in place
+        if (ptr != nullptr && block < blocks.size()) {
+            uint8_t *end = blocks[block].data.get() + offset;
+            if (static_cast<uint8_t *>(ptr) + aligned(oldSize) == end) {
+                const size_t start = static_cast<size_t>(static_cast<uint8_t *>(ptr) - blocks[block].data.get());
+                if (blocks[block].size - start >= aligned(size)) {
+                    offset = start + aligned(size);
+                    return ptr;
+                }
+            }
+        }
+
+        void *moved = allocate(size);
+        if (ptr != nullptr) {
+            std::memcpy(moved, ptr, std::min(oldSize, size));
+        }
+        return moved;
+    }
+
+    void reset()
+    {
+        block = 0;
+        offset = 0;
+    }
+
+    /**
+     * @brief Gives back the blocks past what a thread keeps between saves
+     */
+    void trim()
+    {
+        size_t kept = 0;
+        size_t count = 0;
+        while (count < blocks.size() && kept + blocks[count].size <= SERIAL_ARENA_RETAINED_BYTES) {
+            kept += blocks[count].size;
+            count++;
+        }
+        blocks.resize(count);
+        reset();
+    }
+
+    size_t capacity() const
+    {
+        size_t total = 0;
+        for (const Block &b : blocks) {
+            total += b.size;
+        }
+        return total;
+    }
+};
+
+thread_local SerialArena s_arena;
+
+} // namespace
+
+static bool s_writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0) {
+#if defined(_WIN32)
+        const int written = _write(fd, data, static_cast<unsigned int>(std::min<size_t>(size, 1u << 30)));
+        if (written <= 0) {
+            return false;
+        }
+#else
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+#endif // _WIN32
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+SerialStreamWriter::SerialStreamWriter(int fd) : m_fd(fd)
+{
+    m_buffer.reserve(SERIAL_OUTPUT_BYTES);
+}
+
+SerialStreamWriter::~SerialStreamWriter()
+{
+    if (!m_scopes.empty() || !m_buffer.empty()) {
+        finish();
+    }
+    if (!s_arena.inUse) {
+        s_arena.trim();
+    }
+}
+
+void SerialStreamWriter::write(std::string_view text)
+{
+    // a piece larger than the buffer goes out as it is rather than through it
+    if (text.size() >= SERIAL_OUTPUT_BYTES) {
+        flush();
+        if (!m_failed && !s_writeAll(m_fd, text.data(), text.size())) {
+            RP_CORE_ERROR("failed to write {} bytes of text", text.size());
+            m_failed = true;
+        }
+        m_bytesWritten += text.size();
+        return;
+    }
+
+    if (m_buffer.size() + text.size() > SERIAL_OUTPUT_BYTES) {
+        flush();
+    }
+    m_buffer.insert(m_buffer.end(), text.begin(), text.end());
+}
+
+void SerialStreamWriter::flush()
+{
+    if (m_buffer.empty()) {
+        return;
+    }
+
+    if (!m_failed && !s_writeAll(m_fd, m_buffer.data(), m_buffer.size())) {
+        RP_CORE_ERROR("failed to write {} bytes of text", m_buffer.size());
+        m_failed = true;
+    }
+    m_bytesWritten += m_buffer.size();
+    m_buffer.clear();
+}
+
+void SerialStreamWriter::beginValue(std::string_view key, bool hasKey)
+{
+    if (m_scopes.empty()) {
+        if (m_bytesWritten > 0 || !m_buffer.empty() || hasKey) {
+            RP_CORE_ERROR("a document has one root value, and it has no key");
+            m_failed = true;
+        }
+        return;
+    }
+
+    Scope &scope = m_scopes.back();
+    if (scope.isArray && hasKey) {
+        RP_CORE_ERROR("an array element cannot have a key");
+        m_failed = true;
+    } else if (!scope.isArray && !hasKey) {
+        RP_CORE_ERROR("an object member needs a key");
+        m_failed = true;
+    }
+
+    if (!scope.empty) {
+        write(",");
+    }
+    scope.empty = false;
+
+    if (hasKey) {
+        // written by yyjson like everything else, so a key is escaped the way toText escapes one
+        yyjson_mut_val keyVal{};
+        yyjson_mut_set_strn(&keyVal, key.data(), key.size());
+
+        size_t length = 0;
+        char *text = yyjson_mut_val_write_opts(&keyVal, YYJSON_WRITE_NOFLAG, nullptr, &length, nullptr);
+        if (text == nullptr) {
+            RP_CORE_ERROR("failed to write the key '{}'", key);
+            m_failed = true;
+            return;
+        }
+        write(std::string_view(text, length));
+        write(":");
+        free(text);
+    }
+}
+
+void SerialStreamWriter::beginObject()
+{
+    beginValue({}, false);
+    write("{");
+    m_scopes.push_back(Scope{false, true});
+}
+
+void SerialStreamWriter::beginObject(std::string_view key)
+{
+    beginValue(key, true);
+    write("{");
+    m_scopes.push_back(Scope{false, true});
+}
+
+void SerialStreamWriter::beginArray(std::string_view key)
+{
+    beginValue(key, true);
+    write("[");
+    m_scopes.push_back(Scope{true, true});
+}
+
+void SerialStreamWriter::end()
+{
+    if (m_scopes.empty()) {
+        RP_CORE_ERROR("nothing is open to be closed");
+        m_failed = true;
+        return;
+    }
+
+    write(m_scopes.back().isArray ? "]" : "}");
+    m_scopes.pop_back();
+}
+
+WriteNode SerialStreamWriter::openPiece()
+{
+    // a piece opened while another one on this thread is still open takes its memory from the heap instead
+    m_pieceFromArena = !s_arena.inUse;
+    s_arena.inUse = true;
+
+    const yyjson_alc *allocator = m_pieceFromArena ? &s_arena.alc : nullptr;
+    m_piece = SerialDocument(allocator, SERIAL_FLOAT_TEXT, SERIAL_KEYS_BORROWED);
+    return m_piece->root();
+}
+
+void SerialStreamWriter::closePiece(bool membersOnly)
+{
+    yyjson_mut_doc *doc = m_piece.has_value() ? static_cast<yyjson_mut_doc *>(m_piece->m_mutDoc) : nullptr;
+    yyjson_mut_val *root = doc != nullptr ? yyjson_mut_doc_get_root(doc) : nullptr;
+
+    size_t length = 0;
+    char *text = nullptr;
+    if (root != nullptr) {
+        text = yyjson_mut_val_write_opts(root, YYJSON_WRITE_NOFLAG, m_pieceFromArena ? &s_arena.alc : nullptr, &length, nullptr);
+    }
+
+    if (text == nullptr) {
+        RP_CORE_ERROR("failed to write a piece of a document");
+        m_failed = true;
+    } else if (membersOnly) {
+        if (m_scopes.empty() || m_scopes.back().isArray) {
+            RP_CORE_ERROR("members can only be written into an open object");
+            m_failed = true;
+        } else if (length > 2) {
+            // the piece is an object of its own, the members are what sits between its braces
+            if (!m_scopes.back().empty) {
+                write(",");
+            }
+            m_scopes.back().empty = false;
+            write(std::string_view(text + 1, length - 2));
+        }
+    } else {
+        beginValue({}, false);
+        write(std::string_view(text, length));
+    }
+
+    if (!m_pieceFromArena) {
+        free(text);
+    }
+    m_piece.reset();
+
+    if (m_pieceFromArena) {
+        s_arena.reset();
+        s_arena.inUse = false;
+        m_pieceFromArena = false;
+    }
+}
+
+bool SerialStreamWriter::finish()
+{
+    while (!m_scopes.empty()) {
+        end();
+    }
+    flush();
+    return !m_failed;
+}
+
+size_t SerialStreamWriter::threadArenaBytes()
+{
+    return s_arena.capacity();
+}
+
+} // namespace Rapture
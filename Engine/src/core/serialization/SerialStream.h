@@ -0,0 +1,136 @@
+#ifndef RAPTURE__SERIAL_STREAM_H
+#define RAPTURE__SERIAL_STREAM_H
+
+#include "core/serialization/SerialDocument.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace Rapture {
+
+/**
+ * @brief Writes JSON text straight to a file descriptor, one piece at a time.
+ *
+ * The outer structure is opened and closed as it is written, and what goes inside it is written in pieces:
+ * each piece is a small document built through the usual WriteNode calls, turned to text and sent on before
+ * the next one is started. The pieces take their memory from an arena the calling thread keeps from one save
+ * to the next, and their keys are borrowed rather than copied, so every key written has to be a constant. What
+ * a save holds at once is the largest piece and a fixed output buffer, however much it writes in total.
+ *
+ * The text is the same as SerialDocument::toText gives for the same document, without the pretty printing.
+ */
+class SerialStreamWriter {
+  public:
+    /**
+     * @brief Starts writing
+     * @param fd An open descriptor to write to, which stays the caller's to close
+     */
+    explicit SerialStreamWriter(int fd);
+    ~SerialStreamWriter();
+
+    SerialStreamWriter(const SerialStreamWriter &) = delete;
+    SerialStreamWriter &operator=(const SerialStreamWriter &) = delete;
+
+    /**
+     * @brief Opens the root object, or an object element of the array that is open
+     */
+    void beginObject();
+
+    /**
+     * @brief Opens an object member of the object that is open
+     * @param key The member's key
+     */
+    void beginObject(std::string_view key);
+
+    /**
+     * @brief Opens an array member of the object that is open
+     * @param key The member's key
+     */
+    void beginArray(std::string_view key);
+
+    /**
+     * @brief Closes the object or array opened last
+     */
+    void end();
+
+    /**
+     * @brief Writes members into the object that is open
+     * @param fn Called with a cursor to an empty object, whose members become the open object's
+     */
+    template <typename Fn>
+    void writeMembers(Fn &&fn)
+    {
+        WriteNode node = openPiece();
+        if (node.valid()) {
+            fn(node);
+        }
+        closePiece(true);
+    }
+
+    /**
+     * @brief Appends an object element to the array that is open
+     * @param fn Called with a cursor to the element
+     */
+    template <typename Fn>
+    void appendObject(Fn &&fn)
+    {
+        WriteNode node = openPiece();
+        if (node.valid()) {
+            fn(node);
+        }
+        closePiece(false);
+    }
+
+    /**
+     * @brief Closes whatever is still open and sends the rest of the text on
+     * @return False if anything could not be written, at any point of the save
+     */
+    bool finish();
+
+    /**
+     * @brief How many bytes have been sent to the descriptor so far
+     */
+    uint64_t bytesWritten() const { return m_bytesWritten; }
+
+    /**
+     * @brief How much memory the calling thread's arena holds on to between saves
+     */
+    static size_t threadArenaBytes();
+
+  private:
+    struct Scope {
+        bool isArray = false;
+        bool empty = true;
+    };
+
+    /**
+     * @brief Writes whatever separates the next value from the one before it, and its key if it has one
+     */
+    void beginValue(std::string_view key, bool hasKey);
+
+    WriteNode openPiece();
+
+    /**
+     * @brief Turns the open piece to text and writes it, then hands its memory back to the arena
+     * @param membersOnly Whether only the members are written, into the object that is open
+     */
+    void closePiece(bool membersOnly);
+
+    void write(std::string_view text);
+    void flush();
+
+    int m_fd = -1;
+    std::vector<char> m_buffer;
+    std::vector<Scope> m_scopes;
+    std::optional<SerialDocument> m_piece;
+    bool m_pieceFromArena = false;
+    uint64_t m_bytesWritten = 0;
+    bool m_failed = false;
+};
+
+} // namespace Rapture
+
+#endif // RAPTURE__SERIAL_STREAM_H
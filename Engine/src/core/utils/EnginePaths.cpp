@@ -15,6 +15,7 @@ static std::filesystem::path s_executable;
 static std::filesystem::path s_executableDirectory;
 static std::filesystem::path s_assetDirectory;
 static std::filesystem::path s_shaderDirectory;
+static std::filesystem::path s_shaderCacheDirectory;
 
 static std::filesystem::path s_resolveExecutable()
 {
@@ -46,6 +47,8 @@ void EnginePaths::init()
     s_executableDirectory = s_executable.parent_path();
     s_assetDirectory = s_executableDirectory / "assets";
     s_shaderDirectory = s_assetDirectory / "engine/shaders";
+    // beside the executable rather than under the assets, which a development build links back to the source tree
+    s_shaderCacheDirectory = s_executableDirectory / "cache/shaders";
 
     RP_CORE_INFO("Engine assets: {}", s_assetDirectory.string());
 }
@@ -70,4 +73,9 @@ const std::filesystem::path &EnginePaths::shaderDirectory()
     return s_shaderDirectory;
 }
 
+const std::filesystem::path &EnginePaths::shaderCacheDirectory()
+{
+    return s_shaderCacheDirectory;
+}
+
 } // namespace Rapture
@@ -34,6 +34,11 @@ class EnginePaths {
      * @brief The engine's own shaders
      */
     static const std::filesystem::path &shaderDirectory();
+
+    /**
+     * @brief Where compiled shaders and their reflection are cached between runs
+     */
+    static const std::filesystem::path &shaderCacheDirectory();
 };
 
 } // namespace Rapture
@@ -60,6 +60,40 @@ void Buffer::addData(void *newData, VkDeviceSize size, VkDeviceSize offset)
     vmaUnmapMemory(m_Allocator, m_Allocation);
 }
 
+void Buffer::addDataRegions(const std::vector<BufferWriteRegion> &regions)
+{
+    if (regions.empty()) {
+        return;
+    }
+
+    if (!(m_propertiesFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+        RP_CORE_ERROR("Buffer is not host visible! Use addDataGPU for device local buffers.");
+        return;
+    }
+
+    void *mappedData;
+    if (vmaMapMemory(m_Allocator, m_Allocation, &mappedData) != VK_SUCCESS) {
+        RP_CORE_ERROR("Failed to map memory!");
+        return;
+    }
+
+    bool coherent = m_propertiesFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    for (const auto &region : regions) {
+        if (region.offset + region.size > m_Size) {
+            RP_CORE_ERROR("Buffer overflow detected! Attempted to write {} bytes at offset {} in buffer of size {}", region.size,
+                          region.offset, m_Size);
+            continue;
+        }
+
+        memcpy(static_cast<char *>(mappedData) + region.offset, region.data, region.size);
+        if (!coherent) {
+            vmaFlushAllocation(m_Allocator, m_Allocation, region.offset, region.size);
+        }
+    }
+
+    vmaUnmapMemory(m_Allocator, m_Allocation);
+}
+
 void Buffer::readData(void *destination, VkDeviceSize size, VkDeviceSize offset)
 {
     if (offset + size > m_Size) {
@@ -15,6 +15,15 @@ namespace Rapture {
 
 struct BufferAllocation;
 
+/**
+ * @brief One range of CPU memory to copy into a buffer, see Buffer::addDataRegions
+ */
+struct BufferWriteRegion {
+    const void *data = nullptr;
+    VkDeviceSize size = 0;
+    VkDeviceSize offset = 0; // destination byte offset into the buffer
+};
+
 enum class BufferUsage {
     STATIC,  // gpu only
     DYNAMIC, // host visible
@@ -31,6 +40,14 @@ class Buffer : public std::enable_shared_from_this<Buffer> {
     virtual void destoryObjects();
 
     virtual void addData(void *newData, VkDeviceSize size, VkDeviceSize offset);
+
+    /**
+     * @brief Copy several ranges into a host visible buffer under a single map
+     *
+     * Regions are checked one by one, an out of range region is skipped and logged, the others are still written.
+     * @param regions The ranges to copy, in any order but not overlapping
+     */
+    void addDataRegions(const std::vector<BufferWriteRegion> &regions);
     // needs to be subclass specific because of the staging buffer being created
     // could probably find a way around it but its fine
     virtual void addDataGPU(void *data, VkDeviceSize size, VkDeviceSize offset) = 0;
@@ -1,22 +1,22 @@
 #include "Shader.h"
 
 #include "gpu/descriptors/DescriptorManager.h"
-#include "core/events/ShaderEvents.h"
 #include "core/utils/Log.h"
 #include "core/utils/io.h"
 #include "app/Application.h"
 
+#include "ShaderCache.h"
+#include "ShaderHotReload.h"
 #include "ShaderReflections.h"
 
 #include <algorithm>
+#include <atomic>
 
 namespace Rapture {
 
-Shader::Shader()
-{
-    m_sourceChangedListener =
-        ShaderEvents::onShaderSourceChanged().addListener([this](std::string_view fileName) { onSourceChanged(fileName); });
-}
+static std::atomic<uint64_t> s_nextReloadId{1};
+
+Shader::Shader() : m_reloadId(s_nextReloadId.fetch_add(1, std::memory_order_relaxed)) {}
 
 // Legacy constructor: vertex + fragment
 Shader::Shader(const std::filesystem::path &vertexPath, const std::filesystem::path &fragmentPath, ShaderCompileInfo compileInfo)
@@ -49,7 +49,7 @@ Shader::Shader(const std::filesystem::path &computePath, ShaderCompileInfo compi
 
 Shader::~Shader()
 {
-    ShaderEvents::onShaderSourceChanged().removeListener(m_sourceChangedListener);
+    ShaderHotReload::untrackShader(*this);
     cleanup();
 }
 
@@ -76,47 +76,6 @@ void Shader::cleanup()
     m_pipelineStages.clear();
 }
 
-void Shader::scanDirectIncludes()
-{
-    m_directIncludes.clear();
-
-    for (const auto &stage : m_stages) {
-        if (stage.sourcePath.extension() == ".spv") {
-            continue;
-        }
-
-        std::string source = readFileAsString(stage.sourcePath);
-        size_t pos = 0;
-        while ((pos = source.find("#include", pos)) != std::string::npos) {
-            size_t open = source.find('"', pos);
-            size_t lineEnd = source.find('\n', pos);
-            if (open == std::string::npos || (lineEnd != std::string::npos && open > lineEnd)) {
-                pos += 8;
-                continue;
-            }
-            size_t close = source.find('"', open + 1);
-            if (close == std::string::npos) {
-                break;
-            }
-
-            std::string included(source.substr(open + 1, close - open - 1));
-            std::string name = std::filesystem::path(included).filename().string();
-            if (std::find(m_directIncludes.begin(), m_directIncludes.end(), name) == m_directIncludes.end()) {
-                m_directIncludes.push_back(std::move(name));
-            }
-            pos = close + 1;
-        }
-    }
-}
-
-void Shader::onSourceChanged(std::string_view fileName)
-{
-    if (std::find(m_directIncludes.begin(), m_directIncludes.end(), fileName) == m_directIncludes.end()) {
-        return;
-    }
-    recompile();
-}
-
 Shader &Shader::addStage(ShaderType type, const std::filesystem::path &path)
 {
     // Check for duplicate stage
@@ -167,19 +126,82 @@ const VkShaderModule &Shader::getModule(ShaderType type) const
     return nullModule;
 }
 
-bool Shader::compileStage(ShaderStage &stage)
+/**
+ * @brief Fills a stage's SPIR-V, reflection and includes, from the shader cache when it holds the stage
+ */
+static bool s_loadStageSpirv(ShaderStage &stage, const ShaderCompileInfo &compileInfo, ShaderCompiler &compiler)
 {
+    const VkShaderStageFlags stageFlags = shaderTypeToVkStage(stage.type);
+
     if (stage.sourcePath.extension() == ".spv") {
         stage.spirv = readFile(stage.sourcePath);
-    } else {
-        stage.spirv = m_compiler.Compile(stage.sourcePath, m_compileInfo);
+        if (stage.spirv.empty()) {
+            return false;
+        }
+        if (ShaderCache::loadReflection(stage.spirv, stage.reflection)) {
+            return true;
+        }
+        if (!reflectStageSpirv(stage.spirv, stageFlags, stage.reflection)) {
+            RP_CORE_ERROR("Failed to create reflection data for stage {}", shaderTypeToString(stage.type));
+            return false;
+        }
+        ShaderCache::storeReflection(stage.spirv, stage.reflection);
+        return true;
+    }
+
+    ShaderCache::Entry entry;
+    if (ShaderCache::loadCompiled(stage.sourcePath, compileInfo, entry)) {
+        stage.spirv = std::move(entry.spirv);
+        stage.reflection = std::move(entry.reflection);
+        stage.includedFiles = std::move(entry.includedFiles);
+        return true;
     }
 
-    if (stage.spirv.empty()) {
-        RP_CORE_ERROR("Failed to compile shader: {}", stage.sourcePath.string());
+    entry.spirv = compiler.Compile(stage.sourcePath, compileInfo, &entry.includedFiles);
+    if (entry.spirv.empty()) {
         return false;
     }
+    if (!reflectStageSpirv(entry.spirv, stageFlags, entry.reflection)) {
+        RP_CORE_ERROR("Failed to create reflection data for stage {}", shaderTypeToString(stage.type));
+        return false;
+    }
+    // the annotations live in comments, so they are only ever read from the source
+    entry.reflection.annotations = parsePushConstantAnnotations(readFileAsString(stage.sourcePath));
+
+    ShaderCache::storeCompiled(stage.sourcePath, compileInfo, entry.includedFiles, entry);
+    stage.spirv = std::move(entry.spirv);
+    stage.reflection = std::move(entry.reflection);
+    stage.includedFiles = std::move(entry.includedFiles);
+    return true;
+}
+
+bool Shader::buildStages(std::vector<ShaderStage> &stages, const ShaderCompileInfo &compileInfo)
+{
+    ShaderCompiler compiler;
+    for (auto &stage : stages) {
+        if (!s_loadStageSpirv(stage, compileInfo, compiler)) {
+            RP_CORE_ERROR("Failed to compile shader: {}", stage.sourcePath.string());
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<ShaderStage> Shader::getStageSources() const
+{
+    std::vector<ShaderStage> sources;
+    sources.reserve(m_stages.size());
+    for (const auto &stage : m_stages) {
+        ShaderStage source;
+        source.type = stage.type;
+        source.sourcePath = stage.sourcePath;
+        sources.push_back(std::move(source));
+    }
+    return sources;
+}
 
+bool Shader::createStageModule(ShaderStage &stage)
+{
     // Create VkShaderModule
     Application &app = Application::getInstance();
     VkDevice device = app.getVulkanContext().getLogicalDevice();
@@ -199,57 +221,30 @@ bool Shader::compileStage(ShaderStage &stage)
 
 void Shader::reflectStage(const ShaderStage &stage)
 {
-    VkShaderStageFlags stageFlags = shaderTypeToVkStage(stage.type);
-
-    const uint32_t *spirvData = reinterpret_cast<const uint32_t *>(stage.spirv.data());
-    size_t spirvSize = stage.spirv.size();
-
-    SpvReflectShaderModule module;
-    SpvReflectResult result = spvReflectCreateShaderModule(spirvSize, spirvData, &module);
-    if (result != SPV_REFLECT_RESULT_SUCCESS) {
-        RP_CORE_ERROR("Failed to create reflection data for stage {}", shaderTypeToString(stage.type));
-        return;
-    }
+    for (const auto &stageSet : stage.reflection.descriptorSets) {
+        uint32_t setNumber = stageSet.setNumber;
 
-    // Reflect descriptor bindings
-    uint32_t count = 0;
-    result = spvReflectEnumerateDescriptorBindings(&module, &count, nullptr);
-    if (result == SPV_REFLECT_RESULT_SUCCESS && count > 0) {
-        std::vector<SpvReflectDescriptorBinding *> bindings(count);
-        result = spvReflectEnumerateDescriptorBindings(&module, &count, bindings.data());
+        // Find or create set info
+        auto it = std::find_if(m_descriptorSetInfos.begin(), m_descriptorSetInfos.end(),
+                               [setNumber](const DescriptorSetInfo &info) { return info.setNumber == setNumber; });
 
-        for (auto binding : bindings) {
-            DescriptorBindingInfo bindingInfo{};
-            bindingInfo.binding = binding->binding;
-            bindingInfo.descriptorType = static_cast<VkDescriptorType>(binding->descriptor_type);
-            bindingInfo.descriptorCount = binding->count;
-            bindingInfo.stageFlags = stageFlags;
-            bindingInfo.name = binding->name ? binding->name : "unnamed";
-
-            uint32_t setNumber = binding->set;
-
-            // Find or create set info
-            auto it = std::find_if(m_descriptorSetInfos.begin(), m_descriptorSetInfos.end(),
-                                   [setNumber](const DescriptorSetInfo &info) { return info.setNumber == setNumber; });
-
-            if (it == m_descriptorSetInfos.end()) {
-                m_descriptorSetInfos.push_back(DescriptorSetInfo{setNumber, {}});
-                it = m_descriptorSetInfos.end() - 1;
-            }
+        if (it == m_descriptorSetInfos.end()) {
+            m_descriptorSetInfos.push_back(DescriptorSetInfo{setNumber, {}});
+            it = m_descriptorSetInfos.end() - 1;
+        }
 
+        for (const auto &bindingInfo : stageSet.bindings) {
             // Check if binding already exists (merge stage flags)
             auto bindIt = std::find_if(it->bindings.begin(), it->bindings.end(),
                                        [&](const DescriptorBindingInfo &b) { return b.binding == bindingInfo.binding; });
 
             if (bindIt != it->bindings.end()) {
-                bindIt->stageFlags |= stageFlags;
+                bindIt->stageFlags |= bindingInfo.stageFlags;
             } else {
                 it->bindings.push_back(bindingInfo);
             }
         }
     }
-
-    spvReflectDestroyShaderModule(&module);
 }
 
 void Shader::mergeReflectionData()
@@ -264,43 +259,36 @@ void Shader::mergeReflectionData()
                   [](const DescriptorBindingInfo &a, const DescriptorBindingInfo &b) { return a.binding < b.binding; });
     }
 
-    // Extract push constants from all stages
-    std::vector<std::pair<std::vector<char>, VkShaderStageFlags>> stageSpirvs;
+    // Merge push constants from all stages
+    std::vector<PushConstantInfo> stagePushConstants;
     for (const auto &stage : m_stages) {
-        stageSpirvs.push_back({stage.spirv, shaderTypeToVkStage(stage.type)});
+        stagePushConstants.insert(stagePushConstants.end(), stage.reflection.pushConstants.begin(),
+                                  stage.reflection.pushConstants.end());
     }
 
-    std::vector<PushConstantInfo> pushConstantInfos = getCombinedPushConstantRanges(stageSpirvs);
+    std::vector<PushConstantInfo> pushConstantInfos = mergePushConstantRanges(stagePushConstants);
     m_pushConstantLayouts = pushConstantInfoToRanges(pushConstantInfos);
 
-    // Extract detailed push constants from first stage that has them
+    // Take detailed push constants from first stage that has them
     for (const auto &stage : m_stages) {
-        auto detailed = extractDetailedPushConstants(stage.spirv);
-        if (!detailed.empty()) {
-            m_detailedPushConstants = detailed;
+        if (!stage.reflection.detailedPushConstants.empty()) {
+            m_detailedPushConstants = stage.reflection.detailedPushConstants;
             break;
         }
     }
 
-    // Parse and apply push constant annotations from GLSL source files
-    // (skip for .spv files as they don't have comments)
+    // Apply push constant annotations parsed from the GLSL source files
+    // (precompiled .spv stages carry none, as they don't have comments)
     for (const auto &stage : m_stages) {
-        if (stage.sourcePath.extension() != ".spv") {
-            std::string glslSource = readFileAsString(stage.sourcePath);
-            if (!glslSource.empty()) {
-                auto annotations = parsePushConstantAnnotations(glslSource);
-                if (!annotations.empty()) {
-                    applyPushConstantAnnotations(m_detailedPushConstants, annotations);
-                    break; // Only need annotations from one file
-                }
-            }
+        if (!stage.reflection.annotations.empty()) {
+            applyPushConstantAnnotations(m_detailedPushConstants, stage.reflection.annotations);
+            break; // Only need annotations from one file
         }
     }
 
-    // Extract material sets
+    // Merge material sets
     for (const auto &stage : m_stages) {
-        std::vector<DescriptorInfo> stageMaterialSets = extractMaterialSets(stage.spirv);
-        for (const auto &matSet : stageMaterialSets) {
+        for (const auto &matSet : stage.reflection.materialSets) {
             auto it = std::find_if(m_materialSets.begin(), m_materialSets.end(), [&](const DescriptorInfo &existing) {
                 return existing.setNumber == matSet.setNumber && existing.binding == matSet.binding;
             });
@@ -342,15 +330,29 @@ bool Shader::compile()
     }
 
     // Compile all stages
+    if (!buildStages(m_stages, m_compileInfo)) {
+        m_status = ShaderStatus::FAILED;
+        return false;
+    }
+
     for (auto &stage : m_stages) {
-        if (!compileStage(stage)) {
+        if (!createStageModule(stage)) {
             m_status = ShaderStatus::FAILED;
             return false;
         }
     }
 
+    finishCompile();
+    return true;
+}
+
+void Shader::finishCompile()
+{
     // Reflect all stages
     m_descriptorSetInfos.clear();
+    m_pushConstantLayouts.clear();
+    m_detailedPushConstants.clear();
+    m_materialSets.clear();
     for (const auto &stage : m_stages) {
         reflectStage(stage);
     }
@@ -361,10 +363,9 @@ bool Shader::compile()
     // Build pipeline stage infos
     buildPipelineStages();
 
-    scanDirectIncludes();
+    ShaderHotReload::trackShader(*this);
 
     m_status = ShaderStatus::COMPILED;
-    return true;
 }
 
 bool Shader::createDescriptorLayouts()
@@ -494,18 +495,40 @@ bool Shader::recompile()
         return false;
     }
 
-    cleanup();
+    // built aside first, so a source that no longer compiles leaves the working shader in place
+    std::vector<ShaderStage> stages = getStageSources();
+    if (!buildStages(stages, m_compileInfo)) {
+        RP_CORE_ERROR("Failed to recompile shader, keeping the previous build");
+        return false;
+    }
 
-    m_descriptorSetInfos.clear();
-    m_pushConstantLayouts.clear();
-    m_detailedPushConstants.clear();
-    m_materialSets.clear();
-    for (auto &stage : m_stages) {
-        stage.spirv.clear();
+    return applyRebuild(std::move(stages));
+}
+
+bool Shader::applyRebuild(std::vector<ShaderStage> &&stages)
+{
+    // every new module is created before the old ones go, so a stage that fails leaves the previous build in place
+    for (auto &stage : stages) {
+        if (createStageModule(stage)) {
+            continue;
+        }
+
+        VkDevice device = Application::getInstance().getVulkanContext().getLogicalDevice();
+        for (auto &created : stages) {
+            if (created.module != VK_NULL_HANDLE) {
+                vkDestroyShaderModule(device, created.module, nullptr);
+                created.module = VK_NULL_HANDLE;
+            }
+        }
+        RP_CORE_ERROR("Failed to recompile shader, keeping the previous build");
+        return false;
     }
-    m_status = ShaderStatus::STAGES_ADDED;
 
-    if (!build()) {
+    cleanup();
+    m_stages = std::move(stages);
+    finishCompile();
+
+    if (!createDescriptorLayouts()) {
         m_status = ShaderStatus::FAILED;
         RP_CORE_ERROR("Failed to recompile shader");
         return false;
@@ -34,6 +34,8 @@ struct ShaderStage {
     ShaderType type;
     std::filesystem::path sourcePath;
     std::vector<char> spirv;
+    ShaderStageReflection reflection; // filled with the SPIR-V, from the shader cache when it holds the stage
+    std::vector<std::filesystem::path> includedFiles; // every file the source pulled in, nested includes too
     VkShaderModule module = VK_NULL_HANDLE;
 
     bool isCompiled() const { return !spirv.empty(); }
@@ -105,6 +107,39 @@ class Shader {
      */
     bool recompile();
 
+    /**
+     * @brief Compiles stages to SPIR-V and reflects them, touching neither the device nor any shader
+     *
+     * Safe to run on any thread while the shader the stages came from is in use, so hot reload can
+     * compile in the background and hand the result to applyRebuild() at a frame boundary.
+     * @param stages Stages holding a type and source path, filled with SPIR-V, reflection and includes
+     * @param compileInfo The include path and macros to compile with
+     * @return True if every stage compiled
+     */
+    static bool buildStages(std::vector<ShaderStage> &stages, const ShaderCompileInfo &compileInfo);
+
+    /**
+     * @brief Swaps in stages built by buildStages(), replacing the modules and layouts in place
+     *
+     * The caller must ensure the device is idle first. Fires onRecompiled() on success. If a module cannot be
+     * created the shader keeps its previous modules and layouts.
+     * @param stages The compiled stages, taken over by the shader
+     * @return True if the modules and layouts were created
+     */
+    bool applyRebuild(std::vector<ShaderStage> &&stages);
+
+    /**
+     * @brief The stage types and source paths alone, to hand to buildStages() for a rebuild
+     */
+    std::vector<ShaderStage> getStageSources() const;
+
+    const ShaderCompileInfo &getCompileInfo() const { return m_compileInfo; }
+
+    /**
+     * @brief Identifies this shader to hot reload, never reused by another shader
+     */
+    uint64_t getReloadId() const { return m_reloadId; }
+
     /**
      * @brief Fired after a successful recompile so dependent pipelines can rebuild
      * @return The signal to connect pipeline rebuilds to
@@ -133,9 +168,8 @@ class Shader {
 
   private:
     void cleanup();
-    void scanDirectIncludes();
-    void onSourceChanged(std::string_view fileName);
-    bool compileStage(ShaderStage &stage);
+    bool createStageModule(ShaderStage &stage);
+    void finishCompile();
     void reflectStage(const ShaderStage &stage);
     void mergeReflectionData();
     void createDescriptorSetLayoutFromInfo(const DescriptorSetInfo &setInfo);
@@ -143,7 +177,6 @@ class Shader {
 
     std::vector<ShaderStage> m_stages;
     ShaderCompileInfo m_compileInfo;
-    ShaderCompiler m_compiler;
     ShaderStatus m_status = ShaderStatus::UNINITIALIZED;
 
     // Pipeline stage info (built after createModules)
@@ -159,8 +192,7 @@ class Shader {
 
     EventSignal<void()> m_onRecompiled;
 
-    std::vector<std::string> m_directIncludes;
-    EventListenerId m_sourceChangedListener = 0;
+    uint64_t m_reloadId = 0;
 };
 
 } // namespace Rapture
@@ -0,0 +1,499 @@
+#include "ShaderCache.h"
+
+#include "core/utils/EnginePaths.h"
+#include "core/utils/Log.h"
+#include "core/utils/io.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string_view>
+#include <thread>
+
+namespace Rapture {
+
+static constexpr uint32_t SHADER_REFL_MAGIC = 0x46525352; // "RSRF"
+// Bump whenever the encoding below or anything it reflects changes, stale entries are then ignored
+static constexpr uint32_t SHADER_REFL_VERSION = 1;
+
+// Fixed header at the start of every `.refl`. The dependency table follows, then the reflection.
+struct ShaderReflHeader {
+    uint32_t magic = SHADER_REFL_MAGIC;
+    uint32_t version = SHADER_REFL_VERSION;
+    uint64_t spirvSize = 0;
+    uint64_t spirvChecksum = 0;
+    uint32_t dependencyCount = 0;
+    uint32_t reserved = 0;
+};
+
+static_assert(sizeof(ShaderReflHeader) == 32, "shader reflection header is a fixed 32-byte block");
+
+static std::atomic<bool> s_enabled{true};
+
+// FNV-1a, 64 bits since it doubles as the cache key
+static uint64_t s_checksum(std::span<const uint8_t> bytes, uint64_t hash = 14695981039346656037ull)
+{
+    for (uint8_t b : bytes) {
+        hash ^= b;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint64_t s_checksum(std::string_view str, uint64_t hash = 14695981039346656037ull)
+{
+    return s_checksum(std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(str.data()), str.size()), hash);
+}
+
+static uint64_t s_checksum(const std::vector<char> &bytes)
+{
+    return s_checksum(std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size()));
+}
+
+template <typename T>
+static void s_append(std::vector<uint8_t> &out, const T &value)
+{
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+static void s_appendString(std::vector<uint8_t> &out, std::string_view str)
+{
+    s_append(out, static_cast<uint32_t>(str.size()));
+    out.insert(out.end(), str.begin(), str.end());
+}
+
+struct ByteReader {
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    size_t pos = 0;
+    bool ok = true;
+
+    template <typename T>
+    T read()
+    {
+        T value{};
+        if (pos + sizeof(T) > size) {
+            ok = false;
+            return value;
+        }
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    std::string readString()
+    {
+        uint32_t length = read<uint32_t>();
+        if (!ok || pos + length > size) {
+            ok = false;
+            return {};
+        }
+        std::string str(reinterpret_cast<const char *>(data + pos), length);
+        pos += length;
+        return str;
+    }
+
+    // Guards a count read from the file before it sizes an allocation
+    uint32_t readCount(size_t minElementSize)
+    {
+        uint32_t count = read<uint32_t>();
+        if (!ok || static_cast<size_t>(count) * minElementSize > size - pos) {
+            ok = false;
+            return 0;
+        }
+        return count;
+    }
+};
+
+static void s_appendMetadata(std::vector<uint8_t> &out, const PushConstantMemberMetadata &metadata)
+{
+    s_appendString(out, metadata.displayName);
+    s_append(out, metadata.minValue);
+    s_append(out, metadata.maxValue);
+    s_append(out, static_cast<uint32_t>(metadata.defaultValue.size()));
+    for (float value : metadata.defaultValue) {
+        s_append(out, value);
+    }
+    uint8_t flags = (metadata.hidden ? 1u : 0u) | (metadata.isColor ? 2u : 0u) | (metadata.hasRange ? 4u : 0u) |
+                    (metadata.hasDefault ? 8u : 0u);
+    s_append(out, flags);
+}
+
+static PushConstantMemberMetadata s_readMetadata(ByteReader &reader)
+{
+    PushConstantMemberMetadata metadata;
+    metadata.displayName = reader.readString();
+    metadata.minValue = reader.read<float>();
+    metadata.maxValue = reader.read<float>();
+    uint32_t defaultCount = reader.readCount(sizeof(float));
+    metadata.defaultValue.resize(defaultCount);
+    for (float &value : metadata.defaultValue) {
+        value = reader.read<float>();
+    }
+    uint8_t flags = reader.read<uint8_t>();
+    metadata.hidden = (flags & 1u) != 0;
+    metadata.isColor = (flags & 2u) != 0;
+    metadata.hasRange = (flags & 4u) != 0;
+    metadata.hasDefault = (flags & 8u) != 0;
+    return metadata;
+}
+
+std::vector<uint8_t> ShaderCache::serializeReflection(const ShaderStageReflection &reflection)
+{
+    std::vector<uint8_t> out;
+
+    s_append(out, static_cast<uint32_t>(reflection.descriptorSets.size()));
+    for (const auto &set : reflection.descriptorSets) {
+        s_append(out, set.setNumber);
+        s_append(out, static_cast<uint32_t>(set.bindings.size()));
+        for (const auto &binding : set.bindings) {
+            s_append(out, binding.binding);
+            s_append(out, static_cast<uint32_t>(binding.descriptorType));
+            s_append(out, binding.descriptorCount);
+            s_append(out, static_cast<uint32_t>(binding.stageFlags));
+            s_appendString(out, binding.name);
+        }
+    }
+
+    s_append(out, static_cast<uint32_t>(reflection.pushConstants.size()));
+    for (const auto &pc : reflection.pushConstants) {
+        s_append(out, pc.offset);
+        s_append(out, pc.size);
+        s_append(out, static_cast<uint32_t>(pc.stageFlags));
+        s_appendString(out, pc.name);
+    }
+
+    s_append(out, static_cast<uint32_t>(reflection.detailedPushConstants.size()));
+    for (const auto &block : reflection.detailedPushConstants) {
+        s_append(out, block.offset);
+        s_append(out, block.size);
+        s_append(out, static_cast<uint32_t>(block.stageFlags));
+        s_appendString(out, block.blockName);
+        s_append(out, static_cast<uint32_t>(block.members.size()));
+        for (const auto &member : block.members) {
+            s_appendString(out, member.name);
+            s_appendString(out, member.type);
+            s_append(out, member.offset);
+            s_append(out, member.size);
+            s_append(out, member.arraySize);
+            s_appendMetadata(out, member.metadata);
+        }
+    }
+
+    s_append(out, static_cast<uint32_t>(reflection.materialSets.size()));
+    for (const auto &matSet : reflection.materialSets) {
+        s_appendString(out, matSet.name);
+        s_append(out, matSet.setNumber);
+        s_append(out, matSet.binding);
+        s_append(out, static_cast<uint32_t>(matSet.params.size()));
+        for (const auto &param : matSet.params) {
+            s_appendString(out, param.name);
+            s_appendString(out, param.type);
+            s_append(out, param.size);
+            s_append(out, param.offset);
+        }
+    }
+
+    // written by name rather than in the map's order, so the same SPIR-V always gives the same bytes
+    std::vector<const std::pair<const std::string, PushConstantMemberMetadata> *> annotations;
+    annotations.reserve(reflection.annotations.size());
+    for (const auto &entry : reflection.annotations) {
+        annotations.push_back(&entry);
+    }
+    std::sort(annotations.begin(), annotations.end(), [](const auto *a, const auto *b) { return a->first < b->first; });
+
+    s_append(out, static_cast<uint32_t>(annotations.size()));
+    for (const auto *entry : annotations) {
+        s_appendString(out, entry->first);
+        s_appendMetadata(out, entry->second);
+    }
+
+    return out;
+}
+
+bool ShaderCache::deserializeReflection(std::span<const uint8_t> bytes, ShaderStageReflection &reflection)
+{
+    ByteReader reader{bytes.data(), bytes.size()};
+    ShaderStageReflection result;
+
+    result.descriptorSets.resize(reader.readCount(8));
+    for (auto &set : result.descriptorSets) {
+        set.setNumber = reader.read<uint32_t>();
+        set.bindings.resize(reader.readCount(20));
+        for (auto &binding : set.bindings) {
+            binding.binding = reader.read<uint32_t>();
+            binding.descriptorType = static_cast<VkDescriptorType>(reader.read<uint32_t>());
+            binding.descriptorCount = reader.read<uint32_t>();
+            binding.stageFlags = reader.read<uint32_t>();
+            binding.name = reader.readString();
+        }
+    }
+
+    result.pushConstants.resize(reader.readCount(16));
+    for (auto &pc : result.pushConstants) {
+        pc.offset = reader.read<uint32_t>();
+        pc.size = reader.read<uint32_t>();
+        pc.stageFlags = reader.read<uint32_t>();
+        pc.name = reader.readString();
+    }
+
+    result.detailedPushConstants.resize(reader.readCount(20));
+    for (auto &block : result.detailedPushConstants) {
+        block.offset = reader.read<uint32_t>();
+        block.size = reader.read<uint32_t>();
+        block.stageFlags = reader.read<uint32_t>();
+        block.blockName = reader.readString();
+        block.members.resize(reader.readCount(20));
+        for (auto &member : block.members) {
+            member.name = reader.readString();
+            member.type = reader.readString();
+            member.offset = reader.read<uint32_t>();
+            member.size = reader.read<uint32_t>();
+            member.arraySize = reader.read<uint32_t>();
+            member.metadata = s_readMetadata(reader);
+        }
+    }
+
+    result.materialSets.resize(reader.readCount(16));
+    for (auto &matSet : result.materialSets) {
+        matSet.name = reader.readString();
+        matSet.setNumber = reader.read<uint32_t>();
+        matSet.binding = reader.read<uint32_t>();
+        matSet.params.resize(reader.readCount(16));
+        for (auto &param : matSet.params) {
+            param.name = reader.readString();
+            param.type = reader.readString();
+            param.size = reader.read<uint32_t>();
+            param.offset = reader.read<uint32_t>();
+        }
+    }
+
+    uint32_t annotationCount = reader.readCount(8);
+    for (uint32_t i = 0; i < annotationCount && reader.ok; ++i) {
+        std::string memberName = reader.readString();
+        result.annotations[memberName] = s_readMetadata(reader);
+    }
+
+    if (!reader.ok) {
+        return false;
+    }
+    reflection = std::move(result);
+    return true;
+}
+
+static std::string s_hex(uint64_t value)
+{
+    return fmt::format("{:016x}", value);
+}
+
+/**
+ * @brief The key of a compiled GLSL stage, covering everything that changes its SPIR-V except its includes
+ * @return The key, or empty if the source cannot be read
+ */
+static std::string s_compiledKey(const std::filesystem::path &sourcePath, const ShaderCompileInfo &compileInfo)
+{
+    std::vector<char> source = readFile(sourcePath);
+    if (source.empty()) {
+        return {};
+    }
+
+    uint64_t hash = s_checksum(sourcePath.generic_string());
+    hash = s_checksum(std::string_view(source.data(), source.size()), hash);
+    hash = s_checksum(compileInfo.includePath.generic_string(), hash);
+    for (const auto &macro : compileInfo.macros) {
+        hash = s_checksum(macro.name, hash);
+        hash = s_checksum("=", hash);
+        hash = s_checksum(macro.value, hash);
+        hash = s_checksum(";", hash);
+    }
+    return s_hex(hash);
+}
+
+static bool s_writeAtomically(const std::filesystem::path &path, std::span<const uint8_t> first, std::span<const uint8_t> second = {})
+{
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    // written aside and renamed over, so a concurrent reader never sees a half-written entry
+    std::filesystem::path temp = path;
+    temp += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char *>(first.data()), static_cast<std::streamsize>(first.size()));
+        file.write(reinterpret_cast<const char *>(second.data()), static_cast<std::streamsize>(second.size()));
+        if (!file) {
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+static std::vector<uint8_t> s_readBytes(const std::filesystem::path &path)
+{
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file) {
+        return {};
+    }
+    std::vector<uint8_t> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        return {};
+    }
+    return bytes;
+}
+
+/**
+ * @brief Reads a `.refl`, checking its header, its dependencies and the SPIR-V it describes
+ * @param spirv The SPIR-V the file must describe
+ * @param dependencies Receives the files the entry depends on, when not null
+ */
+static bool s_readRefl(const std::filesystem::path &path, const std::vector<char> &spirv, ShaderStageReflection &reflection,
+                       std::vector<std::filesystem::path> *dependencies = nullptr)
+{
+    std::vector<uint8_t> bytes = s_readBytes(path);
+    if (bytes.size() < sizeof(ShaderReflHeader)) {
+        return false;
+    }
+
+    ShaderReflHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (header.magic != SHADER_REFL_MAGIC || header.version != SHADER_REFL_VERSION || header.spirvSize != spirv.size() ||
+        header.spirvChecksum != s_checksum(spirv)) {
+        return false;
+    }
+
+    ByteReader reader{bytes.data(), bytes.size(), sizeof(ShaderReflHeader)};
+    for (uint32_t i = 0; i < header.dependencyCount; ++i) {
+        std::filesystem::path dependency = reader.readString();
+        uint64_t checksum = reader.read<uint64_t>();
+        if (!reader.ok) {
+            return false;
+        }
+        std::vector<char> contents = readFile(dependency);
+        if (contents.empty() || s_checksum(contents) != checksum) {
+            return false;
+        }
+        if (dependencies != nullptr) {
+            dependencies->push_back(std::move(dependency));
+        }
+    }
+
+    return ShaderCache::deserializeReflection(std::span<const uint8_t>(bytes).subspan(reader.pos), reflection);
+}
+
+static std::vector<uint8_t> s_reflPrefix(const std::vector<char> &spirv, const std::vector<std::filesystem::path> &dependencies)
+{
+    ShaderReflHeader header;
+    header.spirvSize = spirv.size();
+    header.spirvChecksum = s_checksum(spirv);
+    header.dependencyCount = static_cast<uint32_t>(dependencies.size());
+
+    std::vector<uint8_t> out(sizeof(header));
+    std::memcpy(out.data(), &header, sizeof(header));
+    for (const auto &dependency : dependencies) {
+        s_appendString(out, dependency.generic_string());
+        s_append(out, s_checksum(readFile(dependency)));
+    }
+    return out;
+}
+
+bool ShaderCache::loadCompiled(const std::filesystem::path &sourcePath, const ShaderCompileInfo &compileInfo, Entry &entry)
+{
+    const std::filesystem::path &directory = EnginePaths::shaderCacheDirectory();
+    if (!isEnabled() || directory.empty()) {
+        return false;
+    }
+
+    std::string key = s_compiledKey(sourcePath, compileInfo);
+    if (key.empty()) {
+        return false;
+    }
+
+    std::filesystem::path spirvPath = directory / (key + ".spv");
+    std::error_code ec;
+    if (!std::filesystem::exists(spirvPath, ec)) {
+        return false;
+    }
+
+    std::vector<char> spirv = readFile(spirvPath);
+    ShaderStageReflection reflection;
+    std::vector<std::filesystem::path> includedFiles;
+    if (spirv.empty() || !s_readRefl(directory / (key + ".refl"), spirv, reflection, &includedFiles)) {
+        return false;
+    }
+
+    entry.spirv = std::move(spirv);
+    entry.reflection = std::move(reflection);
+    entry.includedFiles = std::move(includedFiles);
+    return true;
+}
+
+void ShaderCache::storeCompiled(const std::filesystem::path &sourcePath, const ShaderCompileInfo &compileInfo,
+                                const std::vector<std::filesystem::path> &includedFiles, const Entry &entry)
+{
+    const std::filesystem::path &directory = EnginePaths::shaderCacheDirectory();
+    if (!isEnabled() || directory.empty()) {
+        return;
+    }
+
+    std::string key = s_compiledKey(sourcePath, compileInfo);
+    if (key.empty()) {
+        return;
+    }
+
+    std::span<const uint8_t> spirvBytes(reinterpret_cast<const uint8_t *>(entry.spirv.data()), entry.spirv.size());
+    // the SPIR-V lands first, so a `.refl` never names SPIR-V that is not there yet
+    if (!s_writeAtomically(directory / (key + ".spv"), spirvBytes) ||
+        !s_writeAtomically(directory / (key + ".refl"), s_reflPrefix(entry.spirv, includedFiles),
+                           serializeReflection(entry.reflection))) {
+        RP_CORE_WARN("Could not cache compiled shader {}", sourcePath.string());
+    }
+}
+
+bool ShaderCache::loadReflection(const std::vector<char> &spirv, ShaderStageReflection &reflection)
+{
+    const std::filesystem::path &directory = EnginePaths::shaderCacheDirectory();
+    if (!isEnabled() || directory.empty() || spirv.empty()) {
+        return false;
+    }
+
+    return s_readRefl(directory / (s_hex(s_checksum(spirv)) + ".refl"), spirv, reflection);
+}
+
+void ShaderCache::storeReflection(const std::vector<char> &spirv, const ShaderStageReflection &reflection)
+{
+    const std::filesystem::path &directory = EnginePaths::shaderCacheDirectory();
+    if (!isEnabled() || directory.empty() || spirv.empty()) {
+        return;
+    }
+
+    if (!s_writeAtomically(directory / (s_hex(s_checksum(spirv)) + ".refl"), s_reflPrefix(spirv, {}),
+                           serializeReflection(reflection))) {
+        RP_CORE_WARN("Could not cache shader reflection");
+    }
+}
+
+void ShaderCache::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool ShaderCache::isEnabled()
+{
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+} // namespace Rapture
@@ -0,0 +1,84 @@
+#ifndef RAPTURE__SHADER_CACHE_H
+#define RAPTURE__SHADER_CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "ShaderCommon.h"
+#include "ShaderReflections.h"
+
+namespace Rapture {
+
+/**
+ * @brief On-disk cache of compiled SPIR-V and its reflection, so a warm start skips glslang and SPIRV-Reflect
+ *
+ * A GLSL stage is keyed by its path, source, include path and macros, and stored as `<key>.spv` with a
+ * `<key>.refl` beside it. The `.refl` also records every file the compiler included, with a checksum of
+ * each, so editing a header misses the entry. A precompiled `.spv` stage only caches its reflection,
+ * keyed by the checksum of the SPIR-V itself. Entries live under EnginePaths::shaderCacheDirectory().
+ */
+class ShaderCache {
+  public:
+    struct Entry {
+        std::vector<char> spirv;
+        ShaderStageReflection reflection;
+        std::vector<std::filesystem::path> includedFiles; ///< what the stage included when it was compiled
+    };
+
+    /**
+     * @brief Loads a compiled GLSL stage if the cache holds one for this exact source and compile info
+     * @param sourcePath The stage's GLSL source
+     * @param compileInfo The include path and macros the stage is compiled with
+     * @param entry Receives the SPIR-V, reflection and included files on a hit
+     * @return True on a hit, false if the stage has to be compiled
+     */
+    static bool loadCompiled(const std::filesystem::path &sourcePath, const ShaderCompileInfo &compileInfo, Entry &entry);
+
+    /**
+     * @brief Stores a freshly compiled GLSL stage
+     * @param sourcePath The stage's GLSL source
+     * @param compileInfo The include path and macros the stage was compiled with
+     * @param includedFiles Every file the compiler pulled in, checked again on load
+     * @param entry The SPIR-V and reflection to store
+     */
+    static void storeCompiled(const std::filesystem::path &sourcePath, const ShaderCompileInfo &compileInfo,
+                              const std::vector<std::filesystem::path> &includedFiles, const Entry &entry);
+
+    /**
+     * @brief Loads the reflection of precompiled SPIR-V
+     * @param spirv The stage's SPIR-V, its checksum is the key
+     * @param reflection Receives the reflection on a hit
+     * @return True on a hit
+     */
+    static bool loadReflection(const std::vector<char> &spirv, ShaderStageReflection &reflection);
+
+    /**
+     * @brief Stores the reflection of precompiled SPIR-V
+     * @param spirv The stage's SPIR-V, its checksum is the key
+     * @param reflection The reflection to store
+     */
+    static void storeReflection(const std::vector<char> &spirv, const ShaderStageReflection &reflection);
+
+    /**
+     * @brief Turns the cache on or off, off forces every stage through glslang and SPIRV-Reflect
+     */
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    /**
+     * @brief Encodes a reflection into the compact form stored in a `.refl`
+     */
+    static std::vector<uint8_t> serializeReflection(const ShaderStageReflection &reflection);
+
+    /**
+     * @brief Decodes a reflection written by serializeReflection
+     * @return False if the bytes are truncated or malformed
+     */
+    static bool deserializeReflection(std::span<const uint8_t> bytes, ShaderStageReflection &reflection);
+};
+
+} // namespace Rapture
+
+#endif // RAPTURE__SHADER_CACHE_H
@@ -5,8 +5,10 @@
 #include <glslang/Public/ShaderLang.h>
 #include <SPIRV/GlslangToSpv.h>
 
+#include <algorithm>
 #include <fstream>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <unordered_map>
 
@@ -37,8 +39,11 @@ class ShaderIncluder : public glslang::TShader::Includer {
         }
     }
 
+    const std::vector<std::filesystem::path>& getIncludedFiles() const { return m_includedFiles; }
+
   private:
     std::filesystem::path m_includePath;
+    std::vector<std::filesystem::path> m_includedFiles;
 
     struct IncludeStorage {
         std::string path;
@@ -57,6 +62,10 @@ class ShaderIncluder : public glslang::TShader::Includer {
         std::stringstream buffer;
         buffer << file.rdbuf();
 
+        if (std::find(m_includedFiles.begin(), m_includedFiles.end(), fullPath) == m_includedFiles.end()) {
+            m_includedFiles.push_back(fullPath);
+        }
+
         auto storage = std::make_unique<IncludeStorage>();
         storage->path = fullPath.string();
         storage->content = buffer.str();
@@ -69,19 +78,18 @@ class ShaderIncluder : public glslang::TShader::Includer {
     }
 };
 
-static bool s_initialized = false;
+static std::once_flag s_initialized;
 
 ShaderCompiler::ShaderCompiler()
 {
-    if (!s_initialized) {
-        glslang::InitializeProcess();
-        s_initialized = true;
-    }
+    // compilers are created on hot reload threads too, so the process-wide setup must run exactly once
+    std::call_once(s_initialized, [] { glslang::InitializeProcess(); });
 }
 
 ShaderCompiler::~ShaderCompiler() {}
 
-std::vector<char> ShaderCompiler::Compile(const std::filesystem::path &path, const ShaderCompileInfo &compileInfo)
+std::vector<char> ShaderCompiler::Compile(const std::filesystem::path &path, const ShaderCompileInfo &compileInfo,
+                                          std::vector<std::filesystem::path> *includedFiles)
 {
     const int stage = getShaderStage(path);
     if (stage == -1) {
@@ -141,6 +149,10 @@ std::vector<char> ShaderCompiler::Compile(const std::filesystem::path &path, con
     }
     RP_CORE_INFO("Compiled shader: {0} \n\t using macros: [{1}]", path.string(), fmt::join(macroStrings, ", "));
 
+    if (includedFiles != nullptr) {
+        *includedFiles = includer.getIncludedFiles();
+    }
+
     std::vector<char> spirv(spirvWords.size() * sizeof(uint32_t));
     memcpy(spirv.data(), spirvWords.data(), spirv.size());
     return spirv;
@@ -14,7 +14,15 @@ class ShaderCompiler {
     ShaderCompiler();
     ~ShaderCompiler();
 
-    std::vector<char> Compile(const std::filesystem::path &path, const ShaderCompileInfo &compileInfo);
+    /**
+     * @brief Compiles one GLSL stage to SPIR-V
+     * @param path The stage's source file, its extension selects the stage
+     * @param compileInfo The include path and macros to compile with
+     * @param includedFiles Receives every file pulled in through #include, nested ones too, when not null
+     * @return The SPIR-V bytecode, or empty on failure
+     */
+    std::vector<char> Compile(const std::filesystem::path &path, const ShaderCompileInfo &compileInfo,
+                              std::vector<std::filesystem::path> *includedFiles = nullptr);
 
   private:
     int getShaderStage(const std::filesystem::path &path);
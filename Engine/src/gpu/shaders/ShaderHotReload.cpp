@@ -0,0 +1,375 @@
+#include "ShaderHotReload.h"
+
+#include "Shader.h"
+
+#include "app/Application.h"
+#include "core/events/ShaderEvents.h"
+#include "core/utils/Log.h"
+#include "core/utils/TracyProfiler.h"
+#include "platform/FileWatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Rapture {
+
+// Editors save in bursts (write, truncate, rename), so a file has to settle before it is compiled
+static constexpr std::chrono::milliseconds RELOAD_DEBOUNCE{120};
+static constexpr uint32_t MAX_RELOAD_THREADS = 2;
+
+struct TrackedShader {
+    Shader *shader = nullptr;
+    std::string name; // the first stage's file name, for the log
+    std::vector<std::string> files;
+    uint64_t generation = 0; // bumped per queued rebuild, only the latest one is applied
+};
+
+struct ReloadJob {
+    uint64_t shaderId = 0;
+    uint64_t generation = 0;
+    std::vector<ShaderStage> stages;
+    ShaderCompileInfo compileInfo;
+};
+
+struct ReloadResult {
+    uint64_t shaderId = 0;
+    uint64_t generation = 0;
+    bool ok = false;
+    std::vector<ShaderStage> stages;
+};
+
+struct HotReloadState {
+    std::mutex mutex;
+    std::condition_variable queueChanged;
+
+    std::unordered_map<uint64_t, TrackedShader> shaders;
+    std::unordered_map<std::string, std::unordered_set<uint64_t>> dependents; // source file -> shaders built from it
+    std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes;
+
+    std::deque<ReloadJob> queue;
+    std::vector<ReloadResult> finished;
+    uint32_t inFlight = 0;
+    bool running = false;
+
+    std::vector<std::thread> workers;
+
+    // main thread only
+    std::unique_ptr<DirectoryWatcher> watcher;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> settling;
+    EventListenerId sourceChangedListener = 0;
+};
+
+// Shaders track themselves whether or not hot reload was started, so the state always exists
+static HotReloadState &s_state()
+{
+    static HotReloadState state;
+    return state;
+}
+
+static std::string s_fileKey(const std::filesystem::path &path)
+{
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+    return (ec ? path : canonical).lexically_normal().generic_string();
+}
+
+static std::filesystem::file_time_type s_writeTime(const std::string &file)
+{
+    std::error_code ec;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(file, ec);
+    return ec ? std::filesystem::file_time_type{} : time;
+}
+
+static void s_unlinkShader(HotReloadState &state, uint64_t shaderId)
+{
+    auto it = state.shaders.find(shaderId);
+    if (it == state.shaders.end()) {
+        return;
+    }
+    for (const auto &file : it->second.files) {
+        auto dep = state.dependents.find(file);
+        if (dep == state.dependents.end()) {
+            continue;
+        }
+        dep->second.erase(shaderId);
+        if (dep->second.empty()) {
+            state.dependents.erase(dep);
+            state.writeTimes.erase(file);
+        }
+    }
+}
+
+static void s_workerLoop(HotReloadState &state)
+{
+    RAPTURE_PROFILE_THREAD("Shader Hot Reload");
+
+    while (true) {
+        ReloadJob job;
+        {
+            std::unique_lock<std::mutex> lock(state.mutex);
+            state.queueChanged.wait(lock, [&] { return !state.running || !state.queue.empty(); });
+            if (!state.running) {
+                return;
+            }
+            job = std::move(state.queue.front());
+            state.queue.pop_front();
+            ++state.inFlight;
+        }
+
+        ReloadResult result;
+        result.shaderId = job.shaderId;
+        result.generation = job.generation;
+        {
+            RAPTURE_PROFILE_SCOPE("Shader Hot Reload Compile");
+            result.ok = Shader::buildStages(job.stages, job.compileInfo);
+        }
+        result.stages = std::move(job.stages);
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.finished.push_back(std::move(result));
+        --state.inFlight;
+    }
+}
+
+static void s_onSourceChanged(std::string_view fileName)
+{
+    std::vector<std::filesystem::path> files;
+    {
+        HotReloadState &state = s_state();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        for (const auto &[file, shaders] : state.dependents) {
+            if (std::filesystem::path(file).filename().string() == fileName) {
+                files.emplace_back(file);
+            }
+        }
+    }
+    ShaderHotReload::requestReload(files);
+}
+
+void ShaderHotReload::init(const std::filesystem::path &shaderDirectory)
+{
+    HotReloadState &state = s_state();
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.running) {
+            return;
+        }
+        state.running = true;
+    }
+
+    // glslang needs far deeper stacks than the job system fibers have, so these are plain threads
+    uint32_t threadCount = std::clamp(std::thread::hardware_concurrency() / 4, 1u, MAX_RELOAD_THREADS);
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        state.workers.emplace_back(s_workerLoop, std::ref(state));
+    }
+
+    state.watcher = DirectoryWatcher::create(shaderDirectory, true, [&state](const FileChange &change) {
+        if (change.type == FW_REMOVED) {
+            return;
+        }
+        state.settling[s_fileKey(change.path)] = std::chrono::steady_clock::now();
+    });
+    if (!state.watcher) {
+        RP_CORE_WARN("Cannot watch '{}', shaders only reload when their sources are regenerated", shaderDirectory.string());
+    }
+
+    state.sourceChangedListener = ShaderEvents::onShaderSourceChanged().addListener(s_onSourceChanged);
+
+    RP_CORE_INFO("Shader hot reload watching '{}' with {} compile thread(s)", shaderDirectory.string(), threadCount);
+}
+
+void ShaderHotReload::shutdown()
+{
+    HotReloadState &state = s_state();
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (!state.running) {
+            return;
+        }
+        state.running = false;
+        state.queue.clear();
+    }
+    state.queueChanged.notify_all();
+
+    for (auto &worker : state.workers) {
+        worker.join();
+    }
+    state.workers.clear();
+
+    ShaderEvents::onShaderSourceChanged().removeListener(state.sourceChangedListener);
+    state.watcher.reset();
+    state.settling.clear();
+    state.finished.clear();
+}
+
+bool ShaderHotReload::isBusy()
+{
+    HotReloadState &state = s_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return !state.queue.empty() || state.inFlight > 0 || !state.finished.empty();
+}
+
+void ShaderHotReload::trackShader(Shader &shader)
+{
+    std::vector<std::string> files;
+    for (const auto &stage : shader.getShaderStages()) {
+        files.push_back(s_fileKey(stage.sourcePath));
+        for (const auto &included : stage.includedFiles) {
+            files.push_back(s_fileKey(included));
+        }
+    }
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+
+    HotReloadState &state = s_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    s_unlinkShader(state, shader.getReloadId());
+
+    for (const auto &file : files) {
+        state.dependents[file].insert(shader.getReloadId());
+        // the version this build saw, an event for the same write later is not a change
+        if (state.writeTimes.find(file) == state.writeTimes.end()) {
+            state.writeTimes[file] = s_writeTime(file);
+        }
+    }
+
+    TrackedShader &tracked = state.shaders[shader.getReloadId()];
+    tracked.shader = &shader;
+    if (!shader.getShaderStages().empty()) {
+        tracked.name = shader.getShaderStages().front().sourcePath.filename().string();
+    }
+    tracked.files = std::move(files);
+}
+
+void ShaderHotReload::untrackShader(Shader &shader)
+{
+    HotReloadState &state = s_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    s_unlinkShader(state, shader.getReloadId());
+    state.shaders.erase(shader.getReloadId());
+}
+
+void ShaderHotReload::requestReload(const std::vector<std::filesystem::path> &files)
+{
+    HotReloadState &state = s_state();
+    std::unique_lock<std::mutex> lock(state.mutex);
+    if (!state.running) {
+        return;
+    }
+
+    std::unordered_set<uint64_t> affected;
+    for (const auto &path : files) {
+        std::string file = s_fileKey(path);
+        auto dep = state.dependents.find(file);
+        if (dep == state.dependents.end()) {
+            continue;
+        }
+
+        std::filesystem::file_time_type writeTime = s_writeTime(file);
+        auto &seen = state.writeTimes[file];
+        if (writeTime == seen) {
+            continue;
+        }
+        seen = writeTime;
+
+        RP_CORE_INFO("Shader source '{}' changed, rebuilding {} shader(s)", path.filename().string(), dep->second.size());
+        affected.insert(dep->second.begin(), dep->second.end());
+    }
+
+    for (uint64_t shaderId : affected) {
+        TrackedShader &tracked = state.shaders[shaderId];
+
+        // an older rebuild still queued is superseded rather than compiled for nothing
+        state.queue.erase(std::remove_if(state.queue.begin(), state.queue.end(),
+                                         [shaderId](const ReloadJob &job) { return job.shaderId == shaderId; }),
+                          state.queue.end());
+
+        ReloadJob job;
+        job.shaderId = shaderId;
+        job.generation = ++tracked.generation;
+        job.stages = tracked.shader->getStageSources();
+        job.compileInfo = tracked.shader->getCompileInfo();
+        state.queue.push_back(std::move(job));
+    }
+
+    lock.unlock();
+    if (!affected.empty()) {
+        state.queueChanged.notify_all();
+    }
+}
+
+void ShaderHotReload::onUpdate()
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    HotReloadState &state = s_state();
+    if (state.watcher) {
+        state.watcher->poll();
+    }
+
+    if (!state.settling.empty()) {
+        auto now = std::chrono::steady_clock::now();
+        std::vector<std::filesystem::path> settled;
+        for (auto it = state.settling.begin(); it != state.settling.end();) {
+            if (now - it->second >= RELOAD_DEBOUNCE) {
+                settled.emplace_back(it->first);
+                it = state.settling.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (!settled.empty()) {
+            requestReload(settled);
+        }
+    }
+
+    // Applied as one batch once every rebuild of it finished, so an edit to a common include
+    // swaps all of its shaders in the same frame
+    std::vector<std::pair<Shader *, std::vector<ShaderStage>>> ready;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.finished.empty() || !state.queue.empty() || state.inFlight > 0) {
+            return;
+        }
+
+        for (auto &result : state.finished) {
+            auto it = state.shaders.find(result.shaderId);
+            if (it == state.shaders.end() || it->second.generation != result.generation) {
+                continue;
+            }
+            if (!result.ok) {
+                RP_CORE_ERROR("Hot reload failed for shader '{}', keeping the previous build", it->second.name);
+                continue;
+            }
+            // shaders are only destroyed on this thread, so the pointer stays valid while the batch applies
+            ready.emplace_back(it->second.shader, std::move(result.stages));
+        }
+        state.finished.clear();
+    }
+
+    if (ready.empty()) {
+        return;
+    }
+
+    // modules and pipelines are replaced in place, nothing in flight may still use them
+    Application::getInstance().getVulkanContext().waitIdle();
+
+    uint32_t applied = 0;
+    for (auto &[shader, stages] : ready) {
+        if (shader->applyRebuild(std::move(stages))) {
+            ++applied;
+        }
+    }
+    RP_CORE_INFO("Hot reloaded {}/{} shader(s)", applied, ready.size());
+}
+
+} // namespace Rapture
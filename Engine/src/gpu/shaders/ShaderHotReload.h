@@ -0,0 +1,68 @@
+#ifndef RAPTURE__SHADER_HOT_RELOAD_H
+#define RAPTURE__SHADER_HOT_RELOAD_H
+
+#include <filesystem>
+#include <vector>
+
+namespace Rapture {
+
+class Shader;
+
+/**
+ * @brief Recompiles the shaders a changed source file reaches and swaps them in between frames
+ *
+ * Every compiled shader records its stage sources and everything they included, nested includes
+ * too, which gives a reverse include graph from a file to the shaders built from it. When the
+ * shader directory watcher or ShaderEvents::onShaderSourceChanged() reports a change, only those
+ * shaders are rebuilt, each permutation with its own compile info, on background threads. The
+ * finished batch is applied from onUpdate() in one go, so the pipelines that rebuild on
+ * Shader::onRecompiled() never mix old and new stages within a frame.
+ *
+ * A shader whose new source fails to compile keeps its previous build.
+ */
+class ShaderHotReload {
+  public:
+    /**
+     * @brief Starts the compile threads and watches the shader directory for edits
+     * @param shaderDirectory The directory to watch, recursively
+     */
+    static void init(const std::filesystem::path &shaderDirectory);
+
+    /**
+     * @brief Stops watching and joins the compile threads, dropping unfinished reloads
+     */
+    static void shutdown();
+
+    /**
+     * @brief Picks up file changes and applies finished rebuilds, call once per frame before recording
+     */
+    static void onUpdate();
+
+    /**
+     * @brief Records the files a compiled shader was built from, replacing what it recorded before
+     */
+    static void trackShader(Shader &shader);
+
+    /**
+     * @brief Forgets a shader and drops any rebuild of it still in flight
+     */
+    static void untrackShader(Shader &shader);
+
+    /**
+     * @brief Queues a background rebuild of every shader built from one of the files
+     *
+     * Files that did not change since they were last seen are skipped, so the same edit reported
+     * twice only rebuilds once. Does nothing before init().
+     * @param files The changed source files
+     */
+    static void requestReload(const std::vector<std::filesystem::path> &files);
+
+    /**
+     * @brief Whether rebuilds are queued, compiling or waiting to be applied
+     */
+    static bool isBusy();
+};
+
+} // namespace Rapture
+
+#endif // RAPTURE__SHADER_HOT_RELOAD_H
@@ -215,32 +215,20 @@ std::string descriptorTypeToString(SpvReflectDescriptorType descriptorType)
     }
 }
 
-std::vector<DescriptorInfo> extractMaterialSets(const std::vector<char> &spirvCode)
+// Material set descriptors of an already created reflection module
+static std::vector<DescriptorInfo> s_materialSetsFromModule(const SpvReflectShaderModule &module)
 {
     std::vector<DescriptorInfo> result;
-    // Create SPIR-V reflection module
-    const uint32_t *spirvData = reinterpret_cast<const uint32_t *>(spirvCode.data());
-
-    size_t spirvSize = spirvCode.size();
-    SpvReflectShaderModule module;
-    SpvReflectResult reflectResult = spvReflectCreateShaderModule(spirvSize, spirvData, &module);
-
-    if (reflectResult != SPV_REFLECT_RESULT_SUCCESS) {
-        RP_CORE_ERROR("Failed to create reflection data for material extraction!");
-        return result;
-    } // Enumerate descriptor bindings
 
     uint32_t count = 0;
-    reflectResult = spvReflectEnumerateDescriptorBindings(&module, &count, nullptr);
+    SpvReflectResult reflectResult = spvReflectEnumerateDescriptorBindings(&module, &count, nullptr);
     if (reflectResult != SPV_REFLECT_RESULT_SUCCESS || count == 0) {
-        spvReflectDestroyShaderModule(&module);
         return result;
     }
 
     std::vector<SpvReflectDescriptorBinding *> bindings(count);
     reflectResult = spvReflectEnumerateDescriptorBindings(&module, &count, bindings.data());
     if (reflectResult != SPV_REFLECT_RESULT_SUCCESS) {
-        spvReflectDestroyShaderModule(&module);
         return result;
     } // Filter for MATERIAL set descriptors only
 
@@ -281,79 +269,93 @@ std::vector<DescriptorInfo> extractMaterialSets(const std::vector<char> &spirvCo
         result.push_back(descriptorInfo);
     }
 
+    return result;
+}
+
+std::vector<DescriptorInfo> extractMaterialSets(const std::vector<char> &spirvCode)
+{
+    // Create SPIR-V reflection module
+    const uint32_t *spirvData = reinterpret_cast<const uint32_t *>(spirvCode.data());
+
+    size_t spirvSize = spirvCode.size();
+    SpvReflectShaderModule module;
+    SpvReflectResult reflectResult = spvReflectCreateShaderModule(spirvSize, spirvData, &module);
+
+    if (reflectResult != SPV_REFLECT_RESULT_SUCCESS) {
+        RP_CORE_ERROR("Failed to create reflection data for material extraction!");
+        return {};
+    }
+
+    std::vector<DescriptorInfo> result = s_materialSetsFromModule(module);
+
     // Clean up
     spvReflectDestroyShaderModule(&module);
     return result;
 }
 
-std::vector<PushConstantInfo>
-getCombinedPushConstantRanges(const std::vector<std::pair<std::vector<char>, VkShaderStageFlags>> &shaderCodeWithStages)
+// Push constant ranges of an already created reflection module, one entry per block
+static std::vector<PushConstantInfo> s_pushConstantsFromModule(const SpvReflectShaderModule &module, VkShaderStageFlags stageHint)
 {
-    // Use a map to merge push constant ranges by offset and size, combining stage flags.
-    // The key is a pair of {offset, size}, the value is PushConstantInfo.
-    std::map<std::pair<uint32_t, uint32_t>, PushConstantInfo> mergedPushConstants;
+    std::vector<PushConstantInfo> result;
 
-    for (const auto &shaderDataPair : shaderCodeWithStages) {
-        const std::vector<char> &spirvCode = shaderDataPair.first;
-        VkShaderStageFlags stageHint = shaderDataPair.second; // Hint for the primary stage of this SPIR-V
+    uint32_t count = 0;
+    SpvReflectResult reflectResult = spvReflectEnumeratePushConstantBlocks(&module, &count, nullptr);
+    if (reflectResult != SPV_REFLECT_RESULT_SUCCESS || count == 0) {
+        return result;
+    }
 
-        const uint32_t *spirvData = reinterpret_cast<const uint32_t *>(spirvCode.data());
-        size_t spirvSize = spirvCode.size();
+    std::vector<SpvReflectBlockVariable *> spvPushConstants(count);
+    reflectResult = spvReflectEnumeratePushConstantBlocks(&module, &count, spvPushConstants.data());
+    if (reflectResult != SPV_REFLECT_RESULT_SUCCESS) {
+        return result;
+    }
 
-        SpvReflectShaderModule module;
-        SpvReflectResult result = spvReflectCreateShaderModule(spirvSize, spirvData, &module);
-        if (result != SPV_REFLECT_RESULT_SUCCESS) {
-            RP_CORE_ERROR("Failed to create reflection data for shader stage (hint: {0}) for push constants!", stageHint);
-            // Optionally, continue to process other shaders or return an empty vector
-            continue;
+    for (const auto *spvPcBlock : spvPushConstants) {
+        if (!spvPcBlock) continue;
+
+        // SPIR-V Reflect gives the shader stage for the *module* itself.
+        // If a push constant is truly used by multiple stages, it will appear in multiple modules.
+        VkShaderStageFlags actualStageFlags = module.shader_stage;
+        if (actualStageFlags == 0) { // If module.shader_stage is not specific, use the hint.
+            actualStageFlags = stageHint;
         }
 
-        uint32_t count = 0;
-        result = spvReflectEnumeratePushConstantBlocks(&module, &count, nullptr);
-        if (result == SPV_REFLECT_RESULT_SUCCESS && count > 0) {
-            std::vector<SpvReflectBlockVariable *> spvPushConstants(count);
-            result = spvReflectEnumeratePushConstantBlocks(&module, &count, spvPushConstants.data());
-
-            if (result == SPV_REFLECT_RESULT_SUCCESS) {
-                for (const auto *spvPcBlock : spvPushConstants) {
-                    if (!spvPcBlock) continue;
-
-                    // SPIR-V Reflect gives the shader stage for the *module* itself.
-                    // If a push constant is truly used by multiple stages, it will appear in multiple modules.
-                    VkShaderStageFlags actualStageFlags = module.shader_stage;
-                    if (actualStageFlags == 0) { // If module.shader_stage is not specific, use the hint.
-                        actualStageFlags = stageHint;
-                    }
-
-                    std::pair<uint32_t, uint32_t> key = {spvPcBlock->offset, spvPcBlock->size};
-                    std::string name = spvPcBlock->name ? spvPcBlock->name : "unnamed_push_constant";
-
-                    auto it = mergedPushConstants.find(key);
-                    if (it != mergedPushConstants.end()) {
-                        // This push constant (offset, size) already exists, merge stage flags
-                        it->second.stageFlags |= actualStageFlags;
-                        // Optional: Name merging strategy (e.g., if names differ, append or log)
-                        if (it->second.name == "unnamed_push_constant" && name != "unnamed_push_constant") {
-                            it->second.name = name; // Prefer a non-default name
-                        } else if (it->second.name != name && name != "unnamed_push_constant") {
-                            // You might want a more sophisticated naming strategy for conflicts
-                            RP_CORE_WARN(
-                                "Push constant at offset {0}, size {1} has conflicting names: '{2}' and '{3}'. Using '{2}'.",
-                                key.first, key.second, it->second.name, name);
-                        }
-                    } else {
-                        // New push constant range
-                        PushConstantInfo pcInfo;
-                        pcInfo.offset = spvPcBlock->offset;
-                        pcInfo.size = spvPcBlock->size;
-                        pcInfo.stageFlags = actualStageFlags;
-                        pcInfo.name = name;
-                        mergedPushConstants[key] = pcInfo;
-                    }
-                }
+        PushConstantInfo pcInfo;
+        pcInfo.offset = spvPcBlock->offset;
+        pcInfo.size = spvPcBlock->size;
+        pcInfo.stageFlags = actualStageFlags;
+        pcInfo.name = spvPcBlock->name ? spvPcBlock->name : "unnamed_push_constant";
+        result.push_back(pcInfo);
+    }
+
+    return result;
+}
+
+std::vector<PushConstantInfo> mergePushConstantRanges(const std::vector<PushConstantInfo> &pushConstants)
+{
+    // Use a map to merge push constant ranges by offset and size, combining stage flags.
+    // The key is a pair of {offset, size}, the value is PushConstantInfo.
+    std::map<std::pair<uint32_t, uint32_t>, PushConstantInfo> mergedPushConstants;
+
+    for (const auto &pcInfo : pushConstants) {
+        std::pair<uint32_t, uint32_t> key = {pcInfo.offset, pcInfo.size};
+
+        auto it = mergedPushConstants.find(key);
+        if (it != mergedPushConstants.end()) {
+            // This push constant (offset, size) already exists, merge stage flags
+            it->second.stageFlags |= pcInfo.stageFlags;
+            // Optional: Name merging strategy (e.g., if names differ, append or log)
+            if (it->second.name == "unnamed_push_constant" && pcInfo.name != "unnamed_push_constant") {
+                it->second.name = pcInfo.name; // Prefer a non-default name
+            } else if (it->second.name != pcInfo.name && pcInfo.name != "unnamed_push_constant") {
+                // You might want a more sophisticated naming strategy for conflicts
+                RP_CORE_WARN("Push constant at offset {0}, size {1} has conflicting names: '{2}' and '{3}'. Using '{2}'.",
+                             key.first, key.second, it->second.name, pcInfo.name);
             }
+        } else {
+            // New push constant range
+            mergedPushConstants[key] = pcInfo;
         }
-        spvReflectDestroyShaderModule(&module);
     }
 
     // Convert map to vector
@@ -374,6 +376,34 @@ getCombinedPushConstantRanges(const std::vector<std::pair<std::vector<char>, VkS
     return resultVector;
 }
 
+std::vector<PushConstantInfo>
+getCombinedPushConstantRanges(const std::vector<std::pair<std::vector<char>, VkShaderStageFlags>> &shaderCodeWithStages)
+{
+    std::vector<PushConstantInfo> allPushConstants;
+
+    for (const auto &shaderDataPair : shaderCodeWithStages) {
+        const std::vector<char> &spirvCode = shaderDataPair.first;
+        VkShaderStageFlags stageHint = shaderDataPair.second; // Hint for the primary stage of this SPIR-V
+
+        const uint32_t *spirvData = reinterpret_cast<const uint32_t *>(spirvCode.data());
+        size_t spirvSize = spirvCode.size();
+
+        SpvReflectShaderModule module;
+        SpvReflectResult result = spvReflectCreateShaderModule(spirvSize, spirvData, &module);
+        if (result != SPV_REFLECT_RESULT_SUCCESS) {
+            RP_CORE_ERROR("Failed to create reflection data for shader stage (hint: {0}) for push constants!", stageHint);
+            // Optionally, continue to process other shaders or return an empty vector
+            continue;
+        }
+
+        std::vector<PushConstantInfo> stagePushConstants = s_pushConstantsFromModule(module, stageHint);
+        allPushConstants.insert(allPushConstants.end(), stagePushConstants.begin(), stagePushConstants.end());
+        spvReflectDestroyShaderModule(&module);
+    }
+
+    return mergePushConstantRanges(allPushConstants);
+}
+
 PushConstantMemberInfo::BaseType PushConstantMemberInfo::getBaseType() const
 {
     if (type == "float") return BaseType::FLOAT;
@@ -386,24 +416,14 @@ PushConstantMemberInfo::BaseType PushConstantMemberInfo::getBaseType() const
     return BaseType::UNKNOWN;
 }
 
-std::vector<DetailedPushConstantInfo> extractDetailedPushConstants(const std::vector<char> &spirvCode)
+// Member-level push constant data of an already created reflection module
+static std::vector<DetailedPushConstantInfo> s_detailedPushConstantsFromModule(const SpvReflectShaderModule &module)
 {
     std::vector<DetailedPushConstantInfo> result;
 
-    const uint32_t *spirvData = reinterpret_cast<const uint32_t *>(spirvCode.data());
-    size_t spirvSize = spirvCode.size();
-    SpvReflectShaderModule module;
-    SpvReflectResult reflectResult = spvReflectCreateShaderModule(spirvSize, spirvData, &module);
-
-    if (reflectResult != SPV_REFLECT_RESULT_SUCCESS) {
-        RP_CORE_ERROR("Failed to create reflection data for push constant extraction!");
-        return result;
-    }
-
     uint32_t count = 0;
-    reflectResult = spvReflectEnumeratePushConstantBlocks(&module, &count, nullptr);
+    SpvReflectResult reflectResult = spvReflectEnumeratePushConstantBlocks(&module, &count, nullptr);
     if (reflectResult != SPV_REFLECT_RESULT_SUCCESS || count == 0) {
-        spvReflectDestroyShaderModule(&module);
         return result;
     }
 
@@ -435,10 +455,84 @@ std::vector<DetailedPushConstantInfo> extractDetailedPushConstants(const std::ve
         result.push_back(info);
     }
 
+    return result;
+}
+
+std::vector<DetailedPushConstantInfo> extractDetailedPushConstants(const std::vector<char> &spirvCode)
+{
+    const uint32_t *spirvData = reinterpret_cast<const uint32_t *>(spirvCode.data());
+    size_t spirvSize = spirvCode.size();
+    SpvReflectShaderModule module;
+    SpvReflectResult reflectResult = spvReflectCreateShaderModule(spirvSize, spirvData, &module);
+
+    if (reflectResult != SPV_REFLECT_RESULT_SUCCESS) {
+        RP_CORE_ERROR("Failed to create reflection data for push constant extraction!");
+        return {};
+    }
+
+    std::vector<DetailedPushConstantInfo> result = s_detailedPushConstantsFromModule(module);
+
     spvReflectDestroyShaderModule(&module);
     return result;
 }
 
+// Descriptor bindings of an already created reflection module, grouped by set
+static std::vector<DescriptorSetInfo> s_descriptorSetsFromModule(const SpvReflectShaderModule &module, VkShaderStageFlags stageFlags)
+{
+    std::vector<DescriptorSetInfo> result;
+
+    uint32_t count = 0;
+    SpvReflectResult reflectResult = spvReflectEnumerateDescriptorBindings(&module, &count, nullptr);
+    if (reflectResult != SPV_REFLECT_RESULT_SUCCESS || count == 0) {
+        return result;
+    }
+
+    std::vector<SpvReflectDescriptorBinding *> bindings(count);
+    reflectResult = spvReflectEnumerateDescriptorBindings(&module, &count, bindings.data());
+    if (reflectResult != SPV_REFLECT_RESULT_SUCCESS) {
+        return result;
+    }
+
+    for (const auto *binding : bindings) {
+        DescriptorBindingInfo bindingInfo{};
+        bindingInfo.binding = binding->binding;
+        bindingInfo.descriptorType = static_cast<VkDescriptorType>(binding->descriptor_type);
+        bindingInfo.descriptorCount = binding->count;
+        bindingInfo.stageFlags = stageFlags;
+        bindingInfo.name = binding->name ? binding->name : "unnamed";
+
+        uint32_t setNumber = binding->set;
+        auto it = std::find_if(result.begin(), result.end(),
+                               [setNumber](const DescriptorSetInfo &info) { return info.setNumber == setNumber; });
+        if (it == result.end()) {
+            result.push_back(DescriptorSetInfo{setNumber, {}});
+            it = result.end() - 1;
+        }
+        it->bindings.push_back(bindingInfo);
+    }
+
+    return result;
+}
+
+bool reflectStageSpirv(const std::vector<char> &spirvCode, VkShaderStageFlags stageFlags, ShaderStageReflection &reflection)
+{
+    const uint32_t *spirvData = reinterpret_cast<const uint32_t *>(spirvCode.data());
+    size_t spirvSize = spirvCode.size();
+
+    SpvReflectShaderModule module;
+    if (spvReflectCreateShaderModule(spirvSize, spirvData, &module) != SPV_REFLECT_RESULT_SUCCESS) {
+        return false;
+    }
+
+    reflection.descriptorSets = s_descriptorSetsFromModule(module, stageFlags);
+    reflection.pushConstants = s_pushConstantsFromModule(module, stageFlags);
+    reflection.detailedPushConstants = s_detailedPushConstantsFromModule(module);
+    reflection.materialSets = s_materialSetsFromModule(module);
+
+    spvReflectDestroyShaderModule(&module);
+    return true;
+}
+
 // Helper to parse a list of float values from a string like "1.0, 2.0, 3.0"
 static std::vector<float> s_parseFloatList(const std::string &str)
 {
@@ -1,6 +1,8 @@
 #ifndef RAPTURE__SHADER_REFLECTIONS_H
 #define RAPTURE__SHADER_REFLECTIONS_H
 
+#include "ShaderCommon.h"
+
 #include <spirv_reflect.h>
 #include <string>
 #include <unordered_map>
@@ -79,6 +81,21 @@ struct DetailedPushConstantInfo {
     std::vector<PushConstantMemberInfo> members;
 };
 
+/**
+ * @brief Everything the engine reads from one stage's SPIR-V, gathered from a single reflection module
+ *
+ * Plain data so it can be stored next to the cached SPIR-V and loaded back without SPIRV-Reflect.
+ * The annotations come from the stage's GLSL source rather than the SPIR-V, and are empty for
+ * precompiled stages.
+ */
+struct ShaderStageReflection {
+    std::vector<DescriptorSetInfo> descriptorSets;
+    std::vector<PushConstantInfo> pushConstants;
+    std::vector<DetailedPushConstantInfo> detailedPushConstants;
+    std::vector<DescriptorInfo> materialSets;
+    std::unordered_map<std::string, PushConstantMemberMetadata> annotations;
+};
+
 // Utility function to convert PushConstantInfo to VkPushConstantRange
 inline VkPushConstantRange pushConstantInfoToRange(const PushConstantInfo &pcInfo)
 {
@@ -120,6 +137,18 @@ std::string getSpirvTypeDescriptionString(const SpvReflectTypeDescription *typeD
 std::vector<PushConstantInfo>
 getCombinedPushConstantRanges(const std::vector<std::pair<std::vector<char>, VkShaderStageFlags>> &shaderCodeWithStages);
 
+// Merge push constant ranges reflected from several stages, combining the stage flags of identical ranges
+std::vector<PushConstantInfo> mergePushConstantRanges(const std::vector<PushConstantInfo> &pushConstants);
+
+/**
+ * @brief Reflects everything the engine needs from one stage in a single pass over the SPIR-V
+ * @param spirvCode The stage's SPIR-V bytecode
+ * @param stageFlags The stage the code belongs to, used when the module does not name one
+ * @param reflection Receives the descriptor sets, push constants and material sets
+ * @return True if the SPIR-V could be reflected
+ */
+bool reflectStageSpirv(const std::vector<char> &spirvCode, VkShaderStageFlags stageFlags, ShaderStageReflection &reflection);
+
 // Extract detailed push constant information including member-level data
 std::vector<DetailedPushConstantInfo> extractDetailedPushConstants(const std::vector<char> &spirvCode);
 
@@ -286,19 +286,32 @@ std::unique_ptr<Texture> Texture::createPlaceholder(TextureSpecification spec)
 }
 
 void Texture::uploadDataAsync(std::vector<uint8_t> data, Counter *completionCounter)
+{
+    auto pixelData = std::make_shared<std::vector<uint8_t>>(std::move(data));
+    size_t size = pixelData->size();
+    uploadDataAsync(
+        size,
+        [pixelData](std::span<uint8_t> staging) {
+            memcpy(staging.data(), pixelData->data(), pixelData->size());
+            return true;
+        },
+        completionCounter);
+}
+
+void Texture::uploadDataAsync(size_t size, std::function<bool(std::span<uint8_t>)> writePixels, Counter *completionCounter)
 {
     m_status.store(TextureStatus::UPLOADING, std::memory_order_release);
 
     Texture *texturePtr = this;
-    auto pixelData = std::make_shared<std::vector<uint8_t>>(std::move(data));
+    auto writer = std::make_shared<std::function<bool(std::span<uint8_t>)>>(std::move(writePixels));
 
     jobs().run(JobDeclaration(
-        [texturePtr, completionCounter, pixelData](JobContext &jctx) {
+        [texturePtr, completionCounter, writer, size](JobContext &jctx) {
             auto &app = Application::getInstance();
             VmaAllocator allocator = app.getVulkanContext().getVmaAllocator();
             auto transferQueue = app.getVulkanContext().getTransferQueue();
 
-            VkDeviceSize imageSize = static_cast<VkDeviceSize>(pixelData->size());
+            VkDeviceSize imageSize = static_cast<VkDeviceSize>(size);
 
             VkBuffer stagingBuffer;
             VmaAllocation stagingAllocation;
@@ -323,9 +336,18 @@ void Texture::uploadDataAsync(std::vector<uint8_t> data, Counter *completionCoun
 
             void *mapped;
             vmaMapMemory(allocator, stagingAllocation, &mapped);
-            memcpy(mapped, pixelData->data(), static_cast<size_t>(imageSize));
+            bool written = (*writer)(std::span<uint8_t>(static_cast<uint8_t *>(mapped), size));
             vmaUnmapMemory(allocator, stagingAllocation);
 
+            if (!written) {
+                vmaDestroyBuffer(allocator, stagingBuffer, stagingAllocation);
+                texturePtr->m_status.store(TextureStatus::FAILED, std::memory_order_release);
+                if (completionCounter) {
+                    completionCounter->decrement();
+                }
+                return;
+            }
+
             size_t threadId = std::hash<std::thread::id>{}(std::this_thread::get_id());
 
             CommandPoolConfig poolConfig{};
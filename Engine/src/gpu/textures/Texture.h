@@ -5,6 +5,7 @@
 #include "gpu/descriptors/DescriptorBinding.h"
 
 #include <atomic>
+#include <functional>
 #include <memory>
 #include <span>
 #include <string>
@@ -60,6 +61,16 @@ class Texture {
      */
     void uploadDataAsync(std::vector<uint8_t> data, Counter *completionCounter = nullptr);
 
+    /**
+     * @brief Fills the staging buffer in place and uploads it via the job system, e.g. to decode an image straight into it
+     *
+     * The staging memory may be write-combined, so the writer should only write, front to back. If it returns false the
+     * texture is marked failed and nothing is uploaded; the counter is decremented either way.
+     * @param size Bytes of the base level, width * height * texel size
+     * @param writePixels Fills the mapped staging span of exactly size bytes, runs on a job
+     */
+    void uploadDataAsync(size_t size, std::function<bool(std::span<uint8_t>)> writePixels, Counter *completionCounter = nullptr);
+
     /**
      * @brief Mark the texture load as failed (e.g. source decode failed upstream)
      */
@@ -0,0 +1,376 @@
+#include "physics/CharacterStepper.h"
+
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseQuery.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
+
+#include "core/utils/TracyProfiler.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace Rapture {
+namespace physics {
+
+// A jump that arrives mid air is served by the first step that finds ground, but only for as long
+// as the buffer lasts. Without the lapse a jump asked for at the top of a long fall still fires on
+// landing, however much later that is.
+static constexpr float JUMP_SETTLE_SPEED = 0.1f;
+
+// Below this a batch costs more to hand to a job than to sweep
+static constexpr uint32_t MIN_BATCH_CHARACTERS = 16;
+// Batches per job, so a job that drew slow characters is made up for by the others claiming more
+static constexpr uint32_t BATCHES_PER_JOB = 4;
+// Past the padding and step heights, how far a character may still find a contact, covering the
+// predictive contact distance
+static constexpr float ISLAND_CONTACT_MARGIN = 0.25f;
+
+/**
+ * @brief Builds the velocity a character body leaves a step with
+ * @param record The character being stepped, whose buffered jump is taken here
+ * @param up The character's upright direction
+ * @param gravity Gravity in world space
+ * @param deltaTime Length of the step in seconds
+ * @return The velocity to step with
+ */
+static JPH::Vec3 s_characterStepVelocity(CharacterRecord &record, JPH::Vec3Arg up, JPH::Vec3Arg gravity, float deltaTime)
+{
+    const JPH::CharacterVirtual &character = *record.character;
+    const JPH::Vec3 ground = character.GetGroundVelocity();
+
+    // taking back what the character was told to move at leaves what the world did to it, so a fall
+    // keeps building while a wall it walked into does not
+    JPH::Vec3 carried = character.GetLinearVelocity() - glmToJoltVec3(record.prevVelocity);
+    carried += gravity * deltaTime;
+
+    // measured against the ground rather than the world, so a character riding a lift is still
+    // standing on it and a character already rising out of a jump is not
+    const bool settled = (carried.Dot(up) - ground.Dot(up)) < JUMP_SETTLE_SPEED;
+    const bool grounded = character.GetGroundState() == JPH::CharacterBase::EGroundState::OnGround && settled;
+    if (grounded) {
+        carried -= up * carried.Dot(up);
+        carried += up * ground.Dot(up);
+
+        if (record.jumpBufferRemaining > 0.0f) {
+            carried += up * record.movement.jumpSpeed;
+            record.jumpBufferRemaining = 0.0f;
+        }
+    }
+
+    record.jumpBufferRemaining = std::max(0.0f, record.jumpBufferRemaining - deltaTime);
+
+    const JPH::Vec3 requested = glmToJoltVec3(record.movement.velocity);
+    JPH::Vec3 applied = requested - up * requested.Dot(up);
+    if (grounded) {
+        // carries the character along with whatever it is standing on
+        applied += ground - up * ground.Dot(up);
+    }
+
+    record.prevVelocity = joltToGlmVec3(applied);
+    return carried + applied;
+}
+
+CharacterStepper::CharacterStepper(uint32_t tempAllocatorSize, uint32_t jobCount, bool characterVsCharacter)
+    : m_tempAllocatorSize(tempAllocatorSize), m_jobCount(jobCount), m_characterVsCharacter(characterVsCharacter)
+{
+}
+
+CharacterStepper::~CharacterStepper() = default;
+
+void CharacterStepper::step(FreeList<CharacterRecord> &records, JPH::PhysicsSystem &system, JPH::JobSystem &jobSystem,
+                            float deltaTime)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    m_lastStats = {};
+    m_entries.clear();
+    m_batches.clear();
+    m_contacts.clear();
+    if (records.size() == 0) {
+        return;
+    }
+
+    // a velocity is worked out from the character's own state alone, and every one is settled before
+    // any sweep so characters stepped together see one another's velocity for this step
+    const JPH::Vec3 gravity = system.GetGravity();
+    records.forEach([&](uint32_t id, CharacterRecord &record) {
+        const JPH::Vec3 up = glmToJoltVec3(record.up);
+        record.character->SetLinearVelocity(s_characterStepVelocity(record, up, gravity, deltaTime));
+        m_entries.push_back({id, &record});
+    });
+
+    const uint32_t count = static_cast<uint32_t>(m_entries.size());
+    const uint32_t slots = m_jobCount != 0 ? m_jobCount : static_cast<uint32_t>(std::max(1, jobSystem.GetMaxConcurrency()));
+    const uint32_t batchSize = std::max(MIN_BATCH_CHARACTERS, (count + slots * BATCHES_PER_JOB - 1) / (slots * BATCHES_PER_JOB));
+
+    if (m_characterVsCharacter) {
+        buildIslands(system, deltaTime);
+        buildIslandBatches(batchSize);
+        m_batchContacts.resize(m_batches.size());
+        for (auto &contacts : m_batchContacts) {
+            contacts.clear();
+        }
+    } else {
+        buildBatches(batchSize);
+    }
+
+    const uint32_t jobCount = std::min(slots, static_cast<uint32_t>(m_batches.size()));
+    while (m_allocators.size() < jobCount) {
+        m_allocators.push_back(std::make_unique<JPH::TempAllocatorImpl>(m_tempAllocatorSize));
+    }
+
+    m_nextBatch.store(0, std::memory_order_relaxed);
+
+    JPH::JobSystem::Barrier *barrier = jobCount > 1 ? jobSystem.CreateBarrier() : nullptr;
+    if (barrier == nullptr) {
+        drain(system, *m_allocators[0], deltaTime);
+        m_lastStats.jobs = 1;
+    } else {
+        // every job claims batches until none are left, sweeping with the allocator of its slot
+        for (uint32_t slot = 0; slot < jobCount; ++slot) {
+            JPH::TempAllocator *allocator = m_allocators[slot].get();
+            auto run = [this, &system, allocator, deltaTime]() { drain(system, *allocator, deltaTime); };
+            barrier->AddJob(jobSystem.CreateJob("Character step", JPH::Color::sGreen, run));
+        }
+        jobSystem.WaitForJobs(barrier);
+        jobSystem.DestroyBarrier(barrier);
+        m_lastStats.jobs = jobCount;
+    }
+
+    if (m_characterVsCharacter) {
+        for (const auto &contacts : m_batchContacts) {
+            m_contacts.insert(m_contacts.end(), contacts.begin(), contacts.end());
+        }
+        // each side of a pair reports it, and batches are appended in island order rather than id order
+        std::sort(m_contacts.begin(), m_contacts.end(), [](const CharacterContact &l, const CharacterContact &r) {
+            return l.a.value != r.a.value ? l.a.value < r.a.value : l.b.value < r.b.value;
+        });
+        auto last = std::unique(m_contacts.begin(), m_contacts.end(), [](const CharacterContact &l, const CharacterContact &r) {
+            return l.a.value == r.a.value && l.b.value == r.b.value;
+        });
+        m_contacts.erase(last, m_contacts.end());
+    }
+
+    m_lastStats.characters = count;
+    m_lastStats.islands = m_characterVsCharacter ? static_cast<uint32_t>(m_islandStarts.size()) - 1 : count;
+    m_lastStats.batches = static_cast<uint32_t>(m_batches.size());
+    m_lastStats.contacts = static_cast<uint32_t>(m_contacts.size());
+    RAPTURE_PROFILE_PLOT("Character Batches", static_cast<int64_t>(m_lastStats.batches));
+}
+
+void CharacterStepper::buildBatches(uint32_t batchSize)
+{
+    const uint32_t count = static_cast<uint32_t>(m_entries.size());
+    for (uint32_t begin = 0; begin < count; begin += batchSize) {
+        m_batches.push_back({begin, std::min(begin + batchSize, count)});
+    }
+}
+
+void CharacterStepper::buildIslands(JPH::PhysicsSystem &system, float deltaTime)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    const uint32_t count = static_cast<uint32_t>(m_entries.size());
+    m_islandParents.resize(count);
+    std::iota(m_islandParents.begin(), m_islandParents.end(), 0u);
+
+    // everywhere the character may reach this step: its shape, moved as far as its velocity takes it
+    // and as far as a stair or the floor may pull it, plus what it keeps contacts at
+    m_reach.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const CharacterRecord &record = *m_entries[i].record;
+        const JPH::CharacterVirtual &character = *record.character;
+
+        JPH::AABox bounds = character.GetShape()->GetWorldSpaceBounds(character.GetCenterOfMassTransform(), JPH::Vec3::sOne());
+        const float reach = character.GetLinearVelocity().Length() * deltaTime + record.stepUp + record.stepDown +
+                            character.GetCharacterPadding() + ISLAND_CONTACT_MARGIN;
+        bounds.ExpandBy(JPH::Vec3::sReplicate(reach));
+        m_reach[i] = bounds;
+    }
+
+    // characters whose reach overlaps may touch, found by sweeping along x
+    m_sweep.resize(count);
+    std::iota(m_sweep.begin(), m_sweep.end(), 0u);
+    std::sort(m_sweep.begin(), m_sweep.end(), [this](uint32_t l, uint32_t r) {
+        const float lx = m_reach[l].mMin.GetX();
+        const float rx = m_reach[r].mMin.GetX();
+        return lx != rx ? lx < rx : l < r;
+    });
+    for (uint32_t i = 0; i < count; ++i) {
+        const JPH::AABox &a = m_reach[m_sweep[i]];
+        for (uint32_t j = i + 1; j < count && m_reach[m_sweep[j]].mMin.GetX() <= a.mMax.GetX(); ++j) {
+            if (a.Overlaps(m_reach[m_sweep[j]])) {
+                join(m_sweep[i], m_sweep[j]);
+            }
+        }
+    }
+
+    // characters that may push the same moving body would race to add their impulses to it
+    const JPH::BroadPhaseQuery &broadPhase = system.GetBroadPhaseQuery();
+    const JPH::SpecifiedBroadPhaseLayerFilter movingBroadPhase(BROAD_PHASE_MOVING);
+    const JPH::SpecifiedObjectLayerFilter movingObjects(LAYER_MOVING);
+    JPH::AllHitCollisionCollector<JPH::CollideShapeBodyCollector> touched;
+    m_bodyToucher.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        touched.Reset();
+        broadPhase.CollideAABox(m_reach[i], touched, movingBroadPhase, movingObjects);
+        for (const JPH::BodyID &body : touched.mHits) {
+            auto [toucher, first] = m_bodyToucher.try_emplace(body.GetIndexAndSequenceNumber(), i);
+            if (!first) {
+                join(toucher->second, i);
+            }
+        }
+    }
+
+    // islands are numbered by their first character and keep their characters in id order, so the
+    // order is the same whichever way the unions above went
+    m_islandOfRoot.assign(count, UINT32_MAX);
+    m_islandStarts.clear();
+    std::vector<uint32_t> &islandOfEntry = m_sweep; // done with the sweep order, reused
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t root = find(i);
+        if (m_islandOfRoot[root] == UINT32_MAX) {
+            m_islandOfRoot[root] = static_cast<uint32_t>(m_islandStarts.size());
+            m_islandStarts.push_back(0);
+        }
+        islandOfEntry[i] = m_islandOfRoot[root];
+        m_islandStarts[islandOfEntry[i]]++;
+    }
+
+    uint32_t start = 0;
+    for (uint32_t &islandStart : m_islandStarts) {
+        const uint32_t size = islandStart;
+        islandStart = start;
+        start += size;
+    }
+    m_islandStarts.push_back(count);
+
+    m_islandEntries.resize(count);
+    std::vector<uint32_t> &cursor = m_islandParents; // done with the unions, reused
+    cursor.assign(m_islandStarts.begin(), m_islandStarts.end() - 1);
+    for (uint32_t i = 0; i < count; ++i) {
+        m_islandEntries[cursor[islandOfEntry[i]]++] = m_entries[i];
+    }
+    m_entries.swap(m_islandEntries);
+
+    // an island's characters collide with one another only, so a sweep never reads a character
+    // another job is moving
+    const uint32_t islandCount = static_cast<uint32_t>(m_islandStarts.size()) - 1;
+    uint32_t shared = 0;
+    for (uint32_t island = 0; island < islandCount; ++island) {
+        const uint32_t begin = m_islandStarts[island];
+        const uint32_t end = m_islandStarts[island + 1];
+        if (end - begin == 1) {
+            m_entries[begin].record->character->SetCharacterVsCharacterCollision(nullptr);
+            continue;
+        }
+
+        if (shared == m_islandCollision.size()) {
+            m_islandCollision.push_back(std::make_unique<JPH::CharacterVsCharacterCollisionSimple>());
+        }
+        JPH::CharacterVsCharacterCollisionSimple &collision = *m_islandCollision[shared++];
+        collision.mCharacters.clear();
+        for (uint32_t i = begin; i < end; ++i) {
+            JPH::CharacterVirtual *character = m_entries[i].record->character.GetPtr();
+            collision.Add(character);
+            character->SetCharacterVsCharacterCollision(&collision);
+        }
+    }
+
+    m_entryByCharacter.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        m_entryByCharacter.emplace(m_entries[i].record->character->GetID().GetValue(), i);
+    }
+}
+
+void CharacterStepper::buildIslandBatches(uint32_t batchSize)
+{
+    const uint32_t islandCount = static_cast<uint32_t>(m_islandStarts.size()) - 1;
+    uint32_t begin = 0;
+    for (uint32_t island = 0; island < islandCount; ++island) {
+        const uint32_t end = m_islandStarts[island + 1];
+        if (end - begin >= batchSize || island + 1 == islandCount) {
+            m_batches.push_back({begin, end});
+            begin = end;
+        }
+    }
+}
+
+void CharacterStepper::drain(JPH::PhysicsSystem &system, JPH::TempAllocator &allocator, float deltaTime)
+{
+    const uint32_t batchCount = static_cast<uint32_t>(m_batches.size());
+    for (uint32_t batch = m_nextBatch.fetch_add(1, std::memory_order_relaxed); batch < batchCount;
+         batch = m_nextBatch.fetch_add(1, std::memory_order_relaxed)) {
+        runBatch(m_batches[batch], system, allocator, deltaTime);
+        if (m_characterVsCharacter) {
+            gatherContacts(m_batches[batch], m_batchContacts[batch]);
+        }
+    }
+}
+
+void CharacterStepper::runBatch(const Batch &batch, JPH::PhysicsSystem &system, JPH::TempAllocator &allocator, float deltaTime)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    const JPH::Vec3 gravity = system.GetGravity();
+    const JPH::DefaultBroadPhaseLayerFilter broadPhaseFilter = system.GetDefaultBroadPhaseLayerFilter(LAYER_MOVING);
+    const JPH::DefaultObjectLayerFilter objectFilter = system.GetDefaultLayerFilter(LAYER_MOVING);
+    const JPH::BodyFilter bodyFilter;
+    const JPH::ShapeFilter shapeFilter;
+
+    for (uint32_t i = batch.begin; i < batch.end; ++i) {
+        CharacterRecord &record = *m_entries[i].record;
+        const JPH::Vec3 up = glmToJoltVec3(record.up);
+
+        JPH::CharacterVirtual::ExtendedUpdateSettings settings;
+        settings.mStickToFloorStepDown = -up * record.stepDown;
+        settings.mWalkStairsStepUp = up * record.stepUp;
+
+        record.character->ExtendedUpdate(deltaTime, gravity, settings, broadPhaseFilter, objectFilter, bodyFilter, shapeFilter,
+                                         allocator);
+    }
+}
+
+void CharacterStepper::gatherContacts(const Batch &batch, std::vector<CharacterContact> &outContacts) const
+{
+    for (uint32_t i = batch.begin; i < batch.end; ++i) {
+        const Entry &entry = m_entries[i];
+        for (const JPH::CharacterVirtual::Contact &contact : entry.record->character->GetActiveContacts()) {
+            if (contact.mCharacterIDB.IsInvalid()) {
+                continue;
+            }
+
+            auto other = m_entryByCharacter.find(contact.mCharacterIDB.GetValue());
+            if (other == m_entryByCharacter.end()) {
+                continue;
+            }
+
+            const Entry &b = m_entries[other->second];
+            const Entry &first = entry.id < b.id ? entry : b;
+            const Entry &second = entry.id < b.id ? b : entry;
+            outContacts.push_back({CharacterBodyId{first.id}, CharacterBodyId{second.id}, first.record->owner,
+                                   second.record->owner});
+        }
+    }
+}
+
+uint32_t CharacterStepper::find(uint32_t entry)
+{
+    while (m_islandParents[entry] != entry) {
+        m_islandParents[entry] = m_islandParents[m_islandParents[entry]];
+        entry = m_islandParents[entry];
+    }
+    return entry;
+}
+
+void CharacterStepper::join(uint32_t a, uint32_t b)
+{
+    a = find(a);
+    b = find(b);
+    if (a != b) {
+        // the lower entry stays the root, so the partition reads the same whichever order pairs come in
+        m_islandParents[std::max(a, b)] = std::min(a, b);
+    }
+}
+
+} // namespace physics
+} // namespace Rapture
@@ -0,0 +1,125 @@
+#ifndef RAPTURE__PHYSICS_CHARACTER_STEPPER_H
+#define RAPTURE__PHYSICS_CHARACTER_STEPPER_H
+
+#include "physics/Internal.h"
+
+#include <Jolt/Physics/Character/CharacterVirtual.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Rapture {
+namespace physics {
+
+/**
+ * @brief Sweeps every character body through the world, split over jobs
+ *
+ * Characters are cut into batches that jobs claim one at a time, and each job sweeps with a temp
+ * allocator of its own, so no two jobs share one. Without characterVsCharacter a character sees only
+ * the world's bodies, so any character may go in any batch.
+ *
+ * With it, characters whose reach this step overlaps, or that may touch the same moving body, are
+ * joined into an island. An island is swept by one job in id order and its characters collide only
+ * with one another, through a collision object of its own, so nothing a job reads is written by
+ * another and the outcome is the same however the batches were scheduled. The character contacts
+ * each island finds are gathered afterwards in id order.
+ */
+class CharacterStepper {
+  public:
+    /**
+     * @param tempAllocatorSize Bytes of temp memory each job sweeps with
+     * @param jobCount Jobs to split the characters over, 0 for as many as the job system runs at once
+     * @param characterVsCharacter Whether characters collide with one another
+     */
+    CharacterStepper(uint32_t tempAllocatorSize, uint32_t jobCount, bool characterVsCharacter);
+    ~CharacterStepper();
+
+    CharacterStepper(const CharacterStepper &) = delete;
+    CharacterStepper &operator=(const CharacterStepper &) = delete;
+
+    /**
+     * @brief Sweeps every character through one step
+     * @param records The characters, whose velocities for the step are worked out here
+     * @param system The simulation they move through, already stepped
+     * @param jobSystem Where the batches run, the waiting thread running some itself
+     * @param deltaTime Length of the step in seconds
+     */
+    void step(FreeList<CharacterRecord> &records, JPH::PhysicsSystem &system, JPH::JobSystem &jobSystem, float deltaTime);
+
+    /**
+     * @brief Characters touching one another after the last step, each pair once and in id order
+     */
+    const std::vector<CharacterContact> &getContacts() const { return m_contacts; }
+
+    const CharacterStepStats &getLastStats() const { return m_lastStats; }
+
+  private:
+    struct Entry {
+        uint32_t id;
+        CharacterRecord *record;
+    };
+
+    struct Batch {
+        uint32_t begin; // range of m_entries
+        uint32_t end;
+    };
+
+    /**
+     * @brief Orders m_entries island by island and gives every island its own collision object
+     */
+    void buildIslands(JPH::PhysicsSystem &system, float deltaTime);
+
+    /**
+     * @brief Cuts m_entries into batches of about batchSize at island boundaries
+     */
+    void buildIslandBatches(uint32_t batchSize);
+
+    /**
+     * @brief Cuts m_entries into batches of about the same size, for characters that cannot touch
+     */
+    void buildBatches(uint32_t batchSize);
+
+    /**
+     * @brief Claims and sweeps batches until none are left
+     */
+    void drain(JPH::PhysicsSystem &system, JPH::TempAllocator &allocator, float deltaTime);
+
+    void runBatch(const Batch &batch, JPH::PhysicsSystem &system, JPH::TempAllocator &allocator, float deltaTime);
+    void gatherContacts(const Batch &batch, std::vector<CharacterContact> &outContacts) const;
+
+    uint32_t find(uint32_t entry);
+    void join(uint32_t a, uint32_t b);
+
+  private:
+    uint32_t m_tempAllocatorSize;
+    uint32_t m_jobCount;
+    bool m_characterVsCharacter;
+
+    std::vector<std::unique_ptr<JPH::TempAllocatorImpl>> m_allocators; // one per job slot
+    std::vector<Entry> m_entries;
+    std::vector<Batch> m_batches;
+    std::atomic<uint32_t> m_nextBatch{0};
+
+    // character vs character only, rebuilt every step
+    std::vector<uint32_t> m_islandParents;
+    std::vector<JPH::AABox> m_reach;
+    std::vector<uint32_t> m_sweep;
+    std::unordered_map<uint32_t, uint32_t> m_bodyToucher; // moving body to the first entry that may touch it
+    std::vector<uint32_t> m_islandOfRoot;
+    std::vector<uint32_t> m_islandStarts; // range of m_entries each island covers, plus the end
+    std::vector<Entry> m_islandEntries;
+    std::vector<std::unique_ptr<JPH::CharacterVsCharacterCollisionSimple>> m_islandCollision;
+    std::unordered_map<uint32_t, uint32_t> m_entryByCharacter; // by JPH::CharacterID
+    std::vector<std::vector<CharacterContact>> m_batchContacts;
+    std::vector<CharacterContact> m_contacts;
+
+    CharacterStepStats m_lastStats;
+};
+
+} // namespace physics
+} // namespace Rapture
+
+#endif // RAPTURE__PHYSICS_CHARACTER_STEPPER_H
@@ -5,8 +5,12 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <memory>
+#include <span>
 #include <string_view>
+#include <type_traits>
 #include <variant>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
@@ -89,6 +93,49 @@ struct CapsuleShape {
     float radius = 0.5f;
 };
 
+/**
+ * @brief Collision geometry cooked into Jolt's binary shape format, read back without cooking it again
+ */
+struct CookedShape {
+    std::vector<uint8_t> bytes;
+};
+
+/**
+ * @brief The collision a StaticMesh was cooked into when it was imported, streamed in with the mesh
+ */
+struct CookedCollision {
+    std::shared_ptr<const CookedShape> mesh;        ///< Every triangle, for static level geometry
+    std::shared_ptr<const CookedShape> convexHull;  ///< The hull around every vertex, for moving props
+    std::shared_ptr<const CookedShape> heightField; ///< Only for a mesh laid out as a square grid of heights
+};
+
+/**
+ * @brief Geometry taken from the collision a StaticMesh was cooked into
+ *
+ * The mesh is what is written to a file, and the cooked data is looked up from it before a body is
+ * built. Without a mesh named, a body takes the mesh of the object it is part of.
+ */
+struct CookedShapeSource {
+    uint64_t mesh = 0;                          ///< Handle of the StaticMesh asset
+    std::shared_ptr<const CookedShape> cooked;  ///< Resolved from the mesh, never written out
+    glm::vec3 scale{1.0f};
+};
+
+/**
+ * @brief Every triangle of a mesh, which has no volume and so only makes static bodies
+ */
+struct MeshShape : CookedShapeSource {};
+
+/**
+ * @brief The convex hull around a mesh
+ */
+struct ConvexHullShape : CookedShapeSource {};
+
+/**
+ * @brief A mesh laid out as a square grid read as heights, which only makes static bodies
+ */
+struct HeightFieldShape : CookedShapeSource {};
+
 /**
  * @brief Names the alternatives of CollisionShape, in the order the variant declares them
  */
@@ -96,10 +143,13 @@ enum CollisionShapeType {
     COLLISION_SHAPE_BOX,
     COLLISION_SHAPE_SPHERE,
     COLLISION_SHAPE_CAPSULE,
+    COLLISION_SHAPE_MESH,
+    COLLISION_SHAPE_CONVEX_HULL,
+    COLLISION_SHAPE_HEIGHT_FIELD,
     COLLISION_SHAPE_COUNT
 };
 
-using CollisionShape = std::variant<BoxShape, SphereShape, CapsuleShape>;
+using CollisionShape = std::variant<BoxShape, SphereShape, CapsuleShape, MeshShape, ConvexHullShape, HeightFieldShape>;
 
 /**
  * @brief The type of the geometry a shape currently holds
@@ -125,6 +175,12 @@ inline std::string_view CollisionShape_toString(CollisionShapeType type)
         return "sphere";
     case COLLISION_SHAPE_CAPSULE:
         return "capsule";
+    case COLLISION_SHAPE_MESH:
+        return "mesh";
+    case COLLISION_SHAPE_CONVEX_HULL:
+        return "convexHull";
+    case COLLISION_SHAPE_HEIGHT_FIELD:
+        return "heightField";
     default:
         return {};
     }
@@ -161,6 +217,12 @@ inline CollisionShape CollisionShape_ofType(CollisionShapeType type)
         return SphereShape{};
     case COLLISION_SHAPE_CAPSULE:
         return CapsuleShape{};
+    case COLLISION_SHAPE_MESH:
+        return MeshShape{};
+    case COLLISION_SHAPE_CONVEX_HULL:
+        return ConvexHullShape{};
+    case COLLISION_SHAPE_HEIGHT_FIELD:
+        return HeightFieldShape{};
     default:
         RP_CORE_ERROR("a collision shape type was added without a shape to build for it");
         return BoxShape{};
@@ -190,7 +252,62 @@ inline CollisionShape CollisionShape_scaled(const CollisionShape &shape, const g
         return CapsuleShape{capsule->halfHeight * magnitude.y, capsule->radius * std::max(magnitude.x, magnitude.z)};
     }
 
-    return shape;
+    // cooked geometry is never cooked again, the scale is carried and applied to it when it is read back
+    return std::visit(
+        [&](const auto &s) -> CollisionShape {
+            using T = std::decay_t<decltype(s)>;
+            if constexpr (std::is_base_of_v<CookedShapeSource, T>) {
+                T scaled = s;
+                scaled.scale *= magnitude;
+                return scaled;
+            } else {
+                return s;
+            }
+        },
+        shape);
+}
+
+/**
+ * @brief The cooked geometry a shape is read back from, if it is one of the shapes taken from a mesh
+ * @param shape The shape to inspect
+ * @return The shape's source, nullptr for a shape built from its own dimensions
+ */
+inline const CookedShapeSource *CollisionShape_cookedSource(const CollisionShape &shape)
+{
+    return std::visit(
+        [](const auto &s) -> const CookedShapeSource * {
+            if constexpr (std::is_base_of_v<CookedShapeSource, std::decay_t<decltype(s)>>) {
+                return &s;
+            } else {
+                return nullptr;
+            }
+        },
+        shape);
+}
+
+inline CookedShapeSource *CollisionShape_cookedSource(CollisionShape &shape)
+{
+    return const_cast<CookedShapeSource *>(CollisionShape_cookedSource(static_cast<const CollisionShape &>(shape)));
+}
+
+/**
+ * @brief Picks the cooked data a shape reads back out of what a mesh was cooked into
+ * @param shape The shape, one of those taken from a mesh
+ * @param collision What the mesh was cooked into
+ * @return The cooked data, nullptr when the mesh was not cooked into that kind
+ */
+inline std::shared_ptr<const CookedShape> CollisionShape_pickCooked(const CollisionShape &shape, const CookedCollision &collision)
+{
+    switch (CollisionShape_typeOf(shape)) {
+    case COLLISION_SHAPE_MESH:
+        return collision.mesh;
+    case COLLISION_SHAPE_CONVEX_HULL:
+        return collision.convexHull;
+    case COLLISION_SHAPE_HEIGHT_FIELD:
+        return collision.heightField;
+    default:
+        return nullptr;
+    }
 }
 
 /**
@@ -245,6 +362,36 @@ struct BodyState {
     glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
 };
 
+/**
+ * @brief The states a run of fixed steps left behind, for drawing between the last two of them
+ */
+struct StepCapture {
+    std::vector<BodyState> previous; ///< After the step before the last, empty when the run was a single step
+    std::vector<BodyState> current;  ///< After the last step
+    uint32_t steps = 0;
+};
+
+/**
+ * @brief Two character bodies touching after a step, the one with the lower id first.
+ */
+struct CharacterContact {
+    CharacterBodyId a;
+    CharacterBodyId b;
+    void *ownerA = nullptr;
+    void *ownerB = nullptr;
+};
+
+/**
+ * @brief How the last step spread its character bodies over jobs.
+ */
+struct CharacterStepStats {
+    uint32_t characters = 0;
+    uint32_t islands = 0; ///< Groups stepped together because they may touch, one per character without characterVsCharacter
+    uint32_t batches = 0;
+    uint32_t jobs = 0;
+    uint32_t contacts = 0;
+};
+
 /**
  * @brief What a ray found.
  */
@@ -256,6 +403,85 @@ struct RaycastResult {
     float distance = 0.0f;
 };
 
+/**
+ * @brief The object layers a query sees, one bit per layer
+ */
+enum QueryLayers : uint32_t {
+    QUERY_LAYER_STATIC = 1u << 0, ///< Bodies made static
+    QUERY_LAYER_MOVING = 1u << 1, ///< Dynamic and kinematic bodies
+    QUERY_LAYER_ALL = QUERY_LAYER_STATIC | QUERY_LAYER_MOVING
+};
+
+/**
+ * @brief A ray of a batch, which finds the closest body along it
+ */
+struct RayQuery {
+    glm::vec3 origin{0.0f};
+    glm::vec3 direction{0.0f, 0.0f, -1.0f}; ///< Unit direction
+    float maxDistance = 100.0f;
+    uint32_t layers = QUERY_LAYER_ALL;
+};
+
+/**
+ * @brief A shape of a batch swept along a direction, which finds the closest body it strikes
+ */
+struct ShapeCastQuery {
+    uint32_t shape = 0; ///< Index into SceneQueryBatch::shapes
+    glm::vec3 origin{0.0f};
+    glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+    glm::vec3 direction{0.0f, 0.0f, -1.0f}; ///< Unit direction
+    float maxDistance = 100.0f;
+    uint32_t layers = QUERY_LAYER_ALL;
+};
+
+/**
+ * @brief A shape of a batch placed in the world, which finds every body it overlaps
+ */
+struct OverlapQuery {
+    uint32_t shape = 0; ///< Index into SceneQueryBatch::shapes
+    glm::vec3 position{0.0f};
+    glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+    uint32_t layers = QUERY_LAYER_ALL;
+};
+
+/**
+ * @brief The bodies an overlap found, whose owners are written to its slice of SceneQueryBatch::overlapOwners
+ */
+struct OverlapResult {
+    uint32_t count = 0;
+    bool truncated = false; ///< More bodies overlapped than the slice holds
+};
+
+/**
+ * @brief Queries run together, each kind into an output array the caller sized to match
+ *
+ * Every output is written at the index of its query, so queries need not be sorted and the outputs
+ * can be kept from frame to frame without reallocating. Overlap i writes the owners it finds to
+ * overlapOwners[i * overlapCapacity] onwards, overlapCapacity being overlapOwners.size() / overlaps.size().
+ */
+struct SceneQueryBatch {
+    std::span<const RayQuery> rays;
+    std::span<RaycastResult> rayHits; ///< One per ray
+
+    std::span<const CollisionShape> shapes; ///< What shape casts and overlaps sweep and place, by index
+    std::span<const ShapeCastQuery> shapeCasts;
+    std::span<RaycastResult> shapeCastHits; ///< One per shape cast
+
+    std::span<const OverlapQuery> overlaps;
+    std::span<OverlapResult> overlapResults; ///< One per overlap
+    std::span<void *> overlapOwners;
+};
+
+/**
+ * @brief How the last batch of queries was run
+ */
+struct SceneQueryStats {
+    uint32_t rays = 0;
+    uint32_t shapeCasts = 0;
+    uint32_t overlaps = 0;
+    uint32_t jobs = 0; ///< 0 when the batch was small enough to run on the calling thread
+};
+
 /**
  * @brief The settings a simulation is created with.
  */
@@ -268,6 +494,13 @@ struct SystemConfig {
     uint32_t maxContactConstraints = 10240;
     uint32_t numBodyMutexes = 0;
     uint32_t tempAllocatorSize = 10u * 1024u * 1024u;
+    uint32_t characterTempAllocatorSize = 1u * 1024u * 1024u; ///< Per job stepping character bodies
+    uint32_t characterJobs = 0;                               ///< Jobs character bodies are split over, 0 for one per thread
+    // character bodies collide with one another, those that may touch in a step stepped together in id order so
+    // the outcome does not depend on how the jobs were scheduled
+    bool characterVsCharacter = false;
+    // steps on Jolt's own thread pool rather than the engine's job system, which needs JobSystem::init() first
+    bool privateJobPool = false;
 };
 
 } // namespace Rapture::physics
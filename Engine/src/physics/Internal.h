@@ -98,6 +98,25 @@ inline GroundState joltToGroundState(JPH::CharacterBase::EGroundState state)
     }
 }
 
+/**
+ * @brief Registers Jolt's allocator, factory and types if nothing has yet
+ *
+ * The first call registers them for the rest of the process, calls racing it wait until it is done,
+ * so shapes can be cooked on import jobs while no world exists.
+ */
+void ensureJoltGlobals();
+
+/**
+ * @brief Reads a cooked shape back into the shape it was cooked from
+ * @return The shape, nullptr if the bytes are not a shape this build of Jolt reads
+ */
+JPH::ShapeRefC restoreCookedShape(const CookedShape &cooked);
+
+/**
+ * @brief Wraps a shape read back from cooked data in the scale of the body built from it
+ */
+JPH::ShapeRefC scaleCookedShape(const JPH::ShapeRefC &shape, const glm::vec3 &scale);
+
 inline JPH::ShapeRefC createJoltShape(const CollisionShape &shape)
 {
     return std::visit(
@@ -109,6 +128,12 @@ inline JPH::ShapeRefC createJoltShape(const CollisionShape &shape)
                 return new JPH::SphereShape(std::max(s.radius, MIN_SHAPE_EXTENT));
             } else if constexpr (std::is_same_v<T, CapsuleShape>) {
                 return new JPH::CapsuleShape(std::max(s.halfHeight, MIN_SHAPE_EXTENT), std::max(s.radius, MIN_SHAPE_EXTENT));
+            } else if constexpr (std::is_base_of_v<CookedShapeSource, T>) {
+                // cooked when the mesh was imported, only ever read back here
+                if (s.cooked == nullptr) {
+                    return JPH::ShapeRefC{};
+                }
+                return scaleCookedShape(restoreCookedShape(*s.cooked), s.scale);
             } else {
                 static_assert(sizeof(T) == 0, "Unhandled physics shape type");
                 return JPH::ShapeRefC{};
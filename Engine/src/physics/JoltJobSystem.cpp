@@ -0,0 +1,161 @@
+#include "physics/JoltJobSystem.h"
+
+#include "core/jobs/JobSystem.h"
+#include "core/utils/Log.h"
+
+#include <chrono>
+#include <emmintrin.h>
+#include <thread>
+
+namespace Rapture {
+namespace physics {
+
+JoltJobSystem::JoltJobSystem(uint32_t maxJobs, uint32_t maxBarriers)
+{
+    m_jobs.Init(maxJobs, maxJobs);
+
+    m_barriers.reserve(maxBarriers);
+    for (uint32_t i = 0; i < maxBarriers; ++i) {
+        m_barriers.push_back(std::make_unique<CounterBarrier>());
+    }
+}
+
+JoltJobSystem::~JoltJobSystem() = default;
+
+int JoltJobSystem::GetMaxConcurrency() const
+{
+    // the thread waiting on a barrier runs jobs as well
+    return static_cast<int>(jobs().getWorkerCount()) + 1;
+}
+
+JPH::JobHandle JoltJobSystem::CreateJob(const char *inName, JPH::ColorArg inColor, const JobFunction &inJobFunction,
+                                        JPH::uint32 inNumDependencies)
+{
+    uint32_t index = JPH::FixedSizeFreeList<Job>::cInvalidObjectIndex;
+    for (;;) {
+        index = m_jobs.ConstructObject(inName, inColor, this, inJobFunction, inNumDependencies);
+        if (index != JPH::FixedSizeFreeList<Job>::cInvalidObjectIndex) {
+            break;
+        }
+        // every job is alive, one frees once a worker finishes it
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    Job *job = &m_jobs.Get(index);
+
+    // taken before queueing, a job without dependencies may finish and free itself right away
+    JobHandle handle(job);
+    if (inNumDependencies == 0) {
+        QueueJob(job);
+    }
+    return handle;
+}
+
+void JoltJobSystem::QueueJob(Job *inJob)
+{
+    // held by the declaration until the job has run, Release() frees it through FreeJob()
+    inJob->AddRef();
+
+    auto run = [inJob](JobContext &) {
+        inJob->Execute();
+        inJob->Release();
+    };
+    // Jolt's jobs keep large frames on the stack, collision of compound and mesh shapes especially
+    jobs().run(JobDeclaration(run, JobPriority::HIGH, QueueAffinity::ANY, nullptr, inJob->GetName(), JobStack::LARGE));
+}
+
+void JoltJobSystem::QueueJobs(Job **inJobs, JPH::uint inNumJobs)
+{
+    for (JPH::uint i = 0; i < inNumJobs; ++i) {
+        QueueJob(inJobs[i]);
+    }
+}
+
+void JoltJobSystem::FreeJob(Job *inJob)
+{
+    m_jobs.DestructObject(inJob);
+}
+
+JPH::JobSystem::Barrier *JoltJobSystem::CreateBarrier()
+{
+    for (auto &barrier : m_barriers) {
+        bool expected = false;
+        if (barrier->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return barrier.get();
+        }
+    }
+
+    RP_CORE_ERROR("JoltJobSystem: out of barriers");
+    return nullptr;
+}
+
+void JoltJobSystem::DestroyBarrier(Barrier *inBarrier)
+{
+    static_cast<CounterBarrier *>(inBarrier)->inUse.store(false, std::memory_order_release);
+}
+
+void JoltJobSystem::WaitForJobs(Barrier *inBarrier)
+{
+    static_cast<CounterBarrier *>(inBarrier)->wait();
+}
+
+void JoltJobSystem::CounterBarrier::AddJob(const JobHandle &inJob)
+{
+    // counted first, the job may finish and report in before SetBarrier() even returns
+    m_pending.increment();
+    if (!inJob.GetPtr()->SetBarrier(this)) {
+        m_pending.decrement();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.push_back(inJob);
+}
+
+void JoltJobSystem::CounterBarrier::AddJobs(const JobHandle *inHandles, JPH::uint inNumHandles)
+{
+    for (JPH::uint i = 0; i < inNumHandles; ++i) {
+        AddJob(inHandles[i]);
+    }
+}
+
+void JoltJobSystem::CounterBarrier::OnJobFinished(Job *inJob)
+{
+    (void)inJob;
+    m_pending.decrement();
+}
+
+void JoltJobSystem::CounterBarrier::wait()
+{
+    while (m_pending.get() > 0) {
+        JobHandle ready;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t i = 0; i < m_jobs.size();) {
+                if (m_jobs[i].IsDone()) {
+                    m_jobs[i] = m_jobs.back();
+                    m_jobs.pop_back();
+                    continue;
+                }
+                if (m_jobs[i].GetPtr()->CanBeExecuted()) {
+                    ready = m_jobs[i];
+                    break;
+                }
+                ++i;
+            }
+        }
+
+        // a job runs once whoever claims it first, so racing its worker here is harmless
+        if (ready.IsValid()) {
+            ready.GetPtr()->Execute();
+        } else {
+            _mm_pause();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.clear();
+}
+
+} // namespace physics
+} // namespace Rapture
@@ -0,0 +1,81 @@
+#ifndef RAPTURE__PHYSICS_JOLT_JOB_SYSTEM_H
+#define RAPTURE__PHYSICS_JOLT_JOB_SYSTEM_H
+
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <Jolt/Core/JobSystem.h>
+
+#include "core/jobs/Counter.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Rapture {
+namespace physics {
+
+/**
+ * @brief Runs Jolt's jobs on the engine's job system instead of threads of its own
+ *
+ * Every job Jolt queues becomes one JobDeclaration, so the simulation shares the engine's workers
+ * rather than competing with them for cores. A barrier counts the jobs added to it on a Counter,
+ * and the thread waiting on it runs whichever of those jobs are ready itself, the way Jolt's own
+ * thread pool does, so a step makes progress even while every worker is busy elsewhere.
+ */
+class JoltJobSystem final : public JPH::JobSystem {
+  public:
+    /**
+     * @param maxJobs Jobs that may be alive at once, JPH::cMaxPhysicsJobs for a PhysicsSystem
+     * @param maxBarriers Barriers that may be alive at once, JPH::cMaxPhysicsBarriers for a PhysicsSystem
+     */
+    JoltJobSystem(uint32_t maxJobs, uint32_t maxBarriers);
+    ~JoltJobSystem() override;
+
+    int GetMaxConcurrency() const override;
+    JobHandle CreateJob(const char *inName, JPH::ColorArg inColor, const JobFunction &inJobFunction,
+                        JPH::uint32 inNumDependencies = 0) override;
+    Barrier *CreateBarrier() override;
+    void DestroyBarrier(Barrier *inBarrier) override;
+    void WaitForJobs(Barrier *inBarrier) override;
+
+  protected:
+    void QueueJob(Job *inJob) override;
+    void QueueJobs(Job **inJobs, JPH::uint inNumJobs) override;
+    void FreeJob(Job *inJob) override;
+
+  private:
+    /**
+     * @brief Counts the unfinished jobs added to it and keeps them so the waiter can run them
+     */
+    class CounterBarrier final : public Barrier {
+      public:
+        void AddJob(const JobHandle &inJob) override;
+        void AddJobs(const JobHandle *inHandles, JPH::uint inNumHandles) override;
+
+        /**
+         * @brief Runs ready jobs on the calling thread until every job added has finished
+         */
+        void wait();
+
+        std::atomic<bool> inUse{false};
+
+      protected:
+        void OnJobFinished(Job *inJob) override;
+
+      private:
+        Counter m_pending;
+        std::mutex m_mutex;
+        std::vector<JobHandle> m_jobs; // guarded by m_mutex, only read by the waiter
+    };
+
+    JPH::FixedSizeFreeList<Job> m_jobs;
+    std::vector<std::unique_ptr<CounterBarrier>> m_barriers;
+};
+
+} // namespace physics
+} // namespace Rapture
+
+#endif // RAPTURE__PHYSICS_JOLT_JOB_SYSTEM_H
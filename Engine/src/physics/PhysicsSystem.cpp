@@ -3,16 +3,26 @@
 #include <Jolt/Core/Factory.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Physics/Body/BodyLock.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseQuery.h>
 #include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/CollideShape.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
 #include <Jolt/Physics/Collision/NarrowPhaseQuery.h>
 #include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/ShapeCast.h>
 #include <Jolt/Physics/PhysicsSettings.h>
 #include <Jolt/RegisterTypes.h>
 
+#include "core/jobs/Counter.h"
+#include "core/jobs/JobSystem.h"
+#include "core/utils/TracyProfiler.h"
 #include "physics/CharacterBody.h"
+#include "physics/CharacterStepper.h"
+#include "physics/JoltJobSystem.h"
 #include "physics/RigidBody.h"
 
 #include <atomic>
+#include <cmath>
 #include <cstdarg>
 #include <thread>
 
@@ -38,28 +48,33 @@ static bool s_assertFailedImpl(const char *inExpression, const char *inMessage,
 }
 #endif // JPH_ENABLE_ASSERTS
 
-static std::atomic<int> gWorldCount{0};
+namespace {
+
+// registered by the first caller, every other one waits for that to finish, and unregistered at exit
+struct JoltGlobals {
+    JoltGlobals()
+    {
+        JPH::RegisterDefaultAllocator();
+        JPH::Trace = s_traceImpl;
+        JPH_IF_ENABLE_ASSERTS(JPH::AssertFailed = s_assertFailedImpl;)
+        JPH::Factory::sInstance = new JPH::Factory();
+        JPH::RegisterTypes();
+    }
 
-static void s_registerJoltGlobals()
-{
-    if (gWorldCount.fetch_add(1) != 0) {
-        return;
+    ~JoltGlobals()
+    {
+        JPH::UnregisterTypes();
+        delete JPH::Factory::sInstance;
+        JPH::Factory::sInstance = nullptr;
     }
-    JPH::RegisterDefaultAllocator();
-    JPH::Trace = s_traceImpl;
-    JPH_IF_ENABLE_ASSERTS(JPH::AssertFailed = s_assertFailedImpl;)
-    JPH::Factory::sInstance = new JPH::Factory();
-    JPH::RegisterTypes();
-}
+};
 
-static void s_unregisterJoltGlobals()
+} // namespace
+
+void physics::ensureJoltGlobals()
 {
-    if (gWorldCount.fetch_sub(1) != 1) {
-        return;
-    }
-    JPH::UnregisterTypes();
-    delete JPH::Factory::sInstance;
-    JPH::Factory::sInstance = nullptr;
+    static JoltGlobals globals;
+    (void)globals;
 }
 
 static int s_jobThreadCount()
@@ -68,137 +83,169 @@ static int s_jobThreadCount()
     return std::max(1, hardwareThreads - 1);
 }
 
-// A jump that arrives mid air is served by the first step that finds ground, but only for as long
-// as the buffer lasts. Without the lapse a jump asked for at the top of a long fall still fires on
-// landing, however much later that is.
-static constexpr float JUMP_SETTLE_SPEED = 0.1f;
-
-/**
- * @brief Builds the velocity a character body leaves a step with
- * @param record The character being stepped, whose buffered jump is taken here
- * @param up The character's upright direction
- * @param gravity Gravity in world space
- * @param deltaTime Length of the step in seconds
- * @return The velocity to step with
- */
-static JPH::Vec3 s_characterStepVelocity(physics::CharacterRecord &record, JPH::Vec3Arg up, JPH::Vec3Arg gravity, float deltaTime)
-{
-    const JPH::CharacterVirtual &character = *record.character;
-    const JPH::Vec3 ground = character.GetGroundVelocity();
-
-    // taking back what the character was told to move at leaves what the world did to it, so a fall
-    // keeps building while a wall it walked into does not
-    JPH::Vec3 carried = character.GetLinearVelocity() - physics::glmToJoltVec3(record.prevVelocity);
-    carried += gravity * deltaTime;
-
-    // measured against the ground rather than the world, so a character riding a lift is still
-    // standing on it and a character already rising out of a jump is not
-    const bool settled = (carried.Dot(up) - ground.Dot(up)) < JUMP_SETTLE_SPEED;
-    const bool grounded = character.GetGroundState() == JPH::CharacterBase::EGroundState::OnGround && settled;
-    if (grounded) {
-        carried -= up * carried.Dot(up);
-        carried += up * ground.Dot(up);
-
-        if (record.jumpBufferRemaining > 0.0f) {
-            carried += up * record.movement.jumpSpeed;
-            record.jumpBufferRemaining = 0.0f;
-        }
-    }
-
-    record.jumpBufferRemaining = std::max(0.0f, record.jumpBufferRemaining - deltaTime);
-
-    const JPH::Vec3 requested = physics::glmToJoltVec3(record.movement.velocity);
-    JPH::Vec3 applied = requested - up * requested.Dot(up);
-    if (grounded) {
-        // carries the character along with whatever it is standing on
-        applied += ground - up * ground.Dot(up);
-    }
-
-    record.prevVelocity = physics::joltToGlmVec3(applied);
-    return carried + applied;
-}
-
 PhysicsSystem::PhysicsSystem(const physics::SystemConfig &config)
-    : m_fixedTimeStep(config.fixedTimeStep), m_maxStepsPerUpdate(config.maxStepsPerUpdate)
+    : m_queriesOnJobs(!config.privateJobPool), m_fixedTimeStep(config.fixedTimeStep), m_maxStepsPerUpdate(config.maxStepsPerUpdate)
 {
-    s_registerJoltGlobals();
+    physics::ensureJoltGlobals();
 
     m_tempAllocator = std::make_unique<JPH::TempAllocatorImpl>(config.tempAllocatorSize);
-    m_jobSystem.Init(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, s_jobThreadCount());
+    if (config.privateJobPool) {
+        m_jobSystem = std::make_unique<JPH::JobSystemThreadPool>(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers,
+                                                                 s_jobThreadCount());
+    } else {
+        m_jobSystem = std::make_unique<physics::JoltJobSystem>(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers);
+    }
 
     m_physicsSystem.Init(config.maxBodies, config.numBodyMutexes, config.maxBodyPairs, config.maxContactConstraints,
                          m_broadPhaseLayerInterface, m_objectVsBroadPhaseLayerFilter, m_objectLayerPairFilter);
     m_physicsSystem.SetGravity(physics::glmToJoltVec3(config.gravity));
     m_bodyInterface = &m_physicsSystem.GetBodyInterface();
+
+    m_characterStepper = std::make_unique<physics::CharacterStepper>(config.characterTempAllocatorSize, config.characterJobs,
+                                                                     config.characterVsCharacter);
 }
 
 PhysicsSystem::~PhysicsSystem()
 {
+    waitForSteps();
     m_characterRecords.clear();
-    s_unregisterJoltGlobals();
+    m_cookedShapes.clear();
 }
 
 void PhysicsSystem::onUpdate(float deltaTime)
+{
+    const uint32_t steps = advance(deltaTime);
+    for (uint32_t i = 0; i < steps; ++i) {
+        step();
+    }
+}
+
+uint32_t PhysicsSystem::advance(float deltaTime)
 {
     if (deltaTime <= 0.0f) {
-        return;
+        return 0;
     }
 
     m_accumulator += deltaTime;
 
-    uint32_t stepsTaken = 0;
-    while (m_accumulator >= m_fixedTimeStep && stepsTaken < m_maxStepsPerUpdate) {
-        m_physicsSystem.Update(m_fixedTimeStep, 1, m_tempAllocator.get(), &m_jobSystem);
-        stepCharacters(m_fixedTimeStep);
-        m_accumulator -= m_fixedTimeStep;
-        ++stepsTaken;
-    }
+    const uint32_t due = static_cast<uint32_t>(m_accumulator / m_fixedTimeStep);
+    const uint32_t steps = std::min(due, m_maxStepsPerUpdate);
+    m_accumulator -= static_cast<float>(steps) * m_fixedTimeStep;
 
+    // a hitch drops the steps it could not afford rather than trying to catch up on them later
     if (m_accumulator >= m_fixedTimeStep) {
-        m_accumulator = 0.0f;
+        m_accumulator = std::fmod(m_accumulator, m_fixedTimeStep);
     }
+
+    return steps;
 }
 
-void PhysicsSystem::stepCharacters(float deltaTime)
+void PhysicsSystem::step()
 {
-    if (m_characterRecords.size() == 0) {
+    m_physicsSystem.Update(m_fixedTimeStep, 1, m_tempAllocator.get(), m_jobSystem.get());
+    stepCharacters(m_fixedTimeStep);
+}
+
+void PhysicsSystem::runSteps(uint32_t steps, physics::StepCapture &outCapture)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    outCapture.steps = steps;
+    outCapture.previous.clear();
+    outCapture.current.clear();
+    if (steps == 0) {
         return;
     }
 
-    const JPH::Vec3 gravity = m_physicsSystem.GetGravity();
-    const JPH::DefaultBroadPhaseLayerFilter broadPhaseFilter =
-        m_physicsSystem.GetDefaultBroadPhaseLayerFilter(physics::LAYER_MOVING);
-    const JPH::DefaultObjectLayerFilter objectFilter = m_physicsSystem.GetDefaultLayerFilter(physics::LAYER_MOVING);
-    const JPH::BodyFilter bodyFilter;
-    const JPH::ShapeFilter shapeFilter;
+    for (uint32_t i = 0; i + 1 < steps; ++i) {
+        step();
+    }
+    if (steps > 1) {
+        getSimulatedStates(outCapture.previous);
+    }
 
-    m_characterRecords.forEach([&](uint32_t id, physics::CharacterRecord &record) {
-        (void)id;
+    step();
+    getSimulatedStates(outCapture.current);
+}
 
-        const JPH::Vec3 up = physics::glmToJoltVec3(record.up);
-        record.character->SetLinearVelocity(s_characterStepVelocity(record, up, gravity, deltaTime));
+void PhysicsSystem::launchSteps(uint32_t steps, physics::StepCapture &outCapture)
+{
+    RP_ASSERT(!isStepping(), "steps launched while the last ones are still running");
 
-        JPH::CharacterVirtual::ExtendedUpdateSettings settings;
-        settings.mStickToFloorStepDown = -up * record.stepDown;
-        settings.mWalkStairsStepUp = up * record.stepUp;
+    m_stepsInFlight.increment();
+    auto run = [this, steps, &outCapture](JobContext &) { runSteps(steps, outCapture); };
+    // waiting on a barrier runs Jolt's jobs inline, character sweeps among them, so they need its stack too
+    jobs().run(JobDeclaration(run, JobPriority::HIGH, QueueAffinity::ANY, &m_stepsInFlight, "Physics steps", JobStack::LARGE));
+}
 
-        record.character->ExtendedUpdate(deltaTime, gravity, settings, broadPhaseFilter, objectFilter, bodyFilter, shapeFilter,
-                                         *m_tempAllocator);
-    });
+void PhysicsSystem::waitForSteps()
+{
+    if (isStepping()) {
+        jobs().waitFor(m_stepsInFlight, 0);
+    }
+}
+
+void PhysicsSystem::stepCharacters(float deltaTime)
+{
+    m_characterStepper->step(m_characterRecords, m_physicsSystem, *m_jobSystem, deltaTime);
+}
+
+const std::vector<physics::CharacterContact> &PhysicsSystem::getCharacterContacts() const
+{
+    return m_characterStepper->getContacts();
+}
+
+const physics::CharacterStepStats &PhysicsSystem::getLastCharacterStats() const
+{
+    return m_characterStepper->getLastStats();
+}
+
+JPH::ShapeRefC PhysicsSystem::createShape(const physics::CollisionShape &shape)
+{
+    const physics::CookedShapeSource *source = physics::CollisionShape_cookedSource(shape);
+    if (source == nullptr || source->cooked == nullptr) {
+        return physics::createJoltShape(shape);
+    }
+
+    auto it = m_cookedShapes.find(source->cooked.get());
+    if (it == m_cookedShapes.end() || it->second.cooked.lock() != source->cooked) {
+        JPH::ShapeRefC restored = physics::restoreCookedShape(*source->cooked);
+        if (restored == nullptr) {
+            return nullptr;
+        }
+
+        // entries outlive the meshes they were read from, so the stale ones are dropped as the map grows
+        if (m_cookedShapes.size() >= m_cookedShapesPruneAt) {
+            std::erase_if(m_cookedShapes, [](const auto &entry) { return entry.second.cooked.expired(); });
+            m_cookedShapesPruneAt = std::max<size_t>(64, m_cookedShapes.size() * 2);
+        }
+        it = m_cookedShapes.insert_or_assign(source->cooked.get(), CookedShapeEntry{source->cooked, restored}).first;
+    }
+
+    return physics::scaleCookedShape(it->second.shape, source->scale);
 }
 
 std::unique_ptr<physics::RigidBody> PhysicsSystem::createRigidBody(const physics::RigidBodyConfig &config, void *owner)
 {
-    JPH::ShapeRefC shape = physics::createJoltShape(config.shape);
+    JPH::ShapeRefC shape = createShape(config.shape);
     if (shape == nullptr) {
         RP_CORE_ERROR("Failed to create physics shape");
         return nullptr;
     }
 
-    const JPH::ObjectLayer layer =
-        (config.motionType == physics::MOTION_STATIC) ? physics::LAYER_NON_MOVING : physics::LAYER_MOVING;
+    // a triangle mesh or height field has no volume to give a moving body mass
+    physics::MotionType motionType = config.motionType;
+    const physics::CollisionShapeType shapeType = physics::CollisionShape_typeOf(config.shape);
+    if (motionType != physics::MOTION_STATIC &&
+        (shapeType == physics::COLLISION_SHAPE_MESH || shapeType == physics::COLLISION_SHAPE_HEIGHT_FIELD)) {
+        RP_CORE_WARN("A {} shape only makes static bodies, the body is made static",
+                     physics::CollisionShape_toString(shapeType));
+        motionType = physics::MOTION_STATIC;
+    }
+
+    const JPH::ObjectLayer layer = (motionType == physics::MOTION_STATIC) ? physics::LAYER_NON_MOVING : physics::LAYER_MOVING;
     JPH::BodyCreationSettings settings(shape, physics::glmToJoltPosition(config.position), physics::glmToJoltQuat(config.rotation),
-                                       physics::motionTypeToJolt(config.motionType), layer);
+                                       physics::motionTypeToJolt(motionType), layer);
     settings.mFriction = config.friction;
     settings.mRestitution = config.restitution;
     settings.mUserData = reinterpret_cast<uint64_t>(owner);
@@ -215,7 +262,14 @@ std::unique_ptr<physics::RigidBody> PhysicsSystem::createRigidBody(const physics
 
 std::unique_ptr<physics::CharacterBody> PhysicsSystem::createCharacterBody(const physics::CharacterBodyConfig &config, void *owner)
 {
-    JPH::ShapeRefC shape = physics::createJoltShape(config.shape);
+    const physics::CollisionShapeType shapeType = physics::CollisionShape_typeOf(config.shape);
+    if (shapeType == physics::COLLISION_SHAPE_MESH || shapeType == physics::COLLISION_SHAPE_HEIGHT_FIELD) {
+        RP_CORE_ERROR("A character cannot be a {} shape, it has no volume to sweep",
+                      physics::CollisionShape_toString(shapeType));
+        return nullptr;
+    }
+
+    JPH::ShapeRefC shape = createShape(config.shape);
     if (shape == nullptr) {
         RP_CORE_ERROR("Failed to create character shape");
         return nullptr;
@@ -255,17 +309,20 @@ void PhysicsSystem::getSimulatedStates(std::vector<physics::BodyState> &outState
     const uint32_t activeCount = m_physicsSystem.GetNumActiveBodies(JPH::EBodyType::RigidBody);
     outStates.reserve(activeCount + m_characterRecords.size());
 
+    // between steps nothing else touches the bodies, so each one is looked up once and read without
+    // taking its lock, where the BodyInterface getters lock and look it up again per field
+    const JPH::BodyLockInterfaceNoLock &bodies = m_physicsSystem.GetBodyLockInterfaceNoLock();
     const JPH::BodyID *activeBodies = m_physicsSystem.GetActiveBodiesUnsafe(JPH::EBodyType::RigidBody);
     for (uint32_t i = 0; i < activeCount; ++i) {
-        const JPH::BodyID bodyId = activeBodies[i];
-        JPH::RVec3 position;
-        JPH::Quat rotation;
-        m_bodyInterface->GetPositionAndRotation(bodyId, position, rotation);
+        const JPH::Body *body = bodies.TryGetBody(activeBodies[i]);
+        if (body == nullptr) {
+            continue;
+        }
 
         physics::BodyState state;
-        state.owner = reinterpret_cast<void *>(m_bodyInterface->GetUserData(bodyId));
-        state.position = physics::joltToGlmVec3(position);
-        state.rotation = physics::joltToGlmQuat(rotation);
+        state.owner = reinterpret_cast<void *>(body->GetUserData());
+        state.position = physics::joltToGlmVec3(body->GetPosition());
+        state.rotation = physics::joltToGlmQuat(body->GetRotation());
         outStates.push_back(state);
     }
 
@@ -316,4 +373,220 @@ physics::RaycastResult PhysicsSystem::raycast(const glm::vec3 &origin, const glm
     return hit;
 }
 
+// rays are cheap enough that a job needs many to outweigh scheduling it, shapes are not
+static constexpr uint32_t QUERY_RAY_CHUNK = 256;
+static constexpr uint32_t QUERY_SHAPE_CHUNK = 32;
+
+// Object and broad phase layers share their numbering, so a query's layer bits select both.
+static_assert(physics::LAYER_NON_MOVING == 0 && physics::LAYER_MOVING == 1, "query layer bits follow the object layers");
+
+namespace {
+
+class QueryBroadPhaseLayerFilter final : public JPH::BroadPhaseLayerFilter {
+  public:
+    explicit QueryBroadPhaseLayerFilter(uint32_t layers) : m_layers(layers) {}
+
+    bool ShouldCollide(JPH::BroadPhaseLayer layer) const override { return ((m_layers >> layer.GetValue()) & 1u) != 0; }
+
+  private:
+    uint32_t m_layers;
+};
+
+class QueryObjectLayerFilter final : public JPH::ObjectLayerFilter {
+  public:
+    explicit QueryObjectLayerFilter(uint32_t layers) : m_layers(layers) {}
+
+    bool ShouldCollide(JPH::ObjectLayer layer) const override { return ((m_layers >> layer) & 1u) != 0; }
+
+  private:
+    uint32_t m_layers;
+};
+
+/**
+ * @brief Writes the owner of each body an overlap touches once, into a slice that was sized up front
+ *
+ * Jolt reports a body before the hits against it, and all of a body's hits come together, so the
+ * owner is taken from the body and a repeat is told apart by comparing against the last body kept.
+ */
+class OverlapCollector final : public JPH::CollideShapeCollector {
+  public:
+    explicit OverlapCollector(std::span<void *> owners) : m_owners(owners) {}
+
+    void OnBody(const JPH::Body &body) override { m_bodyOwner = reinterpret_cast<void *>(body.GetUserData()); }
+
+    void AddHit(const JPH::CollideShapeResult &result) override
+    {
+        if (result.mBodyID2 == m_lastBody) {
+            return;
+        }
+        if (m_count == m_owners.size()) {
+            m_truncated = true;
+            ForceEarlyOut();
+            return;
+        }
+        m_lastBody = result.mBodyID2;
+        m_owners[m_count++] = m_bodyOwner;
+    }
+
+    uint32_t count() const { return m_count; }
+    bool truncated() const { return m_truncated; }
+
+  private:
+    std::span<void *> m_owners;
+    void *m_bodyOwner = nullptr;
+    JPH::BodyID m_lastBody;
+    uint32_t m_count = 0;
+    bool m_truncated = false;
+};
+
+} // namespace
+
+bool PhysicsSystem::queryBatch(const physics::SceneQueryBatch &batch, uint32_t parallelThreshold)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    if (batch.rayHits.size() < batch.rays.size() || batch.shapeCastHits.size() < batch.shapeCasts.size() ||
+        batch.overlapResults.size() < batch.overlaps.size()) {
+        RP_CORE_ERROR("Scene query batch has fewer results than queries");
+        return false;
+    }
+    const size_t overlapCapacity = batch.overlaps.empty() ? 0 : batch.overlapOwners.size() / batch.overlaps.size();
+
+    const bool alreadyQuerying = m_queryingBatch.exchange(true, std::memory_order_acquire);
+    RP_ASSERT(!alreadyQuerying, "queryBatch called while another batch is running, they share the query scratch");
+    (void)alreadyQuerying;
+
+    // a shape used by many queries is built once rather than per query
+    m_queryShapes.clear();
+    m_queryShapes.reserve(batch.shapes.size());
+    for (const physics::CollisionShape &shape : batch.shapes) {
+        m_queryShapes.push_back(createShape(shape));
+    }
+
+    m_queryChunks.clear();
+    auto appendChunks = [this](QueryKind kind, size_t count, uint32_t chunkSize) {
+        for (size_t begin = 0; begin < count; begin += chunkSize) {
+            const size_t end = std::min(begin + chunkSize, count);
+            m_queryChunks.push_back({kind, static_cast<uint32_t>(begin), static_cast<uint32_t>(end)});
+        }
+    };
+    appendChunks(QUERY_RAYS, batch.rays.size(), QUERY_RAY_CHUNK);
+    appendChunks(QUERY_SHAPE_CASTS, batch.shapeCasts.size(), QUERY_SHAPE_CHUNK);
+    appendChunks(QUERY_OVERLAPS, batch.overlaps.size(), QUERY_SHAPE_CHUNK);
+
+    m_lastQueryStats = {static_cast<uint32_t>(batch.rays.size()), static_cast<uint32_t>(batch.shapeCasts.size()),
+                        static_cast<uint32_t>(batch.overlaps.size()), 0};
+    const size_t queryCount = batch.rays.size() + batch.shapeCasts.size() + batch.overlaps.size();
+
+    if (!m_queriesOnJobs || queryCount < parallelThreshold || m_queryChunks.size() < 2) {
+        for (const QueryChunk &chunk : m_queryChunks) {
+            runQueryChunk(chunk, batch, overlapCapacity);
+        }
+        m_queryingBatch.store(false, std::memory_order_release);
+        return true;
+    }
+
+    Counter counter{};
+    counter.increment(static_cast<int32_t>(m_queryChunks.size()));
+    for (const QueryChunk &chunk : m_queryChunks) {
+        auto job = [this, &chunk, &batch, overlapCapacity](JobContext &) { runQueryChunk(chunk, batch, overlapCapacity); };
+        jobs().run(JobDeclaration(job, JobPriority::HIGH, QueueAffinity::ANY, &counter, "Scene queries"));
+    }
+    jobs().waitFor(counter, 0);
+    m_lastQueryStats.jobs = static_cast<uint32_t>(m_queryChunks.size());
+
+    m_queryingBatch.store(false, std::memory_order_release);
+    return true;
+}
+
+void PhysicsSystem::runQueryChunk(const QueryChunk &chunk, const physics::SceneQueryBatch &batch, size_t overlapCapacity) const
+{
+    const JPH::NarrowPhaseQuery &query = m_physicsSystem.GetNarrowPhaseQueryNoLock();
+    const JPH::BodyLockInterfaceNoLock &bodies = m_physicsSystem.GetBodyLockInterfaceNoLock();
+
+    switch (chunk.kind) {
+    case QUERY_RAYS: {
+        for (uint32_t i = chunk.begin; i < chunk.end; ++i) {
+            const physics::RayQuery &ray = batch.rays[i];
+            physics::RaycastResult &hit = batch.rayHits[i];
+            hit = {};
+
+            const JPH::RRayCast cast(physics::glmToJoltPosition(ray.origin),
+                                     physics::glmToJoltVec3(ray.direction) * ray.maxDistance);
+            JPH::RayCastResult result;
+            if (!query.CastRay(cast, result, QueryBroadPhaseLayerFilter(ray.layers), QueryObjectLayerFilter(ray.layers))) {
+                continue;
+            }
+
+            const JPH::RVec3 position = cast.GetPointOnRay(result.mFraction);
+            hit.hit = true;
+            hit.position = physics::joltToGlmVec3(position);
+            hit.distance = ray.maxDistance * result.mFraction;
+            if (const JPH::Body *body = bodies.TryGetBody(result.mBodyID)) {
+                hit.owner = reinterpret_cast<void *>(body->GetUserData());
+                hit.normal = physics::joltToGlmVec3(body->GetWorldSpaceSurfaceNormal(result.mSubShapeID2, position));
+            }
+        }
+        break;
+    }
+    case QUERY_SHAPE_CASTS: {
+        const JPH::ShapeCastSettings settings;
+        for (uint32_t i = chunk.begin; i < chunk.end; ++i) {
+            const physics::ShapeCastQuery &shapeCast = batch.shapeCasts[i];
+            physics::RaycastResult &hit = batch.shapeCastHits[i];
+            hit = {};
+
+            const JPH::Shape *shape = shapeCast.shape < m_queryShapes.size() ? m_queryShapes[shapeCast.shape].GetPtr() : nullptr;
+            if (shape == nullptr) {
+                continue;
+            }
+
+            const JPH::RMat44 start = JPH::RMat44::sRotationTranslation(physics::glmToJoltQuat(shapeCast.rotation),
+                                                                        physics::glmToJoltPosition(shapeCast.origin));
+            const JPH::RShapeCast cast = JPH::RShapeCast::sFromWorldTransform(
+                shape, JPH::Vec3::sReplicate(1.0f), start, physics::glmToJoltVec3(shapeCast.direction) * shapeCast.maxDistance);
+            JPH::ClosestHitCollisionCollector<JPH::CastShapeCollector> collector;
+            query.CastShape(cast, settings, JPH::RVec3::sZero(), collector, QueryBroadPhaseLayerFilter(shapeCast.layers),
+                            QueryObjectLayerFilter(shapeCast.layers));
+            if (!collector.HadHit()) {
+                continue;
+            }
+
+            const JPH::ShapeCastResult &result = collector.mHit;
+            hit.hit = true;
+            hit.position = physics::joltToGlmVec3(result.mContactPointOn2);
+            hit.normal = physics::joltToGlmVec3(-result.mPenetrationAxis.NormalizedOr(JPH::Vec3::sZero()));
+            hit.distance = shapeCast.maxDistance * result.mFraction;
+            if (const JPH::Body *body = bodies.TryGetBody(result.mBodyID2)) {
+                hit.owner = reinterpret_cast<void *>(body->GetUserData());
+            }
+        }
+        break;
+    }
+    case QUERY_OVERLAPS: {
+        const JPH::CollideShapeSettings settings;
+        for (uint32_t i = chunk.begin; i < chunk.end; ++i) {
+            const physics::OverlapQuery &overlap = batch.overlaps[i];
+            physics::OverlapResult &result = batch.overlapResults[i];
+            result = {};
+
+            const JPH::Shape *shape = overlap.shape < m_queryShapes.size() ? m_queryShapes[overlap.shape].GetPtr() : nullptr;
+            if (shape == nullptr || overlapCapacity == 0) {
+                continue;
+            }
+
+            const JPH::RMat44 transform = JPH::RMat44::sRotationTranslation(physics::glmToJoltQuat(overlap.rotation),
+                                                                            physics::glmToJoltPosition(overlap.position))
+                                              .PreTranslated(shape->GetCenterOfMass());
+            OverlapCollector collector(batch.overlapOwners.subspan(i * overlapCapacity, overlapCapacity));
+            query.CollideShape(shape, JPH::Vec3::sReplicate(1.0f), transform, settings, JPH::RVec3::sZero(), collector,
+                               QueryBroadPhaseLayerFilter(overlap.layers), QueryObjectLayerFilter(overlap.layers));
+            result.count = collector.count();
+            result.truncated = collector.truncated();
+        }
+        break;
+    }
+    }
+}
+
 } // namespace Rapture
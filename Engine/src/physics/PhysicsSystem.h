@@ -1,19 +1,23 @@
 #ifndef RAPTURE__PHYSICS_SYSTEM_H
 #define RAPTURE__PHYSICS_SYSTEM_H
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
+#include "core/jobs/Counter.h"
 #include "physics/Internal.h"
 
 namespace Rapture {
 
 namespace physics {
 class CharacterBody;
+class CharacterStepper;
 class RigidBody;
 } // namespace physics
 
@@ -29,11 +33,57 @@ class PhysicsSystem {
     PhysicsSystem &operator=(const PhysicsSystem &) = delete;
 
     /**
-     * @brief Advances the simulation
+     * @brief Advances the simulation, running every fixed step the elapsed time makes due
      * @param deltaTime Elapsed time in seconds
      */
     void onUpdate(float deltaTime);
 
+    /**
+     * @brief Moves the simulation clock on without stepping
+     *
+     * Time short of a whole step is carried to the next call, and is what getInterpolationAlpha()
+     * measures. Steps past maxStepsPerUpdate are dropped rather than owed, but the fraction of a step
+     * is kept so the alpha does not jump.
+     * @param deltaTime Elapsed time in seconds
+     * @return Fixed steps now due, to be run with runSteps() or launchSteps()
+     */
+    uint32_t advance(float deltaTime);
+
+    /**
+     * @brief Runs one fixed step of the bodies and then the character bodies
+     */
+    void step();
+
+    /**
+     * @brief Runs fixed steps on the calling thread and keeps what the last two of them left
+     * @param steps Steps to run
+     * @param outCapture Receives the states, replacing what it held
+     */
+    void runSteps(uint32_t steps, physics::StepCapture &outCapture);
+
+    /**
+     * @brief runSteps() as a job, returning at once
+     *
+     * Nothing may read or change the simulation, nor touch outCapture, until waitForSteps() returns.
+     * @param steps Steps to run
+     * @param outCapture Receives the states, must outlive the wait
+     */
+    void launchSteps(uint32_t steps, physics::StepCapture &outCapture);
+
+    /**
+     * @brief Waits for the steps launchSteps() started, returning at once if none are running
+     */
+    void waitForSteps();
+
+    bool isStepping() const { return m_stepsInFlight.get() != 0; }
+
+    /**
+     * @brief How far the clock is into the next step, 0 right on a step and approaching 1 just before one
+     */
+    float getInterpolationAlpha() const { return m_accumulator / m_fixedTimeStep; }
+
+    float getFixedTimeStep() const { return m_fixedTimeStep; }
+
     /**
      * @brief Adds a rigid body to the simulation
      * @param config What the body is built from
@@ -52,6 +102,9 @@ class PhysicsSystem {
 
     /**
      * @brief Collects the state of every body that may have moved
+     *
+     * Reads the bodies without locking them, so it is only called between steps, from the thread
+     * that steps.
      * @param outStates Receives one entry per awake rigid body and one per character body, replacing what it held
      */
     void getSimulatedStates(std::vector<physics::BodyState> &outStates) const;
@@ -68,13 +121,63 @@ class PhysicsSystem {
      */
     physics::RaycastResult raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance) const;
 
+    /**
+     * @brief Runs a batch of rays, shape casts and overlaps, split over jobs
+     *
+     * Reads the bodies without locking them, so like getSimulatedStates() it is only called between
+     * steps. Each job writes only the results of its own queries. The batch's shapes and chunks are kept
+     * in scratch this system reuses, so one batch runs at a time, asserted in debug builds.
+     * @param batch The queries and the arrays their results are written to
+     * @param parallelThreshold Batches of fewer queries run on the calling thread
+     * @return False if an output array is too small for its queries, in which case nothing is run
+     */
+    bool queryBatch(const physics::SceneQueryBatch &batch, uint32_t parallelThreshold = 512);
+
+    const physics::SceneQueryStats &getLastQueryStats() const { return m_lastQueryStats; }
+
+    /**
+     * @brief Character bodies touching one another after the last step, each pair once and in id order
+     *
+     * Only filled with characterVsCharacter set, without it characters pass through one another.
+     */
+    const std::vector<physics::CharacterContact> &getCharacterContacts() const;
+
+    const physics::CharacterStepStats &getLastCharacterStats() const;
+
     JPH::BodyInterface &bodyInterface() const { return *m_bodyInterface; }
     FreeList<physics::CharacterRecord> &characterRecords() { return m_characterRecords; }
     const FreeList<physics::CharacterRecord> &characterRecords() const { return m_characterRecords; }
 
+    /**
+     * @brief Cooked shapes read back and kept for the bodies built from them, for the benchmark
+     */
+    uint32_t getCookedShapeCacheSize() const { return static_cast<uint32_t>(m_cookedShapes.size()); }
+
   private:
+    enum QueryKind : uint8_t {
+        QUERY_RAYS,
+        QUERY_SHAPE_CASTS,
+        QUERY_OVERLAPS
+    };
+
+    struct QueryChunk {
+        QueryKind kind;
+        uint32_t begin; // range of the batch's queries of that kind
+        uint32_t end;
+    };
+
+    /**
+     * @brief Runs one chunk of a batch's queries, writing their results
+     */
+    void runQueryChunk(const QueryChunk &chunk, const physics::SceneQueryBatch &batch, size_t overlapCapacity) const;
+
     /**
-     * @brief Sweeps every character body through the world
+     * @brief Builds a body's shape, reading cooked data back once however many bodies share it
+     */
+    JPH::ShapeRefC createShape(const physics::CollisionShape &shape);
+
+    /**
+     * @brief Sweeps every character body through the world, split over jobs
      * @param deltaTime Length of the step in seconds
      */
     void stepCharacters(float deltaTime);
@@ -84,14 +187,29 @@ class PhysicsSystem {
     physics::ObjectVsBroadPhaseLayerFilterImpl m_objectVsBroadPhaseLayerFilter;
     physics::ObjectLayerPairFilterImpl m_objectLayerPairFilter;
     std::unique_ptr<JPH::TempAllocatorImpl> m_tempAllocator;
-    JPH::JobSystemThreadPool m_jobSystem;
+    std::unique_ptr<JPH::JobSystem> m_jobSystem;
     JPH::PhysicsSystem m_physicsSystem;
     JPH::BodyInterface *m_bodyInterface = nullptr;
     FreeList<physics::CharacterRecord> m_characterRecords;
+    std::unique_ptr<physics::CharacterStepper> m_characterStepper;
+
+    struct CookedShapeEntry {
+        std::weak_ptr<const physics::CookedShape> cooked; // the key is only looked up while this is alive
+        JPH::ShapeRefC shape;
+    };
+    std::unordered_map<const physics::CookedShape *, CookedShapeEntry> m_cookedShapes;
+    size_t m_cookedShapesPruneAt = 64;
+
+    bool m_queriesOnJobs;
+    std::vector<JPH::ShapeRefC> m_queryShapes; // the batch's shapes, built once per batch
+    std::vector<QueryChunk> m_queryChunks;
+    physics::SceneQueryStats m_lastQueryStats;
+    std::atomic<bool> m_queryingBatch{false}; // set while a batch owns the scratch above
 
     float m_fixedTimeStep;
     uint32_t m_maxStepsPerUpdate;
     float m_accumulator = 0.0f;
+    Counter m_stepsInFlight;
 };
 
 } // namespace Rapture
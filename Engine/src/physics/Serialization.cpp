@@ -7,6 +7,8 @@ static constexpr std::string_view KEY_SHAPE = "shape";
 static constexpr std::string_view KEY_HALF_EXTENTS = "halfExtents";
 static constexpr std::string_view KEY_RADIUS = "radius";
 static constexpr std::string_view KEY_HALF_HEIGHT = "halfHeight";
+static constexpr std::string_view KEY_MESH = "mesh";
+static constexpr std::string_view KEY_SCALE = "scale";
 
 void CollisionShape_serialize(WriteNode node, const CollisionShape &shape)
 {
@@ -28,6 +30,16 @@ void CollisionShape_serialize(WriteNode node, const CollisionShape &shape)
     if (const auto *capsule = std::get_if<CapsuleShape>(&shape)) {
         node.set(KEY_RADIUS, capsule->radius);
         node.set(KEY_HALF_HEIGHT, capsule->halfHeight);
+        return;
+    }
+
+    // the cooked bytes belong to the mesh asset, only the handle naming it is written
+    if (const CookedShapeSource *source = CollisionShape_cookedSource(shape)) {
+        node.set(KEY_MESH, source->mesh);
+        WriteNode scale = node.addArray(KEY_SCALE);
+        scale.append(source->scale.x);
+        scale.append(source->scale.y);
+        scale.append(source->scale.z);
     }
 }
 
@@ -45,6 +57,19 @@ CollisionShape CollisionShape_deserialize(ReadNode node, const CollisionShape &f
                             static_cast<float>(node.child(KEY_RADIUS).asF64(0.5))};
     }
 
+    if (type == COLLISION_SHAPE_MESH || type == COLLISION_SHAPE_CONVEX_HULL || type == COLLISION_SHAPE_HEIGHT_FIELD) {
+        CollisionShape shape = CollisionShape_ofType(type);
+        CookedShapeSource *source = CollisionShape_cookedSource(shape);
+        source->mesh = node.child(KEY_MESH).asU64(0);
+
+        ReadNode scale = node.child(KEY_SCALE);
+        if (scale.size() == 3) {
+            source->scale = glm::vec3(static_cast<float>(scale.at(0).asF64(1.0)), static_cast<float>(scale.at(1).asF64(1.0)),
+                                      static_cast<float>(scale.at(2).asF64(1.0)));
+        }
+        return shape;
+    }
+
     ReadNode extents = node.child(KEY_HALF_EXTENTS);
     if (extents.size() != 3) {
         return BoxShape{};
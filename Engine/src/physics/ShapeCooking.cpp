@@ -0,0 +1,177 @@
+#include "physics/ShapeCooking.h"
+
+#include "physics/Internal.h"
+
+#include <Jolt/Core/StreamIn.h>
+#include <Jolt/Core/StreamOut.h>
+#include <Jolt/Core/StreamUtils.h>
+#include <Jolt/Physics/Collision/Shape/ConvexHullShape.h>
+#include <Jolt/Physics/Collision/Shape/HeightFieldShape.h>
+#include <Jolt/Physics/Collision/Shape/MeshShape.h>
+#include <Jolt/Physics/Collision/Shape/ScaledShape.h>
+
+#include <algorithm>
+#include <cstring>
+
+JPH_SUPPRESS_WARNINGS
+
+namespace Rapture {
+namespace physics {
+
+namespace {
+
+/**
+ * @brief Appends what Jolt writes to a byte vector
+ */
+class ByteStreamOut final : public JPH::StreamOut {
+  public:
+    explicit ByteStreamOut(std::vector<uint8_t> &bytes) : m_bytes(bytes) {}
+
+    void WriteBytes(const void *inData, size_t inNumBytes) override
+    {
+        const uint8_t *data = static_cast<const uint8_t *>(inData);
+        m_bytes.insert(m_bytes.end(), data, data + inNumBytes);
+    }
+
+    bool IsFailed() const override { return false; }
+
+  private:
+    std::vector<uint8_t> &m_bytes;
+};
+
+/**
+ * @brief Reads Jolt's bytes straight out of the cooked data rather than through a copy of it
+ */
+class ByteStreamIn final : public JPH::StreamIn {
+  public:
+    explicit ByteStreamIn(const std::vector<uint8_t> &bytes) : m_bytes(bytes) {}
+
+    void ReadBytes(void *outData, size_t inNumBytes) override
+    {
+        if (m_failed || inNumBytes > m_bytes.size() - m_cursor) {
+            m_failed = true;
+            std::memset(outData, 0, inNumBytes);
+            return;
+        }
+        std::memcpy(outData, m_bytes.data() + m_cursor, inNumBytes);
+        m_cursor += inNumBytes;
+    }
+
+    bool IsEOF() const override { return m_cursor >= m_bytes.size(); }
+    bool IsFailed() const override { return m_failed; }
+
+  private:
+    const std::vector<uint8_t> &m_bytes;
+    size_t m_cursor = 0;
+    bool m_failed = false;
+};
+
+} // namespace
+
+static std::shared_ptr<const CookedShape> s_cook(const JPH::ShapeSettings &settings, const char *kind)
+{
+    JPH::ShapeSettings::ShapeResult result = settings.Create();
+    if (result.HasError()) {
+        RP_CORE_ERROR("Failed to cook {} shape: {}", kind, result.GetError().c_str());
+        return nullptr;
+    }
+
+    auto cooked = std::make_shared<CookedShape>();
+    ByteStreamOut stream(cooked->bytes);
+    JPH::Shape::ShapeToIDMap shapeMap;
+    JPH::Shape::MaterialToIDMap materialMap;
+    result.Get()->SaveWithChildren(stream, shapeMap, materialMap);
+    return cooked;
+}
+
+std::shared_ptr<const CookedShape> cookMeshShape(std::span<const glm::vec3> positions, std::span<const uint32_t> indices)
+{
+    if (positions.empty() || indices.size() < 3) {
+        RP_CORE_ERROR("Cannot cook a mesh shape from {} vertices and {} indices", positions.size(), indices.size());
+        return nullptr;
+    }
+
+    ensureJoltGlobals();
+
+    JPH::VertexList vertices;
+    vertices.reserve(positions.size());
+    for (const glm::vec3 &position : positions) {
+        vertices.push_back(JPH::Float3(position.x, position.y, position.z));
+    }
+
+    JPH::IndexedTriangleList triangles;
+    triangles.reserve(indices.size() / 3);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        if (indices[i] >= positions.size() || indices[i + 1] >= positions.size() || indices[i + 2] >= positions.size()) {
+            RP_CORE_ERROR("Cannot cook a mesh shape, triangle {} indexes past its {} vertices", i / 3, positions.size());
+            return nullptr;
+        }
+        triangles.push_back(JPH::IndexedTriangle(indices[i], indices[i + 1], indices[i + 2]));
+    }
+
+    return s_cook(JPH::MeshShapeSettings(std::move(vertices), std::move(triangles)), "mesh");
+}
+
+std::shared_ptr<const CookedShape> cookConvexHullShape(std::span<const glm::vec3> positions)
+{
+    if (positions.size() < 4) {
+        RP_CORE_ERROR("Cannot cook a convex hull from {} vertices", positions.size());
+        return nullptr;
+    }
+
+    ensureJoltGlobals();
+
+    JPH::Array<JPH::Vec3> points;
+    points.reserve(positions.size());
+    for (const glm::vec3 &position : positions) {
+        points.push_back(glmToJoltVec3(position));
+    }
+
+    return s_cook(JPH::ConvexHullShapeSettings(points), "convex hull");
+}
+
+std::shared_ptr<const CookedShape> cookHeightFieldShape(std::span<const float> heights, uint32_t sampleCount,
+                                                        const glm::vec3 &offset, const glm::vec3 &sampleScale)
+{
+    if (sampleCount < 2 || heights.size() != static_cast<size_t>(sampleCount) * sampleCount) {
+        RP_CORE_ERROR("Cannot cook a height field from {} heights on a side of {}", heights.size(), sampleCount);
+        return nullptr;
+    }
+
+    ensureJoltGlobals();
+
+    // stored in blocks of two samples, with at least two blocks along a side
+    const uint32_t paddedCount = std::max(4u, (sampleCount + 1) & ~1u);
+    std::vector<float> samples(static_cast<size_t>(paddedCount) * paddedCount, JPH::HeightFieldShapeConstants::cNoCollisionValue);
+    for (uint32_t z = 0; z < sampleCount; ++z) {
+        std::copy_n(heights.begin() + static_cast<size_t>(z) * sampleCount, sampleCount,
+                    samples.begin() + static_cast<size_t>(z) * paddedCount);
+    }
+
+    return s_cook(JPH::HeightFieldShapeSettings(samples.data(), glmToJoltVec3(offset), glmToJoltVec3(sampleScale), paddedCount),
+                  "height field");
+}
+
+JPH::ShapeRefC restoreCookedShape(const CookedShape &cooked)
+{
+    ByteStreamIn stream(cooked.bytes);
+    JPH::Shape::IDToShapeMap shapeMap;
+    JPH::Shape::IDToMaterialMap materialMap;
+    JPH::Shape::ShapeResult result = JPH::Shape::sRestoreWithChildren(stream, shapeMap, materialMap);
+    if (result.HasError()) {
+        RP_CORE_ERROR("Failed to read back a cooked shape: {}", result.GetError().c_str());
+        return nullptr;
+    }
+    return result.Get();
+}
+
+JPH::ShapeRefC scaleCookedShape(const JPH::ShapeRefC &shape, const glm::vec3 &scale)
+{
+    if (shape == nullptr || scale == glm::vec3(1.0f)) {
+        return shape;
+    }
+    return new JPH::ScaledShape(shape, glmToJoltVec3(glm::max(scale, glm::vec3(MIN_SHAPE_EXTENT))));
+}
+
+} // namespace physics
+} // namespace Rapture
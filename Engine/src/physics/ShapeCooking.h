@@ -0,0 +1,50 @@
+#ifndef RAPTURE__PHYSICS_SHAPE_COOKING_H
+#define RAPTURE__PHYSICS_SHAPE_COOKING_H
+
+#include "physics/Common.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#include <glm/glm.hpp>
+
+namespace Rapture {
+namespace physics {
+
+/**
+ * @brief Cooks every triangle of a mesh into a shape that only makes static bodies
+ *
+ * Building the shape's tree of triangles is what makes a mesh shape slow to create, so it is done
+ * once, when the mesh is imported, and the cooked bytes are what a body is built from afterwards.
+ * @param positions Vertex positions in mesh space
+ * @param indices Three per triangle, indexing positions
+ * @return The cooked shape, nullptr if the geometry makes no shape
+ */
+std::shared_ptr<const CookedShape> cookMeshShape(std::span<const glm::vec3> positions, std::span<const uint32_t> indices);
+
+/**
+ * @brief Cooks the convex hull around every vertex of a mesh
+ * @param positions Vertex positions in mesh space
+ * @return The cooked shape, nullptr if the points enclose no volume
+ */
+std::shared_ptr<const CookedShape> cookConvexHullShape(std::span<const glm::vec3> positions);
+
+/**
+ * @brief Cooks a square grid of heights
+ *
+ * A grid whose side is odd is padded with samples that collide with nothing, as the shape is
+ * stored in blocks of two samples.
+ * @param heights sampleCount * sampleCount heights, row by row along z
+ * @param sampleCount Samples along each side, at least 2
+ * @param offset Position of the first sample
+ * @param sampleScale Distance between samples along x and z, and the factor heights are scaled by along y
+ * @return The cooked shape, nullptr if the grid makes no shape
+ */
+std::shared_ptr<const CookedShape> cookHeightFieldShape(std::span<const float> heights, uint32_t sampleCount,
+                                                        const glm::vec3 &offset, const glm::vec3 &sampleScale);
+
+} // namespace physics
+} // namespace Rapture
+
+#endif // RAPTURE__PHYSICS_SHAPE_COOKING_H
@@ -0,0 +1,248 @@
+#include "DrawCulling.h"
+
+#include "core/utils/TracyProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Built with -ffp-contract=off, see Engine/CMakeLists.txt. A fused multiply-add rounds once where the
+// shader rounds twice, and one such difference is enough for a grazing box to land on the other side.
+
+namespace Rapture {
+
+uint32_t DepthPyramid::levelCount(uint32_t depthWidth, uint32_t depthHeight)
+{
+    uint32_t width = std::max(1u, depthWidth / 2);
+    uint32_t height = std::max(1u, depthHeight / 2);
+
+    uint32_t levels = 1;
+    while (width > 1 || height > 1) {
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+        levels++;
+    }
+    return levels;
+}
+
+void DepthPyramid::build(const float *depth, uint32_t width, uint32_t height)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    m_depthWidth = width;
+    m_depthHeight = height;
+
+    const uint32_t levels = levelCount(width, height);
+    m_levels.resize(levels);
+    m_widths.resize(levels);
+    m_heights.resize(levels);
+
+    const float *source = depth;
+    uint32_t sourceWidth = width;
+    uint32_t sourceHeight = height;
+
+    for (uint32_t level = 0; level < levels; ++level) {
+        const uint32_t outWidth = std::max(1u, sourceWidth / 2);
+        const uint32_t outHeight = std::max(1u, sourceHeight / 2);
+        m_widths[level] = outWidth;
+        m_heights[level] = outHeight;
+        m_levels[level].resize(static_cast<size_t>(outWidth) * outHeight);
+
+        // DownsampleMip.cs.glsl: the footprint grows to 3 along an odd axis, for every texel
+        const uint32_t extraX = sourceWidth & 1u;
+        const uint32_t extraY = sourceHeight & 1u;
+
+        for (uint32_t y = 0; y < outHeight; ++y) {
+            for (uint32_t x = 0; x < outWidth; ++x) {
+                float farthest = -INFINITY;
+                for (uint32_t dy = 0; dy <= extraY + 1; ++dy) {
+                    const uint32_t sy = std::min(y * 2 + dy, sourceHeight - 1);
+                    for (uint32_t dx = 0; dx <= extraX + 1; ++dx) {
+                        const uint32_t sx = std::min(x * 2 + dx, sourceWidth - 1);
+                        farthest = std::max(farthest, source[static_cast<size_t>(sy) * sourceWidth + sx]);
+                    }
+                }
+                m_levels[level][static_cast<size_t>(y) * outWidth + x] = farthest;
+            }
+        }
+
+        source = m_levels[level].data();
+        sourceWidth = outWidth;
+        sourceHeight = outHeight;
+    }
+}
+
+} // namespace Rapture
+
+namespace Rapture::culling {
+
+/**
+ * @brief The pixel an NDC coordinate c / w falls in, without trusting a division
+ *
+ * The largest t in [0, size) with t * 2w <= (c + w) * size, which is floor((c / w * 0.5 + 0.5) * size)
+ * decided by multiplies and compares alone. The quotient is only where the search starts.
+ */
+static uint32_t s_pixelOf(float c, float w, uint32_t size)
+{
+    const float scaled = (c + w) * static_cast<float>(size);
+    const float twoW = w + w;
+
+    const float guess = scaled / twoW;
+    uint32_t t = guess > 0.0f ? static_cast<uint32_t>(std::min(guess, static_cast<float>(size - 1))) : 0u;
+
+    while (t > 0 && static_cast<float>(t) * twoW > scaled) {
+        t--;
+    }
+    while (t + 1 < size && static_cast<float>(t + 1) * twoW <= scaled) {
+        t++;
+    }
+    return t;
+}
+
+/**
+ * @brief Whether a world box lies behind everything the pyramid holds where it projects
+ * @param center World space center of the box
+ * @param extent World space half size of the box
+ */
+static bool s_occluded(const DrawCullParams &params, const float center[3], const float extent[3])
+{
+    const DepthPyramid &pyramid = *params.pyramid;
+    const glm::mat4 &viewProj = params.occlusionViewProj;
+
+    float clipZ[8];
+    float clipW[8];
+    uint32_t minX = UINT32_MAX;
+    uint32_t minY = UINT32_MAX;
+    uint32_t maxX = 0;
+    uint32_t maxY = 0;
+
+    for (uint32_t corner = 0; corner < 8; ++corner) {
+        const float px = (corner & 1u) != 0 ? center[0] + extent[0] : center[0] - extent[0];
+        const float py = (corner & 2u) != 0 ? center[1] + extent[1] : center[1] - extent[1];
+        const float pz = (corner & 4u) != 0 ? center[2] + extent[2] : center[2] - extent[2];
+
+        float clip[4];
+        for (int row = 0; row < 4; ++row) {
+            clip[row] = ((viewProj[0][row] * px + viewProj[1][row] * py) + viewProj[2][row] * pz) + viewProj[3][row];
+        }
+
+        // a corner level with or behind the eye has no place on screen, the box may cover all of it
+        if (!(clip[3] > 0.0f)) {
+            return false;
+        }
+
+        const uint32_t x = s_pixelOf(clip[0], clip[3], pyramid.getDepthWidth());
+        const uint32_t y = s_pixelOf(clip[1], clip[3], pyramid.getDepthHeight());
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+
+        clipZ[corner] = clip[2];
+        clipW[corner] = clip[3];
+    }
+
+    // from the depth buffer's pixels down to the first level where the box covers at most 2x2 texels,
+    // an odd level's last texel also covers the one past it so the index is clamped rather than lost
+    uint32_t level = 0;
+    minX = std::min(minX >> 1, pyramid.getWidth(0) - 1);
+    maxX = std::min(maxX >> 1, pyramid.getWidth(0) - 1);
+    minY = std::min(minY >> 1, pyramid.getHeight(0) - 1);
+    maxY = std::min(maxY >> 1, pyramid.getHeight(0) - 1);
+
+    while ((maxX - minX > 1 || maxY - minY > 1) && level + 1 < pyramid.getLevelCount()) {
+        level++;
+        minX = std::min(minX >> 1, pyramid.getWidth(level) - 1);
+        maxX = std::min(maxX >> 1, pyramid.getWidth(level) - 1);
+        minY = std::min(minY >> 1, pyramid.getHeight(level) - 1);
+        maxY = std::min(maxY >> 1, pyramid.getHeight(level) - 1);
+    }
+
+    float farthest = -INFINITY;
+    for (uint32_t y = minY; y <= maxY; ++y) {
+        for (uint32_t x = minX; x <= maxX; ++x) {
+            farthest = std::max(farthest, pyramid.fetch(level, x, y));
+        }
+    }
+
+    // z / w > farthest for every corner, with w known to be positive
+    for (uint32_t corner = 0; corner < 8; ++corner) {
+        if (!(clipZ[corner] > farthest * clipW[corner])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+DrawCullResult testDraw(const DrawCullParams &params, const glm::mat4 &model, const DrawBounds &bounds,
+                        const VkDrawIndexedIndirectCommand &command)
+{
+    if (command.instanceCount == 0) {
+        return DrawCullResult::HIDDEN;
+    }
+
+    const float localCenter[3] = {(bounds.min.x + bounds.max.x) * 0.5f, (bounds.min.y + bounds.max.y) * 0.5f,
+                                  (bounds.min.z + bounds.max.z) * 0.5f};
+    const float localExtent[3] = {(bounds.max.x - bounds.min.x) * 0.5f, (bounds.max.y - bounds.min.y) * 0.5f,
+                                  (bounds.max.z - bounds.min.z) * 0.5f};
+
+    // the box around the transformed box, as a center and a half size
+    float center[3];
+    float extent[3];
+    for (int row = 0; row < 3; ++row) {
+        center[row] = ((model[0][row] * localCenter[0] + model[1][row] * localCenter[1]) + model[2][row] * localCenter[2]) +
+                      model[3][row];
+        extent[row] = (std::fabs(model[0][row]) * localExtent[0] + std::fabs(model[1][row]) * localExtent[1]) +
+                      std::fabs(model[2][row]) * localExtent[2];
+    }
+
+    for (const glm::vec4 &plane : params.planes) {
+        const float distance = ((plane.x * center[0] + plane.y * center[1]) + plane.z * center[2]) + plane.w;
+        const float radius = (std::fabs(plane.x) * extent[0] + std::fabs(plane.y) * extent[1]) + std::fabs(plane.z) * extent[2];
+        if (distance + radius < 0.0f) {
+            return DrawCullResult::FRUSTUM;
+        }
+    }
+
+    if (params.pyramid != nullptr && params.pyramid->getLevelCount() != 0 && s_occluded(params, center, extent)) {
+        return DrawCullResult::OCCLUDED;
+    }
+    return DrawCullResult::VISIBLE;
+}
+
+uint32_t cullDraws(const DrawCullInput &input, const DrawCullParams &params, std::vector<VkDrawIndexedIndirectCommand> &out,
+                   DrawCullStats *stats)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    out.clear();
+    DrawCullStats tally;
+
+    const size_t count = input.commands.size();
+    for (size_t draw = 0; draw < count; ++draw) {
+        const VkDrawIndexedIndirectCommand &command = input.commands[draw];
+        const glm::mat4 &model = input.models[input.meshIndices[draw]];
+
+        switch (testDraw(params, model, input.bounds[draw], command)) {
+        case DrawCullResult::VISIBLE:
+            out.push_back(command);
+            tally.visible++;
+            break;
+        case DrawCullResult::HIDDEN:
+            tally.hidden++;
+            break;
+        case DrawCullResult::FRUSTUM:
+            tally.frustumCulled++;
+            break;
+        case DrawCullResult::OCCLUDED:
+            tally.occluded++;
+            break;
+        }
+    }
+
+    if (stats != nullptr) {
+        *stats = tally;
+    }
+    return static_cast<uint32_t>(out.size());
+}
+
+} // namespace Rapture::culling
@@ -0,0 +1,134 @@
+#ifndef RAPTURE__DRAW_CULLING_H
+#define RAPTURE__DRAW_CULLING_H
+
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace Rapture {
+
+/**
+ * @brief A draw's mesh bounds in the mesh's own space, kept per draw beside its ObjectInfo
+ *
+ * Two vec4 so the array has the same stride on both sides of the std430 buffer the cull shader reads.
+ */
+struct DrawBounds {
+    glm::vec4 min; // w unused
+    glm::vec4 max;
+};
+
+/**
+ * @brief Farthest depth over ever larger squares of a depth buffer, down to a single texel
+ *
+ * The CPU twin of the pyramid DepthPyramidPass builds from last frame's depth. Level 0 is half the
+ * depth buffer and every level after it half the one before, rounded down. A texel holds the largest
+ * depth of the 2x2 texels under it, or of 3 along an odd axis so the last row or column is not lost.
+ */
+class DepthPyramid {
+  public:
+    /**
+     * @brief Reduces a depth buffer into every level of the pyramid
+     * @param depth Row major depth values, as the depth attachment stores them
+     */
+    void build(const float *depth, uint32_t width, uint32_t height);
+
+    uint32_t getLevelCount() const { return static_cast<uint32_t>(m_levels.size()); }
+    uint32_t getWidth(uint32_t level) const { return m_widths[level]; }
+    uint32_t getHeight(uint32_t level) const { return m_heights[level]; }
+    uint32_t getDepthWidth() const { return m_depthWidth; }
+    uint32_t getDepthHeight() const { return m_depthHeight; }
+
+    float fetch(uint32_t level, uint32_t x, uint32_t y) const { return m_levels[level][y * m_widths[level] + x]; }
+
+    /**
+     * @brief How many levels the pyramid of a depth buffer this size has
+     */
+    static uint32_t levelCount(uint32_t depthWidth, uint32_t depthHeight);
+
+  private:
+    std::vector<std::vector<float>> m_levels;
+    std::vector<uint32_t> m_widths;
+    std::vector<uint32_t> m_heights;
+    uint32_t m_depthWidth = 0;
+    uint32_t m_depthHeight = 0;
+};
+
+/**
+ * @brief Why the cull kept or dropped a draw
+ */
+enum class DrawCullResult : uint8_t {
+    VISIBLE,
+    HIDDEN,   // the draw's instance count was already zero
+    FRUSTUM,  // its world box is outside a plane of the frustum
+    OCCLUDED, // its nearest point lies behind everything the pyramid holds where it would land
+};
+
+/**
+ * @brief The view a set of draws is culled for
+ */
+struct DrawCullParams {
+    std::array<glm::vec4, 6> planes{}; // normalized and facing inwards, as Frustum::getPlanes() holds them
+
+    // the view-projection the pyramid's depth was rendered with, last frame's for the camera
+    glm::mat4 occlusionViewProj{1.0f};
+
+    const DepthPyramid *pyramid = nullptr; // nullptr skips the occlusion test
+};
+
+/**
+ * @brief The draws of one batch, laid out as the cull shader reads them
+ */
+struct DrawCullInput {
+    std::span<const VkDrawIndexedIndirectCommand> commands;
+    std::span<const uint32_t> meshIndices; // per draw, the ObjectInfo::meshIndex the draw reads its slot from
+    std::span<const DrawBounds> bounds;    // per draw
+    std::span<const glm::mat4> models;     // per mesh slot, the MeshGPUData model matrix
+};
+
+struct DrawCullStats {
+    uint32_t visible = 0;
+    uint32_t hidden = 0;
+    uint32_t frustumCulled = 0;
+    uint32_t occluded = 0;
+};
+
+} // namespace Rapture
+
+namespace Rapture::culling {
+
+// Threads per group of the cull shader, which is also the granularity its compaction scans at
+constexpr uint32_t DRAW_CULL_GROUP_SIZE = 256;
+
+/**
+ * @brief Culls one draw exactly as DrawCull.cs.glsl does
+ *
+ * Every step is an add, subtract, multiply or compare in a fixed order, which IEEE rounds the same on
+ * both sides, so a draw comes out the same here as on the GPU. The one division only seeds a search
+ * that the multiplies then settle, and the file is built without contracting a multiply and an add
+ * into one fused instruction, which the shader forbids with precise.
+ * @param model The model matrix of the draw's mesh slot
+ * @param bounds The draw's mesh bounds
+ * @param command The draw's source command
+ */
+DrawCullResult testDraw(const DrawCullParams &params, const glm::mat4 &model, const DrawBounds &bounds,
+                        const VkDrawIndexedIndirectCommand &command);
+
+/**
+ * @brief Culls a batch and compacts the commands it keeps, the reference for the GPU cull and compaction
+ *
+ * The kept commands come out unchanged and in the order they went in, which is what the shader's
+ * scan over its groups produces, so the output and its count can be compared with the GPU's word
+ * for word.
+ * @param out Filled with the kept commands
+ * @param stats Optional tally of why draws were dropped
+ * @return The number of commands kept, the draw count the GPU would write
+ */
+uint32_t cullDraws(const DrawCullInput &input, const DrawCullParams &params, std::vector<VkDrawIndexedIndirectCommand> &out,
+                   DrawCullStats *stats = nullptr);
+
+} // namespace Rapture::culling
+
+#endif // RAPTURE__DRAW_CULLING_H
@@ -0,0 +1,282 @@
+#include "FrustumCulling.h"
+
+#include "core/jobs/Counter.h"
+#include "core/jobs/JobSystem.h"
+#include "core/utils/Log.h"
+#include "core/utils/TracyProfiler.h"
+
+#include <algorithm>
+
+// x86-64 always has SSE2. The AVX2 kernel is built alongside it whatever the compile flags, and picked
+// at runtime on CPUs that have AVX2 and FMA.
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define RAPTURE_CULL_SSE 1
+#define RAPTURE_CULL_AVX2 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define RAPTURE_CULL_AVX2_TARGET
+#else
+#define RAPTURE_CULL_AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+namespace Rapture::culling {
+
+/**
+ * @brief One plane with the corner it is tested against already chosen
+ *
+ * For a positive normal component the box's maximum along that axis lies furthest along the plane,
+ * for a negative one its minimum, so each plane reads one fixed array per axis.
+ */
+struct PlaneCorner {
+    float nx, ny, nz, d;
+    const float *x;
+    const float *y;
+    const float *z;
+};
+
+// Mask words per tile when culling several views, 1024 rows of six floats fill 24KB of the L1 cache
+static constexpr uint32_t CULL_TILE_WORDS = 16;
+
+static void s_pickCorners(const std::array<glm::vec4, 6> &planes, const BoundsView &bounds, PlaneCorner (&corners)[6])
+{
+    for (int p = 0; p < 6; ++p) {
+        const glm::vec4 &plane = planes[p];
+        corners[p] = {plane.x,
+                      plane.y,
+                      plane.z,
+                      plane.w,
+                      plane.x >= 0.0f ? bounds.maxX : bounds.minX,
+                      plane.y >= 0.0f ? bounds.maxY : bounds.minY,
+                      plane.z >= 0.0f ? bounds.maxZ : bounds.minZ};
+    }
+}
+
+// Culls the 64 rows starting at firstRow into one mask word
+using CullWordFn = uint64_t (*)(const PlaneCorner (&corners)[6], uint32_t firstRow);
+
+#if RAPTURE_CULL_AVX2
+
+RAPTURE_CULL_AVX2_TARGET static uint64_t s_cullWordAvx2(const PlaneCorner (&corners)[6], uint32_t firstRow)
+{
+    uint64_t word = 0;
+    for (uint32_t block = 0; block < 64; block += 8) {
+        const uint32_t row = firstRow + block;
+        __m256 outside = _mm256_setzero_ps();
+        for (const PlaneCorner &plane : corners) {
+            __m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.nx), _mm256_loadu_ps(plane.x + row), _mm256_set1_ps(plane.d));
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.ny), _mm256_loadu_ps(plane.y + row), distance);
+            distance = _mm256_fmadd_ps(_mm256_set1_ps(plane.nz), _mm256_loadu_ps(plane.z + row), distance);
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+        const uint32_t visible = ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xFFu;
+        word |= static_cast<uint64_t>(visible) << block;
+    }
+    return word;
+}
+
+/**
+ * @brief Whether the CPU, and the OS saving its registers, can run the AVX2 kernel
+ */
+static bool s_cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    __cpuid(info, 1);
+    const bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0;
+    return osSavesYmm && fma && avx2;
+#else
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+#endif
+
+#if RAPTURE_CULL_SSE
+
+static uint64_t s_cullWordSse(const PlaneCorner (&corners)[6], uint32_t firstRow)
+{
+    uint64_t word = 0;
+    for (uint32_t block = 0; block < 64; block += 4) {
+        const uint32_t row = firstRow + block;
+        __m128 outside = _mm_setzero_ps();
+        for (const PlaneCorner &plane : corners) {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.nx), _mm_loadu_ps(plane.x + row)), _mm_set1_ps(plane.d));
+            distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.ny), _mm_loadu_ps(plane.y + row)), distance);
+            distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.nz), _mm_loadu_ps(plane.z + row)), distance);
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+        }
+        const uint32_t visible = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xFu;
+        word |= static_cast<uint64_t>(visible) << block;
+    }
+    return word;
+}
+
+#else
+
+static uint64_t s_cullWordScalar(const PlaneCorner (&corners)[6], uint32_t firstRow)
+{
+    uint64_t word = 0;
+    for (uint32_t bit = 0; bit < 64; ++bit) {
+        const uint32_t row = firstRow + bit;
+        bool outside = false;
+        for (const PlaneCorner &plane : corners) {
+            outside |= plane.nx * plane.x[row] + plane.ny * plane.y[row] + plane.nz * plane.z[row] + plane.d < 0.0f;
+        }
+        word |= static_cast<uint64_t>(!outside) << bit;
+    }
+    return word;
+}
+
+#endif
+
+/**
+ * @brief The widest kernel this CPU runs, chosen on first use
+ */
+static CullWordFn s_cullWordKernel()
+{
+    static const CullWordFn kernel = [] {
+#if RAPTURE_CULL_AVX2
+        if (s_cpuHasAvx2()) {
+            return &s_cullWordAvx2;
+        }
+#endif
+#if RAPTURE_CULL_SSE
+        return &s_cullWordSse;
+#else
+        return &s_cullWordScalar;
+#endif
+    }();
+    return kernel;
+}
+
+void cullRange(const std::array<glm::vec4, 6> &planes, const BoundsView &bounds, uint32_t beginWord, uint32_t endWord,
+               uint64_t *words)
+{
+    PlaneCorner corners[6];
+    s_pickCorners(planes, bounds, corners);
+
+    const CullWordFn cullWord = s_cullWordKernel();
+    for (uint32_t word = beginWord; word < endWord; ++word) {
+        words[word] = cullWord(corners, word * 64);
+    }
+}
+
+void cull(const std::array<glm::vec4, 6> &planes, const BoundsView &bounds, VisibilityMask &out, uint32_t parallelThreshold)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    out.reset(bounds.count);
+    const uint32_t wordCount = out.getWordCount();
+
+    if (bounds.count < parallelThreshold || bounds.count <= CULL_CHUNK_ROWS) {
+        cullRange(planes, bounds, 0, wordCount, out.data());
+        return;
+    }
+
+    // chunks cover whole words, so no two jobs write the same one
+    const uint32_t chunkWords = CULL_CHUNK_ROWS / 64;
+    const uint32_t chunkCount = (wordCount + chunkWords - 1) / chunkWords;
+    uint64_t *words = out.data();
+
+    Counter counter{};
+    counter.increment(static_cast<int32_t>(chunkCount));
+    for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+        const uint32_t begin = chunk * chunkWords;
+        const uint32_t end = std::min(begin + chunkWords, wordCount);
+        auto job = [&planes, &bounds, begin, end, words](JobContext &) { cullRange(planes, bounds, begin, end, words); };
+        jobs().run(JobDeclaration(job, JobPriority::HIGH, QueueAffinity::ANY, &counter, "Frustum cull"));
+    }
+    jobs().waitFor(counter, 0);
+}
+
+void cullViewsRange(std::span<const std::array<glm::vec4, 6>> views, const BoundsView &bounds, uint32_t beginWord,
+                    uint32_t endWord, uint64_t *const *words)
+{
+    PlaneCorner corners[CULL_MAX_VIEWS][6];
+    for (size_t view = 0; view < views.size(); ++view) {
+        s_pickCorners(views[view], bounds, corners[view]);
+    }
+
+    // every view runs over one tile of rows before the next tile is touched, so the bounds come from
+    // memory once and stay in the L1 cache for the other views
+    const CullWordFn cullWord = s_cullWordKernel();
+    for (uint32_t tile = beginWord; tile < endWord; tile += CULL_TILE_WORDS) {
+        const uint32_t tileEnd = std::min(tile + CULL_TILE_WORDS, endWord);
+        for (size_t view = 0; view < views.size(); ++view) {
+            for (uint32_t word = tile; word < tileEnd; ++word) {
+                words[view][word] = cullWord(corners[view], word * 64);
+            }
+        }
+    }
+}
+
+void cullViews(std::span<const std::array<glm::vec4, 6>> views, const BoundsView &bounds, std::span<VisibilityMask> out,
+               uint32_t parallelThreshold)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    if (out.size() < views.size()) {
+        RP_CORE_ERROR("{} views were culled into only {} masks", views.size(), out.size());
+        return;
+    }
+
+    // more views than one pass holds are culled in groups, each still reading the bounds once
+    if (views.size() > CULL_MAX_VIEWS) {
+        cullViews(views.subspan(CULL_MAX_VIEWS), bounds, out.subspan(CULL_MAX_VIEWS), parallelThreshold);
+        views = views.first(CULL_MAX_VIEWS);
+    }
+
+    uint64_t *words[CULL_MAX_VIEWS];
+    for (size_t view = 0; view < views.size(); ++view) {
+        out[view].reset(bounds.count);
+        words[view] = out[view].data();
+    }
+
+    if (views.empty()) {
+        return;
+    }
+
+    const uint32_t wordCount = out[0].getWordCount();
+    if (bounds.count < parallelThreshold || bounds.count <= CULL_CHUNK_ROWS) {
+        cullViewsRange(views, bounds, 0, wordCount, words);
+        return;
+    }
+
+    const uint32_t chunkWords = CULL_CHUNK_ROWS / 64;
+    const uint32_t chunkCount = (wordCount + chunkWords - 1) / chunkWords;
+
+    Counter counter{};
+    counter.increment(static_cast<int32_t>(chunkCount));
+    for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+        const uint32_t begin = chunk * chunkWords;
+        const uint32_t end = std::min(begin + chunkWords, wordCount);
+        auto job = [views, &bounds, begin, end, &words](JobContext &) { cullViewsRange(views, bounds, begin, end, words); };
+        jobs().run(JobDeclaration(job, JobPriority::HIGH, QueueAffinity::ANY, &counter, "Multi-view cull"));
+    }
+    jobs().waitFor(counter, 0);
+}
+
+} // namespace Rapture::culling
+
+namespace Rapture {
+
+void ViewCulling::cull(const BoundsView &bounds)
+{
+    if (m_masks.size() < m_planes.size()) {
+        m_masks.resize(m_planes.size());
+    }
+    culling::cullViews(m_planes, bounds, std::span<VisibilityMask>(m_masks).first(m_planes.size()));
+}
+
+} // namespace Rapture
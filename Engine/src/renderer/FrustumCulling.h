@@ -0,0 +1,159 @@
+#ifndef RAPTURE__FRUSTUM_CULLING_H
+#define RAPTURE__FRUSTUM_CULLING_H
+
+#include "scene/systems/WorldBounds.h"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+namespace Rapture {
+
+/**
+ * @brief One bit per row of a BoundsView, set for the rows a frustum keeps
+ */
+class VisibilityMask {
+  public:
+    /**
+     * @brief Sizes the mask for a number of rows and clears it
+     */
+    void reset(uint32_t rows) { m_words.assign((rows + 63) / 64, 0); }
+
+    bool test(uint32_t row) const { return (m_words[row >> 6] >> (row & 63)) & 1u; }
+
+    uint64_t *data() { return m_words.data(); }
+    const uint64_t *data() const { return m_words.data(); }
+    uint32_t getWordCount() const { return static_cast<uint32_t>(m_words.size()); }
+
+    uint32_t countVisible() const
+    {
+        uint32_t count = 0;
+        for (uint64_t word : m_words) {
+            count += static_cast<uint32_t>(std::popcount(word));
+        }
+        return count;
+    }
+
+    /**
+     * @brief Calls fn(row) for every set bit, in row order
+     */
+    template <typename Fn>
+    void forEachVisible(Fn &&fn) const
+    {
+        for (uint32_t word = 0; word < m_words.size(); word++) {
+            for (uint64_t bits = m_words[word]; bits != 0; bits &= bits - 1) {
+                fn(word * 64 + static_cast<uint32_t>(std::countr_zero(bits)));
+            }
+        }
+    }
+
+  private:
+    std::vector<uint64_t> m_words;
+};
+
+/**
+ * @brief The views a frame draws the scene from, culled against its WorldBounds together
+ *
+ * Each pass registers its frustum before the frame is recorded, one cull() fills a mask per view
+ * in a single pass over the bounds, and every pass then builds its draws from its own mask rather
+ * than walking the registry again.
+ */
+class ViewCulling {
+  public:
+    static constexpr uint32_t NO_VIEW = UINT32_MAX;
+
+    void clear() { m_planes.clear(); }
+
+    /**
+     * @return The view's index, for getVisibility() once cull() ran
+     */
+    uint32_t addView(const std::array<glm::vec4, 6> &planes)
+    {
+        m_planes.push_back(planes);
+        return static_cast<uint32_t>(m_planes.size()) - 1;
+    }
+
+    /**
+     * @brief Culls every view added since clear() against the same bounds
+     */
+    void cull(const BoundsView &bounds);
+
+    /**
+     * @return The rows a view keeps, or nullptr for NO_VIEW
+     */
+    const VisibilityMask *getVisibility(uint32_t view) const { return view < m_planes.size() ? &m_masks[view] : nullptr; }
+
+    uint32_t getViewCount() const { return static_cast<uint32_t>(m_planes.size()); }
+
+  private:
+    std::vector<std::array<glm::vec4, 6>> m_planes;
+    std::vector<VisibilityMask> m_masks; // valid until the next cull()
+};
+
+} // namespace Rapture
+
+// Plane tests over boxes stored as in BoundsView. A box is kept unless it lies entirely behind one of
+// the planes, the same conservative test Frustum::testBoundingBox does one box at a time: each plane
+// is checked against the corner furthest along its normal, which is picked once per plane rather than
+// per box. On CPUs with AVX2 eight boxes go through each instruction, picked at runtime, with SSE four,
+// and a scalar loop covers everything else.
+
+namespace Rapture::culling {
+
+// Below this many rows a cull is cheaper on the calling thread than handed out
+inline constexpr uint32_t CULL_PARALLEL_THRESHOLD = 32768;
+inline constexpr uint32_t CULL_CHUNK_ROWS = 16384;
+
+// Views tested in one pass over the bounds, more are culled in several passes
+inline constexpr uint32_t CULL_MAX_VIEWS = 32;
+
+/**
+ * @brief Culls the rows covered by a range of mask words, writing those words whole
+ * @param planes Normalized planes facing inwards, as Frustum::getPlanes() holds them
+ * @param bounds The boxes, padded to whole words
+ * @param beginWord First 64 row word to cull
+ * @param endWord One past the last word
+ * @param words The mask being filled, only [beginWord, endWord) is written
+ */
+void cullRange(const std::array<glm::vec4, 6> &planes, const BoundsView &bounds, uint32_t beginWord, uint32_t endWord,
+               uint64_t *words);
+
+/**
+ * @brief Culls every row, splitting the work across the job system once there are enough rows
+ *
+ * Jobs are waited on before returning, so this is called from the main thread.
+ * @param planes Normalized planes facing inwards
+ * @param bounds The boxes to test
+ * @param out Reset to the row count and filled
+ * @param parallelThreshold Rows needed before jobs are used, UINT32_MAX keeps the cull on the calling thread
+ */
+void cull(const std::array<glm::vec4, 6> &planes, const BoundsView &bounds, VisibilityMask &out,
+          uint32_t parallelThreshold = CULL_PARALLEL_THRESHOLD);
+
+/**
+ * @brief cullRange() for up to CULL_MAX_VIEWS views at once
+ * @param words One mask per view, only [beginWord, endWord) of each is written
+ */
+void cullViewsRange(std::span<const std::array<glm::vec4, 6>> views, const BoundsView &bounds, uint32_t beginWord,
+                    uint32_t endWord, uint64_t *const *words);
+
+/**
+ * @brief Culls every row against several views in one pass over the bounds
+ *
+ * The rows are taken a tile at a time and every view is tested against a tile while it is still in
+ * the L1 cache, so the bounds are read from memory once however many views there are. Every mask
+ * comes out the same as cull() would produce for its view alone.
+ * @param views The planes of each view
+ * @param bounds The boxes to test
+ * @param out One mask per view, each reset to the row count and filled
+ * @param parallelThreshold Rows needed before jobs are used
+ */
+void cullViews(std::span<const std::array<glm::vec4, 6>> views, const BoundsView &bounds, std::span<VisibilityMask> out,
+               uint32_t parallelThreshold = CULL_PARALLEL_THRESHOLD);
+
+} // namespace Rapture::culling
+
+#endif // RAPTURE__FRUSTUM_CULLING_H
@@ -2,6 +2,7 @@
 
 #include "app/Application.h"
 #include "assets/meshes/Mesh.h"
+#include "assets/meshes/SkeletalMesh.h"
 #include "core/utils/Log.h"
 #include "gpu/buffers/Buffers.h"
 #include "gpu/descriptors/DescriptorManager.h"
@@ -9,6 +10,18 @@
 namespace Rapture {
 static constexpr uint32_t INITIAL_BATCH_SIZE = 128;
 
+// a skeletal mesh is culled by the bounds that hold its poses, as WorldBounds culls it on the CPU
+static DrawBounds s_drawBounds(const Mesh &mesh)
+{
+    if (const SkeletalMesh *skeletal = dynamic_cast<const SkeletalMesh *>(&mesh)) {
+        glm::vec3 min;
+        glm::vec3 max;
+        skeletal->getPoseBounds(min, max);
+        return {glm::vec4(min, 0.0f), glm::vec4(max, 0.0f)};
+    }
+    return {glm::vec4(mesh.getBoundsMin(), 0.0f), glm::vec4(mesh.getBoundsMax(), 0.0f)};
+}
+
 MDIBatch::MDIBatch(RenderContext renderContext, std::shared_ptr<BufferAllocation> vboArena,
                    std::shared_ptr<BufferAllocation> iboArena, BufferLayout &bufferLayout, VkIndexType indexType)
     : m_rc(renderContext), m_vboArenaId(vboArena->parentArena->id), m_iboArenaId(iboArena->parentArena->id),
@@ -33,9 +46,8 @@ MDIBatch::~MDIBatch()
     }
 }
 
-void MDIBatch::addObject(const Mesh &mesh, uint32_t meshIndex, uint32_t materialIndex)
+VkDrawIndexedIndirectCommand MDIBatch::makeCommand(const Mesh &mesh, uint32_t firstInstance) const
 {
-
     auto vboAlloc = mesh.getVertexAllocation();
     auto iboAlloc = mesh.getIndexAllocation();
 
@@ -46,7 +58,7 @@ void MDIBatch::addObject(const Mesh &mesh, uint32_t meshIndex, uint32_t material
                                           (m_indexType == VK_INDEX_TYPE_UINT32 ? 4 : 2)); // Direct element index from BufferPool
     cmd.vertexOffset = static_cast<int32_t>(vboAlloc->offsetBytes /
                                             (m_bufferLayout.calculateVertexSize())); // Direct element index from BufferPool
-    cmd.firstInstance = m_cpuIndirectCommands.size(); // This will be the index into the batch info buffer
+    cmd.firstInstance = firstInstance; // This will be the index into the batch info buffer
 
     if (iboAlloc->offsetBytes % (m_indexType == VK_INDEX_TYPE_UINT32 ? 4 : 2) != 0) {
         RP_CORE_ERROR("Index buffer offset is not aligned to index size");
@@ -56,15 +68,115 @@ void MDIBatch::addObject(const Mesh &mesh, uint32_t meshIndex, uint32_t material
                       vboAlloc->offsetBytes % (m_bufferLayout.calculateVertexSize()));
     }
 
-    m_cpuIndirectCommands.push_back(cmd);
+    return cmd;
+}
+
+void MDIBatch::markDirty(uint32_t draw, bool objectInfo)
+{
+    m_dirtyCommands.set(draw);
+    m_dirtyBounds.set(draw);
+    if (objectInfo) {
+        m_dirtyObjectInfo.set(draw);
+    }
+}
+
+uint32_t MDIBatch::addObject(const Mesh &mesh, uint32_t meshIndex, uint32_t materialIndex, uint32_t owner)
+{
+    uint32_t draw = static_cast<uint32_t>(m_cpuIndirectCommands.size());
+
+    m_cpuIndirectCommands.push_back(makeCommand(mesh, draw));
     m_cpuObjectInfo.push_back({meshIndex, materialIndex});
+    m_cpuBounds.push_back(s_drawBounds(mesh));
+    m_owners.push_back(owner);
+    m_visibleCount++;
+
+    m_dirtyCommands.resize(draw + 1);
+    m_dirtyObjectInfo.resize(draw + 1);
+    m_dirtyBounds.resize(draw + 1);
+    markDirty(draw, true);
+    return draw;
+}
+
+bool MDIBatch::setObject(uint32_t draw, const Mesh &mesh, uint32_t meshIndex, uint32_t materialIndex)
+{
+    VkDrawIndexedIndirectCommand cmd = makeCommand(mesh, draw);
+    VkDrawIndexedIndirectCommand &current = m_cpuIndirectCommands[draw];
+    cmd.instanceCount = current.instanceCount;
+
+    ObjectInfo &info = m_cpuObjectInfo[draw];
+    DrawBounds bounds = s_drawBounds(mesh);
+    bool commandChanged = cmd.indexCount != current.indexCount || cmd.firstIndex != current.firstIndex ||
+                          cmd.vertexOffset != current.vertexOffset || bounds.min != m_cpuBounds[draw].min ||
+                          bounds.max != m_cpuBounds[draw].max;
+    bool infoChanged = info.meshIndex != meshIndex || info.materialIndex != materialIndex;
+    if (!commandChanged && !infoChanged) {
+        return false;
+    }
+
+    current = cmd;
+    info = {meshIndex, materialIndex};
+    m_cpuBounds[draw] = bounds;
+    markDirty(draw, infoChanged);
+    return true;
+}
+
+bool MDIBatch::setMeshIndex(uint32_t draw, uint32_t meshIndex)
+{
+    ObjectInfo &info = m_cpuObjectInfo[draw];
+    if (info.meshIndex == meshIndex) {
+        return false;
+    }
+
+    info.meshIndex = meshIndex;
+    m_dirtyObjectInfo.set(draw);
+    return true;
+}
+
+uint32_t MDIBatch::removeObject(uint32_t draw)
+{
+    if (isVisible(draw)) {
+        m_visibleCount--;
+    }
+
+    uint32_t last = static_cast<uint32_t>(m_cpuIndirectCommands.size()) - 1;
+    uint32_t movedOwner = UINT32_MAX;
+    if (draw != last) {
+        m_cpuIndirectCommands[draw] = m_cpuIndirectCommands[last];
+        m_cpuIndirectCommands[draw].firstInstance = draw;
+        m_cpuObjectInfo[draw] = m_cpuObjectInfo[last];
+        m_cpuBounds[draw] = m_cpuBounds[last];
+        m_owners[draw] = m_owners[last];
+        movedOwner = m_owners[draw];
+        markDirty(draw, true);
+    }
+
+    m_cpuIndirectCommands.pop_back();
+    m_cpuObjectInfo.pop_back();
+    m_cpuBounds.pop_back();
+    m_owners.pop_back();
+    return movedOwner;
+}
+
+bool MDIBatch::setVisible(uint32_t draw, bool visible)
+{
+    VkDrawIndexedIndirectCommand &cmd = m_cpuIndirectCommands[draw];
+    if ((cmd.instanceCount != 0) == visible) {
+        return false;
+    }
+
+    cmd.instanceCount = visible ? 1 : 0;
+    m_visibleCount += visible ? 1 : -1;
+    m_dirtyCommands.set(draw);
+    return true;
 }
 
 void MDIBatch::uploadBuffers()
 {
+    m_lastUpload = {};
     if (m_cpuIndirectCommands.empty()) return;
 
     uint32_t requiredSize = m_cpuIndirectCommands.size();
+    bool recreated = false;
 
     // Create buffers if they don't exist yet or resize if needed
     if (!m_buffersCreated || requiredSize > m_allocatedSize) {
@@ -109,16 +221,92 @@ void MDIBatch::uploadBuffers()
 
         m_allocatedSize = newSize;
         m_buffersCreated = true;
+        recreated = true;
+    }
+
+    // fresh buffers hold nothing yet, otherwise only the draws written since the last upload are copied
+    m_commandRegions.clear();
+    m_objectInfoRegions.clear();
+    if (recreated) {
+        m_commandRegions.push_back({.data = m_cpuIndirectCommands.data(),
+                                    .size = requiredSize * sizeof(VkDrawIndexedIndirectCommand),
+                                    .offset = 0});
+        m_objectInfoRegions.push_back({.data = m_cpuObjectInfo.data(), .size = requiredSize * sizeof(ObjectInfo), .offset = 0});
+        m_lastUpload.fullCopies = 2;
+    } else {
+        m_lastUpload.fullCopies += collectDirtyRegions(m_dirtyCommands, m_cpuIndirectCommands.data(),
+                                                       sizeof(VkDrawIndexedIndirectCommand), requiredSize, 0, m_commandRegions);
+        m_lastUpload.fullCopies += collectDirtyRegions(m_dirtyObjectInfo, m_cpuObjectInfo.data(), sizeof(ObjectInfo),
+                                                       requiredSize, 0, m_objectInfoRegions);
+    }
+
+    if (!m_commandRegions.empty()) {
+        m_indirectBuffer->addDataRegions(m_commandRegions);
+    }
+    if (!m_objectInfoRegions.empty()) {
+        m_batchInfoBuffer->addDataRegions(m_objectInfoRegions);
+    }
+
+    // bounds only go to a batch that is culled on the GPU, one that outgrew them gets all of them
+    // again from prepareCullTargets()
+    m_boundsRegions.clear();
+    if (m_boundsBuffer && !recreated && requiredSize <= m_cullCapacity) {
+        m_lastUpload.fullCopies += collectDirtyRegions(m_dirtyBounds, m_cpuBounds.data(), sizeof(DrawBounds), requiredSize, 0,
+                                                       m_boundsRegions);
+        if (!m_boundsRegions.empty()) {
+            m_boundsBuffer->addDataRegions(m_boundsRegions);
+        }
     }
 
-    m_indirectBuffer->addData(m_cpuIndirectCommands.data(), m_cpuIndirectCommands.size() * sizeof(VkDrawIndexedIndirectCommand), 0);
-    m_batchInfoBuffer->addData(m_cpuObjectInfo.data(), m_cpuObjectInfo.size() * sizeof(ObjectInfo), 0);
+    m_lastUpload.regions = static_cast<uint32_t>(m_commandRegions.size() + m_objectInfoRegions.size() + m_boundsRegions.size());
+    for (const auto &region : m_commandRegions) {
+        m_lastUpload.bytes += region.size;
+    }
+    for (const auto &region : m_objectInfoRegions) {
+        m_lastUpload.bytes += region.size;
+    }
+    for (const auto &region : m_boundsRegions) {
+        m_lastUpload.bytes += region.size;
+    }
+
+    m_dirtyCommands.clearAll();
+    m_dirtyObjectInfo.clearAll();
+    m_dirtyBounds.clearAll();
+}
+
+bool MDIBatch::prepareCullTargets()
+{
+    if (!m_buffersCreated) {
+        return false;
+    }
+
+    if (m_boundsBuffer && m_cullCapacity >= m_allocatedSize) {
+        return true;
+    }
+
+    VmaAllocator allocator = Application::getInstance().getVulkanContext().getVmaAllocator();
+
+    // sized like the indirect buffer, so they grow together and only when it does
+    m_boundsBuffer = std::make_shared<StorageBuffer>(m_allocatedSize * sizeof(DrawBounds), BufferUsage::STREAM, allocator);
+    m_culledIndirectBuffer = std::make_shared<StorageBuffer>(m_allocatedSize * sizeof(VkDrawIndexedIndirectCommand),
+                                                             BufferUsage::STATIC, allocator, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+    m_drawCountBuffer =
+        std::make_shared<StorageBuffer>(sizeof(uint32_t), BufferUsage::STATIC, allocator, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+    m_cullCapacity = m_allocatedSize;
+
+    if (!m_cpuBounds.empty()) {
+        m_boundsBuffer->addData(m_cpuBounds.data(), m_cpuBounds.size() * sizeof(DrawBounds), 0);
+    }
+    return true;
 }
 
 void MDIBatch::clear()
 {
     m_cpuIndirectCommands.clear();
     m_cpuObjectInfo.clear();
+    m_cpuBounds.clear();
+    m_owners.clear();
+    m_visibleCount = 0;
 }
 
 std::shared_ptr<StorageBuffer> MDIBatch::getIndirectBuffer()
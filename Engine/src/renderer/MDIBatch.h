@@ -4,6 +4,8 @@
 #include "gpu/buffers/StorageBuffer.h"
 #include "gpu/buffers/UniformBuffer.h"
 #include "gpu/vulkan_context/RenderContext.h"
+#include "renderer/DrawCulling.h"
+#include "renderer/RenderPartition.h"
 
 #include <cstdint>
 #include <vector>
@@ -26,18 +28,73 @@ class MDIBatch {
              BufferLayout &bufferLayout, VkIndexType indexType);
     ~MDIBatch();
 
-    void addObject(const Mesh &mesh, uint32_t meshIndex, uint32_t materialIndex);
-
-    // commit the data to the gpu buffers
+    /**
+     * @brief Appends a draw of a mesh
+     * @param owner Caller's id for the draw, handed back by removeObject() when the draw moves
+     * @return Index of the draw in the batch
+     */
+    uint32_t addObject(const Mesh &mesh, uint32_t meshIndex, uint32_t materialIndex, uint32_t owner = UINT32_MAX);
+
+    /**
+     * @brief Rewrites a draw in place, keeping whether it is visible
+     * @return True if anything the GPU reads changed
+     */
+    bool setObject(uint32_t draw, const Mesh &mesh, uint32_t meshIndex, uint32_t materialIndex);
+
+    /**
+     * @brief Points a draw at another mesh data slot, for when the slot it had was moved
+     * @return True if the index changed
+     */
+    bool setMeshIndex(uint32_t draw, uint32_t meshIndex);
+
+    /**
+     * @brief Removes a draw by moving the last one into its place
+     * @return Owner of the draw that now sits at that index, or UINT32_MAX if it was the last one
+     */
+    uint32_t removeObject(uint32_t draw);
+
+    /**
+     * @brief Shows or hides a draw through its instance count, so that the command stays where it is
+     * @return True if the draw's visibility changed
+     */
+    bool setVisible(uint32_t draw, bool visible);
+
+    bool isVisible(uint32_t draw) const { return m_cpuIndirectCommands[draw].instanceCount != 0; }
+    uint32_t getVisibleCount() const { return m_visibleCount; }
+    uint32_t getOwner(uint32_t draw) const { return m_owners[draw]; }
+    const ObjectInfo &getObjectInfo(uint32_t draw) const { return m_cpuObjectInfo[draw]; }
+    const DrawBounds &getBounds(uint32_t draw) const { return m_cpuBounds[draw]; }
+    const VkDrawIndexedIndirectCommand &getCommand(uint32_t draw) const { return m_cpuIndirectCommands[draw]; }
+
+    // commit the draws changed since the last upload to the gpu buffers
     // should be called at the end, when all of the objects have been added
     void uploadBuffers();
 
+    /**
+     * @brief Creates or grows what DrawCullPass culls this batch into, after uploadBuffers()
+     *
+     * The mesh bounds of every draw, an indirect buffer the kept commands are compacted into and the
+     * draw count for vkCmdDrawIndexedIndirectCount. Only batches culled on the GPU pay for them.
+     * @return False if the batch has no buffers yet
+     */
+    bool prepareCullTargets();
+
     // clear the cpu data
     void clear();
 
+    /**
+     * @brief What the last uploadBuffers() wrote
+     */
+    const GPUUploadStats &getLastUploadStats() const { return m_lastUpload; }
+
     std::shared_ptr<StorageBuffer> getIndirectBuffer();
     std::shared_ptr<StorageBuffer> getBatchInfoBuffer();
     uint32_t getBatchInfoBufferIndex() const;
+
+    // valid once prepareCullTargets() succeeded
+    std::shared_ptr<StorageBuffer> getBoundsBuffer() const { return m_boundsBuffer; }
+    std::shared_ptr<StorageBuffer> getCulledIndirectBuffer() const { return m_culledIndirectBuffer; }
+    std::shared_ptr<StorageBuffer> getDrawCountBuffer() const { return m_drawCountBuffer; }
     uint32_t getVboArenaId() const { return m_vboArenaId; }
     uint32_t getIboArenaId() const { return m_iboArenaId; }
     uint32_t getDrawCount() const { return m_cpuIndirectCommands.size(); }
@@ -48,12 +105,34 @@ class MDIBatch {
     VkBuffer getIndexBuffer() const { return m_indexBuffer; }
     VkIndexType getIndexType() const { return m_indexType; }
 
+  private:
+    VkDrawIndexedIndirectCommand makeCommand(const Mesh &mesh, uint32_t firstInstance) const;
+    void markDirty(uint32_t draw, bool objectInfo);
+
   private:
     std::shared_ptr<StorageBuffer> m_indirectBuffer;
     std::shared_ptr<StorageBuffer> m_batchInfoBuffer;
 
     std::vector<VkDrawIndexedIndirectCommand> m_cpuIndirectCommands;
     std::vector<ObjectInfo> m_cpuObjectInfo;
+    std::vector<DrawBounds> m_cpuBounds;
+    std::vector<uint32_t> m_owners;
+    uint32_t m_visibleCount = 0;
+
+    // draws written since the last upload, so a batch that barely changes uploads next to nothing
+    DirtyBitfield m_dirtyCommands;
+    DirtyBitfield m_dirtyObjectInfo;
+    DirtyBitfield m_dirtyBounds;
+    std::vector<BufferWriteRegion> m_commandRegions;
+    std::vector<BufferWriteRegion> m_objectInfoRegions;
+    std::vector<BufferWriteRegion> m_boundsRegions;
+    GPUUploadStats m_lastUpload;
+
+    // GPU culling, created by prepareCullTargets()
+    std::shared_ptr<StorageBuffer> m_boundsBuffer;
+    std::shared_ptr<StorageBuffer> m_culledIndirectBuffer;
+    std::shared_ptr<StorageBuffer> m_drawCountBuffer;
+    uint32_t m_cullCapacity = 0;
 
     RenderContext m_rc;
 
@@ -97,7 +176,7 @@ class MDIBatchMap {
   public:
     MDIBatchMap(RenderContext renderContext);
 
-    // called at the start of the frame
+    // called at the start of the frame by passes that refill their batches every frame
     // this is used to clear the batch map
     void beginFrame();
 
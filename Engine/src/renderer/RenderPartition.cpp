@@ -11,6 +11,12 @@
 #define SSBO_MIN_CAPACITY  64u
 #define SSBO_GROWTH_FACTOR 2u
 
+// Clean slots between two dirty runs are copied along when the gap is at most this many slots
+#define SSBO_UPLOAD_MERGE_GAP 8u
+// Above this share of a partition dirty, or this many regions, one full copy is cheaper
+#define SSBO_FULL_COPY_PERCENT  50u
+#define SSBO_MAX_UPLOAD_REGIONS 1024u
+
 namespace Rapture {
 
 void DirtyBitfield::resize(uint32_t slotCount)
@@ -37,6 +43,53 @@ bool DirtyBitfield::hasAnyDirty() const
     return m_anyDirty;
 }
 
+bool collectDirtyRegions(const DirtyBitfield &dirty, const void *data, uint32_t stride, uint32_t count, uint64_t baseOffset,
+                         std::vector<BufferWriteRegion> &regions)
+{
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    size_t firstRegion = regions.size();
+    uint32_t copiedSlots = 0;
+
+    auto addRegion = [&](uint32_t first, uint32_t end) {
+        regions.push_back({.data = bytes + static_cast<size_t>(first) * stride,
+                           .size = static_cast<VkDeviceSize>(end - first) * stride,
+                           .offset = baseOffset + static_cast<VkDeviceSize>(first) * stride});
+        copiedSlots += end - first;
+    };
+
+    bool open = false;
+    uint32_t runStart = 0;
+    uint32_t runEnd = 0;
+    dirty.forEachDirtyRange([&](uint32_t first, uint32_t slotCount) {
+        if (first >= count) {
+            return;
+        }
+        slotCount = std::min(slotCount, count - first);
+        if (open && first - runEnd <= SSBO_UPLOAD_MERGE_GAP) {
+            runEnd = first + slotCount;
+            return;
+        }
+        if (open) {
+            addRegion(runStart, runEnd);
+        }
+        runStart = first;
+        runEnd = first + slotCount;
+        open = true;
+    });
+    if (open) {
+        addRegion(runStart, runEnd);
+    }
+
+    size_t regionCount = regions.size() - firstRegion;
+    if (regionCount > 1 &&
+        (copiedSlots * 100ull >= count * static_cast<uint64_t>(SSBO_FULL_COPY_PERCENT) || regionCount > SSBO_MAX_UPLOAD_REGIONS)) {
+        regions.resize(firstRegion);
+        addRegion(0, count);
+        return true;
+    }
+    return false;
+}
+
 template <typename T>
 void RenderPartition<T>::init(uint32_t frameCount, SwapCallback onSwap)
 {
@@ -146,12 +199,6 @@ bool RenderPartition<T>::hasDirty(uint32_t frameIndex) const
     return m_dirtyBitfields[frameIndex].hasAnyDirty();
 }
 
-template <typename T>
-void RenderPartition<T>::forEachDirty(uint32_t frameIndex, const std::function<void(uint32_t)> &fn) const
-{
-    m_dirtyBitfields[frameIndex].forEachDirty(fn);
-}
-
 template <typename T>
 void RenderPartition<T>::clearDirty(uint32_t frameIndex)
 {
@@ -212,24 +259,44 @@ uint32_t GPUDataStore<T>::getTotalCount() const
 template <typename T>
 void GPUDataStore<T>::upload(uint32_t frameIndex)
 {
+    m_lastUpload = {};
+
     uint32_t staticCount = m_partitions[MOBILITY_STATIC].getCount();
     uint32_t dynamicCount = m_partitions[MOBILITY_DYNAMIC].getCount();
     if (staticCount + dynamicCount == 0) return;
 
     ensureCapacity(staticCount, dynamicCount);
 
-    auto *ssbo = m_ssbos[frameIndex].get();
+    // both partitions are gathered after the resize, which can mark everything dirty again
+    m_uploadRegions.clear();
+    collectUploadRegions(MOBILITY_STATIC, frameIndex, 0);
+    collectUploadRegions(MOBILITY_DYNAMIC, frameIndex, m_staticCapacity);
 
-    if (staticCount > 0 && m_partitions[MOBILITY_STATIC].hasDirty(frameIndex)) {
-        ssbo->addData(m_partitions[MOBILITY_STATIC].getData(), static_cast<VkDeviceSize>(staticCount) * sizeof(T), 0);
-        m_partitions[MOBILITY_STATIC].clearDirty(frameIndex);
+    // Each frame in flight owns its SSBO and it is host visible, so the regions land in it directly
+    // without going through a staging buffer and a transfer
+    m_ssbos[frameIndex]->addDataRegions(m_uploadRegions);
+
+    m_lastUpload.regions = static_cast<uint32_t>(m_uploadRegions.size());
+    for (const auto &region : m_uploadRegions) {
+        m_lastUpload.bytes += region.size;
     }
+}
 
-    if (dynamicCount > 0 && m_partitions[MOBILITY_DYNAMIC].hasDirty(frameIndex)) {
-        ssbo->addData(m_partitions[MOBILITY_DYNAMIC].getData(), static_cast<VkDeviceSize>(dynamicCount) * sizeof(T),
-                      static_cast<VkDeviceSize>(m_staticCapacity) * sizeof(T));
-        m_partitions[MOBILITY_DYNAMIC].clearDirty(frameIndex);
+template <typename T>
+void GPUDataStore<T>::collectUploadRegions(Mobility mobility, uint32_t frameIndex, uint32_t globalBase)
+{
+    RenderPartition<T> &partition = m_partitions[mobility];
+    uint32_t count = partition.getCount();
+    if (count == 0 || !partition.hasDirty(frameIndex)) {
+        return;
     }
+
+    if (collectDirtyRegions(partition.getDirty(frameIndex), partition.getData(), sizeof(T), count,
+                            static_cast<uint64_t>(globalBase) * sizeof(T), m_uploadRegions)) {
+        m_lastUpload.fullCopies++;
+    }
+
+    partition.clearDirty(frameIndex);
 }
 
 template <typename T>
@@ -5,6 +5,7 @@
 #include "scene/EntityCommon.h"
 #include "scene/components/ComponentsCommon.h"
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <functional>
@@ -15,6 +16,7 @@ namespace Rapture {
 
 struct RenderContext;
 class StorageBuffer;
+struct BufferWriteRegion;
 
 /**
  * @brief Cache-friendly bit array for tracking which SSBO slots need re-upload
@@ -51,7 +53,21 @@ class DirtyBitfield {
     template <typename Fn>
     void forEachDirty(Fn &&fn) const
     {
-        for (uint32_t wordIdx = 0; wordIdx < static_cast<uint32_t>(m_words.size()); wordIdx++) {
+        forEachDirtyInWords(0, getWordCount(), fn);
+    }
+
+    /**
+     * @brief Invoke a callback for each dirty slot within a range of whole words
+     *
+     * Callers that split the bitfield at word boundaries can walk their parts on separate threads.
+     * @param beginWord First word to visit
+     * @param endWord One past the last word to visit
+     * @param fn Callable with signature void(uint32_t slotIndex)
+     */
+    template <typename Fn>
+    void forEachDirtyInWords(uint32_t beginWord, uint32_t endWord, Fn &&fn) const
+    {
+        for (uint32_t wordIdx = beginWord; wordIdx < endWord; wordIdx++) {
             uint64_t word = m_words[wordIdx];
             while (word != 0) {
                 uint32_t bit = static_cast<uint32_t>(__builtin_ctzll(word));
@@ -64,12 +80,82 @@ class DirtyBitfield {
         }
     }
 
+    uint32_t getWordCount() const { return static_cast<uint32_t>(m_words.size()); }
+
+    /**
+     * @brief The dirty bits of 64 consecutive slots, starting at slot wordIdx * 64
+     */
+    uint64_t getWord(uint32_t wordIdx) const { return m_words[wordIdx]; }
+
+    /**
+     * @brief Invoke a callback for each run of consecutive dirty slots, in ascending order
+     * @param fn Callable with signature void(uint32_t firstSlot, uint32_t slotCount)
+     */
+    template <typename Fn>
+    void forEachDirtyRange(Fn &&fn) const
+    {
+        bool open = false;
+        uint32_t runStart = 0;
+        for (uint32_t wordIdx = 0; wordIdx < static_cast<uint32_t>(m_words.size()); wordIdx++) {
+            uint64_t word = m_words[wordIdx];
+            // whole words of the current state are skipped, only transitions cost a ctz
+            if (word == (open ? ~0ULL : 0ULL)) {
+                continue;
+            }
+
+            uint32_t bit = 0;
+            while (bit < 64) {
+                uint64_t rest = (open ? ~word : word) >> bit;
+                if (rest == 0) {
+                    break;
+                }
+                bit += static_cast<uint32_t>(__builtin_ctzll(rest));
+                uint32_t slot = wordIdx * 64 + bit;
+                if (open) {
+                    emitRange(runStart, slot, fn);
+                } else {
+                    runStart = slot;
+                }
+                open = !open;
+            }
+        }
+        if (open) {
+            emitRange(runStart, static_cast<uint32_t>(m_words.size()) * 64, fn);
+        }
+    }
+
   private:
+    // bits past the slot count can be left over from a shrink, they are never reported
+    template <typename Fn>
+    void emitRange(uint32_t first, uint32_t end, Fn &fn) const
+    {
+        end = std::min(end, m_slotCount);
+        if (first < end) {
+            fn(first, end - first);
+        }
+    }
+
     std::vector<uint64_t> m_words;
     uint32_t m_slotCount = 0;
     bool m_anyDirty = false;
 };
 
+/**
+ * @brief Turns a bitfield's dirty runs into buffer regions, copying short clean gaps between them along
+ *
+ * When the runs cover most of the array, or would need too many regions, they are replaced by one
+ * region over the whole array.
+ * @param dirty Which elements changed, bits at or past count are ignored
+ * @param data First element of the CPU array
+ * @param stride Size of one element in bytes
+ * @param count Number of elements in the array
+ * @param baseOffset Byte offset in the buffer where the first element lands
+ * @param regions Appended to
+ * @return True if the whole array was copied at once
+ */
+bool collectDirtyRegions(const DirtyBitfield &dirty, const void *data, uint32_t stride, uint32_t count, uint64_t baseOffset,
+                         std::vector<BufferWriteRegion> &regions);
+
 /**
  * @brief Dense slot map with per-frame dirty tracking for GPU data
  *
@@ -154,7 +240,24 @@ class RenderPartition {
      * @param frameIndex Frame to query
      * @param fn Callback invoked with each dirty slot index
      */
-    void forEachDirty(uint32_t frameIndex, const std::function<void(uint32_t)> &fn) const;
+    template <typename Fn>
+    void forEachDirty(uint32_t frameIndex, Fn &&fn) const
+    {
+        m_dirtyBitfields[frameIndex].forEachDirty(fn);
+    }
+
+    /**
+     * @brief Invoke a callback for each run of consecutive dirty slots in a frame's bitfield
+     * @param frameIndex Frame to query
+     * @param fn Callable with signature void(uint32_t firstSlot, uint32_t slotCount)
+     */
+    template <typename Fn>
+    void forEachDirtyRange(uint32_t frameIndex, Fn &&fn) const
+    {
+        m_dirtyBitfields[frameIndex].forEachDirtyRange(fn);
+    }
+
+    const DirtyBitfield &getDirty(uint32_t frameIndex) const { return m_dirtyBitfields[frameIndex]; }
 
     /**
      * @brief Clear the dirty bitfield for a frame after upload
@@ -180,6 +283,15 @@ class RenderPartition {
     uint32_t m_frameCount = 0;
 };
 
+/**
+ * @brief What one GPUDataStore::upload wrote, for the profiler
+ */
+struct GPUUploadStats {
+    uint64_t bytes = 0;
+    uint32_t regions = 0;
+    uint32_t fullCopies = 0; // partitions rewritten whole because most of them was dirty
+};
+
 /**
  * @brief Bundles static + dynamic partitions with per-frame SSBOs for one data type
  *
@@ -213,11 +325,19 @@ class GPUDataStore {
     uint32_t getTotalCount() const;
 
     /**
-     * @brief Upload partition data to the SSBO for the given frame
+     * @brief Upload the slots that changed since this frame's SSBO was last written
+     *
+     * Dirty slots are coalesced into ranges, bridging small clean gaps, and written as region copies
+     * under one map. A partition that is mostly dirty, or would need too many regions, is copied whole.
      * @param frameIndex Current frame in flight index
      */
     void upload(uint32_t frameIndex);
 
+    /**
+     * @brief What the last upload() wrote
+     */
+    const GPUUploadStats &getLastUploadStats() const { return m_lastUpload; }
+
     /**
      * @brief Get the SSBO for a given frame
      * @param frameIndex Frame in flight index
@@ -257,6 +377,7 @@ class GPUDataStore {
     uint32_t getLocalSlot(Mobility mobility, uint32_t globalSlot) const;
 
   private:
+    void collectUploadRegions(Mobility mobility, uint32_t frameIndex, uint32_t globalBase);
     void ensureCapacity(uint32_t requiredStaticCount, uint32_t requiredDynamicCount);
     void registerSSBOs();
     void unregisterSSBOs();
@@ -264,6 +385,8 @@ class GPUDataStore {
     std::array<RenderPartition<T>, MOBILITY_COUNT> m_partitions;
     std::vector<std::unique_ptr<StorageBuffer>> m_ssbos;
     std::vector<uint32_t> m_descriptorIndices;
+    std::vector<BufferWriteRegion> m_uploadRegions; // reused between uploads
+    GPUUploadStats m_lastUpload;
     uint32_t m_staticCapacity = 0;
     uint32_t m_dynamicCapacity = 0;
     uint32_t m_frameCount = 0;
@@ -19,6 +19,7 @@ enum RenderSettingFlags {
     RENDER_SHOW_MOTION = 1 << 6,            // debug view: screen-space motion vectors
     RENDER_SHOW_AMBIENT_OCCLUSION = 1 << 7, // debug view: the traced occlusion term on its own
     RENDER_USE_AMBIENT_OCCLUSION = 1 << 8,  // modulate indirect diffuse by the traced occlusion
+    RENDER_USE_GPU_CULLING = 1 << 9,        // cull and compact the camera's draws on the GPU, with last frame's depth pyramid
     RENDER_ALL = 0xFFFFFFFF,
 };
 
@@ -33,6 +34,7 @@ struct RenderSettings {
     bool useDirectLighting() const { return (flags & RENDER_SHOW_DIRECT) != 0u; }
     bool useIndirectLighting() const { return (flags & RENDER_SHOW_INDIRECT) != 0u; }
     bool showDDGIProbes() const { return (flags & RENDER_SHOW_DDGI_PROBES) != 0u; }
+    bool useGPUCulling() const { return (flags & RENDER_USE_GPU_CULLING) != 0u; }
 
     void setFlag(RenderSettingFlags flag, bool on) { flags = on ? (flags | flag) : (flags & ~flag); }
 };
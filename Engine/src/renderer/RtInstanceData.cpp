@@ -67,7 +67,7 @@ void RtInstanceData::rebuild(Scene &scene)
             const StaticMeshComponent &meshComp = reg.read<StaticMeshComponent>(inst.entityID);
             const MaterialComponent &materialComp = reg.read<MaterialComponent>(inst.entityID);
 
-            info.modelMatrix = reg.read<TransformComponent>(inst.entityID).world;
+            info.modelMatrix = reg.read<TransformComponent>(inst.entityID).worldMatrix();
 
             if (materialComp.material) {
                 info.materialIndex = materialComp.material->getBindlessIndex();
@@ -182,7 +182,7 @@ void RtInstanceData::patchDirty(Scene &scene)
         if (transform == nullptr) continue;
 
         uint32_t dst = it->second + static_cast<uint32_t>(TRANSFORM_OFFSET);
-        glm::mat4 model = transform->world;
+        glm::mat4 model = transform->worldMatrix();
         m_buffer->addData(&model, sizeof(glm::mat4), dst);
     }
 
@@ -5,119 +5,346 @@
 #include "core/utils/Log.h"
 #include "core/utils/TracyProfiler.h"
 #include "renderer/Frustum.h"
+#include "renderer/FrustumCulling.h"
 #include "scene/Scene.h"
+#include "scene/components/ChangeChannels.h"
 #include "scene/components/Components.h"
 #include "scene/render_data/SceneRenderData.h"
 
 namespace Rapture {
 
-static void s_addMeshToBatch(MDIBatchMap &batchMap, Mesh &mesh, uint32_t meshSlotIndex, uint32_t materialIndex)
+/**
+ * @brief The mesh an entity draws, whichever mesh component holds it
+ * @return The mesh, or nullptr while there is none or it is still loading
+ */
+static Mesh *s_readyMesh(const ecs::Registry &registry, ecs::Entity entity)
 {
-    auto vboAlloc = mesh.getVertexAllocation();
-    auto iboAlloc = mesh.getIndexAllocation();
-    if (!vboAlloc || !iboAlloc) {
-        return;
+    if (const StaticMeshComponent *staticMesh = registry.tryRead<StaticMeshComponent>(entity)) {
+        return staticMesh->isLoading ? nullptr : staticMesh->mesh.get();
+    }
+    if (const SkeletalMeshComponent *skeletal = registry.tryRead<SkeletalMeshComponent>(entity)) {
+        return skeletal->isLoading ? nullptr : skeletal->mesh.get();
     }
+    return nullptr;
+}
 
-    MDIBatch *batch = batchMap.obtainBatch(vboAlloc, iboAlloc, mesh.getVertexBuffer()->getBufferLayout(),
-                                           mesh.getIndexBuffer()->getIndexType());
+SceneGeometryDraw::SceneGeometryDraw(RenderContext renderContext, uint32_t framesInFlight) : m_rc(renderContext)
+{
+    m_frames.resize(framesInFlight);
+    for (FrameDraws &frame : m_frames) {
+        frame.batchMap = std::make_unique<MDIBatchMap>(m_rc);
+    }
+}
 
-    batch->addObject(mesh, meshSlotIndex, materialIndex);
+void SceneGeometryDraw::attach(Scene &scene)
+{
+    m_connections.clear();
+    m_scene = &scene;
+    m_needsRebuild = true;
+
+    ecs::Registry &registry = scene.getRegistry();
+    auto queue = [this](ecs::Entity entity) {
+        if (m_needsRebuild) {
+            return;
+        }
+        // a pass that populates rarely would rather rebuild than hold on to every change since
+        if (m_pending.size() >= ecs::JOURNAL_RING_CAPACITY) {
+            m_pending.clear();
+            m_needsRebuild = true;
+            return;
+        }
+        m_pending.push_back(entity);
+    };
+
+    // adding or removing a component is not journaled, so those arrive through the signals instead
+    m_connections.push_back(registry.onConstructScoped<StaticMeshComponent>(queue));
+    m_connections.push_back(registry.onDestroyScoped<StaticMeshComponent>(queue));
+    m_connections.push_back(registry.onConstructScoped<SkeletalMeshComponent>(queue));
+    m_connections.push_back(registry.onDestroyScoped<SkeletalMeshComponent>(queue));
+    m_connections.push_back(registry.onConstructScoped<MaterialComponent>(queue));
+    m_connections.push_back(registry.onDestroyScoped<MaterialComponent>(queue));
 }
 
-SceneGeometryDraw::SceneGeometryDraw(RenderContext renderContext, uint32_t framesInFlight) : m_rc(renderContext)
+void SceneGeometryDraw::clearDraws()
 {
-    m_batchMaps.resize(framesInFlight);
-    for (uint32_t frame = 0; frame < framesInFlight; frame++) {
-        m_batchMaps[frame] = std::make_unique<MDIBatchMap>(m_rc);
+    for (FrameDraws &frame : m_frames) {
+        for (MDIBatch *batch : frame.batches) {
+            batch->clear();
+        }
+        frame.shown.clear();
+    }
+    m_drawOf.clear();
+}
+
+void SceneGeometryDraw::dropDraw(uint32_t entityIndex)
+{
+    DrawRef &ref = m_drawOf[entityIndex];
+    for (FrameDraws &frame : m_frames) {
+        uint32_t moved = frame.batches[ref.batch]->removeObject(ref.draw);
+        if (moved != UINT32_MAX) {
+            m_drawOf[moved].draw = ref.draw;
+        }
     }
 
-    m_populatedBatches.resize(framesInFlight);
+    ref = {};
+    m_lastStats.commandsRemoved++;
 }
 
-void SceneGeometryDraw::populate(Scene &scene, const Frustum *frustum, uint32_t frameInFlight)
+void SceneGeometryDraw::resolve(Scene &scene, ecs::Entity entity)
 {
-    RAPTURE_PROFILE_FUNCTION();
+    uint32_t index = ecs::EntityIndex(entity);
+    if (index >= m_drawOf.size()) {
+        m_drawOf.resize(index + 1);
+    }
 
-    if (frameInFlight >= m_batchMaps.size()) {
-        RP_CORE_ERROR("Frame {} has no batches", frameInFlight);
+    // the index was handed to a new entity, the draw left behind belonged to the destroyed one
+    if (m_drawOf[index].entity != ecs::ENTITY_NULL && m_drawOf[index].entity != entity) {
+        dropDraw(index);
+    }
+    bool hasDraw = m_drawOf[index].entity == entity;
+
+    ecs::Registry &registry = scene.getRegistry();
+    const bool alive = registry.isValid(entity);
+    const MaterialComponent *materialComp = alive ? registry.tryRead<MaterialComponent>(entity) : nullptr;
+    Mesh *mesh = materialComp != nullptr ? s_readyMesh(registry, entity) : nullptr;
+    if (mesh != nullptr &&
+        (!mesh->getVertexBuffer() || !mesh->getIndexBuffer() || !mesh->getVertexAllocation() || !mesh->getIndexAllocation())) {
+        mesh = nullptr;
+    }
+
+    if (mesh == nullptr) {
+        if (hasDraw) {
+            dropDraw(index);
+        }
+        // an asset finishing its load is not journaled, so a mesh still on its way is asked again
+        if (materialComp != nullptr && (registry.has<StaticMeshComponent>(entity) || registry.has<SkeletalMeshComponent>(entity))) {
+            m_unresolved.push_back(entity);
+        }
         return;
     }
 
-    MDIBatchMap &batchMap = *m_batchMaps[frameInFlight];
-    batchMap.beginFrame();
+    auto vboAlloc = mesh->getVertexAllocation();
+    auto iboAlloc = mesh->getIndexAllocation();
+    BufferLayout &layout = mesh->getVertexBuffer()->getBufferLayout();
+    VkIndexType indexType = mesh->getIndexBuffer()->getIndexType();
+
+    MDIBatchKey key{vboAlloc->parentArena->id, iboAlloc->parentArena->id, layout.hash(), static_cast<uint32_t>(indexType)};
+    auto [it, inserted] = m_batchIndex.try_emplace(key, static_cast<uint32_t>(m_batchKeys.size()));
+    const uint32_t batch = it->second;
+    if (inserted) {
+        m_batchKeys.push_back(key);
+        for (FrameDraws &frame : m_frames) {
+            frame.batches.push_back(frame.batchMap->obtainBatch(vboAlloc, iboAlloc, layout, indexType));
+        }
+    }
 
-    std::vector<MDIBatch *> &populated = m_populatedBatches[frameInFlight];
-    populated.clear();
+    const uint32_t meshIndex = scene.getRenderData()->getMeshSlot(entity);
+    const uint32_t materialIndex = materialComp->material ? materialComp->material->getBindlessIndex() : 0;
 
-    auto &registry = scene.getRegistry();
-    SceneRenderData *renderData = scene.getRenderData();
+    if (hasDraw && m_drawOf[index].batch == batch) {
+        bool changed = false;
+        for (FrameDraws &frame : m_frames) {
+            changed |= frame.batches[batch]->setObject(m_drawOf[index].draw, *mesh, meshIndex, materialIndex);
+        }
+        m_lastStats.commandsRebuilt += changed;
+        return;
+    }
 
-    for (auto [entity, transform, meshComp, materialComp] : registry.read<TransformComponent, StaticMeshComponent, MaterialComponent>()) {
-        RAPTURE_PROFILE_SCOPE("Populate Batch");
+    if (hasDraw) {
+        dropDraw(index);
+    }
 
-        if (!meshComp.mesh || meshComp.isLoading) {
-            continue;
+    // a new draw starts hidden everywhere, each frame shows it once its own cull keeps it
+    uint32_t draw = 0;
+    for (FrameDraws &frame : m_frames) {
+        draw = frame.batches[batch]->addObject(*mesh, meshIndex, materialIndex, index);
+        frame.batches[batch]->setVisible(draw, false);
+    }
+
+    m_drawOf[index] = {entity, batch, draw};
+    m_lastStats.commandsRebuilt++;
+}
+
+void SceneGeometryDraw::sync(Scene &scene)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    if (m_scene != &scene) {
+        attach(scene);
+    }
+
+    ecs::Journal &journal = scene.getRegistry().getJournal();
+    ecs::Batch meshes = journal.readSince(CHANNEL_MESH_BINDING, m_meshBookmark);
+    ecs::Batch materials = journal.readSince(CHANNEL_MATERIAL_BINDING, m_materialBookmark);
+
+    if (m_needsRebuild || meshes.needsRebuild() || materials.needsRebuild()) {
+        uint32_t dropped = 0;
+        for (const DrawRef &ref : m_drawOf) {
+            dropped += ref.entity != ecs::ENTITY_NULL;
         }
+        clearDraws();
+        m_pending.clear();
+        m_unresolved.clear();
 
-        auto mesh = meshComp.mesh;
-        if (!mesh->getVertexBuffer() || !mesh->getIndexBuffer()) {
-            continue;
+        const WorldBounds &bounds = scene.worldBounds();
+        for (uint32_t row = 0; row < bounds.getCount(); row++) {
+            resolve(scene, bounds.getEntity(row));
         }
 
-        // a bounding box derived from the transform is a cache, not a change to the mesh
-        registry.write<StaticMeshComponent>(entity, 0)->updateWorldBoundingBox(transform);
+        m_meshSlotVersion = scene.getRenderData()->getMeshSlotVersion();
+        m_needsRebuild = false;
+        m_lastStats.commandsRemoved = dropped;
+        m_lastStats.rebuilt = true;
+        return;
+    }
 
-        if (frustum != nullptr && frustum->testBoundingBox(meshComp.worldBoundingBox) == FrustumResult::Outside) {
-            continue;
+    for (ecs::Entity entity : m_pending) {
+        resolve(scene, entity);
+    }
+    m_pending.clear();
+
+    for (ecs::Entity entity : meshes) {
+        resolve(scene, entity);
+    }
+    for (ecs::Entity entity : materials) {
+        resolve(scene, entity);
+    }
+
+    m_retry.swap(m_unresolved);
+    m_unresolved.clear();
+    for (ecs::Entity entity : m_retry) {
+        resolve(scene, entity);
+    }
+
+    // a removal elsewhere can move a mesh's data to another slot without the mesh itself changing
+    SceneRenderData *renderData = scene.getRenderData();
+    if (renderData->getMeshSlotVersion() != m_meshSlotVersion) {
+        for (const DrawRef &ref : m_drawOf) {
+            if (ref.entity == ecs::ENTITY_NULL) {
+                continue;
+            }
+            const uint32_t meshIndex = renderData->getMeshSlot(ref.entity);
+            bool changed = false;
+            for (FrameDraws &frame : m_frames) {
+                changed |= frame.batches[ref.batch]->setMeshIndex(ref.draw, meshIndex);
+            }
+            m_lastStats.slotRefreshes += changed;
         }
+        m_meshSlotVersion = renderData->getMeshSlotVersion();
+    }
+}
 
-        uint32_t materialIndex = materialComp.material ? materialComp.material->getBindlessIndex() : 0;
+template <typename Visit>
+void SceneGeometryDraw::show(Scene &scene, uint32_t frameInFlight, bool checkTransform, Visit &&visit)
+{
+    m_lastStats = {};
 
-        s_addMeshToBatch(batchMap, *mesh, renderData->getMeshSlot(entity), materialIndex);
+    if (frameInFlight >= m_frames.size()) {
+        RP_CORE_ERROR("Frame {} has no batches", frameInFlight);
+        return;
+    }
+    if (scene.getRenderData() == nullptr) {
+        m_frames[frameInFlight].populated.clear();
+        return;
     }
 
-    for (auto [entity, transform, meshComp, materialComp] :
-         registry.read<TransformComponent, SkeletalMeshComponent, MaterialComponent>()) {
-        RAPTURE_PROFILE_SCOPE("Populate Batch");
+    sync(scene);
 
-        if (!meshComp.mesh || meshComp.isLoading) {
-            continue;
+    FrameDraws &frame = m_frames[frameInFlight];
+    frame.stamp++;
+    if (frame.shownStamp.size() < m_drawOf.size()) {
+        frame.shownStamp.resize(m_drawOf.size(), 0);
+    }
+
+    auto &registry = scene.getRegistry();
+    m_shownScratch.clear();
+
+    auto showEntity = [&](ecs::Entity entity) {
+        uint32_t index = ecs::EntityIndex(entity);
+        if (index >= m_drawOf.size() || m_drawOf[index].entity != entity) {
+            return;
         }
 
-        auto mesh = meshComp.mesh;
-        if (!mesh->getVertexBuffer() || !mesh->getIndexBuffer()) {
-            continue;
+        // a culled mesh had a transform to place its bounds with, a traversal without a cull checks
+        if (checkTransform && !registry.has<TransformComponent>(entity)) {
+            return;
         }
 
-        // TODO: bind pose bounds, so an animated mesh whose joints leave them culls too early
-        registry.write<SkeletalMeshComponent>(entity, 0)->updateWorldBoundingBox(transform);
+        const DrawRef &ref = m_drawOf[index];
+        frame.shownStamp[index] = frame.stamp;
+        m_lastStats.visibilityWrites += frame.batches[ref.batch]->setVisible(ref.draw, true);
+        m_shownScratch.push_back(entity);
+    };
+
+    visit(showEntity);
 
-        if (frustum != nullptr && frustum->testBoundingBox(meshComp.worldBoundingBox) == FrustumResult::Outside) {
+    // what this frame showed last time and not now is hidden, a dropped draw went with its entity
+    for (ecs::Entity entity : frame.shown) {
+        uint32_t index = ecs::EntityIndex(entity);
+        if (index >= m_drawOf.size() || m_drawOf[index].entity != entity || frame.shownStamp[index] == frame.stamp) {
             continue;
         }
+        const DrawRef &ref = m_drawOf[index];
+        m_lastStats.visibilityWrites += frame.batches[ref.batch]->setVisible(ref.draw, false);
+    }
+    frame.shown.swap(m_shownScratch);
+
+    frame.populated.clear();
+    uint32_t drawCount = 0;
+    for (MDIBatch *batch : frame.batches) {
+        drawCount += batch->getDrawCount();
+        if (batch->getVisibleCount() > 0) {
+            frame.populated.push_back(batch);
+        }
+    }
 
-        uint32_t materialIndex = materialComp.material ? materialComp.material->getBindlessIndex() : 0;
+    m_lastStats.commandsReused = drawCount > m_lastStats.commandsRebuilt ? drawCount - m_lastStats.commandsRebuilt : 0;
+    RAPTURE_PROFILE_PLOT("Geometry Commands Rebuilt", static_cast<int64_t>(m_lastStats.commandsRebuilt));
+    RAPTURE_PROFILE_PLOT("Geometry Commands Reused", static_cast<int64_t>(m_lastStats.commandsReused));
+}
 
-        s_addMeshToBatch(batchMap, *mesh, renderData->getMeshSlot(entity), materialIndex);
-    }
+void SceneGeometryDraw::populate(Scene &scene, const Frustum *frustum, uint32_t frameInFlight, GeometryCull cull)
+{
+    RAPTURE_PROFILE_FUNCTION();
 
-    for (const auto &[batchKey, batch] : batchMap.getBatches()) {
-        if (batch->getDrawCount() == 0) {
-            continue;
+    const WorldBounds &bounds = scene.worldBounds();
+
+    show(scene, frameInFlight, frustum == nullptr, [&](auto &showEntity) {
+        if (frustum == nullptr) {
+            for (uint32_t row = 0; row < bounds.getCount(); row++) {
+                showEntity(bounds.getEntity(row));
+            }
+        } else if (cull == GeometryCull::BVH) {
+            m_bvhHits.clear();
+            scene.bvh().queryFrustum(frustum->getPlanes(), m_bvhHits);
+            for (ecs::Entity entity : m_bvhHits) {
+                showEntity(entity);
+            }
+        } else {
+            culling::cull(frustum->getPlanes(), bounds.view(), m_visible);
+            m_visible.forEachVisible([&](uint32_t row) { showEntity(bounds.getEntity(row)); });
         }
-        populated.push_back(batch.get());
-    }
+    });
+}
+
+void SceneGeometryDraw::populate(Scene &scene, const VisibilityMask &visible, uint32_t frameInFlight)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    const WorldBounds &bounds = scene.worldBounds();
+
+    show(scene, frameInFlight, false,
+         [&](auto &showEntity) { visible.forEachVisible([&](uint32_t row) { showEntity(bounds.getEntity(row)); }); });
 }
 
 std::span<MDIBatch *const> SceneGeometryDraw::batches(uint32_t frameInFlight) const
 {
-    if (frameInFlight >= m_populatedBatches.size()) {
+    if (frameInFlight >= m_frames.size()) {
         RP_CORE_ERROR("Frame {} has no batches", frameInFlight);
         return {};
     }
 
-    return m_populatedBatches[frameInFlight];
+    return m_frames[frameInFlight].populated;
 }
 
 void SceneGeometryDraw::bindBatch(CommandBuffer *commandBuffer, MDIBatch *batch)
@@ -125,6 +352,7 @@ void SceneGeometryDraw::bindBatch(CommandBuffer *commandBuffer, MDIBatch *batch)
     RAPTURE_PROFILE_FUNCTION();
 
     batch->uploadBuffers();
+    m_lastStats.uploadBytes += batch->getLastUploadStats().bytes;
 
     auto &vc = Application::getInstance().getVulkanContext();
     VkCommandBuffer cmd = commandBuffer->getCommandBufferVk();
@@ -1,13 +1,18 @@
 #ifndef RAPTURE__SCENE_GEOMETRY_DRAW_H
 #define RAPTURE__SCENE_GEOMETRY_DRAW_H
 
+#include "core/ecs/common.h"
+#include "core/ecs/component_signal.h"
+#include "core/ecs/journal.h"
 #include "gpu/command_buffers/CommandBuffer.h"
 #include "gpu/vulkan_context/RenderContext.h"
+#include "renderer/FrustumCulling.h"
 #include "renderer/MDIBatch.h"
 
 #include <cstdint>
 #include <memory>
 #include <span>
+#include <unordered_map>
 #include <vector>
 
 namespace Rapture {
@@ -15,12 +20,43 @@ namespace Rapture {
 class Frustum;
 class Scene;
 
+/**
+ * @brief How populate() finds the meshes a frustum keeps
+ */
+enum class GeometryCull {
+    SCAN, // test every row of the scene's WorldBounds, best when the frustum keeps a good part of the scene
+    BVH   // walk the scene's SceneBVH, best for a narrow frustum such as a picking region
+};
+
+/**
+ * @brief What the last populate() did to the kept draws, for the profiler and benchmarks
+ */
+struct GeometryDrawStats {
+    uint32_t commandsRebuilt = 0;  // draws added or rewritten because their mesh or material changed
+    uint32_t commandsReused = 0;   // draws kept exactly as the last populate() left them
+    uint32_t commandsRemoved = 0;  // draws dropped with their mesh, material or entity
+    uint32_t visibilityWrites = 0; // draws the frame's cull showed or hid
+    uint32_t slotRefreshes = 0;    // draws pointed at a mesh data slot that had moved
+    uint64_t uploadBytes = 0;      // written by bindBatch() as the frame's batches are drawn
+    bool rebuilt = false;          // whether every draw was made again from scratch
+};
+
 /**
  * @brief Gathers the scene's meshes into indirect draw batches for whoever wants to draw them
  *
  * Owns the batches for every frame in flight and the traversal that fills them, so a pass supplies
  * only a frustum and then issues its own draws. Which descriptor sets are bound, what the push
  * constants hold and how the batch is drawn stay with the pass, since those follow its shader.
+ *
+ * The draws persist from frame to frame. Every mesh that has a material keeps one indirect command,
+ * written when the mesh or material is bound and only touched again when CHANNEL_MESH_BINDING or
+ * CHANNEL_MATERIAL_BINDING records it, when it is added or removed, or when SceneRenderData moves its
+ * mesh slot. A transform change costs nothing here, the model matrix lives in the mesh's slot.
+ *
+ * A frame's cull only flips the instance count of the draws whose visibility changed since that frame
+ * was last populated, so the indirect buffers keep their layout and an upload copies just the commands
+ * that were written. Meshes are culled in bulk against the scene's cached WorldBounds, or through its
+ * SceneBVH when the frustum is narrow.
  */
 class SceneGeometryDraw {
   public:
@@ -30,15 +66,27 @@ class SceneGeometryDraw {
     SceneGeometryDraw &operator=(const SceneGeometryDraw &) = delete;
 
     /**
-     * @brief Refill this frame's batches with the meshes a frustum keeps
+     * @brief Show the meshes a frustum keeps in this frame's batches and hide the rest
      * @param scene Scene to traverse
      * @param frustum Frustum to cull against, or nullptr to keep every mesh
      * @param frameInFlight Frame whose batches are filled
+     * @param cull How the frustum is tested against the scene
      */
-    void populate(Scene &scene, const Frustum *frustum, uint32_t frameInFlight);
+    void populate(Scene &scene, const Frustum *frustum, uint32_t frameInFlight, GeometryCull cull = GeometryCull::SCAN);
 
     /**
-     * @brief The batches filled for a frame, each holding at least one draw
+     * @brief Show the rows a cull already kept in this frame's batches and hide the rest
+     * @param scene Scene to traverse
+     * @param visible One bit per row of the scene's WorldBounds, as ViewCulling fills it
+     * @param frameInFlight Frame whose batches are filled
+     */
+    void populate(Scene &scene, const VisibilityMask &visible, uint32_t frameInFlight);
+
+    /**
+     * @brief The batches a frame shows something in
+     *
+     * A batch holds every draw it was given, the hidden ones with an instance count of zero, so it is
+     * drawn with getDrawCount() commands as before.
      * @param frameInFlight Frame to read
      * @return The batches, in no particular order
      */
@@ -51,11 +99,76 @@ class SceneGeometryDraw {
      */
     void bindBatch(CommandBuffer *commandBuffer, MDIBatch *batch);
 
+    /**
+     * @brief What the last populate() rebuilt and reused, with what the batches bound since uploaded
+     */
+    const GeometryDrawStats &getLastStats() const { return m_lastStats; }
+
+  private:
+    // where an entity's draw sits, the same in every frame's batches
+    struct DrawRef {
+        ecs::Entity entity = ecs::ENTITY_NULL; // ENTITY_NULL while the entity index has no draw
+        uint32_t batch = 0;                    // index into m_batchKeys
+        uint32_t draw = 0;
+    };
+
+    struct FrameDraws {
+        std::unique_ptr<MDIBatchMap> batchMap;
+        std::vector<MDIBatch *> batches;   // by batch index
+        std::vector<MDIBatch *> populated; // the batches the last populate() left something visible in
+        std::vector<ecs::Entity> shown;    // what the last populate() showed, to hide what it no longer keeps
+        std::vector<uint32_t> shownStamp;  // per entity index, the stamp of the populate() that last showed it
+        uint32_t stamp = 0;
+    };
+
+    /**
+     * @brief Brings the draws up to date with what changed in the scene since the last populate()
+     */
+    void sync(Scene &scene);
+
+    /**
+     * @brief Subscribes to a scene's mesh and material components coming and going
+     */
+    void attach(Scene &scene);
+
+    /**
+     * @brief Adds, rewrites or drops an entity's draw to match its components
+     */
+    void resolve(Scene &scene, ecs::Entity entity);
+
+    void dropDraw(uint32_t entityIndex);
+    void clearDraws();
+
+    /**
+     * @brief Shows the entities visit() hands over in a frame's batches, and hides the ones it no longer does
+     */
+    template <typename Visit>
+    void show(Scene &scene, uint32_t frameInFlight, bool checkTransform, Visit &&visit);
+
   private:
     RenderContext m_rc;
 
-    std::vector<std::unique_ptr<MDIBatchMap>> m_batchMaps;
-    std::vector<std::vector<MDIBatch *>> m_populatedBatches;
+    std::vector<FrameDraws> m_frames;
+    std::vector<MDIBatchKey> m_batchKeys;
+    std::unordered_map<MDIBatchKey, uint32_t, MDIBatchKeyHash> m_batchIndex;
+
+    Scene *m_scene = nullptr;
+    std::vector<ecs::SignalConnection> m_connections;
+    ecs::Bookmark m_meshBookmark;
+    ecs::Bookmark m_materialBookmark;
+    uint64_t m_meshSlotVersion = 0;
+    bool m_needsRebuild = true;
+
+    std::vector<DrawRef> m_drawOf;         // by entity index
+    std::vector<ecs::Entity> m_pending;    // components added or removed since the last sync
+    std::vector<ecs::Entity> m_unresolved; // meshes still loading, asked again on every sync
+    std::vector<ecs::Entity> m_retry;      // m_unresolved while it is being walked
+
+    std::vector<ecs::Entity> m_shownScratch;
+    GeometryDrawStats m_lastStats;
+
+    VisibilityMask m_visible;            // scratch for the scan, one bit per WorldBounds row
+    std::vector<ecs::Entity> m_bvhHits; // scratch for the BVH walk
 };
 
 } // namespace Rapture
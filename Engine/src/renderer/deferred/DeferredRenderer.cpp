@@ -6,6 +6,7 @@
 #include "core/utils/Log.h"
 #include "core/utils/TracyProfiler.h"
 
+#include "scene/components/Components.h"
 #include "scene/components/TerrainComponent.h"
 #include "core/jobs/InplaceFunction.h"
 #include "core/jobs/Job.h"
@@ -48,6 +49,8 @@ DeferredRenderer::~DeferredRenderer()
     m_skyboxPass.reset();
     m_lightingPass.reset();
     m_ambientOcclusionPass.reset();
+    m_depthPyramidPass.reset();
+    m_drawCullPass.reset();
     m_gbufferPass.reset();
     m_dynamicDiffuseGI.reset();
     m_rtInstanceData.reset();
@@ -258,6 +261,8 @@ void DeferredRenderer::recreateRenderPasses()
     m_skyboxPass.reset();
     m_lightingPass.reset();
     m_ambientOcclusionPass.reset();
+    m_depthPyramidPass.reset();
+    m_drawCullPass.reset();
     m_gbufferPass.reset();
 
     VkFormat presentFormat = m_sceneRenderTarget->getFormat();
@@ -269,6 +274,10 @@ void DeferredRenderer::recreateRenderPasses()
 
     m_gbufferPass = std::make_unique<GBufferPass>(m_width, m_height, framesInFlight);
 
+    m_drawCullPass = std::make_unique<DrawCullPass>(framesInFlight);
+    m_depthPyramidPass =
+        std::make_unique<DepthPyramidPass>(static_cast<uint32_t>(m_width), static_cast<uint32_t>(m_height), framesInFlight);
+
     m_ambientOcclusionPass = std::make_unique<GroundTruthAmbientOcclusionPass>(static_cast<uint32_t>(m_width),
                                                                                static_cast<uint32_t>(m_height), framesInFlight);
 
@@ -364,6 +373,10 @@ void DeferredRenderer::recordCommandBuffer(CommandBuffer *commandBuffer, Scene &
                 staleShadows.insert(shadowSettings.begin(), shadowSettings.end());
             }
 
+            // every view of the frame is gathered first so the scene is culled for all of them in one pass
+            m_views.clear();
+
+            m_staleShadowMaps.clear();
             for (auto [entity, shadowComp] : registry.read<ShadowComponent>().with<TransformComponent>()) {
                 ecs::EntityAccessor lightEntity(entity, &registry);
                 if (Light_tryReadLight(lightEntity) == nullptr) {
@@ -374,28 +387,46 @@ void DeferredRenderer::recordCommandBuffer(CommandBuffer *commandBuffer, Scene &
 
                 ShadowMap *shadowMap = renderData != nullptr ? renderData->getShadowMap(entity) : nullptr;
                 if (shadowMap != nullptr && shouldUpdateShadow) {
-                    auto shadowBuffer = shadowMap->recordSecondary(activeScene, m_currentFrame);
-                    if (shadowBuffer) {
-                        shadowMap->beginDynamicRendering(commandBuffer);
-                        commandBuffer->executeSecondary(*shadowBuffer);
-                        shadowMap->endDynamicRendering(commandBuffer);
-                    }
+                    m_staleShadowMaps.push_back({shadowMap, m_views.addView(shadowMap->getFrustum().getPlanes())});
                 }
             }
 
             // a cascade follows the camera, so it is re-rendered every frame regardless
+            m_cascadedShadowMaps.clear();
             for (auto [entity, lightComp, transformComp, shadowComp] :
                  registry.read<DirectionalLightComponent, TransformComponent, CascadedShadowComponent>()) {
-                bool shouldUpdateShadow = true;
-
                 CascadedShadowMap *cascadedShadowMap = renderData != nullptr ? renderData->getCascadedShadowMap(entity) : nullptr;
-                if (cascadedShadowMap != nullptr && shouldUpdateShadow) {
-                    auto shadowBuffer = cascadedShadowMap->recordSecondary(activeScene, m_currentFrame, terrain);
-                    if (shadowBuffer) {
-                        cascadedShadowMap->beginDynamicRendering(commandBuffer);
-                        commandBuffer->executeSecondary(*shadowBuffer);
-                        cascadedShadowMap->endDynamicRendering(commandBuffer);
-                    }
+                if (cascadedShadowMap != nullptr) {
+                    m_cascadedShadowMaps.push_back(
+                        {cascadedShadowMap, m_views.addView(cascadedShadowMap->getFrustum().getPlanes())});
+                }
+            }
+
+            const CameraComponent *cameraComp = camera.isValid() ? camera.tryRead<CameraComponent>() : nullptr;
+            if (cameraComp != nullptr && activeScene.getSettings().frustumCullingEnabled && !settings.useGPUCulling()) {
+                m_cameraView = m_views.addView(cameraComp->frustum.getPlanes());
+            } else {
+                m_cameraView = ViewCulling::NO_VIEW;
+            }
+
+            m_views.cull(activeScene.worldBounds().view());
+
+            for (const auto &[shadowMap, view] : m_staleShadowMaps) {
+                auto shadowBuffer = shadowMap->recordSecondary(activeScene, m_currentFrame, m_views.getVisibility(view));
+                if (shadowBuffer) {
+                    shadowMap->beginDynamicRendering(commandBuffer);
+                    commandBuffer->executeSecondary(*shadowBuffer);
+                    shadowMap->endDynamicRendering(commandBuffer);
+                }
+            }
+
+            for (const auto &[cascadedShadowMap, view] : m_cascadedShadowMaps) {
+                auto shadowBuffer =
+                    cascadedShadowMap->recordSecondary(activeScene, m_currentFrame, terrain, m_views.getVisibility(view));
+                if (shadowBuffer) {
+                    cascadedShadowMap->beginDynamicRendering(commandBuffer);
+                    commandBuffer->executeSecondary(*shadowBuffer);
+                    cascadedShadowMap->endDynamicRendering(commandBuffer);
                 }
             }
         }
@@ -406,6 +437,7 @@ void DeferredRenderer::recordCommandBuffer(CommandBuffer *commandBuffer, Scene &
 
         RenderPassContext context = buildPassContext(activeScene, camera, imageIndex, settings);
         context.terrain = terrain;
+        context.cameraVisibility = m_views.getVisibility(m_cameraView);
 
         const bool drawSkybox = m_skyboxPass->hasActiveSkybox();
 
@@ -456,6 +488,16 @@ void DeferredRenderer::recordCommandBuffer(CommandBuffer *commandBuffer, Scene &
         }
         // Here we wait for all of them to be finished (if in parallel)
 
+        // the GBuffer's draws were recorded against the culled buffers, which are filled here before it renders
+        const bool gpuCulling = gbufferBuffer != nullptr && settings.useGPUCulling();
+        if (gpuCulling) {
+            RAPTURE_PROFILE_GPU_SCOPE(commandBuffer->getCommandBufferVk(), "Draw Cull Pass");
+            Texture *pyramid = m_depthPyramidPass->getPreviousPyramid(m_currentFrame, camera.getEntity());
+            m_drawCullPass->record(context, commandBuffer, m_gbufferPass->getGeometry()->batches(m_currentFrame), pyramid,
+                                   m_depthPyramidPass->getLevelCount(), m_depthPyramidPass->getDepthWidth(),
+                                   m_depthPyramidPass->getDepthHeight());
+        }
+
         if (gbufferBuffer) {
             RAPTURE_PROFILE_GPU_SCOPE(commandBuffer->getCommandBufferVk(), "GBuffer Pass");
             m_gbufferPass->beginRendering(context, commandBuffer);
@@ -463,6 +505,14 @@ void DeferredRenderer::recordCommandBuffer(CommandBuffer *commandBuffer, Scene &
             m_gbufferPass->endRendering(commandBuffer);
         }
 
+        // a pyramid is only worth its dispatches while the next frame culls with it
+        if (gpuCulling) {
+            RAPTURE_PROFILE_GPU_SCOPE(commandBuffer->getCommandBufferVk(), "Depth Pyramid Pass");
+            m_depthPyramidPass->execute(context, commandBuffer);
+        } else {
+            m_depthPyramidPass->invalidate();
+        }
+
         {
             RAPTURE_PROFILE_GPU_SCOPE(commandBuffer->getCommandBufferVk(), "Ambient Occlusion Pass");
             m_ambientOcclusionPass->execute(context, commandBuffer);
@@ -4,21 +4,28 @@
 #include "renderer/Renderer.h"
 
 #include "core/events/EventSignal.h"
+#include "renderer/FrustumCulling.h"
 #include "renderer/RtInstanceData.h"
 #include "renderer/gi/ddgi/DynamicDiffuseGI.h"
 #include "renderer/passes/CompositePass.h"
+#include "renderer/passes/DepthPyramidPass.h"
+#include "renderer/passes/DrawCullPass.h"
 #include "renderer/deferred/GBufferPass.h"
 #include "renderer/passes/GroundTruthAmbientOcclusionPass.h"
 #include "renderer/deferred/LightingPass.h"
 #include "renderer/passes/SkyboxPass.h"
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace Rapture {
 
 struct StaticMeshComponent;
 struct TransformComponent;
 struct LightComponent;
+class ShadowMap;
+class CascadedShadowMap;
 
 class DeferredRenderer : public Renderer {
 
@@ -55,6 +62,8 @@ class DeferredRenderer : public Renderer {
 
   private:
     std::unique_ptr<GBufferPass> m_gbufferPass;
+    std::unique_ptr<DrawCullPass> m_drawCullPass;         // culls the GBuffer's draws when GPU culling is on
+    std::unique_ptr<DepthPyramidPass> m_depthPyramidPass; // the GBuffer depth reduced for next frame's cull
     std::unique_ptr<GroundTruthAmbientOcclusionPass> m_ambientOcclusionPass;
     std::unique_ptr<LightingPass> m_lightingPass;
     std::unique_ptr<SkyboxPass> m_skyboxPass;
@@ -76,6 +85,12 @@ class DeferredRenderer : public Renderer {
     ecs::Bookmark m_shadowLightBookmark;
     ecs::Bookmark m_shadowSettingsBookmark;
 
+    // the frame's camera and shadow views, culled together before any of them is recorded
+    ViewCulling m_views;
+    uint32_t m_cameraView = ViewCulling::NO_VIEW;
+    std::vector<std::pair<ShadowMap *, uint32_t>> m_staleShadowMaps;
+    std::vector<std::pair<CascadedShadowMap *, uint32_t>> m_cascadedShadowMaps;
+
     EventConnection m_swapchainRecreatedConn;
 
     bool m_giActive = true;
@@ -7,6 +7,7 @@
 #include "assets/asset_manager/AssetImportConfig.h"
 #include "core/ecs/entity_accessor.h"
 #include "core/utils/TracyProfiler.h"
+#include "renderer/RenderSettings.h"
 #include "renderer/generators/terrain/TerrainGenerator.h"
 #include "renderer/generators/terrain/TerrainTypes.h"
 #include "scene/components/Components.h"
@@ -157,7 +158,8 @@ CommandBuffer *GBufferPass::record(const RenderPassContext &context, const Secon
         recordTerrainCommands(commandBuffer, activeScene, camera, *terrain, currentFrame);
     }
 
-    recordEntityCommands(commandBuffer, activeScene, camera, currentFrame);
+    const bool gpuCulling = context.settings != nullptr && context.settings->useGPUCulling();
+    recordEntityCommands(commandBuffer, activeScene, camera, context.cameraVisibility, gpuCulling, currentFrame);
 
     commandBuffer->end();
 
@@ -165,7 +167,7 @@ CommandBuffer *GBufferPass::record(const RenderPassContext &context, const Secon
 }
 
 void GBufferPass::recordEntityCommands(CommandBuffer *secondaryCb, Scene &activeScene, ecs::EntityAccessor camera,
-                                       uint32_t currentFrame)
+                                       const VisibilityMask *visibility, bool gpuCulling, uint32_t currentFrame)
 {
     RAPTURE_PROFILE_FUNCTION();
 
@@ -185,18 +187,24 @@ void GBufferPass::recordEntityCommands(CommandBuffer *secondaryCb, Scene &active
     scissor.extent = {static_cast<uint32_t>(m_width), static_cast<uint32_t>(m_height)};
     vkCmdSetScissor(secondaryCb->getCommandBufferVk(), 0, 1, &scissor);
 
-    const CameraComponent *cameraComp = nullptr;
+    if (visibility != nullptr) {
+        // culled by the renderer together with the shadow views
+        m_geometry->populate(activeScene, *visibility, currentFrame);
+    } else {
+        const CameraComponent *cameraComp = nullptr;
 
-    if (camera.isValid()) {
-        cameraComp = camera.tryRead<CameraComponent>();
-    }
+        if (camera.isValid()) {
+            cameraComp = camera.tryRead<CameraComponent>();
+        }
 
-    const Frustum *frustum = nullptr;
-    if (cameraComp != nullptr && activeScene.getSettings().frustumCullingEnabled) {
-        frustum = &cameraComp->frustum;
-    }
+        // with GPU culling every draw is shown here and DrawCullPass culls them before the frame draws
+        const Frustum *frustum = nullptr;
+        if (cameraComp != nullptr && activeScene.getSettings().frustumCullingEnabled && !gpuCulling) {
+            frustum = &cameraComp->frustum;
+        }
 
-    m_geometry->populate(activeScene, frustum, currentFrame);
+        m_geometry->populate(activeScene, frustum, currentFrame);
+    }
 
     // bind descriptor sets
     m_rc->descriptorManager->bindSet(0, secondaryCb, m_pipeline); // camera stuff
@@ -248,6 +256,14 @@ void GBufferPass::recordEntityCommands(CommandBuffer *secondaryCb, Scene &active
         vkCmdPushConstants(secondaryCb->getCommandBufferVk(), pipeline->getPipelineLayoutVk(), stageFlags, 0,
                            sizeof(GBufferPushConstants), &pushConstants);
 
+        // the culled commands and their count are only written once the frame runs, before the GBuffer renders
+        if (gpuCulling && batch->prepareCullTargets()) {
+            vkCmdDrawIndexedIndirectCount(secondaryCb->getCommandBufferVk(), batch->getCulledIndirectBuffer()->getBufferVk(), 0,
+                                          batch->getDrawCountBuffer()->getBufferVk(), 0, batch->getDrawCount(),
+                                          sizeof(VkDrawIndexedIndirectCommand));
+            continue;
+        }
+
         // Execute multi-draw indirect
         auto indirectBuffer = batch->getIndirectBuffer();
         if (indirectBuffer) {
@@ -70,6 +70,11 @@ class GBufferPass : public RenderPass {
      */
     std::vector<Texture *> getDepthTextures() const;
 
+    /**
+     * @brief The batches this pass draws, for the passes that prepare their draws on the GPU
+     */
+    SceneGeometryDraw *getGeometry() const { return m_geometry.get(); }
+
     // Getters for bindless texture indices for current frame
     uint32_t getNormalTextureIndex() const { return m_normalTextureIndices[m_currentFrame]; }
     uint32_t getAlbedoTextureIndex() const { return m_albedoTextureIndices[m_currentFrame]; }
@@ -100,8 +105,9 @@ class GBufferPass : public RenderPass {
     void recordTerrainCommands(CommandBuffer *secondaryCb, Scene &activeScene, ecs::EntityAccessor camera, TerrainGenerator &terrain,
                                uint32_t currentFrame);
 
-    // Record entity rendering only
-    void recordEntityCommands(CommandBuffer *secondaryCb, Scene &activeScene, ecs::EntityAccessor camera, uint32_t currentFrame);
+    // Record entity rendering only, drawing the GPU culled commands when gpuCulling is set
+    void recordEntityCommands(CommandBuffer *secondaryCb, Scene &activeScene, ecs::EntityAccessor camera,
+                              const VisibilityMask *visibility, bool gpuCulling, uint32_t currentFrame);
 
     void transitionToShaderReadableLayout(CommandBuffer *primaryCb, uint32_t currentFrame);
 
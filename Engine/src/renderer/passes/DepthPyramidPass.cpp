@@ -0,0 +1,217 @@
+#include "DepthPyramidPass.h"
+
+#include "core/utils/EnginePaths.h"
+
+#include "app/Application.h"
+#include "assets/asset_manager/AssetImportConfig.h"
+#include "assets/asset_manager/AssetManager.h"
+#include "core/utils/Log.h"
+#include "core/utils/TracyProfiler.h"
+#include "core/utils/rp_assert.h"
+#include "gpu/command_buffers/CommandBuffer.h"
+#include "gpu/descriptors/DescriptorManager.h"
+#include "renderer/DrawCulling.h"
+
+#include <algorithm>
+#include <glm/glm.hpp>
+
+namespace Rapture {
+
+// DownsampleMip.cs.glsl
+struct DownsamplePushConstants {
+    alignas(4) uint32_t sourceTextureIndex;
+    alignas(4) int32_t sourceMip;
+    alignas(8) glm::ivec2 sourceSize;
+    alignas(8) glm::ivec2 outputSize;
+};
+
+static constexpr uint32_t DOWNSAMPLE_LOCAL_SIZE = 8;
+
+DepthPyramidPass::DepthPyramidPass(uint32_t width, uint32_t height, uint32_t framesInFlight)
+    : m_width(width), m_height(height), m_framesInFlight(framesInFlight),
+      m_levelCount(DepthPyramid::levelCount(width, height))
+{
+    m_rc = &Application::getInstance().getVulkanContext().getRenderContext();
+    m_builtFrom.assign(framesInFlight, ecs::ENTITY_NULL);
+
+    loadShaders();
+    createTextures();
+    createDescriptorSets();
+}
+
+DepthPyramidPass::~DepthPyramidPass()
+{
+    m_levelSets.clear();
+    m_pyramids.clear();
+    m_pipeline.reset();
+}
+
+void DepthPyramidPass::loadShaders()
+{
+    auto shaderPath = EnginePaths::shaderDirectory();
+
+    ShaderImportConfig shaderConfig;
+    shaderConfig.compileInfo.includePath = shaderPath / "glsl";
+    shaderConfig.compileInfo.macros.push_back({"DOWNSAMPLE_REDUCTION_MAX"});
+
+    auto asset = AssetManager::importAsset(shaderPath / "glsl/DownsampleMip.cs.glsl", shaderConfig);
+    m_shader = asset ? asset.get()->getUnderlyingAsset<Shader>() : nullptr;
+    if (m_shader != nullptr) {
+        m_shaderAssets.push_back(std::move(asset));
+    }
+
+    RP_ASSERT(m_shader != nullptr, "Depth pyramid shader failed to load");
+    if (m_shader == nullptr) {
+        RP_CORE_ERROR("Depth pyramid shader failed to load");
+        return;
+    }
+
+    ComputePipelineConfiguration pipelineConfig;
+    pipelineConfig.shader = m_shader;
+    m_pipeline = std::make_shared<ComputePipeline>(pipelineConfig);
+}
+
+void DepthPyramidPass::createTextures()
+{
+    TextureSpecification spec;
+    spec.width = std::max(1u, m_width / 2);
+    spec.height = std::max(1u, m_height / 2);
+    spec.format = TextureFormat::R32F;
+    spec.type = TextureType::TEXTURE2D;
+    spec.filter = TextureFilter::Nearest;
+    spec.wrap = TextureWrap::ClampToEdge;
+    spec.srgb = false;
+    spec.storageImage = true;
+    spec.mipLevels = m_levelCount;
+
+    m_pyramids.reserve(m_framesInFlight);
+    for (uint32_t frame = 0; frame < m_framesInFlight; ++frame) {
+        m_pyramids.push_back(std::make_unique<Texture>(spec));
+        m_pyramids.back()->getBindlessIndex();
+    }
+}
+
+void DepthPyramidPass::createDescriptorSets()
+{
+    DescriptorSetBindings bindings;
+    bindings.setNumber = 4;
+
+    DescriptorSetBinding outputBinding = {};
+    outputBinding.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    outputBinding.location = DescriptorSetBindingLocation::CUSTOM_0;
+    outputBinding.useStorageImageInfo = true;
+    bindings.bindings.push_back(outputBinding);
+
+    m_levelSets.resize(m_framesInFlight);
+    for (uint32_t frame = 0; frame < m_framesInFlight; ++frame) {
+        m_levelSets[frame].reserve(m_levelCount);
+        for (uint32_t level = 0; level < m_levelCount; ++level) {
+            auto set = std::make_unique<DescriptorSet>(bindings);
+            set->getTextureBinding(DescriptorSetBindingLocation::CUSTOM_0)->addStorageMip(*m_pyramids[frame], level);
+            m_levelSets[frame].push_back(std::move(set));
+        }
+    }
+}
+
+Texture *DepthPyramidPass::getPreviousPyramid(uint32_t frameInFlight, ecs::Entity camera) const
+{
+    if (m_framesInFlight == 0 || camera == ecs::ENTITY_NULL) {
+        return nullptr;
+    }
+
+    uint32_t previous = (frameInFlight + m_framesInFlight - 1) % m_framesInFlight;
+    return m_builtFrom[previous] == camera ? m_pyramids[previous].get() : nullptr;
+}
+
+void DepthPyramidPass::invalidate()
+{
+    std::fill(m_builtFrom.begin(), m_builtFrom.end(), ecs::ENTITY_NULL);
+}
+
+void DepthPyramidPass::onResize(uint32_t width, uint32_t height)
+{
+    if (width == m_width && height == m_height) {
+        return;
+    }
+
+    // the pyramids and their level sets may still be read by frames in flight
+    Application::getInstance().getVulkanContext().waitIdle();
+
+    m_levelSets.clear();
+    m_pyramids.clear();
+
+    m_width = width;
+    m_height = height;
+    m_levelCount = DepthPyramid::levelCount(width, height);
+
+    createTextures();
+    createDescriptorSets();
+
+    // nothing was built at the new size yet
+    invalidate();
+}
+
+void DepthPyramidPass::updateResources(const RenderPassContext &context)
+{
+    m_resources.clear();
+
+    // the pyramid is moved between layouts a level at a time while it is built, so record() owns it
+    ComputeResource depth;
+    depth.texture = context.targets->depthStencil;
+    depth.access = ComputeResourceAccess::READ;
+    m_resources.push_back(depth);
+}
+
+void DepthPyramidPass::record(const RenderPassContext &context, CommandBuffer *commandBuffer)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    const uint32_t frame = context.frameInFlight;
+    if (!m_pipeline || context.targets->depthStencil == nullptr || frame >= m_pyramids.size()) {
+        return;
+    }
+
+    Texture &pyramid = *m_pyramids[frame];
+    VkCommandBuffer cmd = commandBuffer->getCommandBufferVk();
+
+    // every level is written before it is read, the last cull that read this pyramid only has to finish
+    VkImageMemoryBarrier toGeneral = pyramid.getImageMemoryBarrier(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0,
+                                                                   VK_ACCESS_SHADER_WRITE_BIT);
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &toGeneral);
+
+    m_pipeline->bind(cmd);
+    m_rc->descriptorManager->bindSet(3, commandBuffer, m_pipeline);
+
+    DownsamplePushConstants pushConstants{};
+    pushConstants.sourceTextureIndex = context.targets->depthStencil->getBindlessIndex();
+    pushConstants.sourceMip = 0;
+    pushConstants.sourceSize = glm::ivec2(m_width, m_height);
+
+    for (uint32_t level = 0; level < m_levelCount; ++level) {
+        pushConstants.outputSize = glm::max(pushConstants.sourceSize / 2, glm::ivec2(1));
+
+        m_levelSets[frame][level]->bind(cmd, m_pipeline);
+        vkCmdPushConstants(cmd, m_pipeline->getPipelineLayoutVk(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DownsamplePushConstants),
+                           &pushConstants);
+        vkCmdDispatch(cmd, groupCount(static_cast<uint32_t>(pushConstants.outputSize.x), DOWNSAMPLE_LOCAL_SIZE),
+                      groupCount(static_cast<uint32_t>(pushConstants.outputSize.y), DOWNSAMPLE_LOCAL_SIZE), 1);
+
+        // the level is the next one's source and stays readable for the cull, the rest are still GENERAL
+        VkImageMemoryBarrier toRead =
+            pyramid.getImageMemoryBarrier(VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                          VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+        toRead.subresourceRange.baseMipLevel = level;
+        toRead.subresourceRange.levelCount = 1;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                             nullptr, 1, &toRead);
+
+        pushConstants.sourceTextureIndex = pyramid.getBindlessIndex();
+        pushConstants.sourceMip = static_cast<int32_t>(level);
+        pushConstants.sourceSize = pushConstants.outputSize;
+    }
+
+    m_builtFrom[frame] = context.camera.getEntity();
+}
+
+} // namespace Rapture
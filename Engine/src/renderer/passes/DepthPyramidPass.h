@@ -0,0 +1,78 @@
+#ifndef RAPTURE__DEPTH_PYRAMID_PASS_H
+#define RAPTURE__DEPTH_PYRAMID_PASS_H
+
+#include "assets/asset_manager/AssetHandle.h"
+#include "core/ecs/common.h"
+#include "gpu/descriptors/DescriptorSet.h"
+#include "gpu/pipelines/ComputePipeline.h"
+#include "gpu/shaders/Shader.h"
+#include "gpu/textures/Texture.h"
+#include "renderer/passes/ComputePass.h"
+
+#include <memory>
+#include <vector>
+
+namespace Rapture {
+
+struct RenderContext;
+
+/**
+ * @brief Reduces the frame's depth into a pyramid of farthest depths, for next frame's occlusion cull
+ *
+ * Level 0 is half the depth buffer and each level after it half the one before, down to a single
+ * texel, built one DownsampleMip dispatch per level. DepthPyramid in renderer/DrawCulling.h builds
+ * the same pyramid on the CPU.
+ */
+class DepthPyramidPass : public ComputePass {
+  public:
+    DepthPyramidPass(uint32_t width, uint32_t height, uint32_t framesInFlight);
+    ~DepthPyramidPass();
+
+    void onResize(uint32_t width, uint32_t height) override;
+
+    /**
+     * @brief The pyramid the frame before this one built, for the occlusion test
+     * @param frameInFlight The frame about to be culled
+     * @param camera The camera it is rendered from
+     * @return The pyramid, or nullptr if the previous frame built none from this camera
+     */
+    Texture *getPreviousPyramid(uint32_t frameInFlight, ecs::Entity camera) const;
+
+    /**
+     * @brief Forgets every pyramid built so far, for when a frame goes by without one
+     */
+    void invalidate();
+
+    uint32_t getLevelCount() const { return m_levelCount; }
+    uint32_t getDepthWidth() const { return m_width; }
+    uint32_t getDepthHeight() const { return m_height; }
+
+  protected:
+    void record(const RenderPassContext &context, CommandBuffer *commandBuffer) override;
+    void updateResources(const RenderPassContext &context) override;
+
+  private:
+    void loadShaders();
+    void createTextures();
+    void createDescriptorSets();
+
+  private:
+    const RenderContext *m_rc = nullptr;
+
+    Shader *m_shader = nullptr;
+    std::vector<AssetRef> m_shaderAssets;
+    std::shared_ptr<ComputePipeline> m_pipeline;
+
+    std::vector<std::unique_ptr<Texture>> m_pyramids;
+    std::vector<std::vector<std::unique_ptr<DescriptorSet>>> m_levelSets; // per frame, one per level
+    std::vector<ecs::Entity> m_builtFrom; // per frame, the camera its pyramid was built for, ENTITY_NULL if none
+
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_framesInFlight;
+    uint32_t m_levelCount;
+};
+
+} // namespace Rapture
+
+#endif // RAPTURE__DEPTH_PYRAMID_PASS_H
@@ -0,0 +1,212 @@
+#include "DrawCullPass.h"
+
+#include "core/utils/EnginePaths.h"
+
+#include "app/Application.h"
+#include "assets/asset_manager/AssetImportConfig.h"
+#include "assets/asset_manager/AssetManager.h"
+#include "core/utils/Log.h"
+#include "core/utils/TracyProfiler.h"
+#include "gpu/command_buffers/CommandBuffer.h"
+#include "gpu/descriptors/DescriptorManager.h"
+#include "gpu/textures/Texture.h"
+#include "renderer/DrawCulling.h"
+#include "renderer/MDIBatch.h"
+#include "scene/Scene.h"
+#include "scene/components/Components.h"
+#include "scene/render_data/SceneRenderData.h"
+
+#include <algorithm>
+#include <glm/glm.hpp>
+
+namespace Rapture {
+
+// DrawCull.cs.glsl, shared by all three stages
+struct DrawCullPushConstants {
+    alignas(4) uint32_t drawCount;
+    alignas(4) uint32_t sourceCommandBufferIndex;
+    alignas(4) uint32_t culledCommandBufferIndex;
+    alignas(4) uint32_t batchInfoBufferIndex;
+    alignas(4) uint32_t boundsBufferIndex;
+    alignas(4) uint32_t meshSSBOIndex;
+    alignas(4) uint32_t cameraSSBOIndex;
+    alignas(4) uint32_t cameraSlotIndex;
+    alignas(4) uint32_t frustumBufferIndex;
+    alignas(4) uint32_t pyramidTextureIndex;
+    alignas(4) uint32_t pyramidLevels;
+    alignas(4) uint32_t flagBufferIndex;
+    alignas(4) uint32_t groupCountBufferIndex;
+    alignas(4) uint32_t drawCountBufferIndex;
+    alignas(8) glm::ivec2 depthSize;
+};
+
+static constexpr const char *STAGE_MACROS[] = {"DRAW_CULL_STAGE_CULL", "DRAW_CULL_STAGE_SCAN", "DRAW_CULL_STAGE_COMPACT"};
+
+// one stage's writes in front of the next stage's reads and writes
+static void s_computeBarrier(VkCommandBuffer cmd)
+{
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+                         nullptr, 0, nullptr);
+}
+
+DrawCullPass::DrawCullPass(uint32_t framesInFlight) : m_framesInFlight(framesInFlight)
+{
+    m_rc = &Application::getInstance().getVulkanContext().getRenderContext();
+
+    m_flagBuffers.resize(framesInFlight);
+    m_groupCountBuffers.resize(framesInFlight);
+    m_scratchCapacity.assign(framesInFlight, 0);
+
+    loadShaders();
+}
+
+DrawCullPass::~DrawCullPass()
+{
+    m_flagBuffers.clear();
+    m_groupCountBuffers.clear();
+    for (auto &pipeline : m_pipelines) {
+        pipeline.reset();
+    }
+}
+
+void DrawCullPass::loadShaders()
+{
+    auto shaderPath = EnginePaths::shaderDirectory();
+
+    for (uint32_t stage = 0; stage < STAGE_COUNT; ++stage) {
+        ShaderImportConfig shaderConfig;
+        shaderConfig.compileInfo.includePath = shaderPath / "glsl";
+        shaderConfig.compileInfo.macros.push_back({STAGE_MACROS[stage]});
+
+        auto asset = AssetManager::importAsset(shaderPath / "glsl/DrawCull.cs.glsl", shaderConfig);
+        Shader *shader = asset ? asset.get()->getUnderlyingAsset<Shader>() : nullptr;
+        if (shader == nullptr) {
+            RP_CORE_ERROR("Draw cull shader failed to load for {}", STAGE_MACROS[stage]);
+            return;
+        }
+        m_shaderAssets.push_back(std::move(asset));
+        m_shaders[stage] = shader;
+
+        ComputePipelineConfiguration pipelineConfig;
+        pipelineConfig.shader = shader;
+        m_pipelines[stage] = std::make_shared<ComputePipeline>(pipelineConfig);
+    }
+}
+
+void DrawCullPass::reserveScratch(uint32_t frameInFlight, uint32_t drawCount)
+{
+    if (m_scratchCapacity[frameInFlight] >= drawCount) {
+        return;
+    }
+
+    // doubling keeps a growing scene from reallocating every frame
+    uint32_t capacity = std::max(drawCount, std::max(m_scratchCapacity[frameInFlight] * 2, culling::DRAW_CULL_GROUP_SIZE));
+    uint32_t groups = (capacity + culling::DRAW_CULL_GROUP_SIZE - 1) / culling::DRAW_CULL_GROUP_SIZE;
+
+    VmaAllocator allocator = Application::getInstance().getVulkanContext().getVmaAllocator();
+    m_flagBuffers[frameInFlight] = std::make_unique<StorageBuffer>(capacity * sizeof(uint32_t), BufferUsage::STATIC, allocator);
+    m_groupCountBuffers[frameInFlight] = std::make_unique<StorageBuffer>(groups * sizeof(uint32_t), BufferUsage::STATIC, allocator);
+    m_scratchCapacity[frameInFlight] = capacity;
+}
+
+void DrawCullPass::record(const RenderPassContext &context, CommandBuffer *commandBuffer, std::span<MDIBatch *const> batches,
+                          Texture *pyramid, uint32_t pyramidLevels, uint32_t depthWidth, uint32_t depthHeight)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    if (!m_pipelines[STAGE_CULL] || !m_pipelines[STAGE_SCAN] || !m_pipelines[STAGE_COMPACT] || batches.empty()) {
+        return;
+    }
+
+    const uint32_t frame = context.frameInFlight;
+    const CameraComponent *camera = context.camera.isValid() ? context.camera.tryRead<CameraComponent>() : nullptr;
+    if (camera == nullptr || frame >= m_framesInFlight) {
+        return;
+    }
+
+    m_frustum.update(camera->camera.getProjectionMatrix(), camera->camera.getViewMatrix());
+    m_frustum.uploadFrustum(frame);
+
+    auto &renderData = *(context.scene->getRenderData());
+    uint32_t cameraSlot = renderData.getCameraSlot(context.camera.getEntity());
+
+    DrawCullPushConstants pushConstants{};
+    pushConstants.meshSSBOIndex = renderData.getMeshes().getDescriptorIndex(frame);
+    pushConstants.cameraSSBOIndex = renderData.getCameras().getDescriptorIndex(frame);
+    pushConstants.cameraSlotIndex = (cameraSlot != UINT32_MAX) ? cameraSlot : 0;
+    pushConstants.frustumBufferIndex = m_frustum.getBindlessIndex(frame);
+    pushConstants.pyramidTextureIndex = pyramid != nullptr ? pyramid->getBindlessIndex() : UINT32_MAX;
+    pushConstants.pyramidLevels = pyramid != nullptr ? pyramidLevels : 0;
+    pushConstants.depthSize = glm::ivec2(depthWidth, depthHeight);
+
+    // sized once for the largest batch, a buffer replaced halfway through would still be read by the batches before it
+    uint32_t largest = 0;
+    for (MDIBatch *batch : batches) {
+        largest = std::max(largest, batch->getDrawCount());
+    }
+    reserveScratch(frame, largest);
+
+    VkCommandBuffer cmd = commandBuffer->getCommandBufferVk();
+    bool recorded = false;
+
+    for (MDIBatch *batch : batches) {
+        const uint32_t drawCount = batch->getDrawCount();
+        auto culledBuffer = batch->getCulledIndirectBuffer();
+        auto countBuffer = batch->getDrawCountBuffer();
+        if (drawCount == 0 || !culledBuffer || !countBuffer) {
+            continue;
+        }
+
+        // the scratch is shared by the frame's batches, the previous batch must be done with it
+        if (recorded) {
+            s_computeBarrier(cmd);
+        }
+
+        pushConstants.drawCount = drawCount;
+        pushConstants.sourceCommandBufferIndex = batch->getIndirectBuffer()->getBindlessIndex();
+        pushConstants.culledCommandBufferIndex = culledBuffer->getBindlessIndex();
+        pushConstants.batchInfoBufferIndex = batch->getBatchInfoBuffer()->getBindlessIndex();
+        pushConstants.boundsBufferIndex = batch->getBoundsBuffer()->getBindlessIndex();
+        pushConstants.flagBufferIndex = m_flagBuffers[frame]->getBindlessIndex();
+        pushConstants.groupCountBufferIndex = m_groupCountBuffers[frame]->getBindlessIndex();
+        pushConstants.drawCountBufferIndex = countBuffer->getBindlessIndex();
+
+        const uint32_t groups = (drawCount + culling::DRAW_CULL_GROUP_SIZE - 1) / culling::DRAW_CULL_GROUP_SIZE;
+
+        for (uint32_t stage = 0; stage < STAGE_COUNT; ++stage) {
+            const std::shared_ptr<ComputePipeline> &pipeline = m_pipelines[stage];
+            if (stage != STAGE_CULL) {
+                s_computeBarrier(cmd);
+            }
+
+            pipeline->bind(cmd);
+            if (stage == STAGE_CULL) {
+                m_rc->descriptorManager->bindSet(0, commandBuffer, pipeline); // camera
+                m_rc->descriptorManager->bindSet(2, commandBuffer, pipeline); // mesh data
+            }
+            m_rc->descriptorManager->bindSet(3, commandBuffer, pipeline); // bindless buffers and the pyramid
+
+            vkCmdPushConstants(cmd, pipeline->getPipelineLayoutVk(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DrawCullPushConstants),
+                               &pushConstants);
+            vkCmdDispatch(cmd, stage == STAGE_SCAN ? 1 : groups, 1, 1);
+        }
+        recorded = true;
+    }
+
+    if (!recorded) {
+        return;
+    }
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0,
+                         nullptr, 0, nullptr);
+}
+
+} // namespace Rapture
@@ -0,0 +1,89 @@
+#ifndef RAPTURE__DRAW_CULL_PASS_H
+#define RAPTURE__DRAW_CULL_PASS_H
+
+#include "assets/asset_manager/AssetHandle.h"
+#include "gpu/buffers/StorageBuffer.h"
+#include "gpu/pipelines/ComputePipeline.h"
+#include "gpu/shaders/Shader.h"
+#include "renderer/Frustum.h"
+#include "renderer/passes/RenderPassContext.h"
+
+#include <array>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace Rapture {
+
+class CommandBuffer;
+class MDIBatch;
+class Texture;
+struct RenderContext;
+
+/**
+ * @brief Culls the camera's draws on the GPU and compacts the survivors for vkCmdDrawIndexedIndirectCount
+ *
+ * Every draw of a batch is tested against the camera frustum and, when the frame before built one, the
+ * depth pyramid of its depth seen through last frame's view-projection. The commands that pass are
+ * copied in their original order into the batch's culled indirect buffer and counted into its draw count
+ * buffer, see MDIBatch::prepareCullTargets(). culling::cullDraws() is the CPU reference of the same cull.
+ *
+ * The pyramid is a frame old, so a draw that was hidden last frame and steps into view this one is
+ * drawn a frame late.
+ */
+class DrawCullPass {
+  public:
+    explicit DrawCullPass(uint32_t framesInFlight);
+    ~DrawCullPass();
+
+    DrawCullPass(const DrawCullPass &) = delete;
+    DrawCullPass &operator=(const DrawCullPass &) = delete;
+
+    /**
+     * @brief Records the cull of every batch, then makes the results readable to indirect draws
+     * @param context The frame being rendered
+     * @param commandBuffer The primary buffer, recorded into before the draws that read the results
+     * @param batches The batches the frame draws, each already uploaded with its cull targets prepared
+     * @param pyramid Last frame's depth pyramid, or nullptr to cull against the frustum alone
+     * @param pyramidLevels Levels in the pyramid
+     * @param depthWidth Width of the depth buffer the pyramid was reduced from
+     * @param depthHeight Height of the depth buffer the pyramid was reduced from
+     */
+    void record(const RenderPassContext &context, CommandBuffer *commandBuffer, std::span<MDIBatch *const> batches,
+                Texture *pyramid, uint32_t pyramidLevels, uint32_t depthWidth, uint32_t depthHeight);
+
+  private:
+    enum Stage {
+        STAGE_CULL,
+        STAGE_SCAN,
+        STAGE_COMPACT,
+        STAGE_COUNT
+    };
+
+    void loadShaders();
+
+    /**
+     * @brief Grows a frame's scratch buffers to hold a batch of this many draws
+     */
+    void reserveScratch(uint32_t frameInFlight, uint32_t drawCount);
+
+  private:
+    const RenderContext *m_rc = nullptr;
+
+    std::array<Shader *, STAGE_COUNT> m_shaders{};
+    std::array<std::shared_ptr<ComputePipeline>, STAGE_COUNT> m_pipelines;
+    std::vector<AssetRef> m_shaderAssets;
+
+    Frustum m_frustum; // the camera's planes, uploaded per frame in flight
+
+    // per frame in flight, reused by every batch of the frame one after another
+    std::vector<std::unique_ptr<StorageBuffer>> m_flagBuffers;       // one word per draw
+    std::vector<std::unique_ptr<StorageBuffer>> m_groupCountBuffers; // one word per group of draws
+    std::vector<uint32_t> m_scratchCapacity;
+
+    uint32_t m_framesInFlight;
+};
+
+} // namespace Rapture
+
+#endif // RAPTURE__DRAW_CULL_PASS_H
@@ -11,6 +11,7 @@ class Scene;
 class SceneRenderTarget;
 class TerrainGenerator;
 class Texture;
+class VisibilityMask;
 struct RenderSettings;
 
 /**
@@ -44,6 +45,9 @@ struct RenderPassContext {
     const RenderSettings *settings = nullptr;
     TerrainGenerator *terrain = nullptr;
 
+    /// WorldBounds rows the camera keeps, culled with the frame's other views; nullptr when the camera is not culled
+    const VisibilityMask *cameraVisibility = nullptr;
+
     uint32_t frameInFlight = 0; ///< indexes per-frame-in-flight resources
     uint32_t imageIndex = 0;    ///< image of the render target being written
 };
@@ -160,10 +160,11 @@ SceneQueryResult SceneQueryRenderer::query(Scene &scene, ecs::EntityAccessor cam
     const glm::mat4 projection = cameraComp->camera.getProjectionMatrix();
 
     // Always culled, and to the region rather than to the camera. A mesh outside the region cannot
-    // cover a pixel inside it, so this narrows what is drawn without narrowing the answer.
+    // cover a pixel inside it, so this narrows what is drawn without narrowing the answer. The region
+    // is usually a few pixels wide, so walking the BVH beats testing every mesh.
     Frustum regionFrustum;
     regionFrustum.update(s_regionProjection(projection, viewportWidth, viewportHeight, region), view);
-    m_geometry->populate(scene, &regionFrustum, 0);
+    m_geometry->populate(scene, &regionFrustum, 0, GeometryCull::BVH);
 
     const glm::mat4 viewProj = projection * view;
 
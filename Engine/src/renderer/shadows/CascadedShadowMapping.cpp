@@ -287,7 +287,8 @@ std::vector<CascadeData> CascadedShadowMap::calculateCascades(const glm::vec3 &l
     return cascadeData;
 }
 
-CommandBuffer *CascadedShadowMap::recordSecondary(Scene &activeScene, uint32_t currentFrame, TerrainGenerator *terrain)
+CommandBuffer *CascadedShadowMap::recordSecondary(Scene &activeScene, uint32_t currentFrame, TerrainGenerator *terrain,
+                                                  const VisibilityMask *visible)
 {
     RAPTURE_PROFILE_FUNCTION();
 
@@ -339,29 +340,27 @@ CommandBuffer *CascadedShadowMap::recordSecondary(Scene &activeScene, uint32_t c
     m_rc->descriptorManager->bindSet(0, commandBuffer, m_pipeline);
     m_rc->descriptorManager->bindSet(2, commandBuffer, m_pipeline);
 
-    // Get entities with TransformComponent and StaticMeshComponent for rendering
-    // First pass: Populate MDI batches with mesh data
-    for (auto [entity, transform, meshComp] : registry.read<TransformComponent, StaticMeshComponent>()) {
+    // First pass: Populate MDI batches with the meshes inside the frustum covering every cascade
+    auto addCaster = [&](ecs::Entity entity) {
+        const StaticMeshComponent *staticMesh = registry.tryRead<StaticMeshComponent>(entity);
 
         // Skip invalid or loading meshes
-        if (!meshComp.mesh || meshComp.isLoading) {
-            continue;
+        if (!staticMesh || !staticMesh->mesh || staticMesh->isLoading) {
+            return;
         }
+        const StaticMeshComponent &meshComp = *staticMesh;
 
         // Check if mesh has valid buffers
         if (!meshComp.mesh->getVertexBuffer() || !meshComp.mesh->getIndexBuffer()) {
-            continue;
+            return;
         }
 
-        // Update world bounding box if transform changed
-        registry.write<StaticMeshComponent>(entity, 0)->updateWorldBoundingBox(transform);
-
         // Get buffer allocation info to determine batch
         auto vboAlloc = meshComp.mesh->getVertexAllocation();
         auto iboAlloc = meshComp.mesh->getIndexAllocation();
 
         if (!vboAlloc || !iboAlloc) {
-            continue;
+            return;
         }
 
         // Get or create batch for this VBO/IBO arena combination
@@ -371,6 +370,17 @@ CommandBuffer *CascadedShadowMap::recordSecondary(Scene &activeScene, uint32_t c
 
         // Add mesh to batch (materialIndex = 0 for shadow pass)
         batch->addObject(*meshComp.mesh, renderData->getMeshSlot(entity), 0);
+    };
+
+    if (visible != nullptr) {
+        const WorldBounds &bounds = activeScene.worldBounds();
+        visible->forEachVisible([&](uint32_t row) { addCaster(bounds.getEntity(row)); });
+    } else {
+        m_casters.clear();
+        activeScene.bvh().queryFrustum(m_shadowFrustum.getPlanes(), m_casters);
+        for (ecs::Entity entity : m_casters) {
+            addCaster(entity);
+        }
     }
 
     // Second pass: Upload batch data and render using MDI
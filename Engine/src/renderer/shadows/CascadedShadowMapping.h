@@ -17,6 +17,7 @@
 #include "renderer/generators/terrain/TerrainCuller.h"
 #include "renderer/generators/terrain/TerrainGenerator.h"
 #include "renderer/Frustum.h"
+#include "renderer/FrustumCulling.h"
 
 #include "renderer/MDIBatch.h"
 
@@ -52,7 +53,12 @@ class CascadedShadowMap {
     CascadedShadowMap(float width, float height, uint32_t numCascades, float lambda);
     ~CascadedShadowMap();
 
-    CommandBuffer *recordSecondary(Scene &activeScene, uint32_t currentFrame, TerrainGenerator *terrain);
+    /**
+     * @brief Records every cascade's casters and terrain into one multiview secondary buffer
+     * @param visible The WorldBounds rows getFrustum() keeps, as ViewCulling fills them; nullptr queries the scene's BVH
+     */
+    CommandBuffer *recordSecondary(Scene &activeScene, uint32_t currentFrame, TerrainGenerator *terrain,
+                                   const VisibilityMask *visible = nullptr);
 
     void beginDynamicRendering(CommandBuffer *commandBuffer);
     void endDynamicRendering(CommandBuffer *commandBuffer);
@@ -86,6 +92,11 @@ class CascadedShadowMap {
 
     std::vector<glm::mat4> getLightViewProjections() const { return m_lightViewProjections; }
 
+    /**
+     * @brief The light frustum covering every cascade, which the casters are culled against
+     */
+    const Frustum &getFrustum() const { return m_shadowFrustum; }
+
     float getLambda() const { return m_lambda; }
     void setLambda(float lambda) { m_lambda = std::clamp(lambda, 0.0f, 1.0f); }
 
@@ -150,6 +161,7 @@ class CascadedShadowMap {
 
     std::vector<AssetRef> m_shaderAssets;
     Frustum m_shadowFrustum;
+    std::vector<ecs::Entity> m_casters;
     std::vector<TerrainCullBuffers> m_terrainShadowBuffers;
 
     VmaAllocator m_allocator;
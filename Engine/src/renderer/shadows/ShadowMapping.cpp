@@ -7,6 +7,7 @@
 #include "scene/systems/Transforms.h"
 #include "core/utils/Log.h"
 #include "core/utils/TracyProfiler.h"
+#include "renderer/FrustumCulling.h"
 #include "renderer/shadows/ShadowCommon.h"
 #include "app/Application.h"
 
@@ -203,7 +204,7 @@ void ShadowMap::updateViewMatrix(ecs::EntityAccessor light, const TransformCompo
     m_lightViewProjection = shadowMapData.lightViewProjection;
 }
 
-CommandBuffer *ShadowMap::recordSecondary(Scene &activeScene, uint32_t currentFrame)
+CommandBuffer *ShadowMap::recordSecondary(Scene &activeScene, uint32_t currentFrame, const VisibilityMask *visible)
 {
     RAPTURE_PROFILE_FUNCTION();
 
@@ -238,27 +239,30 @@ CommandBuffer *ShadowMap::recordSecondary(Scene &activeScene, uint32_t currentFr
     // via pushconstants for now, since it is only one matrix
     // m_rc->descriptorManager->bindSet(DescriptorSetBindingLocation::SHADOW_MATRICES_UBO, commandBuffer, m_pipeline);
 
-    // Get entities with TransformComponent and StaticMeshComponent for rendering
+    const WorldBounds &bounds = activeScene.worldBounds();
+    if (visible == nullptr) {
+        culling::cull(m_frustum.getPlanes(), bounds.view(), m_visible);
+        visible = &m_visible;
+    }
+
+    // Only the rows the light frustum kept are looked up in the registry
     auto &registry = activeScene.getRegistry();
-    for (auto [entity, transform, meshComp] : registry.read<TransformComponent, StaticMeshComponent>()) {
+    visible->forEachVisible([&](uint32_t row) {
         RAPTURE_PROFILE_SCOPE("Draw Shadow Mesh");
 
+        ecs::Entity entity = bounds.getEntity(row);
+        const StaticMeshComponent *staticMesh = registry.tryRead<StaticMeshComponent>(entity);
+        const TransformComponent *transform = registry.tryRead<TransformComponent>(entity);
+
         // Skip invalid or loading meshes
-        if (!meshComp.mesh || meshComp.isLoading) {
-            continue;
+        if (!staticMesh || !transform || !staticMesh->mesh || staticMesh->isLoading) {
+            return;
         }
+        const StaticMeshComponent &meshComp = *staticMesh;
 
         // Check if mesh has valid buffers
         if (!meshComp.mesh->getVertexBuffer() || !meshComp.mesh->getIndexBuffer()) {
-            continue;
-        }
-
-        // Update world bounding box if transform changed
-        registry.write<StaticMeshComponent>(entity, 0)->updateWorldBoundingBox(transform);
-
-        // Perform frustum culling
-        if (m_frustum.testBoundingBox(meshComp.worldBoundingBox) == FrustumResult::Outside) {
-            continue;
+            return;
         }
 
         // Get the vertex buffer layout
@@ -276,7 +280,7 @@ CommandBuffer *ShadowMap::recordSecondary(Scene &activeScene, uint32_t currentFr
 
         // Push the model matrix as a push constant
         ShadowMappingPushConstants pushConstants{};
-        pushConstants.model = transform.world;
+        pushConstants.model = transform->worldMatrix();
         pushConstants.shadowMatrix = m_lightViewProjection;
 
         // Get push constant stage flags from shader
@@ -299,7 +303,7 @@ CommandBuffer *ShadowMap::recordSecondary(Scene &activeScene, uint32_t currentFr
 
         // Draw the mesh
         vkCmdDrawIndexed(commandBuffer->getCommandBufferVk(), meshComp.mesh->getIndexCount(), 1, 0, 0, 0);
-    }
+    });
 
     commandBuffer->end();
 
@@ -12,6 +12,7 @@
 #include "gpu/descriptors/DescriptorSet.h"
 
 #include "renderer/Frustum.h"
+#include "renderer/FrustumCulling.h"
 
 #include "scene/Scene.h"
 
@@ -32,7 +33,11 @@ class ShadowMap {
     ShadowMap(float width, float height);
     ~ShadowMap();
 
-    CommandBuffer *recordSecondary(Scene &activeScene, uint32_t currentFrame);
+    /**
+     * @brief Records the shadow casters into a secondary buffer
+     * @param visible The WorldBounds rows getFrustum() keeps, as ViewCulling fills them; nullptr culls here
+     */
+    CommandBuffer *recordSecondary(Scene &activeScene, uint32_t currentFrame, const VisibilityMask *visible = nullptr);
     void beginDynamicRendering(CommandBuffer *commandBuffer);
     void endDynamicRendering(CommandBuffer *commandBuffer);
 
@@ -44,6 +49,8 @@ class ShadowMap {
 
     glm::mat4 getLightViewProjection() const { return m_lightViewProjection; }
 
+    const Frustum &getFrustum() const { return m_frustum; }
+
   private:
     void setupDynamicRenderingMemoryBarriers(CommandBuffer *commandBuffer);
     void transitionToShaderReadableLayout(CommandBuffer *commandBuffer);
@@ -66,6 +73,7 @@ class ShadowMap {
     VkRenderingAttachmentInfo m_depthAttachmentInfo{};
 
     Frustum m_frustum;
+    VisibilityMask m_visible; // used when the caller did not cull for us
 
     Shader *m_shader = nullptr;
     std::vector<AssetRef> m_shaderAssets;
@@ -112,6 +112,11 @@ bool Project::saveWorld(AssetHandle handle)
     return AssetManager::saveAsset(handle, getContentDirectory());
 }
 
+bool Project::cookWorld(AssetHandle handle)
+{
+    return AssetManager::cookAsset(handle, getCookedDirectory());
+}
+
 void Project::onUpdate(float dt)
 {
     for (const AssetPtr<World> &world : m_worlds) {
@@ -69,6 +69,13 @@ class Project {
      */
     bool saveWorld(AssetHandle handle);
 
+    /**
+     * @brief Writes a world into the cooked directory as a binary scene stream, its own asset staying text
+     * @param handle The world asset to write
+     * @return True if the cooked file was written
+     */
+    bool cookWorld(AssetHandle handle);
+
     /**
      * @brief Starts running a world and the scene it holds
      * @param world The world to activate
@@ -112,6 +119,7 @@ class Project {
     std::filesystem::path getCacheDirectory() const { return m_config.projectDirectory / ".cache"; }
     std::filesystem::path getBlobDirectory() const { return m_config.projectDirectory / "blobs"; }
     std::filesystem::path getContentDirectory() const { return m_config.projectDirectory / "content"; }
+    std::filesystem::path getCookedDirectory() const { return m_config.projectDirectory / "cooked"; }
     std::filesystem::path getThumbnailDirectory() const { return getCacheDirectory() / "thumbnails"; }
     std::string getProjectName() const { return m_config.name; }
 
@@ -16,6 +16,8 @@
 #include "scene/instances/SceneObject.h"
 #include "scene/instances/InstanceRegistry.h"
 #include "scene/SceneLoadContext.h"
+#include "scene/SceneLoadPlan.h"
+#include "scene/SceneSnapshot.h"
 
 #include "assets/asset_manager/AssetManager.h"
 #include "assets/asset_manager/ReservedAssets.h"
@@ -23,6 +25,7 @@
 #include "physics/PhysicsSystem.h"
 #include "scene/EntityCommon.h"
 #include "core/serialization/SerialDocument.h"
+#include "core/serialization/SerialStream.h"
 #include "app/Application.h"
 
 #include <memory>
@@ -39,6 +42,7 @@ static constexpr float DEFAULT_FLOOR_SIZE = 20.0f;
 static constexpr std::string_view KEY_FORMAT_VERSION = "formatVersion";
 static constexpr std::string_view KEY_NAME = "name";
 static constexpr std::string_view KEY_FRUSTUM_CULLING = "frustumCulling";
+static constexpr std::string_view KEY_PHYSICS_ON_WORKER = "physicsOnWorker";
 static constexpr std::string_view KEY_INSTANCES = "instances";
 
 Scene::Scene(const std::string &sceneName)
@@ -54,7 +58,10 @@ Scene::Scene(const std::string &sceneName)
     m_physics = std::make_unique<PhysicsSystem>();
 }
 
-Scene::~Scene() = default;
+Scene::~Scene()
+{
+    joinPhysics();
+}
 
 ecs::EntityAccessor Scene::createEntity(const std::string &name)
 {
@@ -148,8 +155,63 @@ void Scene::stepPhysics(float dt)
         return;
     }
 
-    m_physics->onUpdate(dt);
-    syncSimulatedTransforms();
+    joinPhysics();
+
+    const uint32_t steps = m_physics->advance(dt);
+    const float alpha = m_physics->getInterpolationAlpha();
+
+    if (!m_config.physicsOnWorker) {
+        if (steps > 0) {
+            m_physics->runSteps(steps, m_stepCapture);
+            takeStepCapture();
+        }
+        m_bodyInterpolation.place(alpha, m_registry, m_transforms);
+        return;
+    }
+
+    // what was just joined is a frame behind the clock, so it is drawn at the alpha it was planned at
+    m_bodyInterpolation.place(m_plannedAlpha, m_registry, m_transforms);
+    m_pendingSteps = steps;
+    m_plannedAlpha = alpha;
+}
+
+void Scene::joinPhysics()
+{
+    if (!m_stepsLaunched) {
+        return;
+    }
+
+    m_physics->waitForSteps();
+    m_stepsLaunched = false;
+    takeStepCapture();
+}
+
+bool Scene::queryPhysics(const physics::SceneQueryBatch &batch)
+{
+    if (m_physics == nullptr) {
+        return false;
+    }
+
+    joinPhysics();
+    return m_physics->queryBatch(batch);
+}
+
+void Scene::launchPhysics()
+{
+    if (m_physics == nullptr || m_pendingSteps == 0) {
+        return;
+    }
+
+    m_physics->launchSteps(m_pendingSteps, m_stepCapture);
+    m_pendingSteps = 0;
+    m_stepsLaunched = true;
+}
+
+void Scene::takeStepCapture()
+{
+    m_bodyInterpolation.capture(m_stepCapture, [](void *owner) -> const SimulatedTarget * {
+        return owner != nullptr ? &static_cast<const PhysicsBody3D *>(owner)->simulatedTarget() : nullptr;
+    });
 }
 
 void Scene::onUpdate(float dt)
@@ -160,6 +222,14 @@ void Scene::onUpdate(float dt)
         return;
     }
 
+    // nothing from here to the next stepPhysics touches the simulation, so its steps run meanwhile
+    launchPhysics();
+
+    // everything below reads world transforms straight out of the registry
+    m_transforms.flush();
+    m_worldBounds.refresh();
+    m_bvh.update(m_worldBounds);
+
     // Get current frame dimensions for camera updates
     auto &app = Application::getInstance();
     auto swapChain = app.getMainWindow().getSwapChain();
@@ -294,20 +364,6 @@ std::string Scene::getSceneName() const
     return m_config.sceneName;
 }
 
-void Scene::syncSimulatedTransforms()
-{
-    m_physics->getSimulatedStates(m_simulatedStates);
-
-    for (const physics::BodyState &state : m_simulatedStates) {
-        PhysicsBody3D *body = static_cast<PhysicsBody3D *>(state.owner);
-        if (body == nullptr) {
-            continue;
-        }
-
-        body->applySimulatedTransform(state.position, state.rotation);
-    }
-}
-
 uint32_t Scene::registerTick(Instance *instance, TickPhase phase)
 {
     return m_ticking[phase].insert(instance);
@@ -346,6 +402,8 @@ void Scene::destroyInstance(SceneObject *instance)
         return;
     }
 
+    // the bodies in the subtree leave the simulation with it
+    joinPhysics();
     parent->removeChild(instance);
 }
 
@@ -353,9 +411,7 @@ void Scene::serialize(WriteNode node) const
 {
     RAPTURE_PROFILE_FUNCTION();
 
-    node.set(KEY_FORMAT_VERSION, static_cast<uint64_t>(SCENE_FORMAT_VERSION));
-    node.set(KEY_NAME, std::string_view(m_config.sceneName));
-    node.set(KEY_FRUSTUM_CULLING, m_config.frustumCullingEnabled);
+    serializeSettings(node);
 
     WriteNode instances = node.addArray(KEY_INSTANCES);
     for (const auto &child : m_root->children()) {
@@ -363,26 +419,53 @@ void Scene::serialize(WriteNode node) const
     }
 }
 
+void Scene::serialize(SerialStreamWriter &writer) const
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    writer.writeMembers([this](WriteNode node) { serializeSettings(node); });
+
+    // one top level object in memory at a time, however large the scene
+    writer.beginArray(KEY_INSTANCES);
+    for (const auto &child : m_root->children()) {
+        writer.appendObject([&child](WriteNode node) { child->serialize(node); });
+    }
+    writer.end();
+}
+
+void Scene::serializeSettings(WriteNode node) const
+{
+    node.set(KEY_FORMAT_VERSION, static_cast<uint64_t>(SCENE_FORMAT_VERSION));
+    node.set(KEY_NAME, std::string_view(m_config.sceneName));
+    node.set(KEY_FRUSTUM_CULLING, m_config.frustumCullingEnabled);
+    node.set(KEY_PHYSICS_ON_WORKER, m_config.physicsOnWorker);
+}
+
 void Scene::clearInstances()
 {
+    joinPhysics();
+    m_bodyInterpolation.clear();
+    m_pendingSteps = 0;
+
     while (!m_root->children().empty()) {
         m_root->removeChild(m_root->children().front().get());
     }
 }
 
-SerialDocument Scene::snapshot() const
+SceneSnapshot Scene::snapshot() const
 {
-    SerialDocument builder;
-    serialize(builder.root());
+    RAPTURE_PROFILE_FUNCTION();
+
+    // never text, so floats are held as they are and the document is frozen rather than parsed back,
+    // and the freeze copies the keys, so they are only borrowed while it is written
+    SerialDocument document(SERIAL_FLOAT_NATIVE, SERIAL_KEYS_BORROWED);
+    serialize(document.root());
 
-    // a written document is write mode, so it is parsed back into one that can be read
-    return SerialDocument::parse(builder.toText());
+    return SceneSnapshot::capture(std::move(document), m_registry);
 }
 
-std::unique_ptr<Scene> Scene::deserialize(ReadNode node)
+std::unique_ptr<Scene> Scene::createFromSettings(ReadNode node)
 {
-    RAPTURE_PROFILE_FUNCTION();
-
     uint32_t formatVersion = static_cast<uint32_t>(node.child(KEY_FORMAT_VERSION).asU64(0));
     if (formatVersion != SCENE_FORMAT_VERSION) {
         RP_CORE_ERROR("cannot read a version {} scene, this build reads version {}", formatVersion, SCENE_FORMAT_VERSION);
@@ -391,19 +474,31 @@ std::unique_ptr<Scene> Scene::deserialize(ReadNode node)
 
     auto scene = std::make_unique<Scene>(std::string(node.child(KEY_NAME).asString("Untitled Scene")));
     scene->m_config.frustumCullingEnabled = node.child(KEY_FRUSTUM_CULLING).asBool(scene->m_config.frustumCullingEnabled);
+    scene->m_config.physicsOnWorker = node.child(KEY_PHYSICS_ON_WORKER).asBool(scene->m_config.physicsOnWorker);
 
     // the constructor seeds a default environment, which the document supplies again
     scene->clearInstances();
 
+    return scene;
+}
+
+std::unique_ptr<Scene> Scene::deserialize(ReadNode node)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    std::unique_ptr<Scene> scene = createFromSettings(node);
+    if (scene == nullptr) {
+        return nullptr;
+    }
+
     // the instances are the ones the document was written from, so they keep the ids it gave them
     SceneLoadContext context(false);
 
-    ReadNode instances = node.child(KEY_INSTANCES);
-    for (size_t i = 0; i < instances.size(); i++) {
-        if (SceneObject::loadSubtree(*scene->m_root, instances.at(i), context) == nullptr) {
-            RP_CORE_ERROR("scene '{}' could not be read", scene->m_config.sceneName);
-            return nullptr;
-        }
+    // every class is resolved before the first object is built, so a scene that cannot be read builds nothing
+    SceneLoadPlan plan = SceneLoadPlan::prepare(node.child(KEY_INSTANCES));
+    if (!plan.instantiate(*scene->m_root, context)) {
+        RP_CORE_ERROR("scene '{}' could not be read", scene->m_config.sceneName);
+        return nullptr;
     }
 
     context.finish();
@@ -421,15 +516,14 @@ static void s_mapInstancesById(const SceneObject &parent, std::unordered_map<Ins
 
 // Pre-order, so an instance is under its snapshot parent before its own children come looking for it.
 // Everything the snapshot names leaves the map, so what stays behind is what the scene gained since.
-static bool s_restoreSubtree(SceneObject &parent, ReadNode instances, std::unordered_map<InstanceId, SceneObject *> &live,
-                             SceneLoadContext &context)
+static bool s_restoreSubtree(SceneObject &parent, uint32_t count, std::span<const SceneSnapshot::ObjectRecord> records,
+                             size_t &cursor, std::unordered_map<InstanceId, SceneObject *> &live, SceneLoadContext &context)
 {
-    for (size_t i = 0; i < instances.size(); i++) {
-        ReadNode node = instances.at(i);
-        SceneObject::DocumentHeader header = SceneObject::readHeader(node);
+    for (uint32_t i = 0; i < count; i++) {
+        const SceneSnapshot::ObjectRecord &record = records[cursor++];
 
         SceneObject *instance = nullptr;
-        auto found = live.find(header.id);
+        auto found = live.find(record.id);
 
         if (found != live.end()) {
             instance = found->second;
@@ -439,9 +533,9 @@ static bool s_restoreSubtree(SceneObject &parent, ReadNode instances, std::unord
                 parent.addChild(instance->parent()->removeChild(instance));
             }
         } else {
-            std::unique_ptr<SceneObject> created = InstanceRegistry::createObject(header.className, *parent.scene(), header.name);
+            std::unique_ptr<SceneObject> created = InstanceRegistry::createObject(record.className, *parent.scene(), record.name);
             if (created == nullptr) {
-                RP_CORE_ERROR("no instance class named '{}', needed by '{}'", header.className, header.name);
+                RP_CORE_ERROR("no instance class named '{}', needed by '{}'", record.className, record.name);
                 return false;
             }
 
@@ -449,10 +543,10 @@ static bool s_restoreSubtree(SceneObject &parent, ReadNode instances, std::unord
             parent.addChild(std::move(created));
         }
 
-        instance->deserialize(node);
-        context.addInstance(header.id, instance);
+        instance->deserialize(record.fields);
+        context.addInstance(record.id, instance);
 
-        if (!s_restoreSubtree(*instance, header.children, live, context)) {
+        if (!s_restoreSubtree(*instance, record.childCount, records, cursor, live, context)) {
             return false;
         }
     }
@@ -475,33 +569,38 @@ static void s_destroyInstancesNotInSnapshot(SceneObject &parent, const std::unor
     }
 }
 
-// TODO: try holding the snapshot as a copy of the instances instead of a document, and restoring by
-// assigning those copies over the live ones. Every asset ref would go 1 -> 2 -> 1 and never reach 0,
-// so nothing can be evicted and reloaded across a restore. Measure it against reading the document.
-bool Scene::restoreFrom(ReadNode node)
+bool Scene::restoreFrom(const SceneSnapshot &snapshot)
 {
     RAPTURE_PROFILE_FUNCTION();
 
-    uint32_t formatVersion = static_cast<uint32_t>(node.child(KEY_FORMAT_VERSION).asU64(0));
-    if (formatVersion != SCENE_FORMAT_VERSION) {
-        RP_CORE_ERROR("cannot read a version {} scene, this build reads version {}", formatVersion, SCENE_FORMAT_VERSION);
+    if (snapshot.isEmpty()) {
+        RP_CORE_ERROR("cannot restore '{}' from an empty snapshot", m_config.sceneName);
         return false;
     }
 
+    ReadNode node = snapshot.sceneNode();
     m_config.sceneName = std::string(node.child(KEY_NAME).asString(m_config.sceneName));
     m_config.frustumCullingEnabled = node.child(KEY_FRUSTUM_CULLING).asBool(m_config.frustumCullingEnabled);
+    m_config.physicsOnWorker = node.child(KEY_PHYSICS_ON_WORKER).asBool(m_config.physicsOnWorker);
+
+    // bodies restored below are placed where the snapshot puts them, not where the last steps left them
+    joinPhysics();
+    m_bodyInterpolation.clear();
+    m_pendingSteps = 0;
 
     // instances dropped below take their GPU resources with them, and frames already submitted may
     // still be reading those
     Application::getInstance().getVulkanContext().waitIdle();
 
     std::unordered_map<InstanceId, SceneObject *> live;
+    live.reserve(snapshot.objects().size());
     s_mapInstancesById(*m_root, live);
 
     // an instance the snapshot holds keeps the id it was written under, restored or reused alike
     SceneLoadContext context(false);
 
-    if (!s_restoreSubtree(*m_root, node.child(KEY_INSTANCES), live, context)) {
+    size_t cursor = 0;
+    if (!s_restoreSubtree(*m_root, snapshot.rootChildCount(), snapshot.objects(), cursor, live, context)) {
         return false;
     }
 
@@ -509,6 +608,9 @@ bool Scene::restoreFrom(ReadNode node)
         s_destroyInstancesNotInSnapshot(*m_root, live);
     }
 
+    // what the fields were read into goes back to the exact values it held, caches worked out from them included
+    snapshot.restorePools(m_registry);
+
     // after the drop, so a reference the snapshot no longer holds is not resolved and then emptied
     context.finish();
 
@@ -539,7 +641,7 @@ void Scene::registerBLAS(ecs::Entity entity)
 
     TLASInstance instance;
     instance.blas = blas;
-    instance.transform = transform->world;
+    instance.transform = transform->worldMatrix();
     instance.entityID = entity;
     m_tlas->addInstance(instance);
     m_tlasDirty = true;
@@ -580,9 +682,9 @@ void Scene::updateTLAS()
     for (auto &instance : instances) {
         const TransformComponent *transform = m_registry.tryRead<TransformComponent>(instance.entityID);
 
-        if (transform != nullptr && transform->world != instance.transform) {
-            instance.transform = transform->world;
-            instanceUpdates.push_back({instanceIndex, transform->world});
+        if (transform != nullptr && transform->world != transform::toAffine(instance.transform)) {
+            instance.transform = transform->worldMatrix();
+            instanceUpdates.push_back({instanceIndex, instance.transform});
         }
         instanceIndex++;
     }
@@ -11,6 +11,10 @@
 #include "scene/EntityCommon.h"
 #include "scene/TickPhase.h"
 #include "scene/components/ChangeChannels.h"
+#include "scene/systems/BodyInterpolation.h"
+#include "scene/systems/SceneBVH.h"
+#include "scene/systems/TransformHierarchy.h"
+#include "scene/systems/WorldBounds.h"
 #include <array>
 #include <cstdint>
 #include <memory>
@@ -27,6 +31,8 @@ class Instance;
 class SceneComponent;
 class SceneObject;
 class SceneRenderData;
+class SceneSnapshot;
+class SerialStreamWriter;
 class PhysicsSystem;
 struct RenderContext;
 
@@ -35,6 +41,8 @@ static constexpr uint32_t SCENE_FORMAT_VERSION = 1;
 struct SceneSettings {
     std::string sceneName;
     bool frustumCullingEnabled = true;
+    // steps the simulation on a worker while the frame renders, trailing the clock by a frame
+    bool physicsOnWorker = false;
 };
 
 class Scene {
@@ -56,14 +64,49 @@ class Scene {
     void onUpdate(float dt);
 
     /**
-     * @brief Advances the rigid body simulation and writes the result back onto the transforms
+     * @brief Advances the simulation clock and places every moving body between its last two steps
+     *
+     * The steps due run here, or with physicsOnWorker set, alongside this frame's render, in which
+     * case what is placed is what the steps run alongside the last frame left.
      * @param dt Seconds to advance by
      */
     void stepPhysics(float dt);
 
+    /**
+     * @brief Waits for steps running on a worker and takes in what they left
+     *
+     * Anything that reads or changes the simulation outside stepPhysics() calls this first. Returns at
+     * once when no steps are running.
+     */
+    void joinPhysics();
+
+    /**
+     * @brief Runs a batch of scene queries against the simulation, joining any steps running first
+     *
+     * Owners in the results are the PhysicsBody3D each struck body belongs to.
+     * @param batch The queries and the arrays their results are written to
+     * @return False if the scene has no simulation or an output array is too small
+     */
+    bool queryPhysics(const physics::SceneQueryBatch &batch);
+
     ecs::Registry &getRegistry() { return m_registry; }
     const ecs::Registry &getRegistry() const { return m_registry; }
 
+    /**
+     * @brief The depth sorted table world transforms are propagated through
+     */
+    TransformHierarchy &transforms() { return m_transforms; }
+
+    /**
+     * @brief The cached world bounds of every mesh, refreshed in onUpdate once transforms are flushed
+     */
+    WorldBounds &worldBounds() { return m_worldBounds; }
+
+    /**
+     * @brief Bounding volume hierarchy over the world bounds, for culling and picking queries
+     */
+    SceneBVH &bvh() { return m_bvh; }
+
     /**
      * @brief Binds an entity of this scene to the registry that resolves it
      * @param entity The entity to wrap
@@ -146,6 +189,25 @@ class Scene {
      */
     void serialize(WriteNode node) const;
 
+    /**
+     * @brief Writes the scene's settings and its whole instance tree as text, one top level object at a time
+     * @param writer Writer with the scene's object open
+     */
+    void serialize(SerialStreamWriter &writer) const;
+
+    /**
+     * @brief Writes the scene's own settings, everything serialize writes but the instances
+     * @param node Cursor to write the scene's object into
+     */
+    void serializeSettings(WriteNode node) const;
+
+    /**
+     * @brief Builds a scene with no instances from the settings serializeSettings wrote
+     * @param node Cursor to the scene's object
+     * @return The new scene, or nullptr if the settings are from a format this build does not read
+     */
+    static std::unique_ptr<Scene> createFromSettings(ReadNode node);
+
     /**
      * @brief Builds a scene from a scene document
      * @param node Cursor to the scene's object
@@ -154,17 +216,17 @@ class Scene {
     static std::unique_ptr<Scene> deserialize(ReadNode node);
 
     /**
-     * @brief Captures this scene's current contents into a document it can be restored from
-     * @return The snapshot, which has to outlive the restoreFrom call that reads it
+     * @brief Captures this scene's current contents so they can be restored without going through text
+     * @return The snapshot
      */
-    SerialDocument snapshot() const;
+    SceneSnapshot snapshot() const;
 
     /**
      * @brief Reverts this scene to a snapshot, keeping every instance the snapshot and the scene share
-     * @param node Cursor to the scene's object, which has to outlive the call
+     * @param snapshot A snapshot this scene took, which has to outlive the call
      * @return True if the scene now matches the snapshot
      */
-    bool restoreFrom(ReadNode node);
+    bool restoreFrom(const SceneSnapshot &snapshot);
 
     /**
      * @brief Puts an entity's mesh into the TLAS, replacing the instance it already had
@@ -214,9 +276,14 @@ class Scene {
     void updateShadowViews(const glm::vec3 &cameraPosition, Camera3D *activeCamera);
 
     /**
-     * @brief Hands every body the simulation moved this step back to the node it drives
+     * @brief Starts the steps stepPhysics() planned on a worker, when it left any to run there
+     */
+    void launchPhysics();
+
+    /**
+     * @brief Hands the states the last run of steps left to the interpolation
      */
-    void syncSimulatedTransforms();
+    void takeStepCapture();
 
     /**
      * @brief Destroys every instance under the root, leaving the root itself
@@ -225,10 +292,17 @@ class Scene {
 
   private:
     ecs::Registry m_registry{CHANNEL_COUNT};
+    TransformHierarchy m_transforms{m_registry};
+    WorldBounds m_worldBounds{m_registry};
+    SceneBVH m_bvh;
     Environment *m_environment = nullptr;
     std::unique_ptr<SceneRenderData> m_renderData;
     std::unique_ptr<PhysicsSystem> m_physics;
-    std::vector<physics::BodyState> m_simulatedStates;
+    physics::StepCapture m_stepCapture;
+    BodyInterpolation m_bodyInterpolation;
+    uint32_t m_pendingSteps = 0; // planned by stepPhysics, launched when the frame renders
+    float m_plannedAlpha = 0.0f; // the clock's alpha when the launched steps were planned
+    bool m_stepsLaunched = false;
     Controller *m_activeController = nullptr;
     SceneSettings m_config;
 
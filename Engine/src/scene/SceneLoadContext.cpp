@@ -2,6 +2,12 @@
 
 namespace Rapture {
 
+void SceneLoadContext::reserve(size_t instanceCount)
+{
+    m_byDocumentId.reserve(m_byDocumentId.size() + instanceCount);
+    m_loaded.reserve(m_loaded.size() + instanceCount);
+}
+
 void SceneLoadContext::addInstance(InstanceId documentId, Instance *instance)
 {
     if (instance == nullptr) {
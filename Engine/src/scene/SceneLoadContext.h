@@ -25,6 +25,12 @@ class SceneLoadContext {
     SceneLoadContext(const SceneLoadContext &) = delete;
     SceneLoadContext &operator=(const SceneLoadContext &) = delete;
 
+    /**
+     * @brief Makes room for the instances a read is known to produce, so recording them does not rehash
+     * @param instanceCount How many instances the read will add
+     */
+    void reserve(size_t instanceCount);
+
     /**
      * @brief Records what a document id was read into
      * @param documentId The id the document gave the instance
@@ -46,6 +52,9 @@ class SceneLoadContext {
 
     /**
      * @brief Resolves every reference this read produced, then readies what it produced
+     *
+     * Runs once everything the read produces exists and has been handed to the systems that keep it,
+     * so a reference may name anything the read produced, wherever in the document it was written.
      */
     void finish();
 
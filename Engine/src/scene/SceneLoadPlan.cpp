@@ -0,0 +1,220 @@
+#include "SceneLoadPlan.h"
+
+#include "core/jobs/Counter.h"
+#include "core/jobs/JobSystem.h"
+#include "core/utils/Log.h"
+#include "core/utils/TracyProfiler.h"
+#include "scene/Scene.h"
+#include "scene/SceneLoadContext.h"
+
+#include <algorithm>
+
+namespace Rapture {
+
+static constexpr std::string_view KEY_ID = "id";
+
+// Top level objects one preparation job takes. A subtree is never split, so a document that keeps
+// everything under a few objects is prepared by as many jobs as it has of them.
+static constexpr size_t SCENE_LOAD_ROOTS_PER_JOB = 32;
+
+namespace {
+
+/**
+ * @brief What one job prepared, a run of consecutive top level objects and their subtrees
+ */
+struct PreparedRange {
+    std::vector<SceneLoadPlan::ObjectRecord> objects;
+    std::vector<SceneLoadPlan::ComponentRecord> components;
+
+    // the first class that could not be resolved, and the object that needed it
+    std::string_view missingClass;
+    std::string_view missingOwner;
+    bool missingIsComponent = false;
+    bool failed = false;
+};
+
+} // namespace
+
+static bool s_prepareSubtree(ReadNode node, PreparedRange &out)
+{
+    SceneObject::DocumentHeader header = SceneObject::readHeader(node);
+
+    SceneLoadPlan::ObjectRecord record;
+    record.factory = InstanceRegistry::findObjectFactory(header.className);
+    if (record.factory == nullptr) {
+        out.missingClass = header.className;
+        out.missingOwner = header.name;
+        return false;
+    }
+
+    record.className = header.className;
+    record.name = header.name;
+    record.id = header.id;
+    record.childCount = static_cast<uint32_t>(header.children.size());
+    record.firstComponent = static_cast<uint32_t>(out.components.size());
+    record.fields = node;
+
+    for (ReadNode entry : header.components.elements()) {
+        SceneLoadPlan::ComponentRecord component;
+        component.className = Instance::readClassName(entry);
+        component.factory = InstanceRegistry::findComponentFactory(component.className);
+        if (component.factory == nullptr) {
+            out.missingClass = component.className;
+            out.missingOwner = header.name;
+            out.missingIsComponent = true;
+            return false;
+        }
+
+        component.id = entry.child(KEY_ID).asU64(INVALID_INSTANCE_ID);
+        component.fields = entry;
+        out.components.push_back(component);
+    }
+
+    record.componentCount = static_cast<uint32_t>(out.components.size()) - record.firstComponent;
+    out.objects.push_back(record);
+
+    for (size_t i = 0; i < header.children.size(); i++) {
+        if (!s_prepareSubtree(header.children.at(i), out)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+SceneLoadPlan SceneLoadPlan::prepare(ReadNode objects)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    SceneLoadPlan plan;
+    const std::vector<ReadNode> roots = objects.elements();
+    plan.m_rootCount = static_cast<uint32_t>(roots.size());
+
+    const size_t rangeCount = std::max<size_t>((roots.size() + SCENE_LOAD_ROOTS_PER_JOB - 1) / SCENE_LOAD_ROOTS_PER_JOB, 1);
+    std::vector<PreparedRange> ranges(rangeCount);
+
+    auto prepareRange = [&roots](PreparedRange &range, size_t begin, size_t end) {
+        for (size_t i = begin; i < end && !range.failed; i++) {
+            range.failed = !s_prepareSubtree(roots[i], range);
+        }
+    };
+
+    if (rangeCount < 2 || jobs().getWorkerCount() == 0) {
+        prepareRange(ranges[0], 0, roots.size());
+    } else {
+        // every job only reads the document and the class registry, and writes its own range
+        Counter counter{};
+        counter.increment(static_cast<int32_t>(rangeCount));
+        for (size_t i = 0; i < rangeCount; i++) {
+            PreparedRange *range = &ranges[i];
+            const size_t begin = i * SCENE_LOAD_ROOTS_PER_JOB;
+            const size_t end = std::min(begin + SCENE_LOAD_ROOTS_PER_JOB, roots.size());
+
+            auto job = [&prepareRange, range, begin, end](JobContext &) { prepareRange(*range, begin, end); };
+            jobs().run(JobDeclaration(job, JobPriority::NORMAL, QueueAffinity::ANY, &counter, "Scene load prepare"));
+        }
+        jobs().waitFor(counter, 0);
+        plan.m_jobCount = static_cast<uint32_t>(rangeCount);
+    }
+
+    size_t objectCount = 0;
+    size_t componentCount = 0;
+    for (const PreparedRange &range : ranges) {
+        // the first failure in document order, the one a load object by object would have stopped at
+        if (range.failed) {
+            if (range.missingIsComponent) {
+                RP_CORE_ERROR("no scene component class named '{}', needed by '{}'", range.missingClass, range.missingOwner);
+            } else {
+                RP_CORE_ERROR("no scene object class named '{}', needed by '{}'", range.missingClass, range.missingOwner);
+            }
+            return plan;
+        }
+        objectCount += range.objects.size();
+        componentCount += range.components.size();
+    }
+
+    plan.m_objects.reserve(objectCount);
+    plan.m_components.reserve(componentCount);
+    for (const PreparedRange &range : ranges) {
+        const uint32_t componentOffset = static_cast<uint32_t>(plan.m_components.size());
+        for (ObjectRecord record : range.objects) {
+            record.firstComponent += componentOffset;
+            plan.m_objects.push_back(record);
+        }
+        plan.m_components.insert(plan.m_components.end(), range.components.begin(), range.components.end());
+    }
+
+    plan.m_isValid = true;
+    return plan;
+}
+
+// Pre-order, in the order a load object by object reads them: each object is parented and read, then its
+// components, then its children.
+static void s_instantiateSubtrees(Scene &scene, SceneObject &parent, uint32_t count,
+                                  std::span<const SceneLoadPlan::ObjectRecord> objects,
+                                  std::span<const SceneLoadPlan::ComponentRecord> components, size_t &cursor,
+                                  SceneLoadContext &context)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        const SceneLoadPlan::ObjectRecord &record = objects[cursor++];
+
+        std::unique_ptr<SceneObject> created = record.factory(scene, record.name);
+        SceneObject *self = created.get();
+        parent.addChild(std::move(created));
+        context.addInstance(record.id, self);
+        self->deserialize(record.fields);
+
+        if (context.remintsIds()) {
+            self->remintId();
+        }
+
+        for (const SceneLoadPlan::ComponentRecord &entry : components.subspan(record.firstComponent, record.componentCount)) {
+            std::unique_ptr<SceneComponent> component = entry.factory(scene, entry.className);
+            SceneComponent *raw = component.get();
+
+            // read before attaching so the component claims what it needs from its authored fields
+            component->deserialize(entry.fields);
+            context.addInstance(entry.id, raw);
+
+            if (context.remintsIds()) {
+                raw->remintId();
+            }
+
+            self->attachComponent(std::move(component));
+        }
+
+        s_instantiateSubtrees(scene, *self, record.childCount, objects, components, cursor, context);
+    }
+}
+
+bool SceneLoadPlan::instantiate(SceneObject &parent, SceneLoadContext &context) const
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    if (!m_isValid) {
+        return false;
+    }
+
+    Scene *scene = parent.scene();
+    if (scene == nullptr) {
+        RP_CORE_ERROR("a load instantiates into a scene, and '{}' is in none", parent.name());
+        return false;
+    }
+
+    // every object owns an entity, so the records cover at least the objects without growing
+    ecs::Registry &registry = scene->getRegistry();
+    registry.reserve(static_cast<uint32_t>(registry.getRecords().size() + m_objects.size()));
+    context.reserve(m_objects.size() + m_components.size());
+
+    // immediate handlers, the transform hierarchy's among them, still run as the objects are built,
+    // the deferrable ones run once over the whole batch after it
+    registry.deferConstructSignals();
+
+    size_t cursor = 0;
+    s_instantiateSubtrees(*scene, parent, m_rootCount, m_objects, m_components, cursor, context);
+
+    registry.flushConstructSignals();
+    return true;
+}
+
+} // namespace Rapture
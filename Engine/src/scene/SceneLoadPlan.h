@@ -0,0 +1,100 @@
+#ifndef RAPTURE__SCENE_LOAD_PLAN_H
+#define RAPTURE__SCENE_LOAD_PLAN_H
+
+#include "core/serialization/SerialDocument.h"
+#include "scene/instances/InstanceRegistry.h"
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace Rapture {
+
+class SceneLoadContext;
+class SceneObject;
+
+/**
+ * @brief A run of scene objects read out of a document into plain records, then instanced in one pass.
+ *
+ * Loading is split in two. Preparing walks the document, reads every object's header and resolves the class
+ * it names, and touches nothing but the document and the class registry, so the top level subtrees are
+ * prepared in parallel jobs. Instancing then builds the objects from the records on the calling thread, with
+ * the registry's deferrable construct handlers held back so they run once over the whole batch rather than
+ * once per component. References are left to the SceneLoadContext, which resolves them after both.
+ *
+ * A plan only points into its document, which has to outlive it.
+ */
+class SceneLoadPlan {
+  public:
+    /**
+     * @brief One component, read before there is one to read into
+     */
+    struct ComponentRecord {
+        SceneComponentFactory factory = nullptr;
+        std::string_view className;
+        InstanceId id = INVALID_INSTANCE_ID;
+        ReadNode fields;
+    };
+
+    /**
+     * @brief One scene object, in pre-order, so its children are the childCount subtrees that follow it
+     */
+    struct ObjectRecord {
+        SceneObjectFactory factory = nullptr;
+        std::string_view className;
+        std::string_view name;
+        InstanceId id = INVALID_INSTANCE_ID;
+        uint32_t childCount = 0;
+        uint32_t firstComponent = 0; // into components()
+        uint32_t componentCount = 0;
+        ReadNode fields;
+    };
+
+    /**
+     * @brief Prepares every object in an array of them, and their subtrees
+     * @param objects Cursor to the array, as Scene::serialize writes its instances
+     * @return The plan, invalid if the array names a class that is not registered
+     */
+    static SceneLoadPlan prepare(ReadNode objects);
+
+    bool isValid() const { return m_isValid; }
+
+    /**
+     * @brief Every object the plan holds, the top level ones and everything below them, in pre-order
+     */
+    std::span<const ObjectRecord> objects() const { return m_objects; }
+    std::span<const ComponentRecord> components() const { return m_components; }
+
+    /**
+     * @brief How many of the objects were elements of the array itself
+     */
+    uint32_t rootCount() const { return m_rootCount; }
+
+    /**
+     * @brief How many jobs the preparation was split into, zero if it ran on the calling thread
+     */
+    uint32_t jobCount() const { return m_jobCount; }
+
+    /**
+     * @brief Builds the objects and parents the top level ones to an object, in document order
+     *
+     * The deferrable construct handlers of the parent's scene are held back until everything is built.
+     * The context's finish is left to the caller, once whatever else the read produces is in place too.
+     * @param parent The object the top level objects are added to
+     * @param context The read the objects belong to
+     * @return False if the plan is invalid or the parent is in no scene
+     */
+    bool instantiate(SceneObject &parent, SceneLoadContext &context) const;
+
+  private:
+    std::vector<ObjectRecord> m_objects;
+    std::vector<ComponentRecord> m_components;
+    uint32_t m_rootCount = 0;
+    uint32_t m_jobCount = 0;
+    bool m_isValid = false;
+};
+
+} // namespace Rapture
+
+#endif // RAPTURE__SCENE_LOAD_PLAN_H
@@ -0,0 +1,83 @@
+#include "SceneSnapshot.h"
+
+#include "core/utils/TracyProfiler.h"
+#include "scene/components/Components.h"
+#include "scene/instances/SceneObject.h"
+
+#include <tuple>
+#include <type_traits>
+
+namespace Rapture {
+
+static constexpr std::string_view KEY_INSTANCES = "instances";
+
+/**
+ * @brief The component pools copied as they are, the plain data the scene objects' fields are written into
+ *
+ * Only types that hold nothing but values belong here. A pointer or a handle copied back could name
+ * something released while the scene was played.
+ */
+struct SceneSnapshot::PlainPools {
+    std::tuple<ecs::PoolImage<TransformComponent>, ecs::PoolImage<DirectionalLightComponent>,
+               ecs::PoolImage<PointLightComponent>, ecs::PoolImage<SpotLightComponent>, ecs::PoolImage<ShadowComponent>,
+               ecs::PoolImage<CascadedShadowComponent>>
+        images;
+};
+
+SceneSnapshot::SceneSnapshot() = default;
+SceneSnapshot::~SceneSnapshot() = default;
+SceneSnapshot::SceneSnapshot(SceneSnapshot &&other) noexcept = default;
+SceneSnapshot &SceneSnapshot::operator=(SceneSnapshot &&other) noexcept = default;
+
+SceneSnapshot SceneSnapshot::capture(SerialDocument document, const ecs::Registry &registry)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    SceneSnapshot snapshot;
+    if (!document.freeze()) {
+        return snapshot;
+    }
+
+    snapshot.m_document = std::move(document);
+
+    ReadNode instances = snapshot.m_document.rootView().child(KEY_INSTANCES);
+    snapshot.m_rootChildCount = static_cast<uint32_t>(instances.size());
+    snapshot.indexObjects(instances);
+
+    snapshot.m_pools = std::make_unique<PlainPools>();
+    std::apply(
+        [&](auto &...images) { ((images = registry.captureImage<typename std::decay_t<decltype(images)>::Component>()), ...); },
+        snapshot.m_pools->images);
+
+    return snapshot;
+}
+
+void SceneSnapshot::indexObjects(ReadNode objects)
+{
+    for (ReadNode node : objects.elements()) {
+        SceneObject::DocumentHeader header = SceneObject::readHeader(node);
+
+        ObjectRecord record;
+        record.className = header.className;
+        record.name = header.name;
+        record.id = header.id;
+        record.childCount = static_cast<uint32_t>(header.children.size());
+        record.fields = node;
+        m_objects.push_back(record);
+
+        indexObjects(header.children);
+    }
+}
+
+uint32_t SceneSnapshot::restorePools(ecs::Registry &registry) const
+{
+    if (m_pools == nullptr) {
+        return 0;
+    }
+
+    uint32_t written = 0;
+    std::apply([&](const auto &...images) { ((written += registry.restoreImage(images)), ...); }, m_pools->images);
+    return written;
+}
+
+} // namespace Rapture
@@ -0,0 +1,98 @@
+#ifndef RAPTURE__SCENE_SNAPSHOT_H
+#define RAPTURE__SCENE_SNAPSHOT_H
+
+#include "core/ecs/registry.h"
+#include "core/serialization/SerialDocument.h"
+#include "scene/instances/Instance.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace Rapture {
+
+/**
+ * @brief What a scene held at one moment, kept in memory so the scene can be put back the way it was.
+ *
+ * Taken when play starts and read back when it stops, so it is never text. The instances are written into
+ * a document that holds its floats as they are and is frozen rather than formatted and parsed again. Beside
+ * it is a flat pre-order list of every scene object, so the restore walks an array instead of looking each
+ * header up in the document, and a copy of every pool of plain data components, which the restore copies
+ * back in blocks.
+ */
+class SceneSnapshot {
+  public:
+    /**
+     * @brief One scene object, in pre-order, so its children are the childCount subtrees that follow it
+     */
+    struct ObjectRecord {
+        std::string_view className;
+        std::string_view name;
+        InstanceId id = INVALID_INSTANCE_ID;
+        uint32_t childCount = 0;
+        ReadNode fields;
+    };
+
+    SceneSnapshot();
+    ~SceneSnapshot();
+
+    SceneSnapshot(SceneSnapshot &&other) noexcept;
+    SceneSnapshot &operator=(SceneSnapshot &&other) noexcept;
+    SceneSnapshot(const SceneSnapshot &) = delete;
+    SceneSnapshot &operator=(const SceneSnapshot &) = delete;
+
+    /**
+     * @brief Takes a snapshot of a written scene document and the registry it was written from
+     * @param document The scene's document, written with native floats, which the snapshot freezes and keeps
+     * @param registry The registry whose plain data pools are copied
+     * @return The snapshot, empty if the document could not be frozen
+     */
+    static SceneSnapshot capture(SerialDocument document, const ecs::Registry &registry);
+
+    /**
+     * @brief Whether there is anything to restore
+     */
+    bool isEmpty() const { return !m_document.isReadable(); }
+
+    /**
+     * @brief Cursor to the scene's own object, for its settings
+     */
+    ReadNode sceneNode() const { return m_document.rootView(); }
+
+    /**
+     * @brief Every scene object under the root, in pre-order
+     */
+    std::span<const ObjectRecord> objects() const { return m_objects; }
+
+    /**
+     * @brief How many of the objects sit directly under the root
+     */
+    uint32_t rootChildCount() const { return m_rootChildCount; }
+
+    /**
+     * @brief Copies the pooled components back onto the entities that still hold them
+     * @param registry The registry the snapshot was taken from
+     * @return Number of components written
+     */
+    uint32_t restorePools(ecs::Registry &registry) const;
+
+  private:
+    struct PlainPools;
+
+    /**
+     * @brief Appends a record for every object in an array of them and, after each one, its subtree
+     * @param objects Cursor to the array
+     */
+    void indexObjects(ReadNode objects);
+
+    SerialDocument m_document;
+    std::vector<ObjectRecord> m_objects;
+    uint32_t m_rootChildCount = 0;
+    std::unique_ptr<PlainPools> m_pools;
+};
+
+} // namespace Rapture
+
+#endif // RAPTURE__SCENE_SNAPSHOT_H
@@ -0,0 +1,272 @@
+#include "SceneStream.h"
+
+#include "assets/asset_manager/AssetCommon.h"
+#include "core/serialization/SerialBinary.h"
+#include "core/utils/Log.h"
+#include "core/utils/TracyProfiler.h"
+#include "scene/Scene.h"
+#include "scene/SceneLoadPlan.h"
+
+#include <cstring>
+
+namespace Rapture {
+
+static constexpr uint32_t SCENE_STREAM_MAGIC = Asset_fourCC("RSCN");
+
+// Version packs major in the high 16 bits and minor in the low 16, matching the asset blobs. A minor bump may
+// add chunk kinds, which older readers skip.
+static constexpr uint16_t SCENE_STREAM_VERSION_MAJOR = 1;
+static constexpr uint16_t SCENE_STREAM_VERSION_MINOR = 0;
+static constexpr uint32_t SCENE_STREAM_VERSION =
+    (static_cast<uint32_t>(SCENE_STREAM_VERSION_MAJOR) << 16) | SCENE_STREAM_VERSION_MINOR;
+
+// A chunk is closed at the first object that takes it past this, so one large subtree still fits in one.
+static constexpr size_t SCENE_STREAM_CHUNK_BYTES = 256 * 1024;
+
+// Anything claiming more than this is taken to be corrupt rather than buffered until it arrives.
+static constexpr uint64_t SCENE_STREAM_MAX_CHUNK_BYTES = 1ull << 30;
+
+enum SceneChunkKind : uint32_t {
+    SCENE_CHUNK_HEADER = 1,  // the owner's header document, then the scene's settings
+    SCENE_CHUNK_OBJECTS = 2, // top level objects, each with its subtree
+    SCENE_CHUNK_END = 3,     // nothing, the stream is complete
+};
+
+struct SceneStreamHeader {
+    uint32_t magic = SCENE_STREAM_MAGIC;
+    uint32_t version = SCENE_STREAM_VERSION;
+    uint64_t reserved = 0;
+};
+
+struct SceneChunkHeader {
+    uint32_t kind = 0;
+    uint32_t valueCount = 0; // documents encoded in the payload
+    uint64_t byteSize = 0;   // bytes of payload that follow
+};
+
+static_assert(sizeof(SceneStreamHeader) == 16 && sizeof(SceneChunkHeader) == 16);
+
+static void s_appendChunk(std::vector<uint8_t> &out, SceneChunkKind kind, uint32_t valueCount, const std::vector<uint8_t> &payload)
+{
+    SceneChunkHeader header;
+    header.kind = kind;
+    header.valueCount = valueCount;
+    header.byteSize = payload.size();
+
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&header);
+    out.insert(out.end(), bytes, bytes + sizeof(header));
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+bool isSceneStream(std::span<const uint8_t> bytes)
+{
+    uint32_t magic = 0;
+    if (bytes.size() < sizeof(magic)) {
+        return false;
+    }
+    std::memcpy(&magic, bytes.data(), sizeof(magic));
+    return magic == SCENE_STREAM_MAGIC;
+}
+
+std::vector<uint8_t> writeSceneStream(const Scene &scene, const SerialDocument &header)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    std::vector<uint8_t> out;
+    SceneStreamHeader fileHeader;
+    const uint8_t *fileHeaderBytes = reinterpret_cast<const uint8_t *>(&fileHeader);
+    out.insert(out.end(), fileHeaderBytes, fileHeaderBytes + sizeof(fileHeader));
+
+    // every chunk starts its own key table, so it can be decoded without the ones before it
+    SerialBinaryEncoder encoder;
+    std::vector<uint8_t> payload;
+
+    SerialDocument settings(SERIAL_FLOAT_NATIVE);
+    scene.serializeSettings(settings.root());
+    if (!encoder.encode(header, payload) || !encoder.encode(settings, payload)) {
+        RP_CORE_ERROR("scene '{}' could not be written as a stream", scene.getSceneName());
+        return {};
+    }
+    s_appendChunk(out, SCENE_CHUNK_HEADER, 2, payload);
+
+    payload.clear();
+    encoder.reset();
+    uint32_t valueCount = 0;
+
+    for (const auto &child : scene.root()->children()) {
+        // encoded before the next one is written, so the keys need not be copied
+        SerialDocument object(SERIAL_FLOAT_NATIVE, SERIAL_KEYS_BORROWED);
+        child->serialize(object.root());
+        if (!encoder.encode(object, payload)) {
+            RP_CORE_ERROR("scene '{}' could not be written as a stream", scene.getSceneName());
+            return {};
+        }
+        valueCount++;
+
+        if (payload.size() >= SCENE_STREAM_CHUNK_BYTES) {
+            s_appendChunk(out, SCENE_CHUNK_OBJECTS, valueCount, payload);
+            payload.clear();
+            encoder.reset();
+            valueCount = 0;
+        }
+    }
+
+    if (valueCount > 0) {
+        s_appendChunk(out, SCENE_CHUNK_OBJECTS, valueCount, payload);
+    }
+
+    s_appendChunk(out, SCENE_CHUNK_END, 0, {});
+    return out;
+}
+
+SceneStreamReader::SceneStreamReader() = default;
+
+SceneStreamReader::~SceneStreamReader() = default;
+
+ReadNode SceneStreamReader::header() const
+{
+    return m_header.isReadable() ? m_header.rootView().at(0) : ReadNode();
+}
+
+bool SceneStreamReader::append(std::span<const uint8_t> bytes)
+{
+    if (m_stage == STAGE_FAILED) {
+        return false;
+    }
+
+    // nothing left over from the last call, so the bytes are read where they are and only their tail is kept
+    if (m_pending.empty()) {
+        const size_t read = consume(bytes);
+        if (m_stage != STAGE_FAILED) {
+            m_pending.assign(bytes.begin() + read, bytes.end());
+        }
+    } else {
+        m_pending.insert(m_pending.end(), bytes.begin(), bytes.end());
+        const size_t read = consume(m_pending);
+        m_pending.erase(m_pending.begin(), m_pending.begin() + read);
+    }
+
+    if (m_stage == STAGE_FAILED) {
+        m_pending.clear();
+        return false;
+    }
+    if (m_stage == STAGE_COMPLETE && !m_pending.empty()) {
+        RP_CORE_WARN("{} bytes follow the end of a scene stream and were ignored", m_pending.size());
+        m_pending.clear();
+    }
+    return true;
+}
+
+size_t SceneStreamReader::consume(std::span<const uint8_t> bytes)
+{
+    size_t cursor = 0;
+
+    if (m_stage == STAGE_FILE_HEADER) {
+        if (bytes.size() < sizeof(SceneStreamHeader)) {
+            return 0;
+        }
+
+        SceneStreamHeader fileHeader;
+        std::memcpy(&fileHeader, bytes.data(), sizeof(fileHeader));
+        if (fileHeader.magic != SCENE_STREAM_MAGIC) {
+            RP_CORE_ERROR("scene stream has an invalid magic");
+            m_stage = STAGE_FAILED;
+            return 0;
+        }
+        if ((fileHeader.version >> 16) != SCENE_STREAM_VERSION_MAJOR) {
+            RP_CORE_ERROR("scene stream major version {} is unsupported", fileHeader.version >> 16);
+            m_stage = STAGE_FAILED;
+            return 0;
+        }
+
+        cursor = sizeof(fileHeader);
+        m_stage = STAGE_CHUNKS;
+    }
+
+    while (m_stage == STAGE_CHUNKS && bytes.size() - cursor >= sizeof(SceneChunkHeader)) {
+        SceneChunkHeader chunk;
+        std::memcpy(&chunk, bytes.data() + cursor, sizeof(chunk));
+        if (chunk.byteSize > SCENE_STREAM_MAX_CHUNK_BYTES) {
+            RP_CORE_ERROR("scene stream chunk claims {} bytes", chunk.byteSize);
+            m_stage = STAGE_FAILED;
+            return cursor;
+        }
+
+        const size_t payloadStart = cursor + sizeof(chunk);
+        if (bytes.size() - payloadStart < chunk.byteSize) {
+            break;
+        }
+
+        if (!readChunk(chunk.kind, chunk.valueCount, bytes.subspan(payloadStart, static_cast<size_t>(chunk.byteSize)))) {
+            m_stage = STAGE_FAILED;
+            return cursor;
+        }
+        cursor = payloadStart + static_cast<size_t>(chunk.byteSize);
+    }
+
+    return cursor;
+}
+
+bool SceneStreamReader::readChunk(uint32_t kind, uint32_t valueCount, std::span<const uint8_t> payload)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    switch (kind) {
+    case SCENE_CHUNK_HEADER: {
+        if (m_scene != nullptr || valueCount != 2) {
+            RP_CORE_ERROR("scene stream has a misplaced or malformed header chunk");
+            return false;
+        }
+
+        m_header = decodeSerialBinary(payload, valueCount);
+        if (!m_header.isReadable()) {
+            return false;
+        }
+
+        m_scene = Scene::createFromSettings(m_header.rootView().at(1));
+        return m_scene != nullptr;
+    }
+    case SCENE_CHUNK_OBJECTS: {
+        if (m_scene == nullptr) {
+            RP_CORE_ERROR("scene stream has objects before its header");
+            return false;
+        }
+
+        // the objects are instantiated by the time this returns, so the decoded chunk is dropped with it
+        SerialDocument objects = decodeSerialBinary(payload, valueCount);
+        if (!objects.isReadable()) {
+            return false;
+        }
+
+        SceneLoadPlan plan = SceneLoadPlan::prepare(objects.rootView());
+        if (!plan.instantiate(*m_scene->root(), m_context)) {
+            RP_CORE_ERROR("scene '{}' could not be read", m_scene->getSceneName());
+            return false;
+        }
+        return true;
+    }
+    case SCENE_CHUNK_END:
+        if (m_scene == nullptr) {
+            RP_CORE_ERROR("scene stream ends before its header");
+            return false;
+        }
+        m_stage = STAGE_COMPLETE;
+        return true;
+    default:
+        // added by a later minor version, nothing this build knows what to do with
+        return true;
+    }
+}
+
+std::unique_ptr<Scene> SceneStreamReader::finish()
+{
+    if (m_stage != STAGE_COMPLETE) {
+        RP_CORE_ERROR("cannot finish a scene stream that has not been read to its end");
+        return nullptr;
+    }
+
+    m_context.finish();
+    return std::move(m_scene);
+}
+
+} // namespace Rapture
@@ -0,0 +1,116 @@
+#ifndef RAPTURE__SCENE_STREAM_H
+#define RAPTURE__SCENE_STREAM_H
+
+#include "core/serialization/SerialDocument.h"
+#include "scene/SceneLoadContext.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace Rapture {
+
+class Scene;
+
+/**
+ * @brief Which of its two forms a scene is saved in
+ */
+enum SceneFileFormat : uint8_t {
+    SCENE_FILE_TEXT,   // one JSON document, for source control and the editor
+    SCENE_FILE_BINARY, // a chunked scene stream, for cooked builds
+};
+
+/**
+ * @brief Whether a run of bytes starts the way a scene stream does
+ * @param bytes The bytes, at least the first four of the file
+ */
+bool isSceneStream(std::span<const uint8_t> bytes);
+
+/**
+ * @brief Writes a scene as a stream of binary chunks.
+ *
+ * The first chunk holds the header document and the scene's settings, every chunk after it a run of the
+ * scene's top level objects with their subtrees, each written through the same WriteNode calls a text save
+ * makes, and the last one marks the end. A chunk is closed once it passes a couple of hundred kilobytes, so
+ * a reader can instantiate it while the rest of the file is still arriving.
+ *
+ * @param scene The scene to write
+ * @param header A document for whoever owns the scene, handed back by SceneStreamReader::header
+ * @return The stream's bytes, empty if the header or an object could not be encoded
+ */
+std::vector<uint8_t> writeSceneStream(const Scene &scene, const SerialDocument &header);
+
+/**
+ * @brief Reads a scene stream as it arrives, instantiating each chunk once all of its bytes are in.
+ *
+ * Bytes may be appended in pieces of any size. References between objects in different chunks are only
+ * resolved by finish, once everything they could name has been read.
+ */
+class SceneStreamReader {
+  public:
+    SceneStreamReader();
+    ~SceneStreamReader();
+
+    SceneStreamReader(const SceneStreamReader &) = delete;
+    SceneStreamReader &operator=(const SceneStreamReader &) = delete;
+
+    /**
+     * @brief Hands the reader the next bytes of the stream and reads every chunk they complete
+     * @param bytes The bytes that follow the last ones appended
+     * @return False once the stream turned out to be malformed, after which nothing more is read
+     */
+    bool append(std::span<const uint8_t> bytes);
+
+    /**
+     * @brief Whether the end of the stream has been read
+     */
+    bool isComplete() const { return m_stage == STAGE_COMPLETE; }
+
+    /**
+     * @brief Cursor to the header document the stream was written with, invalid until its first chunk is read
+     */
+    ReadNode header() const;
+
+    /**
+     * @brief The scene being read into, nullptr until the first chunk is read
+     */
+    Scene *scene() const { return m_scene.get(); }
+
+    /**
+     * @brief Resolves the references of everything read and hands over the scene
+     * @return The scene, or nullptr if the stream is not complete
+     */
+    std::unique_ptr<Scene> finish();
+
+  private:
+    enum Stage : uint8_t {
+        STAGE_FILE_HEADER,
+        STAGE_CHUNKS,
+        STAGE_COMPLETE,
+        STAGE_FAILED,
+    };
+
+    /**
+     * @brief Reads every whole chunk at the front of some bytes
+     * @param bytes The unread bytes of the stream
+     * @return How many bytes were read, the rest being the start of a chunk not yet complete
+     */
+    size_t consume(std::span<const uint8_t> bytes);
+
+    /**
+     * @brief Instantiates what one chunk holds
+     * @return False if the chunk is malformed
+     */
+    bool readChunk(uint32_t kind, uint32_t valueCount, std::span<const uint8_t> payload);
+
+    std::vector<uint8_t> m_pending; // the start of a chunk whose end has not arrived yet
+    SerialDocument m_header;
+    std::unique_ptr<Scene> m_scene;
+    SceneLoadContext m_context{false};
+    Stage m_stage = STAGE_FILE_HEADER;
+};
+
+} // namespace Rapture
+
+#endif // RAPTURE__SCENE_STREAM_H
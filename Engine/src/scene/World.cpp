@@ -3,6 +3,7 @@
 #include "assets/asset_manager/Asset.h"
 #include "assets/asset_manager/AssetManager.h"
 #include "core/serialization/SerialDocument.h"
+#include "core/serialization/SerialStream.h"
 #include "core/utils/Log.h"
 #include "physics/PhysicsSystem.h"
 #include "scene/Scene.h"
@@ -47,6 +48,9 @@ void World::onUpdate(float dt)
         return;
     }
 
+    // steps left running alongside the last frame finish before anything of this one reads the bodies
+    m_scene->joinPhysics();
+
     // driven and simulated before the scene's own update, so what this frame draws is where it left things
     if (m_playState == PlayState::PLAYING) {
         if (m_playController != nullptr) {
@@ -75,6 +79,7 @@ void World::applyGravity()
         return;
     }
 
+    m_scene->joinPhysics();
     physicsSystem->setGravity(m_data.gravity);
 }
 
@@ -148,25 +153,56 @@ void World::stop()
     }
     m_intent = ControlInput{};
 
-    // the snapshot outlives the rewind, its document is what the scene is read back out of
-    m_scene->restoreFrom(m_snapshot.rootView());
-    m_snapshot = SerialDocument{};
+    // the snapshot outlives the rewind, it is what the scene is read back out of
+    m_scene->restoreFrom(m_snapshot);
+    m_snapshot = SceneSnapshot{};
 }
 
-std::vector<uint8_t> World::serialize() const
+void World::writeHeader(WriteNode node) const
 {
-    SerialDocument document;
-    WriteNode root = document.root();
+    node.set(KEY_NAME, std::string_view(m_name));
+    node.set(KEY_PUPPET, m_data.puppet);
+    node.set(KEY_CONTROLLER, m_data.controller);
 
-    root.set(KEY_NAME, std::string_view(m_name));
-    root.set(KEY_PUPPET, m_data.puppet);
-    root.set(KEY_CONTROLLER, m_data.controller);
-
-    WriteNode gravity = root.addArray(KEY_GRAVITY);
+    WriteNode gravity = node.addArray(KEY_GRAVITY);
     gravity.append(m_data.gravity.x);
     gravity.append(m_data.gravity.y);
     gravity.append(m_data.gravity.z);
+}
+
+std::unique_ptr<World> World::createFromHeader(ReadNode node, std::unique_ptr<Scene> scene)
+{
+    std::unique_ptr<World> world(new World(std::string(node.child(KEY_NAME).asString("")), std::move(scene)));
+    world->m_data.puppet = node.child(KEY_PUPPET).asU64(INVALID_ASSET_HANDLE);
+    world->m_data.controller = node.child(KEY_CONTROLLER).asU64(INVALID_ASSET_HANDLE);
+
+    ReadNode gravity = node.child(KEY_GRAVITY);
+    if (gravity.size() == 3) {
+        world->m_data.gravity =
+            glm::vec3(static_cast<float>(gravity.at(0).asF64(0.0)), static_cast<float>(gravity.at(1).asF64(0.0)),
+                      static_cast<float>(gravity.at(2).asF64(0.0)));
+    }
+
+    return world;
+}
+
+std::vector<uint8_t> World::serialize(SceneFileFormat format) const
+{
+    if (format == SCENE_FILE_BINARY) {
+        SerialDocument header(SERIAL_FLOAT_NATIVE);
+        writeHeader(header.root());
+
+        std::vector<uint8_t> stream = writeSceneStream(*m_scene, header);
+        if (stream.empty()) {
+            RP_CORE_ERROR("World '{}' could not be written", m_name);
+        }
+        return stream;
+    }
 
+    SerialDocument document;
+    WriteNode root = document.root();
+
+    writeHeader(root);
     m_scene->serialize(root.addObject(KEY_SCENE));
 
     std::string text = document.toText();
@@ -178,8 +214,36 @@ std::vector<uint8_t> World::serialize() const
     return std::vector<uint8_t>(text.begin(), text.end());
 }
 
+bool World::serializeTo(int fd) const
+{
+    SerialStreamWriter writer(fd);
+
+    // the same text serialize writes, without ever holding all of it
+    writer.beginObject();
+    writer.writeMembers([this](WriteNode node) { writeHeader(node); });
+    writer.beginObject(KEY_SCENE);
+    m_scene->serialize(writer);
+    writer.end();
+    writer.end();
+
+    if (!writer.finish()) {
+        RP_CORE_ERROR("World '{}' could not be written", m_name);
+        return false;
+    }
+    return true;
+}
+
 std::unique_ptr<World> World::deserialize(std::span<const uint8_t> blob)
 {
+    if (isSceneStream(blob)) {
+        SceneStreamReader reader;
+        if (!reader.append(blob)) {
+            RP_CORE_ERROR("world blob holds a malformed scene stream");
+            return nullptr;
+        }
+        return deserialize(reader);
+    }
+
     std::string_view text(reinterpret_cast<const char *>(blob.data()), blob.size());
 
     SerialDocument document = SerialDocument::parse(text);
@@ -194,18 +258,20 @@ std::unique_ptr<World> World::deserialize(std::span<const uint8_t> blob)
         return nullptr;
     }
 
-    std::unique_ptr<World> world(new World(std::string(root.child(KEY_NAME).asString("")), std::move(scene)));
-    world->m_data.puppet = root.child(KEY_PUPPET).asU64(INVALID_ASSET_HANDLE);
-    world->m_data.controller = root.child(KEY_CONTROLLER).asU64(INVALID_ASSET_HANDLE);
+    return createFromHeader(root, std::move(scene));
+}
 
-    ReadNode gravity = root.child(KEY_GRAVITY);
-    if (gravity.size() == 3) {
-        world->m_data.gravity =
-            glm::vec3(static_cast<float>(gravity.at(0).asF64(0.0)), static_cast<float>(gravity.at(1).asF64(0.0)),
-                      static_cast<float>(gravity.at(2).asF64(0.0)));
+std::unique_ptr<World> World::deserialize(SceneStreamReader &reader)
+{
+    if (!reader.isComplete()) {
+        RP_CORE_ERROR("world scene stream ends before its end chunk");
+        return nullptr;
     }
 
-    return world;
+    // the header lives in the reader, which outlives the scene being handed over
+    ReadNode header = reader.header();
+    std::unique_ptr<Scene> scene = reader.finish();
+    return scene != nullptr ? createFromHeader(header, std::move(scene)) : nullptr;
 }
 
 } // namespace Rapture
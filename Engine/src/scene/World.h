@@ -3,6 +3,8 @@
 
 #include "assets/asset_manager/AssetCommon.h"
 #include "core/serialization/SerialDocument.h"
+#include "scene/SceneSnapshot.h"
+#include "scene/SceneStream.h"
 #include "input/ControlInput.h"
 
 #include <cstdint>
@@ -103,20 +105,49 @@ class World {
 
     /**
      * @brief Serializes this world into a self-contained blob
+     * @param format Text for source control, or a binary scene stream for cooked builds
      * @return The serialized bytes, empty if the document could not be written
      */
-    std::vector<uint8_t> serialize() const;
+    std::vector<uint8_t> serialize(SceneFileFormat format = SCENE_FILE_TEXT) const;
 
     /**
-     * @brief Rebuilds a world from a blob produced by serialize
+     * @brief Writes this world as text straight to a file, holding no more than one top level object at a time
+     * @param fd An open descriptor to write to
+     * @return False if the text could not be written
+     */
+    bool serializeTo(int fd) const;
+
+    /**
+     * @brief Rebuilds a world from a blob produced by serialize, in either format
      * @param blob The serialized bytes
      * @return The world, or nullptr if the blob does not hold a readable document
      */
     static std::unique_ptr<World> deserialize(std::span<const uint8_t> blob);
 
+    /**
+     * @brief Rebuilds a world from a scene stream whose bytes were appended to a reader as they arrived
+     * @param reader The reader, which has read the stream's end chunk
+     * @return The world, or nullptr if the stream is not complete
+     */
+    static std::unique_ptr<World> deserialize(SceneStreamReader &reader);
+
   private:
     World(std::string name, std::unique_ptr<Scene> scene);
 
+    /**
+     * @brief Writes everything about this world but its scene
+     * @param node Cursor to the object to write into
+     */
+    void writeHeader(WriteNode node) const;
+
+    /**
+     * @brief Builds a world around a scene from what writeHeader wrote
+     * @param node Cursor to the header's object
+     * @param scene The scene the world plays
+     * @return The world
+     */
+    static std::unique_ptr<World> createFromHeader(ReadNode node, std::unique_ptr<Scene> scene);
+
     /**
      * @brief Hands this world's gravity to the simulation its scene runs
      */
@@ -128,7 +159,7 @@ class World {
     WorldData m_data;
 
     /// What the scene is rewound to on stop, held only for as long as a run is up
-    SerialDocument m_snapshot;
+    SceneSnapshot m_snapshot;
 
     /// Spawned into the scene on play and destroyed by the rewind on stop, so only borrowed here
     Controller *m_playController = nullptr;
@@ -43,12 +43,18 @@ struct TagComponent {
     std::string tag;
 };
 
-// local is what the owning instance authored, world is local composed with every ancestor
+// translation, rotation and scale are what the owning instance authored relative to its parent, world is
+// that composed with every ancestor, cached by the scene's TransformHierarchy
 struct TransformComponent {
     static constexpr ecs::ChangeMask CHANGE_CHANNELS = ecs::ChannelBit(CHANNEL_TRANSFORM_WORLD);
 
-    glm::mat4 local{1.0f};
-    glm::mat4 world{1.0f};
+    glm::vec3 translation{0.0f};
+    glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+    glm::vec3 scale{1.0f};
+    Affine3x4 world;
+
+    glm::mat4 localMatrix() const { return transform::compose(translation, rotation, scale); }
+    glm::mat4 worldMatrix() const { return transform::toMat4(world); }
 };
 
 // Pure camera component - only contains camera-specific data
@@ -131,29 +137,16 @@ struct StaticMeshComponent {
     bool isLoading = true;
     Mobility mobility = MOBILITY_STATIC;
     bool isEnabled = true;
-    BoundingBox worldBoundingBox;
 
     StaticMeshComponent() = default;
 
     StaticMeshComponent(AssetRef ref, Mobility mob = MOBILITY_STATIC) : mesh(std::move(ref)), mobility(mob) { isLoading = false; }
 
     /**
-     * @brief Replaces the mesh, invalidating the world bounding box the old one produced
+     * @brief Replaces the mesh, the scene's WorldBounds picks up its bounds through the journal
      * @param ref Reference to the new mesh
      */
     void setMesh(AssetRef ref) { mesh = AssetPtr<StaticMesh>(std::move(ref)); }
-
-    /**
-     * @brief Recomputes the world bounding box from the mesh's bounds
-     * @param transform The transform placing this mesh in the world
-     */
-    void updateWorldBoundingBox(const TransformComponent &transform)
-    {
-        if (!mesh) {
-            return;
-        }
-        worldBoundingBox = BoundingBox(mesh->getBoundsMin(), mesh->getBoundsMax()).transform(transform.world);
-    }
 };
 
 struct SkeletalMeshComponent {
@@ -163,29 +156,16 @@ struct SkeletalMeshComponent {
     SkeletonInstance *pose = nullptr;
     bool isLoading = true;
     bool isEnabled = true;
-    BoundingBox worldBoundingBox;
 
     SkeletalMeshComponent() = default;
 
     SkeletalMeshComponent(AssetRef ref) : mesh(std::move(ref)) { isLoading = false; }
 
     /**
-     * @brief Replaces the mesh, invalidating the world bounding box the old one produced
+     * @brief Replaces the mesh, the scene's WorldBounds picks up its bounds through the journal
      * @param ref Reference to the new mesh
      */
     void setMesh(AssetRef ref) { mesh = AssetPtr<SkeletalMesh>(std::move(ref)); }
-
-    /**
-     * @brief Recomputes the world bounding box from the mesh's bounds
-     * @param transform The transform placing this mesh in the world
-     */
-    void updateWorldBoundingBox(const TransformComponent &transform)
-    {
-        if (!mesh) {
-            return;
-        }
-        worldBoundingBox = BoundingBox(mesh->getBoundsMin(), mesh->getBoundsMax()).transform(transform.world);
-    }
 };
 
 struct SkeletonPoseComponent {
@@ -79,7 +79,11 @@ void CharacterBody3D::onDetach()
 
 void CharacterBody3D::releaseBody()
 {
+    if (m_body != nullptr) {
+        joinSimulation();
+    }
     m_body.reset();
+    m_simulatedTarget.entity = ecs::ENTITY_NULL;
 }
 
 void CharacterBody3D::rebuild()
@@ -89,6 +93,8 @@ void CharacterBody3D::rebuild()
         return;
     }
 
+    joinSimulation();
+
     // a rebuild is a new body standing where the old one did, so the motion it had is carried over
     // rather than restarting the fall from nothing
     const glm::vec3 carriedVelocity = m_body != nullptr ? m_body->linearVelocity() : glm::vec3(0.0f);
@@ -114,6 +120,11 @@ void CharacterBody3D::rebuild()
         return;
     }
 
+    // only the position is taken back, so whatever turns the object keeps owning its rotation
+    m_simulatedTarget.entity = target->entity();
+    m_simulatedTarget.inverseLocal = glm::mat4(1.0f);
+    m_simulatedTarget.positionOnly = true;
+
     m_body->setLinearVelocity(carriedVelocity);
     pushMovement(false);
 }
@@ -127,6 +138,9 @@ void CharacterBody3D::onUpdate(float dt)
         return;
     }
 
+    // ticked after the world joins the last steps, so this only waits when called from elsewhere
+    joinSimulation();
+
     // the simulation never turns a character, so whatever drives the object owns its rotation and
     // the step ahead has to sweep with the one the object is wearing now
     m_body->setRotation(transform::rotation(target->worldTransform()));
@@ -139,6 +153,7 @@ void CharacterBody3D::teleport(const glm::vec3 &position, const glm::quat &rotat
         return;
     }
 
+    joinSimulation();
     target->setWorldTransform(transform::compose(position, rotation, target->scale()));
 
     if (m_body != nullptr) {
@@ -146,26 +161,14 @@ void CharacterBody3D::teleport(const glm::vec3 &position, const glm::quat &rotat
     }
 }
 
-void CharacterBody3D::applySimulatedTransform(const glm::vec3 &position, const glm::quat &rotation)
-{
-    (void)rotation;
-
-    Node3D *target = node();
-    if (target == nullptr) {
-        return;
-    }
-
-    // only the position is taken back, so whatever turns the object keeps owning its rotation
-    const glm::mat4 world = target->worldTransform();
-    target->setSimulatedWorldTransform(transform::compose(position, transform::rotation(world), transform::scale(world)));
-}
-
 void CharacterBody3D::pushMovement(bool jump)
 {
     if (m_body == nullptr) {
         return;
     }
 
+    joinSimulation();
+
     physics::CharacterBodyMovement movement;
     movement.velocity = m_velocity;
     movement.jump = jump;
@@ -187,6 +190,8 @@ void CharacterBody3D::jump()
 
 physics::GroundState CharacterBody3D::groundState() const
 {
+    // the steps write the ground state as they run, so this only waits when called from elsewhere
+    joinSimulation();
     return m_body != nullptr ? m_body->groundState() : physics::GROUND_IN_AIR;
 }
 
@@ -211,6 +216,7 @@ void CharacterBody3D::setMass(float mass)
 {
     m_mass = mass;
     if (m_body != nullptr) {
+        joinSimulation();
         m_body->setMass(mass);
     }
 }
@@ -219,6 +225,7 @@ void CharacterBody3D::setMaxSlopeAngle(float radians)
 {
     m_maxSlopeAngle = radians;
     if (m_body != nullptr) {
+        joinSimulation();
         m_body->setMaxSlopeAngle(radians);
     }
 }
@@ -227,6 +234,7 @@ void CharacterBody3D::setStepUp(float stepUp)
 {
     m_stepUp = stepUp;
     if (m_body != nullptr) {
+        joinSimulation();
         m_body->setStepUp(stepUp);
     }
 }
@@ -235,6 +243,7 @@ void CharacterBody3D::setStepDown(float stepDown)
 {
     m_stepDown = stepDown;
     if (m_body != nullptr) {
+        joinSimulation();
         m_body->setStepDown(stepDown);
     }
 }
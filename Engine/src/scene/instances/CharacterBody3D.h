@@ -28,8 +28,6 @@ class CharacterBody3D : public PhysicsBody3D {
      */
     void onUpdate(float dt) override;
 
-    void applySimulatedTransform(const glm::vec3 &position, const glm::quat &rotation) override;
-
     /**
      * @brief Puts this body and the object it walks somewhere else outright
      * @param position World space position
@@ -110,6 +110,18 @@ std::unique_ptr<SceneComponent> InstanceRegistry::createComponent(std::string_vi
     return it->second(scene, name);
 }
 
+SceneObjectFactory InstanceRegistry::findObjectFactory(std::string_view className)
+{
+    auto it = s_objectFactories.find(className);
+    return it != s_objectFactories.end() ? it->second : nullptr;
+}
+
+SceneComponentFactory InstanceRegistry::findComponentFactory(std::string_view className)
+{
+    auto it = s_componentFactories.find(className);
+    return it != s_componentFactories.end() ? it->second : nullptr;
+}
+
 bool InstanceRegistry::containsObject(std::string_view className)
 {
     return s_objectFactories.find(className) != s_objectFactories.end();
@@ -73,6 +73,22 @@ class InstanceRegistry {
      */
     static std::unique_ptr<SceneComponent> createComponent(std::string_view className, Scene &scene, std::string_view name);
 
+    /**
+     * @brief The factory of the scene object class a document names, without constructing anything
+     *
+     * Only reads the registry, so a load may resolve its classes from worker threads once init has returned.
+     * @param className The class name read from the document
+     * @return The factory, or nullptr if no class is registered under that name
+     */
+    static SceneObjectFactory findObjectFactory(std::string_view className);
+
+    /**
+     * @brief The factory of the scene component class a document names, without constructing anything
+     * @param className The class name read from the document
+     * @return The factory, or nullptr if no class is registered under that name
+     */
+    static SceneComponentFactory findComponentFactory(std::string_view className);
+
     /**
      * @brief Whether a scene object class is registered under a name
      */
@@ -1,6 +1,7 @@
 #include "Node3D.h"
 
 #include "scene/components/Components.h"
+#include "scene/systems/TransformHierarchy.h"
 #include "scene/systems/Transforms.h"
 #include "scene/render_data/SceneRenderData.h"
 #include "scene/Scene.h"
@@ -51,7 +52,7 @@ static glm::quat s_readQuat(ReadNode node, std::string_view key, const glm::quat
                      static_cast<float>(array.at(1).asF64(fallback.y)), static_cast<float>(array.at(2).asF64(fallback.z)));
 }
 
-static const glm::mat4 MAT4_IDENTITY = glm::mat4(1.0f);
+static const TransformComponent DEFAULT_TRANSFORM{};
 
 Node3D::Node3D(Scene &scene, std::string_view name) : SceneObject(scene, name)
 {
@@ -74,86 +75,89 @@ Node3D *Node3D::parentNode() const
     return findFirstAncestorOfType<Node3D>();
 }
 
+/**
+ * @brief The node's component, or the defaults if it lost it
+ */
+static const TransformComponent &s_readTransform(const ecs::EntityAccessor &entity)
+{
+    const auto *component = entity.tryRead<TransformComponent>();
+    return component != nullptr ? *component : DEFAULT_TRANSFORM;
+}
+
 glm::vec3 Node3D::position() const
 {
-    return transform::translation(localTransform());
+    return s_readTransform(m_entity).translation;
 }
 
 void Node3D::setPosition(const glm::vec3 &position)
 {
-    resolveLocal();
-
-    if (!m_entity.has<TransformComponent>()) {
-        return;
-    }
-
-    m_entity.write<TransformComponent>()->local[3] = glm::vec4(position, 1.0f);
-    updateWorldTransform();
+    const TransformComponent &component = s_readTransform(m_entity);
+    setLocalParts(position, component.rotation, component.scale);
 }
 
 const glm::vec3 &Node3D::rotation() const
 {
-    resolveRotationAndScale();
+    const glm::quat &rotation = s_readTransform(m_entity).rotation;
+    if (rotation != m_eulerSource) {
+        m_eulerSource = rotation;
+        m_eulerRotation = glm::eulerAngles(rotation);
+    }
     return m_eulerRotation;
 }
 
 void Node3D::setRotation(const glm::vec3 &rotation)
 {
-    resolveRotationAndScale();
+    const TransformComponent &component = s_readTransform(m_entity);
+    const glm::quat quat(rotation);
+    setLocalParts(component.translation, quat, component.scale);
     m_eulerRotation = rotation;
-    m_rotation = glm::quat(rotation);
-    markRotationAndScaleWritten();
+    m_eulerSource = quat;
 }
 
-const glm::quat &Node3D::rotationQuat() const
+glm::quat Node3D::rotationQuat() const
 {
-    resolveRotationAndScale();
-    return m_rotation;
+    return s_readTransform(m_entity).rotation;
 }
 
 void Node3D::setRotation(const glm::quat &rotation)
 {
-    resolveRotationAndScale();
-    m_rotation = rotation;
-    m_eulerRotation = glm::eulerAngles(rotation);
-    markRotationAndScaleWritten();
+    const TransformComponent &component = s_readTransform(m_entity);
+    setLocalParts(component.translation, rotation, component.scale);
 }
 
-const glm::vec3 &Node3D::scale() const
+glm::vec3 Node3D::scale() const
 {
-    resolveRotationAndScale();
-    return m_scale;
+    return s_readTransform(m_entity).scale;
 }
 
 void Node3D::setScale(const glm::vec3 &scale)
 {
-    resolveRotationAndScale();
-    m_scale = scale;
-    markRotationAndScaleWritten();
+    const TransformComponent &component = s_readTransform(m_entity);
+    setLocalParts(component.translation, component.rotation, scale);
 }
 
-const glm::mat4 &Node3D::localTransform() const
+void Node3D::setLocalParts(const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale)
 {
-    resolveLocal();
+    if (m_entity.has<TransformComponent>()) {
+        scene()->transforms().setLocal(entity(), position, rotation, scale);
+    }
+}
 
-    const auto *component = m_entity.tryRead<TransformComponent>();
-    return component != nullptr ? component->local : MAT4_IDENTITY;
+glm::mat4 Node3D::localTransform() const
+{
+    return s_readTransform(m_entity).localMatrix();
 }
 
 void Node3D::setLocalTransform(const glm::mat4 &transform)
 {
-    if (!m_entity.has<TransformComponent>()) {
-        return;
+    if (m_entity.has<TransformComponent>()) {
+        scene()->transforms().setLocal(entity(), transform);
     }
-
-    m_entity.write<TransformComponent>()->local = transform;
-    markLocalWritten();
 }
 
-const glm::mat4 &Node3D::worldTransform() const
+glm::mat4 Node3D::worldTransform() const
 {
-    const auto *component = m_entity.tryRead<TransformComponent>();
-    return component != nullptr ? component->world : MAT4_IDENTITY;
+    return m_entity.has<TransformComponent>() ? transform::toMat4(scene()->transforms().world(entity())) : glm::mat4(1.0f);
 }
 
 void Node3D::setWorldTransform(const glm::mat4 &transform)
@@ -162,101 +166,16 @@ void Node3D::setWorldTransform(const glm::mat4 &transform)
     setLocalTransform(parent != nullptr ? transform::toLocal(parent->worldTransform(), transform) : transform);
 }
 
-void Node3D::setSimulatedWorldTransform(const glm::mat4 &transform)
-{
-    if (!m_entity.has<TransformComponent>()) {
-        return;
-    }
-
-    {
-        auto component = m_entity.write<TransformComponent>();
-        const Node3D *parent = parentNode();
-        component->world = transform;
-        component->local = parent != nullptr ? transform::toLocal(parent->worldTransform(), transform) : transform;
-    }
-
-    m_dirtyMask = TRANSFORM_DIRTY_ROTATION_AND_SCALE;
-
-    updateDescendantWorldTransforms(*this);
-}
-
-void Node3D::markRotationAndScaleWritten()
-{
-    m_dirtyMask &= ~TRANSFORM_DIRTY_ROTATION_AND_SCALE;
-    m_dirtyMask |= TRANSFORM_DIRTY_LOCAL;
-    updateWorldTransform();
-}
-
-void Node3D::markLocalWritten()
-{
-    m_dirtyMask &= ~TRANSFORM_DIRTY_LOCAL;
-    m_dirtyMask |= TRANSFORM_DIRTY_ROTATION_AND_SCALE;
-    updateWorldTransform();
-}
-
 void Node3D::updateWorldTransform()
 {
-    resolveLocal();
-
-    if (!m_entity.has<TransformComponent>()) {
-        return;
-    }
-
-    {
-        auto component = m_entity.write<TransformComponent>();
-        const Node3D *parent = parentNode();
-        component->world = parent != nullptr ? parent->worldTransform() * component->local : component->local;
-    }
-
-    updateDescendantWorldTransforms(*this);
+    scene()->transforms().markDirty(entity());
 }
 
 void Node3D::onParentChanged()
 {
-    updateWorldTransform();
-}
-
-void Node3D::updateDescendantWorldTransforms(const SceneObject &parent)
-{
-    for (const auto &child : parent.children()) {
-        Node3D *node = child->as<Node3D>();
-        if (node != nullptr) {
-            node->updateWorldTransform();
-            continue;
-        }
-
-        updateDescendantWorldTransforms(*child);
-    }
-}
-
-void Node3D::resolveRotationAndScale() const
-{
-    if ((m_dirtyMask & TRANSFORM_DIRTY_ROTATION_AND_SCALE) == 0) {
-        return;
-    }
-
-    const auto *component = m_entity.tryRead<TransformComponent>();
-    if (component != nullptr) {
-        m_rotation = transform::rotation(component->local);
-        m_eulerRotation = glm::eulerAngles(m_rotation);
-        m_scale = transform::scale(component->local);
-    }
-
-    m_dirtyMask &= ~TRANSFORM_DIRTY_ROTATION_AND_SCALE;
-}
-
-void Node3D::resolveLocal() const
-{
-    if ((m_dirtyMask & TRANSFORM_DIRTY_LOCAL) == 0) {
-        return;
-    }
-
-    if (m_entity.has<TransformComponent>()) {
-        auto component = m_entity.write<TransformComponent>();
-        component->local = transform::compose(transform::translation(component->local), m_rotation, m_scale);
-    }
-
-    m_dirtyMask &= ~TRANSFORM_DIRTY_LOCAL;
+    // Node3Ds below keep this node as their closest Node3D, so only this row moves in the hierarchy
+    const Node3D *parent = parentNode();
+    scene()->transforms().setParent(entity(), parent != nullptr ? parent->entity() : ecs::ENTITY_NULL);
 }
 
 void Node3D::serialize(WriteNode node) const
@@ -278,9 +197,10 @@ void Node3D::deserialize(ReadNode node)
         return;
     }
 
-    setPosition(s_readVec3(transform, KEY_TRANSLATION, position()));
-    setRotation(s_readQuat(transform, KEY_ROTATION, rotationQuat()));
-    setScale(s_readVec3(transform, KEY_SCALE, scale()));
+    // one write, so a node that is read moves in the hierarchy once rather than once per part
+    const TransformComponent &current = s_readTransform(m_entity);
+    setLocalParts(s_readVec3(transform, KEY_TRANSLATION, current.translation),
+                  s_readQuat(transform, KEY_ROTATION, current.rotation), s_readVec3(transform, KEY_SCALE, current.scale));
 }
 
 } // namespace Rapture
@@ -1,10 +1,13 @@
 #include "PhysicsBody3D.h"
 
+#include "assets/asset_manager/AssetManager.h"
+#include "assets/meshes/StaticMesh.h"
 #include "core/utils/Log.h"
 #include "physics/CharacterBody.h"
 #include "physics/PhysicsSystem.h"
 #include "physics/RigidBody.h"
 #include "scene/Scene.h"
+#include "scene/instances/StaticMesh3D.h"
 
 namespace Rapture {
 
@@ -21,6 +24,13 @@ const TypeInfo &PhysicsBody3D::type() const
     return staticType();
 }
 
+void PhysicsBody3D::joinSimulation() const
+{
+    if (scene() != nullptr) {
+        scene()->joinPhysics();
+    }
+}
+
 std::unique_ptr<physics::RigidBody> PhysicsBody3D::createRigidBody(const physics::RigidBodyConfig &config)
 {
     PhysicsSystem *physicsSystem = scene() != nullptr ? scene()->physicsSystem() : nullptr;
@@ -29,7 +39,13 @@ std::unique_ptr<physics::RigidBody> PhysicsBody3D::createRigidBody(const physics
         return nullptr;
     }
 
-    return physicsSystem->createRigidBody(config, this);
+    physics::RigidBodyConfig resolved = config;
+    if (!resolveCookedShape(resolved.shape)) {
+        return nullptr;
+    }
+
+    joinSimulation();
+    return physicsSystem->createRigidBody(resolved, this);
 }
 
 std::unique_ptr<physics::CharacterBody> PhysicsBody3D::createCharacterBody(const physics::CharacterBodyConfig &config)
@@ -40,7 +56,43 @@ std::unique_ptr<physics::CharacterBody> PhysicsBody3D::createCharacterBody(const
         return nullptr;
     }
 
-    return physicsSystem->createCharacterBody(config, this);
+    physics::CharacterBodyConfig resolved = config;
+    if (!resolveCookedShape(resolved.shape)) {
+        return nullptr;
+    }
+
+    joinSimulation();
+    return physicsSystem->createCharacterBody(resolved, this);
+}
+
+bool PhysicsBody3D::resolveCookedShape(physics::CollisionShape &shape) const
+{
+    physics::CookedShapeSource *source = physics::CollisionShape_cookedSource(shape);
+    if (source == nullptr || source->cooked != nullptr) {
+        return true;
+    }
+
+    AssetHandle handle = source->mesh;
+    if (handle == INVALID_ASSET_HANDLE) {
+        const StaticMesh3D *meshObject = owner() != nullptr ? owner()->as<StaticMesh3D>() : nullptr;
+        handle = meshObject != nullptr ? meshObject->mesh() : INVALID_ASSET_HANDLE;
+    }
+
+    AssetRef ref = AssetManager::getAsset(handle);
+    const StaticMesh *mesh = ref ? ref.get()->getUnderlyingAsset<StaticMesh>() : nullptr;
+    if (mesh == nullptr) {
+        RP_CORE_ERROR("'{}' has no static mesh to take its {} shape from", name(),
+                      physics::CollisionShape_toString(physics::CollisionShape_typeOf(shape)));
+        return false;
+    }
+
+    source->cooked = physics::CollisionShape_pickCooked(shape, mesh->getCollision());
+    if (source->cooked == nullptr) {
+        RP_CORE_ERROR("mesh {} was not cooked into a {} shape, reimport it to cook one", handle,
+                      physics::CollisionShape_toString(physics::CollisionShape_typeOf(shape)));
+        return false;
+    }
+    return true;
 }
 
 } // namespace Rapture
@@ -2,6 +2,7 @@
 #define RAPTURE__PHYSICS_BODY3D_H
 
 #include "physics/Common.h"
+#include "scene/systems/BodyInterpolation.h"
 #include "scene/instances/SceneComponent.h"
 
 #include <glm/glm.hpp>
@@ -26,11 +27,9 @@ class PhysicsBody3D : public SceneComponent {
     const TypeInfo &type() const override;
 
     /**
-     * @brief Hands a simulated transform to the object this body moves
-     * @param position Where the simulation put the body
-     * @param rotation How the simulation oriented the body
+     * @brief Where the transforms the simulation produces for this body land
      */
-    virtual void applySimulatedTransform(const glm::vec3 &position, const glm::quat &rotation) = 0;
+    const SimulatedTarget &simulatedTarget() const { return m_simulatedTarget; }
 
     /**
      * @brief Sets the velocity the object moves at until it is told otherwise
@@ -39,6 +38,11 @@ class PhysicsBody3D : public SceneComponent {
     virtual void setVelocity(const glm::vec3 &velocity) = 0;
 
   protected:
+    /**
+     * @brief Waits for steps the scene is running on a worker, before the body is read or changed
+     */
+    void joinSimulation() const;
+
     /**
      * @brief Adds a rigid body to this object's scene, owned by this body
      * @param config What the body is built from
@@ -52,6 +56,18 @@ class PhysicsBody3D : public SceneComponent {
      * @return The body, or nullptr if the scene has no simulation to join
      */
     std::unique_ptr<physics::CharacterBody> createCharacterBody(const physics::CharacterBodyConfig &config);
+
+    /**
+     * @brief Looks up the collision a shape taken from a mesh was cooked into
+     *
+     * A shape naming no mesh takes the StaticMesh3D this body is part of. Other shapes are left as they are.
+     * @param shape The shape, given its cooked data here
+     * @return False if the mesh carries no cooked data of the shape's kind
+     */
+    bool resolveCookedShape(physics::CollisionShape &shape) const;
+
+  protected:
+    SimulatedTarget m_simulatedTarget;
 };
 
 } // namespace Rapture
@@ -91,7 +91,11 @@ glm::mat4 RigidBody3D::bodyTransform(const glm::mat4 &local) const
 
 void RigidBody3D::releaseBody()
 {
+    if (m_body != nullptr) {
+        joinSimulation();
+    }
     m_body.reset();
+    m_simulatedTarget.entity = ecs::ENTITY_NULL;
 }
 
 void RigidBody3D::onAttach()
@@ -115,6 +119,8 @@ void RigidBody3D::rebuild()
         return;
     }
 
+    joinSimulation();
+
     // a rebuild is a new body standing where the old one did, so the motion it had is carried over
     // rather than dropping back to rest
     const glm::vec3 carriedVelocity = m_body != nullptr ? m_body->linearVelocity() : glm::vec3(0.0f);
@@ -122,7 +128,6 @@ void RigidBody3D::rebuild()
     releaseBody();
 
     const glm::mat4 local = scaledLocalTransform();
-    m_inverseLocal = glm::inverse(local);
 
     const glm::mat4 body = bodyTransform(local);
 
@@ -140,6 +145,10 @@ void RigidBody3D::rebuild()
         return;
     }
 
+    m_simulatedTarget.entity = node()->entity();
+    m_simulatedTarget.inverseLocal = glm::inverse(local);
+    m_simulatedTarget.positionOnly = false;
+
     m_body->setLinearVelocity(carriedVelocity);
 }
 
@@ -149,22 +158,10 @@ void RigidBody3D::setVelocity(const glm::vec3 &velocity)
         return;
     }
 
+    joinSimulation();
     m_body->setLinearVelocity(velocity);
 }
 
-void RigidBody3D::applySimulatedTransform(const glm::vec3 &position, const glm::quat &rotation)
-{
-    Node3D *target = node();
-    if (target == nullptr) {
-        return;
-    }
-
-    const glm::mat4 world = transform::compose(position, rotation, glm::vec3(1.0f)) * m_inverseLocal;
-
-    target->setSimulatedWorldTransform(
-        transform::compose(transform::translation(world), transform::rotation(world), target->scale()));
-}
-
 void RigidBody3D::setShape(const physics::CollisionShape &shape)
 {
     m_shape = shape;
@@ -191,6 +188,7 @@ void RigidBody3D::setFriction(float friction)
 {
     m_friction = friction;
     if (m_body != nullptr) {
+        joinSimulation();
         m_body->setFriction(friction);
     }
 }
@@ -199,6 +197,7 @@ void RigidBody3D::setRestitution(float restitution)
 {
     m_restitution = restitution;
     if (m_body != nullptr) {
+        joinSimulation();
         m_body->setRestitution(restitution);
     }
 }
@@ -25,8 +25,6 @@ class RigidBody3D : public PhysicsBody3D {
     static const TypeInfo &staticType();
     const TypeInfo &type() const override;
 
-    void applySimulatedTransform(const glm::vec3 &position, const glm::quat &rotation) override;
-
     void setVelocity(const glm::vec3 &velocity) override;
 
     /**
@@ -95,7 +93,6 @@ class RigidBody3D : public PhysicsBody3D {
     bool m_startActive = true;
 
     std::unique_ptr<physics::RigidBody> m_body;
-    glm::mat4 m_inverseLocal{1.0f};
 };
 
 } // namespace Rapture
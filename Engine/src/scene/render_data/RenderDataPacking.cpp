@@ -0,0 +1,152 @@
+#include "scene/render_data/RenderDataPacking.h"
+
+#include "core/ecs/entity_accessor.h"
+#include "core/jobs/Counter.h"
+#include "core/jobs/JobSystem.h"
+#include "core/utils/TracyProfiler.h"
+#include "scene/components/Components.h"
+#include "scene/systems/Transforms.h"
+
+#include <cmath>
+
+namespace Rapture {
+
+void RenderDataPacker::run(uint32_t parallelThreshold)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    m_lastStats = {m_queuedSlots, 0};
+
+    if (m_queuedSlots < parallelThreshold || m_chunks.size() < 2) {
+        for (const Chunk &chunk : m_chunks) {
+            chunk.pack(chunk);
+        }
+    } else {
+        Counter counter{};
+        counter.increment(static_cast<int32_t>(m_chunks.size()));
+        for (const Chunk &chunk : m_chunks) {
+            auto job = [&chunk](JobContext &) { chunk.pack(chunk); };
+            jobs().run(JobDeclaration(job, JobPriority::HIGH, QueueAffinity::ANY, &counter, "Render data pack"));
+        }
+        jobs().waitFor(counter, 0);
+        m_lastStats.jobs = static_cast<uint32_t>(m_chunks.size());
+    }
+
+    m_chunks.clear();
+    m_queuedSlots = 0;
+}
+
+MeshPacker::MeshPacker(const ecs::Registry &registry)
+    : m_registry(&registry), m_transforms(registry.getPool<TransformComponent>()),
+      m_staticMeshes(registry.getPool<StaticMeshComponent>()), m_skeletalMeshes(registry.getPool<SkeletalMeshComponent>()),
+      m_transformBit(ecs::ComponentBit<TransformComponent>()), m_staticMeshBit(ecs::ComponentBit<StaticMeshComponent>()),
+      m_skeletalMeshBit(ecs::ComponentBit<SkeletalMeshComponent>())
+{
+}
+
+void MeshPacker::operator()(RenderPartition<MeshGPUData> &partition, uint32_t slot) const
+{
+    ecs::Entity entityId = partition.getEntityId(slot);
+    if (!m_registry->isValid(entityId)) {
+        return;
+    }
+
+    const ecs::ComponentMask components = m_registry->getComponentMask(entityId);
+    if ((components & m_transformBit) == 0) {
+        return;
+    }
+
+    const Mesh *mesh = nullptr;
+    uint32_t boneOffset = UINT32_MAX;
+
+    if ((components & m_staticMeshBit) != 0) {
+        mesh = m_staticMeshes->get(entityId).mesh.get();
+    } else if ((components & m_skeletalMeshBit) != 0) {
+        const SkeletalMeshComponent &skeletal = m_skeletalMeshes->get(entityId);
+        mesh = skeletal.mesh.get();
+        if (skeletal.pose != nullptr) {
+            boneOffset = skeletal.pose->getBoneOffset();
+        }
+    }
+
+    if (mesh == nullptr) {
+        return;
+    }
+
+    MeshGPUData &data = partition.getSlotData(slot);
+    data.modelMatrix = m_transforms->get(entityId).worldMatrix();
+    data.vertexBufferFlags = mesh->getVertexBuffer()->getBufferLayout().getFlags();
+    data.entityId = entityId;
+    data.materialIndex = 0;
+    data.boneOffset = boneOffset;
+}
+
+void LightPacker::operator()(RenderPartition<LightGPUData> &partition, uint32_t slot) const
+{
+    ecs::Registry &registry = *m_registry;
+    ecs::Entity entityId = partition.getEntityId(slot);
+    ecs::EntityAccessor entity(entityId, &registry);
+
+    const TransformComponent *transform = registry.tryRead<TransformComponent>(entityId);
+    const LightComponent *light = Light_tryReadLight(entity);
+    if (transform == nullptr || light == nullptr) {
+        return;
+    }
+
+    LightType type = Light_getLightType(entity);
+
+    auto &data = partition.getSlotData(slot);
+
+    glm::vec3 position = transform::translation(transform->world);
+    if (type == LightType::DIRECTIONAL) {
+        position = glm::vec3(0.0f);
+    }
+    data.positionAndType = glm::vec4(position, static_cast<float>(type));
+
+    glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+    if (type == LightType::DIRECTIONAL || type == LightType::SPOT) {
+        direction = transform::forward(transform->world);
+    }
+
+    float range = 0.0f;
+    float innerCos = 0.0f;
+    float outerCos = 0.0f;
+    if (const SpotLightComponent *spot = registry.tryRead<SpotLightComponent>(entityId)) {
+        range = spot->range;
+        innerCos = std::cos(spot->innerConeAngle);
+        outerCos = std::cos(spot->outerConeAngle);
+    } else if (const PointLightComponent *point = registry.tryRead<PointLightComponent>(entityId)) {
+        range = point->range;
+    }
+    data.directionAndRange = glm::vec4(direction, range);
+
+    data.colorAndIntensity = glm::vec4(light->color, light->intensity);
+
+    data.spotAngles = glm::vec4(innerCos, outerCos, static_cast<float>(entityId), 0.0f);
+}
+
+void CameraPacker::operator()(RenderPartition<CameraGPUData> &partition, uint32_t slot) const
+{
+    ecs::Registry &registry = *m_registry;
+    ecs::Entity entityId = partition.getEntityId(slot);
+    if (!registry.hasAll<TransformComponent, CameraComponent>(entityId)) {
+        return;
+    }
+
+    // hasRenderData records what this slot holds, not a change to the camera
+    auto camera = registry.write<CameraComponent>(entityId, 0);
+    auto &data = partition.getSlotData(slot);
+
+    // Carried from the values this slot still holds, so it lags exactly one update
+    const glm::mat4 previousViewProj = data.projection * data.view;
+
+    data.view = camera->camera.getViewMatrix();
+    data.projection = camera->camera.getProjectionMatrix();
+    data.invViewProj = glm::inverse(data.projection * data.view);
+
+    // A slot that has never been updated holds a zero matrix, which would reproject to w = 0
+    data.prevViewProj = camera->hasRenderData ? previousViewProj : (data.projection * data.view);
+    camera->hasRenderData = true;
+}
+
+} // namespace Rapture
@@ -0,0 +1,236 @@
+#ifndef RAPTURE__RENDER_DATA_PACKING_H
+#define RAPTURE__RENDER_DATA_PACKING_H
+
+#include "renderer/GPUDataStructs.h"
+#include "renderer/RenderPartition.h"
+#include "scene/components/ChangeChannels.h"
+
+#include "core/ecs/entity_map.h"
+#include "core/ecs/registry.h"
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace Rapture {
+
+struct TransformComponent;
+struct StaticMeshComponent;
+struct SkeletalMeshComponent;
+
+// dirty slots a packing job is handed at least, fewer are not worth the hop to a worker
+inline constexpr uint32_t PACK_CHUNK_SLOTS = 1024;
+
+// dirty slots one RenderDataPacker::run() must hold before it is split into jobs at all
+inline constexpr uint32_t PACK_PARALLEL_THRESHOLD = 4096;
+
+/**
+ * @brief Where an entity's data landed in a store, and the partition it landed in
+ *
+ * The mobility is the one the slot was allocated against, so freeing, moving and repacking the
+ * slot never has to read it back from a component that may already have changed.
+ */
+struct RenderSlot {
+    uint32_t globalSlot = UINT32_MAX;
+    Mobility mobility = MOBILITY_DYNAMIC;
+};
+
+using RenderSlotMap = ecs::EntityMap<RenderSlot>;
+
+/**
+ * @brief One store's position in the channels it mirrors, for one frame's buffer
+ */
+struct RenderStoreBookmarks {
+    ecs::Bookmark transform;
+    ecs::Bookmark params;
+};
+
+/**
+ * @brief Marks every slot of a store dirty for one frame
+ *
+ * Store is a GPUDataStore, or anything with the same getPartition(), getGlobalSlot() and
+ * getLocalSlot(), which is how the packing runs without a device.
+ */
+template <typename Store>
+void markAllSlots(Store &store, uint32_t frameIndex)
+{
+    for (uint32_t m = 0; m < MOBILITY_COUNT; m++) {
+        auto &partition = store.getPartition(static_cast<Mobility>(m));
+        for (uint32_t i = 0; i < partition.getCount(); i++) {
+            partition.markDirty(frameIndex, i);
+        }
+    }
+}
+
+/**
+ * @brief Pulls both channels a store mirrors and marks the slots of whatever they name dirty
+ *
+ * Only marks, the slots are packed afterwards by a RenderDataPacker. Marking into the frame's
+ * bitfield also folds an entity named by both channels, or named twice, into one repack.
+ * @param journal The registry's journal, read on the calling thread
+ * @param store Store whose frame buffer is being brought up to date
+ * @param slots Where each entity's data landed in the store
+ * @param bookmarks This frame's position in both channels
+ * @param paramsChannel The channel carrying this store's own parameters
+ * @param frameIndex Frame whose buffer is being brought up to date
+ */
+template <typename Store>
+void markChangedSlots(ecs::Journal &journal, Store &store, const RenderSlotMap &slots, RenderStoreBookmarks &bookmarks,
+                      SceneChannel paramsChannel, uint32_t frameIndex)
+{
+    ecs::Batch transforms = journal.readSince(CHANNEL_TRANSFORM_WORLD, bookmarks.transform);
+    ecs::Batch params = journal.readSince(paramsChannel, bookmarks.params);
+
+    // the reader fell too far behind to know what changed
+    if (transforms.needsRebuild() || params.needsRebuild()) {
+        markAllSlots(store, frameIndex);
+        return;
+    }
+
+    auto mark = [&](ecs::Entity entityId) {
+        const RenderSlot *slot = slots.find(entityId);
+        if (slot != nullptr) {
+            store.getPartition(slot->mobility).markDirty(frameIndex, store.getLocalSlot(slot->mobility, slot->globalSlot));
+        }
+    };
+    for (ecs::Entity entity : transforms) {
+        mark(entity);
+    }
+    for (ecs::Entity entity : params) {
+        mark(entity);
+    }
+}
+
+/**
+ * @brief Packs the dirty slots of several partitions as one set of jobs
+ *
+ * Each partition added is cut at word boundaries of its frame's dirty bitfield into chunks of
+ * about PACK_CHUNK_SLOTS dirty slots, and run() packs the chunks of every partition on one
+ * counter. A chunk owns whole words, so no two jobs pack the same slot, and the bitfields are only
+ * read while the jobs run. Nothing may mark, allocate or free slots between add() and run().
+ */
+class RenderDataPacker {
+  public:
+    /**
+     * @brief What the last run() packed
+     */
+    struct Stats {
+        uint32_t slots = 0;
+        uint32_t jobs = 0; // 0 when it packed on the calling thread
+    };
+
+    /**
+     * @brief Queues the slots a frame's bitfield marks dirty
+     * @param partition Partition to pack, must outlive run()
+     * @param frameIndex Frame whose dirty bits name the slots
+     * @param pack Called as pack(partition, slot) on any worker, must outlive run()
+     */
+    template <typename T, typename Pack>
+    void add(RenderPartition<T> &partition, uint32_t frameIndex, const Pack &pack)
+    {
+        const DirtyBitfield &dirty = partition.getDirty(frameIndex);
+        const uint32_t wordCount = dirty.getWordCount();
+
+        uint32_t chunkBegin = 0;
+        uint32_t chunkSlots = 0;
+        for (uint32_t word = 0; word < wordCount; word++) {
+            chunkSlots += static_cast<uint32_t>(std::popcount(dirty.getWord(word)));
+            if (chunkSlots < PACK_CHUNK_SLOTS && word + 1 < wordCount) {
+                continue;
+            }
+            if (chunkSlots > 0) {
+                m_chunks.push_back({&packWords<T, Pack>, &partition, &pack, frameIndex, chunkBegin, word + 1});
+                m_queuedSlots += chunkSlots;
+            }
+            chunkBegin = word + 1;
+            chunkSlots = 0;
+        }
+    }
+
+    /**
+     * @brief Packs every queued chunk, on jobs once there are enough slots to share, then forgets them
+     * @param parallelThreshold Dirty slots needed before jobs are used, UINT32_MAX packs on the calling thread
+     */
+    void run(uint32_t parallelThreshold = PACK_PARALLEL_THRESHOLD);
+
+    const Stats &getLastStats() const { return m_lastStats; }
+
+  private:
+    struct Chunk {
+        void (*pack)(const Chunk &chunk);
+        void *partition;
+        const void *packer;
+        uint32_t frameIndex;
+        uint32_t beginWord;
+        uint32_t endWord;
+    };
+
+    template <typename T, typename Pack>
+    static void packWords(const Chunk &chunk)
+    {
+        auto &partition = *static_cast<RenderPartition<T> *>(chunk.partition);
+        const Pack &pack = *static_cast<const Pack *>(chunk.packer);
+        partition.getDirty(chunk.frameIndex).forEachDirtyInWords(chunk.beginWord, chunk.endWord, [&](uint32_t slot) {
+            pack(partition, slot);
+        });
+    }
+
+    std::vector<Chunk> m_chunks; // reused between runs
+    uint32_t m_queuedSlots = 0;
+    Stats m_lastStats;
+};
+
+/**
+ * @brief Packs a mesh slot from its entity's transform and whichever mesh component it holds
+ *
+ * The pools are resolved once at construction, then the entity's mask says which of them hold it,
+ * so a slot costs one record read and a lookup per component it reads. Reads only, so it may run
+ * on every worker at once.
+ */
+class MeshPacker {
+  public:
+    explicit MeshPacker(const ecs::Registry &registry);
+
+    void operator()(RenderPartition<MeshGPUData> &partition, uint32_t slot) const;
+
+  private:
+    const ecs::Registry *m_registry;
+    const ecs::ComponentPool<TransformComponent> *m_transforms;
+    const ecs::ComponentPool<StaticMeshComponent> *m_staticMeshes;
+    const ecs::ComponentPool<SkeletalMeshComponent> *m_skeletalMeshes;
+    ecs::ComponentMask m_transformBit;
+    ecs::ComponentMask m_staticMeshBit;
+    ecs::ComponentMask m_skeletalMeshBit;
+};
+
+/**
+ * @brief Packs a light slot from its entity's transform and whichever concrete light it holds
+ */
+class LightPacker {
+  public:
+    explicit LightPacker(ecs::Registry &registry) : m_registry(&registry) {}
+
+    void operator()(RenderPartition<LightGPUData> &partition, uint32_t slot) const;
+
+  private:
+    ecs::Registry *m_registry;
+};
+
+/**
+ * @brief Packs a camera slot, carrying the view-projection the slot still holds into prevViewProj
+ *
+ * Writes the camera's own hasRenderData, which nothing else packing at the same time reads.
+ */
+class CameraPacker {
+  public:
+    explicit CameraPacker(ecs::Registry &registry) : m_registry(&registry) {}
+
+    void operator()(RenderPartition<CameraGPUData> &partition, uint32_t slot) const;
+
+  private:
+    ecs::Registry *m_registry;
+};
+
+} // namespace Rapture
+
+#endif // RAPTURE__RENDER_DATA_PACKING_H
@@ -1,7 +1,6 @@
 #include "scene/render_data/SceneRenderData.h"
 
 #include "scene/components/Components.h"
-#include "scene/systems/Transforms.h"
 #include "core/ecs/entity_accessor.h"
 #include "core/utils/TracyProfiler.h"
 #include "renderer/shadows/CascadedShadowMapping.h"
@@ -9,7 +8,6 @@
 #include "scene/Scene.h"
 
 #include <algorithm>
-#include <cmath>
 #include <glm/gtc/quaternion.hpp>
 #include <vector>
 
@@ -42,35 +40,30 @@ SceneRenderData::SceneRenderData(const RenderContext &renderContext, Scene &scen
     // a bookmark belongs to a destination, and every frame in flight has its own buffer
     m_meshBookmarks.resize(frameCount);
     m_lightBookmarks.resize(frameCount);
-    m_cameraBookmarks.resize(frameCount);
     m_shadowBookmarks.resize(frameCount);
 
     ecs::Registry &registry = m_scene->getRegistry();
 
-    auto meshSwapCb = [this, &registry](ecs::Entity entity, uint32_t newSlot) {
-        Mobility mobility;
-        if (s_tryReadMeshMobility(registry, entity, mobility)) {
-            m_meshSlots[entity] = m_meshes.getGlobalSlot(mobility, newSlot);
+    // a slot moved within its partition, which is the one its entry was allocated against
+    auto meshSwapCb = [this](ecs::Entity entity, uint32_t newSlot) {
+        if (RenderSlot *slot = m_meshSlots.find(entity)) {
+            slot->globalSlot = m_meshes.getGlobalSlot(slot->mobility, newSlot);
+            m_meshSlotVersion++;
         }
     };
-    auto lightSwapCb = [this, &registry](ecs::Entity entity, uint32_t newSlot) {
-        const LightComponent *light = Light_tryReadLight(ecs::EntityAccessor(entity, &registry));
-        if (light != nullptr) {
-            m_lightSlots[entity] = m_lights.getGlobalSlot(light->mobility, newSlot);
+    auto lightSwapCb = [this](ecs::Entity entity, uint32_t newSlot) {
+        if (RenderSlot *slot = m_lightSlots.find(entity)) {
+            slot->globalSlot = m_lights.getGlobalSlot(slot->mobility, newSlot);
         }
     };
-    auto cameraSwapCb = [this, &registry](ecs::Entity entity, uint32_t newSlot) {
-        if (registry.has<CameraComponent>(entity)) {
-            m_cameraSlots[entity] = m_cameras.getGlobalSlot(MOBILITY_DYNAMIC, newSlot);
+    auto cameraSwapCb = [this](ecs::Entity entity, uint32_t newSlot) {
+        if (RenderSlot *slot = m_cameraSlots.find(entity)) {
+            slot->globalSlot = m_cameras.getGlobalSlot(slot->mobility, newSlot);
         }
     };
-    auto shadowSwapCb = [this, &registry](ecs::Entity entity, uint32_t newSlot) {
-        if (const ShadowComponent *shadow = registry.tryRead<ShadowComponent>(entity)) {
-            m_shadowSlots[entity] = m_shadows.getGlobalSlot(shadow->mobility, newSlot);
-            return;
-        }
-        if (const CascadedShadowComponent *cascaded = registry.tryRead<CascadedShadowComponent>(entity)) {
-            m_shadowSlots[entity] = m_shadows.getGlobalSlot(cascaded->mobility, newSlot);
+    auto shadowSwapCb = [this](ecs::Entity entity, uint32_t newSlot) {
+        if (RenderSlot *slot = m_shadowSlots.find(entity)) {
+            slot->globalSlot = m_shadows.getGlobalSlot(slot->mobility, newSlot);
         }
     };
 
@@ -81,32 +74,42 @@ SceneRenderData::SceneRenderData(const RenderContext &renderContext, Scene &scen
         m_shadows.getPartition(static_cast<Mobility>(i)).init(frameCount, shadowSwapCb);
     }
 
-    m_connections.push_back(registry.onConstructScoped<StaticMeshComponent>([this](ecs::Entity entity) { onMeshAdded(entity); }));
+    // slot handlers only hand out storage nothing reads before the next frame is packed, so a bulk load
+    // may hold them back and hand the slots out in one go
+    constexpr ecs::SignalDispatch SLOTS = ecs::SIGNAL_DISPATCH_DEFERRABLE;
+    auto meshAdded = [this](ecs::Entity entity) { onMeshAdded(entity); };
+
+    m_connections.push_back(registry.onConstructScoped<StaticMeshComponent>(meshAdded, SLOTS));
     m_connections.push_back(registry.onDestroyScoped<StaticMeshComponent>([this](ecs::Entity entity) { onMeshRemoved(entity); }));
 
-    m_connections.push_back(registry.onConstructScoped<SkeletalMeshComponent>([this](ecs::Entity entity) { onMeshAdded(entity); }));
+    m_connections.push_back(registry.onConstructScoped<SkeletalMeshComponent>(meshAdded, SLOTS));
     m_connections.push_back(registry.onDestroyScoped<SkeletalMeshComponent>([this](ecs::Entity entity) { onMeshRemoved(entity); }));
 
     connectLightSignals<DirectionalLightComponent>(registry);
     connectLightSignals<PointLightComponent>(registry);
     connectLightSignals<SpotLightComponent>(registry);
 
-    m_connections.push_back(registry.onConstructScoped<CameraComponent>([this](ecs::Entity entity) { onCameraAdded(entity); }));
+    auto cameraAdded = [this](ecs::Entity entity) { onCameraAdded(entity); };
+    m_connections.push_back(registry.onConstructScoped<CameraComponent>(cameraAdded, SLOTS));
     m_connections.push_back(registry.onDestroyScoped<CameraComponent>([this](ecs::Entity entity) { onCameraRemoved(entity); }));
 
-    m_connections.push_back(registry.onConstructScoped<ShadowComponent>([this](ecs::Entity entity) {
-        onShadowAdded(entity);
-        createShadowMap(entity);
-    }));
+    m_connections.push_back(registry.onConstructScoped<ShadowComponent>(
+        [this](ecs::Entity entity) {
+            onShadowAdded(entity);
+            createShadowMap(entity);
+        },
+        SLOTS));
     m_connections.push_back(registry.onDestroyScoped<ShadowComponent>([this](ecs::Entity entity) {
         destroyShadowMap(entity);
         onShadowRemoved(entity);
     }));
 
-    m_connections.push_back(registry.onConstructScoped<CascadedShadowComponent>([this](ecs::Entity entity) {
-        onCascadedShadowAdded(entity);
-        createCascadedShadowMap(entity);
-    }));
+    m_connections.push_back(registry.onConstructScoped<CascadedShadowComponent>(
+        [this](ecs::Entity entity) {
+            onCascadedShadowAdded(entity);
+            createCascadedShadowMap(entity);
+        },
+        SLOTS));
     m_connections.push_back(registry.onDestroyScoped<CascadedShadowComponent>([this](ecs::Entity entity) {
         destroyCascadedShadowMap(entity);
         onCascadedShadowRemoved(entity);
@@ -143,12 +146,27 @@ SceneRenderData::SceneRenderData(const RenderContext &renderContext, Scene &scen
 template <typename T>
 void SceneRenderData::connectLightSignals(ecs::Registry &registry)
 {
-    m_connections.push_back(registry.onConstructScoped<T>([this](ecs::Entity entity) { onLightAdded(entity); }));
+    auto lightAdded = [this](ecs::Entity entity) { onLightAdded(entity); };
+    m_connections.push_back(registry.onConstructScoped<T>(lightAdded, ecs::SIGNAL_DISPATCH_DEFERRABLE));
     m_connections.push_back(registry.onDestroyScoped<T>([this](ecs::Entity entity) { onLightRemoved(entity); }));
 }
 
 SceneRenderData::~SceneRenderData() = default;
 
+template <typename T>
+void SceneRenderData::freeStoreSlot(GPUDataStore<T> &store, RenderSlotMap &slots, ecs::Entity entityId)
+{
+    const RenderSlot *found = slots.find(entityId);
+    if (found == nullptr) {
+        return;
+    }
+
+    // copied out, freeing swaps the partition's last slot into this one and rewrites that slot's entry
+    const RenderSlot slot = *found;
+    store.getPartition(slot.mobility).freeSlot(store.getLocalSlot(slot.mobility, slot.globalSlot));
+    slots.erase(entityId);
+}
+
 void SceneRenderData::onMeshAdded(ecs::Entity entityId)
 {
     Mobility mobility;
@@ -157,20 +175,12 @@ void SceneRenderData::onMeshAdded(ecs::Entity entityId)
     }
 
     uint32_t localSlot = m_meshes.getPartition(mobility).allocateSlot(entityId);
-    m_meshSlots[entityId] = m_meshes.getGlobalSlot(mobility, localSlot);
+    m_meshSlots.assign(entityId, {m_meshes.getGlobalSlot(mobility, localSlot), mobility});
 }
 
 void SceneRenderData::onMeshRemoved(ecs::Entity entityId)
 {
-    Mobility mobility;
-    uint32_t globalSlot = getMeshSlot(entityId);
-    if (!s_tryReadMeshMobility(m_scene->getRegistry(), entityId, mobility) || globalSlot == UINT32_MAX) {
-        return;
-    }
-
-    uint32_t localSlot = m_meshes.getLocalSlot(mobility, globalSlot);
-    m_meshes.getPartition(mobility).freeSlot(localSlot);
-    m_meshSlots.erase(entityId);
+    freeStoreSlot(m_meshes, m_meshSlots, entityId);
 }
 
 void SceneRenderData::setMeshMobility(ecs::Entity entityId, Mobility mobility)
@@ -182,10 +192,14 @@ void SceneRenderData::setMeshMobility(ecs::Entity entityId, Mobility mobility)
     }
 
     // The slot is freed against the old mobility and reallocated against the new one, so the
-    // component's mobility is only changed between the two.
+    // component's mobility is only changed between the two. One that has no slot yet is still owed its
+    // construct handler, which allocates against whatever mobility it finds by then.
+    const bool hadSlot = m_meshSlots.find(entityId) != nullptr;
     onMeshRemoved(entityId);
     registry.write<StaticMeshComponent>(entityId)->mobility = mobility;
-    onMeshAdded(entityId);
+    if (hadSlot) {
+        onMeshAdded(entityId);
+    }
 }
 
 void SceneRenderData::setLightMobility(ecs::Entity entityId, Mobility mobility)
@@ -196,9 +210,12 @@ void SceneRenderData::setLightMobility(ecs::Entity entityId, Mobility mobility)
         return;
     }
 
+    const bool hadSlot = m_lightSlots.find(entityId) != nullptr;
     onLightRemoved(entityId);
     Light_tryWriteLight(entity, ecs::ChannelBit(CHANNEL_LIGHT_PARAMS))->mobility = mobility;
-    onLightAdded(entityId);
+    if (hadSlot) {
+        onLightAdded(entityId);
+    }
 }
 
 void SceneRenderData::setShadowMobility(ecs::Entity entityId, Mobility mobility)
@@ -209,9 +226,12 @@ void SceneRenderData::setShadowMobility(ecs::Entity entityId, Mobility mobility)
         return;
     }
 
+    const bool hadSlot = m_shadowSlots.find(entityId) != nullptr;
     onShadowRemoved(entityId);
     registry.write<ShadowComponent>(entityId)->mobility = mobility;
-    onShadowAdded(entityId);
+    if (hadSlot) {
+        onShadowAdded(entityId);
+    }
 }
 
 void SceneRenderData::setCascadedShadowMobility(ecs::Entity entityId, Mobility mobility)
@@ -222,9 +242,12 @@ void SceneRenderData::setCascadedShadowMobility(ecs::Entity entityId, Mobility m
         return;
     }
 
+    const bool hadSlot = m_shadowSlots.find(entityId) != nullptr;
     onCascadedShadowRemoved(entityId);
     registry.write<CascadedShadowComponent>(entityId)->mobility = mobility;
-    onCascadedShadowAdded(entityId);
+    if (hadSlot) {
+        onCascadedShadowAdded(entityId);
+    }
 }
 
 void SceneRenderData::onLightAdded(ecs::Entity entityId)
@@ -234,19 +257,12 @@ void SceneRenderData::onLightAdded(ecs::Entity entityId)
         return;
     }
     uint32_t localSlot = m_lights.getPartition(light->mobility).allocateSlot(entityId);
-    m_lightSlots[entityId] = m_lights.getGlobalSlot(light->mobility, localSlot);
+    m_lightSlots.assign(entityId, {m_lights.getGlobalSlot(light->mobility, localSlot), light->mobility});
 }
 
 void SceneRenderData::onLightRemoved(ecs::Entity entityId)
 {
-    const LightComponent *light = Light_tryReadLight(ecs::EntityAccessor(entityId, &m_scene->getRegistry()));
-    uint32_t globalSlot = getLightSlot(entityId);
-    if (light == nullptr || globalSlot == UINT32_MAX) {
-        return;
-    }
-    uint32_t localSlot = m_lights.getLocalSlot(light->mobility, globalSlot);
-    m_lights.getPartition(light->mobility).freeSlot(localSlot);
-    m_lightSlots.erase(entityId);
+    freeStoreSlot(m_lights, m_lightSlots, entityId);
 }
 
 void SceneRenderData::onCameraAdded(ecs::Entity entityId)
@@ -256,19 +272,12 @@ void SceneRenderData::onCameraAdded(ecs::Entity entityId)
     }
 
     uint32_t localSlot = m_cameras.getPartition(MOBILITY_DYNAMIC).allocateSlot(entityId);
-    m_cameraSlots[entityId] = m_cameras.getGlobalSlot(MOBILITY_DYNAMIC, localSlot);
+    m_cameraSlots.assign(entityId, {m_cameras.getGlobalSlot(MOBILITY_DYNAMIC, localSlot), MOBILITY_DYNAMIC});
 }
 
 void SceneRenderData::onCameraRemoved(ecs::Entity entityId)
 {
-    uint32_t globalSlot = getCameraSlot(entityId);
-    if (globalSlot == UINT32_MAX) {
-        return;
-    }
-
-    uint32_t localSlot = m_cameras.getLocalSlot(MOBILITY_DYNAMIC, globalSlot);
-    m_cameras.getPartition(MOBILITY_DYNAMIC).freeSlot(localSlot);
-    m_cameraSlots.erase(entityId);
+    freeStoreSlot(m_cameras, m_cameraSlots, entityId);
 }
 
 void SceneRenderData::onShadowAdded(ecs::Entity entityId)
@@ -279,20 +288,12 @@ void SceneRenderData::onShadowAdded(ecs::Entity entityId)
     }
 
     uint32_t localSlot = m_shadows.getPartition(shadow->mobility).allocateSlot(entityId);
-    m_shadowSlots[entityId] = m_shadows.getGlobalSlot(shadow->mobility, localSlot);
+    m_shadowSlots.assign(entityId, {m_shadows.getGlobalSlot(shadow->mobility, localSlot), shadow->mobility});
 }
 
 void SceneRenderData::onShadowRemoved(ecs::Entity entityId)
 {
-    const ShadowComponent *shadow = m_scene->getRegistry().tryRead<ShadowComponent>(entityId);
-    uint32_t globalSlot = getShadowSlot(entityId);
-    if (shadow == nullptr || globalSlot == UINT32_MAX) {
-        return;
-    }
-
-    uint32_t localSlot = m_shadows.getLocalSlot(shadow->mobility, globalSlot);
-    m_shadows.getPartition(shadow->mobility).freeSlot(localSlot);
-    m_shadowSlots.erase(entityId);
+    freeStoreSlot(m_shadows, m_shadowSlots, entityId);
 }
 
 void SceneRenderData::onCascadedShadowAdded(ecs::Entity entityId)
@@ -303,20 +304,12 @@ void SceneRenderData::onCascadedShadowAdded(ecs::Entity entityId)
     }
 
     uint32_t localSlot = m_shadows.getPartition(shadow->mobility).allocateSlot(entityId);
-    m_shadowSlots[entityId] = m_shadows.getGlobalSlot(shadow->mobility, localSlot);
+    m_shadowSlots.assign(entityId, {m_shadows.getGlobalSlot(shadow->mobility, localSlot), shadow->mobility});
 }
 
 void SceneRenderData::onCascadedShadowRemoved(ecs::Entity entityId)
 {
-    const CascadedShadowComponent *shadow = m_scene->getRegistry().tryRead<CascadedShadowComponent>(entityId);
-    uint32_t globalSlot = getShadowSlot(entityId);
-    if (shadow == nullptr || globalSlot == UINT32_MAX) {
-        return;
-    }
-
-    uint32_t localSlot = m_shadows.getLocalSlot(shadow->mobility, globalSlot);
-    m_shadows.getPartition(shadow->mobility).freeSlot(localSlot);
-    m_shadowSlots.erase(entityId);
+    freeStoreSlot(m_shadows, m_shadowSlots, entityId);
 }
 
 void SceneRenderData::createShadowMap(ecs::Entity entityId)
@@ -353,10 +346,11 @@ void SceneRenderData::destroyCascadedShadowMap(ecs::Entity entityId)
     m_cascadedShadowMaps.erase(entityId);
 }
 
-static uint32_t s_lookupSlot(const std::unordered_map<ecs::Entity, uint32_t> &slots, ecs::Entity entityId)
+template <typename Slot>
+static uint32_t s_lookupSlot(const ecs::EntityMap<Slot> &slots, ecs::Entity entityId)
 {
-    auto it = slots.find(entityId);
-    return it != slots.end() ? it->second : UINT32_MAX;
+    const Slot *slot = slots.find(entityId);
+    return slot != nullptr ? slot->globalSlot : UINT32_MAX;
 }
 
 uint32_t SceneRenderData::getMeshSlot(ecs::Entity entityId) const
@@ -391,318 +385,102 @@ CascadedShadowMap *SceneRenderData::getCascadedShadowMap(ecs::Entity entityId) c
     return it != m_cascadedShadowMaps.end() ? it->second.get() : nullptr;
 }
 
-void SceneRenderData::consumeChanges(StoreBookmarks &bookmarks, SceneChannel paramsChannel,
-                                     const std::function<void(ecs::Entity)> &repackEntity, const std::function<void()> &repackAll)
+void SceneRenderData::onUpdate(uint32_t frameIndex)
 {
-    ecs::Journal &journal = m_scene->getRegistry().getJournal();
+    RAPTURE_PROFILE_SCOPE("SceneRenderData::onUpdate");
 
-    ecs::Batch transforms = journal.readSince(CHANNEL_TRANSFORM_WORLD, bookmarks.transform);
-    ecs::Batch params = journal.readSince(paramsChannel, bookmarks.params);
+    ecs::Registry &registry = m_scene->getRegistry();
 
-    if (transforms.needsRebuild() || params.needsRebuild()) {
-        repackAll();
-        return;
-    }
+    // the journal is read here, a slot the partition moved was already marked when it moved
+    {
+        RAPTURE_PROFILE_SCOPE("SceneRenderData::markChangedSlots");
+        ecs::Journal &journal = registry.getJournal();
+        markChangedSlots(journal, m_meshes, m_meshSlots, m_meshBookmarks[frameIndex], CHANNEL_MESH_BINDING, frameIndex);
+        markChangedSlots(journal, m_lights, m_lightSlots, m_lightBookmarks[frameIndex], CHANNEL_LIGHT_PARAMS, frameIndex);
+        markChangedSlots(journal, m_shadows, m_shadowSlots, m_shadowBookmarks[frameIndex], CHANNEL_SHADOW_SETTINGS, frameIndex);
 
-    for (ecs::Entity entity : transforms) {
-        repackEntity(entity);
-    }
-    for (ecs::Entity entity : params) {
-        repackEntity(entity);
+        // prevViewProj is per frame state rather than a mirror of the component, so a camera is
+        // repacked every frame instead of when something announces a change
+        markAllSlots(m_cameras, frameIndex);
     }
-}
 
-void SceneRenderData::onUpdate(uint32_t frameIndex)
-{
-    RAPTURE_PROFILE_SCOPE("SceneRenderData::onUpdate");
+    // the four stores share no slots, so their chunks are packed side by side on one set of jobs
+    const MeshPacker meshPacker(registry);
+    const LightPacker lightPacker(registry);
+    const CameraPacker cameraPacker(registry);
+    auto shadowPacker = [this](RenderPartition<ShadowGPUData> &partition, uint32_t slot) { packShadow(partition, slot); };
 
-    updateMeshes(frameIndex);
-    updateLights(frameIndex);
-    updateCameras(frameIndex);
-    updateShadows(frameIndex);
+    for (uint32_t m = 0; m < MOBILITY_COUNT; m++) {
+        const Mobility mobility = static_cast<Mobility>(m);
+        m_packer.add(m_meshes.getPartition(mobility), frameIndex, meshPacker);
+        m_packer.add(m_lights.getPartition(mobility), frameIndex, lightPacker);
+        m_packer.add(m_cameras.getPartition(mobility), frameIndex, cameraPacker);
+        m_packer.add(m_shadows.getPartition(mobility), frameIndex, shadowPacker);
+    }
+    m_packer.run();
 
     m_meshes.upload(frameIndex);
     m_lights.upload(frameIndex);
     m_cameras.upload(frameIndex);
     m_shadows.upload(frameIndex);
-}
-
-void SceneRenderData::updateMeshes(uint32_t frameIndex)
-{
-    RAPTURE_PROFILE_SCOPE("SceneRenderData::updateMeshes");
-
-    auto packMesh = [this](RenderPartition<MeshGPUData> &partition, uint32_t i) {
-        ecs::Registry &registry = m_scene->getRegistry();
-        ecs::Entity entityId = partition.getEntityId(i);
-
-        const TransformComponent *transform = registry.tryRead<TransformComponent>(entityId);
-        if (transform == nullptr) {
-            return;
-        }
-
-        const Mesh *mesh = nullptr;
-        uint32_t boneOffset = UINT32_MAX;
-
-        if (const StaticMeshComponent *staticMesh = registry.tryRead<StaticMeshComponent>(entityId)) {
-            mesh = staticMesh->mesh.get();
-        } else if (const SkeletalMeshComponent *skeletal = registry.tryRead<SkeletalMeshComponent>(entityId)) {
-            mesh = skeletal->mesh.get();
-            if (skeletal->pose != nullptr) {
-                boneOffset = skeletal->pose->getBoneOffset();
-            }
-        }
-
-        if (mesh == nullptr) {
-            return;
-        }
-
-        MeshGPUData &data = partition.getSlotData(i);
-        data.modelMatrix = transform->world;
-        data.vertexBufferFlags = mesh->getVertexBuffer()->getBufferLayout().getFlags();
-        data.entityId = entityId;
-        data.materialIndex = 0;
-        data.boneOffset = boneOffset;
-    };
-
-    // a slot the partition moved needs repacking whether or not its entity changed
-    for (uint32_t m = 0; m < MOBILITY_COUNT; m++) {
-        auto &partition = m_meshes.getPartition(static_cast<Mobility>(m));
-        partition.forEachDirty(frameIndex, [&](uint32_t i) { packMesh(partition, i); });
-    }
-
-    ecs::Registry &registry = m_scene->getRegistry();
-
-    auto repackEntity = [&](ecs::Entity entityId) {
-        Mobility mobility;
-        uint32_t globalSlot = getMeshSlot(entityId);
-        if (!s_tryReadMeshMobility(registry, entityId, mobility) || globalSlot == UINT32_MAX) {
-            return;
-        }
-
-        auto &partition = m_meshes.getPartition(mobility);
-        uint32_t localSlot = m_meshes.getLocalSlot(mobility, globalSlot);
-        packMesh(partition, localSlot);
-        partition.markDirty(frameIndex, localSlot);
-    };
-
-    auto repackAll = [&]() {
-        for (uint32_t m = 0; m < MOBILITY_COUNT; m++) {
-            auto &partition = m_meshes.getPartition(static_cast<Mobility>(m));
-            for (uint32_t i = 0; i < partition.getCount(); i++) {
-                packMesh(partition, i);
-                partition.markDirty(frameIndex, i);
-            }
-        }
-    };
-
-    consumeChanges(m_meshBookmarks[frameIndex], CHANNEL_MESH_BINDING, repackEntity, repackAll);
-}
-
-void SceneRenderData::updateLights(uint32_t frameIndex)
-{
-    RAPTURE_PROFILE_SCOPE("SceneRenderData::updateLights");
-
-    auto packLight = [&](RenderPartition<LightGPUData> &partition, uint32_t i) {
-        ecs::Registry &registry = m_scene->getRegistry();
-        ecs::Entity entityId = partition.getEntityId(i);
-        ecs::EntityAccessor entity(entityId, &registry);
-
-        const TransformComponent *transform = registry.tryRead<TransformComponent>(entityId);
-        const LightComponent *light = Light_tryReadLight(entity);
-        if (transform == nullptr || light == nullptr) {
-            return;
-        }
-
-        LightType type = Light_getLightType(entity);
 
-        auto &data = partition.getSlotData(i);
-
-        glm::vec3 position = transform::translation(transform->world);
-        if (type == LightType::DIRECTIONAL) {
-            position = glm::vec3(0.0f);
-        }
-        data.positionAndType = glm::vec4(position, static_cast<float>(type));
-
-        glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
-        if (type == LightType::DIRECTIONAL || type == LightType::SPOT) {
-            direction = transform::forward(transform->world);
-        }
-
-        float range = 0.0f;
-        float innerCos = 0.0f;
-        float outerCos = 0.0f;
-        if (const SpotLightComponent *spot = registry.tryRead<SpotLightComponent>(entityId)) {
-            range = spot->range;
-            innerCos = std::cos(spot->innerConeAngle);
-            outerCos = std::cos(spot->outerConeAngle);
-        } else if (const PointLightComponent *point = registry.tryRead<PointLightComponent>(entityId)) {
-            range = point->range;
-        }
-        data.directionAndRange = glm::vec4(direction, range);
-
-        data.colorAndIntensity = glm::vec4(light->color, light->intensity);
-
-        data.spotAngles = glm::vec4(innerCos, outerCos, static_cast<float>(entityId), 0.0f);
-    };
-
-    for (uint32_t m = 0; m < MOBILITY_COUNT; m++) {
-        auto &partition = m_lights.getPartition(static_cast<Mobility>(m));
-        partition.forEachDirty(frameIndex, [&](uint32_t i) { packLight(partition, i); });
+    uint64_t uploadBytes = 0;
+    uint32_t uploadRegions = 0;
+    for (const GPUUploadStats *stats : {&m_meshes.getLastUploadStats(), &m_lights.getLastUploadStats(),
+                                        &m_cameras.getLastUploadStats(), &m_shadows.getLastUploadStats()}) {
+        uploadBytes += stats->bytes;
+        uploadRegions += stats->regions;
     }
-
-    ecs::Registry &registry = m_scene->getRegistry();
-
-    auto repackEntity = [&](ecs::Entity entityId) {
-        const LightComponent *light = Light_tryReadLight(ecs::EntityAccessor(entityId, &registry));
-        uint32_t globalSlot = getLightSlot(entityId);
-        if (light == nullptr || globalSlot == UINT32_MAX) {
-            return;
-        }
-
-        auto &partition = m_lights.getPartition(light->mobility);
-        uint32_t localSlot = m_lights.getLocalSlot(light->mobility, globalSlot);
-        packLight(partition, localSlot);
-        partition.markDirty(frameIndex, localSlot);
-    };
-
-    auto repackAll = [&]() {
-        for (uint32_t m = 0; m < MOBILITY_COUNT; m++) {
-            auto &partition = m_lights.getPartition(static_cast<Mobility>(m));
-            for (uint32_t i = 0; i < partition.getCount(); i++) {
-                packLight(partition, i);
-                partition.markDirty(frameIndex, i);
-            }
-        }
-    };
-
-    consumeChanges(m_lightBookmarks[frameIndex], CHANNEL_LIGHT_PARAMS, repackEntity, repackAll);
+    RAPTURE_PROFILE_PLOT("SceneRenderData Upload Bytes", static_cast<int64_t>(uploadBytes));
+    RAPTURE_PROFILE_PLOT("SceneRenderData Upload Regions", static_cast<int64_t>(uploadRegions));
+    RAPTURE_PROFILE_PLOT("SceneRenderData Packed Slots", static_cast<int64_t>(m_packer.getLastStats().slots));
 }
 
-void SceneRenderData::updateCameras(uint32_t frameIndex)
+void SceneRenderData::packShadow(RenderPartition<ShadowGPUData> &partition, uint32_t slot) const
 {
-    RAPTURE_PROFILE_SCOPE("SceneRenderData::updateCameras");
-    (void)frameIndex;
-
     ecs::Registry &registry = m_scene->getRegistry();
-    auto &partition = m_cameras.getPartition(MOBILITY_DYNAMIC);
-
-    for (uint32_t i = 0; i < partition.getCount(); i++) {
-        ecs::Entity entityId = partition.getEntityId(i);
-        if (!registry.hasAll<TransformComponent, CameraComponent>(entityId)) {
-            continue;
-        }
-
-        // hasRenderData records what this slot holds, not a change to the camera
-        auto camera = registry.write<CameraComponent>(entityId, 0);
-        auto &data = partition.getSlotData(i);
-
-        // Carried from the values this slot still holds, so it lags exactly one update
-        const glm::mat4 previousViewProj = data.projection * data.view;
+    ecs::Entity entityId = partition.getEntityId(slot);
+    ecs::EntityAccessor entity(entityId, &registry);
 
-        data.view = camera->camera.getViewMatrix();
-        data.projection = camera->camera.getProjectionMatrix();
-        data.invViewProj = glm::inverse(data.projection * data.view);
-
-        // A slot that has never been updated holds a zero matrix, which would reproject to w = 0
-        data.prevViewProj = camera->hasRenderData ? previousViewProj : (data.projection * data.view);
-        camera->hasRenderData = true;
-
-        // prevViewProj is per frame state rather than a mirror of the component, so a camera is
-        // repacked every frame instead of when something announces a change
-        partition.markDirty(frameIndex, i);
+    if (Light_tryReadLight(entity) == nullptr) {
+        return;
     }
-}
 
-void SceneRenderData::updateShadows(uint32_t frameIndex)
-{
-    RAPTURE_PROFILE_SCOPE("SceneRenderData::updateShadows");
+    auto &data = partition.getSlotData(slot);
 
-    auto packShadow = [&](RenderPartition<ShadowGPUData> &partition, uint32_t i) {
-        ecs::Registry &registry = m_scene->getRegistry();
-        ecs::Entity entityId = partition.getEntityId(i);
-        ecs::EntityAccessor entity(entityId, &registry);
-
-        if (Light_tryReadLight(entity) == nullptr) {
-            return;
-        }
-
-        auto &data = partition.getSlotData(i);
-
-        const ShadowComponent *shadow = registry.tryRead<ShadowComponent>(entityId);
-        ShadowMap *shadowMap = getShadowMap(entityId);
-        if (shadow != nullptr && shadowMap != nullptr && shadow->isActive) {
-            data.type = static_cast<int>(Light_getLightType(entity));
-            data.cascadeCount = 1;
-            data.lightIndex = entityId;
-            data.textureHandle = shadowMap->getTextureHandle();
-            data.cascadeMatrices[0] = shadowMap->getLightViewProjection();
-            data.cascadeSplitsViewSpace[0] = glm::vec4(0.0f);
-            return;
-        }
-
-        const CascadedShadowComponent *cascaded = registry.tryRead<CascadedShadowComponent>(entityId);
-        CascadedShadowMap *cascadedMap = getCascadedShadowMap(entityId);
-        if (cascaded != nullptr && cascadedMap != nullptr && cascaded->isActive) {
-            data.type = static_cast<int>(Light_getLightType(entity));
-            data.lightIndex = entityId;
-            data.textureHandle = cascadedMap->getTextureHandle();
-
-            // both are filled by the first cascade update, which a light packed before its shadow
-            // pass has ever run has not had yet
-            std::vector<glm::mat4> matrices = cascadedMap->getLightViewProjections();
-            std::vector<float> splits = cascadedMap->getCascadeSplits();
-            size_t count = std::min<size_t>(cascadedMap->getNumCascades(), matrices.size());
-            count = std::min<size_t>(count, splits.empty() ? 0 : splits.size() - 1);
-            count = std::min<size_t>(count, MAX_CASCADES);
-
-            data.cascadeCount = static_cast<uint32_t>(count);
-            for (size_t c = 0; c < count; c++) {
-                data.cascadeMatrices[c] = matrices[c];
-                data.cascadeSplitsViewSpace[c] = glm::vec4(splits[c], splits[c + 1], 0.0f, -1.0f);
-            }
-        }
-    };
-
-    for (uint32_t m = 0; m < MOBILITY_COUNT; m++) {
-        auto &partition = m_shadows.getPartition(static_cast<Mobility>(m));
-        partition.forEachDirty(frameIndex, [&](uint32_t i) { packShadow(partition, i); });
+    const ShadowComponent *shadow = registry.tryRead<ShadowComponent>(entityId);
+    ShadowMap *shadowMap = getShadowMap(entityId);
+    if (shadow != nullptr && shadowMap != nullptr && shadow->isActive) {
+        data.type = static_cast<int>(Light_getLightType(entity));
+        data.cascadeCount = 1;
+        data.lightIndex = entityId;
+        data.textureHandle = shadowMap->getTextureHandle();
+        data.cascadeMatrices[0] = shadowMap->getLightViewProjection();
+        data.cascadeSplitsViewSpace[0] = glm::vec4(0.0f);
+        return;
     }
 
-    ecs::Registry &registry = m_scene->getRegistry();
-
-    auto repackEntity = [&](ecs::Entity entityId) {
-        Mobility mobility = MOBILITY_DYNAMIC;
-        uint32_t globalSlot = getShadowSlot(entityId);
-
-        if (const ShadowComponent *shadow = registry.tryRead<ShadowComponent>(entityId)) {
-            mobility = shadow->mobility;
-        } else if (const CascadedShadowComponent *cascaded = registry.tryRead<CascadedShadowComponent>(entityId)) {
-            mobility = cascaded->mobility;
-        } else {
-            return;
+    const CascadedShadowComponent *cascaded = registry.tryRead<CascadedShadowComponent>(entityId);
+    CascadedShadowMap *cascadedMap = getCascadedShadowMap(entityId);
+    if (cascaded != nullptr && cascadedMap != nullptr && cascaded->isActive) {
+        data.type = static_cast<int>(Light_getLightType(entity));
+        data.lightIndex = entityId;
+        data.textureHandle = cascadedMap->getTextureHandle();
+
+        // both are filled by the first cascade update, which a light packed before its shadow
+        // pass has ever run has not had yet
+        std::vector<glm::mat4> matrices = cascadedMap->getLightViewProjections();
+        std::vector<float> splits = cascadedMap->getCascadeSplits();
+        size_t count = std::min<size_t>(cascadedMap->getNumCascades(), matrices.size());
+        count = std::min<size_t>(count, splits.empty() ? 0 : splits.size() - 1);
+        count = std::min<size_t>(count, MAX_CASCADES);
+
+        data.cascadeCount = static_cast<uint32_t>(count);
+        for (size_t c = 0; c < count; c++) {
+            data.cascadeMatrices[c] = matrices[c];
+            data.cascadeSplitsViewSpace[c] = glm::vec4(splits[c], splits[c + 1], 0.0f, -1.0f);
         }
-
-        if (globalSlot == UINT32_MAX) {
-            return;
-        }
-
-        auto &partition = m_shadows.getPartition(mobility);
-        uint32_t localSlot = m_shadows.getLocalSlot(mobility, globalSlot);
-        packShadow(partition, localSlot);
-        partition.markDirty(frameIndex, localSlot);
-    };
-
-    auto repackAll = [&]() {
-        for (uint32_t m = 0; m < MOBILITY_COUNT; m++) {
-            auto &partition = m_shadows.getPartition(static_cast<Mobility>(m));
-            for (uint32_t i = 0; i < partition.getCount(); i++) {
-                packShadow(partition, i);
-                partition.markDirty(frameIndex, i);
-            }
-        }
-    };
-
-    consumeChanges(m_shadowBookmarks[frameIndex], CHANNEL_SHADOW_SETTINGS, repackEntity, repackAll);
+    }
 }
 
 } // namespace Rapture
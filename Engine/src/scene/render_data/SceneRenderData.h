@@ -2,14 +2,15 @@
 #define RAPTURE__SCENERENDERDATA_H
 
 #include "scene/components/ChangeChannels.h"
+#include "scene/render_data/RenderDataPacking.h"
 #include "scene/render_data/SkeletonInstanceManager.h"
 #include "renderer/GPUDataStructs.h"
 #include "renderer/RenderPartition.h"
 
+#include "core/ecs/entity_map.h"
 #include "core/ecs/registry.h"
 #include "gpu/vulkan_context/RenderContext.h"
 
-#include <functional>
 #include <memory>
 #include <unordered_map>
 
@@ -23,7 +24,9 @@ class CascadedShadowMap;
  *
  * Manages GPUDataStores for meshes, lights, and cameras. Hooks into
  * the scene's registry via signals for slot lifecycle, and packs
- * component data into SSBOs each frame.
+ * component data into SSBOs each frame. The journal is read and the
+ * changed slots marked on the calling thread, then the marked slots of
+ * every store are packed together on jobs, see RenderDataPacker.
  */
 class SceneRenderData {
   public:
@@ -80,6 +83,13 @@ class SceneRenderData {
      */
     uint32_t getMeshSlot(ecs::Entity entityId) const;
 
+    /**
+     * @brief Bumped whenever a mesh other than the one being added or removed is moved to another slot
+     *
+     * Whoever keeps mesh slots around compares this to tell when to look them up again.
+     */
+    uint64_t getMeshSlotVersion() const { return m_meshSlotVersion; }
+
     /**
      * @brief Where an entity's light data was packed
      * @param entityId Entity holding a light component
@@ -150,22 +160,32 @@ class SceneRenderData {
     void createCascadedShadowMap(ecs::Entity entityId);
     void destroyCascadedShadowMap(ecs::Entity entityId);
 
-    void updateMeshes(uint32_t frameIndex);
-    void updateLights(uint32_t frameIndex);
-    void updateCameras(uint32_t frameIndex);
-    void updateShadows(uint32_t frameIndex);
+    /**
+     * @brief Packs a shadow slot from the light's shadow component and the map owned for it
+     *
+     * Reads only, the shadow maps are neither created nor destroyed while slots are packed.
+     */
+    void packShadow(RenderPartition<ShadowGPUData> &partition, uint32_t slot) const;
 
     GPUDataStore<MeshGPUData> m_meshes;
     GPUDataStore<LightGPUData> m_lights;
     GPUDataStore<CameraGPUData> m_cameras;
     GPUDataStore<ShadowGPUData> m_shadows;
 
+    /**
+     * @brief Frees an entity's slot in a store and forgets it
+     */
+    template <typename T>
+    void freeStoreSlot(GPUDataStore<T> &store, RenderSlotMap &slots, ecs::Entity entityId);
+
     // where each entity's data landed in its store, held here rather than on the component so that
-    // overwriting a component cannot lose the slot it was handed
-    std::unordered_map<ecs::Entity, uint32_t> m_meshSlots;
-    std::unordered_map<ecs::Entity, uint32_t> m_lightSlots;
-    std::unordered_map<ecs::Entity, uint32_t> m_cameraSlots;
-    std::unordered_map<ecs::Entity, uint32_t> m_shadowSlots;
+    // overwriting a component cannot lose the slot it was handed. Paged by entity index, since the
+    // mesh slot is looked up for every draw a frame records
+    RenderSlotMap m_meshSlots;
+    RenderSlotMap m_lightSlots;
+    RenderSlotMap m_cameraSlots;
+    RenderSlotMap m_shadowSlots;
+    uint64_t m_meshSlotVersion = 0;
 
     std::unordered_map<ecs::Entity, std::unique_ptr<ShadowMap>> m_shadowMaps;
     std::unordered_map<ecs::Entity, std::unique_ptr<CascadedShadowMap>> m_cascadedShadowMaps;
@@ -176,31 +196,13 @@ class SceneRenderData {
     Scene *m_scene = nullptr;
     uint32_t m_frameCount = 0;
 
-    /**
-     * @brief One store's position in the channels it mirrors, for one frame's buffer
-     */
-    struct StoreBookmarks {
-        ecs::Bookmark transform;
-        ecs::Bookmark params;
-    };
-
-    /**
-     * @brief Pulls both channels a store mirrors and repacks whatever they name
-     * @param bookmarks This frame's position in both channels
-     * @param paramsChannel The channel carrying this store's own parameters
-     * @param frameIndex Frame whose buffer is being brought up to date
-     * @param repackEntity Repacks one entity's slot, called only for entities that own one
-     * @param repackAll Repacks every slot, used when the reader fell too far behind
-     */
-    void consumeChanges(StoreBookmarks &bookmarks, SceneChannel paramsChannel,
-                        const std::function<void(ecs::Entity)> &repackEntity, const std::function<void()> &repackAll);
-
     std::vector<ecs::SignalConnection> m_connections;
 
-    std::vector<StoreBookmarks> m_meshBookmarks;
-    std::vector<StoreBookmarks> m_lightBookmarks;
-    std::vector<StoreBookmarks> m_cameraBookmarks;
-    std::vector<StoreBookmarks> m_shadowBookmarks;
+    std::vector<RenderStoreBookmarks> m_meshBookmarks;
+    std::vector<RenderStoreBookmarks> m_lightBookmarks;
+    std::vector<RenderStoreBookmarks> m_shadowBookmarks;
+
+    RenderDataPacker m_packer;
 };
 
 } // namespace Rapture
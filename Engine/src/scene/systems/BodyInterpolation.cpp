@@ -0,0 +1,132 @@
+#include "BodyInterpolation.h"
+
+#include "core/utils/TracyProfiler.h"
+#include "scene/components/Components.h"
+#include "scene/systems/Transforms.h"
+
+namespace Rapture {
+
+void BodyInterpolation::record(const SimulatedTarget &target, const physics::BodyState &state, CaptureSlot slot)
+{
+    const uint32_t *found = m_rows.find(target.entity);
+    uint32_t row = 0;
+    if (found != nullptr) {
+        row = *found;
+    } else {
+        // a body that just started moving has nothing to come from, so it starts where it is
+        row = static_cast<uint32_t>(m_entities.size());
+        m_rows.assign(target.entity, row);
+        m_entities.push_back(target.entity);
+        m_inverseLocals.emplace_back(1.0f);
+        m_positionOnly.push_back(0);
+        m_previousPositions.push_back(state.position);
+        m_previousRotations.push_back(state.rotation);
+        m_currentPositions.push_back(state.position);
+        m_currentRotations.push_back(state.rotation);
+        m_lastSeen.push_back(0);
+    }
+
+    m_inverseLocals[row] = target.inverseLocal;
+    m_positionOnly[row] = target.positionOnly ? 1 : 0;
+
+    if (slot == CAPTURE_PREVIOUS) {
+        // the current state stays here too unless the last step reports one, a body the last step
+        // did not report came to rest during it
+        m_previousPositions[row] = state.position;
+        m_previousRotations[row] = state.rotation;
+        m_currentPositions[row] = state.position;
+        m_currentRotations[row] = state.rotation;
+        return;
+    }
+
+    m_currentPositions[row] = state.position;
+    m_currentRotations[row] = state.rotation;
+    m_lastSeen[row] = m_capture;
+}
+
+void BodyInterpolation::place(float alpha, const ecs::Registry &registry, TransformHierarchy &transforms)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    if (m_entities.empty()) {
+        return;
+    }
+
+    alpha = glm::clamp(alpha, 0.0f, 1.0f);
+
+    const ecs::ComponentPool<TransformComponent> *components = registry.getPool<TransformComponent>();
+    m_placements.clear();
+    for (uint32_t row = 0; row < m_entities.size(); ++row) {
+        const ecs::Entity entity = m_entities[row];
+        const TransformComponent *component = components != nullptr ? components->tryGet(entity) : nullptr;
+        if (component == nullptr) {
+            continue;
+        }
+
+        const glm::vec3 position = glm::mix(m_previousPositions[row], m_currentPositions[row], alpha);
+
+        glm::mat4 world;
+        if (m_positionOnly[row] != 0) {
+            const glm::mat4 current = transform::toMat4(transforms.world(entity));
+            world = transform::compose(position, transform::rotation(current), transform::scale(current));
+        } else {
+            const glm::quat rotation = glm::slerp(m_previousRotations[row], m_currentRotations[row], alpha);
+            const glm::mat4 moved = transform::compose(position, rotation, glm::vec3(1.0f)) * m_inverseLocals[row];
+            world = transform::compose(transform::translation(moved), transform::rotation(moved), component->scale);
+        }
+        m_placements.push_back({entity, transform::toAffine(world)});
+    }
+
+    transforms.setWorlds(m_placements);
+
+    // rows at rest have just been placed where they stopped, and rows whose object is gone have
+    // nothing to place, so neither is carried into the next frame
+    for (uint32_t row = static_cast<uint32_t>(m_entities.size()); row-- > 0;) {
+        if (m_lastSeen[row] != m_capture || components == nullptr || !components->contains(m_entities[row])) {
+            removeRow(row);
+        }
+    }
+
+    RAPTURE_PROFILE_PLOT("Interpolated Bodies", static_cast<int64_t>(m_placements.size()));
+}
+
+void BodyInterpolation::removeRow(uint32_t row)
+{
+    const uint32_t last = static_cast<uint32_t>(m_entities.size()) - 1;
+    m_rows.erase(m_entities[row]);
+    if (row != last) {
+        m_entities[row] = m_entities[last];
+        m_inverseLocals[row] = m_inverseLocals[last];
+        m_positionOnly[row] = m_positionOnly[last];
+        m_previousPositions[row] = m_previousPositions[last];
+        m_previousRotations[row] = m_previousRotations[last];
+        m_currentPositions[row] = m_currentPositions[last];
+        m_currentRotations[row] = m_currentRotations[last];
+        m_lastSeen[row] = m_lastSeen[last];
+        m_rows.assign(m_entities[row], row);
+    }
+
+    m_entities.pop_back();
+    m_inverseLocals.pop_back();
+    m_positionOnly.pop_back();
+    m_previousPositions.pop_back();
+    m_previousRotations.pop_back();
+    m_currentPositions.pop_back();
+    m_currentRotations.pop_back();
+    m_lastSeen.pop_back();
+}
+
+void BodyInterpolation::clear()
+{
+    m_rows.clear();
+    m_entities.clear();
+    m_inverseLocals.clear();
+    m_positionOnly.clear();
+    m_previousPositions.clear();
+    m_previousRotations.clear();
+    m_currentPositions.clear();
+    m_currentRotations.clear();
+    m_lastSeen.clear();
+}
+
+} // namespace Rapture
@@ -0,0 +1,124 @@
+#ifndef RAPTURE__BODY_INTERPOLATION_H
+#define RAPTURE__BODY_INTERPOLATION_H
+
+#include "core/ecs/entity_map.h"
+#include "core/ecs/registry.h"
+#include "physics/Common.h"
+#include "scene/systems/TransformHierarchy.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace Rapture {
+
+/**
+ * @brief How a simulated transform lands on the object a body moves
+ *
+ * Kept as plain data on the body, so moved bodies are handed back in one batch rather than through a
+ * call per body.
+ */
+struct SimulatedTarget {
+    ecs::Entity entity = ecs::ENTITY_NULL; ///< The object moved, null while the body is out of the simulation
+    glm::mat4 inverseLocal{1.0f};          ///< Takes the body's own offset back off its transform
+    bool positionOnly = false;             ///< Keeps the object's own rotation and scale, taking only the position
+};
+
+/**
+ * @brief The last two simulated states of every moving body, drawn at a point between them
+ *
+ * The simulation runs at a fixed step while frames come at whatever rate they do, so a frame drawn
+ * straight from the last step shows a body standing still for some frames and jumping on others.
+ * Instead each body keeps the state of the step before the last and of the last, and place() puts
+ * its object the clock's alpha of the way from one to the other. What is drawn trails the
+ * simulation by up to one step but moves evenly.
+ *
+ * Rows are kept per entity, one array per field. A body the last capture did not report has come
+ * to rest, so its row is placed once more at where it stopped and then dropped, and a scene at rest
+ * costs nothing per frame.
+ */
+class BodyInterpolation {
+  public:
+    /**
+     * @brief Which of the last two steps a capture holds
+     */
+    enum CaptureSlot {
+        CAPTURE_PREVIOUS,
+        CAPTURE_CURRENT
+    };
+
+    /**
+     * @brief Takes in what a run of steps left, carrying what the last run left over as the previous state
+     *
+     * A run of one step only reports the state after it, so the previous state is the one the run
+     * before left. A longer run reports the state of its last two steps.
+     * @param capture The states the run left
+     * @param resolve Called as resolve(owner) for each state, returning the SimulatedTarget of the
+     *                body that owner is, or nullptr to skip the state
+     */
+    template <typename Resolve>
+    void capture(const physics::StepCapture &capture, Resolve &&resolve)
+    {
+        if (capture.steps == 0) {
+            return;
+        }
+
+        m_capture++;
+        m_previousPositions = m_currentPositions;
+        m_previousRotations = m_currentRotations;
+
+        captureSlot(capture.previous, CAPTURE_PREVIOUS, resolve);
+        captureSlot(capture.current, CAPTURE_CURRENT, resolve);
+    }
+
+    /**
+     * @brief Places every tracked object between its body's last two states
+     * @param alpha How far from the previous state to the current one, 0 to 1
+     * @param registry Registry the objects live in, read for what they keep of their own transform
+     * @param transforms Where the objects are placed, recording them all in one pass
+     */
+    void place(float alpha, const ecs::Registry &registry, TransformHierarchy &transforms);
+
+    /**
+     * @brief Forgets every body, as when the objects they moved are gone
+     */
+    void clear();
+
+    uint32_t getCount() const { return static_cast<uint32_t>(m_entities.size()); }
+
+  private:
+    template <typename Resolve>
+    void captureSlot(const std::vector<physics::BodyState> &states, CaptureSlot slot, Resolve &resolve)
+    {
+        for (const physics::BodyState &state : states) {
+            const SimulatedTarget *target = resolve(state.owner);
+            if (target == nullptr || target->entity == ecs::ENTITY_NULL) {
+                continue;
+            }
+            record(*target, state, slot);
+        }
+    }
+
+    void record(const SimulatedTarget &target, const physics::BodyState &state, CaptureSlot slot);
+    void removeRow(uint32_t row);
+
+  private:
+    ecs::EntityMap<uint32_t> m_rows;
+    std::vector<ecs::Entity> m_entities;
+    std::vector<glm::mat4> m_inverseLocals;
+    std::vector<uint8_t> m_positionOnly;
+    std::vector<glm::vec3> m_previousPositions;
+    std::vector<glm::quat> m_previousRotations;
+    std::vector<glm::vec3> m_currentPositions;
+    std::vector<glm::quat> m_currentRotations;
+    std::vector<uint32_t> m_lastSeen; // the capture that last reported the row as current
+
+    uint32_t m_capture = 0;
+    std::vector<WorldPlacement> m_placements;
+};
+
+} // namespace Rapture
+
+#endif // RAPTURE__BODY_INTERPOLATION_H
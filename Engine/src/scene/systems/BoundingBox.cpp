@@ -2,6 +2,7 @@
 
 #include "core/utils/Log.h"
 #include "core/utils/TracyProfiler.h"
+#include "scene/systems/TransformKernels.h"
 
 #include <algorithm>
 #include <glm/gtc/matrix_transform.hpp>
@@ -60,6 +61,17 @@ BoundingBox BoundingBox::transform(const glm::mat4 &matrix) const
     return BoundingBox(newMin, newMax);
 }
 
+BoundingBox BoundingBox::transform(const Affine3x4 &matrix) const
+{
+    if (!m_isValid) {
+        return BoundingBox();
+    }
+
+    glm::vec3 newMin, newMax;
+    transform::transformBoundsBatch(&matrix, &m_min, &m_max, &newMin, &newMax, 1);
+    return BoundingBox(newMin, newMax);
+}
+
 BoundingBox BoundingBox::operator+(const BoundingBox &other) const
 {
     glm::vec3 min = glm::min(m_min, other.m_min);
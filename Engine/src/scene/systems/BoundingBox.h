@@ -5,6 +5,8 @@
 
 namespace Rapture {
 
+struct Affine3x4;
+
 class BoundingBox {
 
   public:
@@ -28,6 +30,9 @@ class BoundingBox {
 
     BoundingBox transform(const glm::mat4 &matrix) const;
 
+    // Transforms the center and extents instead of all eight corners, exact for affine transforms
+    BoundingBox transform(const Affine3x4 &matrix) const;
+
     BoundingBox operator+(const BoundingBox &other) const;
 
   private:
@@ -0,0 +1,876 @@
+#include "SceneBVH.h"
+
+#include "core/utils/Log.h"
+#include "core/utils/TracyProfiler.h"
+#include "scene/systems/WorldBounds.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace Rapture {
+
+static constexpr uint32_t NULL_NODE = UINT32_MAX;
+
+// How far a leaf's box is enlarged past the exact one, as a fraction of its size plus a floor
+static constexpr float FAT_MARGIN_FRACTION = 0.1f;
+static constexpr float FAT_MARGIN_MIN = 0.05f;
+
+// A leaf whose enlarged box has grown this much larger than it needs is reinserted tighter
+static constexpr float FAT_SHRINK_RATIO = 4.0f;
+
+// Once this share of the leaves moved in one update, refitting everything beats reinserting
+static constexpr uint32_t REFIT_DIVISOR = 4;
+
+// Once this share of the leaves is new, building from scratch beats inserting one at a time
+static constexpr uint32_t REBUILD_DIVISOR = 2;
+
+/**
+ * @brief A depth first stack that stays on the stack for any tree a balanced build produces
+ */
+template <typename T>
+class TraversalStack {
+  public:
+    bool empty() const { return m_size == 0 && m_overflow.empty(); }
+
+    void push(const T &value)
+    {
+        if (m_size < INLINE_CAPACITY) {
+            m_inline[m_size++] = value;
+        } else {
+            m_overflow.push_back(value);
+        }
+    }
+
+    T pop()
+    {
+        if (!m_overflow.empty()) {
+            T value = m_overflow.back();
+            m_overflow.pop_back();
+            return value;
+        }
+        return m_inline[--m_size];
+    }
+
+  private:
+    static constexpr uint32_t INLINE_CAPACITY = 128;
+    std::array<T, INLINE_CAPACITY> m_inline;
+    uint32_t m_size = 0;
+    std::vector<T> m_overflow;
+};
+
+static float s_area(const glm::vec3 &min, const glm::vec3 &max)
+{
+    const glm::vec3 d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+static bool s_contains(const glm::vec3 &outerMin, const glm::vec3 &outerMax, const glm::vec3 &min, const glm::vec3 &max)
+{
+    return outerMin.x <= min.x && outerMin.y <= min.y && outerMin.z <= min.z && max.x <= outerMax.x && max.y <= outerMax.y &&
+           max.z <= outerMax.z;
+}
+
+static bool s_overlaps(const glm::vec3 &aMin, const glm::vec3 &aMax, const glm::vec3 &bMin, const glm::vec3 &bMax)
+{
+    return aMin.x <= bMax.x && aMin.y <= bMax.y && aMin.z <= bMax.z && bMin.x <= aMax.x && bMin.y <= aMax.y && bMin.z <= aMax.z;
+}
+
+static bool s_isEmpty(const glm::vec3 &min, const glm::vec3 &max)
+{
+    return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+/**
+ * @brief The same corner test culling::cull does, also reporting planes the box lies fully inside
+ * @param planeMask Planes still to test, cleared of those the box is entirely in front of
+ * @return False if the box is behind one of the planes
+ */
+static bool s_testPlanes(const SceneBVH::Planes &planes, const glm::vec3 &min, const glm::vec3 &max, uint32_t &planeMask)
+{
+    for (uint32_t p = 0; p < 6; ++p) {
+        if ((planeMask & (1u << p)) == 0) {
+            continue;
+        }
+        const glm::vec4 &plane = planes[p];
+        const glm::vec3 farCorner(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y,
+                                  plane.z >= 0.0f ? max.z : min.z);
+        if (plane.x * farCorner.x + plane.y * farCorner.y + plane.z * farCorner.z + plane.w < 0.0f) {
+            return false;
+        }
+        const glm::vec3 nearCorner(plane.x >= 0.0f ? min.x : max.x, plane.y >= 0.0f ? min.y : max.y,
+                                   plane.z >= 0.0f ? min.z : max.z);
+        if (plane.x * nearCorner.x + plane.y * nearCorner.y + plane.z * nearCorner.z + plane.w >= 0.0f) {
+            planeMask &= ~(1u << p);
+        }
+    }
+    return true;
+}
+
+static bool s_sphereOverlaps(const glm::vec3 &center, float radiusSquared, const glm::vec3 &min, const glm::vec3 &max)
+{
+    const glm::vec3 offset = center - glm::clamp(center, min, max);
+    return glm::dot(offset, offset) <= radiusSquared;
+}
+
+/**
+ * @brief Slab test of a ray against a box
+ * @param entry Receives where the ray enters the box, clamped to the ray's start
+ */
+static bool s_rayHits(const glm::vec3 &origin, const glm::vec3 &inverseDirection, const glm::vec3 &min, const glm::vec3 &max,
+                      float maxDistance, float &entry)
+{
+    const glm::vec3 t0 = (min - origin) * inverseDirection;
+    const glm::vec3 t1 = (max - origin) * inverseDirection;
+    glm::vec3 near = glm::min(t0, t1);
+    glm::vec3 far = glm::max(t0, t1);
+
+    // a zero direction component makes its inverse infinite, and where the origin lies on one of that
+    // axis' planes, infinity times zero is NaN. The ray runs along the plane, inside the slab.
+    for (int axis = 0; axis < 3; ++axis) {
+        if (std::isnan(t0[axis]) || std::isnan(t1[axis])) {
+            near[axis] = -std::numeric_limits<float>::infinity();
+            far[axis] = std::numeric_limits<float>::infinity();
+        }
+    }
+
+    entry = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+    const float exit = std::min(std::min(far.x, far.y), std::min(far.z, maxDistance));
+    return entry <= exit;
+}
+
+SceneBVH::SceneBVH() : m_root(NULL_NODE), m_freeList(NULL_NODE) {}
+
+SceneBVH::~SceneBVH() = default;
+
+void SceneBVH::clear()
+{
+    m_nodes.clear();
+    m_exact.clear();
+    m_leafOf.clear();
+    m_root = NULL_NODE;
+    m_freeList = NULL_NODE;
+    m_leafCount = 0;
+}
+
+uint32_t SceneBVH::allocateNode()
+{
+    uint32_t node = m_freeList;
+    if (node != NULL_NODE) {
+        m_freeList = m_nodes[node].parent;
+    } else {
+        node = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+        m_exact.emplace_back();
+    }
+
+    Node &n = m_nodes[node];
+    n.parent = NULL_NODE;
+    n.left = NULL_NODE;
+    n.right = NULL_NODE;
+    n.height = 0;
+    n.entity = ecs::ENTITY_NULL;
+    return node;
+}
+
+void SceneBVH::freeNode(uint32_t node)
+{
+    m_nodes[node].height = -1;
+    m_nodes[node].parent = m_freeList;
+    m_freeList = node;
+}
+
+uint32_t SceneBVH::leafOf(ecs::Entity entity) const
+{
+    if (entity == ecs::ENTITY_NULL) {
+        return NULL_NODE;
+    }
+
+    uint32_t index = ecs::EntityIndex(entity);
+    if (index >= m_leafOf.size()) {
+        return NULL_NODE;
+    }
+
+    uint32_t leaf = m_leafOf[index];
+    return leaf != NULL_NODE && m_nodes[leaf].entity == entity ? leaf : NULL_NODE;
+}
+
+void SceneBVH::writeLeaf(uint32_t leaf, const glm::vec3 &min, const glm::vec3 &max)
+{
+    const glm::vec3 margin = (max - min) * FAT_MARGIN_FRACTION + FAT_MARGIN_MIN;
+    m_exact[leaf] = {min, max};
+    m_nodes[leaf].min = min - margin;
+    m_nodes[leaf].max = max + margin;
+}
+
+uint32_t SceneBVH::createLeaf(ecs::Entity entity, const glm::vec3 &min, const glm::vec3 &max)
+{
+    uint32_t leaf = allocateNode();
+    m_nodes[leaf].entity = entity;
+    writeLeaf(leaf, min, max);
+
+    uint32_t index = ecs::EntityIndex(entity);
+    if (index >= m_leafOf.size()) {
+        m_leafOf.resize(index + 1, NULL_NODE);
+    }
+    m_leafOf[index] = leaf;
+    m_leafCount++;
+    m_lastUpdate.inserted++;
+    return leaf;
+}
+
+void SceneBVH::set(ecs::Entity entity, const glm::vec3 &min, const glm::vec3 &max)
+{
+    if (s_isEmpty(min, max)) {
+        remove(entity);
+        return;
+    }
+
+    uint32_t leaf = leafOf(entity);
+    if (leaf == NULL_NODE) {
+        insertLeaf(createLeaf(entity, min, max));
+        return;
+    }
+
+    m_lastUpdate.moved++;
+    const Node &node = m_nodes[leaf];
+    const glm::vec3 margin = (max - min) * FAT_MARGIN_FRACTION + FAT_MARGIN_MIN;
+    const bool escaped = !s_contains(node.min, node.max, min, max);
+    const bool oversized = s_area(node.min, node.max) > FAT_SHRINK_RATIO * s_area(min - margin, max + margin);
+    if (!escaped && !oversized) {
+        m_exact[leaf] = {min, max};
+        return;
+    }
+
+    removeLeaf(leaf);
+    writeLeaf(leaf, min, max);
+    insertLeaf(leaf);
+    m_lastUpdate.reinserted++;
+}
+
+void SceneBVH::remove(ecs::Entity entity)
+{
+    uint32_t leaf = leafOf(entity);
+    if (leaf == NULL_NODE) {
+        return;
+    }
+
+    removeLeaf(leaf);
+    freeNode(leaf);
+    m_leafOf[ecs::EntityIndex(entity)] = NULL_NODE;
+    m_leafCount--;
+    m_lastUpdate.removed++;
+}
+
+void SceneBVH::update(const WorldBounds &bounds)
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    m_lastUpdate = {};
+
+    for (ecs::Entity entity : bounds.getLastRemoved()) {
+        remove(entity);
+    }
+
+    const std::vector<ecs::Entity> &changed = bounds.getLastChanged();
+    if (changed.empty()) {
+        return;
+    }
+
+    const BoundsView view = bounds.view();
+    auto boxOf = [&](ecs::Entity entity, glm::vec3 &min, glm::vec3 &max) {
+        uint32_t row = bounds.rowOf(entity);
+        if (row == UINT32_MAX) {
+            return false;
+        }
+        min = glm::vec3(view.minX[row], view.minY[row], view.minZ[row]);
+        max = glm::vec3(view.maxX[row], view.maxY[row], view.maxZ[row]);
+        return !s_isEmpty(min, max);
+    };
+
+    uint32_t added = 0;
+    uint32_t moved = 0;
+    for (ecs::Entity entity : changed) {
+        glm::vec3 min, max;
+        if (leafOf(entity) != NULL_NODE) {
+            moved++;
+        } else if (boxOf(entity, min, max)) {
+            added++;
+        }
+    }
+
+    const uint32_t leavesAfter = m_leafCount + added;
+    const bool rebuildAll = added > 0 && added * REBUILD_DIVISOR >= leavesAfter;
+    const bool refitAll = !rebuildAll && moved > 0 && moved * REFIT_DIVISOR >= m_leafCount;
+
+    if (!rebuildAll && !refitAll) {
+        for (ecs::Entity entity : changed) {
+            glm::vec3 min, max;
+            if (boxOf(entity, min, max)) {
+                set(entity, min, max);
+            } else {
+                remove(entity);
+            }
+        }
+        return;
+    }
+
+    // leaves are written in place and the tree is fixed up once afterwards
+    for (ecs::Entity entity : changed) {
+        glm::vec3 min, max;
+        if (!boxOf(entity, min, max)) {
+            remove(entity);
+            continue;
+        }
+
+        if (uint32_t leaf = leafOf(entity); leaf != NULL_NODE) {
+            writeLeaf(leaf, min, max);
+            m_lastUpdate.moved++;
+        } else if (rebuildAll) {
+            createLeaf(entity, min, max);
+        }
+    }
+
+    if (rebuildAll) {
+        rebuild();
+        return;
+    }
+
+    refit();
+    for (ecs::Entity entity : changed) {
+        glm::vec3 min, max;
+        if (leafOf(entity) == NULL_NODE && boxOf(entity, min, max)) {
+            set(entity, min, max);
+        }
+    }
+}
+
+void SceneBVH::insertLeaf(uint32_t leaf)
+{
+    if (m_root == NULL_NODE) {
+        m_root = leaf;
+        m_nodes[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    const glm::vec3 leafMin = m_nodes[leaf].min;
+    const glm::vec3 leafMax = m_nodes[leaf].max;
+
+    // walk down to the sibling that grows the total surface area the least
+    uint32_t index = m_root;
+    while (!m_nodes[index].isLeaf()) {
+        const Node &node = m_nodes[index];
+        const float area = s_area(node.min, node.max);
+        const float combinedArea = s_area(glm::min(node.min, leafMin), glm::max(node.max, leafMax));
+
+        // pairing with this node makes a new parent, descending grows this node by the leaf
+        const float cost = 2.0f * combinedArea;
+        const float inheritance = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](uint32_t child) {
+            const Node &c = m_nodes[child];
+            const float grown = s_area(glm::min(c.min, leafMin), glm::max(c.max, leafMax));
+            return (c.isLeaf() ? grown : grown - s_area(c.min, c.max)) + inheritance;
+        };
+        const float leftCost = descendCost(node.left);
+        const float rightCost = descendCost(node.right);
+
+        if (cost < leftCost && cost < rightCost) {
+            break;
+        }
+        index = leftCost < rightCost ? node.left : node.right;
+    }
+
+    const uint32_t sibling = index;
+    const uint32_t oldParent = m_nodes[sibling].parent;
+    const uint32_t newParent = allocateNode();
+
+    Node &parent = m_nodes[newParent];
+    parent.parent = oldParent;
+    parent.min = glm::min(leafMin, m_nodes[sibling].min);
+    parent.max = glm::max(leafMax, m_nodes[sibling].max);
+    parent.height = m_nodes[sibling].height + 1;
+    parent.left = sibling;
+    parent.right = leaf;
+
+    if (oldParent != NULL_NODE) {
+        if (m_nodes[oldParent].left == sibling) {
+            m_nodes[oldParent].left = newParent;
+        } else {
+            m_nodes[oldParent].right = newParent;
+        }
+    } else {
+        m_root = newParent;
+    }
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+
+    refitAncestors(newParent);
+}
+
+void SceneBVH::removeLeaf(uint32_t leaf)
+{
+    if (leaf == m_root) {
+        m_root = NULL_NODE;
+        return;
+    }
+
+    const uint32_t parent = m_nodes[leaf].parent;
+    const uint32_t grandParent = m_nodes[parent].parent;
+    const uint32_t sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+
+    if (grandParent != NULL_NODE) {
+        if (m_nodes[grandParent].left == parent) {
+            m_nodes[grandParent].left = sibling;
+        } else {
+            m_nodes[grandParent].right = sibling;
+        }
+        m_nodes[sibling].parent = grandParent;
+        freeNode(parent);
+        refitAncestors(grandParent);
+    } else {
+        m_root = sibling;
+        m_nodes[sibling].parent = NULL_NODE;
+        freeNode(parent);
+    }
+}
+
+void SceneBVH::refitAncestors(uint32_t node)
+{
+    for (uint32_t index = node; index != NULL_NODE; index = m_nodes[index].parent) {
+        index = balance(index);
+
+        Node &n = m_nodes[index];
+        const Node &left = m_nodes[n.left];
+        const Node &right = m_nodes[n.right];
+        n.height = 1 + std::max(left.height, right.height);
+        n.min = glm::min(left.min, right.min);
+        n.max = glm::max(left.max, right.max);
+    }
+}
+
+uint32_t SceneBVH::balance(uint32_t iA)
+{
+    Node &a = m_nodes[iA];
+    if (a.isLeaf() || a.height < 2) {
+        return iA;
+    }
+
+    const uint32_t iB = a.left;
+    const uint32_t iC = a.right;
+    Node &b = m_nodes[iB];
+    Node &c = m_nodes[iC];
+    const int32_t skew = c.height - b.height;
+
+    // rotate C up
+    if (skew > 1) {
+        const uint32_t iF = c.left;
+        const uint32_t iG = c.right;
+        Node &f = m_nodes[iF];
+        Node &g = m_nodes[iG];
+
+        c.left = iA;
+        c.parent = a.parent;
+        a.parent = iC;
+        if (c.parent != NULL_NODE) {
+            if (m_nodes[c.parent].left == iA) {
+                m_nodes[c.parent].left = iC;
+            } else {
+                m_nodes[c.parent].right = iC;
+            }
+        } else {
+            m_root = iC;
+        }
+
+        // the taller of C's children stays with C, the other moves under A
+        const bool keepF = f.height > g.height;
+        Node &kept = keepF ? f : g;
+        Node &moved = keepF ? g : f;
+        c.right = keepF ? iF : iG;
+        a.right = keepF ? iG : iF;
+        moved.parent = iA;
+
+        a.min = glm::min(b.min, moved.min);
+        a.max = glm::max(b.max, moved.max);
+        c.min = glm::min(a.min, kept.min);
+        c.max = glm::max(a.max, kept.max);
+        a.height = 1 + std::max(b.height, moved.height);
+        c.height = 1 + std::max(a.height, kept.height);
+        return iC;
+    }
+
+    // rotate B up
+    if (skew < -1) {
+        const uint32_t iD = b.left;
+        const uint32_t iE = b.right;
+        Node &d = m_nodes[iD];
+        Node &e = m_nodes[iE];
+
+        b.left = iA;
+        b.parent = a.parent;
+        a.parent = iB;
+        if (b.parent != NULL_NODE) {
+            if (m_nodes[b.parent].left == iA) {
+                m_nodes[b.parent].left = iB;
+            } else {
+                m_nodes[b.parent].right = iB;
+            }
+        } else {
+            m_root = iB;
+        }
+
+        const bool keepD = d.height > e.height;
+        Node &kept = keepD ? d : e;
+        Node &moved = keepD ? e : d;
+        b.right = keepD ? iD : iE;
+        a.left = keepD ? iE : iD;
+        moved.parent = iA;
+
+        a.min = glm::min(c.min, moved.min);
+        a.max = glm::max(c.max, moved.max);
+        b.min = glm::min(a.min, kept.min);
+        b.max = glm::max(a.max, kept.max);
+        a.height = 1 + std::max(c.height, moved.height);
+        b.height = 1 + std::max(a.height, kept.height);
+        return iB;
+    }
+
+    return iA;
+}
+
+void SceneBVH::refit()
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    if (m_root == NULL_NODE) {
+        return;
+    }
+
+    // parents before children, so walking it backwards finishes every child before its parent
+    m_order.clear();
+    m_order.push_back(m_root);
+    for (size_t i = 0; i < m_order.size(); ++i) {
+        const Node &node = m_nodes[m_order[i]];
+        if (!node.isLeaf()) {
+            m_order.push_back(node.left);
+            m_order.push_back(node.right);
+        }
+    }
+
+    for (size_t i = m_order.size(); i-- > 0;) {
+        Node &node = m_nodes[m_order[i]];
+        if (node.isLeaf()) {
+            continue;
+        }
+        node.min = glm::min(m_nodes[node.left].min, m_nodes[node.right].min);
+        node.max = glm::max(m_nodes[node.left].max, m_nodes[node.right].max);
+    }
+}
+
+void SceneBVH::rebuild()
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    m_buildItems.clear();
+    m_root = NULL_NODE;
+
+    // keep the leaves where they are and hand every internal node back
+    m_freeList = NULL_NODE;
+    for (uint32_t node = static_cast<uint32_t>(m_nodes.size()); node-- > 0;) {
+        if (m_nodes[node].height == 0) {
+            m_buildItems.push_back({m_nodes[node].min + m_nodes[node].max, node});
+        } else {
+            freeNode(node);
+        }
+    }
+
+    if (m_buildItems.empty()) {
+        return;
+    }
+
+    m_root = buildRange(m_buildItems.data(), static_cast<uint32_t>(m_buildItems.size()));
+    m_nodes[m_root].parent = NULL_NODE;
+    m_lastUpdate.rebuilt = true;
+}
+
+uint32_t SceneBVH::buildRange(BuildItem *items, uint32_t count)
+{
+    if (count == 1) {
+        return items[0].node;
+    }
+
+    // split at the median along the axis the centers spread furthest on
+    glm::vec3 centerMin(std::numeric_limits<float>::max());
+    glm::vec3 centerMax(std::numeric_limits<float>::lowest());
+    for (uint32_t i = 0; i < count; ++i) {
+        centerMin = glm::min(centerMin, items[i].center);
+        centerMax = glm::max(centerMax, items[i].center);
+    }
+    const glm::vec3 spread = centerMax - centerMin;
+    const int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+
+    const uint32_t half = count / 2;
+    std::nth_element(items, items + half, items + count,
+                     [axis](const BuildItem &a, const BuildItem &b) { return a.center[axis] < b.center[axis]; });
+
+    const uint32_t left = buildRange(items, half);
+    const uint32_t right = buildRange(items + half, count - half);
+
+    const uint32_t node = allocateNode();
+    Node &n = m_nodes[node];
+    n.left = left;
+    n.right = right;
+    n.min = glm::min(m_nodes[left].min, m_nodes[right].min);
+    n.max = glm::max(m_nodes[left].max, m_nodes[right].max);
+    n.height = 1 + std::max(m_nodes[left].height, m_nodes[right].height);
+    m_nodes[left].parent = node;
+    m_nodes[right].parent = node;
+    return node;
+}
+
+void SceneBVH::collectLeaves(uint32_t node, std::vector<ecs::Entity> &out) const
+{
+    TraversalStack<uint32_t> stack;
+    stack.push(node);
+    while (!stack.empty()) {
+        const Node &n = m_nodes[stack.pop()];
+        if (n.isLeaf()) {
+            out.push_back(n.entity);
+        } else {
+            stack.push(n.left);
+            stack.push(n.right);
+        }
+    }
+}
+
+void SceneBVH::queryFrustum(const Planes &planes, std::vector<ecs::Entity> &out) const
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    if (m_root == NULL_NODE) {
+        return;
+    }
+
+    struct Entry {
+        uint32_t node;
+        uint32_t planeMask; // planes the node could still cross
+    };
+
+    TraversalStack<Entry> stack;
+    stack.push({m_root, 0x3Fu});
+    while (!stack.empty()) {
+        Entry entry = stack.pop();
+        const Node &node = m_nodes[entry.node];
+
+        if (node.isLeaf()) {
+            const LeafBounds &exact = m_exact[entry.node];
+            if (s_testPlanes(planes, exact.min, exact.max, entry.planeMask)) {
+                out.push_back(node.entity);
+            }
+            continue;
+        }
+
+        if (!s_testPlanes(planes, node.min, node.max, entry.planeMask)) {
+            continue;
+        }
+
+        // inside every plane, and so is everything below it
+        if (entry.planeMask == 0) {
+            collectLeaves(entry.node, out);
+            continue;
+        }
+
+        stack.push({node.left, entry.planeMask});
+        stack.push({node.right, entry.planeMask});
+    }
+}
+
+void SceneBVH::queryFrusta(std::span<const Planes> frusta, std::span<std::vector<ecs::Entity>> out) const
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    if (out.size() < frusta.size()) {
+        RP_CORE_ERROR("{} frusta were queried with only {} result lists", frusta.size(), out.size());
+        return;
+    }
+
+    if (frusta.size() > MAX_BATCHED_FRUSTA) {
+        queryFrusta(frusta.subspan(MAX_BATCHED_FRUSTA), out.subspan(MAX_BATCHED_FRUSTA));
+        frusta = frusta.first(MAX_BATCHED_FRUSTA);
+    }
+
+    if (m_root == NULL_NODE || frusta.empty()) {
+        return;
+    }
+
+    struct Entry {
+        uint32_t node;
+        uint32_t testMask;   // frusta the parent crossed, still to test
+        uint32_t insideMask; // frusta holding the parent whole, and so this node too
+    };
+
+    const uint32_t allFrusta = frusta.size() == 32 ? 0xFFFFFFFFu : (1u << frusta.size()) - 1;
+
+    TraversalStack<Entry> stack;
+    stack.push({m_root, allFrusta, 0});
+    while (!stack.empty()) {
+        Entry entry = stack.pop();
+        const Node &node = m_nodes[entry.node];
+        const glm::vec3 &min = node.isLeaf() ? m_exact[entry.node].min : node.min;
+        const glm::vec3 &max = node.isLeaf() ? m_exact[entry.node].max : node.max;
+
+        uint32_t crossing = 0;
+        uint32_t inside = entry.insideMask;
+        for (uint32_t bits = entry.testMask; bits != 0; bits &= bits - 1) {
+            const uint32_t f = static_cast<uint32_t>(std::countr_zero(bits));
+            uint32_t planeMask = 0x3Fu;
+            if (s_testPlanes(frusta[f], min, max, planeMask)) {
+                (planeMask == 0 ? inside : crossing) |= 1u << f;
+            }
+        }
+        if ((crossing | inside) == 0) {
+            continue;
+        }
+
+        if (node.isLeaf()) {
+            for (uint32_t bits = crossing | inside; bits != 0; bits &= bits - 1) {
+                out[std::countr_zero(bits)].push_back(node.entity);
+            }
+            continue;
+        }
+
+        stack.push({node.left, crossing, inside});
+        stack.push({node.right, crossing, inside});
+    }
+}
+
+void SceneBVH::querySphere(const glm::vec3 &center, float radius, std::vector<ecs::Entity> &out) const
+{
+    if (m_root == NULL_NODE) {
+        return;
+    }
+
+    const float radiusSquared = radius * radius;
+    TraversalStack<uint32_t> stack;
+    stack.push(m_root);
+    while (!stack.empty()) {
+        const uint32_t index = stack.pop();
+        const Node &node = m_nodes[index];
+
+        if (node.isLeaf()) {
+            if (s_sphereOverlaps(center, radiusSquared, m_exact[index].min, m_exact[index].max)) {
+                out.push_back(node.entity);
+            }
+        } else if (s_sphereOverlaps(center, radiusSquared, node.min, node.max)) {
+            stack.push(node.left);
+            stack.push(node.right);
+        }
+    }
+}
+
+void SceneBVH::queryAABB(const glm::vec3 &min, const glm::vec3 &max, std::vector<ecs::Entity> &out) const
+{
+    if (m_root == NULL_NODE) {
+        return;
+    }
+
+    TraversalStack<uint32_t> stack;
+    stack.push(m_root);
+    while (!stack.empty()) {
+        const uint32_t index = stack.pop();
+        const Node &node = m_nodes[index];
+
+        if (node.isLeaf()) {
+            if (s_overlaps(min, max, m_exact[index].min, m_exact[index].max)) {
+                out.push_back(node.entity);
+            }
+        } else if (s_overlaps(min, max, node.min, node.max)) {
+            stack.push(node.left);
+            stack.push(node.right);
+        }
+    }
+}
+
+void SceneBVH::raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, const RayCallback &callback) const
+{
+    if (m_root == NULL_NODE) {
+        return;
+    }
+
+    struct Entry {
+        uint32_t node;
+        float entry;
+    };
+
+    const glm::vec3 inverseDirection = 1.0f / direction;
+
+    float entry = 0.0f;
+    if (!s_rayHits(origin, inverseDirection, m_nodes[m_root].min, m_nodes[m_root].max, maxDistance, entry)) {
+        return;
+    }
+
+    TraversalStack<Entry> stack;
+    stack.push({m_root, entry});
+    while (!stack.empty()) {
+        const Entry current = stack.pop();
+        if (current.entry > maxDistance) {
+            continue;
+        }
+
+        const Node &node = m_nodes[current.node];
+        if (node.isLeaf()) {
+            const LeafBounds &exact = m_exact[current.node];
+            if (s_rayHits(origin, inverseDirection, exact.min, exact.max, maxDistance, entry)) {
+                maxDistance = std::min(maxDistance, callback(node.entity, entry));
+            }
+            continue;
+        }
+
+        float leftEntry = 0.0f;
+        float rightEntry = 0.0f;
+        const Node &left = m_nodes[node.left];
+        const Node &right = m_nodes[node.right];
+        const bool hitsLeft = s_rayHits(origin, inverseDirection, left.min, left.max, maxDistance, leftEntry);
+        const bool hitsRight = s_rayHits(origin, inverseDirection, right.min, right.max, maxDistance, rightEntry);
+
+        // the nearer child goes on top so it is walked first and can shorten the ray for the other
+        if (hitsLeft && hitsRight) {
+            if (leftEntry <= rightEntry) {
+                stack.push({node.right, rightEntry});
+                stack.push({node.left, leftEntry});
+            } else {
+                stack.push({node.left, leftEntry});
+                stack.push({node.right, rightEntry});
+            }
+        } else if (hitsLeft) {
+            stack.push({node.left, leftEntry});
+        } else if (hitsRight) {
+            stack.push({node.right, rightEntry});
+        }
+    }
+}
+
+uint32_t SceneBVH::getHeight() const
+{
+    return m_root == NULL_NODE ? 0 : static_cast<uint32_t>(m_nodes[m_root].height);
+}
+
+float SceneBVH::getAreaRatio() const
+{
+    if (m_root == NULL_NODE) {
+        return 0.0f;
+    }
+
+    float total = 0.0f;
+    for (const Node &node : m_nodes) {
+        if (node.height > 0) {
+            total += s_area(node.min, node.max);
+        }
+    }
+
+    const float rootArea = s_area(m_nodes[m_root].min, m_nodes[m_root].max);
+    return rootArea > 0.0f ? total / rootArea : 0.0f;
+}
+
+} // namespace Rapture
@@ -0,0 +1,201 @@
+#ifndef RAPTURE__SCENE_BVH_H
+#define RAPTURE__SCENE_BVH_H
+
+#include "core/ecs/common.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+namespace Rapture {
+
+class WorldBounds;
+
+/**
+ * @brief What the last SceneBVH::update did, for the profiler and benchmarks
+ */
+struct BVHUpdateStats {
+    uint32_t inserted = 0;
+    uint32_t removed = 0;
+    uint32_t moved = 0;      // leaves whose box changed
+    uint32_t reinserted = 0; // moved leaves that left their enlarged box and were taken out and put back
+    bool refit = false;      // whether enough leaves moved that every box was refit in place instead
+    bool rebuilt = false;    // whether the tree was built again from scratch
+};
+
+/**
+ * @brief Dynamic bounding volume hierarchy over the meshes in a scene's WorldBounds, keyed by entity
+ *
+ * A binary tree of axis aligned boxes. Each leaf holds one entity's world bounds, both exactly and
+ * enlarged by a margin; the enlarged box is what the tree is built around, so an object that moves
+ * a little stays inside it and costs nothing but a write to its exact box. A leaf that leaves its
+ * enlarged box is taken out and inserted again, with the parent picked by the surface area cost and
+ * the tree kept balanced by rotations on the way back up.
+ *
+ * update() follows what WorldBounds recomputed in its last refresh, which in turn follows
+ * CHANNEL_TRANSFORM_WORLD and CHANNEL_MESH_BINDING. When most leaves moved at once the boxes are refit
+ * bottom up without changing the shape of the tree, and when most of the tree is new it is built again
+ * top down instead of inserting leaf by leaf.
+ *
+ * Queries walk the internal nodes with the enlarged boxes and test leaves against their exact ones,
+ * so they report the same entities a scan over the exact boxes would.
+ */
+class SceneBVH {
+  public:
+    using Planes = std::array<glm::vec4, 6>;
+
+    /**
+     * @brief Called for each entity a ray reaches
+     * @return How far along the ray to keep searching; the distance given finds only the closest hit,
+     * the current limit keeps every hit
+     */
+    using RayCallback = std::function<float(ecs::Entity entity, float distance)>;
+
+    SceneBVH();
+    ~SceneBVH();
+
+    SceneBVH(const SceneBVH &) = delete;
+    SceneBVH &operator=(const SceneBVH &) = delete;
+
+    /**
+     * @brief Applies the rows a WorldBounds added, moved or dropped in its last refresh
+     */
+    void update(const WorldBounds &bounds);
+
+    /**
+     * @brief Inserts an entity or moves its leaf
+     * @param entity The entity the box belongs to
+     * @param min World space minimum
+     * @param max World space maximum, below min for an entity that should have no leaf
+     */
+    void set(ecs::Entity entity, const glm::vec3 &min, const glm::vec3 &max);
+
+    void remove(ecs::Entity entity);
+
+    /**
+     * @brief Recomputes every internal box from the leaves up, keeping the shape of the tree
+     */
+    void refit();
+
+    /**
+     * @brief Builds the whole tree again top down from the current leaves
+     */
+    void rebuild();
+
+    void clear();
+
+    /**
+     * @brief Every entity whose box is at least partly inside a frustum
+     * @param planes Normalized planes facing inwards, as Frustum::getPlanes() holds them
+     */
+    void queryFrustum(const Planes &planes, std::vector<ecs::Entity> &out) const;
+
+    /**
+     * @brief queryFrustum() for several frusta in one walk of the tree
+     *
+     * A node is only tested against the frusta that kept its parent, so views looking at the same
+     * part of the scene share most of the work.
+     * @param frusta Up to MAX_BATCHED_FRUSTA frusta
+     * @param out One list per frustum, appended to
+     */
+    void queryFrusta(std::span<const Planes> frusta, std::span<std::vector<ecs::Entity>> out) const;
+
+    void querySphere(const glm::vec3 &center, float radius, std::vector<ecs::Entity> &out) const;
+    void queryAABB(const glm::vec3 &min, const glm::vec3 &max, std::vector<ecs::Entity> &out) const;
+
+    /**
+     * @brief Walks the boxes a ray passes through, nearest subtree first
+     * @param origin Where the ray starts
+     * @param direction Direction of the ray, need not be normalized; distances are in its units
+     * @param maxDistance How far along the ray to search
+     * @param callback Called for each box the ray enters within the current limit
+     */
+    void raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, const RayCallback &callback) const;
+
+    uint32_t getLeafCount() const { return m_leafCount; }
+    uint32_t getHeight() const;
+
+    /**
+     * @brief Sum of the internal node surface areas over the root's, lower is better for queries
+     */
+    float getAreaRatio() const;
+
+    const BVHUpdateStats &getLastUpdateStats() const { return m_lastUpdate; }
+
+    static constexpr uint32_t MAX_BATCHED_FRUSTA = 32;
+
+  private:
+    struct Node {
+        glm::vec3 min;
+        uint32_t parent;
+        glm::vec3 max;
+        uint32_t left; // UINT32_MAX for a leaf
+        uint32_t right;
+        int32_t height; // 0 for a leaf, -1 while on the free list
+        ecs::Entity entity;
+
+        bool isLeaf() const { return left == UINT32_MAX; }
+    };
+
+    struct LeafBounds {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    // a leaf as the top down build sorts it, kept apart from the nodes so the sorts stay in cache
+    struct BuildItem {
+        glm::vec3 center; // twice the center, the halving changes no order
+        uint32_t node;
+    };
+
+    uint32_t allocateNode();
+    void freeNode(uint32_t node);
+    uint32_t leafOf(ecs::Entity entity) const;
+
+    /**
+     * @brief Allocates a leaf for an entity without placing it in the tree
+     */
+    uint32_t createLeaf(ecs::Entity entity, const glm::vec3 &min, const glm::vec3 &max);
+
+    /**
+     * @brief Stores a leaf's exact box and the enlarged one around it
+     */
+    void writeLeaf(uint32_t leaf, const glm::vec3 &min, const glm::vec3 &max);
+
+    void insertLeaf(uint32_t leaf);
+    void removeLeaf(uint32_t leaf);
+    uint32_t balance(uint32_t node);
+
+    /**
+     * @brief Rebalances and recomputes every node from one up to the root
+     */
+    void refitAncestors(uint32_t node);
+    uint32_t buildRange(BuildItem *items, uint32_t count);
+
+    /**
+     * @brief Emits every leaf below a node without testing it, for subtrees known to be inside
+     */
+    void collectLeaves(uint32_t node, std::vector<ecs::Entity> &out) const;
+
+  private:
+    std::vector<Node> m_nodes;
+    std::vector<LeafBounds> m_exact; // per node, only meaningful for leaves
+    uint32_t m_root;
+    uint32_t m_freeList;
+    uint32_t m_leafCount = 0;
+
+    std::vector<uint32_t> m_leafOf; // entity index -> leaf node
+
+    // refit and rebuild scratch
+    std::vector<BuildItem> m_buildItems;
+    std::vector<uint32_t> m_order;
+
+    BVHUpdateStats m_lastUpdate;
+};
+
+} // namespace Rapture
+
+#endif // RAPTURE__SCENE_BVH_H
@@ -0,0 +1,563 @@
+#include "TransformHierarchy.h"
+
+#include "core/jobs/Counter.h"
+#include "core/jobs/JobSystem.h"
+#include "core/utils/Log.h"
+#include "core/utils/TracyProfiler.h"
+#include "core/utils/rp_assert.h"
+#include "scene/components/Components.h"
+#include "scene/systems/TransformKernels.h"
+
+#include <algorithm>
+
+namespace Rapture {
+
+static constexpr uint32_t NO_ROW = UINT32_MAX;
+
+// Below this many rows a level is cheaper to compose on the calling thread than to hand out
+static constexpr uint32_t DEFAULT_PARALLEL_THRESHOLD = 16384;
+static constexpr uint32_t PARALLEL_CHUNK_ROWS = 4096;
+
+enum TransformRowDirty : uint8_t {
+    ROW_CLEAN = 0,
+    ROW_DIRTY_CHILDREN = 1, // the row itself is current, only what is below it is stale
+    ROW_DIRTY_SELF = 2
+};
+
+static const Affine3x4 AFFINE_IDENTITY{};
+
+TransformHierarchy::TransformHierarchy(ecs::Registry &registry)
+    : m_registry(registry), m_parallelThreshold(DEFAULT_PARALLEL_THRESHOLD)
+{
+    m_constructConnection = registry.onConstructScoped<TransformComponent>([this](ecs::Entity entity) { addRow(entity); });
+    m_destroyConnection = registry.onDestroyScoped<TransformComponent>([this](ecs::Entity entity) { removeRow(entity); });
+
+    // components that existed before the hierarchy did
+    for (auto [entity, transform] : registry.read<TransformComponent>()) {
+        (void)transform;
+        addRow(entity);
+    }
+}
+
+TransformHierarchy::~TransformHierarchy() = default;
+
+uint32_t TransformHierarchy::rowOf(ecs::Entity entity) const
+{
+    if (entity == ecs::ENTITY_NULL) {
+        return NO_ROW;
+    }
+
+    uint32_t index = ecs::EntityIndex(entity);
+    if (index >= m_rowOf.size()) {
+        return NO_ROW;
+    }
+
+    uint32_t row = m_rowOf[index];
+    return row != NO_ROW && m_entities[row] == entity ? row : NO_ROW;
+}
+
+void TransformHierarchy::addRow(ecs::Entity entity)
+{
+    uint32_t index = ecs::EntityIndex(entity);
+    if (index >= m_rowOf.size()) {
+        m_rowOf.resize(index + 1, NO_ROW);
+    }
+
+    m_rowOf[index] = static_cast<uint32_t>(m_entities.size());
+    m_entities.push_back(entity);
+    m_parentEntities.push_back(ecs::ENTITY_NULL);
+    m_parents.push_back(NO_ROW);
+    m_depths.push_back(0);
+    m_local.emplace_back();
+    m_world.emplace_back();
+    m_dirty.push_back(ROW_CLEAN);
+
+    // the creator usually fills in the component right after adding it, so its parts are only
+    // composed once they are needed
+    m_added.push_back(entity);
+    m_orderDirty = true;
+    queue(m_rowOf[index], ROW_DIRTY_SELF);
+}
+
+void TransformHierarchy::removeRow(ecs::Entity entity)
+{
+    uint32_t row = rowOf(entity);
+    if (row == NO_ROW) {
+        return;
+    }
+
+    // swap and pop, the order is rebuilt on the next flush anyway
+    uint32_t last = static_cast<uint32_t>(m_entities.size()) - 1;
+    if (row != last) {
+        m_entities[row] = m_entities[last];
+        m_parentEntities[row] = m_parentEntities[last];
+        m_depths[row] = m_depths[last];
+        m_local[row] = m_local[last];
+        m_world[row] = m_world[last];
+        m_dirty[row] = m_dirty[last];
+        m_rowOf[ecs::EntityIndex(m_entities[row])] = row;
+    }
+
+    m_entities.pop_back();
+    m_parentEntities.pop_back();
+    m_parents.pop_back();
+    m_depths.pop_back();
+    m_local.pop_back();
+    m_world.pop_back();
+    m_dirty.pop_back();
+    m_rowOf[ecs::EntityIndex(entity)] = NO_ROW;
+
+    m_orderDirty = true;
+}
+
+void TransformHierarchy::refreshAdded()
+{
+    if (m_added.empty()) {
+        return;
+    }
+
+    const auto *pool = m_registry.getPool<TransformComponent>();
+    for (ecs::Entity entity : m_added) {
+        uint32_t row = rowOf(entity);
+        if (row != NO_ROW) {
+            const TransformComponent &component = pool->get(entity);
+            m_local[row] = transform::composeAffine(component.translation, component.rotation, component.scale);
+        }
+    }
+    m_added.clear();
+}
+
+void TransformHierarchy::queue(uint32_t row, uint8_t dirty)
+{
+    if (m_dirty[row] == ROW_CLEAN) {
+        m_pending.push_back(m_entities[row]);
+    }
+    m_dirty[row] = std::max(m_dirty[row], dirty);
+}
+
+void TransformHierarchy::setParent(ecs::Entity entity, ecs::Entity parent)
+{
+    uint32_t row = rowOf(entity);
+    if (row == NO_ROW) {
+        return;
+    }
+
+    uint32_t parentRow = rowOf(parent);
+    if (parentRow == NO_ROW) {
+        parent = ecs::ENTITY_NULL;
+    }
+    if (rowOf(m_parentEntities[row]) == NO_ROW && m_parentEntities[row] != ecs::ENTITY_NULL) {
+        // the old parent lost its transform since the last flush, the row takes its place from there
+        orphan(row);
+    }
+    if (m_parentEntities[row] == parent) {
+        return;
+    }
+
+    // a row may not end up below itself
+    for (uint32_t ancestor = parentRow; ancestor != NO_ROW; ancestor = rowOf(m_parentEntities[ancestor])) {
+        if (ancestor == row) {
+            RP_CORE_ERROR("Cannot parent a transform to one of its own descendants");
+            return;
+        }
+    }
+
+    m_parentEntities[row] = parent;
+    m_orderDirty = true;
+    queue(row, ROW_DIRTY_SELF);
+}
+
+void TransformHierarchy::setLocal(ecs::Entity entity, const glm::vec3 &translation, const glm::quat &rotation,
+                                  const glm::vec3 &scale)
+{
+    uint32_t row = rowOf(entity);
+    if (row == NO_ROW) {
+        return;
+    }
+
+    m_local[row] = transform::composeAffine(translation, rotation, scale);
+
+    // the world transform it produces is what gets announced, once it is flushed
+    TransformComponent &component = m_registry.getPool<TransformComponent>()->get(entity);
+    component.translation = translation;
+    component.rotation = rotation;
+    component.scale = scale;
+    queue(row, ROW_DIRTY_SELF);
+}
+
+void TransformHierarchy::setLocal(ecs::Entity entity, const glm::mat4 &local)
+{
+    glm::vec3 translation, scale;
+    glm::quat rotation;
+    transform::decompose(transform::toAffine(local), translation, rotation, scale);
+    setLocal(entity, translation, rotation, scale);
+}
+
+void TransformHierarchy::setWorld(ecs::Entity entity, const glm::mat4 &world)
+{
+    uint32_t row = rowOf(entity);
+    if (row == NO_ROW) {
+        return;
+    }
+
+    refreshAdded();
+
+    placeWorld(row, transform::toAffine(world), m_registry.getPool<TransformComponent>()->get(entity));
+    m_registry.getJournal().record(entity, ecs::ChannelBit(CHANNEL_TRANSFORM_WORLD));
+}
+
+void TransformHierarchy::setWorlds(std::span<const WorldPlacement> placements)
+{
+    if (placements.empty()) {
+        return;
+    }
+
+    refreshAdded();
+
+    ecs::ComponentPool<TransformComponent> *components = m_registry.getPool<TransformComponent>();
+    m_placed.clear();
+    for (const WorldPlacement &placement : placements) {
+        uint32_t row = rowOf(placement.entity);
+        if (row == NO_ROW) {
+            continue;
+        }
+
+        placeWorld(row, placement.world, components->get(placement.entity));
+        m_placed.push_back(placement.entity);
+    }
+
+    m_registry.getJournal().record(m_placed, ecs::ChannelBit(CHANNEL_TRANSFORM_WORLD));
+}
+
+void TransformHierarchy::placeWorld(uint32_t row, const Affine3x4 &target, TransformComponent &component)
+{
+    uint32_t parentRow = rowOf(m_parentEntities[row]);
+    const Affine3x4 local =
+        parentRow != NO_ROW ? transform::multiply(transform::inverse(this->world(m_entities[parentRow])), target) : target;
+
+    glm::vec3 translation, scale;
+    glm::quat rotation;
+    transform::decompose(local, translation, rotation, scale);
+    m_local[row] = transform::composeAffine(translation, rotation, scale);
+    m_world[row] = target;
+    if (m_dirty[row] == ROW_DIRTY_SELF) {
+        m_dirty[row] = ROW_DIRTY_CHILDREN;
+    }
+
+    component.translation = translation;
+    component.rotation = rotation;
+    component.scale = scale;
+    component.world = target;
+
+    queue(row, ROW_DIRTY_CHILDREN);
+}
+
+void TransformHierarchy::markDirty(ecs::Entity entity)
+{
+    uint32_t row = rowOf(entity);
+    if (row != NO_ROW) {
+        queue(row, ROW_DIRTY_SELF);
+    }
+}
+
+const Affine3x4 &TransformHierarchy::world(ecs::Entity entity)
+{
+    refreshAdded();
+
+    uint32_t row = rowOf(entity);
+    if (row == NO_ROW) {
+        return AFFINE_IDENTITY;
+    }
+
+    // Only the chain above the row matters, so a read between flushes costs its depth rather than
+    // a flush of everything queued. The rows it recomputes stay queued and the flush redoes them.
+    m_chain.clear();
+    size_t staleFrom = 0; // chain[staleFrom - 1] and everything below it is stale
+    for (uint32_t current = row; current != NO_ROW;) {
+        m_chain.push_back(current);
+        uint32_t parentRow = rowOf(m_parentEntities[current]);
+
+        if (parentRow == NO_ROW && m_parentEntities[current] != ecs::ENTITY_NULL) {
+            orphan(current);
+        }
+        if (m_dirty[current] == ROW_DIRTY_SELF) {
+            staleFrom = m_chain.size();
+        } else if (m_dirty[current] == ROW_DIRTY_CHILDREN && m_chain.size() > 1) {
+            staleFrom = m_chain.size() - 1;
+        }
+        current = parentRow;
+    }
+
+    for (size_t i = staleFrom; i-- > 0;) {
+        const uint32_t current = m_chain[i];
+        m_world[current] = i + 1 < m_chain.size() ? transform::multiply(m_world[m_chain[i + 1]], m_local[current])
+                                                  : m_local[current];
+    }
+    return m_world[row];
+}
+
+void TransformHierarchy::orphan(uint32_t row)
+{
+    // a row whose world is current stays where it was, its world becoming its local. One whose local
+    // changed since the last flush was never placed under the parent it had, so it keeps that local.
+    if (m_dirty[row] != ROW_DIRTY_SELF) {
+        glm::vec3 translation, scale;
+        glm::quat rotation;
+        transform::decompose(m_world[row], translation, rotation, scale);
+        m_local[row] = transform::composeAffine(translation, rotation, scale);
+
+        TransformComponent &component = m_registry.getPool<TransformComponent>()->get(m_entities[row]);
+        component.translation = translation;
+        component.rotation = rotation;
+        component.scale = scale;
+    }
+
+    m_parentEntities[row] = ecs::ENTITY_NULL;
+    m_orderDirty = true;
+    queue(row, ROW_DIRTY_SELF);
+}
+
+void TransformHierarchy::rebuildOrder()
+{
+    RAPTURE_PROFILE_SCOPE("TransformHierarchy::rebuildOrder");
+
+    const uint32_t rowCount = static_cast<uint32_t>(m_entities.size());
+
+    // children per old row as a compact adjacency list, in row order so the result is stable
+    std::vector<uint32_t> oldParents(rowCount);
+    std::vector<uint32_t> childOffsets(rowCount + 1, 0);
+    for (uint32_t row = 0; row < rowCount; ++row) {
+        uint32_t parentRow = rowOf(m_parentEntities[row]);
+        if (parentRow == NO_ROW && m_parentEntities[row] != ecs::ENTITY_NULL) {
+            orphan(row);
+        }
+        oldParents[row] = parentRow;
+        if (parentRow != NO_ROW) {
+            childOffsets[parentRow + 1]++;
+        }
+    }
+    for (uint32_t row = 0; row < rowCount; ++row) {
+        childOffsets[row + 1] += childOffsets[row];
+    }
+    std::vector<uint32_t> children(childOffsets[rowCount]);
+    std::vector<uint32_t> fill(childOffsets.begin(), childOffsets.end() - 1);
+    for (uint32_t row = 0; row < rowCount; ++row) {
+        if (oldParents[row] != NO_ROW) {
+            children[fill[oldParents[row]]++] = row;
+        }
+    }
+
+    // breadth first from every root at once, so depths never decrease along the order
+    std::vector<uint32_t> order;
+    order.reserve(rowCount);
+    for (uint32_t row = 0; row < rowCount; ++row) {
+        if (oldParents[row] == NO_ROW) {
+            order.push_back(row);
+        }
+    }
+
+    std::vector<uint32_t> newRowOf(rowCount, NO_ROW);
+    m_firstChild.assign(rowCount + 1, rowCount);
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        newRowOf[order[i]] = i;
+    }
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        uint32_t oldRow = order[i];
+        m_firstChild[i] = static_cast<uint32_t>(order.size());
+        for (uint32_t c = childOffsets[oldRow]; c < childOffsets[oldRow + 1]; ++c) {
+            newRowOf[children[c]] = static_cast<uint32_t>(order.size());
+            order.push_back(children[c]);
+        }
+    }
+    RP_ASSERT(order.size() == rowCount, "setParent rejects cycles, so every row is reachable from a root");
+
+    std::vector<ecs::Entity> entities(rowCount);
+    std::vector<ecs::Entity> parentEntities(rowCount);
+    std::vector<Affine3x4> local(rowCount);
+    std::vector<Affine3x4> world(rowCount);
+    std::vector<uint8_t> dirty(rowCount);
+    for (uint32_t i = 0; i < rowCount; ++i) {
+        uint32_t oldRow = order[i];
+        entities[i] = m_entities[oldRow];
+        parentEntities[i] = m_parentEntities[oldRow];
+        local[i] = m_local[oldRow];
+        world[i] = m_world[oldRow];
+        dirty[i] = m_dirty[oldRow];
+
+        uint32_t parentRow = oldParents[oldRow] != NO_ROW ? newRowOf[oldParents[oldRow]] : NO_ROW;
+        m_parents[i] = parentRow;
+        m_depths[i] = parentRow != NO_ROW ? m_depths[parentRow] + 1 : 0;
+        m_rowOf[ecs::EntityIndex(entities[i])] = i;
+    }
+    m_entities = std::move(entities);
+    m_parentEntities = std::move(parentEntities);
+    m_local = std::move(local);
+    m_world = std::move(world);
+    m_dirty = std::move(dirty);
+
+    m_levels.clear();
+    for (uint32_t i = 0; i < rowCount; ++i) {
+        while (m_levels.size() <= m_depths[i]) {
+            m_levels.push_back(i);
+        }
+    }
+    m_levels.push_back(rowCount);
+
+    m_orderDirty = false;
+}
+
+void TransformHierarchy::updateRange(RowRange range, bool roots)
+{
+    if (roots) {
+        std::copy(m_local.begin() + range.begin, m_local.begin() + range.end, m_world.begin() + range.begin);
+    } else {
+        transform::multiplyHierarchyRange(m_parents.data(), m_local.data(), m_world.data(), range.begin, range.end);
+    }
+
+    auto *pool = m_registry.getPool<TransformComponent>();
+    for (uint32_t row = range.begin; row < range.end; ++row) {
+        pool->get(m_entities[row]).world = m_world[row];
+    }
+}
+
+void TransformHierarchy::updateLevel(const std::vector<RowRange> &ranges, bool roots)
+{
+    uint32_t rows = 0;
+    for (const RowRange &range : ranges) {
+        rows += range.end - range.begin;
+    }
+
+    if (rows < m_parallelThreshold) {
+        for (const RowRange &range : ranges) {
+            updateRange(range, roots);
+        }
+        return;
+    }
+
+    // every row of a level only reads the level above, so any split of it is independent
+    m_chunks.clear();
+    for (const RowRange &range : ranges) {
+        for (uint32_t begin = range.begin; begin < range.end; begin += PARALLEL_CHUNK_ROWS) {
+            m_chunks.push_back({begin, std::min(range.end, begin + PARALLEL_CHUNK_ROWS)});
+        }
+    }
+
+    Counter counter{};
+    counter.increment(static_cast<int32_t>(m_chunks.size()));
+    for (const RowRange &chunk : m_chunks) {
+        jobs().run(JobDeclaration([this, chunk, roots](JobContext &) { updateRange(chunk, roots); }, JobPriority::HIGH,
+                                  QueueAffinity::ANY, &counter, "Transform hierarchy level"));
+    }
+    jobs().waitFor(counter, 0);
+
+    m_lastFlush.parallelJobs += static_cast<uint32_t>(m_chunks.size());
+}
+
+void TransformHierarchy::flush()
+{
+    if (!hasPending()) {
+        return;
+    }
+
+    RAPTURE_PROFILE_SCOPE("TransformHierarchy::flush");
+
+    m_lastFlush = {};
+
+    refreshAdded();
+    if (m_orderDirty) {
+        rebuildOrder();
+        m_lastFlush.reordered = true;
+    }
+
+    const uint32_t levelCount = getLevelCount();
+    for (auto &seeds : m_seeds) {
+        seeds.clear();
+    }
+    if (m_seeds.size() < levelCount + 1) {
+        m_seeds.resize(levelCount + 1);
+    }
+
+    // queued rows seed the level they sit on, or the one below if only their children are stale
+    uint32_t firstLevel = levelCount;
+    uint32_t lastLevel = 0;
+    for (ecs::Entity entity : m_pending) {
+        uint32_t row = rowOf(entity);
+        if (row == NO_ROW || m_dirty[row] == ROW_CLEAN) {
+            continue;
+        }
+
+        uint32_t level = m_depths[row];
+        RowRange range = {row, row + 1};
+        if (m_dirty[row] == ROW_DIRTY_CHILDREN) {
+            level++;
+            range = {m_firstChild[row], m_firstChild[row + 1]};
+        }
+        m_dirty[row] = ROW_CLEAN;
+
+        if (range.begin == range.end) {
+            continue;
+        }
+        m_seeds[level].push_back(range);
+        firstLevel = std::min(firstLevel, level);
+        lastLevel = std::max(lastLevel, level);
+    }
+    m_pending.clear();
+
+    m_written.clear();
+    m_nextRanges.clear();
+    for (uint32_t level = firstLevel; level < levelCount; ++level) {
+        m_levelRanges.swap(m_nextRanges);
+        m_levelRanges.insert(m_levelRanges.end(), m_seeds[level].begin(), m_seeds[level].end());
+        m_nextRanges.clear();
+
+        if (m_levelRanges.empty()) {
+            if (level >= lastLevel) {
+                break;
+            }
+            continue;
+        }
+
+        // a queued row whose parent is also being updated is covered by the parent's child range
+        std::sort(m_levelRanges.begin(), m_levelRanges.end(),
+                  [](const RowRange &a, const RowRange &b) { return a.begin < b.begin; });
+        size_t merged = 0;
+        for (size_t i = 1; i < m_levelRanges.size(); ++i) {
+            if (m_levelRanges[i].begin <= m_levelRanges[merged].end) {
+                m_levelRanges[merged].end = std::max(m_levelRanges[merged].end, m_levelRanges[i].end);
+            } else {
+                m_levelRanges[++merged] = m_levelRanges[i];
+            }
+        }
+        m_levelRanges.resize(merged + 1);
+
+        updateLevel(m_levelRanges, level == 0);
+
+        m_lastFlush.levels++;
+        m_lastFlush.ranges += static_cast<uint32_t>(m_levelRanges.size());
+        for (const RowRange &range : m_levelRanges) {
+            m_lastFlush.rowsUpdated += range.end - range.begin;
+            m_written.push_back(range);
+
+            // the children of a run of rows are one run on the next level
+            RowRange next = {m_firstChild[range.begin], m_firstChild[range.end]};
+            if (next.begin == next.end) {
+                continue;
+            }
+            if (!m_nextRanges.empty() && m_nextRanges.back().end == next.begin) {
+                m_nextRanges.back().end = next.end;
+            } else {
+                m_nextRanges.push_back(next);
+            }
+        }
+    }
+
+    ecs::Journal &journal = m_registry.getJournal();
+    for (const RowRange &range : m_written) {
+        journal.record(std::span(m_entities).subspan(range.begin, range.end - range.begin),
+                       ecs::ChannelBit(CHANNEL_TRANSFORM_WORLD));
+    }
+
+    RAPTURE_PROFILE_PLOT("Transform Rows Updated", static_cast<int64_t>(m_lastFlush.rowsUpdated));
+}
+
+} // namespace Rapture
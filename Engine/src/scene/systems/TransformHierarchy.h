@@ -0,0 +1,212 @@
+#ifndef RAPTURE__TRANSFORM_HIERARCHY_H
+#define RAPTURE__TRANSFORM_HIERARCHY_H
+
+#include "core/ecs/component_signal.h"
+#include "core/ecs/registry.h"
+#include "scene/systems/Transforms.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Rapture {
+
+struct TransformComponent;
+
+/**
+ * @brief What the last TransformHierarchy::flush did, for the profiler and benchmarks
+ */
+struct TransformFlushStats {
+    uint32_t rowsUpdated = 0;
+    uint32_t levels = 0;     // depths that had at least one row to update
+    uint32_t ranges = 0;     // contiguous runs the updated rows were processed in
+    uint32_t parallelJobs = 0;
+    bool reordered = false; // whether a structural change made the table re-sort first
+};
+
+/**
+ * @brief A world transform to place one entity at, for TransformHierarchy::setWorlds
+ */
+struct WorldPlacement {
+    ecs::Entity entity = ecs::ENTITY_NULL;
+    Affine3x4 world;
+};
+
+/**
+ * @brief Flat table of every TransformComponent in a registry, sorted breadth first by depth
+ *
+ * Each row holds its parent's row and the local and world transforms as affine 3x4 matrices, each
+ * field in its own array.
+ * Rows are ordered level by level and, within a level, grouped by parent in the order the parents
+ * appear, so the children of any run of rows are themselves one contiguous run. Updating a subtree is
+ * then a sequence of contiguous ranges, one set per level, each row only reading the level above it.
+ *
+ * Writes are lazy. setLocal() and the like only queue the row, and flush() later walks the queued
+ * rows level by level, composing each range with SIMD and splitting large levels into jobs. The
+ * finished world transforms are copied into the TransformComponents and recorded on
+ * CHANNEL_TRANSFORM_WORLD. Anything that needs a current world transform before the next flush reads
+ * it through world(), which only resolves the chain above the row asked for.
+ *
+ * Rows follow the TransformComponent pool on their own, an entity gets one when it gains the
+ * component and loses it with the component. A new row is queued with whatever translation, rotation
+ * and scale its creator put in the component by the time it is first read.
+ */
+class TransformHierarchy {
+  public:
+    explicit TransformHierarchy(ecs::Registry &registry);
+    ~TransformHierarchy();
+
+    TransformHierarchy(const TransformHierarchy &) = delete;
+    TransformHierarchy &operator=(const TransformHierarchy &) = delete;
+
+    /**
+     * @brief Parents one transform to another, keeping its local transform
+     * @param entity The entity to move, ignored if it has no row
+     * @param parent The new parent, or ecs::ENTITY_NULL to make it a root
+     */
+    void setParent(ecs::Entity entity, ecs::Entity parent);
+
+    /**
+     * @brief Replaces a local transform and queues the row and everything below it
+     * @param entity The entity to write, ignored if it has no row
+     * @param translation Position relative to the parent
+     * @param rotation Orientation relative to the parent
+     * @param scale Scale relative to the parent
+     */
+    void setLocal(ecs::Entity entity, const glm::vec3 &translation, const glm::quat &rotation, const glm::vec3 &scale);
+
+    /**
+     * @brief Replaces a local transform given as a matrix, which is split into its parts and loses any shear
+     */
+    void setLocal(ecs::Entity entity, const glm::mat4 &local);
+
+    /**
+     * @brief Places a row at a world transform directly, deriving its local transform from the parent
+     *
+     * The row keeps exactly the given world transform, only the rows below it are queued.
+     * @param entity The entity to write, ignored if it has no row
+     * @param world The world transform it should end up with
+     */
+    void setWorld(ecs::Entity entity, const glm::mat4 &world);
+
+    /**
+     * @brief setWorld() for many rows, with the changes recorded in one pass once every row is placed
+     *
+     * Placements are applied in order, so a row placed after its parent is derived from the parent's
+     * new world transform. Entities without a row are skipped.
+     * @param placements The rows to place and where
+     */
+    void setWorlds(std::span<const WorldPlacement> placements);
+
+    /**
+     * @brief Queues a row and everything below it without changing it
+     */
+    void markDirty(ecs::Entity entity);
+
+    /**
+     * @brief A current world transform, recomputing only the stale part of the chain above it
+     * @return The world transform, identity if the entity has no row
+     */
+    const Affine3x4 &world(ecs::Entity entity);
+
+    /**
+     * @brief Brings every queued row and its subtree up to date
+     *
+     * Levels with at least getParallelThreshold() rows to update are split across the job system and
+     * waited on, so this is called from the main thread.
+     */
+    void flush();
+
+    /**
+     * @brief Whether a flush has anything to do
+     */
+    bool hasPending() const { return !m_pending.empty() || m_orderDirty; }
+
+    uint32_t getCount() const { return static_cast<uint32_t>(m_entities.size()); }
+    uint32_t getLevelCount() const { return m_levels.empty() ? 0 : static_cast<uint32_t>(m_levels.size()) - 1; }
+
+    const TransformFlushStats &getLastFlushStats() const { return m_lastFlush; }
+
+    /**
+     * @brief Rows a level needs before it is split into jobs, UINT32_MAX keeps every flush on the calling thread
+     */
+    uint32_t getParallelThreshold() const { return m_parallelThreshold; }
+    void setParallelThreshold(uint32_t rows) { m_parallelThreshold = rows; }
+
+  private:
+    struct RowRange {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    void addRow(ecs::Entity entity);
+    void removeRow(ecs::Entity entity);
+    uint32_t rowOf(ecs::Entity entity) const;
+    void queue(uint32_t row, uint8_t dirty);
+
+    /**
+     * @brief The part of setWorld() that places a row, without recording the change
+     */
+    void placeWorld(uint32_t row, const Affine3x4 &target, TransformComponent &component);
+
+    /**
+     * @brief Picks up the local transforms the creators of new rows wrote after adding the component
+     */
+    void refreshAdded();
+
+    /**
+     * @brief Makes a row whose parent lost its transform a root, left where it was
+     */
+    void orphan(uint32_t row);
+
+    /**
+     * @brief Re-sorts the table breadth first after rows were added, removed or reparented
+     */
+    void rebuildOrder();
+
+    /**
+     * @brief Composes a set of ranges on one level and mirrors them into the components
+     */
+    void updateLevel(const std::vector<RowRange> &ranges, bool roots);
+    void updateRange(RowRange range, bool roots);
+
+  private:
+    ecs::Registry &m_registry;
+    ecs::SignalConnection m_constructConnection;
+    ecs::SignalConnection m_destroyConnection;
+
+    // one entry per row, in breadth first order once m_orderDirty is clear
+    std::vector<ecs::Entity> m_entities;
+    std::vector<ecs::Entity> m_parentEntities; // what the row is parented to, survives reordering
+    std::vector<uint32_t> m_parents;           // the parent's row, only valid while the order is
+    std::vector<uint32_t> m_depths;
+    std::vector<Affine3x4> m_local; // composed from the component's translation, rotation and scale
+    std::vector<Affine3x4> m_world;
+    std::vector<uint8_t> m_dirty;
+
+    // the children of row r are the rows [m_firstChild[r], m_firstChild[r + 1]), sized rows + 1
+    std::vector<uint32_t> m_firstChild;
+    // the rows at depth d are [m_levels[d], m_levels[d + 1])
+    std::vector<uint32_t> m_levels;
+
+    std::vector<uint32_t> m_rowOf; // entity index -> row
+    std::vector<ecs::Entity> m_pending;
+    std::vector<ecs::Entity> m_added;
+    bool m_orderDirty = false;
+
+    // flush scratch, kept to avoid reallocating every frame
+    std::vector<std::vector<RowRange>> m_seeds;
+    std::vector<RowRange> m_levelRanges;
+    std::vector<RowRange> m_nextRanges;
+    std::vector<RowRange> m_chunks;
+    std::vector<RowRange> m_written;
+    std::vector<uint32_t> m_chain;
+    std::vector<ecs::Entity> m_placed;
+
+    uint32_t m_parallelThreshold;
+    TransformFlushStats m_lastFlush;
+};
+
+} // namespace Rapture
+
+#endif // RAPTURE__TRANSFORM_HIERARCHY_H
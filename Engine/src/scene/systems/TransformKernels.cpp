@@ -0,0 +1,382 @@
+#include "TransformKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RAPTURE_TRANSFORM_SSE 1
+#endif
+
+#if RAPTURE_TRANSFORM_SSE && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+namespace Rapture::transform {
+
+#if RAPTURE_TRANSFORM_SSE
+
+static constexpr size_t LANES = 4;
+
+/**
+ * @brief Four transforms across the lanes of twelve registers, m[r][c] holding element (r, c) of each
+ */
+struct AffineLanes {
+    __m128 m[3][4];
+};
+
+struct Vec3Lanes {
+    __m128 x, y, z;
+};
+
+static inline __m128 s_madd(__m128 a, __m128 b, __m128 c)
+{
+#if defined(__FMA__)
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+static inline __m128 s_select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 s_abs(__m128 value)
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+}
+
+static inline __m128 s_loadRow(const Affine3x4 &matrix, int row)
+{
+    return _mm_loadu_ps(&matrix.rows[row].x);
+}
+
+static inline void s_storeRow(Affine3x4 &matrix, int row, __m128 value)
+{
+    _mm_storeu_ps(&matrix.rows[row].x, value);
+}
+
+static void s_loadLanes(const Affine3x4 *matrices, AffineLanes &lanes)
+{
+    for (int row = 0; row < 3; ++row) {
+        __m128 a = s_loadRow(matrices[0], row);
+        __m128 b = s_loadRow(matrices[1], row);
+        __m128 c = s_loadRow(matrices[2], row);
+        __m128 d = s_loadRow(matrices[3], row);
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+        lanes.m[row][0] = a;
+        lanes.m[row][1] = b;
+        lanes.m[row][2] = c;
+        lanes.m[row][3] = d;
+    }
+}
+
+static void s_storeLanes(const AffineLanes &lanes, Affine3x4 *matrices)
+{
+    for (int row = 0; row < 3; ++row) {
+        __m128 a = lanes.m[row][0];
+        __m128 b = lanes.m[row][1];
+        __m128 c = lanes.m[row][2];
+        __m128 d = lanes.m[row][3];
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+        s_storeRow(matrices[0], row, a);
+        s_storeRow(matrices[1], row, b);
+        s_storeRow(matrices[2], row, c);
+        s_storeRow(matrices[3], row, d);
+    }
+}
+
+// glm only guarantees the order of a vec3's members, not its padding, so these go member by member
+static Vec3Lanes s_loadVec3Lanes(const glm::vec3 *values)
+{
+    return {_mm_setr_ps(values[0].x, values[1].x, values[2].x, values[3].x),
+            _mm_setr_ps(values[0].y, values[1].y, values[2].y, values[3].y),
+            _mm_setr_ps(values[0].z, values[1].z, values[2].z, values[3].z)};
+}
+
+static void s_storeVec3Lanes(const Vec3Lanes &lanes, glm::vec3 *values)
+{
+    alignas(16) float x[LANES], y[LANES], z[LANES];
+    _mm_store_ps(x, lanes.x);
+    _mm_store_ps(y, lanes.y);
+    _mm_store_ps(z, lanes.z);
+    for (size_t i = 0; i < LANES; ++i) {
+        values[i] = glm::vec3(x[i], y[i], z[i]);
+    }
+}
+
+/**
+ * @brief The rows of parent * child, with the parent already split into broadcasts
+ */
+struct ParentBroadcast {
+    __m128 x[3], y[3], z[3], w[3];
+
+    explicit ParentBroadcast(const Affine3x4 &parent)
+    {
+        const __m128 wMask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+        for (int row = 0; row < 3; ++row) {
+            __m128 p = s_loadRow(parent, row);
+            x[row] = _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0));
+            y[row] = _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1));
+            z[row] = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2));
+            w[row] = _mm_and_ps(p, wMask);
+        }
+    }
+
+    void apply(const Affine3x4 &child, Affine3x4 &out) const
+    {
+        const __m128 c0 = s_loadRow(child, 0);
+        const __m128 c1 = s_loadRow(child, 1);
+        const __m128 c2 = s_loadRow(child, 2);
+        for (int row = 0; row < 3; ++row) {
+            __m128 result = s_madd(x[row], c0, w[row]);
+            result = s_madd(y[row], c1, result);
+            result = s_madd(z[row], c2, result);
+            s_storeRow(out, row, result);
+        }
+    }
+};
+
+#endif // RAPTURE_TRANSFORM_SSE
+
+void composeBatch(const glm::vec3 *translations, const glm::quat *rotations, const glm::vec3 *scales, Affine3x4 *out,
+                  size_t count)
+{
+    size_t i = 0;
+#if RAPTURE_TRANSFORM_SSE
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    for (; i + LANES <= count; i += LANES) {
+        const glm::quat *q = rotations + i;
+        const __m128 qx = _mm_setr_ps(q[0].x, q[1].x, q[2].x, q[3].x);
+        const __m128 qy = _mm_setr_ps(q[0].y, q[1].y, q[2].y, q[3].y);
+        const __m128 qz = _mm_setr_ps(q[0].z, q[1].z, q[2].z, q[3].z);
+        const __m128 qw = _mm_setr_ps(q[0].w, q[1].w, q[2].w, q[3].w);
+        const Vec3Lanes t = s_loadVec3Lanes(translations + i);
+        const Vec3Lanes s = s_loadVec3Lanes(scales + i);
+
+        const __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+        const __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+        const __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+        AffineLanes lanes;
+        lanes.m[0][0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), s.x);
+        lanes.m[0][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), s.y);
+        lanes.m[0][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), s.z);
+        lanes.m[0][3] = t.x;
+        lanes.m[1][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), s.x);
+        lanes.m[1][1] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), s.y);
+        lanes.m[1][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), s.z);
+        lanes.m[1][3] = t.y;
+        lanes.m[2][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), s.x);
+        lanes.m[2][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), s.y);
+        lanes.m[2][2] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), s.z);
+        lanes.m[2][3] = t.z;
+        s_storeLanes(lanes, out + i);
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = composeAffine(translations[i], rotations[i], scales[i]);
+    }
+}
+
+void multiplyBatch(const Affine3x4 *parents, const Affine3x4 *children, Affine3x4 *out, size_t count)
+{
+#if RAPTURE_TRANSFORM_SSE
+    for (size_t i = 0; i < count; ++i) {
+        ParentBroadcast(parents[i]).apply(children[i], out[i]);
+    }
+#else
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = multiply(parents[i], children[i]);
+    }
+#endif
+}
+
+void multiplyHierarchyRange(const uint32_t *parents, const Affine3x4 *locals, Affine3x4 *worlds, uint32_t begin,
+                            uint32_t end)
+{
+#if RAPTURE_TRANSFORM_SSE
+    uint32_t row = begin;
+    while (row < end) {
+        const uint32_t parent = parents[row];
+        const ParentBroadcast broadcast(worlds[parent]);
+        for (; row < end && parents[row] == parent; ++row) {
+            broadcast.apply(locals[row], worlds[row]);
+        }
+    }
+#else
+    for (uint32_t row = begin; row < end; ++row) {
+        worlds[row] = multiply(worlds[parents[row]], locals[row]);
+    }
+#endif
+}
+
+void inverseBatch(const Affine3x4 *matrices, Affine3x4 *out, size_t count)
+{
+    size_t i = 0;
+#if RAPTURE_TRANSFORM_SSE
+    for (; i + LANES <= count; i += LANES) {
+        AffineLanes in;
+        s_loadLanes(matrices + i, in);
+        const auto &m = in.m;
+
+        // the columns of the inverse are the cross products of the rows, over the determinant
+        const __m128 c0x = _mm_sub_ps(_mm_mul_ps(m[1][1], m[2][2]), _mm_mul_ps(m[1][2], m[2][1]));
+        const __m128 c0y = _mm_sub_ps(_mm_mul_ps(m[1][2], m[2][0]), _mm_mul_ps(m[1][0], m[2][2]));
+        const __m128 c0z = _mm_sub_ps(_mm_mul_ps(m[1][0], m[2][1]), _mm_mul_ps(m[1][1], m[2][0]));
+        const __m128 c1x = _mm_sub_ps(_mm_mul_ps(m[2][1], m[0][2]), _mm_mul_ps(m[2][2], m[0][1]));
+        const __m128 c1y = _mm_sub_ps(_mm_mul_ps(m[2][2], m[0][0]), _mm_mul_ps(m[2][0], m[0][2]));
+        const __m128 c1z = _mm_sub_ps(_mm_mul_ps(m[2][0], m[0][1]), _mm_mul_ps(m[2][1], m[0][0]));
+        const __m128 c2x = _mm_sub_ps(_mm_mul_ps(m[0][1], m[1][2]), _mm_mul_ps(m[0][2], m[1][1]));
+        const __m128 c2y = _mm_sub_ps(_mm_mul_ps(m[0][2], m[1][0]), _mm_mul_ps(m[0][0], m[1][2]));
+        const __m128 c2z = _mm_sub_ps(_mm_mul_ps(m[0][0], m[1][1]), _mm_mul_ps(m[0][1], m[1][0]));
+
+        const __m128 det = s_madd(m[0][0], c0x, s_madd(m[0][1], c0y, _mm_mul_ps(m[0][2], c0z)));
+        const __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+        const __m128 columns[3][3] = {{c0x, c0y, c0z}, {c1x, c1y, c1z}, {c2x, c2y, c2z}};
+        AffineLanes result;
+        for (int row = 0; row < 3; ++row) {
+            __m128 translation = _mm_setzero_ps();
+            for (int column = 0; column < 3; ++column) {
+                result.m[row][column] = _mm_mul_ps(columns[column][row], invDet);
+                translation = s_madd(result.m[row][column], m[column][3], translation);
+            }
+            result.m[row][3] = _mm_sub_ps(_mm_setzero_ps(), translation);
+        }
+        s_storeLanes(result, out + i);
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = inverse(matrices[i]);
+    }
+}
+
+void transformBoundsBatch(const Affine3x4 *matrices, const glm::vec3 *mins, const glm::vec3 *maxs, glm::vec3 *outMins,
+                          glm::vec3 *outMaxs, size_t count)
+{
+    size_t i = 0;
+#if RAPTURE_TRANSFORM_SSE
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; i + LANES <= count; i += LANES) {
+        AffineLanes in;
+        s_loadLanes(matrices + i, in);
+        const Vec3Lanes lo = s_loadVec3Lanes(mins + i);
+        const Vec3Lanes hi = s_loadVec3Lanes(maxs + i);
+
+        const __m128 center[3] = {_mm_mul_ps(_mm_add_ps(lo.x, hi.x), half), _mm_mul_ps(_mm_add_ps(lo.y, hi.y), half),
+                                  _mm_mul_ps(_mm_add_ps(lo.z, hi.z), half)};
+        const __m128 extent[3] = {_mm_mul_ps(_mm_sub_ps(hi.x, lo.x), half), _mm_mul_ps(_mm_sub_ps(hi.y, lo.y), half),
+                                  _mm_mul_ps(_mm_sub_ps(hi.z, lo.z), half)};
+
+        __m128 newCenter[3], newExtent[3];
+        for (int row = 0; row < 3; ++row) {
+            newCenter[row] = in.m[row][3];
+            newExtent[row] = _mm_setzero_ps();
+            for (int column = 0; column < 3; ++column) {
+                newCenter[row] = s_madd(in.m[row][column], center[column], newCenter[row]);
+                newExtent[row] = s_madd(s_abs(in.m[row][column]), extent[column], newExtent[row]);
+            }
+        }
+
+        s_storeVec3Lanes({_mm_sub_ps(newCenter[0], newExtent[0]), _mm_sub_ps(newCenter[1], newExtent[1]),
+                          _mm_sub_ps(newCenter[2], newExtent[2])},
+                         outMins + i);
+        s_storeVec3Lanes({_mm_add_ps(newCenter[0], newExtent[0]), _mm_add_ps(newCenter[1], newExtent[1]),
+                          _mm_add_ps(newCenter[2], newExtent[2])},
+                         outMaxs + i);
+    }
+#endif
+    for (; i < count; ++i) {
+        const Affine3x4 &m = matrices[i];
+        const glm::vec3 center = (mins[i] + maxs[i]) * 0.5f;
+        const glm::vec3 extent = (maxs[i] - mins[i]) * 0.5f;
+
+        glm::vec3 newCenter, newExtent;
+        for (int row = 0; row < 3; ++row) {
+            const glm::vec3 axes(m.rows[row]);
+            newCenter[row] = glm::dot(axes, center) + m.rows[row].w;
+            newExtent[row] = glm::dot(glm::abs(axes), extent);
+        }
+        outMins[i] = newCenter - newExtent;
+        outMaxs[i] = newCenter + newExtent;
+    }
+}
+
+void decomposeBatch(const Affine3x4 *matrices, glm::vec3 *translations, glm::quat *rotations, glm::vec3 *scales,
+                    size_t count)
+{
+    size_t i = 0;
+#if RAPTURE_TRANSFORM_SSE
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; i + LANES <= count; i += LANES) {
+        AffineLanes in;
+        s_loadLanes(matrices + i, in);
+        const auto &m = in.m;
+
+        __m128 scale[3], r[3][3];
+        for (int column = 0; column < 3; ++column) {
+            __m128 squared = _mm_mul_ps(m[0][column], m[0][column]);
+            squared = s_madd(m[1][column], m[1][column], squared);
+            squared = s_madd(m[2][column], m[2][column], squared);
+            scale[column] = _mm_sqrt_ps(squared);
+
+            const __m128 invScale = _mm_div_ps(one, scale[column]);
+            for (int row = 0; row < 3; ++row) {
+                r[row][column] = _mm_mul_ps(m[row][column], invScale);
+            }
+        }
+
+        // Same choice as glm::quat_cast: solve for the largest component first, w then x, y and z on ties
+        const __m128 fourW = _mm_add_ps(_mm_add_ps(r[0][0], r[1][1]), r[2][2]);
+        const __m128 fourX = _mm_sub_ps(_mm_sub_ps(r[0][0], r[1][1]), r[2][2]);
+        const __m128 fourY = _mm_sub_ps(_mm_sub_ps(r[1][1], r[0][0]), r[2][2]);
+        const __m128 fourZ = _mm_sub_ps(_mm_sub_ps(r[2][2], r[0][0]), r[1][1]);
+
+        __m128 biggest = fourW;
+        const __m128 pickX = _mm_cmpgt_ps(fourX, biggest);
+        biggest = _mm_max_ps(biggest, fourX);
+        const __m128 pickY = _mm_cmpgt_ps(fourY, biggest);
+        biggest = _mm_max_ps(biggest, fourY);
+        const __m128 pickZ = _mm_cmpgt_ps(fourZ, biggest);
+        biggest = _mm_max_ps(biggest, fourZ);
+        // a later pick overrides the earlier ones, which is the order the comparisons ran in
+        const __m128 isZ = pickZ;
+        const __m128 isY = _mm_andnot_ps(isZ, pickY);
+        const __m128 isX = _mm_andnot_ps(_mm_or_ps(isZ, pickY), pickX);
+
+        const __m128 big = _mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(biggest, one)), _mm_set1_ps(0.5f));
+        const __m128 mult = _mm_div_ps(_mm_set1_ps(0.25f), big);
+
+        const __m128 a = _mm_mul_ps(_mm_sub_ps(r[2][1], r[1][2]), mult);
+        const __m128 b = _mm_mul_ps(_mm_sub_ps(r[0][2], r[2][0]), mult);
+        const __m128 c = _mm_mul_ps(_mm_sub_ps(r[1][0], r[0][1]), mult);
+        const __m128 d = _mm_mul_ps(_mm_add_ps(r[0][1], r[1][0]), mult);
+        const __m128 e = _mm_mul_ps(_mm_add_ps(r[0][2], r[2][0]), mult);
+        const __m128 f = _mm_mul_ps(_mm_add_ps(r[1][2], r[2][1]), mult);
+
+        //           w is biggest    x is biggest       y is biggest       z is biggest
+        const __m128 qw = s_select(isZ, c, s_select(isY, b, s_select(isX, a, big)));
+        const __m128 qx = s_select(isZ, e, s_select(isY, d, s_select(isX, big, a)));
+        const __m128 qy = s_select(isZ, f, s_select(isY, big, s_select(isX, d, b)));
+        const __m128 qz = s_select(isZ, big, s_select(isY, f, s_select(isX, e, c)));
+
+        s_storeVec3Lanes({m[0][3], m[1][3], m[2][3]}, translations + i);
+        s_storeVec3Lanes({scale[0], scale[1], scale[2]}, scales + i);
+
+        alignas(16) float w[LANES], x[LANES], y[LANES], z[LANES];
+        _mm_store_ps(w, qw);
+        _mm_store_ps(x, qx);
+        _mm_store_ps(y, qy);
+        _mm_store_ps(z, qz);
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            rotations[i + lane] = glm::quat(w[lane], x[lane], y[lane], z[lane]);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        decompose(matrices[i], translations[i], rotations[i], scales[i]);
+    }
+}
+
+} // namespace Rapture::transform
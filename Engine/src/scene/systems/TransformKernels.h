@@ -0,0 +1,68 @@
+#ifndef RAPTURE__TRANSFORM_KERNELS_H
+#define RAPTURE__TRANSFORM_KERNELS_H
+
+#include "scene/systems/Transforms.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Batch versions of the transform math in Transforms.h, for systems that walk whole arrays of
+// transforms. Where the target has SSE the kernels work on four transforms at a time, spread across
+// the lanes of a register; elsewhere, and for the last few of a batch, they call the single
+// transform functions. Output arrays may not overlap the inputs unless a kernel says otherwise.
+
+namespace Rapture::transform {
+
+/**
+ * @brief composeAffine() over arrays of parts
+ * @param translations Positions, count of them
+ * @param rotations Normalized orientations, count of them
+ * @param scales Scales along each axis, count of them
+ * @param out Receives count transforms
+ * @param count How many transforms to compose
+ */
+void composeBatch(const glm::vec3 *translations, const glm::quat *rotations, const glm::vec3 *scales, Affine3x4 *out,
+                  size_t count);
+
+/**
+ * @brief out[i] = parents[i] * children[i]
+ */
+void multiplyBatch(const Affine3x4 *parents, const Affine3x4 *children, Affine3x4 *out, size_t count);
+
+/**
+ * @brief worlds[i] = worlds[parents[i]] * locals[i] for every i in [begin, end)
+ *
+ * The parent rows must lie outside the range, which a breadth first table guarantees. Rows that
+ * share a parent in a row reuse it from registers, so siblings stored together are cheapest.
+ */
+void multiplyHierarchyRange(const uint32_t *parents, const Affine3x4 *locals, Affine3x4 *worlds, uint32_t begin,
+                            uint32_t end);
+
+/**
+ * @brief inverse() over an array
+ */
+void inverseBatch(const Affine3x4 *matrices, Affine3x4 *out, size_t count);
+
+/**
+ * @brief The axis aligned bounds of transformed boxes, from their centers and extents
+ *
+ * Exact for the eight corners, like transforming every corner, without the eight transforms.
+ * @param matrices One transform per box
+ * @param mins Box minimums, expected not to exceed the maximums
+ * @param maxs Box maximums
+ * @param outMins Receives the transformed minimums
+ * @param outMaxs Receives the transformed maximums
+ * @param count How many boxes to transform
+ */
+void transformBoundsBatch(const Affine3x4 *matrices, const glm::vec3 *mins, const glm::vec3 *maxs, glm::vec3 *outMins,
+                          glm::vec3 *outMaxs, size_t count);
+
+/**
+ * @brief decompose() over an array, dropping any shear
+ */
+void decomposeBatch(const Affine3x4 *matrices, glm::vec3 *translations, glm::quat *rotations, glm::vec3 *scales,
+                    size_t count);
+
+} // namespace Rapture::transform
+
+#endif // RAPTURE__TRANSFORM_KERNELS_H
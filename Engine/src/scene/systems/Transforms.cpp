@@ -64,4 +64,101 @@ glm::mat4 toLocal(const glm::mat4 &parentWorld, const glm::mat4 &world)
     return glm::inverse(parentWorld) * world;
 }
 
+Affine3x4 composeAffine(const glm::vec3 &translation, const glm::quat &rotation, const glm::vec3 &scale)
+{
+    const float xx = rotation.x * rotation.x, yy = rotation.y * rotation.y, zz = rotation.z * rotation.z;
+    const float xy = rotation.x * rotation.y, xz = rotation.x * rotation.z, yz = rotation.y * rotation.z;
+    const float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+
+    Affine3x4 result;
+    result.rows[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy - wz) * scale.y, 2.0f * (xz + wy) * scale.z,
+                               translation.x);
+    result.rows[1] = glm::vec4(2.0f * (xy + wz) * scale.x, (1.0f - 2.0f * (xx + zz)) * scale.y, 2.0f * (yz - wx) * scale.z,
+                               translation.y);
+    result.rows[2] = glm::vec4(2.0f * (xz - wy) * scale.x, 2.0f * (yz + wx) * scale.y, (1.0f - 2.0f * (xx + yy)) * scale.z,
+                               translation.z);
+    return result;
+}
+
+void decompose(const Affine3x4 &matrix, glm::vec3 &translation, glm::quat &rotation, glm::vec3 &scale)
+{
+    translation = transform::translation(matrix);
+    scale = transform::scale(matrix);
+
+    glm::mat3 axes;
+    for (int column = 0; column < 3; ++column) {
+        for (int row = 0; row < 3; ++row) {
+            axes[column][row] = matrix.rows[row][column] / scale[column];
+        }
+    }
+    rotation = glm::quat_cast(axes);
+}
+
+Affine3x4 toAffine(const glm::mat4 &matrix)
+{
+    Affine3x4 result;
+    for (int row = 0; row < 3; ++row) {
+        result.rows[row] = glm::vec4(matrix[0][row], matrix[1][row], matrix[2][row], matrix[3][row]);
+    }
+    return result;
+}
+
+glm::mat4 toMat4(const Affine3x4 &matrix)
+{
+    glm::mat4 result(1.0f);
+    for (int row = 0; row < 3; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            result[column][row] = matrix.rows[row][column];
+        }
+    }
+    return result;
+}
+
+Affine3x4 multiply(const Affine3x4 &parent, const Affine3x4 &child)
+{
+    Affine3x4 result;
+    for (int row = 0; row < 3; ++row) {
+        const glm::vec4 &p = parent.rows[row];
+        result.rows[row] = p.x * child.rows[0] + p.y * child.rows[1] + p.z * child.rows[2] + glm::vec4(0.0f, 0.0f, 0.0f, p.w);
+    }
+    return result;
+}
+
+Affine3x4 inverse(const Affine3x4 &matrix)
+{
+    const glm::vec3 r0(matrix.rows[0]), r1(matrix.rows[1]), r2(matrix.rows[2]);
+
+    // the columns of the inverse are the cross products of the rows, over the determinant
+    const glm::vec3 c0 = glm::cross(r1, r2);
+    const glm::vec3 c1 = glm::cross(r2, r0);
+    const glm::vec3 c2 = glm::cross(r0, r1);
+    const float invDet = 1.0f / glm::dot(r0, c0);
+
+    Affine3x4 result;
+    const glm::vec3 t = translation(matrix);
+    for (int row = 0; row < 3; ++row) {
+        const glm::vec3 r = glm::vec3(c0[row], c1[row], c2[row]) * invDet;
+        result.rows[row] = glm::vec4(r, -glm::dot(r, t));
+    }
+    return result;
+}
+
+glm::vec3 translation(const Affine3x4 &matrix)
+{
+    return glm::vec3(matrix.rows[0].w, matrix.rows[1].w, matrix.rows[2].w);
+}
+
+glm::vec3 scale(const Affine3x4 &matrix)
+{
+    const glm::vec3 squared = glm::vec3(matrix.rows[0]) * glm::vec3(matrix.rows[0]) +
+                              glm::vec3(matrix.rows[1]) * glm::vec3(matrix.rows[1]) +
+                              glm::vec3(matrix.rows[2]) * glm::vec3(matrix.rows[2]);
+    return glm::sqrt(squared);
+}
+
+glm::vec3 forward(const Affine3x4 &matrix)
+{
+    return glm::normalize(-glm::vec3(matrix.rows[0].z, matrix.rows[1].z, matrix.rows[2].z));
+}
+
 } // namespace Rapture::transform
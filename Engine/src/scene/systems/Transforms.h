@@ -4,6 +4,23 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
+namespace Rapture {
+
+/**
+ * @brief A transform without the projective row, stored as three rows of four
+ *
+ * Row i holds the i-th component of the x, y and z axes followed by the i-th component of the
+ * translation, the layout VkTransformMatrixKHR uses. It is 48 bytes where a glm::mat4 is 64, and
+ * composing two of them skips the row that is always (0, 0, 0, 1).
+ */
+struct Affine3x4 {
+    glm::vec4 rows[3] = {glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.0f), glm::vec4(0.0f, 0.0f, 1.0f, 0.0f)};
+
+    bool operator==(const Affine3x4 &other) const = default;
+};
+
+} // namespace Rapture
+
 namespace Rapture::transform {
 
 /**
@@ -76,6 +93,45 @@ glm::vec3 forward(const glm::mat4 &matrix);
  */
 glm::mat4 toLocal(const glm::mat4 &parentWorld, const glm::mat4 &world);
 
+/**
+ * @brief Builds an affine transform from its parts without going through a 4x4 matrix
+ * @param translation Position
+ * @param rotation Orientation, expected to be normalized
+ * @param scale Scale along each axis
+ * @return The composed transform
+ */
+Affine3x4 composeAffine(const glm::vec3 &translation, const glm::quat &rotation, const glm::vec3 &scale);
+
+/**
+ * @brief Splits an affine transform into its parts, dropping any shear
+ */
+void decompose(const Affine3x4 &matrix, glm::vec3 &translation, glm::quat &rotation, glm::vec3 &scale);
+
+/**
+ * @brief Drops the projective row of a 4x4 matrix, which is expected to be (0, 0, 0, 1)
+ */
+Affine3x4 toAffine(const glm::mat4 &matrix);
+
+/**
+ * @brief Expands an affine transform into a 4x4 matrix, for the GPU and for glm based code
+ */
+glm::mat4 toMat4(const Affine3x4 &matrix);
+
+/**
+ * @brief The affine equivalent of parent * child
+ */
+Affine3x4 multiply(const Affine3x4 &parent, const Affine3x4 &child);
+
+/**
+ * @brief Inverts an affine transform through its 3x3 part, cheaper than a general 4x4 inverse
+ * @return The inverse, or a degenerate transform if the matrix has a zero scale
+ */
+Affine3x4 inverse(const Affine3x4 &matrix);
+
+glm::vec3 translation(const Affine3x4 &matrix);
+glm::vec3 scale(const Affine3x4 &matrix);
+glm::vec3 forward(const Affine3x4 &matrix);
+
 } // namespace Rapture::transform
 
 #endif // RAPTURE__TRANSFORMS_H
@@ -0,0 +1,250 @@
+#include "WorldBounds.h"
+
+#include "core/utils/TracyProfiler.h"
+#include "scene/components/ChangeChannels.h"
+#include "scene/components/Components.h"
+#include "scene/systems/TransformKernels.h"
+
+#include <cfloat>
+
+namespace Rapture {
+
+static constexpr uint32_t NO_ROW = UINT32_MAX;
+
+/**
+ * @brief The mesh space box of whatever mesh an entity draws, a skeletal one's padded to hold its poses
+ * @return False while there is no mesh or it is still loading
+ */
+static bool s_localBounds(const ecs::Registry &registry, ecs::Entity entity, glm::vec3 &min, glm::vec3 &max)
+{
+    if (const StaticMeshComponent *staticMesh = registry.tryRead<StaticMeshComponent>(entity)) {
+        if (!staticMesh->mesh || staticMesh->isLoading) {
+            return false;
+        }
+        min = staticMesh->mesh->getBoundsMin();
+        max = staticMesh->mesh->getBoundsMax();
+        return true;
+    }
+    if (const SkeletalMeshComponent *skeletal = registry.tryRead<SkeletalMeshComponent>(entity)) {
+        if (!skeletal->mesh || skeletal->isLoading) {
+            return false;
+        }
+        skeletal->mesh->getPoseBounds(min, max);
+        return true;
+    }
+    return false;
+}
+
+WorldBounds::WorldBounds(ecs::Registry &registry) : m_registry(registry)
+{
+    m_connections.push_back(registry.onConstructScoped<StaticMeshComponent>([this](ecs::Entity entity) { addRow(entity); }));
+    m_connections.push_back(registry.onDestroyScoped<StaticMeshComponent>([this](ecs::Entity entity) { removeRow(entity); }));
+    m_connections.push_back(registry.onConstructScoped<SkeletalMeshComponent>([this](ecs::Entity entity) { addRow(entity); }));
+    m_connections.push_back(registry.onDestroyScoped<SkeletalMeshComponent>([this](ecs::Entity entity) { removeRow(entity); }));
+
+    // components that existed before the cache did
+    for (auto [entity, mesh] : registry.read<StaticMeshComponent>()) {
+        (void)mesh;
+        addRow(entity);
+    }
+    for (auto [entity, mesh] : registry.read<SkeletalMeshComponent>()) {
+        (void)mesh;
+        addRow(entity);
+    }
+}
+
+WorldBounds::~WorldBounds() = default;
+
+uint32_t WorldBounds::rowOf(ecs::Entity entity) const
+{
+    if (entity == ecs::ENTITY_NULL) {
+        return NO_ROW;
+    }
+
+    uint32_t index = ecs::EntityIndex(entity);
+    if (index >= m_rowOf.size()) {
+        return NO_ROW;
+    }
+
+    uint32_t row = m_rowOf[index];
+    return row != NO_ROW && m_entities[row] == entity ? row : NO_ROW;
+}
+
+BoundsView WorldBounds::view() const
+{
+    return {m_minX.data(), m_minY.data(), m_minZ.data(), m_maxX.data(), m_maxY.data(), m_maxZ.data(), getCount()};
+}
+
+void WorldBounds::resizeArrays()
+{
+    BoundsView padded{};
+    padded.count = getCount();
+    const size_t size = padded.getPaddedCount();
+
+    // the padding is made of empty boxes, rows are overwritten as soon as they are computed
+    m_minX.resize(size, FLT_MAX);
+    m_minY.resize(size, FLT_MAX);
+    m_minZ.resize(size, FLT_MAX);
+    m_maxX.resize(size, -FLT_MAX);
+    m_maxY.resize(size, -FLT_MAX);
+    m_maxZ.resize(size, -FLT_MAX);
+}
+
+void WorldBounds::setEmpty(uint32_t row)
+{
+    m_minX[row] = m_minY[row] = m_minZ[row] = FLT_MAX;
+    m_maxX[row] = m_maxY[row] = m_maxZ[row] = -FLT_MAX;
+}
+
+void WorldBounds::addRow(ecs::Entity entity)
+{
+    if (rowOf(entity) != NO_ROW) {
+        return;
+    }
+
+    uint32_t index = ecs::EntityIndex(entity);
+    if (index >= m_rowOf.size()) {
+        m_rowOf.resize(index + 1, NO_ROW);
+    }
+
+    uint32_t row = static_cast<uint32_t>(m_entities.size());
+    m_rowOf[index] = row;
+    m_entities.push_back(entity);
+    m_stale.push_back(0);
+    resizeArrays();
+    setEmpty(row);
+
+    // the creator fills in the mesh after adding the component, so it is read on the next refresh
+    markStale(row);
+}
+
+void WorldBounds::removeRow(ecs::Entity entity)
+{
+    uint32_t row = rowOf(entity);
+    if (row == NO_ROW) {
+        return;
+    }
+
+    uint32_t last = getCount() - 1;
+    if (row != last) {
+        m_entities[row] = m_entities[last];
+        m_stale[row] = m_stale[last];
+        m_minX[row] = m_minX[last];
+        m_minY[row] = m_minY[last];
+        m_minZ[row] = m_minZ[last];
+        m_maxX[row] = m_maxX[last];
+        m_maxY[row] = m_maxY[last];
+        m_maxZ[row] = m_maxZ[last];
+        m_rowOf[ecs::EntityIndex(m_entities[row])] = row;
+    }
+
+    setEmpty(last);
+    m_entities.pop_back();
+    m_stale.pop_back();
+    m_rowOf[ecs::EntityIndex(entity)] = NO_ROW;
+    m_removed.push_back(entity);
+    resizeArrays();
+}
+
+void WorldBounds::markStale(uint32_t row)
+{
+    if (m_stale[row] == 0) {
+        m_stale[row] = 1;
+        m_staleEntities.push_back(m_entities[row]);
+    }
+}
+
+void WorldBounds::refresh()
+{
+    RAPTURE_PROFILE_FUNCTION();
+
+    m_lastRemoved.swap(m_removed);
+    m_removed.clear();
+    m_lastChanged.clear();
+
+    ecs::Journal &journal = m_registry.getJournal();
+    ecs::Batch transforms = journal.readSince(CHANNEL_TRANSFORM_WORLD, m_transformBookmark);
+    ecs::Batch meshes = journal.readSince(CHANNEL_MESH_BINDING, m_meshBookmark);
+
+    if (transforms.needsRebuild() || meshes.needsRebuild()) {
+        for (uint32_t row = 0; row < getCount(); row++) {
+            markStale(row);
+        }
+    } else {
+        for (ecs::Entity entity : transforms) {
+            if (uint32_t row = rowOf(entity); row != NO_ROW) {
+                markStale(row);
+            }
+        }
+        for (ecs::Entity entity : meshes) {
+            if (uint32_t row = rowOf(entity); row != NO_ROW) {
+                markStale(row);
+            }
+        }
+    }
+
+    // an asset finishing its load is not journaled, so rows still waiting on one are asked again
+    for (ecs::Entity entity : m_unresolved) {
+        if (uint32_t row = rowOf(entity); row != NO_ROW) {
+            markStale(row);
+        }
+    }
+    m_unresolved.clear();
+
+    recomputeStale();
+}
+
+void WorldBounds::recomputeStale()
+{
+    m_rows.clear();
+    m_matrices.clear();
+    m_localMins.clear();
+    m_localMaxs.clear();
+
+    for (ecs::Entity entity : m_staleEntities) {
+        uint32_t row = rowOf(entity);
+        if (row == NO_ROW || m_stale[row] == 0) {
+            continue;
+        }
+        m_stale[row] = 0;
+        m_lastChanged.push_back(entity);
+
+        const TransformComponent *transform = m_registry.tryRead<TransformComponent>(entity);
+        glm::vec3 localMin;
+        glm::vec3 localMax;
+        if (transform == nullptr || !s_localBounds(m_registry, entity, localMin, localMax)) {
+            setEmpty(row);
+            m_unresolved.push_back(entity);
+            continue;
+        }
+
+        m_rows.push_back(row);
+        m_matrices.push_back(transform->world);
+        m_localMins.push_back(localMin);
+        m_localMaxs.push_back(localMax);
+    }
+    m_staleEntities.clear();
+
+    const size_t count = m_rows.size();
+    m_lastRefreshCount = static_cast<uint32_t>(count);
+    if (count == 0) {
+        return;
+    }
+
+    m_worldMins.resize(count);
+    m_worldMaxs.resize(count);
+    transform::transformBoundsBatch(m_matrices.data(), m_localMins.data(), m_localMaxs.data(), m_worldMins.data(),
+                                    m_worldMaxs.data(), count);
+
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t row = m_rows[i];
+        m_minX[row] = m_worldMins[i].x;
+        m_minY[row] = m_worldMins[i].y;
+        m_minZ[row] = m_worldMins[i].z;
+        m_maxX[row] = m_worldMaxs[i].x;
+        m_maxY[row] = m_worldMaxs[i].y;
+        m_maxZ[row] = m_worldMaxs[i].z;
+    }
+}
+
+} // namespace Rapture
@@ -0,0 +1,143 @@
+#ifndef RAPTURE__WORLD_BOUNDS_H
+#define RAPTURE__WORLD_BOUNDS_H
+
+#include "core/ecs/component_signal.h"
+#include "core/ecs/journal.h"
+#include "core/ecs/registry.h"
+#include "scene/systems/Transforms.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Rapture {
+
+/**
+ * @brief Read only view of boxes stored one coordinate per array
+ *
+ * The arrays hold getPaddedCount() entries, a multiple of BOUNDS_ROW_ALIGNMENT. Entries past count
+ * and rows without valid bounds are empty boxes, min at FLT_MAX and max at -FLT_MAX, which every
+ * plane test rejects, so kernels can walk whole blocks without a tail.
+ */
+struct BoundsView {
+    const float *minX = nullptr;
+    const float *minY = nullptr;
+    const float *minZ = nullptr;
+    const float *maxX = nullptr;
+    const float *maxY = nullptr;
+    const float *maxZ = nullptr;
+    uint32_t count = 0;
+
+    uint32_t getPaddedCount() const;
+};
+
+// rows are padded to whole 64 bit visibility words
+inline constexpr uint32_t BOUNDS_ROW_ALIGNMENT = 64;
+
+inline uint32_t BoundsView::getPaddedCount() const
+{
+    return (count + BOUNDS_ROW_ALIGNMENT - 1) / BOUNDS_ROW_ALIGNMENT * BOUNDS_ROW_ALIGNMENT;
+}
+
+/**
+ * @brief World space bounds of every static and skeletal mesh in a registry, cached between frames
+ *
+ * One row per entity holding a StaticMeshComponent or SkeletalMeshComponent, its world box kept as
+ * six float arrays so culling can test eight boxes per instruction. Rows are only recomputed when the
+ * journal says their world transform or mesh binding changed, a frame where nothing moved costs two
+ * empty journal reads. Rows whose mesh is still loading, or that have no transform yet, hold an empty
+ * box and are retried on every refresh until they resolve. A skeletal mesh's row holds its pose bounds,
+ * so an animated mesh is not culled while a limb it swings out of its bind pose box is still in view.
+ *
+ * Rows are unordered, removing one moves the last row into its place.
+ */
+class WorldBounds {
+  public:
+    explicit WorldBounds(ecs::Registry &registry);
+    ~WorldBounds();
+
+    WorldBounds(const WorldBounds &) = delete;
+    WorldBounds &operator=(const WorldBounds &) = delete;
+
+    /**
+     * @brief Recomputes the rows whose transform or mesh changed since the last refresh
+     *
+     * Reads the journal, so it runs on the main thread after the transform hierarchy was flushed.
+     */
+    void refresh();
+
+    BoundsView view() const;
+
+    uint32_t getCount() const { return static_cast<uint32_t>(m_entities.size()); }
+
+    ecs::Entity getEntity(uint32_t row) const { return m_entities[row]; }
+
+    /**
+     * @brief The row an entity's bounds live in
+     * @return The row, or UINT32_MAX if the entity has no mesh
+     */
+    uint32_t rowOf(ecs::Entity entity) const;
+
+    /**
+     * @brief Rows recomputed by the last refresh, for the profiler and benchmarks
+     */
+    uint32_t getLastRefreshCount() const { return m_lastRefreshCount; }
+
+    /**
+     * @brief Entities whose box the last refresh wrote, including boxes it left empty
+     *
+     * Valid until the next refresh, for structures that follow these bounds such as SceneBVH.
+     */
+    const std::vector<ecs::Entity> &getLastChanged() const { return m_lastChanged; }
+
+    /**
+     * @brief Entities whose row was removed between the last two refreshes
+     */
+    const std::vector<ecs::Entity> &getLastRemoved() const { return m_lastRemoved; }
+
+  private:
+    void addRow(ecs::Entity entity);
+    void removeRow(ecs::Entity entity);
+    void markStale(uint32_t row);
+    void setEmpty(uint32_t row);
+
+    /**
+     * @brief Keeps the coordinate arrays padded with empty boxes to the next multiple of BOUNDS_ROW_ALIGNMENT
+     */
+    void resizeArrays();
+
+    /**
+     * @brief Transforms the local bounds of every stale row into world space
+     */
+    void recomputeStale();
+
+  private:
+    ecs::Registry &m_registry;
+    std::vector<ecs::SignalConnection> m_connections;
+
+    ecs::Bookmark m_transformBookmark;
+    ecs::Bookmark m_meshBookmark;
+
+    std::vector<ecs::Entity> m_entities;
+    std::vector<float> m_minX, m_minY, m_minZ;
+    std::vector<float> m_maxX, m_maxY, m_maxZ;
+    std::vector<uint8_t> m_stale;
+
+    std::vector<uint32_t> m_rowOf; // entity index -> row
+    std::vector<ecs::Entity> m_staleEntities;
+    std::vector<ecs::Entity> m_unresolved; // rows left empty because their mesh or transform was missing
+    std::vector<ecs::Entity> m_removed;
+    std::vector<ecs::Entity> m_lastRemoved;
+    std::vector<ecs::Entity> m_lastChanged;
+
+    // recompute scratch, kept to avoid reallocating every frame
+    std::vector<uint32_t> m_rows;
+    std::vector<Affine3x4> m_matrices;
+    std::vector<glm::vec3> m_localMins, m_localMaxs;
+    std::vector<glm::vec3> m_worldMins, m_worldMaxs;
+
+    uint32_t m_lastRefreshCount = 0;
+};
+
+} // namespace Rapture
+
+#endif // RAPTURE__WORLD_BOUNDS_H